@@ -0,0 +1,13 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Entry point of the rgpot benchmark suite.
+ *
+ * Pass @c --benchmark_format=json or @c --benchmark_out=FILE to record
+ * results for comparison between builds.
+ */
+
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
@@ -0,0 +1,112 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Reproducible input configurations shared by the benchmarks.
+ *
+ * Every benchmark draws its systems from here so that numbers from
+ * different runs and binaries are comparable.
+ */
+
+// clang-format off
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+// clang-format on
+
+#include "rgpot/ForceStructs.hpp"
+
+namespace rgpot {
+namespace bench {
+
+/**
+ * @brief One configuration with its output buffers.
+ */
+struct System {
+  size_t nAtoms = 0;          //!< Number of atoms.
+  std::vector<double> pos;    //!< Coordinates [nAtoms * 3].
+  std::vector<int> atmnrs;    //!< Atomic numbers [nAtoms].
+  std::vector<double> box;    //!< Row-major cell [9].
+  std::vector<double> forces; //!< Force output [nAtoms * 3].
+
+  /**
+   * @brief Fetches the input view of the configuration.
+   * @return A @c ForceInput pointing into the members.
+   */
+  ForceInput input() const {
+    return {.nAtoms = nAtoms,
+            .pos = pos.data(),
+            .atmnrs = atmnrs.data(),
+            .box = box.data()};
+  }
+};
+
+/**
+ * @brief Builds a jittered simple cubic lattice of Lennard-Jones atoms.
+ *
+ * The spacing sits near the minimum of the default LJ parameters, so the
+ * neighbor counts per atom stay constant as the system grows.
+ *
+ * @param n_atoms Number of atoms.
+ * @param seed Seed of the jitter.
+ * @return The configuration in a cubic, periodic cell.
+ */
+inline System lj_lattice(size_t n_atoms, unsigned seed = 42) {
+  const double spacing = 1.12;
+  const auto side = static_cast<size_t>(
+      std::ceil(std::cbrt(static_cast<double>(n_atoms))));
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> jitter(-0.05, 0.05);
+
+  System sys;
+  sys.nAtoms = n_atoms;
+  sys.pos.reserve(n_atoms * 3);
+  for (size_t i = 0; i < n_atoms; ++i) {
+    const size_t cell[3] = {i % side, (i / side) % side, i / (side * side)};
+    for (size_t d = 0; d < 3; ++d) {
+      sys.pos.push_back(spacing * static_cast<double>(cell[d]) + jitter(gen));
+    }
+  }
+  sys.atmnrs.assign(n_atoms, 0);
+  const double len = spacing * static_cast<double>(side);
+  sys.box = {len, 0.0, 0.0, 0.0, len, 0.0, 0.0, 0.0, len};
+  sys.forces.assign(n_atoms * 3, 0.0);
+  return sys;
+}
+
+/**
+ * @brief Tiles the CuH2 reference configuration over a supercell.
+ * @param reps Repetitions along x and y, giving 4 * @a reps^2 atoms.
+ * @return The configuration of two Cu and two H atoms per cell.
+ */
+inline System cuh2_supercell(size_t reps) {
+  const double cell[3] = {15.345599999999999, 21.702000000000002, 100.0};
+  const double unit[4][3] = {
+      {0.63940268750835, 0.90484742551374, 6.97516498544584},
+      {3.19652040936288, 0.90417430354811, 6.97547796369474},
+      {8.98363230369760, 9.94703496017833, 7.83556854923689},
+      {7.64080177576300, 9.94703114803832, 7.83556986121272}};
+  const int types[4] = {29, 29, 1, 1};
+
+  System sys;
+  sys.nAtoms = 4 * reps * reps;
+  for (size_t a = 0; a < reps; ++a) {
+    for (size_t b = 0; b < reps; ++b) {
+      for (size_t k = 0; k < 4; ++k) {
+        sys.pos.push_back(unit[k][0] + cell[0] * static_cast<double>(a));
+        sys.pos.push_back(unit[k][1] + cell[1] * static_cast<double>(b));
+        sys.pos.push_back(unit[k][2]);
+        sys.atmnrs.push_back(types[k]);
+      }
+    }
+  }
+  const auto r = static_cast<double>(reps);
+  sys.box = {cell[0] * r, 0.0, 0.0, 0.0, cell[1] * r, 0.0, 0.0, 0.0, cell[2]};
+  sys.forces.assign(sys.nAtoms * 3, 0.0);
+  return sys;
+}
+
+} // namespace bench
+} // namespace rgpot
@@ -0,0 +1,135 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Benchmarks of the result cache hit and miss paths.
+ *
+ * Databases are created under the system temporary directory and removed
+ * when each benchmark finishes.
+ */
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "BenchUtils.hpp"
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/PotentialCache.hpp"
+
+#include <rocksdb/db.h>
+#include <rocksdb/options.h>
+
+namespace {
+
+namespace fs = std::filesystem;
+using rgpot::cache::PotentialCache;
+using rgpot::cache::TierMode;
+using rgpot::cache::TierOptions;
+
+// Potential type mixed into the keys of the benchmarks
+constexpr int lj_type = static_cast<int>(rgpot::PotType::LJ);
+
+/**
+ * @class ScratchCache
+ * @brief Cache in a fresh database directory, destroyed with the object.
+ */
+class ScratchCache {
+public:
+  /**
+   * @brief Constructor for ScratchCache.
+   * @param name Distinguishes the databases of different benchmarks.
+   * @param mode Memory tier mode of the cache.
+   */
+  ScratchCache(const std::string &name, TierMode mode)
+      : m_path((fs::temp_directory_path() /
+                ("rgpot_bench_" + name + "_" +
+                 std::to_string(std::chrono::steady_clock::now()
+                                    .time_since_epoch()
+                                    .count())))
+                   .string()) {
+    rocksdb::DestroyDB(m_path, rocksdb::Options());
+    m_cache = std::make_unique<PotentialCache>(
+        m_path, TierOptions{.mode = mode});
+  }
+
+  /**
+   * @brief Destructor, closes and removes the database.
+   */
+  ~ScratchCache() {
+    m_cache.reset();
+    rocksdb::DestroyDB(m_path, rocksdb::Options());
+  }
+
+  /**
+   * @brief Fetches the cache.
+   * @return The open cache.
+   */
+  PotentialCache &get() { return *m_cache; }
+
+private:
+  std::string m_path;                      //!< Database directory.
+  std::unique_ptr<PotentialCache> m_cache; //!< The cache.
+};
+
+/**
+ * @brief Reads the tier mode a benchmark runs with.
+ * @param state The benchmark state, mode in @c range(1).
+ * @return The mode.
+ */
+TierMode mode_of(const benchmark::State &state) {
+  return state.range(1) ? TierMode::WriteThrough : TierMode::Disabled;
+}
+
+void BM_CacheKey(benchmark::State &state) {
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  const rgpot::ForceInput fi = sys.input();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(rgpot::cache::make_key(fi, lj_type));
+  }
+  state.SetBytesProcessed(
+      state.iterations() *
+      static_cast<int64_t>(sys.nAtoms * 3 * sizeof(double)));
+}
+BENCHMARK(BM_CacheKey)->RangeMultiplier(4)->Range(16, 16384);
+
+void BM_CacheHit(benchmark::State &state) {
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  ScratchCache scratch("hit", mode_of(state));
+  rgpot::LJPot pot;
+  pot.set_cache(&scratch.get());
+  const rgpot::ForceInput fi = sys.input();
+  rgpot::ForceOut fo{.F = sys.forces.data(), .energy = 0.0, .variance = 0.0};
+  pot.compute_into(fi, fo);
+
+  for (auto _ : state) {
+    pot.compute_into(fi, fo);
+    benchmark::DoNotOptimize(fo.energy);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheHit)
+    ->ArgsProduct({{16, 256, 4096}, {0, 1}})
+    ->ArgNames({"atoms", "memory_tier"});
+
+void BM_CacheMissStore(benchmark::State &state) {
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  ScratchCache scratch("miss", mode_of(state));
+  PotentialCache &cache = scratch.get();
+  const size_t n = sys.nAtoms * 3;
+  double energy = 0.0;
+  for (auto _ : state) {
+    // A fresh configuration every iteration, as a trajectory produces
+    sys.pos[0] += 1e-9;
+    const auto key = rgpot::cache::make_key(sys.input(), lj_type);
+    benchmark::DoNotOptimize(cache.lookup(key, energy, sys.forces.data(), n));
+    cache.store(key, energy, sys.forces.data(), n);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheMissStore)
+    ->ArgsProduct({{16, 256, 4096}, {0, 1}})
+    ->ArgNames({"atoms", "memory_tier"});
+
+} // namespace
@@ -0,0 +1,136 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Benchmarks of the potentials across system sizes.
+ *
+ * @c compute_into isolates the force routine, the call operator adds the
+ * matrix allocation and copies a typical C++ caller pays. @c compute_moved
+ * times the incremental update of a single displaced atom.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "BenchUtils.hpp"
+#include "rgpot/LennardJones/LJPot.hpp"
+#ifdef RGPOT_HAS_FORTRAN
+#include "rgpot/CuH2/CuH2Pot.hpp"
+#endif // RGPOT_HAS_FORTRAN
+
+namespace {
+
+/**
+ * @brief Times @c compute_into of a potential on one configuration.
+ * @param state The benchmark state.
+ * @param pot The potential.
+ * @param sys The configuration.
+ * @return Void.
+ */
+void run_compute_into(benchmark::State &state, rgpot::PotentialBase &pot,
+                      rgpot::bench::System &sys) {
+  const rgpot::ForceInput fi = sys.input();
+  rgpot::ForceOut fo{.F = sys.forces.data(), .energy = 0.0, .variance = 0.0};
+  for (auto _ : state) {
+    pot.compute_into(fi, fo);
+    benchmark::DoNotOptimize(fo.energy);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(sys.nAtoms));
+  state.counters["atoms"] = static_cast<double>(sys.nAtoms);
+}
+
+void BM_LJPot_ComputeInto(benchmark::State &state) {
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  rgpot::LJPot pot;
+  run_compute_into(state, pot, sys);
+}
+BENCHMARK(BM_LJPot_ComputeInto)
+    ->RangeMultiplier(4)
+    ->Range(16, 4096)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_LJPot_Call(benchmark::State &state) {
+  const auto n = static_cast<size_t>(state.range(0));
+  auto sys = rgpot::bench::lj_lattice(n);
+  rgpot::types::AtomMatrix pos(n, 3);
+  std::copy(sys.pos.begin(), sys.pos.end(), pos.data());
+  std::array<std::array<double, 3>, 3> box{};
+  for (size_t d = 0; d < 3; ++d) {
+    box[d][d] = sys.box[4 * d];
+  }
+  rgpot::LJPot pot;
+  for (auto _ : state) {
+    auto result = pot(pos, sys.atmnrs, box);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(n));
+}
+BENCHMARK(BM_LJPot_Call)
+    ->RangeMultiplier(4)
+    ->Range(16, 4096)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_LJPot_Batch(benchmark::State &state) {
+  const size_t nconf = 8;
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  const size_t stride = sys.nAtoms * 3;
+  std::vector<double> pos(nconf * stride), boxes(nconf * 9);
+  for (size_t c = 0; c < nconf; ++c) {
+    std::copy(sys.pos.begin(), sys.pos.end(), pos.begin() + c * stride);
+    std::copy(sys.box.begin(), sys.box.end(), boxes.begin() + c * 9);
+  }
+  std::vector<double> energies(nconf), forces(nconf * stride);
+  rgpot::LJPot pot;
+  for (auto _ : state) {
+    pot.calculate_batch(nconf, sys.nAtoms, pos.data(), sys.atmnrs.data(),
+                        boxes.data(), energies.data(), forces.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(nconf * sys.nAtoms));
+}
+BENCHMARK(BM_LJPot_Batch)
+    ->RangeMultiplier(4)
+    ->Range(16, 1024)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_LJPot_MoveOne(benchmark::State &state) {
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  rgpot::LJPot pot;
+  rgpot::ForceOut fo{.F = sys.forces.data(), .energy = 0.0, .variance = 0.0};
+  pot.compute_into(sys.input(), fo);
+  // Moves one atom back and forth within the neighbor list skin
+  auto moved_sys = sys;
+  moved_sys.pos[0] += 0.05;
+  const rgpot::ForceInput a = sys.input();
+  const rgpot::ForceInput b = moved_sys.input();
+  const size_t moved = 0;
+  bool forth = true;
+  for (auto _ : state) {
+    pot.compute_moved(forth ? a : b, forth ? b : a, &moved, 1, fo);
+    forth = !forth;
+    benchmark::DoNotOptimize(fo.energy);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["atoms"] = static_cast<double>(sys.nAtoms);
+}
+BENCHMARK(BM_LJPot_MoveOne)
+    ->RangeMultiplier(4)
+    ->Range(16, 4096)
+    ->Unit(benchmark::kMicrosecond);
+
+#ifdef RGPOT_HAS_FORTRAN
+void BM_CuH2Pot_ComputeInto(benchmark::State &state) {
+  auto sys = rgpot::bench::cuh2_supercell(static_cast<size_t>(state.range(0)));
+  rgpot::CuH2Pot pot;
+  run_compute_into(state, pot, sys);
+}
+BENCHMARK(BM_CuH2Pot_ComputeInto)
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->Unit(benchmark::kMicrosecond);
+#endif // RGPOT_HAS_FORTRAN
+
+} // namespace
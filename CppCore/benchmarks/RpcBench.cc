@@ -0,0 +1,241 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Benchmarks of the Cap'n Proto adapters and the client bridge.
+ *
+ * The bridge benchmarks talk to an in-process Lennard-Jones server on the
+ * loopback interface, so they measure serialization and round-trip
+ * overhead rather than network latency.
+ */
+
+#include <benchmark/benchmark.h>
+#include <capnp/ez-rpc.h>
+#include <capnp/message.h>
+#include <future>
+#include <kj/async.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "BenchUtils.hpp"
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/rpc/Potentials.capnp.h"
+#include "rgpot/rpc/pot_bridge.h"
+#include "rgpot/types/adapters/capnp/capnp_adapter.hpp"
+#include "rgpot/types/adapters/capnp/capnp_view.hpp"
+
+namespace {
+
+namespace adapt = rgpot::types::adapt::capnp;
+
+/**
+ * @class LJServer
+ * @brief Minimal single-threaded @c Potential server used by the benchmarks.
+ */
+class LJServer final : public Potential::Server {
+public:
+  /**
+   * @details
+   * Views the request in place and writes the forces straight into the
+   * response, like @c potserv does.
+   */
+  kj::Promise<void> calculate(CalculateContext context) override {
+    auto fip = context.getParams().getFip();
+    auto pres = context.getResults().initResult();
+    const size_t n = fip.getAtmnrs().size();
+    const double *pos = adapt::viewFromCapnp(fip.getPos(), m_pos);
+    const int *atmnrs = adapt::viewFromCapnp(fip.getAtmnrs(), m_atm);
+    const double *box = adapt::viewFromCapnp(fip.getBox(), m_box);
+    auto forces = pres.initForces(n * 3);
+    m_forces.resize(n * 3);
+    double energy = 0.0;
+    m_pot.calculate_batch(1, n, pos, atmnrs, box, &energy, m_forces.data());
+    adapt::copyToCapnp(forces, m_forces.data());
+    pres.setEnergy(energy);
+    return kj::READY_NOW;
+  }
+
+private:
+  rgpot::LJPot m_pot;           //!< The potential.
+  std::vector<double> m_pos;    //!< Fallback copy of the positions.
+  std::vector<int> m_atm;       //!< Fallback copy of the atomic numbers.
+  std::vector<double> m_box;    //!< Fallback copy of the box.
+  std::vector<double> m_forces; //!< Force buffer.
+};
+
+/**
+ * @class InProcessServer
+ * @brief Runs an @c LJServer on its own thread and event loop.
+ */
+class InProcessServer {
+public:
+  /**
+   * @brief Constructor, returns once the server listens.
+   */
+  InProcessServer() {
+    using Ready =
+        std::pair<unsigned, kj::Own<kj::CrossThreadPromiseFulfiller<void>>>;
+    std::promise<Ready> ready;
+    m_thread = std::thread([&ready] {
+      capnp::EzRpcServer server(kj::heap<LJServer>(), "127.0.0.1", 0);
+      auto &waitScope = server.getWaitScope();
+      auto stop = kj::newPromiseAndCrossThreadFulfiller<void>();
+      const unsigned port = server.getPort().wait(waitScope);
+      ready.set_value({port, kj::mv(stop.fulfiller)});
+      stop.promise.wait(waitScope);
+    });
+    auto started = ready.get_future().get();
+    m_port = started.first;
+    m_stop = kj::mv(started.second);
+  }
+
+  /**
+   * @brief Destructor, stops the event loop and joins the thread.
+   */
+  ~InProcessServer() {
+    m_stop->fulfill();
+    m_thread.join();
+  }
+
+  /**
+   * @brief Fetches the port the server listens on.
+   * @return The loopback port.
+   */
+  unsigned port() const { return m_port; }
+
+private:
+  std::thread m_thread;  //!< Thread running the event loop.
+  unsigned m_port = 0;   //!< Listening port.
+  kj::Own<kj::CrossThreadPromiseFulfiller<void>> m_stop; //!< Stop signal.
+};
+
+/**
+ * @brief Fills a @c ForceInput builder with a configuration.
+ * @param fip The builder.
+ * @param sys The configuration.
+ * @return Void.
+ */
+void fill_input(ForceInput::Builder fip, const rgpot::bench::System &sys) {
+  auto pos = fip.initPos(sys.nAtoms * 3);
+  adapt::copyToCapnp(pos, sys.pos.data());
+  auto atm = fip.initAtmnrs(sys.nAtoms);
+  for (size_t i = 0; i < sys.nAtoms; ++i) {
+    atm.set(i, sys.atmnrs[i]);
+  }
+  auto box = fip.initBox(9);
+  adapt::copyToCapnp(box, sys.box.data());
+}
+
+void BM_CapnpView(benchmark::State &state) {
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  capnp::MallocMessageBuilder message;
+  auto fip = message.initRoot<ForceInput>();
+  fill_input(fip, sys);
+  auto reader = fip.asReader();
+  std::vector<double> storage;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(adapt::viewFromCapnp(reader.getPos(), storage));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CapnpView)->RangeMultiplier(8)->Range(16, 16384);
+
+void BM_CapnpCopyPositions(benchmark::State &state) {
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  capnp::MallocMessageBuilder message;
+  auto fip = message.initRoot<ForceInput>();
+  fill_input(fip, sys);
+  auto reader = fip.asReader();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        adapt::convertPositionsFromCapnp(reader.getPos(), sys.nAtoms));
+  }
+  state.SetBytesProcessed(
+      state.iterations() *
+      static_cast<int64_t>(sys.pos.size() * sizeof(double)));
+}
+BENCHMARK(BM_CapnpCopyPositions)->RangeMultiplier(8)->Range(16, 16384);
+
+void BM_CapnpWriteForces(benchmark::State &state) {
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    capnp::MallocMessageBuilder message;
+    auto pres = message.initRoot<PotentialResult>();
+    auto forces = pres.initForces(sys.nAtoms * 3);
+    adapt::copyToCapnp(forces, sys.pos.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetBytesProcessed(
+      state.iterations() *
+      static_cast<int64_t>(sys.pos.size() * sizeof(double)));
+}
+BENCHMARK(BM_CapnpWriteForces)->RangeMultiplier(8)->Range(16, 16384);
+
+/**
+ * @brief Fetches the shared in-process server, started on first use.
+ * @return The server, alive until the process exits.
+ */
+InProcessServer &shared_server() {
+  static auto *server = new InProcessServer();
+  return *server;
+}
+
+void BM_BridgeRoundTrip(benchmark::State &state) {
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  PotClient *client = pot_client_init(
+      "127.0.0.1", static_cast<int32_t>(shared_server().port()));
+  if (!client) {
+    state.SkipWithError("Unable to connect to the in-process server");
+    return;
+  }
+  const auto natoms = static_cast<int32_t>(sys.nAtoms);
+  double energy = 0.0;
+  for (auto _ : state) {
+    if (pot_calculate(client, natoms, sys.pos.data(), sys.atmnrs.data(),
+                      sys.box.data(), &energy, sys.forces.data()) != 0) {
+      state.SkipWithError(pot_get_last_error(client));
+      break;
+    }
+  }
+  pot_client_free(client);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BridgeRoundTrip)
+    ->RangeMultiplier(8)
+    ->Range(16, 4096)
+    ->Unit(benchmark::kMicrosecond);
+
+void BM_BridgePipelined(benchmark::State &state) {
+  const auto inflight = static_cast<size_t>(state.range(0));
+  auto sys = rgpot::bench::lj_lattice(64);
+  PotClient *client = pot_client_init(
+      "127.0.0.1", static_cast<int32_t>(shared_server().port()));
+  if (!client) {
+    state.SkipWithError("Unable to connect to the in-process server");
+    return;
+  }
+  const auto natoms = static_cast<int32_t>(sys.nAtoms);
+  std::vector<double> energies(inflight);
+  std::vector<double> forces(inflight * sys.nAtoms * 3);
+  std::vector<int64_t> tickets(inflight);
+  for (auto _ : state) {
+    for (size_t k = 0; k < inflight; ++k) {
+      tickets[k] = pot_calculate_submit(
+          client, natoms, sys.pos.data(), sys.atmnrs.data(), sys.box.data(),
+          &energies[k], forces.data() + k * sys.nAtoms * 3);
+    }
+    for (int64_t ticket : tickets) {
+      pot_calculate_wait(client, ticket);
+    }
+  }
+  pot_client_free(client);
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(inflight));
+}
+BENCHMARK(BM_BridgePipelined)
+    ->RangeMultiplier(4)
+    ->Range(1, 64)
+    ->Unit(benchmark::kMicrosecond);
+
+} // namespace
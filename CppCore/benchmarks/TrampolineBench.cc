@@ -0,0 +1,62 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Benchmarks of the Rust core dispatch overhead.
+ *
+ * Compares @c PotentialHandle::from_impl, which crosses the C ABI and the
+ * DLPack tensors on every call, with a direct @c compute_into on the same
+ * Lennard-Jones potential; the difference is the trampoline cost.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include "BenchUtils.hpp"
+// clang-format off
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/potential.hpp"
+// clang-format on
+
+namespace {
+
+void BM_Trampoline_Direct(benchmark::State &state) {
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  rgpot::LJPot lj;
+  const rgpot::ForceInput fi = sys.input();
+  rgpot::ForceOut fo{.F = sys.forces.data(), .energy = 0.0, .variance = 0.0};
+  for (auto _ : state) {
+    lj.compute_into(fi, fo);
+    benchmark::DoNotOptimize(fo.energy);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Trampoline_Direct)->RangeMultiplier(8)->Range(2, 1024);
+
+void BM_Trampoline_CalculateInto(benchmark::State &state) {
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  rgpot::LJPot lj;
+  auto pot = rgpot::PotentialHandle::from_impl(lj);
+  rgpot::InputSpec input(sys.pos, sys.atmnrs, sys.box.data());
+  rgpot::CalcResult result(sys.forces.data(), sys.nAtoms);
+  for (auto _ : state) {
+    pot.calculate_into(input, result);
+    benchmark::DoNotOptimize(result.energy());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Trampoline_CalculateInto)->RangeMultiplier(8)->Range(2, 1024);
+
+void BM_Trampoline_Calculate(benchmark::State &state) {
+  auto sys = rgpot::bench::lj_lattice(static_cast<size_t>(state.range(0)));
+  rgpot::LJPot lj;
+  auto pot = rgpot::PotentialHandle::from_impl(lj);
+  rgpot::InputSpec input(sys.pos, sys.atmnrs, sys.box.data());
+  for (auto _ : state) {
+    auto result = pot.calculate(input);
+    benchmark::DoNotOptimize(result.energy());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Trampoline_Calculate)->RangeMultiplier(8)->Range(2, 1024);
+
+} // namespace
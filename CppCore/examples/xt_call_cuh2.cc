@@ -8,8 +8,8 @@
 #include "rgpot/types/adapters/xtensor.hpp"
 using rgpot::types::AtomMatrix;
 using rgpot::types::adapt::xtensor::convertToArray3x3;
-using rgpot::types::adapt::xtensor::convertToAtomMatrix;
 using rgpot::types::adapt::xtensor::convertToVector;
+using rgpot::types::adapt::xtensor::viewAsAtomMatrix;
 
 int main(void) {
   auto cuh2pot = rgpot::CuH2Pot();
@@ -30,7 +30,7 @@ int main(void) {
   };
 
   auto [energy, forces] =
-      cuh2pot(convertToAtomMatrix(positions), convertToVector(atomTypes),
+      cuh2pot(viewAsAtomMatrix(positions), convertToVector(atomTypes),
               convertToArray3x3(boxMatrix));
 
   fmt::print("Got energy {}\n Forces:\n{}", energy, fmt::streamed(forces));
@@ -0,0 +1,167 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Implementation of the sharded in-memory cache tier.
+ */
+
+#include "rgpot/CacheTier.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace rgpot::cache {
+
+namespace {
+
+/**
+ * @brief Views a serialized value as raw bytes.
+ * @param value Energy followed by the forces.
+ * @return The byte view.
+ */
+std::string_view as_bytes(const std::vector<double> &value) {
+  return {reinterpret_cast<const char *>(value.data()),
+          value.size() * sizeof(double)};
+}
+
+} // namespace
+
+/**
+ * @details
+ * Counts the key and value payloads plus a fixed allowance for the list
+ * node, the index slot and the container headers, so that a budget full of
+ * small entries is not badly underestimated.
+ */
+size_t ShardedLRU::Entry::bytes() const {
+  constexpr size_t overhead = 128;
+  return key.size() + value.size() * sizeof(double) + overhead;
+}
+
+/**
+ * @details
+ * The budget is divided evenly, so a shard evicts on its own once its share
+ * is used even if other shards still have room.
+ */
+ShardedLRU::ShardedLRU(size_t capacity_bytes, size_t num_shards)
+    : m_shards(std::max<size_t>(1, num_shards)),
+      m_shard_capacity(capacity_bytes / std::max<size_t>(1, num_shards)) {}
+
+bool ShardedLRU::get(size_t hash, std::string_view key, double &energy,
+                     double *forces, size_t n) {
+  Shard &shard = shard_for(hash);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it == shard.index.end() || it->second->value.size() != n + 1) {
+    return false;
+  }
+  shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+  const double *value = it->second->value.data();
+  energy = value[0];
+  std::memcpy(forces, value + 1, n * sizeof(double));
+  return true;
+}
+
+/**
+ * @details
+ * An existing entry is replaced, and the replacement stays dirty if the old
+ * entry was. Evicted dirty entries are moved out of the shard and only
+ * spilled once the lock is released, so a slow persistent store does not
+ * block concurrent lookups on the same shard.
+ */
+void ShardedLRU::put(size_t hash, std::string_view key, double energy,
+                     const double *forces, size_t n, bool dirty,
+                     const SpillFn &spill) {
+  Entry fresh{.key = std::string(key),
+              .value = std::vector<double>(n + 1),
+              .dirty = dirty};
+  fresh.value[0] = energy;
+  std::memcpy(fresh.value.data() + 1, forces, n * sizeof(double));
+
+  if (fresh.bytes() > m_shard_capacity) {
+    if (dirty && spill) {
+      spill(fresh.key, as_bytes(fresh.value));
+    }
+    return;
+  }
+
+  std::list<Entry> evicted;
+  {
+    Shard &shard = shard_for(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+      auto node = it->second;
+      shard.index.erase(it);
+      fresh.dirty = fresh.dirty || node->dirty;
+      shard.bytes -= node->bytes();
+      // Moved to the evicted list without the dirty flag so it is dropped
+      node->dirty = false;
+      evicted.splice(evicted.end(), shard.lru, node);
+    }
+
+    shard.bytes += fresh.bytes();
+    shard.lru.push_front(std::move(fresh));
+    shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+
+    while (shard.bytes > m_shard_capacity && shard.lru.size() > 1) {
+      auto victim = std::prev(shard.lru.end());
+      shard.bytes -= victim->bytes();
+      shard.index.erase(victim->key);
+      evicted.splice(evicted.end(), shard.lru, victim);
+    }
+  }
+
+  if (spill) {
+    for (const auto &entry : evicted) {
+      if (entry.dirty) {
+        spill(entry.key, as_bytes(entry.value));
+      }
+    }
+  }
+}
+
+/**
+ * @details
+ * Each shard is locked in turn while its dirty entries are spilled, so the
+ * callback must not call back into the cache.
+ */
+void ShardedLRU::drain_dirty(const SpillFn &spill) {
+  for (auto &shard : m_shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto &entry : shard.lru) {
+      if (entry.dirty) {
+        spill(entry.key, as_bytes(entry.value));
+        entry.dirty = false;
+      }
+    }
+  }
+}
+
+void ShardedLRU::clear() {
+  for (auto &shard : m_shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.index.clear();
+    shard.lru.clear();
+    shard.bytes = 0;
+  }
+}
+
+size_t ShardedLRU::size() const {
+  size_t total = 0;
+  for (const auto &shard : m_shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    total += shard.lru.size();
+  }
+  return total;
+}
+
+size_t ShardedLRU::size_bytes() const {
+  size_t total = 0;
+  for (const auto &shard : m_shards) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    total += shard.bytes;
+  }
+  return total;
+}
+
+} // namespace rgpot::cache
@@ -0,0 +1,170 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Sharded, byte-budgeted LRU used as the in-memory cache tier.
+ *
+ * Defines @c ShardedLRU, which keeps recently used results in process
+ * memory in front of the RocksDB backed @c PotentialCache, and the options
+ * selecting how the two tiers interact.
+ */
+
+// clang-format off
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+// clang-format on
+
+namespace rgpot::cache {
+
+/**
+ * @brief How the in-memory tier relates to the persistent store.
+ * @ingroup rgpot_cache
+ */
+enum class TierMode {
+  Disabled,     //!< Only RocksDB is used.
+  MemoryOnly,   //!< Only the in-memory tier is used.
+  WriteThrough, //!< Writes go to both tiers immediately.
+  WriteBack     //!< Writes go to memory, RocksDB on eviction or flush.
+};
+
+/**
+ * @brief Configuration of the in-memory tier.
+ * @ingroup rgpot_cache
+ */
+struct TierOptions {
+  TierMode mode = TierMode::Disabled;   //!< Tier interaction mode.
+  size_t capacity_bytes = size_t{64} << 20; //!< Total memory budget.
+  size_t num_shards = 16;               //!< Independently locked shards.
+};
+
+/**
+ * @class ShardedLRU
+ * @brief Thread-safe LRU map from cache keys to energy and forces.
+ * @ingroup rgpot_cache
+ *
+ * Entries are spread over shards by their numeric hash, each shard with its
+ * own lock and an equal share of the byte budget. Values are stored in the
+ * serialized layout of @c PotentialCache, @c [energy, F_0, ..., F_n-1].
+ */
+class ShardedLRU {
+public:
+  /**
+   * @brief Callback receiving an entry that must be persisted.
+   *
+   * Called with the key and the serialized value as raw bytes.
+   */
+  using SpillFn = std::function<void(std::string_view key,
+                                     std::string_view value)>;
+
+  /**
+   * @brief Constructor for ShardedLRU.
+   * @param capacity_bytes Total memory budget, split evenly over shards.
+   * @param num_shards Number of shards, at least one.
+   */
+  ShardedLRU(size_t capacity_bytes, size_t num_shards);
+
+  /**
+   * @brief Looks up an entry and marks it most recently used.
+   * @param hash Numeric hash of the key, selects the shard.
+   * @param key The cache key.
+   * @param energy Receives the energy on a hit.
+   * @param forces Receives @a n force components on a hit.
+   * @param n Number of force components expected.
+   * @return Whether the entry was present with @a n components.
+   */
+  bool get(size_t hash, std::string_view key, double &energy, double *forces,
+           size_t n);
+
+  /**
+   * @brief Inserts or replaces an entry.
+   *
+   * Least recently used entries are evicted until the shard fits its
+   * budget; dirty ones are passed to @a spill after the shard lock has been
+   * released. Entries larger than a shard's budget are not stored, and are
+   * spilled right away when @a dirty is set.
+   *
+   * @param hash Numeric hash of the key, selects the shard.
+   * @param key The cache key.
+   * @param energy The energy.
+   * @param forces Pointer to @a n force components.
+   * @param n Number of force components.
+   * @param dirty Whether the entry still has to reach the persistent store.
+   * @param spill Receives evicted dirty entries, may be empty if @a dirty
+   * is never set.
+   * @return Void.
+   */
+  void put(size_t hash, std::string_view key, double energy,
+           const double *forces, size_t n, bool dirty, const SpillFn &spill);
+
+  /**
+   * @brief Passes every dirty entry to @a spill and marks it clean.
+   * @param spill Receives the dirty entries.
+   * @return Void.
+   */
+  void drain_dirty(const SpillFn &spill);
+
+  /**
+   * @brief Drops every entry without spilling.
+   * @return Void.
+   */
+  void clear();
+
+  /**
+   * @brief Fetches the number of stored entries.
+   * @return The entry count.
+   */
+  [[nodiscard]] size_t size() const;
+
+  /**
+   * @brief Fetches the accounted memory of all entries.
+   * @return Bytes in use.
+   */
+  [[nodiscard]] size_t size_bytes() const;
+
+private:
+  /**
+   * @brief One cached result.
+   */
+  struct Entry {
+    std::string key;            //!< The cache key.
+    std::vector<double> value;  //!< Energy followed by the forces.
+    bool dirty = false;         //!< Not yet persisted.
+
+    /**
+     * @brief Approximate memory held by the entry.
+     * @return Bytes including container overhead.
+     */
+    [[nodiscard]] size_t bytes() const;
+  };
+
+  /**
+   * @brief Independently locked part of the cache.
+   */
+  struct Shard {
+    mutable std::mutex mutex; //!< Guards the members below.
+    std::list<Entry> lru;     //!< Entries, most recently used first.
+    std::unordered_map<std::string_view, std::list<Entry>::iterator>
+        index;                //!< Lookup by key, viewing @c Entry::key.
+    size_t bytes = 0;         //!< Accounted memory of @c lru.
+  };
+
+  /**
+   * @brief Selects the shard for a hash.
+   * @param hash Numeric hash of the key.
+   * @return The shard.
+   */
+  Shard &shard_for(size_t hash) { return m_shards[hash % m_shards.size()]; }
+
+  std::vector<Shard> m_shards; //!< The shards.
+  size_t m_shard_capacity;     //!< Byte budget of each shard.
+};
+
+} // namespace rgpot::cache
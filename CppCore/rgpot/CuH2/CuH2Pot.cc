@@ -10,52 +10,100 @@
 
 // clang-format off
 #include <limits>
-#include <set>
+#include <mutex>
+#include <stdexcept>
 // clang-format on
 #include "rgpot/CuH2/CuH2Pot.hpp"
+#include "rgpot/PeriodicCell.hpp"
 #include "rgpot/types/AtomMatrix.hpp"
 using rgpot::types::AtomMatrix;
 
 namespace rgpot {
 
+namespace {
+
+/**
+ * @brief Serializes calls into the Fortran EAM code.
+ *
+ * The Fortran code behind @c c_force_eam is not reentrant, so one lock
+ * is shared by every instance in the process.
+ * @return The process-wide lock.
+ */
+std::mutex &eam_mutex() {
+  static std::mutex m;
+  return m;
+}
+
+} // namespace
+
 /**
  * @details
- * This method validates that the input system contains only Copper (29)
- * and Hydrogen (1) atoms. It uses a @c std::multiset to count occurrences
- * of each species.
- * * The box vectors are simplified to a diagonal representation (cubic)
- * before being passed to the @c c_force_eam Fortran bridge.
- * * @warning Throws @c std::runtime_error if species other than Cu or H
+ * The system may only contain Copper (29) and Hydrogen (1) atoms. The
+ * species are counted on every call: one pass without allocation, which
+ * is cheap next to the EAM evaluation and cannot trust a stale result.
+ *
+ * @warning Throws @c std::runtime_error if species other than Cu or H
  * are present, or if either species is entirely missing.
  */
-void CuH2Pot::forceImpl(const ForceInput &in, ForceOut *out) const {
-  std::multiset<double> natmc;
-  const auto N = in.nAtoms;
-  int natms[2]{0, 0};                // Always Cu, then H
-  int ndim{3 * static_cast<int>(N)}; // see main.f90
-
+std::array<int, 2> CuH2Pot::composition(const int *atmnrs, size_t N) {
+  std::array<int, 2> natms{0, 0}; // Always Cu, then H
   for (size_t i = 0; i < N; ++i) {
-    natmc.insert(in.atmnrs[i]);
+    if (atmnrs[i] == 29) {
+      ++natms[0];
+    } else if (atmnrs[i] == 1) {
+      ++natms[1];
+    }
   }
 
-  if (natmc.count(29) <= 0 || natmc.count(1) <= 0) {
+  if (natms[0] <= 0 || natms[1] <= 0) {
     throw std::runtime_error("The system does not have Copper or Hydrogen, but "
                              "the CuH2 potential was requested");
   }
 
-  natms[0] = natmc.count(29); // Cu
-  natms[1] = natmc.count(1);  // H
-
-  if (natms[0] + natms[1] != N) {
+  if (static_cast<size_t>(natms[0] + natms[1]) != N) {
     throw std::runtime_error("The system has other atom types, but the CuH2 "
                              "potential was requested");
   }
+  return natms;
+}
+
+/**
+ * @details
+ * The species are validated by @c composition. The Fortran EAM code only
+ * takes box lengths, so the cell must be orthogonal; its diagonal is
+ * passed to the @c c_force_eam Fortran bridge, which is entered by one
+ * thread of the process at a time.
+ *
+ * @warning Throws @c std::runtime_error for a skewed cell.
+ */
+void CuH2Pot::forceImpl(const ForceInput &in, ForceOut *out) const {
+  auto natms = composition(in.atmnrs, in.nAtoms);
+  if (!PeriodicCell(in.box).orthogonal()) {
+    throw std::runtime_error("The CuH2 potential requires an orthogonal box");
+  }
+  int ndim{3 * static_cast<int>(in.nAtoms)}; // see main.f90
 
-  // The box only takes the diagonal (assumes cubic)
   double box_eam[]{in.box[0], in.box[4], in.box[8]};
 
-  c_force_eam(natms, ndim, box_eam, const_cast<double *>(in.pos), out->F,
+  std::lock_guard<std::mutex> lock(eam_mutex());
+  c_force_eam(natms.data(), ndim, box_eam, const_cast<double *>(in.pos), out->F,
               &out->energy);
 }
 
+/**
+ * @details
+ * Replicas are not dispatched to several threads, since the Fortran EAM
+ * code behind @c c_force_eam is not reentrant and runs under one lock.
+ */
+void CuH2Pot::calculate_batch(size_t nconf, size_t nAtoms,
+                              const double *positions, const int *atmtypes,
+                              const double *boxes, double *energies,
+                              double *forces) {
+  if (nconf > 0 && atmtypes) {
+    composition(atmtypes, nAtoms);
+  }
+  Potential::calculate_batch(nconf, nAtoms, positions, atmtypes, boxes,
+                             energies, forces);
+}
+
 } // namespace rgpot
@@ -11,6 +11,8 @@
  */
 
 // clang-format off
+#include <array>
+#include <cstddef>
 #include <utility>
 #include <vector>
 // clang-format on
@@ -54,7 +56,36 @@ public:
    */
   void forceImpl(const ForceInput &in, ForceOut *out) const override;
 
+  /**
+   * @brief Evaluates several replicas of one system, e.g. NEB images.
+   *
+   * The composition is validated once, before any replica is evaluated,
+   * and the replicas then run in order through the cache and force call
+   * accounting of @c Potential::calculate_batch.
+   *
+   * @param nconf Number of replicas.
+   * @param nAtoms Number of atoms in every replica.
+   * @param positions Flat [nconf x nAtoms x 3] array of coordinates.
+   * @param atmtypes The atomic numbers, shared by all replicas.
+   * @param boxes Flat [nconf x 9] array of simulation cells.
+   * @param energies Output array of size @a nconf.
+   * @param forces Output flat [nconf x nAtoms x 3] array of forces.
+   * @return Void.
+   */
+  void calculate_batch(size_t nconf, size_t nAtoms, const double *positions,
+                       const int *atmtypes, const double *boxes,
+                       double *energies, double *forces) override;
+
 private:
+  /**
+   * @brief Counts and validates the Cu and H atoms of a system.
+   *
+   * @param atmnrs The atomic numbers.
+   * @param N Number of atoms.
+   * @return The Cu and H counts, in the order of @c c_force_eam.
+   */
+  static std::array<int, 2> composition(const int *atmnrs, size_t N);
+
   /**
    * @brief Legacy eOn-compatible force interface.
    * @param N          Number of atoms.
@@ -0,0 +1,322 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Implementation of the memory-mapped frame files.
+ *
+ * The blocks follow the header in the order of their @c Field bits, each
+ * one rounded up to 64 bytes. Ranges handed to @c madvise and @c msync are
+ * aligned to pages: outwards when reading ahead or writing back, inwards
+ * when dropping pages, so that neighboring frames keep theirs.
+ */
+
+// clang-format off
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "rgpot/FrameFile.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RGPOT_FRAMES_MMAP 1
+#endif
+// clang-format on
+
+namespace rgpot::frames {
+
+namespace {
+
+/**
+ * @brief Byte offsets of the parts of a file.
+ */
+struct Layout {
+  uint64_t blocks[3] = {0, 0, 0};  //!< Start of each field, 0 if absent.
+  uint64_t strides[3] = {0, 0, 0}; //!< Bytes per frame of each field.
+  uint64_t total = 0;              //!< File size.
+};
+
+/**
+ * @brief The fields in block order, indexing @c Layout.
+ */
+constexpr Field kFields[3] = {Positions, Energies, Forces};
+
+/**
+ * @brief Multiplies sizes, rejecting overflow.
+ * @param a A size.
+ * @param b Another size.
+ * @return The product.
+ */
+uint64_t checked_mul(uint64_t a, uint64_t b) {
+  if (b != 0 && a > std::numeric_limits<uint64_t>::max() / b) {
+    throw std::overflow_error("Frame file shape is too large");
+  }
+  return a * b;
+}
+
+/**
+ * @brief Rounds a size up to the block alignment.
+ * @param bytes A size.
+ * @return The next multiple of 64.
+ */
+uint64_t align_up(uint64_t bytes) {
+  if (bytes > std::numeric_limits<uint64_t>::max() - 63) {
+    throw std::overflow_error("Frame file shape is too large");
+  }
+  return (bytes + 63) / 64 * 64;
+}
+
+/**
+ * @brief Places the blocks of a file.
+ * @param fields The @c Field blocks stored.
+ * @param natoms Atoms of every frame.
+ * @param nframes Number of frames.
+ * @return The offsets.
+ */
+Layout layout(uint32_t fields, uint64_t natoms, uint64_t nframes) {
+  Layout out;
+  uint64_t offset =
+      align_up(sizeof(FileHeader) + checked_mul(natoms, sizeof(int32_t)));
+  for (size_t k = 0; k < 3; ++k) {
+    if ((fields & kFields[k]) == 0) {
+      continue;
+    }
+    out.strides[k] =
+        kFields[k] == Energies ? sizeof(double)
+                               : checked_mul(natoms, 3 * sizeof(double));
+    out.blocks[k] = offset;
+    offset = align_up(offset + checked_mul(out.strides[k], nframes));
+  }
+  out.total = offset;
+  return out;
+}
+
+#ifdef RGPOT_FRAMES_MMAP
+
+/**
+ * @brief Fetches the page size.
+ * @return Bytes of a page.
+ */
+uintptr_t page_bytes() {
+  static const auto page = static_cast<uintptr_t>(::sysconf(_SC_PAGESIZE));
+  return page;
+}
+
+/**
+ * @brief Maps a file descriptor, closing it.
+ * @param fd Open descriptor.
+ * @param bytes Length to map.
+ * @param writable Whether to map for writing.
+ * @param path Context for the error message.
+ * @return The mapping.
+ */
+void *map_fd(int fd, size_t bytes, bool writable, const std::string &path) {
+  const int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+  void *base = ::mmap(nullptr, bytes, prot, MAP_SHARED, fd, 0);
+  const int err = errno;
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    throw std::runtime_error("mmap of " + path + ": " + std::strerror(err));
+  }
+  return base;
+}
+
+#endif // RGPOT_FRAMES_MMAP
+
+} // namespace
+
+uint64_t FrameFile::file_bytes(uint32_t fields, uint64_t natoms,
+                               uint64_t nframes) {
+  return layout(fields, natoms, nframes).total;
+}
+
+const int32_t *FrameFile::atmnrs() const {
+  return reinterpret_cast<const int32_t *>(static_cast<const char *>(m_base) +
+                                           sizeof(FileHeader));
+}
+
+double *FrameFile::data(Field field, uint64_t frame) const {
+  const FileHeader &hdr = header();
+  const Layout parts = layout(hdr.fields, hdr.natoms, hdr.nframes);
+  for (size_t k = 0; k < 3; ++k) {
+    if (kFields[k] == field && parts.blocks[k] != 0) {
+      return reinterpret_cast<double *>(static_cast<char *>(m_base) +
+                                        parts.blocks[k] +
+                                        frame * parts.strides[k]);
+    }
+  }
+  return nullptr;
+}
+
+double *FrameFile::positions(uint64_t frame) const {
+  return data(Positions, frame);
+}
+
+double *FrameFile::energies(uint64_t frame) const {
+  return data(Energies, frame);
+}
+
+double *FrameFile::forces(uint64_t frame) const { return data(Forces, frame); }
+
+template <typename Fn>
+void FrameFile::for_each_range(uint64_t first, uint64_t count,
+                               Fn &&fn) const {
+  const FileHeader &hdr = header();
+  if (first >= hdr.nframes || count == 0) {
+    return;
+  }
+  count = std::min(count, hdr.nframes - first);
+  const Layout parts = layout(hdr.fields, hdr.natoms, hdr.nframes);
+  for (size_t k = 0; k < 3; ++k) {
+    if (parts.blocks[k] == 0) {
+      continue;
+    }
+    char *begin = static_cast<char *>(m_base) + parts.blocks[k] +
+                  first * parts.strides[k];
+    fn(begin, begin + count * parts.strides[k]);
+  }
+}
+
+#ifdef RGPOT_FRAMES_MMAP
+
+FrameFile FrameFile::open(const std::string &path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("open of " + path + ": " + std::strerror(errno));
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<uint64_t>(st.st_size) < sizeof(FileHeader)) {
+    ::close(fd);
+    throw std::runtime_error(path + " is not a frame file");
+  }
+  const auto bytes = static_cast<size_t>(st.st_size);
+  FrameFile file(path, map_fd(fd, bytes, false, path), bytes);
+  const FileHeader &hdr = file.header();
+  if (hdr.magic != kMagic) {
+    throw std::runtime_error(path + " is not a frame file of this byte order");
+  }
+  if (hdr.version != kVersion || (hdr.fields & ~(Positions | Energies |
+                                                 Forces)) != 0) {
+    throw std::runtime_error(path + " has an unknown frame file version");
+  }
+  if (file_bytes(hdr.fields, hdr.natoms, hdr.nframes) > bytes) {
+    throw std::runtime_error(path + " is truncated");
+  }
+  return file;
+}
+
+/**
+ * @details
+ * The file is sized with @c ftruncate, so frames not written yet read as
+ * zeros and take no disk space until their pages are touched.
+ */
+FrameFile FrameFile::create(const std::string &path, uint32_t fields,
+                            uint64_t natoms, uint64_t nframes,
+                            const int32_t *atmnrs, const double *box) {
+  if ((fields & ~(Positions | Energies | Forces)) != 0) {
+    throw std::invalid_argument("Unknown frame file fields");
+  }
+  const uint64_t bytes = file_bytes(fields, natoms, nframes);
+  if (bytes > std::numeric_limits<size_t>::max() ||
+      bytes > static_cast<uint64_t>(std::numeric_limits<off_t>::max())) {
+    throw std::overflow_error("Frame file shape is too large");
+  }
+  const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("open of " + path + ": " + std::strerror(errno));
+  }
+  if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+    const int err = errno;
+    ::close(fd);
+    throw std::runtime_error("ftruncate of " + path + ": " +
+                             std::strerror(err));
+  }
+  FrameFile file(path, map_fd(fd, bytes, true, path),
+                 static_cast<size_t>(bytes));
+  auto *hdr = static_cast<FileHeader *>(file.m_base);
+  hdr->magic = kMagic;
+  hdr->version = kVersion;
+  hdr->fields = fields;
+  hdr->natoms = natoms;
+  hdr->nframes = nframes;
+  std::memcpy(hdr->box, box, sizeof(hdr->box));
+  if (natoms != 0) {
+    std::memcpy(const_cast<int32_t *>(file.atmnrs()), atmnrs,
+                natoms * sizeof(int32_t));
+  }
+  return file;
+}
+
+FrameFile::~FrameFile() {
+  if (m_base) {
+    ::munmap(m_base, m_bytes);
+  }
+}
+
+void FrameFile::prefetch(uint64_t first, uint64_t count) const {
+  const uintptr_t page = page_bytes();
+  for_each_range(first, count, [page](char *begin, char *end) {
+    const uintptr_t lo = reinterpret_cast<uintptr_t>(begin) / page * page;
+    const uintptr_t hi = reinterpret_cast<uintptr_t>(end);
+    ::madvise(reinterpret_cast<void *>(lo), hi - lo, MADV_WILLNEED);
+  });
+}
+
+void FrameFile::evict(uint64_t first, uint64_t count) const {
+  const uintptr_t page = page_bytes();
+  for_each_range(first, count, [page](char *begin, char *end) {
+    const uintptr_t lo =
+        (reinterpret_cast<uintptr_t>(begin) + page - 1) / page * page;
+    const uintptr_t hi = reinterpret_cast<uintptr_t>(end) / page * page;
+    if (hi > lo) {
+      ::madvise(reinterpret_cast<void *>(lo), hi - lo, MADV_DONTNEED);
+    }
+  });
+}
+
+void FrameFile::flush(uint64_t first, uint64_t count, bool wait) const {
+  const uintptr_t page = page_bytes();
+  for_each_range(first, count, [this, page, wait](char *begin, char *end) {
+    const uintptr_t lo = reinterpret_cast<uintptr_t>(begin) / page * page;
+    const uintptr_t hi = reinterpret_cast<uintptr_t>(end);
+    if (::msync(reinterpret_cast<void *>(lo), hi - lo,
+                wait ? MS_SYNC : MS_ASYNC) != 0) {
+      throw std::runtime_error("msync of " + m_path + ": " +
+                               std::strerror(errno));
+    }
+  });
+}
+
+#else
+
+FrameFile FrameFile::open(const std::string &) {
+  throw std::runtime_error("Frame files require POSIX mmap");
+}
+
+FrameFile FrameFile::create(const std::string &, uint32_t, uint64_t,
+                            uint64_t, const int32_t *, const double *) {
+  throw std::runtime_error("Frame files require POSIX mmap");
+}
+
+FrameFile::~FrameFile() = default;
+
+void FrameFile::prefetch(uint64_t, uint64_t) const {}
+void FrameFile::evict(uint64_t, uint64_t) const {}
+void FrameFile::flush(uint64_t, uint64_t, bool) const {}
+
+#endif // RGPOT_FRAMES_MMAP
+
+FrameFile::FrameFile(FrameFile &&other) noexcept
+    : m_path(std::move(other.m_path)), m_base(other.m_base),
+      m_bytes(other.m_bytes) {
+  other.m_base = nullptr;
+  other.m_bytes = 0;
+}
+
+} // namespace rgpot::frames
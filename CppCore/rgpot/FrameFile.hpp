@@ -0,0 +1,222 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Memory-mapped binary trajectories of one system.
+ *
+ * A frame file holds any number of frames of a fixed system: a 128 byte
+ * @c FileHeader with the atom count, frame count and box, the atomic
+ * numbers, then one contiguous block per stored field, all frames of the
+ * field back to back:
+ *
+ * - positions, @c 3 * natoms doubles per frame;
+ * - energies, one double per frame;
+ * - forces, @c 3 * natoms doubles per frame.
+ *
+ * Every block starts on a 64 byte boundary, so the frames are read and
+ * written in place through the mapping without any parsing, and a run of
+ * frames is exactly the layout @c PotentialBase::calculate_batch expects.
+ * Values are stored in the byte order of the machine writing the file;
+ * another byte order is rejected as a foreign file. Mapping files requires
+ * POSIX, elsewhere opening one throws.
+ */
+
+// clang-format off
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+// clang-format on
+
+namespace rgpot::frames {
+
+/**
+ * @brief The bytes "RGPOTFRM" read as a little-endian integer.
+ */
+inline constexpr uint64_t kMagic = 0x4D5246544F504752ULL;
+
+/**
+ * @brief Version of the file layout.
+ */
+inline constexpr uint32_t kVersion = 1;
+
+/**
+ * @brief Per-frame fields, combined as bits in @c FileHeader::fields.
+ */
+enum Field : uint32_t {
+  Positions = 1u << 0, //!< Atomic positions.
+  Energies = 1u << 1,  //!< Total energy.
+  Forces = 1u << 2,    //!< Atomic forces.
+};
+
+/**
+ * @brief Start of every frame file.
+ */
+struct FileHeader {
+  uint64_t magic;       //!< @c kMagic.
+  uint32_t version;     //!< @c kVersion.
+  uint32_t fields;      //!< The @c Field blocks stored.
+  uint64_t natoms;      //!< Atoms of every frame.
+  uint64_t nframes;     //!< Number of frames.
+  double box[9];        //!< Simulation cell, row-major.
+  uint64_t reserved[3]; //!< Zero, pads the header to 128 bytes.
+};
+
+static_assert(sizeof(FileHeader) == 128, "Header layout is on disk");
+
+/**
+ * @class FrameFile
+ * @brief Mapping of a frame file.
+ *
+ * Opened files are mapped read-only; created files are mapped for writing,
+ * and the pointers of a read-only mapping must not be written through.
+ * Frame pointers are valid as long as the mapping lives.
+ */
+class FrameFile {
+public:
+  /**
+   * @brief Maps an existing file for reading.
+   * @param path Path of the file.
+   * @return The mapping.
+   * @throws std::runtime_error when the file is missing, truncated or not a
+   * frame file.
+   */
+  static FrameFile open(const std::string &path);
+
+  /**
+   * @brief Creates a zero-filled file and maps it for writing.
+   * @param path Path of the file, replaced if it exists.
+   * @param fields The @c Field blocks to store.
+   * @param natoms Atoms of every frame.
+   * @param nframes Number of frames.
+   * @param atmnrs Atomic numbers [natoms].
+   * @param box Simulation cell, row-major [9].
+   * @return The mapping.
+   * @throws std::runtime_error when the file cannot be created.
+   */
+  static FrameFile create(const std::string &path, uint32_t fields,
+                          uint64_t natoms, uint64_t nframes,
+                          const int32_t *atmnrs, const double *box);
+
+  ~FrameFile();
+  FrameFile(FrameFile &&other) noexcept;
+  FrameFile &operator=(FrameFile &&other) = delete;
+  FrameFile(const FrameFile &) = delete;
+  FrameFile &operator=(const FrameFile &) = delete;
+
+  /**
+   * @brief Fetches the header.
+   * @return The header in the mapping.
+   */
+  [[nodiscard]] const FileHeader &header() const {
+    return *static_cast<const FileHeader *>(m_base);
+  }
+
+  /**
+   * @brief Fetches the atom count.
+   * @return Atoms of every frame.
+   */
+  [[nodiscard]] uint64_t natoms() const { return header().natoms; }
+
+  /**
+   * @brief Fetches the frame count.
+   * @return Number of frames.
+   */
+  [[nodiscard]] uint64_t nframes() const { return header().nframes; }
+
+  /**
+   * @brief Fetches the simulation cell.
+   * @return The row-major box in the header.
+   */
+  [[nodiscard]] const double *box() const { return header().box; }
+
+  /**
+   * @brief Checks whether a field is stored.
+   * @param field The field.
+   * @return True if the file has its block.
+   */
+  [[nodiscard]] bool has(Field field) const {
+    return (header().fields & field) != 0;
+  }
+
+  /**
+   * @brief Fetches the atomic numbers.
+   * @return The @c natoms() numbers in the mapping.
+   */
+  [[nodiscard]] const int32_t *atmnrs() const;
+
+  /**
+   * @brief Fetches the start of a frame in one block.
+   * @param field The field.
+   * @param frame Frame index, at most @c nframes().
+   * @return The values of @a frame and the frames after it, or
+   * @c nullptr without the field.
+   */
+  [[nodiscard]] double *data(Field field, uint64_t frame) const;
+
+  [[nodiscard]] double *positions(uint64_t frame) const; //!< Positions.
+  [[nodiscard]] double *energies(uint64_t frame) const;  //!< Energies.
+  [[nodiscard]] double *forces(uint64_t frame) const;    //!< Forces.
+
+  /**
+   * @brief Asks the kernel to read a range of frames ahead of use.
+   * @param first First frame.
+   * @param count Number of frames.
+   * @return Void.
+   */
+  void prefetch(uint64_t first, uint64_t count) const;
+
+  /**
+   * @brief Drops the cached pages of a range of frames that was used.
+   *
+   * Pages shared with neighboring frames are kept; the file itself is not
+   * changed, so the frames are read again if they are used later.
+   *
+   * @param first First frame.
+   * @param count Number of frames.
+   * @return Void.
+   */
+  void evict(uint64_t first, uint64_t count) const;
+
+  /**
+   * @brief Writes a range of frames back to the file.
+   * @param first First frame.
+   * @param count Number of frames.
+   * @param wait Whether to block until the data is on disk.
+   * @return Void.
+   * @throws std::runtime_error when the write back fails.
+   */
+  void flush(uint64_t first, uint64_t count, bool wait) const;
+
+  /**
+   * @brief Bytes a file of the given shape takes.
+   * @param fields The @c Field blocks stored.
+   * @param natoms Atoms of every frame.
+   * @param nframes Number of frames.
+   * @return The file size.
+   * @throws std::overflow_error for shapes beyond the address space.
+   */
+  static uint64_t file_bytes(uint32_t fields, uint64_t natoms,
+                             uint64_t nframes);
+
+private:
+  FrameFile(std::string path, void *base, size_t bytes)
+      : m_path(std::move(path)), m_base(base), m_bytes(bytes) {}
+
+  /**
+   * @brief Calls @a fn with the byte range of some frames in every block.
+   * @param first First frame.
+   * @param count Number of frames.
+   * @param fn Callable @c void(char*, char*).
+   * @return Void.
+   */
+  template <typename Fn>
+  void for_each_range(uint64_t first, uint64_t count, Fn &&fn) const;
+
+  std::string m_path; //!< Path, for error messages.
+  void *m_base;       //!< Start of the mapping.
+  size_t m_bytes;     //!< Length of the mapping.
+};
+
+} // namespace rgpot::frames
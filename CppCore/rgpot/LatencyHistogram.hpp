@@ -0,0 +1,211 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief High dynamic range histogram of latencies.
+ *
+ * Defines @c LatencyHistogram, a log-linear histogram in the spirit of
+ * HdrHistogram: every power of two is split into equal sub-buckets, so
+ * values from a nanosecond to centuries are recorded in constant time with
+ * a bounded relative error. Used by the @c potload load generator to report
+ * tail latencies.
+ */
+
+// clang-format off
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+// clang-format on
+
+namespace rgpot {
+
+/**
+ * @class LatencyHistogram
+ * @brief Log-linear histogram of unsigned 64-bit values.
+ * @ingroup rgpot
+ *
+ * Values below @c 2^sub_bucket_bits are counted exactly; above that every
+ * power of two holds @c 2^(sub_bucket_bits-1) sub-buckets, bounding the
+ * relative error of a reported percentile by @c 2^(1-sub_bucket_bits).
+ * Not thread-safe: give every thread its own histogram and @c merge them.
+ */
+class LatencyHistogram {
+public:
+  static constexpr unsigned sub_bucket_bits = 8; //!< Exact range, in bits.
+  static constexpr uint64_t sub_bucket_count =
+      uint64_t{1} << sub_bucket_bits; //!< Values counted exactly.
+  static constexpr uint64_t sub_bucket_half =
+      sub_bucket_count / 2; //!< Sub-buckets per power of two.
+  static constexpr size_t num_counts =
+      sub_bucket_count +
+      (64 - sub_bucket_bits) * sub_bucket_half; //!< Buckets in total.
+
+  /**
+   * @brief Constructor for LatencyHistogram.
+   */
+  LatencyHistogram() : m_counts(num_counts, 0) {}
+
+  /**
+   * @brief Records occurrences of a value.
+   * @param value The value, usually nanoseconds.
+   * @param n Number of occurrences.
+   * @return Void.
+   */
+  void record(uint64_t value, uint64_t n = 1) {
+    m_counts[index_of(value)] += n;
+    m_total += n;
+    m_sum += static_cast<long double>(value) * n;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+  }
+
+  /**
+   * @brief Records a value, back-filling the samples a stalled closed loop
+   * failed to take.
+   *
+   * When a request of a loop expecting one sample every @a expected_interval
+   * takes longer, the requests that would have been sent meanwhile are
+   * recorded with the latencies they would have seen, which removes the
+   * coordinated omission bias of closed-loop measurements.
+   *
+   * @param value The measured value.
+   * @param expected_interval Expected time between samples, 0 disables the
+   * correction.
+   * @return Void.
+   */
+  void record_corrected(uint64_t value, uint64_t expected_interval) {
+    record(value);
+    if (expected_interval == 0) {
+      return;
+    }
+    for (uint64_t missing = value; missing > expected_interval;) {
+      missing -= expected_interval;
+      record(missing);
+    }
+  }
+
+  /**
+   * @brief Adds the counts of another histogram.
+   * @param other The histogram to add.
+   * @return Void.
+   */
+  void merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < num_counts; ++i) {
+      m_counts[i] += other.m_counts[i];
+    }
+    m_total += other.m_total;
+    m_sum += other.m_sum;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+  }
+
+  /**
+   * @brief Clears every count.
+   * @return Void.
+   */
+  void reset() {
+    std::fill(m_counts.begin(), m_counts.end(), 0);
+    m_total = 0;
+    m_sum = 0;
+    m_min = std::numeric_limits<uint64_t>::max();
+    m_max = 0;
+  }
+
+  /**
+   * @brief Number of recorded values.
+   * @return The total count.
+   */
+  [[nodiscard]] uint64_t count() const { return m_total; }
+
+  /**
+   * @brief Smallest recorded value.
+   * @return The exact minimum, 0 when empty.
+   */
+  [[nodiscard]] uint64_t min() const { return m_total ? m_min : 0; }
+
+  /**
+   * @brief Largest recorded value.
+   * @return The exact maximum, 0 when empty.
+   */
+  [[nodiscard]] uint64_t max() const { return m_max; }
+
+  /**
+   * @brief Mean of the recorded values.
+   * @return The exact mean, 0 when empty.
+   */
+  [[nodiscard]] double mean() const {
+    return m_total ? static_cast<double>(m_sum / m_total) : 0.0;
+  }
+
+  /**
+   * @brief Value below which a fraction of the recorded values fall.
+   * @param percentile Percentile in [0, 100].
+   * @return The largest value equivalent to the bucket holding the
+   * percentile, capped by the maximum; the minimum for 0 and 0 when empty.
+   */
+  [[nodiscard]] uint64_t value_at_percentile(double percentile) const {
+    if (m_total == 0) {
+      return 0;
+    }
+    if (percentile <= 0.0) {
+      return m_min;
+    }
+    const double fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+    const auto target = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(fraction * m_total)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < num_counts; ++i) {
+      seen += m_counts[i];
+      if (seen >= target) {
+        return std::clamp(highest_equivalent(i), min(), m_max);
+      }
+    }
+    return m_max;
+  }
+
+  /**
+   * @brief Maps a value to its bucket.
+   * @param value The value.
+   * @return Index into the counts.
+   */
+  static size_t index_of(uint64_t value) {
+    if (value < sub_bucket_count) {
+      return static_cast<size_t>(value);
+    }
+    const unsigned shift = std::bit_width(value) - sub_bucket_bits;
+    const uint64_t sub = value >> shift;
+    return static_cast<size_t>(sub_bucket_count +
+                               (shift - 1) * sub_bucket_half +
+                               (sub - sub_bucket_half));
+  }
+
+  /**
+   * @brief Largest value sharing a bucket.
+   * @param index Index into the counts.
+   * @return The upper edge of the bucket.
+   */
+  static uint64_t highest_equivalent(size_t index) {
+    if (index < sub_bucket_count) {
+      return index;
+    }
+    const size_t rel = index - sub_bucket_count;
+    const unsigned shift = static_cast<unsigned>(rel / sub_bucket_half) + 1;
+    const uint64_t sub = sub_bucket_half + rel % sub_bucket_half;
+    const uint64_t lowest = sub << shift;
+    return lowest + ((uint64_t{1} << shift) - 1);
+  }
+
+private:
+  std::vector<uint64_t> m_counts; //!< Counts per bucket.
+  uint64_t m_total{0};            //!< Number of recorded values.
+  long double m_sum{0};           //!< Sum of recorded values.
+  uint64_t m_min{std::numeric_limits<uint64_t>::max()}; //!< Exact minimum.
+  uint64_t m_max{0};                                     //!< Exact maximum.
+};
+
+} // namespace rgpot
@@ -0,0 +1,173 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Lennard-Jones pair terms shared by the host and the GPU backend.
+ *
+ * Defines the cell and pair functions run by every GPU thread of
+ * @c LJGpuPot. They are plain inline C++ marked @c RGPOT_HOST_DEVICE, so a
+ * host build runs the same arithmetic and the tests compare it with
+ * @c LJPot without a GPU.
+ */
+
+// clang-format off
+#include <cmath>
+#include <cstddef>
+// clang-format on
+#include "rgpot/LennardJones/LJKernels.hpp"
+
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define RGPOT_HOST_DEVICE __host__ __device__
+#else
+#define RGPOT_HOST_DEVICE
+#endif
+
+namespace rgpot {
+
+/**
+ * @brief Cell matrix and inverse in a form kernels can take by value.
+ *
+ * Mirrors @c PeriodicCell, whose constructor is not available in device
+ * code. The two agree on the inverse and on which cells are orthogonal.
+ */
+struct LJDeviceCell {
+  double box[9];   //!< Cell vectors as rows.
+  double inv[9];   //!< Inverse of @c box.
+  bool orthogonal; //!< Whether @c box is diagonal.
+};
+
+/**
+ * @brief Builds the cell of a box matrix.
+ *
+ * Same inverse and orthogonality test as @c PeriodicCell, but a singular
+ * box is not reported and yields non-finite results.
+ *
+ * @param box Flat 3x3 cell matrix, one cell vector per row.
+ * @return The cell with its inverse.
+ */
+RGPOT_HOST_DEVICE inline LJDeviceCell make_device_cell(const double *box) {
+  LJDeviceCell c{};
+  for (size_t k = 0; k < 9; ++k) {
+    c.box[k] = box[k];
+  }
+  const double *m = c.box;
+  const double scale = fmax(fabs(m[0]), fmax(fabs(m[4]), fabs(m[8])));
+  const double tol = 1e-12 * scale;
+  c.orthogonal = fabs(m[1]) <= tol && fabs(m[2]) <= tol &&
+                 fabs(m[3]) <= tol && fabs(m[5]) <= tol &&
+                 fabs(m[6]) <= tol && fabs(m[7]) <= tol;
+  if (c.orthogonal) {
+    c.inv[0] = 1.0 / m[0];
+    c.inv[4] = 1.0 / m[4];
+    c.inv[8] = 1.0 / m[8];
+    return c;
+  }
+  const double inv_det = 1.0 / (m[0] * (m[4] * m[8] - m[5] * m[7]) -
+                                m[1] * (m[3] * m[8] - m[5] * m[6]) +
+                                m[2] * (m[3] * m[7] - m[4] * m[6]));
+  c.inv[0] = (m[4] * m[8] - m[5] * m[7]) * inv_det;
+  c.inv[1] = (m[2] * m[7] - m[1] * m[8]) * inv_det;
+  c.inv[2] = (m[1] * m[5] - m[2] * m[4]) * inv_det;
+  c.inv[3] = (m[5] * m[6] - m[3] * m[8]) * inv_det;
+  c.inv[4] = (m[0] * m[8] - m[2] * m[6]) * inv_det;
+  c.inv[5] = (m[2] * m[3] - m[0] * m[5]) * inv_det;
+  c.inv[6] = (m[3] * m[7] - m[4] * m[6]) * inv_det;
+  c.inv[7] = (m[1] * m[6] - m[0] * m[7]) * inv_det;
+  c.inv[8] = (m[0] * m[4] - m[1] * m[3]) * inv_det;
+  return c;
+}
+
+/**
+ * @brief Evaluates one pair under the minimum image convention.
+ *
+ * Same arithmetic as the scalar kernel of @c lj_pair_range. The branch on
+ * @c cell.orthogonal is uniform across a launch, so GPU threads do not
+ * diverge on it.
+ *
+ * @param ri Position of the first atom.
+ * @param rj Position of the second atom.
+ * @param params Potential parameters.
+ * @param cell Simulation cell.
+ * @param fi Force on the first atom, added to.
+ * @return The shifted pair energy, or zero beyond the cutoff.
+ */
+RGPOT_HOST_DEVICE inline double lj_pair_image(const double *ri,
+                                              const double *rj,
+                                              const LJParams &params,
+                                              const LJDeviceCell &cell,
+                                              double *fi) {
+  double d[3]{ri[0] - rj[0], ri[1] - rj[1], ri[2] - rj[2]};
+  if (cell.orthogonal) {
+    for (size_t k = 0; k < 3; ++k) {
+      d[k] -= cell.box[4 * k] * floor(d[k] * cell.inv[4 * k] + 0.5);
+    }
+  } else {
+    double s[3];
+    for (size_t k = 0; k < 3; ++k) {
+      s[k] = d[0] * cell.inv[k] + d[1] * cell.inv[3 + k] +
+             d[2] * cell.inv[6 + k];
+      s[k] -= floor(s[k] + 0.5);
+    }
+    for (size_t k = 0; k < 3; ++k) {
+      d[k] = s[0] * cell.box[k] + s[1] * cell.box[3 + k] +
+             s[2] * cell.box[6 + k];
+    }
+  }
+  const double r2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+  if (!(r2 < params.cutoff * params.cutoff)) {
+    return 0.0;
+  }
+  const double inv_r2 = 1.0 / r2;
+  const double s2 = params.psi * params.psi * inv_r2;
+  const double s6 = s2 * s2 * s2;
+  const double fs = 24.0 * params.u0 * s6 * (2.0 * s6 - 1.0) * inv_r2;
+  fi[0] += fs * d[0];
+  fi[1] += fs * d[1];
+  fi[2] += fs * d[2];
+  return 4.0 * params.u0 * s6 * (s6 - 1.0) - params.shift;
+}
+
+/**
+ * @brief Sums the pair terms of one atom with every other atom.
+ *
+ * The work of one GPU thread, without the shared memory tiling of the
+ * kernel. Each pair is visited from both of its atoms, so the total energy
+ * is half the sum over all atoms.
+ *
+ * @param i The atom.
+ * @param n_atoms Number of atoms.
+ * @param pos Interleaved positions of all atoms.
+ * @param params Potential parameters.
+ * @param cell Simulation cell.
+ * @param fi Receives the force on atom @a i.
+ * @return The energy of all pairs of atom @a i.
+ */
+RGPOT_HOST_DEVICE inline double
+lj_atom_all_pairs(size_t i, size_t n_atoms, const double *pos,
+                  const LJParams &params, const LJDeviceCell &cell,
+                  double *fi) {
+  fi[0] = fi[1] = fi[2] = 0.0;
+  double energy = 0.0;
+  for (size_t j = 0; j < n_atoms; ++j) {
+    if (j != i) {
+      energy += lj_pair_image(pos + 3 * i, pos + 3 * j, params, cell, fi);
+    }
+  }
+  return energy;
+}
+
+/**
+ * @brief Parameters of the shifted 12-6 form with a continuous energy.
+ * @param u0 Well depth.
+ * @param psi Distance at which the unshifted potential is zero.
+ * @param cutoff Interaction cutoff radius.
+ * @return The parameters, shifted by the pair energy at @a cutoff as in
+ *         @c LJPot.
+ */
+inline LJParams shifted_lj_params(double u0, double psi, double cutoff) {
+  return {u0, psi, cutoff,
+          4.0 * u0 * (std::pow(psi / cutoff, 12) - std::pow(psi / cutoff, 6))};
+}
+
+} // namespace rgpot
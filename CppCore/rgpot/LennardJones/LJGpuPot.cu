@@ -0,0 +1,179 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief CUDA and HIP implementation of the GPU Lennard-Jones potential.
+ *
+ * The same source compiles with @c nvcc and with @c hipcc; the runtime
+ * calls are spelled through @c RGPOT_GPU, which prefixes them with
+ * @c cuda or @c hip. The pair arithmetic lives in @c LJDevice.hpp.
+ */
+
+// clang-format off
+#include <stdexcept>
+#include <string>
+// clang-format on
+#if defined(__HIPCC__)
+#include <hip/hip_runtime.h>
+#define RGPOT_GPU(name) hip##name
+#else
+#include <cuda_runtime.h>
+#define RGPOT_GPU(name) cuda##name
+#endif
+#include "rgpot/LennardJones/LJGpuPot.hpp"
+
+namespace rgpot {
+
+namespace {
+
+constexpr unsigned kBlock = 256; //!< Threads per block and atoms per tile.
+
+/**
+ * @brief Throws on a failed runtime call.
+ * @param status Status of the call.
+ * @param what Name of the call.
+ * @return Void.
+ */
+void check(RGPOT_GPU(Error_t) status, const char *what) {
+  if (status != RGPOT_GPU(Success)) {
+    throw std::runtime_error(std::string(what) + ": " +
+                             RGPOT_GPU(GetErrorString)(status));
+  }
+}
+
+/**
+ * @brief All-pairs forces and energy, one thread per atom.
+ *
+ * Each block walks the atoms in tiles of @c kBlock positions staged in
+ * shared memory. Every thread writes the force of its own atom, so the
+ * forces need neither atomics nor zeroing; the halved pair energies are
+ * reduced per block and added to @a energy.
+ *
+ * @param n_atoms Number of atoms.
+ * @param pos Interleaved positions.
+ * @param box Cell matrix, one vector per row.
+ * @param params Potential parameters.
+ * @param F Forces, overwritten.
+ * @param energy Energy accumulator, added to.
+ * @return Void.
+ */
+__global__ void lj_all_pairs_kernel(size_t n_atoms,
+                                    const double *__restrict__ pos,
+                                    const double *__restrict__ box,
+                                    LJParams params, double *__restrict__ F,
+                                    double *energy) {
+  __shared__ double tile[3 * kBlock];
+  __shared__ double partial[kBlock];
+  const LJDeviceCell cell = make_device_cell(box);
+  const size_t i = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+  const bool active = i < n_atoms;
+  double ri[3]{0.0, 0.0, 0.0};
+  if (active) {
+    ri[0] = pos[3 * i];
+    ri[1] = pos[3 * i + 1];
+    ri[2] = pos[3 * i + 2];
+  }
+  double fi[3]{0.0, 0.0, 0.0};
+  double e = 0.0;
+  for (size_t base = 0; base < n_atoms; base += kBlock) {
+    const size_t j = base + threadIdx.x;
+    if (j < n_atoms) {
+      for (unsigned d = 0; d < 3; ++d) {
+        tile[3 * threadIdx.x + d] = pos[3 * j + d];
+      }
+    }
+    __syncthreads();
+    const size_t count = n_atoms - base < kBlock ? n_atoms - base : kBlock;
+    if (active) {
+      for (size_t t = 0; t < count; ++t) {
+        if (base + t != i) {
+          e += lj_pair_image(ri, tile + 3 * t, params, cell, fi);
+        }
+      }
+    }
+    __syncthreads();
+  }
+  if (active) {
+    F[3 * i] = fi[0];
+    F[3 * i + 1] = fi[1];
+    F[3 * i + 2] = fi[2];
+  }
+  partial[threadIdx.x] = active ? 0.5 * e : 0.0;
+  __syncthreads();
+  for (unsigned s = blockDim.x / 2; s > 0; s >>= 1) {
+    if (threadIdx.x < s) {
+      partial[threadIdx.x] += partial[threadIdx.x + s];
+    }
+    __syncthreads();
+  }
+  if (threadIdx.x == 0) {
+    atomicAdd(energy, partial[0]);
+  }
+}
+
+} // namespace
+
+LJGpuPot::LJGpuPot(int device_id, LJParams params)
+    : m_device{device_id}, m_params{params}, m_energy{nullptr} {
+  check(RGPOT_GPU(SetDevice)(m_device), "SetDevice");
+  check(RGPOT_GPU(Malloc)(reinterpret_cast<void **>(&m_energy),
+                          sizeof(double)),
+        "Malloc");
+}
+
+LJGpuPot::~LJGpuPot() { device_free(m_energy); }
+
+/**
+ * @details
+ * Launches on the default stream of the device, so work queued there on
+ * the same positions is ordered before the kernel. The call returns once
+ * the energy has been copied to the host, which also completes the
+ * forces.
+ */
+void LJGpuPot::deviceForceImpl(const ForceInput &in, ForceOut *out) const {
+  check(RGPOT_GPU(SetDevice)(m_device), "SetDevice");
+  check(RGPOT_GPU(Memset)(m_energy, 0, sizeof(double)), "Memset");
+  if (in.nAtoms > 0) {
+    const auto blocks =
+        static_cast<unsigned>((in.nAtoms + kBlock - 1) / kBlock);
+    lj_all_pairs_kernel<<<blocks, kBlock>>>(in.nAtoms, in.pos, in.box,
+                                            m_params, out->F, m_energy);
+    check(RGPOT_GPU(GetLastError)(), "lj_all_pairs_kernel");
+  }
+  check(RGPOT_GPU(Memcpy)(&out->energy, m_energy, sizeof(double),
+                          RGPOT_GPU(MemcpyDeviceToHost)),
+        "Memcpy");
+  out->variance = 0.0;
+}
+
+double *LJGpuPot::device_alloc(size_t n_doubles) const {
+  check(RGPOT_GPU(SetDevice)(m_device), "SetDevice");
+  double *ptr = nullptr;
+  check(RGPOT_GPU(Malloc)(reinterpret_cast<void **>(&ptr),
+                          n_doubles * sizeof(double)),
+        "Malloc");
+  return ptr;
+}
+
+void LJGpuPot::device_free(void *ptr) {
+  if (ptr) {
+    (void)RGPOT_GPU(Free)(ptr);
+  }
+}
+
+int LJGpuPot::dlpack_device_type() {
+#if defined(__HIPCC__)
+  return 10; // kDLROCM
+#else
+  return 2; // kDLCUDA
+#endif
+}
+
+void gpu_copy_to_host(void *dst, const void *src, size_t bytes,
+                      int device_id) {
+  check(RGPOT_GPU(SetDevice)(device_id), "SetDevice");
+  check(RGPOT_GPU(Memcpy)(dst, src, bytes, RGPOT_GPU(MemcpyDeviceToHost)),
+        "Memcpy");
+}
+
+} // namespace rgpot
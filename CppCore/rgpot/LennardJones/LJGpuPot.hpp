@@ -0,0 +1,116 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Header file for the GPU Lennard-Jones potential.
+ *
+ * Defines @c LJGpuPot, the shifted 12-6 form of @c LJPot evaluated by a
+ * CUDA or HIP kernel on positions that already live in device memory. It
+ * is built with the meson @c with_cuda option or the CMake
+ * @c RGPOT_GPU_BACKEND setting; the header itself needs no GPU toolkit, so
+ * host code can hold the potential and call it.
+ */
+
+// clang-format off
+#include <cstddef>
+// clang-format on
+#include "rgpot/ForceStructs.hpp"
+#include "rgpot/LennardJones/LJDevice.hpp"
+
+namespace rgpot {
+
+/**
+ * @class LJGpuPot
+ * @brief Shifted 12-6 Lennard-Jones potential on one GPU.
+ * @ingroup rgpot_potentials
+ *
+ * Every thread sums the pairs of one atom with all the others, reading the
+ * positions through shared memory tiles, so the cost is quadratic in the
+ * number of atoms and no neighbor list is kept. Forces are written to
+ * device memory; only the energy, which the C ABI keeps on the host, is
+ * copied back.
+ *
+ * Unlike @c LJPot this is not a @c Potential: the cache, the statistics
+ * and the incremental moves of that base all read positions on the host.
+ * Use it through @c rgpot::PotentialHandle::from_device_impl.
+ */
+class LJGpuPot {
+public:
+  /**
+   * @brief Constructor for LJGpuPot.
+   * @param device_id Ordinal of the GPU the configurations live on.
+   * @param params Potential parameters, those of @c LJPot by default.
+   */
+  explicit LJGpuPot(int device_id = 0,
+                    LJParams params = shifted_lj_params(1.0, 1.0, 15.0));
+
+  ~LJGpuPot();
+  LJGpuPot(const LJGpuPot &) = delete;
+  LJGpuPot &operator=(const LJGpuPot &) = delete;
+
+  /**
+   * @brief Computes forces and energy of a device-resident configuration.
+   *
+   * The cutoff has to stay below half of the smallest perpendicular width
+   * of the cell, as for @c LJPot.
+   *
+   * @param in Configuration whose @c pos and @c box point to memory of
+   *           this device; @c atmnrs is not read.
+   * @param out Results; @c F points to @c 3 * in.nAtoms doubles of this
+   *            device, @c energy is set on the host.
+   * @return Void.
+   * @throws std::runtime_error when the GPU runtime reports an error.
+   */
+  void deviceForceImpl(const ForceInput &in, ForceOut *out) const;
+
+  /**
+   * @brief Allocates a force buffer on the device of this potential.
+   * @param n_doubles Number of doubles.
+   * @return Device pointer, released with @c device_free.
+   * @throws std::runtime_error when the allocation fails.
+   */
+  [[nodiscard]] double *device_alloc(size_t n_doubles) const;
+
+  /**
+   * @brief Releases a buffer of @c device_alloc.
+   * @param ptr Device pointer, may be null.
+   * @return Void.
+   */
+  static void device_free(void *ptr);
+
+  /**
+   * @brief Fetches the GPU ordinal.
+   * @return The device id of the DLPack device.
+   */
+  [[nodiscard]] int device_id() const { return m_device; }
+
+  /**
+   * @brief Fetches the DLPack device type of the backend.
+   * @return @c kDLCUDA (2) for CUDA builds, @c kDLROCM (10) for HIP.
+   */
+  [[nodiscard]] static int dlpack_device_type();
+
+private:
+  int m_device;      //!< GPU ordinal.
+  LJParams m_params; //!< Potential parameters.
+  double *m_energy;  //!< Device accumulator of the energy.
+};
+
+/**
+ * @brief Copies device memory to the host.
+ *
+ * Matches the copy function of @c rgpot::set_device_copy, which lets the
+ * RPC layer stage GPU tensors.
+ *
+ * @param dst Host destination.
+ * @param src Device source.
+ * @param bytes Number of bytes.
+ * @param device_id Ordinal of the source device.
+ * @return Void.
+ * @throws std::runtime_error when the copy fails.
+ */
+void gpu_copy_to_host(void *dst, const void *src, size_t bytes,
+                      int device_id);
+
+} // namespace rgpot
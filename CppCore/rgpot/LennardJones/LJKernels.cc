@@ -0,0 +1,718 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Implementation of the vectorized Lennard-Jones pair kernels.
+ *
+ * The AVX2 and AVX-512 variants are compiled with function-level target
+ * attributes, so the rest of the library keeps the baseline instruction set
+ * and the widest variant is picked at runtime.
+ */
+
+// clang-format off
+#include <cmath>
+// clang-format on
+#include "rgpot/LennardJones/LJKernels.hpp"
+
+#if (defined(__x86_64__) || defined(__i386__)) &&                              \
+    (defined(__GNUC__) || defined(__clang__))
+#define RGPOT_LJ_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+namespace rgpot {
+
+namespace {
+
+/**
+ * @brief Evaluates one pair with the inverse power form.
+ * @param data Positions and neighbor list.
+ * @param params Potential parameters.
+ * @param i First atom of the pair.
+ * @param j Second atom of the pair.
+ * @param fi Force accumulator of atom @a i, added to.
+ * @param F Force array, the contribution of atom @a j is added here.
+ * @return The pair energy, or zero beyond the cutoff.
+ */
+template <bool Orthogonal>
+inline double pair_scalar(const LJPairData &data, const LJParams &params,
+                          size_t i, size_t j, double *fi, double *F) {
+  double dx = data.x[i] - data.x[j];
+  double dy = data.y[i] - data.y[j];
+  double dz = data.z[i] - data.z[j];
+  data.cell->minimum_image<Orthogonal>(dx, dy, dz);
+  const double r2 = dx * dx + dy * dy + dz * dz;
+  if (!(r2 < params.cutoff * params.cutoff)) {
+    return 0.0;
+  }
+  const double inv_r2 = 1.0 / r2;
+  const double s2 = params.psi * params.psi * inv_r2;
+  const double s6 = s2 * s2 * s2;
+  const double fs = 24.0 * params.u0 * s6 * (2.0 * s6 - 1.0) * inv_r2;
+  fi[0] += fs * dx;
+  fi[1] += fs * dy;
+  fi[2] += fs * dz;
+  F[3 * j] -= fs * dx;
+  F[3 * j + 1] -= fs * dy;
+  F[3 * j + 2] -= fs * dz;
+  return 4.0 * params.u0 * s6 * (s6 - 1.0) - params.shift;
+}
+
+template <bool Orthogonal>
+double range_scalar(const LJPairData &data, const LJParams &params,
+                    size_t i_begin, size_t i_end, double *F) {
+  double energy = 0.0;
+  for (size_t i = i_begin; i < i_end; ++i) {
+    double fi[3]{0.0, 0.0, 0.0};
+    for (size_t k = data.offsets[i]; k < data.offsets[i + 1]; ++k) {
+      energy += pair_scalar<Orthogonal>(data, params, i, data.neighbors[k],
+                                        fi, F);
+    }
+    F[3 * i] += fi[0];
+    F[3 * i + 1] += fi[1];
+    F[3 * i + 2] += fi[2];
+  }
+  return energy;
+}
+
+/**
+ * @brief Parameters of the mixed precision kernels in single precision.
+ */
+struct MixedParams {
+  float len[3];     //!< Box lengths of an orthogonal cell.
+  float inv_len[3]; //!< Reciprocal box lengths.
+  float rc2;        //!< Squared cutoff.
+  float psi2;       //!< Squared zero crossing distance.
+  float c4;         //!< Energy prefactor, 4 u0.
+  float c24;        //!< Force prefactor, 24 u0.
+  double shift;     //!< Energy shift, subtracted in double.
+
+  MixedParams(const PeriodicCell &cell, const LJParams &params)
+      : rc2{static_cast<float>(params.cutoff * params.cutoff)},
+        psi2{static_cast<float>(params.psi * params.psi)},
+        c4{static_cast<float>(4.0 * params.u0)},
+        c24{static_cast<float>(24.0 * params.u0)}, shift{params.shift} {
+    const auto l = cell.lengths();
+    const auto il = cell.inverse_lengths();
+    for (size_t d = 0; d < 3; ++d) {
+      len[d] = static_cast<float>(l[d]);
+      inv_len[d] = static_cast<float>(il[d]);
+    }
+  }
+};
+
+/**
+ * @brief Evaluates one pair in single precision.
+ * @param data Single precision positions and neighbor list.
+ * @param mp Single precision parameters.
+ * @param i First atom of the pair.
+ * @param j Second atom of the pair.
+ * @param fi Force accumulator of atom @a i, added to.
+ * @param F Force array, the contribution of atom @a j is added here.
+ * @return The shifted pair energy, or zero beyond the cutoff.
+ */
+template <bool Orthogonal>
+inline double pair_mixed(const LJPairDataF &data, const MixedParams &mp,
+                         size_t i, size_t j, double *fi, double *F) {
+  float dx = data.x[i] - data.x[j];
+  float dy = data.y[i] - data.y[j];
+  float dz = data.z[i] - data.z[j];
+  if constexpr (Orthogonal) {
+    dx -= mp.len[0] * std::floor(dx * mp.inv_len[0] + 0.5f);
+    dy -= mp.len[1] * std::floor(dy * mp.inv_len[1] + 0.5f);
+    dz -= mp.len[2] * std::floor(dz * mp.inv_len[2] + 0.5f);
+  } else {
+    double d[3]{dx, dy, dz};
+    data.cell->minimum_image<false>(d[0], d[1], d[2]);
+    dx = static_cast<float>(d[0]);
+    dy = static_cast<float>(d[1]);
+    dz = static_cast<float>(d[2]);
+  }
+  const float r2 = dx * dx + dy * dy + dz * dz;
+  if (!(r2 < mp.rc2)) {
+    return 0.0;
+  }
+  const float inv_r2 = 1.0f / r2;
+  const float s2 = mp.psi2 * inv_r2;
+  const float s6 = s2 * s2 * s2;
+  const float fs = mp.c24 * s6 * (2.0f * s6 - 1.0f) * inv_r2;
+  const double fx = fs * dx;
+  const double fy = fs * dy;
+  const double fz = fs * dz;
+  fi[0] += fx;
+  fi[1] += fy;
+  fi[2] += fz;
+  F[3 * j] -= fx;
+  F[3 * j + 1] -= fy;
+  F[3 * j + 2] -= fz;
+  return static_cast<double>(mp.c4 * s6 * (s6 - 1.0f)) - mp.shift;
+}
+
+template <bool Orthogonal>
+double range_mixed_scalar(const LJPairDataF &data, const MixedParams &mp,
+                          size_t i_begin, size_t i_end, double *F) {
+  double energy = 0.0;
+  for (size_t i = i_begin; i < i_end; ++i) {
+    double fi[3]{0.0, 0.0, 0.0};
+    for (size_t k = data.offsets[i]; k < data.offsets[i + 1]; ++k) {
+      energy +=
+          pair_mixed<Orthogonal>(data, mp, i, data.neighbors[k], fi, F);
+    }
+    F[3 * i] += fi[0];
+    F[3 * i + 1] += fi[1];
+    F[3 * i + 2] += fi[2];
+  }
+  return energy;
+}
+
+#ifdef RGPOT_LJ_X86_DISPATCH
+
+__attribute__((target("avx2,fma"))) inline double hsum_avx2(__m256d v) {
+  const __m128d lo = _mm256_castpd256_pd128(v);
+  const __m128d hi = _mm256_extractf128_pd(v, 1);
+  const __m128d s = _mm_add_pd(lo, hi);
+  return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+/**
+ * @details
+ * Four neighbors are gathered per step. AVX2 has no scatter, so the
+ * partner forces are stored to a small buffer and applied one by one; the
+ * remaining row tail goes through the scalar pair function.
+ */
+__attribute__((target("avx2,fma"))) double
+range_avx2(const LJPairData &data, const LJParams &params, size_t i_begin,
+           size_t i_end, double *F) {
+  const auto len = data.cell->lengths();
+  const auto inv_len = data.cell->inverse_lengths();
+  const __m256d len_x = _mm256_set1_pd(len[0]);
+  const __m256d len_y = _mm256_set1_pd(len[1]);
+  const __m256d len_z = _mm256_set1_pd(len[2]);
+  const __m256d inv_x = _mm256_set1_pd(inv_len[0]);
+  const __m256d inv_y = _mm256_set1_pd(inv_len[1]);
+  const __m256d inv_z = _mm256_set1_pd(inv_len[2]);
+  const __m256d half = _mm256_set1_pd(0.5);
+  const __m256d one = _mm256_set1_pd(1.0);
+  const __m256d two = _mm256_set1_pd(2.0);
+  const __m256d rc2 = _mm256_set1_pd(params.cutoff * params.cutoff);
+  const __m256d psi2 = _mm256_set1_pd(params.psi * params.psi);
+  const __m256d c4 = _mm256_set1_pd(4.0 * params.u0);
+  const __m256d c24 = _mm256_set1_pd(24.0 * params.u0);
+  const __m256d shift = _mm256_set1_pd(params.shift);
+
+  __m256d energy_v = _mm256_setzero_pd();
+  double energy = 0.0;
+  alignas(32) double tx[4], ty[4], tz[4];
+
+  for (size_t i = i_begin; i < i_end; ++i) {
+    const __m256d xi = _mm256_set1_pd(data.x[i]);
+    const __m256d yi = _mm256_set1_pd(data.y[i]);
+    const __m256d zi = _mm256_set1_pd(data.z[i]);
+    __m256d fxi = _mm256_setzero_pd();
+    __m256d fyi = _mm256_setzero_pd();
+    __m256d fzi = _mm256_setzero_pd();
+
+    size_t k = data.offsets[i];
+    const size_t end = data.offsets[i + 1];
+    for (; k + 4 <= end; k += 4) {
+      const __m256i idx = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(data.neighbors + k));
+      __m256d dx = _mm256_sub_pd(xi, _mm256_i64gather_pd(data.x, idx, 8));
+      __m256d dy = _mm256_sub_pd(yi, _mm256_i64gather_pd(data.y, idx, 8));
+      __m256d dz = _mm256_sub_pd(zi, _mm256_i64gather_pd(data.z, idx, 8));
+      dx = _mm256_fnmadd_pd(
+          len_x, _mm256_floor_pd(_mm256_fmadd_pd(dx, inv_x, half)), dx);
+      dy = _mm256_fnmadd_pd(
+          len_y, _mm256_floor_pd(_mm256_fmadd_pd(dy, inv_y, half)), dy);
+      dz = _mm256_fnmadd_pd(
+          len_z, _mm256_floor_pd(_mm256_fmadd_pd(dz, inv_z, half)), dz);
+      const __m256d r2 = _mm256_fmadd_pd(
+          dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+      const __m256d mask = _mm256_cmp_pd(r2, rc2, _CMP_LT_OQ);
+
+      const __m256d inv_r2 = _mm256_div_pd(one, r2);
+      const __m256d s2 = _mm256_mul_pd(psi2, inv_r2);
+      const __m256d s6 = _mm256_mul_pd(_mm256_mul_pd(s2, s2), s2);
+      const __m256d e = _mm256_fmsub_pd(
+          _mm256_mul_pd(c4, s6), _mm256_sub_pd(s6, one), shift);
+      energy_v = _mm256_add_pd(energy_v, _mm256_and_pd(mask, e));
+      const __m256d fs = _mm256_and_pd(
+          mask, _mm256_mul_pd(_mm256_mul_pd(c24, s6),
+                              _mm256_mul_pd(_mm256_fmsub_pd(two, s6, one),
+                                            inv_r2)));
+
+      const __m256d fx = _mm256_mul_pd(fs, dx);
+      const __m256d fy = _mm256_mul_pd(fs, dy);
+      const __m256d fz = _mm256_mul_pd(fs, dz);
+      fxi = _mm256_add_pd(fxi, fx);
+      fyi = _mm256_add_pd(fyi, fy);
+      fzi = _mm256_add_pd(fzi, fz);
+      _mm256_store_pd(tx, fx);
+      _mm256_store_pd(ty, fy);
+      _mm256_store_pd(tz, fz);
+      for (size_t l = 0; l < 4; ++l) {
+        const size_t j = data.neighbors[k + l];
+        F[3 * j] -= tx[l];
+        F[3 * j + 1] -= ty[l];
+        F[3 * j + 2] -= tz[l];
+      }
+    }
+
+    double fi[3]{hsum_avx2(fxi), hsum_avx2(fyi), hsum_avx2(fzi)};
+    for (; k < end; ++k) {
+      energy += pair_scalar<true>(data, params, i, data.neighbors[k], fi, F);
+    }
+    F[3 * i] += fi[0];
+    F[3 * i + 1] += fi[1];
+    F[3 * i + 2] += fi[2];
+  }
+  return energy + hsum_avx2(energy_v);
+}
+
+/**
+ * @details
+ * Eight neighbors are processed per step. The row tail is handled with a
+ * lane mask on the index load and the gathers, and the partner forces are
+ * updated with gather-scatter pairs. Neighbors within one row are distinct,
+ * so the scatter never has conflicting lanes.
+ */
+/**
+ * @brief Sums the lanes of a vector.
+ *
+ * The halves are split with masked extracts: the plain ones, and
+ * @c _mm512_reduce_add_pd built on them, start from an undefined vector
+ * that GCC 12 reports as used uninitialized.
+ *
+ * @param v Vector to sum.
+ * @return The sum of its eight lanes.
+ */
+__attribute__((target("avx512f"))) inline double hsum_avx512(__m512d v) {
+  const __m256d lo = _mm512_maskz_extractf64x4_pd(0xF, v, 0);
+  const __m256d hi = _mm512_maskz_extractf64x4_pd(0xF, v, 1);
+  return hsum_avx2(_mm256_add_pd(lo, hi));
+}
+
+__attribute__((target("avx512f"))) double
+range_avx512(const LJPairData &data, const LJParams &params, size_t i_begin,
+             size_t i_end, double *F) {
+  const auto len = data.cell->lengths();
+  const auto inv_len = data.cell->inverse_lengths();
+  const __m512d len_x = _mm512_set1_pd(len[0]);
+  const __m512d len_y = _mm512_set1_pd(len[1]);
+  const __m512d len_z = _mm512_set1_pd(len[2]);
+  const __m512d inv_x = _mm512_set1_pd(inv_len[0]);
+  const __m512d inv_y = _mm512_set1_pd(inv_len[1]);
+  const __m512d inv_z = _mm512_set1_pd(inv_len[2]);
+  const __m512d half = _mm512_set1_pd(0.5);
+  const __m512d one = _mm512_set1_pd(1.0);
+  const __m512d two = _mm512_set1_pd(2.0);
+  const __m512d rc2 = _mm512_set1_pd(params.cutoff * params.cutoff);
+  const __m512d psi2 = _mm512_set1_pd(params.psi * params.psi);
+  const __m512d c4 = _mm512_set1_pd(4.0 * params.u0);
+  const __m512d c24 = _mm512_set1_pd(24.0 * params.u0);
+  const __m512d shift = _mm512_set1_pd(params.shift);
+  const __m512d zero = _mm512_setzero_pd();
+
+  __m512d energy_v = zero;
+
+  for (size_t i = i_begin; i < i_end; ++i) {
+    const __m512d xi = _mm512_set1_pd(data.x[i]);
+    const __m512d yi = _mm512_set1_pd(data.y[i]);
+    const __m512d zi = _mm512_set1_pd(data.z[i]);
+    __m512d fxi = zero;
+    __m512d fyi = zero;
+    __m512d fzi = zero;
+
+    const size_t end = data.offsets[i + 1];
+    for (size_t k = data.offsets[i]; k < end; k += 8) {
+      const size_t left = end - k;
+      const __mmask8 lanes =
+          left >= 8 ? static_cast<__mmask8>(0xFF)
+                    : static_cast<__mmask8>((1u << left) - 1u);
+      const __m512i idx = _mm512_maskz_loadu_epi64(lanes, data.neighbors + k);
+      __m512d dx = _mm512_sub_pd(
+          xi, _mm512_mask_i64gather_pd(xi, lanes, idx, data.x, 8));
+      __m512d dy = _mm512_sub_pd(
+          yi, _mm512_mask_i64gather_pd(yi, lanes, idx, data.y, 8));
+      __m512d dz = _mm512_sub_pd(
+          zi, _mm512_mask_i64gather_pd(zi, lanes, idx, data.z, 8));
+      dx = _mm512_fnmadd_pd(
+          len_x, _mm512_floor_pd(_mm512_fmadd_pd(dx, inv_x, half)), dx);
+      dy = _mm512_fnmadd_pd(
+          len_y, _mm512_floor_pd(_mm512_fmadd_pd(dy, inv_y, half)), dy);
+      dz = _mm512_fnmadd_pd(
+          len_z, _mm512_floor_pd(_mm512_fmadd_pd(dz, inv_z, half)), dz);
+      const __m512d r2 = _mm512_fmadd_pd(
+          dx, dx, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dz, dz)));
+      const __mmask8 mask =
+          _mm512_mask_cmp_pd_mask(lanes, r2, rc2, _CMP_LT_OQ);
+
+      const __m512d inv_r2 = _mm512_maskz_div_pd(mask, one, r2);
+      const __m512d s2 = _mm512_mul_pd(psi2, inv_r2);
+      const __m512d s6 = _mm512_mul_pd(_mm512_mul_pd(s2, s2), s2);
+      const __m512d e = _mm512_fmsub_pd(_mm512_mul_pd(c4, s6),
+                                        _mm512_sub_pd(s6, one), shift);
+      energy_v = _mm512_mask_add_pd(energy_v, mask, energy_v, e);
+      const __m512d fs = _mm512_maskz_mul_pd(
+          mask, _mm512_mul_pd(c24, s6),
+          _mm512_mul_pd(_mm512_fmsub_pd(two, s6, one), inv_r2));
+
+      const __m512d fx = _mm512_mul_pd(fs, dx);
+      const __m512d fy = _mm512_mul_pd(fs, dy);
+      const __m512d fz = _mm512_mul_pd(fs, dz);
+      fxi = _mm512_add_pd(fxi, fx);
+      fyi = _mm512_add_pd(fyi, fy);
+      fzi = _mm512_add_pd(fzi, fz);
+
+      const __m512i j3 = _mm512_add_epi64(idx, _mm512_add_epi64(idx, idx));
+      const __m512i j3y = _mm512_add_epi64(j3, _mm512_set1_epi64(1));
+      const __m512i j3z = _mm512_add_epi64(j3, _mm512_set1_epi64(2));
+      __m512d fjx = _mm512_mask_i64gather_pd(zero, mask, j3, F, 8);
+      __m512d fjy = _mm512_mask_i64gather_pd(zero, mask, j3y, F, 8);
+      __m512d fjz = _mm512_mask_i64gather_pd(zero, mask, j3z, F, 8);
+      _mm512_mask_i64scatter_pd(F, mask, j3, _mm512_sub_pd(fjx, fx), 8);
+      _mm512_mask_i64scatter_pd(F, mask, j3y, _mm512_sub_pd(fjy, fy), 8);
+      _mm512_mask_i64scatter_pd(F, mask, j3z, _mm512_sub_pd(fjz, fz), 8);
+    }
+
+    F[3 * i] += hsum_avx512(fxi);
+    F[3 * i + 1] += hsum_avx512(fyi);
+    F[3 * i + 2] += hsum_avx512(fzi);
+  }
+  return hsum_avx512(energy_v);
+}
+
+__attribute__((target("avx2,fma"))) inline __m256d
+add_widened_avx2(__m256d acc, __m256 v) {
+  acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+  return _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+}
+
+__attribute__((target("avx2,fma"))) inline __m256
+gather_avx2(const float *base, __m256i idx_lo, __m256i idx_hi) {
+  return _mm256_set_m128(_mm256_i64gather_ps(base, idx_hi, 4),
+                         _mm256_i64gather_ps(base, idx_lo, 4));
+}
+
+/**
+ * @details
+ * Eight neighbors are gathered per step, two four-lane gathers each since
+ * the indices are 64-bit. Only the energy shift and the sums leave single
+ * precision: the interacting lanes are counted for the shift, and pair
+ * energies and forces are widened before they are added up.
+ */
+__attribute__((target("avx2,fma"))) double
+range_mixed_avx2(const LJPairDataF &data, const MixedParams &mp,
+                 size_t i_begin, size_t i_end, double *F) {
+  const __m256 len_x = _mm256_set1_ps(mp.len[0]);
+  const __m256 len_y = _mm256_set1_ps(mp.len[1]);
+  const __m256 len_z = _mm256_set1_ps(mp.len[2]);
+  const __m256 inv_x = _mm256_set1_ps(mp.inv_len[0]);
+  const __m256 inv_y = _mm256_set1_ps(mp.inv_len[1]);
+  const __m256 inv_z = _mm256_set1_ps(mp.inv_len[2]);
+  const __m256 half = _mm256_set1_ps(0.5f);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 two = _mm256_set1_ps(2.0f);
+  const __m256 rc2 = _mm256_set1_ps(mp.rc2);
+  const __m256 psi2 = _mm256_set1_ps(mp.psi2);
+  const __m256 c4 = _mm256_set1_ps(mp.c4);
+  const __m256 c24 = _mm256_set1_ps(mp.c24);
+
+  __m256d energy_v = _mm256_setzero_pd();
+  double energy = 0.0;
+  size_t n_pairs = 0;
+  alignas(32) float tx[8], ty[8], tz[8];
+
+  for (size_t i = i_begin; i < i_end; ++i) {
+    const __m256 xi = _mm256_set1_ps(data.x[i]);
+    const __m256 yi = _mm256_set1_ps(data.y[i]);
+    const __m256 zi = _mm256_set1_ps(data.z[i]);
+    __m256d fxi = _mm256_setzero_pd();
+    __m256d fyi = _mm256_setzero_pd();
+    __m256d fzi = _mm256_setzero_pd();
+
+    size_t k = data.offsets[i];
+    const size_t end = data.offsets[i + 1];
+    for (; k + 8 <= end; k += 8) {
+      const __m256i idx_lo = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(data.neighbors + k));
+      const __m256i idx_hi = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(data.neighbors + k + 4));
+      __m256 dx = _mm256_sub_ps(xi, gather_avx2(data.x, idx_lo, idx_hi));
+      __m256 dy = _mm256_sub_ps(yi, gather_avx2(data.y, idx_lo, idx_hi));
+      __m256 dz = _mm256_sub_ps(zi, gather_avx2(data.z, idx_lo, idx_hi));
+      dx = _mm256_fnmadd_ps(
+          len_x, _mm256_floor_ps(_mm256_fmadd_ps(dx, inv_x, half)), dx);
+      dy = _mm256_fnmadd_ps(
+          len_y, _mm256_floor_ps(_mm256_fmadd_ps(dy, inv_y, half)), dy);
+      dz = _mm256_fnmadd_ps(
+          len_z, _mm256_floor_ps(_mm256_fmadd_ps(dz, inv_z, half)), dz);
+      const __m256 r2 = _mm256_fmadd_ps(
+          dx, dx, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dz, dz)));
+      const __m256 mask = _mm256_cmp_ps(r2, rc2, _CMP_LT_OQ);
+      n_pairs += __builtin_popcount(_mm256_movemask_ps(mask));
+
+      const __m256 inv_r2 = _mm256_div_ps(one, r2);
+      const __m256 s2 = _mm256_mul_ps(psi2, inv_r2);
+      const __m256 s6 = _mm256_mul_ps(_mm256_mul_ps(s2, s2), s2);
+      const __m256 e = _mm256_mul_ps(_mm256_mul_ps(c4, s6),
+                                     _mm256_sub_ps(s6, one));
+      energy_v = add_widened_avx2(energy_v, _mm256_and_ps(mask, e));
+      const __m256 fs = _mm256_and_ps(
+          mask, _mm256_mul_ps(_mm256_mul_ps(c24, s6),
+                              _mm256_mul_ps(_mm256_fmsub_ps(two, s6, one),
+                                            inv_r2)));
+
+      const __m256 fx = _mm256_mul_ps(fs, dx);
+      const __m256 fy = _mm256_mul_ps(fs, dy);
+      const __m256 fz = _mm256_mul_ps(fs, dz);
+      fxi = add_widened_avx2(fxi, fx);
+      fyi = add_widened_avx2(fyi, fy);
+      fzi = add_widened_avx2(fzi, fz);
+      _mm256_store_ps(tx, fx);
+      _mm256_store_ps(ty, fy);
+      _mm256_store_ps(tz, fz);
+      for (size_t l = 0; l < 8; ++l) {
+        const size_t j = data.neighbors[k + l];
+        F[3 * j] -= tx[l];
+        F[3 * j + 1] -= ty[l];
+        F[3 * j + 2] -= tz[l];
+      }
+    }
+
+    double fi[3]{hsum_avx2(fxi), hsum_avx2(fyi), hsum_avx2(fzi)};
+    for (; k < end; ++k) {
+      energy += pair_mixed<true>(data, mp, i, data.neighbors[k], fi, F);
+    }
+    F[3 * i] += fi[0];
+    F[3 * i + 1] += fi[1];
+    F[3 * i + 2] += fi[2];
+  }
+  return energy + hsum_avx2(energy_v) - static_cast<double>(n_pairs) * mp.shift;
+}
+
+// The helpers below use masked forms throughout: the plain extracts,
+// inserts and conversions start from an undefined vector, which GCC 12
+// reports as used uninitialized
+
+template <int Half>
+__attribute__((target("avx512f"))) inline __m256 half_avx512(__m512 v) {
+  return _mm256_castpd_ps(
+      _mm512_maskz_extractf64x4_pd(0xF, _mm512_castps_pd(v), Half));
+}
+
+__attribute__((target("avx512f"))) inline __m512d
+widen_lo_avx512(__m512 v) {
+  return _mm512_maskz_cvtps_pd(0xFF, half_avx512<0>(v));
+}
+
+__attribute__((target("avx512f"))) inline __m512d
+widen_hi_avx512(__m512 v) {
+  return _mm512_maskz_cvtps_pd(0xFF, half_avx512<1>(v));
+}
+
+__attribute__((target("avx512f"))) inline __m512d
+add_widened_avx512(__m512d acc, __m512 v) {
+  return _mm512_add_pd(_mm512_add_pd(acc, widen_lo_avx512(v)),
+                       widen_hi_avx512(v));
+}
+
+__attribute__((target("avx512f"))) inline __m512
+gather_avx512(__m512 src, __mmask8 lo_lanes, __mmask8 hi_lanes,
+              __m512i idx_lo, __m512i idx_hi, const float *base) {
+  const __m256 s = half_avx512<0>(src);
+  const __m256 lo = _mm512_mask_i64gather_ps(s, lo_lanes, idx_lo, base, 4);
+  const __m256 hi = _mm512_mask_i64gather_ps(s, hi_lanes, idx_hi, base, 4);
+  return _mm512_castpd_ps(_mm512_maskz_insertf64x4(
+      0xFF, _mm512_castps_pd(_mm512_castps256_ps512(lo)),
+      _mm256_castps_pd(hi), 1));
+}
+
+__attribute__((target("avx512f"))) inline void
+scatter_sub_avx512(double *F, __mmask8 mask, __m512i idx, __m512d fx,
+                   __m512d fy, __m512d fz) {
+  const __m512d zero = _mm512_setzero_pd();
+  const __m512i j3 = _mm512_add_epi64(idx, _mm512_add_epi64(idx, idx));
+  const __m512i j3y = _mm512_add_epi64(j3, _mm512_set1_epi64(1));
+  const __m512i j3z = _mm512_add_epi64(j3, _mm512_set1_epi64(2));
+  __m512d fjx = _mm512_mask_i64gather_pd(zero, mask, j3, F, 8);
+  __m512d fjy = _mm512_mask_i64gather_pd(zero, mask, j3y, F, 8);
+  __m512d fjz = _mm512_mask_i64gather_pd(zero, mask, j3z, F, 8);
+  _mm512_mask_i64scatter_pd(F, mask, j3, _mm512_sub_pd(fjx, fx), 8);
+  _mm512_mask_i64scatter_pd(F, mask, j3y, _mm512_sub_pd(fjy, fy), 8);
+  _mm512_mask_i64scatter_pd(F, mask, j3z, _mm512_sub_pd(fjz, fz), 8);
+}
+
+/**
+ * @details
+ * Sixteen neighbors are processed per step as two halves of eight 64-bit
+ * indices, whose gathers are joined into one single precision vector. The
+ * partner forces are widened and scattered one half at a time.
+ */
+__attribute__((target("avx512f"))) double
+range_mixed_avx512(const LJPairDataF &data, const MixedParams &mp,
+                   size_t i_begin, size_t i_end, double *F) {
+  const __m512 len_x = _mm512_set1_ps(mp.len[0]);
+  const __m512 len_y = _mm512_set1_ps(mp.len[1]);
+  const __m512 len_z = _mm512_set1_ps(mp.len[2]);
+  const __m512 inv_x = _mm512_set1_ps(mp.inv_len[0]);
+  const __m512 inv_y = _mm512_set1_ps(mp.inv_len[1]);
+  const __m512 inv_z = _mm512_set1_ps(mp.inv_len[2]);
+  const __m512 half = _mm512_set1_ps(0.5f);
+  const __m512 one = _mm512_set1_ps(1.0f);
+  const __m512 two = _mm512_set1_ps(2.0f);
+  const __m512 rc2 = _mm512_set1_ps(mp.rc2);
+  const __m512 psi2 = _mm512_set1_ps(mp.psi2);
+  const __m512 c4 = _mm512_set1_ps(mp.c4);
+  const __m512 c24 = _mm512_set1_ps(mp.c24);
+  const __m512d zero = _mm512_setzero_pd();
+
+  __m512d energy_v = zero;
+  size_t n_pairs = 0;
+
+  for (size_t i = i_begin; i < i_end; ++i) {
+    const __m512 xi = _mm512_set1_ps(data.x[i]);
+    const __m512 yi = _mm512_set1_ps(data.y[i]);
+    const __m512 zi = _mm512_set1_ps(data.z[i]);
+    __m512d fxi = zero;
+    __m512d fyi = zero;
+    __m512d fzi = zero;
+
+    const size_t end = data.offsets[i + 1];
+    for (size_t k = data.offsets[i]; k < end; k += 16) {
+      const size_t left = end - k;
+      const __mmask16 lanes =
+          left >= 16 ? static_cast<__mmask16>(0xFFFF)
+                     : static_cast<__mmask16>((1u << left) - 1u);
+      const auto lo_lanes = static_cast<__mmask8>(lanes & 0xFF);
+      const auto hi_lanes = static_cast<__mmask8>(lanes >> 8);
+      const __m512i idx_lo =
+          _mm512_maskz_loadu_epi64(lo_lanes, data.neighbors + k);
+      const __m512i idx_hi =
+          _mm512_maskz_loadu_epi64(hi_lanes, data.neighbors + k + 8);
+      __m512 dx = _mm512_sub_ps(
+          xi, gather_avx512(xi, lo_lanes, hi_lanes, idx_lo, idx_hi, data.x));
+      __m512 dy = _mm512_sub_ps(
+          yi, gather_avx512(yi, lo_lanes, hi_lanes, idx_lo, idx_hi, data.y));
+      __m512 dz = _mm512_sub_ps(
+          zi, gather_avx512(zi, lo_lanes, hi_lanes, idx_lo, idx_hi, data.z));
+      dx = _mm512_fnmadd_ps(
+          len_x, _mm512_floor_ps(_mm512_fmadd_ps(dx, inv_x, half)), dx);
+      dy = _mm512_fnmadd_ps(
+          len_y, _mm512_floor_ps(_mm512_fmadd_ps(dy, inv_y, half)), dy);
+      dz = _mm512_fnmadd_ps(
+          len_z, _mm512_floor_ps(_mm512_fmadd_ps(dz, inv_z, half)), dz);
+      const __m512 r2 = _mm512_fmadd_ps(
+          dx, dx, _mm512_fmadd_ps(dy, dy, _mm512_mul_ps(dz, dz)));
+      const __mmask16 mask =
+          _mm512_mask_cmp_ps_mask(lanes, r2, rc2, _CMP_LT_OQ);
+      n_pairs += __builtin_popcount(mask);
+
+      const __m512 inv_r2 = _mm512_maskz_div_ps(mask, one, r2);
+      const __m512 s2 = _mm512_mul_ps(psi2, inv_r2);
+      const __m512 s6 = _mm512_mul_ps(_mm512_mul_ps(s2, s2), s2);
+      const __m512 e = _mm512_maskz_mul_ps(mask, _mm512_mul_ps(c4, s6),
+                                           _mm512_sub_ps(s6, one));
+      energy_v = add_widened_avx512(energy_v, e);
+      const __m512 fs = _mm512_maskz_mul_ps(
+          mask, _mm512_mul_ps(c24, s6),
+          _mm512_mul_ps(_mm512_fmsub_ps(two, s6, one), inv_r2));
+
+      const __m512 fx = _mm512_mul_ps(fs, dx);
+      const __m512 fy = _mm512_mul_ps(fs, dy);
+      const __m512 fz = _mm512_mul_ps(fs, dz);
+      fxi = add_widened_avx512(fxi, fx);
+      fyi = add_widened_avx512(fyi, fy);
+      fzi = add_widened_avx512(fzi, fz);
+      scatter_sub_avx512(F, static_cast<__mmask8>(mask & 0xFF), idx_lo,
+                         widen_lo_avx512(fx), widen_lo_avx512(fy),
+                         widen_lo_avx512(fz));
+      scatter_sub_avx512(F, static_cast<__mmask8>(mask >> 8), idx_hi,
+                         widen_hi_avx512(fx), widen_hi_avx512(fy),
+                         widen_hi_avx512(fz));
+    }
+
+    F[3 * i] += hsum_avx512(fxi);
+    F[3 * i + 1] += hsum_avx512(fyi);
+    F[3 * i + 2] += hsum_avx512(fzi);
+  }
+  return hsum_avx512(energy_v) - static_cast<double>(n_pairs) * mp.shift;
+}
+
+#endif // RGPOT_LJ_X86_DISPATCH
+
+} // namespace
+
+SimdLevel detect_simd_level() {
+  if (simd_level_supported(SimdLevel::AVX512)) {
+    return SimdLevel::AVX512;
+  }
+  if (simd_level_supported(SimdLevel::AVX2)) {
+    return SimdLevel::AVX2;
+  }
+  return SimdLevel::Scalar;
+}
+
+bool simd_level_supported(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::Scalar:
+    return true;
+#ifdef RGPOT_LJ_X86_DISPATCH
+  case SimdLevel::AVX2:
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  case SimdLevel::AVX512:
+    return __builtin_cpu_supports("avx512f");
+#endif
+  default:
+    return false;
+  }
+}
+
+/**
+ * @details
+ * Dispatches on @a level without re-checking CPU support, callers are
+ * expected to validate the level once with @c simd_level_supported.
+ */
+double lj_pair_range(SimdLevel level, const LJPairData &data,
+                     const LJParams &params, size_t i_begin, size_t i_end,
+                     double *F) {
+  if (!data.cell->orthogonal()) {
+    return range_scalar<false>(data, params, i_begin, i_end, F);
+  }
+  switch (level) {
+#ifdef RGPOT_LJ_X86_DISPATCH
+  case SimdLevel::AVX512:
+    return range_avx512(data, params, i_begin, i_end, F);
+  case SimdLevel::AVX2:
+    return range_avx2(data, params, i_begin, i_end, F);
+#endif
+  default:
+    return range_scalar<true>(data, params, i_begin, i_end, F);
+  }
+}
+
+/**
+ * @details
+ * The single precision constants are rounded once per call, before the
+ * same dispatch as @c lj_pair_range.
+ */
+double lj_pair_range_mixed(SimdLevel level, const LJPairDataF &data,
+                           const LJParams &params, size_t i_begin,
+                           size_t i_end, double *F) {
+  const MixedParams mp(*data.cell, params);
+  if (!data.cell->orthogonal()) {
+    return range_mixed_scalar<false>(data, mp, i_begin, i_end, F);
+  }
+  switch (level) {
+#ifdef RGPOT_LJ_X86_DISPATCH
+  case SimdLevel::AVX512:
+    return range_mixed_avx512(data, mp, i_begin, i_end, F);
+  case SimdLevel::AVX2:
+    return range_mixed_avx2(data, mp, i_begin, i_end, F);
+#endif
+  default:
+    return range_mixed_scalar<true>(data, mp, i_begin, i_end, F);
+  }
+}
+
+} // namespace rgpot
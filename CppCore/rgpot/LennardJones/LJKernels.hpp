@@ -0,0 +1,145 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Vectorized Lennard-Jones pair kernels with runtime dispatch.
+ *
+ * Declares the SIMD levels known to rgpot and a pair kernel that walks
+ * neighbor list rows over a structure-of-arrays copy of the positions. The
+ * kernel works on squared distances and inverse powers only, so the inner
+ * loop has no @c pow, @c sqrt or per-component division.
+ */
+
+// clang-format off
+#include <cstddef>
+// clang-format on
+#include "rgpot/PeriodicCell.hpp"
+
+namespace rgpot {
+
+/**
+ * @brief Instruction set used by the vectorized pair kernels.
+ */
+enum class SimdLevel {
+  Scalar, //!< Portable code, no vector intrinsics.
+  AVX2,   //!< 256-bit vectors with FMA.
+  AVX512  //!< 512-bit vectors with masked gathers and scatters.
+};
+
+/**
+ * @brief Queries the widest SIMD level supported by the running CPU.
+ * @return The best available level, @c SimdLevel::Scalar on other targets.
+ */
+SimdLevel detect_simd_level();
+
+/**
+ * @brief Checks whether the running CPU can execute a SIMD level.
+ * @param level The level to test.
+ * @return True if kernels of that level can run.
+ */
+bool simd_level_supported(SimdLevel level);
+
+/**
+ * @brief Floating point format of the pair kernels.
+ *
+ * The mixed mode halves the bandwidth of the position gathers and doubles
+ * the number of pairs per vector. Energies and forces are still summed in
+ * double, so its error is set by the single precision pair terms and does
+ * not grow with the number of pairs; see @c lj_pair_range_mixed.
+ */
+enum class Precision {
+  Double, //!< Positions and pair terms in double precision.
+  Mixed   //!< Pair terms in single precision, sums in double precision.
+};
+
+/**
+ * @brief Read-only inputs shared by every call of the pair kernel.
+ */
+struct LJPairData {
+  const double *x;         //!< X coordinates of all atoms.
+  const double *y;         //!< Y coordinates of all atoms.
+  const double *z;         //!< Z coordinates of all atoms.
+  const size_t *offsets;   //!< Neighbor list row offsets.
+  const size_t *neighbors; //!< Flattened neighbor indices.
+  const PeriodicCell *cell; //!< Simulation cell.
+};
+
+/**
+ * @brief Single precision inputs of the mixed precision pair kernel.
+ *
+ * The positions are expected inside the cell at the origin, see
+ * @c PeriodicCell::wrap, which bounds their rounding error by the size of
+ * the cell rather than by how far atoms have drifted from it.
+ */
+struct LJPairDataF {
+  const float *x;           //!< X coordinates of all atoms.
+  const float *y;           //!< Y coordinates of all atoms.
+  const float *z;           //!< Z coordinates of all atoms.
+  const size_t *offsets;    //!< Neighbor list row offsets.
+  const size_t *neighbors;  //!< Flattened neighbor indices.
+  const PeriodicCell *cell; //!< Simulation cell.
+};
+
+/**
+ * @brief Parameters of the shifted 12-6 Lennard-Jones form.
+ */
+struct LJParams {
+  double u0;     //!< Well depth.
+  double psi;    //!< Distance at which the unshifted potential is zero.
+  double cutoff; //!< Interaction cutoff radius.
+  double shift;  //!< Energy subtracted from every interacting pair.
+};
+
+/**
+ * @brief Accumulates Lennard-Jones pair terms for a range of atoms.
+ *
+ * Visits the neighbor rows of atoms in [@a i_begin, @a i_end) and adds the
+ * pair forces to both atoms of each pair in the interleaved array @a F.
+ * Skewed cells always run the scalar kernel, the vector kernels only
+ * implement the orthogonal minimum image.
+ *
+ * @param level The SIMD level to run, must be supported.
+ * @param data Positions and neighbor list.
+ * @param params Potential parameters.
+ * @param i_begin First atom whose neighbor row is visited.
+ * @param i_end One past the last atom whose neighbor row is visited.
+ * @param F Force array of size 3 * N, added to.
+ * @return The energy of the visited pairs.
+ */
+double lj_pair_range(SimdLevel level, const LJPairData &data,
+                     const LJParams &params, size_t i_begin, size_t i_end,
+                     double *F);
+
+/**
+ * @brief Accumulates single precision pair terms for a range of atoms.
+ *
+ * Same contract as @c lj_pair_range, but separations, the minimum image
+ * and the pair terms are evaluated in @c float, eight pairs per AVX2 step
+ * and sixteen per AVX-512 step. Every pair energy and force is widened to
+ * double before it is summed, and the energy shift is subtracted in
+ * double.
+ *
+ * With u = 2^-24 and wrapped positions no further than L from the origin,
+ * each separation component is off by at most about 3 u L, from
+ * rounding both positions and the image shift. A pair term scaling as
+ * r^-13 then carries a relative error of at most about (70 L / r + 10) u,
+ * the constant term covering the float arithmetic. The error of the total
+ * energy and forces is bounded by the sum of the absolute pair terms times
+ * this factor, taken at the closest pair distance; for L = 50 and r = 1 it
+ * is about 2e-4. Skewed cells run the scalar kernel, whose minimum image
+ * is taken in double from the single precision separation.
+ *
+ * @param level The SIMD level to run, must be supported.
+ * @param data Single precision positions and neighbor list.
+ * @param params Potential parameters.
+ * @param i_begin First atom whose neighbor row is visited.
+ * @param i_end One past the last atom whose neighbor row is visited.
+ * @param F Force array of size 3 * N, added to.
+ * @return The energy of the visited pairs.
+ */
+double lj_pair_range_mixed(SimdLevel level, const LJPairDataF &data,
+                           const LJParams &params, size_t i_begin,
+                           size_t i_end, double *F);
+
+} // namespace rgpot
@@ -0,0 +1,366 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Implementation of the MPI domain-decomposed Lennard-Jones
+ * potential.
+ *
+ * Rank 0 bins the atoms into domains by their fractional coordinates and
+ * scatters them, the ranks trade ghost atoms with their neighbors one cell
+ * vector at a time, and the forces of the owned atoms are gathered back.
+ */
+
+// clang-format off
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+// clang-format on
+
+#include "rgpot/LennardJones/LJMpiPot.hpp"
+
+namespace rgpot {
+
+namespace {
+
+/**
+ * @brief Wrapped fractional coordinate of a position along a cell vector.
+ * @param cell Simulation cell.
+ * @param r The Cartesian position.
+ * @param d Index of the cell vector.
+ * @return The coordinate, in [0, 1].
+ */
+double fractional(const PeriodicCell &cell, const double *r, size_t d) {
+  const auto &inv = cell.inverse();
+  const double s = r[0] * inv[d] + r[1] * inv[3 + d] + r[2] * inv[6 + d];
+  return s - std::floor(s);
+}
+
+/**
+ * @brief Domain holding a fractional coordinate.
+ * @param s The coordinate, in [0, 1].
+ * @param p Number of domains along its cell vector.
+ * @return The domain index, in [0, @a p).
+ */
+int domain_of(double s, int p) {
+  return std::min(p - 1, static_cast<int>(s * p));
+}
+
+/**
+ * @brief Rank owning a domain.
+ * @param c Domain indices along the three cell vectors.
+ * @param grid Number of domains along each cell vector.
+ * @return The rank.
+ */
+int rank_of(const std::array<int, 3> &c, const std::array<int, 3> &grid) {
+  return (c[0] * grid[1] + c[1]) * grid[2] + c[2];
+}
+
+/**
+ * @brief Domain of a rank.
+ * @param rank The rank, below the number of domains.
+ * @param grid Number of domains along each cell vector.
+ * @return Domain indices along the three cell vectors.
+ */
+std::array<int, 3> domain_of_rank(int rank, const std::array<int, 3> &grid) {
+  return {rank / (grid[1] * grid[2]), (rank / grid[2]) % grid[1],
+          rank % grid[2]};
+}
+
+} // namespace
+
+LJMpiPot::LJMpiPot(MPI_Comm comm, LJParams params)
+    : Potential(PotType::LJ), m_params{params},
+      m_nlist(params.cutoff, 0.0) {
+  int initialized = 0;
+  MPI_Initialized(&initialized);
+  if (!initialized) {
+    throw std::runtime_error("LJMpiPot needs MPI to be initialized");
+  }
+  MPI_Comm_dup(comm, &m_comm);
+  MPI_Comm_rank(m_comm, &m_rank);
+  MPI_Comm_size(m_comm, &m_size);
+  MPI_Type_contiguous(sizeof(Atom), MPI_BYTE, &m_atom_type);
+  MPI_Type_commit(&m_atom_type);
+}
+
+LJMpiPot::~LJMpiPot() {
+  int finalized = 0;
+  MPI_Finalized(&finalized);
+  if (!finalized) {
+    MPI_Type_free(&m_atom_type);
+    MPI_Comm_free(&m_comm);
+  }
+}
+
+/**
+ * @details
+ * The ghost atoms of a domain are found by its fractional extent widened
+ * by the cutoff divided by the perpendicular width along each cell vector,
+ * a superset of the atoms within the cutoff of the domain. The grids are
+ * enumerated directly, there are few for any realistic number of ranks.
+ */
+std::array<int, 3> LJMpiPot::process_grid(int ranks, const PeriodicCell &cell,
+                                          double cutoff) {
+  std::array<double, 3> width{};
+  std::array<int, 3> limit{};
+  for (size_t d = 0; d < 3; ++d) {
+    width[d] = cell.perpendicular_width(d);
+    const double n = std::floor(width[d] / cutoff);
+    limit[d] = std::isfinite(n) && n > 1.0
+                   ? static_cast<int>(std::min<double>(n, ranks))
+                   : 1;
+  }
+  std::array<int, 3> best{1, 1, 1};
+  int best_used = 1;
+  double best_cost = std::numeric_limits<double>::infinity();
+  for (int p0 = 1; p0 <= limit[0]; ++p0) {
+    for (int p1 = 1; p1 <= std::min(limit[1], ranks / p0); ++p1) {
+      const int p2 = std::min(limit[2], ranks / (p0 * p1));
+      const int used = p0 * p1 * p2;
+      // Ghosts per domain grow with the domain count along each vector
+      const double cost = p0 / width[0] + p1 / width[1] + p2 / width[2];
+      if (used > best_used || (used == best_used && cost < best_cost)) {
+        best = {p0, p1, p2};
+        best_used = used;
+        best_cost = cost;
+      }
+    }
+  }
+  return best;
+}
+
+/**
+ * @class LJMpiPot
+ * @details
+ *
+ * Each rank sums the pairs of its half neighbor list over the owned and
+ * ghost atoms. Pairs of two owned atoms count fully, pairs of an owned
+ * atom and a ghost count half on each of the two ranks holding them, and
+ * pairs of two ghosts are skipped, so the reduced energy holds every pair
+ * once. Forces are only accumulated on owned atoms, which need no reverse
+ * communication of the ghost forces.
+ *
+ * The pair terms are those of @c lj_pair_image, the arithmetic of the
+ * scalar @c LJPot kernel, and a single rank gives the results of
+ * @c LJPot up to the summation order.
+ */
+void LJMpiPot::forceImpl(const ForceInput &in, ForceOut *out) const {
+  uint64_t n_atoms = in.nAtoms;
+  double box[9];
+  std::copy(in.box, in.box + 9, box);
+  MPI_Bcast(&n_atoms, 1, MPI_UINT64_T, 0, m_comm);
+  MPI_Bcast(box, 9, MPI_DOUBLE, 0, m_comm);
+  int mismatch = n_atoms != in.nAtoms;
+  MPI_Allreduce(MPI_IN_PLACE, &mismatch, 1, MPI_INT, MPI_LOR, m_comm);
+  if (mismatch) {
+    throw std::invalid_argument("LJMpiPot ranks disagree on the atom count");
+  }
+
+  const PeriodicCell cell(box);
+  m_grid = process_grid(m_size, cell, m_params.cutoff);
+  scatter(in, cell);
+  if (m_rank < m_grid[0] * m_grid[1] * m_grid[2]) {
+    for (size_t d = 0; d < 3; ++d) {
+      if (m_grid[d] > 1) {
+        exchange(d, cell);
+      }
+    }
+  }
+
+  double energy = local_forces(box);
+  MPI_Allreduce(MPI_IN_PLACE, &energy, 1, MPI_DOUBLE, MPI_SUM, m_comm);
+  out->energy = energy;
+  gather(in.nAtoms, out->F);
+}
+
+/**
+ * @details
+ * Rank 0 sends every atom wrapped into the cell, in the order of the
+ * ranks, so that one @c MPI_Scatterv delivers them.
+ */
+void LJMpiPot::scatter(const ForceInput &in, const PeriodicCell &cell) const {
+  std::vector<int> counts;
+  std::vector<int> displs;
+  if (m_rank == 0) {
+    const size_t N = in.nAtoms;
+    std::vector<int> owner(N);
+    counts.assign(m_size, 0);
+    for (size_t i = 0; i < N; ++i) {
+      std::array<int, 3> c{};
+      for (size_t d = 0; d < 3; ++d) {
+        c[d] = domain_of(fractional(cell, in.pos + 3 * i, d), m_grid[d]);
+      }
+      owner[i] = rank_of(c, m_grid);
+      ++counts[owner[i]];
+    }
+    displs.assign(m_size, 0);
+    for (int r = 1; r < m_size; ++r) {
+      displs[r] = displs[r - 1] + counts[r - 1];
+    }
+    std::vector<int> cursor = displs;
+    m_send.resize(N);
+    cell.dispatch([&](auto ortho) {
+      constexpr bool Orthogonal = decltype(ortho)::value;
+      for (size_t i = 0; i < N; ++i) {
+        Atom &atom = m_send[cursor[owner[i]]++];
+        cell.wrap<Orthogonal>(in.pos + 3 * i, atom.r);
+        atom.id = i;
+      }
+    });
+  }
+
+  int n_owned = 0;
+  MPI_Scatter(counts.data(), 1, MPI_INT, &n_owned, 1, MPI_INT, 0, m_comm);
+  m_n_owned = static_cast<size_t>(n_owned);
+  m_local.resize(m_n_owned);
+  MPI_Scatterv(m_send.data(), counts.data(), displs.data(), m_atom_type,
+               m_local.data(), n_owned, m_atom_type, 0, m_comm);
+}
+
+/**
+ * @details
+ * A domain is at least one cutoff wide, so the atoms sent across a face
+ * all come from the domain itself or from ghosts of earlier directions,
+ * whose fractional coordinate along @a d lies in the domain. With two
+ * domains along @a d both neighbors are the same rank, which receives the
+ * atoms near either face in one message so that none arrives twice.
+ */
+void LJMpiPot::exchange(size_t d, const PeriodicCell &cell) const {
+  const int p = m_grid[d];
+  const std::array<int, 3> c = domain_of_rank(m_rank, m_grid);
+  std::array<int, 3> below = c;
+  std::array<int, 3> above = c;
+  below[d] = (c[d] + p - 1) % p;
+  above[d] = (c[d] + 1) % p;
+  const int lower = rank_of(below, m_grid);
+  const int upper = rank_of(above, m_grid);
+
+  const double half = 0.5 / p;
+  const double mid = (c[d] + 0.5) / p;
+  const double halo = m_params.cutoff / cell.perpendicular_width(d);
+
+  // Both lists are staged before anything is appended to m_local
+  std::vector<Atom> to_lower;
+  std::vector<Atom> to_upper;
+  for (const Atom &atom : m_local) {
+    // Offset from the middle of the domain, an atom at a face of the cell
+    // may round to either side of it
+    double ds = fractional(cell, atom.r, d) - mid;
+    ds -= std::round(ds);
+    const bool near_lower = ds + half <= halo;
+    const bool near_upper = half - ds <= halo;
+    if (p == 2) {
+      if (near_lower || near_upper) {
+        to_lower.push_back(atom);
+      }
+      continue;
+    }
+    if (near_lower) {
+      to_lower.push_back(atom);
+    }
+    if (near_upper) {
+      to_upper.push_back(atom);
+    }
+  }
+
+  const auto trade = [&](const std::vector<Atom> &out, int to, int from) {
+    int n_out = static_cast<int>(out.size());
+    int n_in = 0;
+    MPI_Sendrecv(&n_out, 1, MPI_INT, to, 0, &n_in, 1, MPI_INT, from, 0,
+                 m_comm, MPI_STATUS_IGNORE);
+    const size_t start = m_local.size();
+    m_local.resize(start + n_in);
+    MPI_Sendrecv(out.data(), n_out, m_atom_type, to, 1,
+                 m_local.data() + start, n_in, m_atom_type, from, 1, m_comm,
+                 MPI_STATUS_IGNORE);
+  };
+  trade(to_lower, lower, upper);
+  if (p > 2) {
+    trade(to_upper, upper, lower);
+  }
+}
+
+/**
+ * @details
+ * The neighbor list has no Verlet skin: the local atoms change with every
+ * configuration, so a list kept by index would need checking against
+ * other atoms anyway. Owned atoms come first in @c m_local, so the rows
+ * of the ghosts only hold ghost pairs and are not visited. The owned
+ * forces are written back into the positions of @c m_local, ready for
+ * @c gather.
+ */
+double LJMpiPot::local_forces(const double *box) const {
+  const size_t n_local = m_local.size();
+  m_pos.resize(3 * n_local);
+  for (size_t i = 0; i < n_local; ++i) {
+    std::copy(m_local[i].r, m_local[i].r + 3, m_pos.data() + 3 * i);
+  }
+  const ForceInput local{.nAtoms = n_local,
+                         .pos = m_pos.data(),
+                         .atmnrs = nullptr,
+                         .box = box};
+  m_nlist.update(local);
+
+  const LJDeviceCell dcell = make_device_cell(box);
+  const auto &offsets = m_nlist.offsets();
+  const auto &neighbors = m_nlist.neighbors();
+  std::vector<double> F(3 * m_n_owned, 0.0);
+  double energy = 0.0;
+  for (size_t i = 0; i < m_n_owned; ++i) {
+    for (size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+      const size_t j = neighbors[k];
+      double f[3]{0.0, 0.0, 0.0};
+      const double e = lj_pair_image(m_pos.data() + 3 * i,
+                                     m_pos.data() + 3 * j, m_params, dcell, f);
+      F[3 * i] += f[0];
+      F[3 * i + 1] += f[1];
+      F[3 * i + 2] += f[2];
+      if (j < m_n_owned) {
+        F[3 * j] -= f[0];
+        F[3 * j + 1] -= f[1];
+        F[3 * j + 2] -= f[2];
+        energy += e;
+      } else {
+        energy += 0.5 * e;
+      }
+    }
+  }
+  for (size_t i = 0; i < m_n_owned; ++i) {
+    std::copy(F.data() + 3 * i, F.data() + 3 * i + 3, m_local[i].r);
+  }
+  return energy;
+}
+
+/**
+ * @details
+ * The owned atoms carry their forces and indices to rank 0, which places
+ * them and broadcasts the full array, so every rank returns the same
+ * result.
+ */
+void LJMpiPot::gather(size_t n_atoms, double *F) const {
+  int n_owned = static_cast<int>(m_n_owned);
+  std::vector<int> counts;
+  std::vector<int> displs;
+  if (m_rank == 0) {
+    counts.resize(m_size);
+    displs.assign(m_size, 0);
+  }
+  MPI_Gather(&n_owned, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, m_comm);
+  if (m_rank == 0) {
+    for (int r = 1; r < m_size; ++r) {
+      displs[r] = displs[r - 1] + counts[r - 1];
+    }
+    m_send.resize(n_atoms);
+  }
+  MPI_Gatherv(m_local.data(), n_owned, m_atom_type, m_send.data(),
+              counts.data(), displs.data(), m_atom_type, 0, m_comm);
+  if (m_rank == 0) {
+    for (const Atom &atom : m_send) {
+      std::copy(atom.r, atom.r + 3, F + 3 * atom.id);
+    }
+  }
+  MPI_Bcast(F, static_cast<int>(3 * n_atoms), MPI_DOUBLE, 0, m_comm);
+}
+
+} // namespace rgpot
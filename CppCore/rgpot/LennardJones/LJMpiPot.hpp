@@ -0,0 +1,176 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Header file for the MPI domain-decomposed Lennard-Jones potential.
+ *
+ * Defines @c LJMpiPot, the shifted 12-6 form of @c LJPot evaluated by all
+ * ranks of an MPI communicator on one configuration. It is built with the
+ * meson @c with_mpi option or the CMake @c RGPOT_WITH_MPI setting, which
+ * also define @c RGPOT_HAS_MPI.
+ */
+
+// clang-format off
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <mpi.h>
+// clang-format on
+#include "rgpot/LennardJones/LJDevice.hpp"
+#include "rgpot/NeighborList.hpp"
+#include "rgpot/PeriodicCell.hpp"
+#include "rgpot/Potential.hpp"
+
+namespace rgpot {
+
+/**
+ * @class LJMpiPot
+ * @brief Shifted 12-6 Lennard-Jones potential split across MPI ranks.
+ * @ingroup rgpot_potentials
+ *
+ * The cell is cut into a grid of domains along its three vectors, one per
+ * rank. Every rank receives the atoms of its domain, copies of the atoms
+ * within the cutoff of it from the neighboring domains, and computes the
+ * forces on its own atoms; the energy is summed over the ranks.
+ *
+ * Every call is collective: all ranks of the communicator call
+ * @c operator() (or any other evaluation) together. Only the configuration
+ * of rank 0 is read, the other ranks pass the same number of atoms, and
+ * all of them receive the energy and the forces. With a cache attached,
+ * the ranks have to pass identical configurations so that they agree on
+ * the hits.
+ */
+class LJMpiPot : public Potential<LJMpiPot> {
+public:
+  /**
+   * @brief Constructor for LJMpiPot.
+   * @param comm Communicator of the ranks sharing the work, duplicated so
+   *             that its messages do not mix with those of the caller.
+   * @param params Potential parameters, those of @c LJPot by default.
+   * @throws std::runtime_error when MPI is not initialized.
+   */
+  explicit LJMpiPot(MPI_Comm comm = MPI_COMM_WORLD,
+                    LJParams params = shifted_lj_params(1.0, 1.0, 15.0));
+
+  ~LJMpiPot() override;
+  LJMpiPot(const LJMpiPot &) = delete;
+  LJMpiPot &operator=(const LJMpiPot &) = delete;
+
+  /**
+   * @brief Computes the forces and energy for a given configuration.
+   *
+   * The cutoff has to stay below half of the smallest perpendicular width
+   * of the cell, as for @c LJPot.
+   *
+   * @param in Structure containing coordinates and cell info.
+   * @param out Pointer to the results structure.
+   * @return Void.
+   * @throws std::invalid_argument when the ranks pass different numbers of
+   *         atoms, on every rank.
+   */
+  void forceImpl(const ForceInput &in, ForceOut *out) const override;
+
+  /**
+   * @brief Picks the grid of domains for a cell.
+   *
+   * Every domain is at least one cutoff wide, so the atoms within the
+   * cutoff of a domain all live in its direct neighbors. Among the grids
+   * using the most ranks, the one with the fewest ghost atoms is taken;
+   * ranks beyond the grid stay idle.
+   *
+   * @param ranks Number of ranks available.
+   * @param cell Simulation cell.
+   * @param cutoff Interaction cutoff radius.
+   * @return Number of domains along each cell vector.
+   */
+  [[nodiscard]] static std::array<int, 3>
+  process_grid(int ranks, const PeriodicCell &cell, double cutoff);
+
+  /**
+   * @brief Fetches the grid of domains of the last evaluation.
+   * @return Number of domains along each cell vector.
+   */
+  [[nodiscard]] std::array<int, 3> grid() const { return m_grid; }
+
+  /**
+   * @brief Fetches the number of ghost atoms of the last evaluation.
+   * @return Copies received by this rank from its neighbors.
+   */
+  [[nodiscard]] size_t num_ghosts() const {
+    return m_local.size() - m_n_owned;
+  }
+
+  /**
+   * @brief Fetches the rank of this process.
+   * @return Rank in the communicator.
+   */
+  [[nodiscard]] int rank() const { return m_rank; }
+
+  /**
+   * @brief Fetches the number of ranks.
+   * @return Size of the communicator.
+   */
+  [[nodiscard]] int size() const { return m_size; }
+
+private:
+  /**
+   * @brief One atom as it travels between ranks.
+   */
+  struct Atom {
+    double r[3]; //!< Position, or force on the way back.
+    uint64_t id; //!< Index in the configuration of rank 0.
+  };
+
+  /**
+   * @brief Sends rank 0's atoms to the ranks owning their domains.
+   * @param in Configuration, only read on rank 0.
+   * @param cell Simulation cell.
+   * @return Void.
+   */
+  void scatter(const ForceInput &in, const PeriodicCell &cell) const;
+
+  /**
+   * @brief Copies the atoms near the faces of a domain to its neighbors.
+   *
+   * Sends the owned and ghost atoms within the cutoff of the lower and
+   * upper face along cell vector @a d, and appends those received as
+   * ghosts. After the three directions, the ghosts of a domain cover its
+   * edges and corners as well.
+   *
+   * @param d Index of the cell vector.
+   * @param cell Simulation cell.
+   * @return Void.
+   */
+  void exchange(size_t d, const PeriodicCell &cell) const;
+
+  /**
+   * @brief Computes the forces on the owned atoms.
+   * @param box Flat 3x3 cell matrix.
+   * @return The energy of this rank's share of the pairs.
+   */
+  double local_forces(const double *box) const;
+
+  /**
+   * @brief Gathers the forces on rank 0 and broadcasts them.
+   * @param n_atoms Number of atoms.
+   * @param F Receives the forces of all atoms, on every rank.
+   * @return Void.
+   */
+  void gather(size_t n_atoms, double *F) const;
+
+  MPI_Comm m_comm;          //!< Duplicated communicator.
+  MPI_Datatype m_atom_type; //!< An @c Atom as bytes.
+  int m_rank;               //!< Rank in @c m_comm.
+  int m_size;               //!< Size of @c m_comm.
+  LJParams m_params;        //!< Potential parameters.
+  mutable std::array<int, 3> m_grid{1, 1, 1}; //!< Domains per cell vector.
+  mutable NeighborList m_nlist; //!< Pairs of the owned and ghost atoms.
+  mutable std::vector<Atom> m_local; //!< Owned atoms, then the ghosts.
+  mutable size_t m_n_owned{0};       //!< Owned atoms in @c m_local.
+  mutable std::vector<Atom> m_send;  //!< Staging of outgoing atoms.
+  mutable std::vector<double> m_pos; //!< Interleaved @c m_local positions.
+};
+
+} // namespace rgpot
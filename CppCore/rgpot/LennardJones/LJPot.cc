@@ -25,68 +25,204 @@ namespace rgpot {
  * @details
  *
  * This method calculates pairwise interactions between all atoms
- * within the cutoff radius. It applies the minimum image convention
- * using the provided box dimensions to handle periodic boundaries.
+ * within the cutoff radius. It applies the minimum image convention of a
+ * @c PeriodicCell built once per call, so orthogonal and skewed boxes are
+ * both handled and the pair loop multiplies by the inverse cell instead
+ * of dividing by the box lengths.
  *
- * @note This implementation is adapted, untouched from the [eOn
+ * Candidate pairs come from the internal @c NeighborList, which is only
+ * rebuilt when an atom has moved by more than half the Verlet skin since
+ * the previous call, so the cost per call is linear in the number of atoms.
+ *
+ * When a thread pool is attached, the neighbor rows are split into chunks
+ * of similar pair counts, each accumulated into a private force buffer,
+ * and the buffers are summed afterwards. Without a pool, or with a pool of
+ * one thread, the serial loop runs directly.
+ *
+ * Unless the SIMD level is @c SimdLevel::Scalar, the positions are first
+ * copied into separate x, y and z blocks for the vectorized kernel.
+ * In mixed precision the blocks are single precision instead, filled once
+ * per call from positions wrapped into the cell, so the rounding error of
+ * a coordinate is bounded by the cell size.
+ *
+ * @note The pair kernel is adapted, untouched from the [eOn
  * project](https://github.com/TheochemUI/EONgit/blob/stable/client/potentials/LJ/LJ.cpp).
- * @warning The box is assumed to be orthogonal.
  *
  */
 void LJPot::forceImpl(const ForceInput &in, ForceOut *out) const {
-  long N = in.nAtoms;
-  const double *R = in.pos;
-  const double *box = in.box;
-  double *F = out->F;
-  double *U = &out->energy;
+  const size_t N = in.nAtoms;
+  const PeriodicCell cell(in.box);
+  m_nlist.update(in);
+  if (m_precision == Precision::Mixed) {
+    m_soa_f.resize(3 * N);
+    cell.dispatch([&](auto ortho) {
+      constexpr bool Orthogonal = decltype(ortho)::value;
+      double w[3];
+      for (size_t i = 0; i < N; i++) {
+        cell.wrap<Orthogonal>(in.pos + 3 * i, w);
+        m_soa_f[i] = static_cast<float>(w[0]);
+        m_soa_f[N + i] = static_cast<float>(w[1]);
+        m_soa_f[2 * N + i] = static_cast<float>(w[2]);
+      }
+    });
+  } else if (m_simd != SimdLevel::Scalar) {
+    m_soa.resize(3 * N);
+    for (size_t i = 0; i < N; i++) {
+      m_soa[i] = in.pos[3 * i];
+      m_soa[N + i] = in.pos[3 * i + 1];
+      m_soa[2 * N + i] = in.pos[3 * i + 2];
+    }
+  }
+
+  if (m_pool && m_pool->size() > 1) {
+    out->energy = accumulate_pair_forces(
+        *m_pool, N, m_nlist.offsets(), m_deterministic, m_scratch, out->F,
+        [&](size_t i_begin, size_t i_end, double *F) {
+          return pairRange(i_begin, i_end, in.pos, cell, F);
+        });
+    return;
+  }
+
+  for (size_t i = 0; i < 3 * N; i++) {
+    out->F[i] = 0;
+  }
+  out->energy = pairRange(0, N, in.pos, cell, out->F);
+  return;
+}
+
+/**
+ * @details
+ * Only the pairs of the moved atoms are re-evaluated, with the partners of
+ * the neighbor list, so the cost is proportional to the moved atoms times
+ * their neighbors plus one pass checking the list. The move is declined,
+ * and the configuration evaluated in full, when the list would need a
+ * rebuild for either configuration or a quarter of the atoms or more
+ * moved. The pair terms are those of the SIMD kernels in double
+ * precision, whatever the selected precision.
+ */
+bool LJPot::movedImpl(const ForceInput &prev, const ForceInput &next,
+                      const size_t *moved, size_t n_moved, ForceOut *out,
+                      bool with_forces) const {
+  if (4 * n_moved >= next.nAtoms ||
+      !m_nlist.covers_move(prev, next, moved, n_moved)) {
+    return false;
+  }
+  m_nlist.index_partners();
+  const PeriodicCell cell(next.box);
+  const double rc2 = cuttOffR * cuttOffR;
+  const double psi2 = psi * psi;
+  out->energy += cell.dispatch([&](auto ortho) {
+    constexpr bool Orthogonal = decltype(ortho)::value;
+    return pair_move_delta(
+        prev, next, moved, n_moved, m_moved, with_forces ? out->F : nullptr,
+        [&](size_t i, auto &&visit) { m_nlist.for_each_partner(i, visit); },
+        [&](const double *ri, const double *rj, double *f) {
+          double dx = ri[0] - rj[0];
+          double dy = ri[1] - rj[1];
+          double dz = ri[2] - rj[2];
+          cell.minimum_image<Orthogonal>(dx, dy, dz);
+          const double r2 = dx * dx + dy * dy + dz * dz;
+          if (!(r2 < rc2)) {
+            return 0.0;
+          }
+          const double s2 = psi2 / r2;
+          const double s6 = s2 * s2 * s2;
+          const double fs = 24.0 * u0 * s6 * (2.0 * s6 - 1.0) / r2;
+          f[0] += fs * dx;
+          f[1] += fs * dy;
+          f[2] += fs * dz;
+          return 4.0 * u0 * s6 * (s6 - 1.0) - cuttOffU;
+        });
+  });
+  return true;
+}
+
+/**
+ * @details
+ * Visits the neighbor rows of atoms in [@a i_begin, @a i_end) and applies
+ * Newton's third law to both atoms of each pair, so disjoint ranges only
+ * conflict through the partner atoms.
+ *
+ * With a SIMD level other than @c SimdLevel::Scalar the range is handed to
+ * @c lj_pair_range instead, which evaluates the same shifted 12-6 form from
+ * squared distances. In mixed precision every level goes to
+ * @c lj_pair_range_mixed.
+ *
+ * The scalar loop is instantiated once per cell shape, the orthogonal
+ * minimum image being the one of the original code.
+ */
+double LJPot::pairRange(size_t i_begin, size_t i_end, const double *R,
+                        const PeriodicCell &cell, double *F) const {
+  if (m_precision == Precision::Mixed) {
+    const size_t N = m_nlist.num_atoms();
+    const LJPairDataF data{m_soa_f.data(),
+                           m_soa_f.data() + N,
+                           m_soa_f.data() + 2 * N,
+                           m_nlist.offsets().data(),
+                           m_nlist.neighbors().data(),
+                           &cell};
+    return lj_pair_range_mixed(m_simd, data, {u0, psi, cuttOffR, cuttOffU},
+                               i_begin, i_end, F);
+  }
+  if (m_simd != SimdLevel::Scalar) {
+    const size_t N = m_nlist.num_atoms();
+    const LJPairData data{m_soa.data(),
+                          m_soa.data() + N,
+                          m_soa.data() + 2 * N,
+                          m_nlist.offsets().data(),
+                          m_nlist.neighbors().data(),
+                          &cell};
+    return lj_pair_range(m_simd, data, {u0, psi, cuttOffR, cuttOffU}, i_begin,
+                         i_end, F);
+  }
   // This is adapted, untouched from EON's BSD 3 clause implementation
   // Original source:
   // https://github.com/TheochemUI/EONgit/blob/stable/client/potentials/LJ/LJ.cpp
   // Copyright (c) 2010, EON Development Team
   // All rights reserved. BSD 3-Clause License.
-  double diffR{0}, diffRX{0}, diffRY{0}, diffRZ{0}, dU{0}, a{0}, b{0};
-  *U = 0;
-  for (int i = 0; i < N; i++) {
-    F[3 * i] = 0;
-    F[3 * i + 1] = 0;
-    F[3 * i + 2] = 0;
-  }
+  const auto &offsets = m_nlist.offsets();
+  const auto &neighbors = m_nlist.neighbors();
 
-  for (int i = 0; i < N - 1; i++) {
-    for (int j = i + 1; j < N; j++) {
-      diffRX = R[3 * i] - R[3 * j];
-      diffRY = R[3 * i + 1] - R[3 * j + 1];
-      diffRZ = R[3 * i + 2] - R[3 * j + 2];
+  return cell.dispatch([&](auto ortho) {
+    constexpr bool Orthogonal = decltype(ortho)::value;
+    double diffR{0}, diffRX{0}, diffRY{0}, diffRZ{0}, dU{0}, a{0}, b{0};
+    double U{0};
 
-      // Minimum image convention
-      diffRX = diffRX - box[0] * floor(diffRX / box[0] + 0.5);
-      diffRY = diffRY - box[4] * floor(diffRY / box[4] + 0.5);
-      diffRZ = diffRZ - box[8] * floor(diffRZ / box[8] + 0.5);
+    for (size_t i = i_begin; i < i_end; i++) {
+      for (size_t k = offsets[i]; k < offsets[i + 1]; k++) {
+        const size_t j = neighbors[k];
+        diffRX = R[3 * i] - R[3 * j];
+        diffRY = R[3 * i + 1] - R[3 * j + 1];
+        diffRZ = R[3 * i + 2] - R[3 * j + 2];
 
-      diffR = sqrt(diffRX * diffRX + diffRY * diffRY + diffRZ * diffRZ);
+        // Minimum image convention
+        cell.minimum_image<Orthogonal>(diffRX, diffRY, diffRZ);
 
-      if (diffR < cuttOffR) {
-        // Standard 12-6 form: 4u0((psi/r)^12 - (psi/r)^6)
-        a = pow(psi / diffR, 6);
-        b = 4 * u0 * a;
+        diffR = sqrt(diffRX * diffRX + diffRY * diffRY + diffRZ * diffRZ);
 
-        *U = *U + b * (a - 1) - cuttOffU;
+        if (diffR < cuttOffR) {
+          // Standard 12-6 form: 4u0((psi/r)^12 - (psi/r)^6)
+          a = pow(psi / diffR, 6);
+          b = 4 * u0 * a;
 
-        dU = -6 * b / diffR * (2 * a - 1);
+          U = U + b * (a - 1) - cuttOffU;
 
-        // Update forces for both atoms
-        // F is the negative derivative
-        F[3 * i] = F[3 * i] - dU * diffRX / diffR;
-        F[3 * i + 1] = F[3 * i + 1] - dU * diffRY / diffR;
-        F[3 * i + 2] = F[3 * i + 2] - dU * diffRZ / diffR;
+          dU = -6 * b / diffR * (2 * a - 1);
 
-        F[3 * j] = F[3 * j] + dU * diffRX / diffR;
-        F[3 * j + 1] = F[3 * j + 1] + dU * diffRY / diffR;
-        F[3 * j + 2] = F[3 * j + 2] + dU * diffRZ / diffR;
+          // Update forces for both atoms
+          // F is the negative derivative
+          F[3 * i] = F[3 * i] - dU * diffRX / diffR;
+          F[3 * i + 1] = F[3 * i + 1] - dU * diffRY / diffR;
+          F[3 * i + 2] = F[3 * i + 2] - dU * diffRZ / diffR;
+
+          F[3 * j] = F[3 * j] + dU * diffRX / diffR;
+          F[3 * j + 1] = F[3 * j + 1] + dU * diffRY / diffR;
+          F[3 * j + 2] = F[3 * j + 2] + dU * diffRZ / diffR;
+        }
       }
     }
-  }
-  return;
+    return U;
+  });
 }
 
 } // namespace rgpot
@@ -10,11 +10,18 @@
  */
 
 // clang-format off
+#include <cmath>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <stdexcept>
 // clang-format on
+#include "rgpot/LennardJones/LJKernels.hpp"
+#include "rgpot/NeighborList.hpp"
+#include "rgpot/PairMoves.hpp"
+#include "rgpot/PeriodicCell.hpp"
 #include "rgpot/Potential.hpp"
+#include "rgpot/ThreadPool.hpp"
 #include "rgpot/types/AtomMatrix.hpp"
 using rgpot::types::AtomMatrix;
 
@@ -29,8 +36,17 @@ class LJPot : public Potential<LJPot> {
 public:
   /**
    * @brief Default constructor initializing parameters.
+   *
+   * The energy shift is the unshifted pair energy at the cutoff, as in
+   * eOn, so the pair energy is continuous there.
    */
-  LJPot() : Potential(PotType::LJ), u0{1.0}, cuttOffR{15.0}, psi{1.0} {}
+  LJPot()
+      : Potential(PotType::LJ), u0{1.0}, cuttOffR{15.0}, psi{1.0},
+        cuttOffU{4.0 * u0 *
+                 (std::pow(psi / cuttOffR, 12) - std::pow(psi / cuttOffR, 6))},
+        m_nlist(cuttOffR, 0.3), m_pool{ThreadPool::from_env()},
+        m_deterministic{ThreadPool::deterministic_from_env()},
+        m_simd{detect_simd_level()} {}
 
   /**
    * @brief Computes the forces and energy for a given configuration.
@@ -40,11 +56,127 @@ public:
    */
   void forceImpl(const ForceInput &in, ForceOut *out) const override;
 
+  /**
+   * @brief Updates energy and forces for a move of a few atoms.
+   * @param prev Configuration whose results are in @a out.
+   * @param next Configuration after the move.
+   * @param moved Indices of the displaced atoms.
+   * @param n_moved Number of entries in @a moved.
+   * @param out Results of @a prev, updated to those of @a next.
+   * @param with_forces Whether @c out->F has to be updated.
+   * @return True if the move was handled incrementally.
+   */
+  bool movedImpl(const ForceInput &prev, const ForceInput &next,
+                 const size_t *moved, size_t n_moved, ForceOut *out,
+                 bool with_forces) const override;
+
+  /**
+   * @brief Sets the Verlet skin of the internal neighbor list.
+   * @param skin Extra shell beyond the cutoff, zero rebuilds every move.
+   * @return Void.
+   */
+  void set_neighbor_skin(double skin) { m_nlist.set_skin(skin); }
+
+  /**
+   * @brief Fetches the internal neighbor list.
+   * @return Const reference to the neighbor list.
+   */
+  [[nodiscard]] const NeighborList &neighbor_list() const { return m_nlist; }
+
+  /**
+   * @brief Runs the pair loop on a private thread pool.
+   * @param num_threads Total threads, one restores serial execution.
+   * @param deterministic Toggle the fixed-order force reduction.
+   * @return Void.
+   */
+  void set_num_threads(size_t num_threads, bool deterministic = false) {
+    m_pool = num_threads > 1 ? std::make_shared<ThreadPool>(num_threads)
+                             : nullptr;
+    m_deterministic = deterministic;
+  }
+
+  /**
+   * @brief Runs the pair loop on a shared thread pool.
+   * @param pool The pool to use, @c nullptr restores serial execution.
+   * @param deterministic Toggle the fixed-order force reduction.
+   * @return Void.
+   */
+  void set_thread_pool(std::shared_ptr<ThreadPool> pool,
+                       bool deterministic = false) {
+    m_pool = std::move(pool);
+    m_deterministic = deterministic;
+  }
+
+  /**
+   * @brief Fetches the number of threads used by the pair loop.
+   * @return Pool size, or one for serial execution.
+   */
+  [[nodiscard]] size_t num_threads() const {
+    return m_pool ? m_pool->size() : 1;
+  }
+
+  /**
+   * @brief Selects the pair kernel instruction set.
+   * @param level The SIMD level, @c SimdLevel::Scalar runs the eOn loop.
+   * @return Void.
+   */
+  void set_simd_level(SimdLevel level) {
+    if (!simd_level_supported(level)) {
+      throw std::invalid_argument("SIMD level not supported by this CPU");
+    }
+    m_simd = level;
+  }
+
+  /**
+   * @brief Fetches the pair kernel instruction set.
+   * @return The active SIMD level.
+   */
+  [[nodiscard]] SimdLevel simd_level() const { return m_simd; }
+
+  /**
+   * @brief Selects the floating point format of the pair kernel.
+   *
+   * @c Precision::Mixed runs @c lj_pair_range_mixed at every SIMD level,
+   * including @c SimdLevel::Scalar. Results of both formats share cache
+   * keys, so a cache should not be shared across precisions.
+   *
+   * @param precision The format, @c Precision::Double by default.
+   * @return Void.
+   */
+  void set_precision(Precision precision) { m_precision = precision; }
+
+  /**
+   * @brief Fetches the floating point format of the pair kernel.
+   * @return The active precision.
+   */
+  [[nodiscard]] Precision precision() const { return m_precision; }
+
 private:
+  /**
+   * @brief Accumulates the pair terms of a range of atoms.
+   * @param i_begin First atom whose neighbor row is visited.
+   * @param i_end One past the last atom whose neighbor row is visited.
+   * @param R Positions of all atoms.
+   * @param cell Simulation cell.
+   * @param F Force array of all atoms, added to.
+   * @return The energy of the visited pairs.
+   */
+  double pairRange(size_t i_begin, size_t i_end, const double *R,
+                   const PeriodicCell &cell, double *F) const;
+
   double u0;       //!< Well depth parameter.
   double cuttOffR; //!< Distance beyond which potential is truncated.
   double psi;      //!< Distance at which the inter-particle potential is zero.
   double cuttOffU; //!< Potential energy value at the cutoff distance.
+  mutable NeighborList m_nlist; //!< Pair list reused across force calls.
+  std::shared_ptr<ThreadPool> m_pool; //!< Pool for the pair loop, or null.
+  bool m_deterministic;               //!< Fixed-order force reduction.
+  mutable std::vector<double> m_scratch; //!< Per-thread force buffers.
+  SimdLevel m_simd;                      //!< Pair kernel instruction set.
+  mutable std::vector<double> m_soa; //!< Positions as x, y, z blocks.
+  Precision m_precision{Precision::Double}; //!< Pair kernel format.
+  mutable std::vector<float> m_soa_f; //!< Wrapped single precision blocks.
+  mutable std::vector<char> m_moved;  //!< Flags of the atoms of a move.
 };
 
 } // namespace rgpot
@@ -0,0 +1,269 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Implementation of the linked-cell neighbor list.
+ *
+ * Contains the rebuild criterion and the two list builders: a linked-cell
+ * pass used when the box holds at least three cells per direction, and an
+ * all-pairs pass for small boxes where the cell stencil would overlap
+ * itself.
+ */
+
+// clang-format off
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+// clang-format on
+#include "rgpot/NeighborList.hpp"
+
+namespace rgpot {
+
+namespace {
+
+constexpr size_t kNoAtom = std::numeric_limits<size_t>::max();
+
+} // namespace
+
+NeighborList::NeighborList(double cutoff, double skin)
+    : m_cutoff{cutoff}, m_skin{0.0}, m_valid{false}, m_rebuilds{0},
+      m_ref_box{}, m_partners_valid{false} {
+  set_skin(skin);
+}
+
+/**
+ * @details
+ * Changing the skin alters the list radius, so the stored list is
+ * invalidated.
+ *
+ * @warning Throws @c std::invalid_argument for a negative skin.
+ */
+void NeighborList::set_skin(double skin) {
+  if (skin < 0.0) {
+    throw std::invalid_argument("NeighborList skin must be non-negative");
+  }
+  m_skin = skin;
+  m_valid = false;
+}
+
+/**
+ * @details
+ * A rebuild is needed when no list exists yet, when the atom count or box
+ * changed, or when any atom moved by more than half the skin since the last
+ * build. The half-skin criterion guarantees that no pair can have crossed
+ * from outside @c cutoff + @c skin to inside @c cutoff in between.
+ */
+bool NeighborList::needs_rebuild(const ForceInput &in) const {
+  if (!m_valid || num_atoms() != in.nAtoms) {
+    return true;
+  }
+  for (size_t k = 0; k < 9; ++k) {
+    if (m_ref_box[k] != in.box[k]) {
+      return true;
+    }
+  }
+  for (size_t i = 0; i < in.nAtoms; ++i) {
+    if (displaced(in.pos + 3 * i, i)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool NeighborList::displaced(const double *r, size_t i) const {
+  const double half_skin = 0.5 * m_skin;
+  const double dx = r[0] - m_ref_pos[3 * i];
+  const double dy = r[1] - m_ref_pos[3 * i + 1];
+  const double dz = r[2] - m_ref_pos[3 * i + 2];
+  const double d2 = dx * dx + dy * dy + dz * dz;
+  return d2 > half_skin * half_skin || (m_skin == 0.0 && d2 != 0.0);
+}
+
+/**
+ * @details
+ * The box and every atom of @a prev are checked as in @c update, which is
+ * a single pass over the positions without any pair work. With a zero
+ * skin every move is displaced, so callers fall back to a full update.
+ */
+bool NeighborList::covers_move(const ForceInput &prev, const ForceInput &next,
+                               const size_t *moved, size_t n_moved) const {
+  if (next.nAtoms != prev.nAtoms || needs_rebuild(prev)) {
+    return false;
+  }
+  for (size_t k = 0; k < 9; ++k) {
+    if (m_ref_box[k] != next.box[k]) {
+      return false;
+    }
+  }
+  for (size_t k = 0; k < n_moved; ++k) {
+    if (displaced(next.pos + 3 * moved[k], moved[k])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @details
+ * Counts the pairs per second atom and fills the reverse rows in one more
+ * pass, so each reverse row lists its first atoms in increasing order.
+ */
+void NeighborList::index_partners() {
+  if (m_partners_valid) {
+    return;
+  }
+  const size_t N = num_atoms();
+  m_rev_offsets.assign(N + 1, 0);
+  for (size_t j : m_neighbors) {
+    ++m_rev_offsets[j + 1];
+  }
+  for (size_t i = 0; i < N; ++i) {
+    m_rev_offsets[i + 1] += m_rev_offsets[i];
+  }
+  m_rev_neighbors.resize(m_neighbors.size());
+  std::vector<size_t> slot(m_rev_offsets.begin(), m_rev_offsets.end() - 1);
+  for (size_t i = 0; i < N; ++i) {
+    for (size_t k = m_offsets[i]; k < m_offsets[i + 1]; ++k) {
+      m_rev_neighbors[slot[m_neighbors[k]]++] = i;
+    }
+  }
+  m_partners_valid = true;
+}
+
+/**
+ * @details
+ * Picks the linked-cell builder when every box direction holds at least
+ * three cells of width @c cutoff + @c skin, measured between opposite cell
+ * faces so that skewed cells are binned correctly, and falls back to the
+ * all-pairs builder otherwise. The reference positions and box are stored
+ * for the displacement check of subsequent calls.
+ */
+bool NeighborList::update(const ForceInput &in) {
+  if (!needs_rebuild(in)) {
+    return false;
+  }
+  const PeriodicCell cell(in.box);
+  const double rlist = m_cutoff + m_skin;
+  std::array<size_t, 3> ncell{0, 0, 0};
+  bool use_cells = rlist > 0.0;
+  for (size_t d = 0; d < 3 && use_cells; ++d) {
+    const double n = std::floor(cell.perpendicular_width(d) / rlist);
+    use_cells = std::isfinite(n) && n >= 3.0;
+    ncell[d] = use_cells ? static_cast<size_t>(n) : 0;
+  }
+  cell.dispatch([&](auto ortho) {
+    constexpr bool Orthogonal = decltype(ortho)::value;
+    if (use_cells) {
+      build_cells<Orthogonal>(in, cell, ncell);
+    } else {
+      build_all_pairs<Orthogonal>(in, cell);
+    }
+  });
+  m_ref_pos.assign(in.pos, in.pos + 3 * in.nAtoms);
+  std::copy(in.box, in.box + 9, m_ref_box.begin());
+  m_valid = true;
+  m_partners_valid = false;
+  ++m_rebuilds;
+  return true;
+}
+
+/**
+ * @details
+ * Atoms are binned into an @c ncell[0] x @c ncell[1] x @c ncell[2] grid
+ * using their fractional coordinates (wrapped into the cell), stored as
+ * singly linked lists through @c m_cell_head and @c m_cell_next. Each atom
+ * then visits the 27 surrounding cells with periodic wrapping and keeps
+ * partners with a larger index, so each pair appears exactly once.
+ */
+template <bool Orthogonal>
+void NeighborList::build_cells(const ForceInput &in, const PeriodicCell &cell,
+                               const std::array<size_t, 3> &ncell) {
+  const size_t N = in.nAtoms;
+  const double *R = in.pos;
+  const double rlist = m_cutoff + m_skin;
+  const double rlist2 = rlist * rlist;
+
+  const size_t total = ncell[0] * ncell[1] * ncell[2];
+  m_cell_head.assign(total, kNoAtom);
+  m_cell_next.assign(N, kNoAtom);
+
+  std::vector<std::array<size_t, 3>> atom_cell(N);
+  for (size_t i = 0; i < N; ++i) {
+    double frac[3];
+    cell.to_fractional<Orthogonal>(R + 3 * i, frac);
+    for (size_t d = 0; d < 3; ++d) {
+      double s = frac[d] - std::floor(frac[d]);
+      auto c = static_cast<size_t>(s * static_cast<double>(ncell[d]));
+      atom_cell[i][d] = c < ncell[d] ? c : ncell[d] - 1;
+    }
+    const size_t flat =
+        (atom_cell[i][0] * ncell[1] + atom_cell[i][1]) * ncell[2] +
+        atom_cell[i][2];
+    m_cell_next[i] = m_cell_head[flat];
+    m_cell_head[flat] = i;
+  }
+
+  m_offsets.resize(N + 1);
+  m_neighbors.clear();
+  for (size_t i = 0; i < N; ++i) {
+    m_offsets[i] = m_neighbors.size();
+    for (size_t ox = 0; ox < 3; ++ox) {
+      const size_t cx = (atom_cell[i][0] + ncell[0] + ox - 1) % ncell[0];
+      for (size_t oy = 0; oy < 3; ++oy) {
+        const size_t cy = (atom_cell[i][1] + ncell[1] + oy - 1) % ncell[1];
+        for (size_t oz = 0; oz < 3; ++oz) {
+          const size_t cz = (atom_cell[i][2] + ncell[2] + oz - 1) % ncell[2];
+          const size_t flat = (cx * ncell[1] + cy) * ncell[2] + cz;
+          for (size_t j = m_cell_head[flat]; j != kNoAtom;
+               j = m_cell_next[j]) {
+            if (j <= i) {
+              continue;
+            }
+            double dx = R[3 * i] - R[3 * j];
+            double dy = R[3 * i + 1] - R[3 * j + 1];
+            double dz = R[3 * i + 2] - R[3 * j + 2];
+            cell.minimum_image<Orthogonal>(dx, dy, dz);
+            if (dx * dx + dy * dy + dz * dz < rlist2) {
+              m_neighbors.push_back(j);
+            }
+          }
+        }
+      }
+    }
+  }
+  m_offsets[N] = m_neighbors.size();
+}
+
+/**
+ * @details
+ * Tests every @c i < @c j pair under the minimum image convention. This is
+ * only used when the box is too small for a three-cell stencil, which is
+ * also the regime where the list stays cheap to rebuild.
+ */
+template <bool Orthogonal>
+void NeighborList::build_all_pairs(const ForceInput &in,
+                                   const PeriodicCell &cell) {
+  const size_t N = in.nAtoms;
+  const double *R = in.pos;
+  const double rlist = m_cutoff + m_skin;
+  const double rlist2 = rlist * rlist;
+
+  m_offsets.resize(N + 1);
+  m_neighbors.clear();
+  for (size_t i = 0; i < N; ++i) {
+    m_offsets[i] = m_neighbors.size();
+    for (size_t j = i + 1; j < N; ++j) {
+      double dx = R[3 * i] - R[3 * j];
+      double dy = R[3 * i + 1] - R[3 * j + 1];
+      double dz = R[3 * i + 2] - R[3 * j + 2];
+      cell.minimum_image<Orthogonal>(dx, dy, dz);
+      if (dx * dx + dy * dy + dz * dz < rlist2) {
+        m_neighbors.push_back(j);
+      }
+    }
+  }
+  m_offsets[N] = m_neighbors.size();
+}
+
+} // namespace rgpot
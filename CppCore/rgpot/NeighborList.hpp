@@ -0,0 +1,201 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Linked-cell neighbor list with an optional Verlet skin.
+ *
+ * Defines the @c NeighborList class used by short-ranged pair potentials to
+ * avoid the full O(N^2) pair search. The list stores each pair once
+ * (@c i < @c j) in a compressed row layout and is only rebuilt when an atom
+ * has moved by more than half the skin since the last build.
+ */
+
+// clang-format off
+#include <array>
+#include <cstddef>
+#include <vector>
+// clang-format on
+#include "rgpot/ForceStructs.hpp"
+#include "rgpot/PeriodicCell.hpp"
+
+namespace rgpot {
+
+/**
+ * @class NeighborList
+ * @brief Half neighbor list built by linked-cell binning.
+ * @ingroup rgpot
+ *
+ * Pairs are collected within @c cutoff + @c skin using the minimum image
+ * convention of @c PeriodicCell, for orthogonal and skewed cells alike.
+ * Callers must still test the actual distance against the interaction
+ * cutoff, since the list is a superset.
+ */
+class NeighborList {
+public:
+  /**
+   * @brief Constructor for NeighborList.
+   * @param cutoff The interaction cutoff radius.
+   * @param skin Extra Verlet shell, zero disables list reuse across moves.
+   */
+  explicit NeighborList(double cutoff, double skin = 0.0);
+
+  /**
+   * @brief Rebuilds the list if the configuration requires it.
+   * @param in Structure containing coordinates and cell info.
+   * @return True if the list was rebuilt.
+   */
+  bool update(const ForceInput &in);
+
+  /**
+   * @brief Forces a rebuild on the next call to @c update.
+   * @return Void.
+   */
+  void invalidate() { m_valid = false; }
+
+  /**
+   * @brief Sets the Verlet skin thickness.
+   * @param skin Extra shell beyond the cutoff, must be non-negative.
+   * @return Void.
+   */
+  void set_skin(double skin);
+
+  /**
+   * @brief Fetches the interaction cutoff.
+   * @return The cutoff radius.
+   */
+  [[nodiscard]] double cutoff() const { return m_cutoff; }
+
+  /**
+   * @brief Fetches the Verlet skin thickness.
+   * @return The skin thickness.
+   */
+  [[nodiscard]] double skin() const { return m_skin; }
+
+  /**
+   * @brief Fetches the number of atoms the list was built for.
+   * @return Atom count.
+   */
+  [[nodiscard]] size_t num_atoms() const {
+    return m_offsets.empty() ? 0 : m_offsets.size() - 1;
+  }
+
+  /**
+   * @brief Fetches the row offsets into @c neighbors().
+   * @return Vector of size @c num_atoms() + 1.
+   */
+  [[nodiscard]] const std::vector<size_t> &offsets() const { return m_offsets; }
+
+  /**
+   * @brief Fetches the flattened neighbor indices.
+   * @return Neighbors of atom @c i are in [offsets()[i], offsets()[i+1]).
+   */
+  [[nodiscard]] const std::vector<size_t> &neighbors() const {
+    return m_neighbors;
+  }
+
+  /**
+   * @brief Checks whether the list holds every pair of a local move.
+   *
+   * Only the atoms in @a moved may differ between @a prev and @a next. The
+   * list covers both configurations when it was built for their box and
+   * atom count, and no atom of either one is further than half the skin
+   * from its position at the last build. The unmoved atoms are shared, so
+   * @a next only needs its moved atoms checked.
+   *
+   * @param prev Configuration before the move.
+   * @param next Configuration after the move.
+   * @param moved Indices of the displaced atoms.
+   * @param n_moved Number of displaced atoms.
+   * @return True if neither configuration requires a rebuild.
+   */
+  [[nodiscard]] bool covers_move(const ForceInput &prev, const ForceInput &next,
+                                 const size_t *moved, size_t n_moved) const;
+
+  /**
+   * @brief Indexes every pair from its second atom as well.
+   *
+   * Needed by @c for_each_partner, and only redone after a rebuild.
+   *
+   * @return Void.
+   */
+  void index_partners();
+
+  /**
+   * @brief Visits every listed partner of one atom.
+   *
+   * Walks the row of @a i and the pairs where @a i is the second atom, so
+   * each partner is visited once. @c index_partners must have been called
+   * since the last rebuild.
+   *
+   * @param i The atom.
+   * @param fn Callable taking the index of a partner.
+   * @return Void.
+   */
+  template <typename Fn> void for_each_partner(size_t i, Fn &&fn) const {
+    for (size_t k = m_offsets[i]; k < m_offsets[i + 1]; ++k) {
+      fn(m_neighbors[k]);
+    }
+    for (size_t k = m_rev_offsets[i]; k < m_rev_offsets[i + 1]; ++k) {
+      fn(m_rev_neighbors[k]);
+    }
+  }
+
+  /**
+   * @brief Fetches the number of rebuilds performed so far.
+   * @return Rebuild count.
+   */
+  [[nodiscard]] size_t rebuilds() const { return m_rebuilds; }
+
+private:
+  /**
+   * @brief Checks whether the stored list is stale for a configuration.
+   * @param in Structure containing coordinates and cell info.
+   * @return True if a rebuild is required.
+   */
+  [[nodiscard]] bool needs_rebuild(const ForceInput &in) const;
+
+  /**
+   * @brief Checks one atom against its position at the last build.
+   * @param r Position of the atom.
+   * @param i Index of the atom.
+   * @return True if the atom moved by more than half the skin.
+   */
+  [[nodiscard]] bool displaced(const double *r, size_t i) const;
+
+  /**
+   * @brief Builds the list by binning atoms into cells.
+   * @param in Structure containing coordinates and cell info.
+   * @param cell The periodic cell of @a in.
+   * @param ncell Number of cells along each box vector.
+   * @return Void.
+   */
+  template <bool Orthogonal>
+  void build_cells(const ForceInput &in, const PeriodicCell &cell,
+                   const std::array<size_t, 3> &ncell);
+
+  /**
+   * @brief Builds the list by testing every pair.
+   * @param in Structure containing coordinates and cell info.
+   * @param cell The periodic cell of @a in.
+   * @return Void.
+   */
+  template <bool Orthogonal>
+  void build_all_pairs(const ForceInput &in, const PeriodicCell &cell);
+
+  double m_cutoff; //!< Interaction cutoff radius.
+  double m_skin;   //!< Verlet shell added to the cutoff when building.
+  bool m_valid;    //!< Whether the stored list matches a configuration.
+  size_t m_rebuilds;               //!< Number of list builds.
+  std::vector<size_t> m_offsets;   //!< Row offsets into @c m_neighbors.
+  std::vector<size_t> m_neighbors; //!< Flattened neighbor indices.
+  std::vector<double> m_ref_pos;   //!< Positions at the last build.
+  std::array<double, 9> m_ref_box; //!< Box at the last build.
+  std::vector<size_t> m_cell_head; //!< First atom in each cell.
+  std::vector<size_t> m_cell_next; //!< Next atom in the same cell.
+  bool m_partners_valid;               //!< Whether the reverse rows match.
+  std::vector<size_t> m_rev_offsets;   //!< Row offsets of the reverse rows.
+  std::vector<size_t> m_rev_neighbors; //!< First atoms of each pair.
+};
+
+} // namespace rgpot
@@ -0,0 +1,134 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Pair functionals for @c PairPotential and their default instances.
+ *
+ * Each functional only states the untruncated pair energy and its force
+ * scalar; truncation, periodicity, neighbor lists and threading come from
+ * @c PairPotential. All parameters default to reduced units.
+ */
+
+// clang-format off
+#include <cmath>
+// clang-format on
+#include "rgpot/PairPotential.hpp"
+#include "rgpot/pot_types.hpp"
+
+namespace rgpot {
+
+namespace pair {
+
+/**
+ * @brief 12-6 Lennard-Jones, U = 4 u0 ((psi/r)^12 - (psi/r)^6).
+ *
+ * Defaults match @c LJPot.
+ */
+struct LennardJones {
+  static constexpr PotType type = PotType::LJ; //!< Reported type.
+  static constexpr double default_cutoff = 15.0; //!< Cutoff of @c LJPot.
+
+  double u0 = 1.0;  //!< Well depth.
+  double psi = 1.0; //!< Distance at which the potential is zero.
+
+  /**
+   * @brief Evaluates one pair.
+   * @param r2 The squared distance.
+   * @param u Receives the pair energy.
+   * @param fs Receives @c -(dU/dr) / r.
+   * @return Void.
+   */
+  template <typename Real> void operator()(Real r2, Real &u, Real &fs) const {
+    const Real inv_r2 = Real{1} / r2;
+    const Real s2 = static_cast<Real>(psi * psi) * inv_r2;
+    const Real s6 = s2 * s2 * s2;
+    const auto c4 = static_cast<Real>(4.0 * u0);
+    u = c4 * s6 * (s6 - Real{1});
+    fs = Real{6} * c4 * s6 * (Real{2} * s6 - Real{1}) * inv_r2;
+  }
+};
+
+/**
+ * @brief Morse, U = D (exp(-2 a (r - re)) - 2 exp(-a (r - re))).
+ */
+struct Morse {
+  static constexpr PotType type = PotType::Morse; //!< Reported type.
+  static constexpr double default_cutoff = 8.0;   //!< Default cutoff.
+
+  double D = 1.0;  //!< Well depth.
+  double a = 1.0;  //!< Inverse width of the well.
+  double re = 1.0; //!< Equilibrium distance.
+
+  /**
+   * @brief Evaluates one pair.
+   * @param r2 The squared distance.
+   * @param u Receives the pair energy.
+   * @param fs Receives @c -(dU/dr) / r.
+   * @return Void.
+   */
+  template <typename Real> void operator()(Real r2, Real &u, Real &fs) const {
+    using std::exp;
+    using std::sqrt;
+    const Real r = sqrt(r2);
+    const Real e1 = exp(static_cast<Real>(-a) * (r - static_cast<Real>(re)));
+    const Real e2 = e1 * e1;
+    const auto d = static_cast<Real>(D);
+    u = d * (e2 - Real{2} * e1);
+    fs = Real{2} * static_cast<Real>(a) * d * (e2 - e1) / r;
+  }
+};
+
+/**
+ * @brief Buckingham exponential-6, U = A exp(-r / rho) - C / r^6.
+ *
+ * The dispersion term dominates at very short range, so the potential has
+ * an unphysical minimum below the barrier; configurations are expected to
+ * stay on the repulsive side of it.
+ */
+struct Buckingham {
+  static constexpr PotType type = PotType::Buckingham; //!< Reported type.
+  static constexpr double default_cutoff = 10.0;       //!< Default cutoff.
+
+  double A = 1000.0; //!< Repulsion prefactor.
+  double rho = 0.3;  //!< Repulsion decay length.
+  double C = 10.0;   //!< Dispersion coefficient.
+
+  /**
+   * @brief Evaluates one pair.
+   * @param r2 The squared distance.
+   * @param u Receives the pair energy.
+   * @param fs Receives @c -(dU/dr) / r.
+   * @return Void.
+   */
+  template <typename Real> void operator()(Real r2, Real &u, Real &fs) const {
+    using std::exp;
+    using std::sqrt;
+    const Real r = sqrt(r2);
+    const Real inv_r2 = Real{1} / r2;
+    const Real inv_r6 = inv_r2 * inv_r2 * inv_r2;
+    const Real rep = static_cast<Real>(A) * exp(-r / static_cast<Real>(rho));
+    const auto c = static_cast<Real>(C);
+    u = rep - c * inv_r6;
+    fs = rep / (static_cast<Real>(rho) * r) - Real{6} * c * inv_r6 * inv_r2;
+  }
+};
+
+} // namespace pair
+
+/**
+ * @brief Lennard-Jones built from the policies, equivalent to @c LJPot.
+ */
+using LJPairPot = PairPotential<pair::LennardJones>;
+
+/**
+ * @brief Energy-shifted Morse potential for orthogonal cells.
+ */
+using MorsePot = PairPotential<pair::Morse>;
+
+/**
+ * @brief Energy-shifted Buckingham potential for orthogonal cells.
+ */
+using BuckinghamPot = PairPotential<pair::Buckingham>;
+
+} // namespace rgpot
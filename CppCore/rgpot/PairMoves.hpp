@@ -0,0 +1,83 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Incremental energy and force updates of pair potentials.
+ *
+ * Defines @c pair_move_delta, which re-evaluates only the pairs touching a
+ * set of displaced atoms. It is shared by the pair potentials implementing
+ * @c Potential::movedImpl and works with any way of enumerating partners,
+ * the @c NeighborList of periodic cells or every atom of a cluster.
+ */
+
+// clang-format off
+#include <cstddef>
+#include <vector>
+// clang-format on
+#include "rgpot/ForceStructs.hpp"
+
+namespace rgpot {
+
+/**
+ * @brief Energy and force change of a pair potential under a local move.
+ *
+ * Every pair with at least one atom in @a moved is evaluated at its
+ * @a prev and @a next separation, and the difference is returned and
+ * applied to both atoms in @a F. Pairs of two moved atoms are counted once
+ * and repeated indices are ignored, so the cost is proportional to the
+ * number of moved atoms times their partners.
+ *
+ * @param prev Configuration before the move.
+ * @param next Configuration after the move, only @a moved atoms differ.
+ * @param moved Indices of the displaced atoms, all below @c next.nAtoms.
+ * @param n_moved Number of entries in @a moved.
+ * @param is_moved Scratch flags, resized to the atom count and left zeroed.
+ * @param F Forces of @a prev, updated to those of @a next; null skips them.
+ * @param partners Callable @c (i, visit) calling @c visit(j) for every
+ * candidate partner @c j of atom @c i.
+ * @param pair Callable @c (ri, rj, f) returning the energy of atoms at
+ * @c ri and @c rj and adding the force on the first one to @c f, which
+ * starts zeroed; pairs beyond the cutoff return zero and leave @c f.
+ * @return The energy of @a next minus the energy of @a prev.
+ */
+template <typename Partners, typename PairFn>
+double pair_move_delta(const ForceInput &prev, const ForceInput &next,
+                       const size_t *moved, size_t n_moved,
+                       std::vector<char> &is_moved, double *F,
+                       Partners &&partners, PairFn &&pair) {
+  is_moved.resize(next.nAtoms, 0);
+  for (size_t k = 0; k < n_moved; ++k) {
+    is_moved[moved[k]] = 1;
+  }
+  double delta = 0.0;
+  for (size_t k = 0; k < n_moved; ++k) {
+    const size_t i = moved[k];
+    if (is_moved[i] != 1) {
+      continue; // Repeated index
+    }
+    is_moved[i] = 2;
+    partners(i, [&](size_t j) {
+      if (is_moved[j] != 0 && j < i) {
+        return; // Counted from the other atom
+      }
+      double f_old[3]{0.0, 0.0, 0.0};
+      double f_new[3]{0.0, 0.0, 0.0};
+      delta += pair(next.pos + 3 * i, next.pos + 3 * j, f_new) -
+               pair(prev.pos + 3 * i, prev.pos + 3 * j, f_old);
+      if (F) {
+        for (size_t d = 0; d < 3; ++d) {
+          const double df = f_new[d] - f_old[d];
+          F[3 * i + d] += df;
+          F[3 * j + d] -= df;
+        }
+      }
+    });
+  }
+  for (size_t k = 0; k < n_moved; ++k) {
+    is_moved[moved[k]] = 0;
+  }
+  return delta;
+}
+
+} // namespace rgpot
@@ -0,0 +1,517 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Policy-based framework for short-ranged pair potentials.
+ *
+ * Defines the @c PairPotential template, which builds a complete potential
+ * from a pair functional and three compile-time policies: the truncation
+ * at the cutoff, the periodicity of the cell and the floating point type
+ * of the pair arithmetic. Every policy is resolved while compiling, so the
+ * pair loop carries no runtime switch and the cutoff test is a select
+ * rather than a branch.
+ *
+ * A pair functional is a small copyable struct providing
+ * @code
+ * static constexpr PotType type;        // Reported type
+ * static constexpr double default_cutoff;
+ * template <typename Real>
+ * void operator()(Real r2, Real &u, Real &fs) const;
+ * @endcode
+ * where @c u is the untruncated pair energy at the squared distance @c r2
+ * and @c fs = -(dU/dr) / r, so the force on the first atom of a pair is
+ * @c fs times their separation.
+ */
+
+// clang-format off
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+// clang-format on
+#include "rgpot/NeighborList.hpp"
+#include "rgpot/PairMoves.hpp"
+#include "rgpot/PeriodicCell.hpp"
+#include "rgpot/Potential.hpp"
+#include "rgpot/ThreadPool.hpp"
+
+namespace rgpot {
+
+/**
+ * @brief Constants of a truncation, evaluated once at the cutoff.
+ */
+struct TruncationTerms {
+  double rc;   //!< Cutoff radius.
+  double rc2;  //!< Squared cutoff radius.
+  double u_c;  //!< Pair energy at the cutoff.
+  double fs_c; //!< Force scalar at the cutoff.
+  double ron2; //!< Squared start of the switching region.
+};
+
+/**
+ * @brief Truncation policies, applied to the raw pair terms.
+ *
+ * Each policy provides @c prepare, evaluating its constants for a
+ * functional, and @c apply, correcting @c u and @c fs inside the cutoff.
+ */
+namespace truncation {
+
+/**
+ * @brief Shifts the energy to zero at the cutoff, forces are unchanged.
+ *
+ * This is the form of @c LJPot and of the eOn Lennard-Jones potential.
+ */
+struct ShiftedEnergy {
+  /**
+   * @brief Evaluates the constants of the truncation.
+   * @param fn The pair functional.
+   * @param rc The cutoff radius.
+   * @param ron Unused.
+   * @return The constants.
+   */
+  template <typename Functional>
+  static TruncationTerms prepare(const Functional &fn, double rc,
+                                 [[maybe_unused]] double ron) {
+    double u_c = 0.0, fs_c = 0.0;
+    fn(rc * rc, u_c, fs_c);
+    return {rc, rc * rc, u_c, fs_c, rc * rc};
+  }
+
+  /**
+   * @brief Truncates the raw terms of one pair.
+   * @param t The constants of @c prepare.
+   * @param r2 The squared distance, below the cutoff.
+   * @param u The pair energy, updated.
+   * @param fs The force scalar, unchanged.
+   * @return Void.
+   */
+  template <typename Real>
+  static void apply(const TruncationTerms &t, [[maybe_unused]] Real r2,
+                    Real &u, [[maybe_unused]] Real &fs) {
+    u -= static_cast<Real>(t.u_c);
+  }
+};
+
+/**
+ * @brief Shifts energy and force to zero at the cutoff.
+ *
+ * Subtracts the tangent of the energy at the cutoff, so both the energy
+ * and the force are continuous there, which conserves energy in MD.
+ */
+struct ShiftedForce {
+  /**
+   * @brief Evaluates the constants of the truncation.
+   * @param fn The pair functional.
+   * @param rc The cutoff radius.
+   * @param ron Unused.
+   * @return The constants.
+   */
+  template <typename Functional>
+  static TruncationTerms prepare(const Functional &fn, double rc,
+                                 [[maybe_unused]] double ron) {
+    return ShiftedEnergy::prepare(fn, rc, ron);
+  }
+
+  /**
+   * @brief Truncates the raw terms of one pair.
+   * @param t The constants of @c prepare.
+   * @param r2 The squared distance, below the cutoff.
+   * @param u The pair energy, updated.
+   * @param fs The force scalar, updated.
+   * @return Void.
+   */
+  template <typename Real>
+  static void apply(const TruncationTerms &t, Real r2, Real &u, Real &fs) {
+    using std::sqrt;
+    const Real r = sqrt(r2);
+    const auto rc = static_cast<Real>(t.rc);
+    const auto fc = static_cast<Real>(t.fs_c * t.rc); // -dU/dr at rc
+    u += (r - rc) * fc - static_cast<Real>(t.u_c);
+    fs -= fc / r;
+  }
+};
+
+/**
+ * @brief Multiplies the energy by a smooth switch between @c ron and @c rc.
+ *
+ * Uses the CHARMM switching function
+ * S = (rc^2 - r^2)^2 (rc^2 + 2 r^2 - 3 ron^2) / (rc^2 - ron^2)^3, which
+ * leaves the potential untouched below @c ron and takes energy and force
+ * smoothly to zero at @c rc.
+ */
+struct Switched {
+  /**
+   * @brief Evaluates the constants of the truncation.
+   * @param fn Unused.
+   * @param rc The cutoff radius.
+   * @param ron Start of the switching region, zero picks @c 0.9 * rc.
+   * @return The constants.
+   */
+  template <typename Functional>
+  static TruncationTerms prepare([[maybe_unused]] const Functional &fn,
+                                 double rc, double ron) {
+    if (ron == 0.0) {
+      ron = 0.9 * rc;
+    }
+    if (!(ron > 0.0 && ron < rc)) {
+      throw std::invalid_argument(
+          "The switching region must start inside the cutoff");
+    }
+    return {rc, rc * rc, 0.0, 0.0, ron * ron};
+  }
+
+  /**
+   * @brief Truncates the raw terms of one pair.
+   * @param t The constants of @c prepare.
+   * @param r2 The squared distance, below the cutoff.
+   * @param u The pair energy, updated.
+   * @param fs The force scalar, updated.
+   * @return Void.
+   */
+  template <typename Real>
+  static void apply(const TruncationTerms &t, Real r2, Real &u, Real &fs) {
+    const auto a = static_cast<Real>(t.rc2);
+    const auto b = static_cast<Real>(t.ron2);
+    // Clamping to ron gives S = 1 and dS = 0 without a branch
+    const Real x = r2 < b ? b : r2;
+    const Real inv = Real{1} / ((a - b) * (a - b) * (a - b));
+    const Real s = (a - x) * (a - x) * (a + Real{2} * x - Real{3} * b) * inv;
+    const Real ds_dx = Real{6} * (a - x) * (b - x) * inv;
+    fs = fs * s - Real{2} * u * ds_dx;
+    u *= s;
+  }
+};
+
+} // namespace truncation
+
+/**
+ * @brief Periodicity policies, choosing the minimum image of the loop.
+ */
+namespace periodicity {
+
+/**
+ * @brief Isolated systems, every pair is visited and the box is ignored.
+ */
+struct None {
+  static constexpr bool periodic = false;   //!< No images.
+  static constexpr bool orthogonal = false; //!< Unused.
+};
+
+/**
+ * @brief Periodic cells with vectors along the Cartesian axes.
+ */
+struct Orthogonal {
+  static constexpr bool periodic = true;   //!< Minimum images.
+  static constexpr bool orthogonal = true; //!< Diagonal cell only.
+};
+
+/**
+ * @brief General periodic cells, images found in fractional coordinates.
+ */
+struct Triclinic {
+  static constexpr bool periodic = true;    //!< Minimum images.
+  static constexpr bool orthogonal = false; //!< Any cell.
+};
+
+} // namespace periodicity
+
+/**
+ * @class PairPotential
+ * @brief Short-ranged pair potential assembled from compile-time policies.
+ * @ingroup rgpot_potentials
+ *
+ * @tparam Functional The pair functional, see the file description.
+ * @tparam Truncation One of the @c truncation policies.
+ * @tparam Periodicity One of the @c periodicity policies.
+ * @tparam Real Floating point type of the pair arithmetic; positions,
+ * minimum images and accumulated forces and energies stay in @c double.
+ *
+ * Periodic instances visit the pairs of a @c NeighborList and may split
+ * them over a @c ThreadPool like @c LJPot. Instances without periodicity
+ * test every pair and are meant for small clusters.
+ *
+ * @note The cache key only holds the @c PotType of the functional, so
+ * instances differing in their policies or parameters must not share one
+ * @c PotentialCache.
+ */
+template <typename Functional,
+          typename Truncation = truncation::ShiftedEnergy,
+          typename Periodicity = periodicity::Orthogonal,
+          typename Real = double>
+class PairPotential
+    : public Potential<
+          PairPotential<Functional, Truncation, Periodicity, Real>> {
+  using Base =
+      Potential<PairPotential<Functional, Truncation, Periodicity, Real>>;
+
+public:
+  /**
+   * @brief Constructor for PairPotential.
+   * @param fn The pair functional and its parameters.
+   * @param cutoff The interaction cutoff radius.
+   * @param switch_on Start of the switching region of
+   * @c truncation::Switched, zero picks @c 0.9 * cutoff.
+   */
+  explicit PairPotential(Functional fn = Functional{},
+                         double cutoff = Functional::default_cutoff,
+                         double switch_on = 0.0)
+      : Base(Functional::type), m_fn{fn},
+        m_terms{Truncation::prepare(m_fn, cutoff, switch_on)},
+        m_nlist(cutoff, 0.3), m_pool{ThreadPool::from_env()},
+        m_deterministic{ThreadPool::deterministic_from_env()} {}
+
+  /**
+   * @brief Computes the forces and energy for a given configuration.
+   *
+   * @warning Throws @c std::runtime_error when an orthogonal instance
+   * receives a skewed cell.
+   *
+   * @param in Structure containing coordinates and cell info.
+   * @param out Pointer to the results structure.
+   * @return Void.
+   */
+  void forceImpl(const ForceInput &in, ForceOut *out) const override {
+    const size_t N = in.nAtoms;
+    if constexpr (!Periodicity::periodic) {
+      std::fill(out->F, out->F + 3 * N, 0.0);
+      out->energy = clusterRange(in.pos, N, out->F);
+    } else {
+      const PeriodicCell cell(in.box);
+      if (Periodicity::orthogonal && !cell.orthogonal()) {
+        throw std::runtime_error(
+            "An orthogonal pair potential was given a skewed cell");
+      }
+      m_nlist.update(in);
+      if (m_pool && m_pool->size() > 1) {
+        out->energy = accumulate_pair_forces(
+            *m_pool, N, m_nlist.offsets(), m_deterministic, m_scratch, out->F,
+            [&](size_t i_begin, size_t i_end, double *F) {
+              return pairRange(i_begin, i_end, in.pos, cell, F);
+            });
+        return;
+      }
+      std::fill(out->F, out->F + 3 * N, 0.0);
+      out->energy = pairRange(0, N, in.pos, cell, out->F);
+    }
+  }
+
+  /**
+   * @brief Updates energy and forces for a move of a few atoms.
+   *
+   * Periodic instances re-evaluate the pairs of the moved atoms through
+   * the partners of the neighbor list, and decline the move when the list
+   * would need a rebuild or an orthogonal instance is given a skewed cell,
+   * which the full evaluation then reports. Isolated
+   * instances test the moved atoms against every atom. Moves of a quarter
+   * of the atoms or more are always declined.
+   *
+   * @param prev Configuration whose results are in @a out.
+   * @param next Configuration after the move.
+   * @param moved Indices of the displaced atoms.
+   * @param n_moved Number of entries in @a moved.
+   * @param out Results of @a prev, updated to those of @a next.
+   * @param with_forces Whether @c out->F has to be updated.
+   * @return True if the move was handled incrementally.
+   */
+  bool movedImpl(const ForceInput &prev, const ForceInput &next,
+                 const size_t *moved, size_t n_moved, ForceOut *out,
+                 bool with_forces) const override {
+    const size_t N = next.nAtoms;
+    if (4 * n_moved >= N) {
+      return false;
+    }
+    double *F = with_forces ? out->F : nullptr;
+    if constexpr (!Periodicity::periodic) {
+      out->energy += pair_move_delta(
+          prev, next, moved, n_moved, m_moved, F,
+          [N](size_t i, auto &&visit) {
+            for (size_t j = 0; j < N; ++j) {
+              if (j != i) {
+                visit(j);
+              }
+            }
+          },
+          [this](const double *ri, const double *rj, double *f) {
+            return pairForce(ri[0] - rj[0], ri[1] - rj[1], ri[2] - rj[2], f);
+          });
+    } else {
+      const PeriodicCell cell(next.box);
+      if ((Periodicity::orthogonal && !cell.orthogonal()) ||
+          !m_nlist.covers_move(prev, next, moved, n_moved)) {
+        return false;
+      }
+      m_nlist.index_partners();
+      out->energy += pair_move_delta(
+          prev, next, moved, n_moved, m_moved, F,
+          [this](size_t i, auto &&visit) {
+            m_nlist.for_each_partner(i, visit);
+          },
+          [&](const double *ri, const double *rj, double *f) {
+            double dx = ri[0] - rj[0];
+            double dy = ri[1] - rj[1];
+            double dz = ri[2] - rj[2];
+            cell.minimum_image<Periodicity::orthogonal>(dx, dy, dz);
+            return pairForce(dx, dy, dz, f);
+          });
+    }
+    return true;
+  }
+
+  /**
+   * @brief Evaluates the truncated terms of one pair.
+   * @param r2 The squared distance.
+   * @param u Receives the pair energy, zero beyond the cutoff.
+   * @param fs Receives @c -(dU/dr) / r, zero beyond the cutoff.
+   * @return Void.
+   */
+  void pair_terms(Real r2, Real &u, Real &fs) const {
+    m_fn(r2, u, fs);
+    Truncation::apply(m_terms, r2, u, fs);
+    const Real inside = r2 < static_cast<Real>(m_terms.rc2) ? Real{1} : Real{0};
+    u *= inside;
+    fs *= inside;
+  }
+
+  /**
+   * @brief Fetches the pair functional.
+   * @return Const reference to the functional.
+   */
+  [[nodiscard]] const Functional &functional() const { return m_fn; }
+
+  /**
+   * @brief Fetches the interaction cutoff.
+   * @return The cutoff radius.
+   */
+  [[nodiscard]] double cutoff() const { return m_terms.rc; }
+
+  /**
+   * @brief Sets the Verlet skin of the internal neighbor list.
+   * @param skin Extra shell beyond the cutoff, zero rebuilds every move.
+   * @return Void.
+   */
+  void set_neighbor_skin(double skin) { m_nlist.set_skin(skin); }
+
+  /**
+   * @brief Fetches the internal neighbor list.
+   * @return Const reference to the neighbor list.
+   */
+  [[nodiscard]] const NeighborList &neighbor_list() const { return m_nlist; }
+
+  /**
+   * @brief Runs the pair loop on a shared thread pool.
+   * @param pool The pool to use, @c nullptr restores serial execution.
+   * @param deterministic Toggle the fixed-order force reduction.
+   * @return Void.
+   */
+  void set_thread_pool(std::shared_ptr<ThreadPool> pool,
+                       bool deterministic = false) {
+    m_pool = std::move(pool);
+    m_deterministic = deterministic;
+  }
+
+private:
+  /**
+   * @brief Accumulates one pair into the force arrays.
+   * @param dx Separation along x, minimum image applied.
+   * @param dy Separation along y, minimum image applied.
+   * @param dz Separation along z, minimum image applied.
+   * @param fi Force accumulator of the first atom, added to.
+   * @param Fj Force of the second atom, subtracted from.
+   * @return The pair energy.
+   */
+  double accumulate(double dx, double dy, double dz, double *fi,
+                    double *Fj) const {
+    double f[3]{0.0, 0.0, 0.0};
+    const double u = pairForce(dx, dy, dz, f);
+    for (size_t d = 0; d < 3; ++d) {
+      fi[d] += f[d];
+      Fj[d] -= f[d];
+    }
+    return u;
+  }
+
+  /**
+   * @brief Evaluates one pair into a force accumulator.
+   * @param dx Separation along x, minimum image applied.
+   * @param dy Separation along y, minimum image applied.
+   * @param dz Separation along z, minimum image applied.
+   * @param f Force on the first atom, added to.
+   * @return The pair energy.
+   */
+  double pairForce(double dx, double dy, double dz, double *f) const {
+    Real u{0}, fs{0};
+    pair_terms(static_cast<Real>(dx * dx + dy * dy + dz * dz), u, fs);
+    const auto s = static_cast<double>(fs);
+    f[0] += s * dx;
+    f[1] += s * dy;
+    f[2] += s * dz;
+    return static_cast<double>(u);
+  }
+
+  /**
+   * @brief Accumulates the pair terms of a range of neighbor rows.
+   * @param i_begin First atom whose neighbor row is visited.
+   * @param i_end One past the last atom whose neighbor row is visited.
+   * @param R Positions of all atoms.
+   * @param cell Simulation cell.
+   * @param F Force array of all atoms, added to.
+   * @return The energy of the visited pairs.
+   */
+  double pairRange(size_t i_begin, size_t i_end, const double *R,
+                   const PeriodicCell &cell, double *F) const {
+    const auto &offsets = m_nlist.offsets();
+    const auto &neighbors = m_nlist.neighbors();
+    double energy = 0.0;
+    for (size_t i = i_begin; i < i_end; ++i) {
+      double fi[3]{0.0, 0.0, 0.0};
+      for (size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+        const size_t j = neighbors[k];
+        double dx = R[3 * i] - R[3 * j];
+        double dy = R[3 * i + 1] - R[3 * j + 1];
+        double dz = R[3 * i + 2] - R[3 * j + 2];
+        cell.minimum_image<Periodicity::orthogonal>(dx, dy, dz);
+        energy += accumulate(dx, dy, dz, fi, F + 3 * j);
+      }
+      F[3 * i] += fi[0];
+      F[3 * i + 1] += fi[1];
+      F[3 * i + 2] += fi[2];
+    }
+    return energy;
+  }
+
+  /**
+   * @brief Accumulates every pair of an isolated system.
+   * @param R Positions of all atoms.
+   * @param N Number of atoms.
+   * @param F Force array of all atoms, added to.
+   * @return The energy of all pairs.
+   */
+  double clusterRange(const double *R, size_t N, double *F) const {
+    double energy = 0.0;
+    for (size_t i = 0; i < N; ++i) {
+      double fi[3]{0.0, 0.0, 0.0};
+      for (size_t j = i + 1; j < N; ++j) {
+        energy += accumulate(R[3 * i] - R[3 * j], R[3 * i + 1] - R[3 * j + 1],
+                             R[3 * i + 2] - R[3 * j + 2], fi, F + 3 * j);
+      }
+      F[3 * i] += fi[0];
+      F[3 * i + 1] += fi[1];
+      F[3 * i + 2] += fi[2];
+    }
+    return energy;
+  }
+
+  Functional m_fn;                       //!< Pair functional.
+  TruncationTerms m_terms;               //!< Constants of the truncation.
+  mutable NeighborList m_nlist;          //!< Pair list of periodic cells.
+  std::shared_ptr<ThreadPool> m_pool;    //!< Pool for the pair loop, or null.
+  bool m_deterministic;                  //!< Fixed-order force reduction.
+  mutable std::vector<double> m_scratch; //!< Per-thread force buffers.
+  mutable std::vector<char> m_moved;     //!< Flags of the atoms of a move.
+};
+
+} // namespace rgpot
@@ -0,0 +1,57 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Implementation of the periodic cell inverse.
+ */
+
+// clang-format off
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+// clang-format on
+#include "rgpot/PeriodicCell.hpp"
+
+namespace rgpot {
+
+/**
+ * @details
+ * The inverse is the adjugate divided by the determinant. A cell counts as
+ * orthogonal when every off-diagonal element is below @c 1e-12 of the
+ * largest diagonal one, so boxes written with rounding noise keep the fast
+ * path; their inverse then holds the exact reciprocal lengths.
+ *
+ * @warning Throws @c std::invalid_argument for a singular cell.
+ */
+PeriodicCell::PeriodicCell(const double *box) : m_box{}, m_inv{} {
+  std::copy(box, box + 9, m_box.begin());
+  const auto &m = m_box;
+  const double det = m[0] * (m[4] * m[8] - m[5] * m[7]) -
+                     m[1] * (m[3] * m[8] - m[5] * m[6]) +
+                     m[2] * (m[3] * m[7] - m[4] * m[6]);
+  if (!std::isfinite(det) || det == 0.0) {
+    throw std::invalid_argument("PeriodicCell requires a non-singular box");
+  }
+  const double inv_det = 1.0 / det;
+  m_inv = {(m[4] * m[8] - m[5] * m[7]) * inv_det,
+           (m[2] * m[7] - m[1] * m[8]) * inv_det,
+           (m[1] * m[5] - m[2] * m[4]) * inv_det,
+           (m[5] * m[6] - m[3] * m[8]) * inv_det,
+           (m[0] * m[8] - m[2] * m[6]) * inv_det,
+           (m[2] * m[3] - m[0] * m[5]) * inv_det,
+           (m[3] * m[7] - m[4] * m[6]) * inv_det,
+           (m[1] * m[6] - m[0] * m[7]) * inv_det,
+           (m[0] * m[4] - m[1] * m[3]) * inv_det};
+
+  const double scale =
+      std::max({std::abs(m[0]), std::abs(m[4]), std::abs(m[8])});
+  const double tol = 1e-12 * scale;
+  m_orthogonal = std::abs(m[1]) <= tol && std::abs(m[2]) <= tol &&
+                 std::abs(m[3]) <= tol && std::abs(m[5]) <= tol &&
+                 std::abs(m[6]) <= tol && std::abs(m[7]) <= tol;
+  if (m_orthogonal) {
+    m_inv = {1.0 / m[0], 0.0, 0.0, 0.0, 1.0 / m[4], 0.0, 0.0, 0.0, 1.0 / m[8]};
+  }
+}
+
+} // namespace rgpot
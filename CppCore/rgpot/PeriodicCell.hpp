@@ -0,0 +1,179 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Periodic simulation cell with a precomputed inverse.
+ *
+ * Defines the @c PeriodicCell helper shared by the pair potentials and the
+ * neighbor list. The inverse of the cell matrix is computed once per force
+ * call, so the minimum image convention needs no division per pair. Cells
+ * whose vectors lie along the Cartesian axes take a separate orthogonal
+ * path, selected at compile time by the @c Orthogonal template argument of
+ * the hot functions.
+ */
+
+// clang-format off
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+// clang-format on
+
+namespace rgpot {
+
+/**
+ * @class PeriodicCell
+ * @brief Cell vectors, their inverse and the minimum image convention.
+ * @ingroup rgpot
+ *
+ * The box is the flat 3x3 matrix of @c ForceInput, one cell vector per
+ * row, so a Cartesian position is @c r = s * box for fractional
+ * coordinates @c s. Minimum images are taken in fractional coordinates,
+ * which finds the nearest image as long as the cutoff stays below half of
+ * the smallest @c perpendicular_width.
+ */
+class PeriodicCell {
+public:
+  /**
+   * @brief Constructor for PeriodicCell.
+   * @param box Flat 3x3 cell matrix, one cell vector per row.
+   */
+  explicit PeriodicCell(const double *box);
+
+  /**
+   * @brief Checks whether the cell vectors lie along the Cartesian axes.
+   * @return True if every off-diagonal element is negligible.
+   */
+  [[nodiscard]] bool orthogonal() const { return m_orthogonal; }
+
+  /**
+   * @brief Fetches the cell matrix.
+   * @return Flat 3x3 matrix, one cell vector per row.
+   */
+  [[nodiscard]] const std::array<double, 9> &matrix() const { return m_box; }
+
+  /**
+   * @brief Fetches the inverse of the cell matrix.
+   * @return Flat 3x3 matrix mapping Cartesian to fractional coordinates.
+   */
+  [[nodiscard]] const std::array<double, 9> &inverse() const { return m_inv; }
+
+  /**
+   * @brief Fetches the diagonal of the cell matrix.
+   * @return The box lengths of an orthogonal cell.
+   */
+  [[nodiscard]] std::array<double, 3> lengths() const {
+    return {m_box[0], m_box[4], m_box[8]};
+  }
+
+  /**
+   * @brief Fetches the diagonal of the inverse cell matrix.
+   * @return The reciprocal box lengths of an orthogonal cell.
+   */
+  [[nodiscard]] std::array<double, 3> inverse_lengths() const {
+    return {m_inv[0], m_inv[4], m_inv[8]};
+  }
+
+  /**
+   * @brief Fetches the distance between opposite faces of the cell.
+   * @param d Index of the cell vector crossing the faces.
+   * @return The width of the cell along the normal of those faces.
+   */
+  [[nodiscard]] double perpendicular_width(size_t d) const {
+    // Column d of the inverse is the face normal divided by the width
+    const double a = m_inv[d], b = m_inv[3 + d], c = m_inv[6 + d];
+    return 1.0 / std::sqrt(a * a + b * b + c * c);
+  }
+
+  /**
+   * @brief Maps a Cartesian vector to fractional coordinates.
+   * @param r The Cartesian vector.
+   * @param s Receives the fractional coordinates.
+   * @return Void.
+   */
+  template <bool Orthogonal>
+  void to_fractional(const double *r, double *s) const {
+    if constexpr (Orthogonal) {
+      s[0] = r[0] * m_inv[0];
+      s[1] = r[1] * m_inv[4];
+      s[2] = r[2] * m_inv[8];
+    } else {
+      for (size_t k = 0; k < 3; ++k) {
+        s[k] = r[0] * m_inv[k] + r[1] * m_inv[3 + k] + r[2] * m_inv[6 + k];
+      }
+    }
+  }
+
+  /**
+   * @brief Maps a Cartesian position into the cell at the origin.
+   * @param r The Cartesian position.
+   * @param w Receives the image with fractional coordinates in [0, 1).
+   * @return Void.
+   */
+  template <bool Orthogonal> void wrap(const double *r, double *w) const {
+    double s[3];
+    to_fractional<Orthogonal>(r, s);
+    for (double &sk : s) {
+      sk -= std::floor(sk);
+    }
+    if constexpr (Orthogonal) {
+      w[0] = s[0] * m_box[0];
+      w[1] = s[1] * m_box[4];
+      w[2] = s[2] * m_box[8];
+    } else {
+      for (size_t k = 0; k < 3; ++k) {
+        w[k] = s[0] * m_box[k] + s[1] * m_box[3 + k] + s[2] * m_box[6 + k];
+      }
+    }
+  }
+
+  /**
+   * @brief Replaces a separation vector by its minimum image.
+   * @param dx The x component, updated.
+   * @param dy The y component, updated.
+   * @param dz The z component, updated.
+   * @return Void.
+   */
+  template <bool Orthogonal>
+  void minimum_image(double &dx, double &dy, double &dz) const {
+    if constexpr (Orthogonal) {
+      dx -= m_box[0] * std::floor(dx * m_inv[0] + 0.5);
+      dy -= m_box[4] * std::floor(dy * m_inv[4] + 0.5);
+      dz -= m_box[8] * std::floor(dz * m_inv[8] + 0.5);
+    } else {
+      const double r[3]{dx, dy, dz};
+      double s[3];
+      to_fractional<false>(r, s);
+      for (double &sk : s) {
+        sk -= std::floor(sk + 0.5);
+      }
+      dx = s[0] * m_box[0] + s[1] * m_box[3] + s[2] * m_box[6];
+      dy = s[0] * m_box[1] + s[1] * m_box[4] + s[2] * m_box[7];
+      dz = s[0] * m_box[2] + s[1] * m_box[5] + s[2] * m_box[8];
+    }
+  }
+
+  /**
+   * @brief Runs a callable specialized for the shape of this cell.
+   *
+   * Picks the path once per call, outside of any pair loop.
+   *
+   * @param fn Callable taking @c std::true_type for orthogonal cells and
+   * @c std::false_type otherwise.
+   * @return The result of @a fn.
+   */
+  template <typename Fn> decltype(auto) dispatch(Fn &&fn) const {
+    if (m_orthogonal) {
+      return fn(std::true_type{});
+    }
+    return fn(std::false_type{});
+  }
+
+private:
+  std::array<double, 9> m_box; //!< Cell vectors as rows.
+  std::array<double, 9> m_inv; //!< Inverse of @c m_box.
+  bool m_orthogonal;           //!< Whether @c m_box is diagonal.
+};
+
+} // namespace rgpot
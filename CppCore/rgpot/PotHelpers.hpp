@@ -2,7 +2,9 @@
 // MIT License
 // Copyright 2023--present rgpot developers
 #include "ForceStructs.hpp"
+#include <atomic>
 #include <cstddef>
+#include <mutex>
 
 /**
  * @brief Utility templates and functions for potential management.
@@ -19,12 +21,16 @@ namespace rgpot {
  * @brief Static registry for instance tracking and statistics.
  *
  * The registry uses a linked list to track all active instances
- * of a derived potential class.
+ * of a derived potential class. Instances may be created and destroyed
+ * from any thread; walking the list requires holding @c mutex. Timing and
+ * cache statistics live in @c PotentialStats.
  */
 template <typename T> class registry {
 public:
-  static size_t count;      //!< Total number of active instances.
-  static size_t forceCalls; //!< Global counter for force evaluations.
+  static std::atomic<size_t> count; //!< Total number of active instances.
+  static std::atomic<size_t>
+      forceCalls; //!< Global counter for force evaluations.
+  static std::mutex mutex;  //!< Guards the instance list.
   static T *head;           //!< Pointer to the head of the linked list.
   T *prev;                  //!< Pointer to the previous instance in the list.
   T *next;                  //!< Pointer to the next instance in the list.
@@ -33,34 +39,19 @@ protected:
   /**
    * @brief Default constructor.
    */
-  registry() {
-    ++count;
-    prev = nullptr;
-    next = head;
-    head = static_cast<T *>(this);
-    if (next) {
-      next->prev = head;
-    }
-  }
+  registry() { link(); }
 
   /**
    * @brief Copy constructor.
    * @param other The instance to copy.
    */
-  registry(const registry &) {
-    ++count;
-    prev = nullptr;
-    next = head;
-    head = static_cast<T *>(this);
-    if (next) {
-      next->prev = head;
-    }
-  }
+  registry(const registry &) { link(); }
 
   /**
    * @brief Destructor.
    */
   ~registry() {
+    std::lock_guard<std::mutex> lock(mutex);
     --count;
     if (prev) {
       prev->next = next;
@@ -73,16 +64,38 @@ protected:
     }
   }
 
+private:
+  /**
+   * @brief Pushes this instance at the head of the list.
+   * @return Void.
+   */
+  void link() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++count;
+    prev = nullptr;
+    next = head;
+    head = static_cast<T *>(this);
+    if (next) {
+      next->prev = head;
+    }
+  }
+
 public:
   /**
    * @brief Increments the force call counter.
+   *
+   * Safe to call from concurrent force evaluations of separate instances.
+   *
    * @return Void.
    */
-  static void incrementForceCalls() { ++forceCalls; }
+  static void incrementForceCalls() {
+    forceCalls.fetch_add(1, std::memory_order_relaxed);
+  }
 };
 
-template <typename T> size_t registry<T>::count = 0;
-template <typename T> size_t registry<T>::forceCalls = 0;
+template <typename T> std::atomic<size_t> registry<T>::count = 0;
+template <typename T> std::atomic<size_t> registry<T>::forceCalls = 0;
+template <typename T> std::mutex registry<T>::mutex;
 template <typename T> T *registry<T>::head = nullptr;
 
 /**
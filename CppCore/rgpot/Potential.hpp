@@ -11,19 +11,21 @@
  */
 
 // clang-format off
+#include <algorithm>
+#include <chrono>
 #include <utility>
 #include <vector>
 #include <stdexcept>
 // clang-format on
 
 #ifdef RGPOT_HAS_CACHE
-#define XXH_INLINE_ALL
 #include "rgpot/PotentialCache.hpp"
-#include <xxhash.h>
 #endif
 
 #include "rgpot/ForceStructs.hpp"
 #include "rgpot/PotHelpers.hpp"
+#include "rgpot/PotentialStats.hpp"
+#include "rgpot/Trace.hpp"
 #include "rgpot/pot_types.hpp"
 #include "rgpot/types/AtomMatrix.hpp"
 
@@ -59,6 +61,88 @@ public:
   operator()(const AtomMatrix &positions, const std::vector<int> &atmtypes,
              const std::array<std::array<double, 3>, 3> &box) = 0;
 
+  /**
+   * @brief Potential and force calculation on borrowed coordinates.
+   *
+   * Same as the @c AtomMatrix overload for positions held elsewhere, e.g.
+   * a row-major Eigen or xtensor array, which are read in place.
+   *
+   * @param positions View of the atomic coordinates.
+   * @param atmtypes The atomic numbers.
+   * @param box The simulation cell vectors.
+   * @return A pair containing the energy and the force matrix.
+   */
+  std::pair<double, AtomMatrix>
+  operator()(types::ConstAtomMatrixView positions,
+             const std::vector<int> &atmtypes,
+             const std::array<std::array<double, 3>, 3> &box) {
+    AtomMatrix forces(positions.rows(), 3);
+    double flatBox[9];
+    for (size_t i = 0; i < 3; ++i) {
+      for (size_t j = 0; j < 3; ++j) {
+        flatBox[i * 3 + j] = box[i][j];
+      }
+    }
+    ForceInput fi{.nAtoms = positions.rows(),
+                  .pos = positions.data(),
+                  .atmnrs = atmtypes.data(),
+                  .box = flatBox};
+    ForceOut fo{.F = forces.data(), .energy = 0.0, .variance = 0.0};
+    compute_into(fi, fo);
+    return {fo.energy, std::move(forces)};
+  }
+
+  /**
+   * @brief Evaluates several configurations of one system in a single call.
+   * @param nconf Number of configurations.
+   * @param nAtoms Number of atoms in every configuration.
+   * @param positions Flat [nconf x nAtoms x 3] array of coordinates.
+   * @param atmtypes The atomic numbers, shared by all configurations.
+   * @param boxes Flat [nconf x 9] array of simulation cells.
+   * @param energies Output array of size @a nconf.
+   * @param forces Output flat [nconf x nAtoms x 3] array of forces.
+   * @return Void.
+   */
+  virtual void calculate_batch(size_t nconf, size_t nAtoms,
+                               const double *positions, const int *atmtypes,
+                               const double *boxes, double *energies,
+                               double *forces) = 0;
+
+  /**
+   * @brief Evaluates one configuration into caller-owned storage.
+   *
+   * Unlike @c operator(), nothing is allocated per call, so MD loops can
+   * reuse one force buffer for every step.
+   *
+   * @param fi The configuration.
+   * @param fo Receives the results, @c fo.F must hold @c fi.nAtoms * 3
+   * doubles; their previous contents are discarded.
+   * @return Void.
+   */
+  virtual void compute_into(const ForceInput &fi, ForceOut &fo) = 0;
+
+  /**
+   * @brief Updates the results of a configuration after a local move.
+   *
+   * Meant for Monte Carlo and dimer drivers displacing a few atoms at a
+   * time. Potentials that cannot update incrementally recompute @a next in
+   * full.
+   *
+   * @param prev Configuration whose results are in @a fo.
+   * @param next Configuration after the move, same atoms and box, only the
+   * atoms in @a moved differ from @a prev.
+   * @param moved Indices of the displaced atoms.
+   * @param n_moved Number of entries in @a moved.
+   * @param fo Holds the results of @a prev, receives those of @a next;
+   * @c fo.F must hold @c next.nAtoms * 3 doubles.
+   * @param with_forces Whether @c fo.F has to be updated, otherwise it
+   * holds unspecified forces on return.
+   * @return Void.
+   */
+  virtual void compute_moved(const ForceInput &prev, const ForceInput &next,
+                             const size_t *moved, size_t n_moved,
+                             ForceOut &fo, bool with_forces = true) = 0;
+
 #ifdef RGPOT_HAS_CACHE
   /**
    * @brief Sets the computation cache.
@@ -91,6 +175,7 @@ template <typename Derived>
 class Potential : public PotentialBase, public registry<Derived> {
 public:
   using PotentialBase::PotentialBase;
+  using PotentialBase::operator();
 
 #ifdef RGPOT_HAS_CACHE
   /**
@@ -105,13 +190,7 @@ public:
    * @brief Implements the potential and force calculation logic.
    *
    * This method manages the transformation of @c Eigen matrices into
-   * flat @c double arrays.
-   *
-   * # Caching Logic
-   * If @c RGPOT_HAS_CACHE is defined, the method:
-   * 1. Generates a @c XXH3_64bits hash of positions, types, and box.
-   * 2. Checks the @c rocksdb backend for a hit.
-   * 3. Returns cached values if present, otherwise computes and stores results.
+   * flat @c double arrays. Caching is handled by @c evaluate.
    *
    * @param positions The atomic coordinates.
    * @param atmtypes The atomic numbers.
@@ -139,52 +218,226 @@ public:
                   .box = flatBox};
     ForceOut fo{.F = forces.data(), .energy = energy, .variance = variance};
 
+    evaluate(fi, fo);
+    return {fo.energy, forces};
+  }
+
+  /**
+   * @brief Evaluates several configurations of one system in a single call.
+   *
+   * Configuration @c c reads @c positions[c * nAtoms * 3] and
+   * @c boxes[c * 9], and writes @c energies[c] and
+   * @c forces[c * nAtoms * 3]. Each configuration goes through the same
+   * cache lookup and force call accounting as @c operator(), without
+   * allocating intermediate matrices.
+   *
+   * The default runs the configurations in order. Implementations may
+   * override it to work on several configurations at once, using
+   * @c evaluate for the per-configuration bookkeeping.
+   *
+   * @param nconf Number of configurations.
+   * @param nAtoms Number of atoms in every configuration.
+   * @param positions Flat [nconf x nAtoms x 3] array of coordinates.
+   * @param atmtypes The atomic numbers, shared by all configurations.
+   * @param boxes Flat [nconf x 9] array of simulation cells.
+   * @param energies Output array of size @a nconf.
+   * @param forces Output flat [nconf x nAtoms x 3] array of forces.
+   * @return Void.
+   */
+  void calculate_batch(size_t nconf, size_t nAtoms, const double *positions,
+                       const int *atmtypes, const double *boxes,
+                       double *energies, double *forces) override {
+    if (nconf == 0) {
+      return;
+    }
+    if (!positions || !atmtypes || !boxes || !energies || !forces) {
+      throw std::runtime_error("calculate_batch called with a null buffer");
+    }
+    const size_t stride = nAtoms * 3;
+    for (size_t c = 0; c < nconf; ++c) {
+      ForceInput fi{.nAtoms = nAtoms,
+                    .pos = positions + c * stride,
+                    .atmnrs = atmtypes,
+                    .box = boxes + c * 9};
+      ForceOut fo{.F = forces + c * stride, .energy = 0.0, .variance = 0.0};
+      std::fill(fo.F, fo.F + stride, 0.0);
+      evaluate(fi, fo);
+      energies[c] = fo.energy;
+    }
+  }
+
+  /**
+   * @brief Evaluates one configuration into caller-owned storage.
+   *
+   * Zeroes @c fo and runs the same cache lookup and force call accounting
+   * as @c operator().
+   *
+   * @param fi The configuration.
+   * @param fo Receives the results, @c fo.F must hold @c fi.nAtoms * 3
+   * doubles.
+   * @return Void.
+   */
+  void compute_into(const ForceInput &fi, ForceOut &fo) override {
+    std::fill(fo.F, fo.F + fi.nAtoms * 3, 0.0);
+    fo.energy = 0.0;
+    fo.variance = 0.0;
+    evaluate(fi, fo);
+  }
+
+  /**
+   * @brief Updates the results of a configuration after a local move.
+   *
+   * Runs @c movedImpl when the implementation supports the move and falls
+   * back to @c compute_into otherwise. Incremental updates bypass the cache
+   * and are not counted as force calls; with @c RGPOT_HAS_TRACE they are
+   * traced as @c pot.moved. Each update rounds differently from a full
+   * evaluation, so long chains of moves should be refreshed by one now and
+   * then.
+   *
+   * @warning Throws @c std::out_of_range for an index beyond
+   * @c next.nAtoms and @c std::runtime_error for a null @a moved.
+   *
+   * @param prev Configuration whose results are in @a fo.
+   * @param next Configuration after the move.
+   * @param moved Indices of the displaced atoms.
+   * @param n_moved Number of entries in @a moved.
+   * @param fo Holds the results of @a prev, receives those of @a next.
+   * @param with_forces Whether @c fo.F has to be updated.
+   * @return Void.
+   */
+  void compute_moved(const ForceInput &prev, const ForceInput &next,
+                     const size_t *moved, size_t n_moved, ForceOut &fo,
+                     bool with_forces = true) override {
+    if (n_moved > 0 && !moved) {
+      throw std::runtime_error("compute_moved called with a null index list");
+    }
+    for (size_t k = 0; k < n_moved; ++k) {
+      if (moved[k] >= next.nAtoms) {
+        throw std::out_of_range("compute_moved index beyond the atom count");
+      }
+    }
+    bool updated = false;
+    if (prev.nAtoms == next.nAtoms) {
+      RGPOT_TRACE_SCOPE("pot.moved");
+      updated = static_cast<Derived *>(this)->movedImpl(
+          prev, next, moved, n_moved, &fo, with_forces);
+    }
+    if (!updated) {
+      compute_into(next, fo);
+    }
+  }
+
+  /**
+   * @brief Hook for incremental updates, see @c compute_moved.
+   *
+   * The default declines every move. Implementations either update
+   * @a out and return true, or leave it untouched and return false to
+   * request a full evaluation.
+   *
+   * @param prev Configuration whose results are in @a out.
+   * @param next Configuration after the move, same atom count.
+   * @param moved Indices of the displaced atoms, validated.
+   * @param n_moved Number of entries in @a moved.
+   * @param out Results of @a prev, updated to those of @a next.
+   * @param with_forces Whether @c out->F has to be updated.
+   * @return True if @a out was updated.
+   */
+  virtual bool movedImpl([[maybe_unused]] const ForceInput &prev,
+                         [[maybe_unused]] const ForceInput &next,
+                         [[maybe_unused]] const size_t *moved,
+                         [[maybe_unused]] size_t n_moved,
+                         [[maybe_unused]] ForceOut *out,
+                         [[maybe_unused]] bool with_forces) const {
+    return false;
+  }
+
+  /**
+   * @brief Abstract hook for the actual implementation.
+   * @param in Structure containing coordinates and cell info.
+   * @param out Pointer to the results structure.
+   * @return Void.
+   */
+  virtual void forceImpl(const ForceInput &in, ForceOut *out) const = 0;
+
+protected:
+  /**
+   * @brief Evaluates one configuration through the cache.
+   *
+   * # Caching Logic
+   * If @c RGPOT_HAS_CACHE is defined, the method:
+   * 1. Generates a 128-bit @c XXH3 key of positions, types, box and type.
+   * 2. Checks the memory tier and the @c rocksdb backend for a hit, then,
+   *    when quantization is enabled, stored geometries within tolerance.
+   * 3. Returns cached values if present, otherwise computes and stores results.
+   *
+   * The force call counter is only incremented when @c forceImpl runs.
+   * Cache hits and misses, and the atoms and wall time of every
+   * @c forceImpl call, are recorded in @c PotentialStats::for_type. With
+   * @c RGPOT_HAS_TRACE, the hashing, cache and force stages are traced.
+   *
+   * @param fi Structure containing coordinates and cell info.
+   * @param fo Results structure, @c fo.F must hold zeroed storage.
+   * @return Void.
+   */
+  void evaluate(const ForceInput &fi, ForceOut &fo) {
 #ifdef RGPOT_HAS_CACHE
     // Hashing
-    size_t hash_val = 0;
-    hash_val ^= XXH3_64bits(fi.pos, fi.nAtoms * 3 * sizeof(double));
-    hash_val ^= XXH3_64bits(fi.atmnrs, fi.nAtoms * sizeof(int));
-    hash_val ^= XXH3_64bits(fi.box, 9 * sizeof(double));
-    size_t type_val = static_cast<size_t>(m_type);
-    hash_val ^= XXH3_64bits(&type_val, sizeof(size_t));
-
-    rgpot::cache::KeyHash key(hash_val);
+    auto key = [&] {
+      RGPOT_TRACE_SCOPE("pot.hash");
+      return rgpot::cache::make_key(fi, static_cast<int>(m_type));
+    }();
 
     // Cache Read
     if (_cache) {
-      auto hit = _cache->find(key);
+      bool hit = false;
+      {
+        RGPOT_TRACE_SCOPE("pot.cache_lookup");
+        hit = _cache->lookup(key, fo.energy, fo.F, fi.nAtoms * 3) ||
+              _cache->lookup_near(fi, static_cast<int>(m_type), fo.energy,
+                                  fo.F);
+      }
       if (hit) {
-        _cache->deserialize_hit(*hit, fo.energy, forces);
-        return {fo.energy, forces};
+        PotentialStats::for_type(m_type).record_cache_hit();
+        return;
       }
+      PotentialStats::for_type(m_type).record_cache_miss();
     }
 
     // Computation
-    static_cast<Derived *>(this)->forceImpl(fi, &fo);
-    registry<Derived>::incrementForceCalls();
+    compute(fi, fo);
 
     // Cache Write
     if (_cache) {
-      _cache->add_serialized(key, fo.energy, forces);
+      RGPOT_TRACE_SCOPE("pot.cache_store");
+      _cache->store(key, fo.energy, fo.F, fi.nAtoms * 3);
+      _cache->index_near(fi, static_cast<int>(m_type), key);
     }
 #else
     // Fallback when caching is disabled
-    static_cast<Derived *>(this)->forceImpl(fi, &fo);
-    registry<Derived>::incrementForceCalls();
+    compute(fi, fo);
 #endif
-
-    return {fo.energy, forces};
   }
 
+private:
   /**
-   * @brief Abstract hook for the actual implementation.
-   * @param in Structure containing coordinates and cell info.
-   * @param out Pointer to the results structure.
+   * @brief Runs @c forceImpl and updates the force call statistics.
+   * @param fi Structure containing coordinates and cell info.
+   * @param fo Results structure, @c fo.F must hold zeroed storage.
    * @return Void.
    */
-  virtual void forceImpl(const ForceInput &in, ForceOut *out) const = 0;
+  void compute(const ForceInput &fi, ForceOut &fo) {
+    const auto start = std::chrono::steady_clock::now();
+    {
+      RGPOT_TRACE_SCOPE("pot.force");
+      static_cast<Derived *>(this)->forceImpl(fi, &fo);
+    }
+    const auto wall = std::chrono::steady_clock::now() - start;
+    registry<Derived>::incrementForceCalls();
+    PotentialStats::for_type(m_type).record_call(
+        fi.nAtoms,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(wall).count());
+  }
 
-private:
 #ifdef RGPOT_HAS_CACHE
   rgpot::cache::PotentialCache *_cache =
       nullptr; //!< Pointer to the optional calculation cache.
@@ -10,25 +10,267 @@
  */
 
 #include "rgpot/PotentialCache.hpp"
+#include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iostream>
+#include <numeric>
+#include <rocksdb/cache.h>
+#include <rocksdb/env.h>
+#include <rocksdb/filter_policy.h>
 #include <rocksdb/options.h>
+#include <rocksdb/sst_file_writer.h>
+#include <rocksdb/table.h>
+#include <rocksdb/write_batch.h>
+#include <stdexcept>
 #include <vector>
 
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
 namespace rgpot::cache {
 
+namespace {
+
+/**
+ * @brief Checksum of a serialized payload.
+ * @param data The payload bytes.
+ * @param size Number of bytes.
+ * @return The checksum.
+ */
+uint64_t payload_checksum(const char *data, size_t size) {
+  return XXH3_64bits(data, size);
+}
+
+/**
+ * @brief Validates a stored value of @a n force components.
+ *
+ * Accepts the plain layout, and the layout with a trailing checksum when the
+ * checksum matches.
+ *
+ * @param data The stored bytes.
+ * @param size Number of stored bytes.
+ * @param n Number of force components expected.
+ * @return Whether the value holds a usable result.
+ */
+bool valid_value(const char *data, size_t size, size_t n) {
+  const size_t payload = (n + 1) * sizeof(double);
+  if (size == payload) {
+    return true;
+  }
+  if (size != payload + sizeof(uint64_t)) {
+    return false;
+  }
+  uint64_t stored = 0;
+  std::memcpy(&stored, data + payload, sizeof(uint64_t));
+  return stored == payload_checksum(data, payload);
+}
+
+/**
+ * @brief Most candidates kept per grid cell, oldest dropped first.
+ */
+constexpr size_t max_cell_candidates = 8;
+
+/**
+ * @brief Leading byte of quantized cell keys.
+ *
+ * Makes cell records one byte longer than result keys, so the two can share
+ * a RocksDB instance without clashing.
+ */
+constexpr char cell_key_tag = 'q';
+
+/**
+ * @brief Number of doubles describing a geometry, positions then box.
+ * @param fi The configuration.
+ * @return @c fi.nAtoms * 3 + 9.
+ */
+size_t geometry_size(const ForceInput &fi) { return fi.nAtoms * 3 + 9; }
+
+/**
+ * @brief Compares a stored geometry against a configuration.
+ * @param stored Positions followed by the box, unaligned.
+ * @param fi The configuration.
+ * @param tolerance Accepted per-coordinate deviation.
+ * @return Whether every component lies within @a tolerance.
+ */
+bool within_tolerance(const char *stored, const ForceInput &fi,
+                      double tolerance) {
+  const size_t npos = fi.nAtoms * 3;
+  double value = 0.0;
+  for (size_t i = 0; i < npos + 9; ++i) {
+    std::memcpy(&value, stored + i * sizeof(double), sizeof(double));
+    const double wanted = i < npos ? fi.pos[i] : fi.box[i - npos];
+    if (!(std::abs(value - wanted) <= tolerance)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Translates the cache tuning into RocksDB options.
+ *
+ * @c PointLookup follows the RocksDB advice for point lookups: full-key
+ * bloom filters in the SST files and the memtable, a hash index inside data
+ * blocks, and index and filter blocks held in the block cache. Negative
+ * lookups, the common case of a cache, then rarely touch the disk.
+ *
+ * @param db The tuning.
+ * @return The options, without @c create_if_missing.
+ */
+rocksdb::Options make_options(const DbOptions &db) {
+  rocksdb::Options options;
+  switch (db.compression) {
+  case Compression::Default:
+    break;
+  case Compression::None:
+    options.compression = rocksdb::kNoCompression;
+    break;
+  case Compression::LZ4:
+    options.compression = rocksdb::kLZ4Compression;
+    break;
+  case Compression::ZSTD:
+    options.compression = rocksdb::kZSTD;
+    break;
+  }
+
+  if (db.profile == DbProfile::Default && db.block_cache_bytes == 0) {
+    return options;
+  }
+  rocksdb::BlockBasedTableOptions table;
+  if (db.profile == DbProfile::PointLookup) {
+    table.filter_policy.reset(
+        rocksdb::NewBloomFilterPolicy(db.bloom_bits_per_key));
+    table.whole_key_filtering = true;
+    table.data_block_index_type =
+        rocksdb::BlockBasedTableOptions::kDataBlockBinaryAndHash;
+    table.cache_index_and_filter_blocks = true;
+    table.pin_l0_filter_and_index_blocks_in_cache = true;
+    options.memtable_whole_key_filtering = true;
+    options.memtable_prefix_bloom_size_ratio = 0.02;
+  }
+  const size_t cache_bytes =
+      db.block_cache_bytes > 0 ? db.block_cache_bytes : size_t{256} << 20;
+  table.block_cache = rocksdb::NewLRUCache(cache_bytes);
+  options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(table));
+  return options;
+}
+
+/**
+ * @brief Throws for a failed RocksDB operation.
+ * @param status The operation status.
+ * @param what Description of the operation.
+ * @return Void.
+ * @throws std::runtime_error Unless @a status is ok.
+ */
+void check(const rocksdb::Status &status, const std::string &what) {
+  if (!status.ok()) {
+    throw std::runtime_error(what + ": " + status.ToString());
+  }
+}
+
+} // namespace
+
+/**
+ * @details
+ * Stores the digest in the canonical big-endian form of
+ * @c XXH128_canonical_t, so keys sort and compare the same on every host.
+ */
+KeyHash::KeyHash(uint64_t low64, uint64_t high64) : hash{low64}, key{} {
+  XXH128_hash_t digest{.low64 = low64, .high64 = high64};
+  XXH128_canonical_t canonical;
+  XXH128_canonicalFromHash(&canonical, digest);
+  std::memcpy(key.data(), canonical.digest, width);
+}
+
+KeyHash KeyHash::from_bytes(const char *bytes) {
+  XXH128_canonical_t canonical;
+  std::memcpy(canonical.digest, bytes, width);
+  XXH128_hash_t digest = XXH128_hashFromCanonical(&canonical);
+  return KeyHash(digest.low64, digest.high64);
+}
+
+/**
+ * @details
+ * The atom count is hashed first so that the boundaries between the
+ * position, atomic number and box segments are fixed by the input itself.
+ * Every field goes through the same streaming state, so unlike XOR-combined
+ * per-field digests, swapping or repeating fields changes the key.
+ */
+KeyHash make_key(const ForceInput &fi, int pot_type) {
+  XXH3_state_t state;
+  XXH3_INITSTATE(&state);
+  XXH3_128bits_reset(&state);
+  const uint64_t natoms = fi.nAtoms;
+  const int64_t type = pot_type;
+  XXH3_128bits_update(&state, &natoms, sizeof(natoms));
+  XXH3_128bits_update(&state, fi.pos, fi.nAtoms * 3 * sizeof(double));
+  XXH3_128bits_update(&state, fi.atmnrs, fi.nAtoms * sizeof(int));
+  XXH3_128bits_update(&state, fi.box, 9 * sizeof(double));
+  XXH3_128bits_update(&state, &type, sizeof(type));
+  XXH128_hash_t digest = XXH3_128bits_digest(&state);
+  return KeyHash(digest.low64, digest.high64);
+}
+
 /**
  * @details
- * Initializes the RocksDB options, specifically setting `create_if_missing`.
- * It attempts to open the database at the specified path. If the open fails,
- * an error is printed to stderr and the internal database pointer remains null.
- * If successful, the `own_db_` flag is set to true.
+ * Hashes the same fields in the same order as @c make_key, with every
+ * position and box entry replaced by the index @c llround(x / grid) of its
+ * grid point. Writing @c -0.0 or @c 0.0 makes no difference to the index.
+ */
+KeyHash make_quantized_key(const ForceInput &fi, int pot_type, double grid) {
+  XXH3_state_t state;
+  XXH3_INITSTATE(&state);
+  XXH3_128bits_reset(&state);
+  const uint64_t natoms = fi.nAtoms;
+  const int64_t type = pot_type;
+  auto update_cells = [&](const double *values, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      const int64_t cell = std::llround(values[i] / grid);
+      XXH3_128bits_update(&state, &cell, sizeof(cell));
+    }
+  };
+  XXH3_128bits_update(&state, &natoms, sizeof(natoms));
+  update_cells(fi.pos, fi.nAtoms * 3);
+  XXH3_128bits_update(&state, fi.atmnrs, fi.nAtoms * sizeof(int));
+  update_cells(fi.box, 9);
+  XXH3_128bits_update(&state, &type, sizeof(type));
+  XXH128_hash_t digest = XXH3_128bits_digest(&state);
+  return KeyHash(digest.low64, digest.high64);
+}
+
+/**
+ * @details
+ * Opens the database with default tuning and no memory tier.
  */
 PotentialCache::PotentialCache(const std::string &db_path,
-                               bool create_if_missing) {
-  rocksdb::Options options;
-  options.create_if_missing = create_if_missing;
-  rocksdb::Status status = rocksdb::DB::Open(options, db_path, &db_);
+                               bool create_if_missing)
+    : PotentialCache(db_path, DbOptions{}, TierOptions{}, create_if_missing) {}
+
+/**
+ * @details
+ * Opens the database with default tuning and installs the in-memory tier.
+ * A @c MemoryOnly tier never touches the opened database.
+ */
+PotentialCache::PotentialCache(const std::string &db_path,
+                               const TierOptions &tier,
+                               bool create_if_missing)
+    : PotentialCache(db_path, DbOptions{}, tier, create_if_missing) {}
+
+/**
+ * @details
+ * Translates the tuning into RocksDB options, specifically setting
+ * `create_if_missing`, and attempts to open the database at the specified
+ * path. If the open fails, an error is printed to stderr and the internal
+ * database pointer remains null. If successful, the `own_db_` flag is set
+ * to true.
+ */
+PotentialCache::PotentialCache(const std::string &db_path,
+                               const DbOptions &db, const TierOptions &tier,
+                               bool create_if_missing)
+    : options_(make_options(db)) {
+  options_.create_if_missing = create_if_missing;
+  rocksdb::Status status = rocksdb::DB::Open(options_, db_path, &db_);
   if (!status.ok()) {
     std::cerr << "Unable to open RocksDB at " << db_path << ": "
               << status.ToString() << std::endl;
@@ -36,14 +278,16 @@ PotentialCache::PotentialCache(const std::string &db_path,
   } else {
     own_db_ = true;
   }
+  set_memory_tier(tier);
 }
 
 /**
  * @details
- * Checks if the class owns the database pointer. If so, it deletes the
- * `rocksdb::DB` instance to prevent memory leaks.
+ * Persists pending write-back entries, then, if the class owns the database
+ * pointer, deletes the `rocksdb::DB` instance to prevent memory leaks.
  */
 PotentialCache::~PotentialCache() {
+  flush();
   if (own_db_ && db_) {
     delete db_;
   }
@@ -61,6 +305,7 @@ PotentialCache::~PotentialCache() {
  * passed pointer is managed elsewhere.
  */
 void PotentialCache::set_db(rocksdb::DB *db) {
+  flush();
   if (own_db_ && db_)
     delete db_;
   db_ = db;
@@ -77,9 +322,18 @@ void PotentialCache::set_db(rocksdb::DB *db) {
  */
 void PotentialCache::deserialize_hit(const std::string &hit, double &energy,
                                      rgpot::types::AtomMatrix &forces) {
+  deserialize_hit(hit, energy, forces.data(), forces.size());
+}
+
+/**
+ * @details
+ * Same layout as the matrix overload, writing @a n force components
+ * straight into @a forces.
+ */
+void PotentialCache::deserialize_hit(const std::string &hit, double &energy,
+                                     double *forces, size_t n) {
   std::memcpy(&energy, hit.data(), sizeof(double));
-  std::memcpy(forces.data(), hit.data() + sizeof(double),
-              forces.size() * sizeof(double));
+  std::memcpy(forces, hit.data() + sizeof(double), n * sizeof(double));
 }
 
 /**
@@ -92,20 +346,167 @@ void PotentialCache::deserialize_hit(const std::string &hit, double &energy,
  */
 void PotentialCache::add_serialized(const KeyHash &kv, double energy,
                                     const rgpot::types::AtomMatrix &forces) {
+  add_serialized(kv, energy, forces.data(), forces.size());
+}
+
+/**
+ * @details
+ * Raw buffer variant of the matrix overload, used by the batched path.
+ *
+ * @note If the database is not initialized, this function returns immediately.
+ */
+void PotentialCache::add_serialized(const KeyHash &kv, double energy,
+                                    const double *forces, size_t n) {
   if (!db_)
     return;
   // Calculate total size needed
-  size_t value_size = sizeof(double) + forces.size() * sizeof(double);
+  size_t value_size = sizeof(double) + n * sizeof(double);
   std::vector<char> buffer(value_size);
 
   // Copy energy to buffer
   std::memcpy(buffer.data(), &energy, sizeof(double));
   // Copy forces to buffer offset by sizeof(double)
-  std::memcpy(buffer.data() + sizeof(double), forces.data(),
-              forces.size() * sizeof(double));
+  std::memcpy(buffer.data() + sizeof(double), forces, n * sizeof(double));
+
+  put_raw(kv.view(), std::string_view(buffer.data(), buffer.size()));
+}
 
-  rocksdb::Slice value(buffer.data(), buffer.size());
-  db_->Put(rocksdb::WriteOptions(), kv.key, value);
+/**
+ * @details
+ * Serializes every entry as @c add_serialized does into one
+ * @c rocksdb::WriteBatch, which is applied atomically with a single
+ * write-ahead log record. The memory tier is not touched.
+ *
+ * @note If the database is not initialized, this function returns immediately.
+ */
+void PotentialCache::add_many(size_t count, const KeyHash *keys,
+                              const double *energies, const double *forces,
+                              size_t n, bool disable_wal) {
+  if (!db_ || count == 0)
+    return;
+  rocksdb::WriteBatch batch;
+  std::vector<char> buffer((n + 1) * sizeof(double));
+  std::string scratch;
+  for (size_t i = 0; i < count; ++i) {
+    std::memcpy(buffer.data(), &energies[i], sizeof(double));
+    std::memcpy(buffer.data() + sizeof(double), forces + i * n,
+                n * sizeof(double));
+    batch.Put(keys[i].slice(),
+              encode(std::string_view(buffer.data(), buffer.size()), scratch));
+  }
+  rocksdb::WriteOptions options;
+  options.disableWAL = disable_wal;
+  db_->Write(options, &batch);
+}
+
+/**
+ * @details
+ * @c rocksdb::SstFileWriter requires strictly increasing keys, so the
+ * entries are written in the order of a stable sort of their keys. Values
+ * use the layout and checksum setting of this cache.
+ */
+void PotentialCache::write_sst(const std::string &path, size_t count,
+                               const KeyHash *keys, const double *energies,
+                               const double *forces, size_t n) const {
+  if (count == 0) {
+    throw std::invalid_argument("SST files cannot be empty");
+  }
+  std::vector<size_t> order(count);
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::stable_sort(order.begin(), order.end(), [keys](size_t a, size_t b) {
+    return keys[a].view() < keys[b].view();
+  });
+
+  rocksdb::SstFileWriter writer(rocksdb::EnvOptions(), options_);
+  check(writer.Open(path), "Unable to create " + path);
+  std::vector<char> buffer((n + 1) * sizeof(double));
+  std::string scratch;
+  for (size_t k = 0; k < count; ++k) {
+    const size_t i = order[k];
+    if (k > 0 && keys[i].view() == keys[order[k - 1]].view()) {
+      continue;
+    }
+    std::memcpy(buffer.data(), &energies[i], sizeof(double));
+    std::memcpy(buffer.data() + sizeof(double), forces + i * n,
+                n * sizeof(double));
+    check(writer.Put(keys[i].slice(),
+                     encode(std::string_view(buffer.data(), buffer.size()),
+                            scratch)),
+          "Unable to write " + path);
+  }
+  check(writer.Finish(), "Unable to finish " + path);
+}
+
+/**
+ * @details
+ * Pending write-back entries are flushed first. The database iterator
+ * already returns keys in the order the writer needs, and stored values,
+ * including grid cell records, are copied verbatim.
+ */
+size_t PotentialCache::export_sst(const std::string &path) {
+  if (!db_) {
+    throw std::runtime_error("Cannot export a cache without a database");
+  }
+  flush();
+  std::unique_ptr<rocksdb::Iterator> it(
+      db_->NewIterator(rocksdb::ReadOptions()));
+  it->SeekToFirst();
+  if (!it->Valid()) {
+    check(it->status(), "Unable to read the cache");
+    return 0;
+  }
+  rocksdb::SstFileWriter writer(rocksdb::EnvOptions(), options_);
+  check(writer.Open(path), "Unable to create " + path);
+  size_t count = 0;
+  for (; it->Valid(); it->Next()) {
+    check(writer.Put(it->key(), it->value()), "Unable to write " + path);
+    ++count;
+  }
+  check(it->status(), "Unable to read the cache");
+  check(writer.Finish(), "Unable to finish " + path);
+  return count;
+}
+
+/**
+ * @details
+ * Uses @c rocksdb::DB::IngestExternalFile, which links the files into the
+ * LSM tree without passing the entries through the memtable. Ingested
+ * entries replace stored ones with the same key.
+ */
+void PotentialCache::ingest_sst(const std::vector<std::string> &paths,
+                                bool move_files) {
+  if (!db_) {
+    throw std::runtime_error("Cannot ingest into a cache without a database");
+  }
+  rocksdb::IngestExternalFileOptions options;
+  options.move_files = move_files;
+  check(db_->IngestExternalFile(paths, options), "Unable to ingest SST files");
+}
+
+void PotentialCache::put_raw(std::string_view key, std::string_view payload) {
+  if (!db_)
+    return;
+  std::string scratch;
+  db_->Put(rocksdb::WriteOptions(), rocksdb::Slice(key.data(), key.size()),
+           encode(payload, scratch));
+}
+
+/**
+ * @details
+ * With checksums enabled the value becomes
+ * `[double energy] [double force_0] ... [double force_N] [uint64 checksum]`,
+ * where the checksum is the @c XXH3_64bits digest of the preceding bytes.
+ */
+rocksdb::Slice PotentialCache::encode(std::string_view payload,
+                                      std::string &scratch) const {
+  if (!checksum_) {
+    return {payload.data(), payload.size()};
+  }
+  const uint64_t sum = payload_checksum(payload.data(), payload.size());
+  scratch.reserve(payload.size() + sizeof(sum));
+  scratch.assign(payload.data(), payload.size());
+  scratch.append(reinterpret_cast<const char *>(&sum), sizeof(sum));
+  return {scratch.data(), scratch.size()};
 }
 
 /**
@@ -119,10 +520,242 @@ std::optional<std::string> PotentialCache::find(const KeyHash &kv) {
   if (!db_)
     return std::nullopt;
   std::string value;
-  rocksdb::Status s = db_->Get(rocksdb::ReadOptions(), kv.key, &value);
+  rocksdb::Status s = db_->Get(rocksdb::ReadOptions(), kv.slice(), &value);
   if (s.ok()) {
     return value;
   }
   return std::nullopt;
 }
+
+/**
+ * @details
+ * A @c Disabled mode drops the tier. Otherwise a fresh, empty
+ * @c ShardedLRU is created with the requested budget and shard count.
+ */
+void PotentialCache::set_memory_tier(const TierOptions &tier) {
+  flush();
+  mode_ = tier.mode;
+  if (mode_ == TierMode::Disabled) {
+    tier_.reset();
+  } else {
+    tier_ = std::make_unique<ShardedLRU>(tier.capacity_bytes, tier.num_shards);
+  }
+}
+
+/**
+ * @details
+ * A memory hit only costs a shard lock and a hash probe. On a miss the
+ * value is read from RocksDB into a @c PinnableSlice, which can reference
+ * the block cache without copying, and promoted into the memory tier as a
+ * clean entry. @c MemoryOnly mode never reads RocksDB. Stored values of the
+ * wrong size or with a failing checksum count as misses.
+ */
+bool PotentialCache::lookup(const KeyHash &kv, double &energy, double *forces,
+                            size_t n) {
+  if (tier_ && tier_->get(kv.hash, kv.view(), energy, forces, n)) {
+    return true;
+  }
+  if (!db_ || mode_ == TierMode::MemoryOnly) {
+    return false;
+  }
+
+  rocksdb::PinnableSlice value;
+  rocksdb::Status s = db_->Get(rocksdb::ReadOptions(),
+                               db_->DefaultColumnFamily(), kv.slice(), &value);
+  if (!s.ok() || !valid_value(value.data(), value.size(), n)) {
+    return false;
+  }
+  std::memcpy(&energy, value.data(), sizeof(double));
+  std::memcpy(forces, value.data() + sizeof(double), n * sizeof(double));
+  if (tier_) {
+    promote(kv, energy, forces, n);
+  }
+  return true;
+}
+
+/**
+ * @details
+ * In write-back mode the clean entry may evict dirty ones, which are then
+ * written to RocksDB like those evicted by @c store.
+ */
+void PotentialCache::promote(const KeyHash &kv, double energy,
+                             const double *forces, size_t n) {
+  if (mode_ != TierMode::WriteBack) {
+    tier_->put(kv.hash, kv.view(), energy, forces, n, false, {});
+    return;
+  }
+  tier_->put(kv.hash, kv.view(), energy, forces, n, false,
+             [this](std::string_view key, std::string_view value) {
+               put_raw(key, value);
+             });
+}
+
+/**
+ * @details
+ * - @c Disabled: a synchronous RocksDB @c Put, as @c add_serialized.
+ * - @c MemoryOnly: memory tier only.
+ * - @c WriteThrough: RocksDB @c Put, then a clean memory entry.
+ * - @c WriteBack: a dirty memory entry, written to RocksDB when it is
+ *   evicted or on @c flush.
+ */
+void PotentialCache::store(const KeyHash &kv, double energy,
+                           const double *forces, size_t n) {
+  switch (mode_) {
+  case TierMode::Disabled:
+    add_serialized(kv, energy, forces, n);
+    break;
+  case TierMode::MemoryOnly:
+    tier_->put(kv.hash, kv.view(), energy, forces, n, false, {});
+    break;
+  case TierMode::WriteThrough:
+    add_serialized(kv, energy, forces, n);
+    tier_->put(kv.hash, kv.view(), energy, forces, n, false, {});
+    break;
+  case TierMode::WriteBack:
+    tier_->put(kv.hash, kv.view(), energy, forces, n, db_ != nullptr,
+               [this](std::string_view key, std::string_view value) {
+                 put_raw(key, value);
+               });
+    break;
+  }
+}
+
+/**
+ * @details
+ * Dirty entries are collected into a single @c rocksdb::WriteBatch. The
+ * tier stays populated, only the dirty flags are cleared.
+ */
+void PotentialCache::flush() {
+  if (!tier_ || mode_ != TierMode::WriteBack || !db_) {
+    return;
+  }
+  rocksdb::WriteBatch batch;
+  std::string scratch;
+  tier_->drain_dirty([&](std::string_view key, std::string_view value) {
+    batch.Put(rocksdb::Slice(key.data(), key.size()), encode(value, scratch));
+  });
+  if (batch.Count() > 0) {
+    db_->Write(rocksdb::WriteOptions(), &batch);
+  }
+}
+
+/**
+ * @details
+ * Previously indexed cells are kept, since their candidates are verified
+ * against the tolerance in force at lookup time.
+ */
+void PotentialCache::set_quantization(double grid, double tolerance) {
+  if (!(grid >= 0.0) || !(tolerance >= 0.0)) {
+    throw std::invalid_argument(
+        "Quantization grid and tolerance must be non-negative");
+  }
+  if (grid > 0.0 && tolerance > grid) {
+    throw std::invalid_argument(
+        "Quantization tolerance must not exceed the grid");
+  }
+  grid_ = grid;
+  tolerance_ = tolerance;
+}
+
+/**
+ * @details
+ * Cell records live in RocksDB next to the results, under a key of the
+ * @c cell_key_tag byte followed by the cell digest, so restarted runs find
+ * them again. Without a database, or in @c MemoryOnly mode, they are kept in
+ * process memory. The caller holds @c near_mutex_.
+ */
+bool PotentialCache::get_record(const KeyHash &cell, std::string &record) {
+  std::string key(1, cell_key_tag);
+  key.append(cell.view());
+  if (db_ && mode_ != TierMode::MemoryOnly) {
+    return db_->Get(rocksdb::ReadOptions(), key, &record).ok();
+  }
+  auto it = near_index_.find(key);
+  if (it == near_index_.end()) {
+    return false;
+  }
+  record = it->second;
+  return true;
+}
+
+void PotentialCache::put_record(const KeyHash &cell,
+                                const std::string &record) {
+  std::string key(1, cell_key_tag);
+  key.append(cell.view());
+  if (db_ && mode_ != TierMode::MemoryOnly) {
+    db_->Put(rocksdb::WriteOptions(), key, record);
+    return;
+  }
+  near_index_[key] = record;
+}
+
+/**
+ * @details
+ * A cell record is a list of candidates, each the exact result key followed
+ * by the positions and box the result was computed for. The first candidate
+ * within tolerance whose result is still stored is returned, i.e. the
+ * reported energy and forces are those of the stored geometry.
+ */
+bool PotentialCache::lookup_near(const ForceInput &fi, int pot_type,
+                                 double &energy, double *forces) {
+  if (grid_ <= 0.0) {
+    return false;
+  }
+  const KeyHash cell = make_quantized_key(fi, pot_type, grid_);
+  std::string record;
+  {
+    std::lock_guard<std::mutex> lock(near_mutex_);
+    if (!get_record(cell, record)) {
+      return false;
+    }
+  }
+  const size_t stride = KeyHash::width + geometry_size(fi) * sizeof(double);
+  for (size_t off = 0; off + stride <= record.size(); off += stride) {
+    const char *candidate = record.data() + off;
+    if (within_tolerance(candidate + KeyHash::width, fi, tolerance_) &&
+        lookup(KeyHash::from_bytes(candidate), energy, forces,
+               fi.nAtoms * 3)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @details
+ * The candidate is appended to the cell record, dropping the oldest one
+ * once @c max_cell_candidates are held. The read-modify-write of the record
+ * is serialized by @c near_mutex_ for concurrent writers of this instance.
+ */
+void PotentialCache::index_near(const ForceInput &fi, int pot_type,
+                                const KeyHash &exact) {
+  if (grid_ <= 0.0) {
+    return;
+  }
+  const KeyHash cell = make_quantized_key(fi, pot_type, grid_);
+  const size_t npos = fi.nAtoms * 3;
+  const size_t stride = KeyHash::width + geometry_size(fi) * sizeof(double);
+
+  std::string candidate(exact.view());
+  candidate.append(reinterpret_cast<const char *>(fi.pos),
+                   npos * sizeof(double));
+  candidate.append(reinterpret_cast<const char *>(fi.box), 9 * sizeof(double));
+
+  std::lock_guard<std::mutex> lock(near_mutex_);
+  std::string record;
+  if (!get_record(cell, record) || record.size() % stride != 0) {
+    record.clear();
+  }
+  for (size_t off = 0; off + stride <= record.size(); off += stride) {
+    if (record.compare(off, KeyHash::width, exact.view()) == 0) {
+      return;
+    }
+  }
+  if (record.size() / stride >= max_cell_candidates) {
+    record.erase(0, stride);
+  }
+  record.append(candidate);
+  put_record(cell, record);
+}
+
 } // namespace rgpot::cache
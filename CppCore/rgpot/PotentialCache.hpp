@@ -6,41 +6,212 @@
  * @brief Header file for the PotentialCache class.
  *
  * This file defines the caching mechanism for the rgpot library, utilizing
- * RocksDB to store and retrieve potential energy and force calculations.
+ * RocksDB to store and retrieve potential energy and force calculations,
+ * optionally behind an in-memory @c ShardedLRU tier.
  */
 
+#include "rgpot/CacheTier.hpp"
+#include "rgpot/ForceStructs.hpp"
 #include "rgpot/types/AtomMatrix.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <rocksdb/db.h>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace rgpot::cache {
 
 /**
  * @class KeyHash
- * @brief Struct to hold the hash and string key for caching.
+ * @brief Fixed-width binary cache key.
  * @ingroup rgpot_cache
+ *
+ * Holds a 128-bit digest in canonical (big-endian) byte order, which is
+ * used verbatim as the RocksDB key. The low 64 bits double as the numeric
+ * hash selecting a memory tier shard.
  */
 struct KeyHash {
-  size_t hash;     //!< The numeric hash value.
-  std::string key; //!< The string representation of the hash.
+  static constexpr size_t width = 16; //!< Key length in bytes.
+
+  size_t hash;                    //!< The low 64 bits of the digest.
+  std::array<char, width> key;    //!< The binary key.
 
   /**
    * @brief Constructor for KeyHash.
-   * @param _hash The numeric hash to wrap.
+   * @param low64 Low 64 bits of the digest.
+   * @param high64 High 64 bits of the digest.
+   */
+  KeyHash(uint64_t low64, uint64_t high64);
+
+  /**
+   * @brief Rebuilds a key from its binary form.
+   * @param bytes Pointer to @c width key bytes.
+   * @return The key.
+   */
+  static KeyHash from_bytes(const char *bytes);
+
+  /**
+   * @brief Views the key bytes.
+   * @return A view of the @c width key bytes.
+   */
+  [[nodiscard]] std::string_view view() const { return {key.data(), width}; }
+
+  /**
+   * @brief Views the key bytes as a RocksDB slice.
+   * @return A slice of the @c width key bytes.
+   */
+  [[nodiscard]] rocksdb::Slice slice() const { return {key.data(), width}; }
+};
+
+/**
+ * @brief Builds the cache key of a configuration.
+ *
+ * Feeds the atom count, positions, atomic numbers, box and potential type
+ * into one streaming @c XXH3_128bits state, so that no permutation of the
+ * inputs can cancel out.
+ *
+ * @param fi The configuration.
+ * @param pot_type Numeric potential type.
+ * @return The key.
+ */
+KeyHash make_key(const ForceInput &fi, int pot_type);
+
+/**
+ * @brief Builds the key of the grid cell holding a configuration.
+ *
+ * Like @c make_key, but positions and box entries are first rounded to the
+ * nearest multiple of @a grid, so geometries differing by much less than
+ * @a grid usually share the key.
+ *
+ * @param fi The configuration.
+ * @param pot_type Numeric potential type.
+ * @param grid The quantization step, positive.
+ * @return The key.
+ */
+KeyHash make_quantized_key(const ForceInput &fi, int pot_type, double grid);
+
+/**
+ * @brief Compression of the RocksDB data blocks.
+ * @ingroup rgpot_cache
+ */
+enum class Compression {
+  Default, //!< Keep the RocksDB default.
+  None,    //!< Store blocks uncompressed.
+  LZ4,     //!< Fast LZ4 compression.
+  ZSTD     //!< Denser, slower ZSTD compression.
+};
+
+/**
+ * @brief Named RocksDB tuning profiles.
+ * @ingroup rgpot_cache
+ */
+enum class DbProfile {
+  Default,    //!< RocksDB defaults.
+  PointLookup //!< Bloom filters, hashed block index and a large block cache.
+};
+
+/**
+ * @brief RocksDB configuration of a @c PotentialCache.
+ * @ingroup rgpot_cache
+ *
+ * Cache keys are uniformly distributed fixed-width digests that are only
+ * ever read by exact match, which is what @c DbProfile::PointLookup is
+ * tuned for.
+ */
+struct DbOptions {
+  DbProfile profile = DbProfile::Default;         //!< Base tuning.
+  size_t block_cache_bytes = 0;                   //!< Zero keeps the profile's.
+  Compression compression = Compression::Default; //!< Block compression.
+  double bloom_bits_per_key = 10.0; //!< Filter size of @c PointLookup.
+
+  /**
+   * @brief Options tuned for exact-match lookups.
+   * @param block_cache_bytes Size of the block cache.
+   * @param compression Block compression.
+   * @return The options.
    */
-  KeyHash(size_t _hash) : hash{_hash}, key(std::to_string(_hash)) {}
+  static DbOptions point_lookup(size_t block_cache_bytes = size_t{512} << 20,
+                                Compression compression = Compression::LZ4) {
+    return {.profile = DbProfile::PointLookup,
+            .block_cache_bytes = block_cache_bytes,
+            .compression = compression};
+  }
 };
 
 /**
  * @class PotentialCache
  * @brief Caches potential energy and force calculations using RocksDB.
  * @ingroup rgpot_cache
+ *
+ * @c lookup and @c store consult the in-memory tier configured with
+ * @c set_memory_tier before RocksDB. @c find and @c add_serialized always
+ * address RocksDB directly.
+ *
+ * Lookups and stores may be issued concurrently, e.g. by the worker threads
+ * of one server sharing a single instance; configuration setters may not.
  */
 class PotentialCache {
 private:
   rocksdb::DB *db_ = nullptr; //!< Pointer to the RocksDB instance.
+  rocksdb::Options options_;  //!< Options the database was opened with.
   bool own_db_ = false;       //!< Ownership flag for the DB pointer.
+  TierMode mode_ = TierMode::Disabled; //!< Interaction of the two tiers.
+  std::unique_ptr<ShardedLRU> tier_;   //!< Optional in-memory tier.
+  bool checksum_ = false; //!< Append a payload checksum on write.
+  double grid_ = 0.0;      //!< Quantization step, zero when disabled.
+  double tolerance_ = 0.0; //!< Accepted per-coordinate deviation.
+  std::mutex near_mutex_;  //!< Guards the grid cell records.
+  std::unordered_map<std::string, std::string>
+      near_index_; //!< Cell records when RocksDB is not used.
+
+  /**
+   * @brief Reads the candidate record of a grid cell, under @c near_mutex_.
+   * @param cell The quantized key.
+   * @param record Receives the record.
+   * @return Whether a record exists.
+   */
+  bool get_record(const KeyHash &cell, std::string &record);
+
+  /**
+   * @brief Writes the candidate record of a grid cell, under @c near_mutex_.
+   * @param cell The quantized key.
+   * @param record The record.
+   * @return Void.
+   */
+  void put_record(const KeyHash &cell, const std::string &record);
+
+  /**
+   * @brief Writes a serialized value to RocksDB.
+   * @param key The cache key.
+   * @param payload Serialized energy and forces.
+   * @return Void.
+   */
+  void put_raw(std::string_view key, std::string_view payload);
+
+  /**
+   * @brief Enters a RocksDB hit into the memory tier as a clean entry.
+   * @param kv The cache key.
+   * @param energy The energy.
+   * @param forces The forces.
+   * @param n Number of force components.
+   * @return Void.
+   */
+  void promote(const KeyHash &kv, double energy, const double *forces,
+               size_t n);
+
+  /**
+   * @brief Encodes a payload for storage, appending the checksum if
+   * enabled.
+   * @param payload Serialized energy and forces.
+   * @param scratch Storage for the encoded value when a checksum is added.
+   * @return The value to store, viewing @a payload or @a scratch.
+   */
+  rocksdb::Slice encode(std::string_view payload, std::string &scratch) const;
 
 public:
   /**
@@ -61,6 +232,28 @@ public:
    */
   ~PotentialCache();
 
+  /**
+   * @brief Constructor opens the DB and configures the memory tier.
+   * @param db_path Path to the RocksDB database.
+   * @param tier Configuration of the in-memory tier.
+   * @param create_if_missing Toggle creation of DB if absent.
+   */
+  PotentialCache(const std::string &db_path, const TierOptions &tier,
+                 bool create_if_missing = true);
+
+  /**
+   * @brief Constructor opens a tuned DB and configures the memory tier.
+   * @param db_path Path to the RocksDB database.
+   * @param db RocksDB tuning, e.g. @c DbOptions::point_lookup().
+   * @param tier Configuration of the in-memory tier.
+   * @param create_if_missing Toggle creation of DB if absent.
+   */
+  PotentialCache(const std::string &db_path, const DbOptions &db,
+                 const TierOptions &tier = {}, bool create_if_missing = true);
+
+  PotentialCache(const PotentialCache &) = delete;
+  PotentialCache &operator=(const PotentialCache &) = delete;
+
   /**
    * @brief Helper for manual pointer setting.
    * @param db Pointer to an existing RocksDB instance.
@@ -68,6 +261,12 @@ public:
    */
   void set_db(rocksdb::DB *db);
 
+  /**
+   * @brief Checks whether a RocksDB instance is attached.
+   * @return @c false when opening the database failed or none was set.
+   */
+  [[nodiscard]] bool is_open() const { return db_ != nullptr; }
+
   /**
    * @brief Deserializes a cache hit into output containers.
    * @param value Serialized string from the cache.
@@ -78,6 +277,17 @@ public:
   void deserialize_hit(const std::string &value, double &energy,
                        rgpot::types::AtomMatrix &forces);
 
+  /**
+   * @brief Deserializes a cache hit into a raw force buffer.
+   * @param value Serialized string from the cache.
+   * @param energy Reference to store the energy.
+   * @param forces Pointer to the force buffer.
+   * @param n Number of force components to write.
+   * @return Void.
+   */
+  void deserialize_hit(const std::string &value, double &energy,
+                       double *forces, size_t n);
+
   /**
    * @brief Adds a serialized calculation to the cache.
    * @param key Unique hash key for the configuration.
@@ -88,12 +298,191 @@ public:
   void add_serialized(const KeyHash &key, double energy,
                       const rgpot::types::AtomMatrix &forces);
 
+  /**
+   * @brief Adds a serialized calculation from a raw force buffer.
+   * @param key Unique hash key for the configuration.
+   * @param energy Calculated energy.
+   * @param forces Pointer to the calculated forces.
+   * @param n Number of force components.
+   * @return Void.
+   */
+  void add_serialized(const KeyHash &key, double energy, const double *forces,
+                      size_t n);
+
+  /**
+   * @brief Adds many calculations in one atomic @c rocksdb::WriteBatch.
+   *
+   * Entry @c i stores @c energies[i] and the @a n force components at
+   * @c forces[i * n]. Very large sets are better split over several calls,
+   * or written with @c write_sst and ingested.
+   *
+   * @param count Number of entries.
+   * @param keys The @a count keys.
+   * @param energies The @a count energies.
+   * @param forces Flat [count x n] array of forces.
+   * @param n Number of force components per entry.
+   * @param disable_wal Skip the write-ahead log, the batch is lost on a
+   * crash before the memtable is flushed.
+   * @return Void.
+   */
+  void add_many(size_t count, const KeyHash *keys, const double *energies,
+                const double *forces, size_t n, bool disable_wal = false);
+
+  /**
+   * @brief Writes entries to an SST file for @c ingest_sst.
+   *
+   * Needs no open database, so training sets can be prepared offline. The
+   * entries are sorted by key and duplicates keep their first occurrence.
+   *
+   * @param path The file to create.
+   * @param count Number of entries, at least one.
+   * @param keys The @a count keys.
+   * @param energies The @a count energies.
+   * @param forces Flat [count x n] array of forces.
+   * @param n Number of force components per entry.
+   * @return Void.
+   * @throws std::invalid_argument For an empty set.
+   * @throws std::runtime_error When the file cannot be written.
+   */
+  void write_sst(const std::string &path, size_t count, const KeyHash *keys,
+                 const double *energies, const double *forces, size_t n) const;
+
+  /**
+   * @brief Writes every stored entry to an SST file.
+   * @param path The file to create.
+   * @return Number of entries written, the file is only created if non-zero.
+   * @throws std::runtime_error Without a database or on write errors.
+   */
+  size_t export_sst(const std::string &path);
+
+  /**
+   * @brief Bulk loads SST files written by @c write_sst or @c export_sst.
+   * @param paths The files to ingest.
+   * @param move_files Move the files into the database instead of copying.
+   * @return Void.
+   * @throws std::runtime_error Without a database or when ingestion fails.
+   */
+  void ingest_sst(const std::vector<std::string> &paths,
+                  bool move_files = false);
+
   /**
    * @brief Searches the cache for a specific key.
    * @param key Unique hash key.
    * @return Optional string containing the serialized data.
    */
   std::optional<std::string> find(const KeyHash &key);
+
+  /**
+   * @brief Configures the in-memory tier, replacing any previous one.
+   *
+   * Dirty entries of a previous write-back tier are persisted first.
+   *
+   * @param tier Configuration of the in-memory tier.
+   * @return Void.
+   */
+  void set_memory_tier(const TierOptions &tier);
+
+  /**
+   * @brief Fetches the active tier mode.
+   * @return The tier mode.
+   */
+  [[nodiscard]] TierMode tier_mode() const { return mode_; }
+
+  /**
+   * @brief Fetches the in-memory tier.
+   * @return Pointer to the tier, or @c nullptr when disabled.
+   */
+  [[nodiscard]] const ShardedLRU *memory_tier() const { return tier_.get(); }
+
+  /**
+   * @brief Looks a result up in the memory tier, then in RocksDB.
+   * @param key Unique hash key for the configuration.
+   * @param energy Receives the energy on a hit.
+   * @param forces Receives @a n force components on a hit.
+   * @param n Number of force components expected.
+   * @return Whether the result was found.
+   */
+  bool lookup(const KeyHash &key, double &energy, double *forces, size_t n);
+
+  /**
+   * @brief Stores a result according to the tier mode.
+   * @param key Unique hash key for the configuration.
+   * @param energy Calculated energy.
+   * @param forces Pointer to the calculated forces.
+   * @param n Number of force components.
+   * @return Void.
+   */
+  void store(const KeyHash &key, double energy, const double *forces,
+             size_t n);
+
+  /**
+   * @brief Persists all dirty entries of a write-back tier.
+   * @return Void.
+   */
+  void flush();
+
+  /**
+   * @brief Toggles the payload checksum on newly written values.
+   *
+   * Values carrying a checksum are verified by @c lookup regardless of this
+   * setting; a mismatch is reported as a miss.
+   *
+   * @param enabled Whether to append a checksum.
+   * @return Void.
+   */
+  void set_checksum(bool enabled) { checksum_ = enabled; }
+
+  /**
+   * @brief Whether newly written values carry a checksum.
+   * @return The checksum setting.
+   */
+  [[nodiscard]] bool checksum() const { return checksum_; }
+
+  /**
+   * @brief Enables tolerance-aware lookups of near-duplicate geometries.
+   *
+   * Every stored result is also indexed under the grid cell of its
+   * geometry (@c make_quantized_key). On an exact miss, @c lookup_near
+   * checks the stored candidates of the cell and accepts one whose
+   * positions and box all lie within @a tolerance. Geometries straddling a
+   * cell boundary land in different cells and still miss, so @a grid should
+   * be much larger than the expected noise. A @a grid of zero disables the
+   * mode.
+   *
+   * @param grid Quantization step, in the units of the positions.
+   * @param tolerance Accepted per-coordinate deviation, at most @a grid.
+   * @return Void.
+   * @throws std::invalid_argument For negative values or
+   * @a tolerance > @a grid.
+   */
+  void set_quantization(double grid, double tolerance);
+
+  /**
+   * @brief Fetches the quantization step.
+   * @return The grid, zero when disabled.
+   */
+  [[nodiscard]] double quantization_grid() const { return grid_; }
+
+  /**
+   * @brief Looks up a stored result for a geometry within tolerance.
+   * @param fi The configuration.
+   * @param pot_type Numeric potential type.
+   * @param energy Receives the energy on a hit.
+   * @param forces Receives @c fi.nAtoms * 3 force components on a hit.
+   * @return Whether a matching result was found, always @c false when
+   * quantization is disabled.
+   */
+  bool lookup_near(const ForceInput &fi, int pot_type, double &energy,
+                   double *forces);
+
+  /**
+   * @brief Records a stored result in the index of its grid cell.
+   * @param fi The configuration.
+   * @param pot_type Numeric potential type.
+   * @param exact The exact key the result was stored under.
+   * @return Void.
+   */
+  void index_near(const ForceInput &fi, int pot_type, const KeyHash &exact);
 };
 
 } // namespace rgpot::cache
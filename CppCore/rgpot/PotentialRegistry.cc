@@ -0,0 +1,81 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Implementation of the potential registry and its built-in table.
+ *
+ * The built-in potentials are entered by the constructor of the global
+ * registry rather than by static registrars in their own files, so that
+ * they are available however the library is linked.
+ */
+
+#include "rgpot/PotentialRegistry.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef RGPOT_HAS_FORTRAN
+#include "rgpot/CuH2/CuH2Pot.hpp"
+#endif // RGPOT_HAS_FORTRAN
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/PairFunctionals.hpp"
+
+namespace rgpot {
+
+PotentialRegistry::PotentialRegistry() {
+  add<LJPot>("LJ", PotType::LJ);
+  add<MorsePot>("Morse", PotType::Morse);
+  add<BuckinghamPot>("Buckingham", PotType::Buckingham);
+#ifdef RGPOT_HAS_FORTRAN
+  add<CuH2Pot>("CuH2", PotType::CuH2);
+#endif // RGPOT_HAS_FORTRAN
+}
+
+PotentialRegistry &PotentialRegistry::global() {
+  static PotentialRegistry instance;
+  return instance;
+}
+
+bool PotentialRegistry::add(Entry entry) {
+  std::lock_guard lock(m_mutex);
+  std::string name = entry.name;
+  return m_entries.emplace(std::move(name), std::move(entry)).second;
+}
+
+const PotentialRegistry::Entry *
+PotentialRegistry::find(std::string_view name) const {
+  std::lock_guard lock(m_mutex);
+  const auto it = m_entries.find(name);
+  return it == m_entries.end() ? nullptr : &it->second;
+}
+
+std::unique_ptr<PotentialBase>
+PotentialRegistry::create(std::string_view name) const {
+  const Entry *entry = find(name);
+  if (!entry) {
+    throw std::invalid_argument("Unknown potential type '" +
+                                std::string(name) +
+                                "', available: " + describe());
+  }
+  return entry->create();
+}
+
+std::vector<std::string> PotentialRegistry::names() const {
+  std::lock_guard lock(m_mutex);
+  std::vector<std::string> out;
+  out.reserve(m_entries.size());
+  for (const auto &[name, entry] : m_entries) {
+    out.push_back(name);
+  }
+  return out;
+}
+
+std::string PotentialRegistry::describe() const {
+  std::string out;
+  for (const std::string &name : names()) {
+    out += out.empty() ? name : ", " + name;
+  }
+  return out;
+}
+
+} // namespace rgpot
@@ -0,0 +1,153 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Name-based factory of potential energy surfaces.
+ *
+ * The @c PotentialRegistry maps a name such as @c "LJ" to its @c PotType
+ * and a factory creating instances on demand, so that a driver names the
+ * potential it needs instead of linking a chain of constructors. Nothing
+ * is constructed until @c create is called.
+ *
+ * The potentials of the library are listed in one prebuilt table in
+ * @c PotentialRegistry.cc. Programs add their own with
+ * @c RGPOT_REGISTER_POTENTIAL in one of their translation units; a
+ * registration inside a static library only runs if its object file is
+ * linked in.
+ */
+
+// clang-format off
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+// clang-format on
+
+#include "rgpot/Potential.hpp"
+#include "rgpot/pot_types.hpp"
+
+namespace rgpot {
+
+/**
+ * @class PotentialRegistry
+ * @brief Process-wide table of the potentials a driver can create.
+ * @ingroup rgpot
+ *
+ * Entries are only ever added, so pointers returned by @c find stay valid.
+ * All members are safe to call from any thread.
+ */
+class PotentialRegistry {
+public:
+  /**
+   * @brief Creates one potential instance.
+   */
+  using Factory = std::function<std::unique_ptr<PotentialBase>()>;
+
+  /**
+   * @brief One registered potential.
+   */
+  struct Entry {
+    std::string name; //!< Name used to select it.
+    PotType type;     //!< Its type, for statistics and cache keys.
+    Factory create;   //!< Creates an instance.
+    std::function<size_t()> instances; //!< Live instances, from @c registry.
+  };
+
+  /**
+   * @brief Fetches the process-wide registry.
+   * @return The registry, holding the built-in potentials.
+   */
+  static PotentialRegistry &global();
+
+  /**
+   * @brief Registers a potential.
+   * @param entry The potential.
+   * @return False if the name was already taken, the entry is then ignored.
+   */
+  bool add(Entry entry);
+
+  /**
+   * @brief Registers a default-constructible potential class.
+   * @tparam T A @c Potential derived class.
+   * @param name Name used to select it.
+   * @param type Its type.
+   * @return False if the name was already taken.
+   */
+  template <typename T> bool add(std::string name, PotType type) {
+    return add(Entry{std::move(name), type,
+                     [] { return std::make_unique<T>(); },
+                     [] { return registry<T>::count.load(); }});
+  }
+
+  /**
+   * @brief Looks up a potential.
+   * @param name The name.
+   * @return The entry, or @c nullptr if nothing is registered under it.
+   */
+  [[nodiscard]] const Entry *find(std::string_view name) const;
+
+  /**
+   * @brief Creates an instance of a registered potential.
+   * @param name The name.
+   * @return The new instance.
+   * @throws std::invalid_argument for an unknown name, listing the known
+   * ones.
+   */
+  [[nodiscard]] std::unique_ptr<PotentialBase>
+  create(std::string_view name) const;
+
+  /**
+   * @brief Lists the registered potentials.
+   * @return Their names, sorted.
+   */
+  [[nodiscard]] std::vector<std::string> names() const;
+
+  /**
+   * @brief Joins the registered names for messages.
+   * @return The names separated by commas.
+   */
+  [[nodiscard]] std::string describe() const;
+
+private:
+  PotentialRegistry();
+
+  mutable std::mutex m_mutex; //!< Guards @c m_entries.
+  std::map<std::string, Entry, std::less<>> m_entries; //!< By name.
+};
+
+/**
+ * @brief Registers a potential class during static initialization.
+ * @tparam T A default-constructible @c Potential derived class.
+ */
+template <typename T> struct PotentialRegistrar {
+  /**
+   * @brief Adds @a T to the global registry.
+   * @param name Name used to select it.
+   * @param type Its type.
+   */
+  PotentialRegistrar(const char *name, PotType type) {
+    PotentialRegistry::global().add<T>(name, type);
+  }
+};
+
+} // namespace rgpot
+
+//! @cond
+#define RGPOT_REGISTRAR_NAME_(line) rgpot_potential_registrar_##line
+#define RGPOT_REGISTRAR_NAME(line) RGPOT_REGISTRAR_NAME_(line)
+//! @endcond
+
+/**
+ * @brief Registers @a Type under @a Name with the @c PotType @a Id.
+ *
+ * Expands to a static @c PotentialRegistrar, use it at namespace scope of
+ * a source file.
+ */
+#define RGPOT_REGISTER_POTENTIAL(Type, Name, Id)                              \
+  static const ::rgpot::PotentialRegistrar<Type> RGPOT_REGISTRAR_NAME(       \
+      __LINE__){Name, Id}
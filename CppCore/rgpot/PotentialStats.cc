@@ -0,0 +1,114 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Implementation of the per-potential evaluation statistics.
+ *
+ * Contains the process-wide table of @c PotentialStats, the shard selection
+ * and the C API declared in @c pot_stats.h.
+ */
+
+#include "rgpot/PotentialStats.hpp"
+
+namespace rgpot {
+
+namespace {
+
+/**
+ * @brief Fetches the table of statistics, indexed by potential type.
+ * @return The table, never destroyed so that threads exiting during
+ * shutdown can still record.
+ */
+std::array<PotentialStats, PotentialStats::max_pot_types> &stats_table() {
+  static auto *table =
+      new std::array<PotentialStats, PotentialStats::max_pot_types>();
+  return *table;
+}
+
+/**
+ * @brief Looks up the statistics of a numeric potential type.
+ * @param pot_type Numeric value of the @c PotType.
+ * @return The statistics, or @c nullptr when out of range.
+ */
+PotentialStats *find_stats(int32_t pot_type) {
+  if (pot_type < 0 ||
+      static_cast<size_t>(pot_type) >= PotentialStats::max_pot_types) {
+    return nullptr;
+  }
+  return &PotentialStats::for_type(static_cast<PotType>(pot_type));
+}
+
+} // namespace
+
+/**
+ * @details
+ * Types beyond @c max_pot_types share the slot of @c PotType::UNKNOWN.
+ */
+PotentialStats &PotentialStats::for_type(PotType type) {
+  const auto idx = static_cast<size_t>(type);
+  return stats_table()[idx < max_pot_types ? idx : 0];
+}
+
+/**
+ * @details
+ * Threads are dealt shards round robin on their first call, which spreads
+ * the usual handful of worker threads over distinct cache lines.
+ */
+PotentialStats::Shard &PotentialStats::shard() {
+  static std::atomic<size_t> next{0};
+  thread_local const size_t idx =
+      next.fetch_add(1, std::memory_order_relaxed) % num_shards;
+  return m_shards[idx];
+}
+
+PotStats PotentialStats::snapshot() const {
+  PotStats out{};
+  for (const Shard &s : m_shards) {
+    out.force_calls += s.force_calls.load(std::memory_order_relaxed);
+    out.cache_hits += s.cache_hits.load(std::memory_order_relaxed);
+    out.cache_misses += s.cache_misses.load(std::memory_order_relaxed);
+    out.atoms += s.atoms.load(std::memory_order_relaxed);
+    out.wall_ns += s.wall_ns.load(std::memory_order_relaxed);
+    for (size_t b = 0; b < num_buckets; ++b) {
+      out.wall_histogram[b] += s.histogram[b].load(std::memory_order_relaxed);
+    }
+  }
+  return out;
+}
+
+void PotentialStats::reset() {
+  for (Shard &s : m_shards) {
+    s.force_calls.store(0, std::memory_order_relaxed);
+    s.cache_hits.store(0, std::memory_order_relaxed);
+    s.cache_misses.store(0, std::memory_order_relaxed);
+    s.atoms.store(0, std::memory_order_relaxed);
+    s.wall_ns.store(0, std::memory_order_relaxed);
+    for (auto &h : s.histogram) {
+      h.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+} // namespace rgpot
+
+extern "C" {
+
+int32_t pot_stats_get(int32_t pot_type, PotStats *out) {
+  rgpot::PotentialStats *stats = rgpot::find_stats(pot_type);
+  if (!stats || !out) {
+    return 1;
+  }
+  *out = stats->snapshot();
+  return 0;
+}
+
+int32_t pot_stats_reset(int32_t pot_type) {
+  rgpot::PotentialStats *stats = rgpot::find_stats(pot_type);
+  if (!stats) {
+    return 1;
+  }
+  stats->reset();
+  return 0;
+}
+
+} // extern "C"
@@ -0,0 +1,126 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Low-overhead evaluation statistics for every potential type.
+ *
+ * Defines @c PotentialStats, the set of counters @c Potential::evaluate
+ * updates on every call: force calls, cache hits and misses, atoms processed
+ * and a histogram of the wall time spent in @c forceImpl. Counters are split
+ * over cache-line sized shards picked per thread, so concurrent evaluations
+ * do not contend on a single atomic.
+ */
+
+// clang-format off
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+// clang-format on
+
+#include "rgpot/pot_stats.h"
+#include "rgpot/pot_types.hpp"
+
+namespace rgpot {
+
+/**
+ * @class PotentialStats
+ * @brief Sharded, thread-safe counters of one potential type.
+ * @ingroup rgpot
+ *
+ * Writers use relaxed atomic increments on the shard of their thread;
+ * readers sum all shards, so a snapshot taken during evaluations may mix
+ * counts of calls that are still in progress.
+ */
+class PotentialStats {
+public:
+  static constexpr size_t num_buckets = POT_STATS_BUCKETS; //!< Histogram.
+  static constexpr size_t num_shards = 16;   //!< Counter shards.
+  static constexpr size_t max_pot_types = 16; //!< Slots of @c for_type.
+
+  /**
+   * @brief Fetches the statistics of a potential type.
+   * @param type The potential type.
+   * @return The process-wide counters of @a type.
+   */
+  static PotentialStats &for_type(PotType type);
+
+  /**
+   * @brief Records one evaluation of the force routine.
+   * @param n_atoms Number of atoms of the configuration.
+   * @param wall_ns Time spent in the force routine.
+   * @return Void.
+   */
+  void record_call(size_t n_atoms, uint64_t wall_ns) {
+    Shard &s = shard();
+    s.force_calls.fetch_add(1, std::memory_order_relaxed);
+    s.atoms.fetch_add(n_atoms, std::memory_order_relaxed);
+    s.wall_ns.fetch_add(wall_ns, std::memory_order_relaxed);
+    s.histogram[bucket_of(wall_ns)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Records an evaluation answered by a cache.
+   * @return Void.
+   */
+  void record_cache_hit() {
+    shard().cache_hits.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Records a cache lookup that found nothing.
+   * @return Void.
+   */
+  void record_cache_miss() {
+    shard().cache_misses.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Sums the shards into a snapshot.
+   * @return The current totals.
+   */
+  [[nodiscard]] PotStats snapshot() const;
+
+  /**
+   * @brief Clears every counter.
+   * @return Void.
+   */
+  void reset();
+
+  /**
+   * @brief Maps a wall time to its histogram bucket.
+   * @param wall_ns Time in nanoseconds.
+   * @return Index of the power-of-two bucket holding @a wall_ns.
+   */
+  static size_t bucket_of(uint64_t wall_ns) {
+    const size_t b = wall_ns ? std::bit_width(wall_ns) - 1 : 0;
+    return std::min(b, num_buckets - 1);
+  }
+
+private:
+  /**
+   * @brief Counters updated by one group of threads.
+   */
+  struct alignas(64) Shard {
+    std::atomic<uint64_t> force_calls{0};  //!< Force routine calls.
+    std::atomic<uint64_t> cache_hits{0};   //!< Cache hits.
+    std::atomic<uint64_t> cache_misses{0}; //!< Cache misses.
+    std::atomic<uint64_t> atoms{0};        //!< Atoms processed.
+    std::atomic<uint64_t> wall_ns{0};      //!< Force routine time.
+    std::array<std::atomic<uint64_t>, num_buckets>
+        histogram{}; //!< Wall time histogram.
+  };
+
+  /**
+   * @brief Fetches the shard of the calling thread.
+   * @return The shard, fixed for the lifetime of the thread.
+   */
+  Shard &shard();
+
+  std::array<Shard, num_shards> m_shards; //!< The counter shards.
+};
+
+} // namespace rgpot
@@ -0,0 +1,211 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Implementation of the fork-join thread pool.
+ *
+ * Jobs are queued in submission order. Background threads and the
+ * submitting thread claim task indices from a shared atomic counter, so a
+ * job always makes progress even when every background thread is busy with
+ * another job.
+ */
+
+#include "rgpot/ThreadPool.hpp"
+#include <cstdlib>
+#include <string>
+
+namespace rgpot {
+
+/**
+ * @details
+ * Tasks are claimed through @c next and counted through @c done. The
+ * submitting thread sleeps on @c cv until every claimed task finished.
+ * @c slots hands out the per-call worker slot indices.
+ */
+struct ThreadPool::Job {
+  const TaskFn *fn = nullptr;      //!< Callable shared by all tasks.
+  size_t ntasks = 0;               //!< Number of tasks in the job.
+  std::atomic<size_t> next{0};     //!< Next unclaimed task index.
+  std::atomic<size_t> done{0};     //!< Number of finished tasks.
+  std::atomic<size_t> slots{0};    //!< Next worker slot index.
+  std::exception_ptr error;        //!< First exception thrown by a task.
+  std::mutex mutex;                //!< Guards @c error and @c cv waits.
+  std::condition_variable cv;      //!< Signals job completion.
+};
+
+/**
+ * @details
+ * Spawns @a num_threads - 1 background threads, the calling thread of
+ * @c parallel_for being the remaining one.
+ */
+ThreadPool::ThreadPool(size_t num_threads) {
+  if (num_threads == 0) {
+    num_threads = default_num_threads();
+  }
+  m_workers.reserve(num_threads - 1);
+  for (size_t i = 1; i < num_threads; ++i) {
+    m_workers.emplace_back([this] { worker_loop(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  for (auto &worker : m_workers) {
+    worker.join();
+  }
+}
+
+/**
+ * @details
+ * Each participating thread takes one slot, then claims task indices until
+ * none remain. Exceptions are caught per task and only the first one is
+ * kept for the submitting thread to rethrow.
+ */
+void ThreadPool::run_tasks(Job &job) {
+  const size_t slot = job.slots.fetch_add(1);
+  while (true) {
+    const size_t task = job.next.fetch_add(1);
+    if (task >= job.ntasks) {
+      return;
+    }
+    try {
+      (*job.fn)(task, slot);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(job.mutex);
+      if (!job.error) {
+        job.error = std::current_exception();
+      }
+    }
+    if (job.done.fetch_add(1) + 1 == job.ntasks) {
+      std::lock_guard<std::mutex> lock(job.mutex);
+      job.cv.notify_all();
+    }
+  }
+}
+
+/**
+ * @details
+ * Background threads pick the oldest job that still has unclaimed tasks.
+ * Exhausted jobs are dropped from the queue, which guarantees a thread
+ * never joins the same job twice and keeps slot indices below @c size().
+ */
+void ThreadPool::worker_loop() {
+  while (true) {
+    std::shared_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+      if (m_jobs.empty()) {
+        return;
+      }
+      job = m_jobs.front();
+      if (job->next.load() >= job->ntasks) {
+        m_jobs.pop_front();
+        continue;
+      }
+    }
+    run_tasks(*job);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_jobs.empty() && m_jobs.front() == job) {
+      m_jobs.pop_front();
+    }
+  }
+}
+
+/**
+ * @details
+ * Runs inline without touching the queue when there is no background
+ * thread or only a single task. Otherwise the job is queued, the calling
+ * thread works on it as well, and then waits for stragglers.
+ *
+ * @warning Rethrows the first exception raised by any task after all
+ * tasks have finished.
+ */
+void ThreadPool::parallel_for(size_t ntasks, const TaskFn &fn) {
+  if (ntasks == 0) {
+    return;
+  }
+  if (m_workers.empty() || ntasks == 1) {
+    for (size_t task = 0; task < ntasks; ++task) {
+      fn(task, 0);
+    }
+    return;
+  }
+
+  auto job = std::make_shared<Job>();
+  job->fn = &fn;
+  job->ntasks = ntasks;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.push_back(job);
+  }
+  if (ntasks - 1 >= m_workers.size()) {
+    m_cv.notify_all();
+  } else {
+    for (size_t i = 0; i + 1 < ntasks; ++i) {
+      m_cv.notify_one();
+    }
+  }
+
+  run_tasks(*job);
+  {
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->cv.wait(lock, [&] { return job->done.load() == job->ntasks; });
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find(m_jobs.begin(), m_jobs.end(), job);
+    if (it != m_jobs.end()) {
+      m_jobs.erase(it);
+    }
+  }
+  if (job->error) {
+    std::rethrow_exception(job->error);
+  }
+}
+
+/**
+ * @details
+ * Parses @c RGPOT_NUM_THREADS as an unsigned integer. Zero requests one
+ * thread per hardware thread; unset or malformed values fall back to serial
+ * execution.
+ */
+size_t ThreadPool::default_num_threads() {
+  const char *env = std::getenv("RGPOT_NUM_THREADS");
+  if (!env || *env == '\0') {
+    return 1;
+  }
+  try {
+    const unsigned long value = std::stoul(env);
+    if (value == 0) {
+      return std::max(1u, std::thread::hardware_concurrency());
+    }
+    return static_cast<size_t>(value);
+  } catch (const std::exception &) {
+    return 1;
+  }
+}
+
+/**
+ * @details
+ * The pool is created on first use and shared by every caller, so several
+ * potentials in one process do not oversubscribe the machine.
+ */
+std::shared_ptr<ThreadPool> ThreadPool::from_env() {
+  static const std::shared_ptr<ThreadPool> pool = [] {
+    const size_t n = default_num_threads();
+    return n > 1 ? std::make_shared<ThreadPool>(n) : nullptr;
+  }();
+  return pool;
+}
+
+bool ThreadPool::deterministic_from_env() {
+  const char *env = std::getenv("RGPOT_DETERMINISTIC");
+  return env && *env != '\0' && std::string(env) != "0";
+}
+
+} // namespace rgpot
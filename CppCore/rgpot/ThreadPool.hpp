@@ -0,0 +1,190 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Minimal fork-join thread pool and per-thread force reduction.
+ *
+ * Defines the @c ThreadPool used by the opt-in parallel execution mode of
+ * the potentials, and @c accumulate_pair_forces, which runs a pair kernel
+ * over atom ranges into private force buffers before reducing them in a
+ * fixed order.
+ */
+
+// clang-format off
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+// clang-format on
+
+namespace rgpot {
+
+/**
+ * @class ThreadPool
+ * @brief Fork-join pool where the calling thread joins the work.
+ * @ingroup rgpot
+ *
+ * A pool of size @c n spawns @c n - 1 background threads. Concurrent and
+ * nested @c parallel_for calls are allowed, since every caller also works
+ * through its own tasks.
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief Task signature, receives the task index and a worker slot.
+   *
+   * The slot is unique among the threads running one @c parallel_for call
+   * and is always smaller than @c size().
+   */
+  using TaskFn = std::function<void(size_t task, size_t slot)>;
+
+  /**
+   * @brief Constructor for ThreadPool.
+   * @param num_threads Total threads including the caller, zero picks
+   * @c default_num_threads().
+   */
+  explicit ThreadPool(size_t num_threads = 0);
+
+  /**
+   * @brief Destructor, joins all background threads.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief Fetches the number of threads that can run tasks.
+   * @return Background threads plus the calling thread.
+   */
+  [[nodiscard]] size_t size() const { return m_workers.size() + 1; }
+
+  /**
+   * @brief Runs @a fn for every task index and waits for completion.
+   * @param ntasks Number of tasks.
+   * @param fn Callable invoked as @c fn(task, slot).
+   * @return Void.
+   */
+  void parallel_for(size_t ntasks, const TaskFn &fn);
+
+  /**
+   * @brief Reads the thread count requested by the environment.
+   * @return Value of @c RGPOT_NUM_THREADS, the hardware concurrency for
+   * zero, or one when unset.
+   */
+  static size_t default_num_threads();
+
+  /**
+   * @brief Fetches the process-wide pool requested by the environment.
+   * @return Shared pool, or @c nullptr when fewer than two threads are set.
+   */
+  static std::shared_ptr<ThreadPool> from_env();
+
+  /**
+   * @brief Reads whether the environment requests deterministic reduction.
+   * @return True if @c RGPOT_DETERMINISTIC is set to a non-zero value.
+   */
+  static bool deterministic_from_env();
+
+private:
+  struct Job; //!< Shared state of one @c parallel_for call.
+
+  /**
+   * @brief Background thread main loop.
+   * @return Void.
+   */
+  void worker_loop();
+
+  /**
+   * @brief Claims and runs tasks of a job until none are left.
+   * @param job The job to work on.
+   * @return Void.
+   */
+  static void run_tasks(Job &job);
+
+  std::vector<std::thread> m_workers;      //!< Background threads.
+  std::deque<std::shared_ptr<Job>> m_jobs; //!< Jobs with unclaimed tasks.
+  std::mutex m_mutex;                      //!< Guards @c m_jobs, @c m_stop.
+  std::condition_variable m_cv;            //!< Signals new jobs or stop.
+  bool m_stop = false;                     //!< Set on destruction.
+};
+
+/**
+ * @brief Runs a pair kernel in parallel with private force buffers.
+ *
+ * The atom range is split into chunks of roughly equal pair counts using
+ * the neighbor list row offsets. Each chunk accumulates into a private
+ * buffer through @c kernel(i_begin, i_end, F_local), which returns the
+ * chunk energy; the buffers are then summed into @a F.
+ *
+ * With @a deterministic set, there is one chunk per buffer and buffers are
+ * reduced in chunk order, so the result is bit-stable for a given pool
+ * size. Otherwise chunks are finer and land in whichever buffer belongs to
+ * the thread that claimed them.
+ *
+ * @param pool The thread pool to run on.
+ * @param nAtoms Number of atoms.
+ * @param offsets Neighbor list row offsets, used as work weights.
+ * @param deterministic Toggle the fixed summation order.
+ * @param scratch Reusable storage for the private buffers.
+ * @param F Output force array of size 3 * @a nAtoms, overwritten.
+ * @param kernel Callable @c double(size_t, size_t, double*).
+ * @return The total energy.
+ */
+template <typename Kernel>
+double accumulate_pair_forces(ThreadPool &pool, size_t nAtoms,
+                              const std::vector<size_t> &offsets,
+                              bool deterministic,
+                              std::vector<double> &scratch, double *F,
+                              Kernel &&kernel) {
+  const size_t nbuf = pool.size();
+  const size_t len = 3 * nAtoms;
+  const size_t nchunks = deterministic ? nbuf : 4 * nbuf;
+  const size_t total = offsets.empty() ? 0 : offsets[nAtoms];
+
+  std::vector<size_t> bounds(nchunks + 1, nAtoms);
+  bounds[0] = 0;
+  for (size_t c = 1; c < nchunks; ++c) {
+    const size_t target = total * c / nchunks;
+    bounds[c] = static_cast<size_t>(
+        std::lower_bound(offsets.begin(), offsets.begin() + nAtoms, target) -
+        offsets.begin());
+    bounds[c] = std::max(bounds[c], bounds[c - 1]);
+  }
+
+  scratch.assign(nbuf * len, 0.0);
+  std::vector<double> energies(nbuf, 0.0);
+  pool.parallel_for(nchunks, [&](size_t chunk, size_t slot) {
+    const size_t buf = deterministic ? chunk : slot;
+    energies[buf] +=
+        kernel(bounds[chunk], bounds[chunk + 1], scratch.data() + buf * len);
+  });
+
+  const size_t block = (len + nbuf - 1) / nbuf;
+  pool.parallel_for(nbuf, [&](size_t part, size_t) {
+    const size_t end = std::min(len, (part + 1) * block);
+    for (size_t k = part * block; k < end; ++k) {
+      double sum = 0.0;
+      for (size_t b = 0; b < nbuf; ++b) {
+        sum += scratch[b * len + k];
+      }
+      F[k] = sum;
+    }
+  });
+
+  double energy = 0.0;
+  for (double e : energies) {
+    energy += e;
+  }
+  return energy;
+}
+
+} // namespace rgpot
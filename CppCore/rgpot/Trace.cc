@@ -0,0 +1,237 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Implementation of the trace span ring buffers.
+ *
+ * Every thread owns one ring of spans and is the only writer of it. Each
+ * slot is guarded by its own sequence number, a seqlock, so a dump taken
+ * from another thread copies the slots without locking and discards the
+ * ones rewritten meanwhile. Rings are never freed, spans of finished
+ * threads stay available until @c clear.
+ */
+
+#include "rgpot/Trace.hpp"
+
+// clang-format off
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+// clang-format on
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#include "rgpot/pot_trace.h"
+
+namespace rgpot::trace {
+
+namespace {
+
+/**
+ * @brief One recorded span, every field is read concurrently by dumps.
+ */
+struct Slot {
+  std::atomic<uint64_t> seq{0}; //!< Odd while written, 2 * (index + 1) after.
+  std::atomic<const char *> name{nullptr}; //!< Stage name.
+  std::atomic<uint64_t> begin{0};          //!< Start time.
+  std::atomic<uint64_t> dur{0};            //!< Duration.
+};
+
+/**
+ * @brief Spans of one thread.
+ */
+struct Ring {
+  uint32_t tid = 0;                        //!< Trace thread id.
+  std::atomic<uint64_t> head{0};           //!< Spans ever written.
+  std::array<Slot, ring_capacity> slots{}; //!< The ring.
+};
+
+/**
+ * @brief Registry of every ring, never destroyed.
+ */
+struct Registry {
+  std::mutex mutex;          //!< Guards @c rings.
+  std::vector<Ring *> rings; //!< Rings in creation order.
+};
+
+/**
+ * @brief Fetches the registry of rings.
+ * @return The registry, leaked so that late threads can still record.
+ */
+Registry &registry() {
+  static auto *reg = new Registry();
+  return *reg;
+}
+
+/**
+ * @brief Fetches the ring of the calling thread, creating it on first use.
+ * @return The ring.
+ */
+Ring &local_ring() {
+  thread_local Ring *ring = [] {
+    auto *r = new Ring();
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    r->tid = static_cast<uint32_t>(reg.rings.size()) + 1;
+    reg.rings.push_back(r);
+    return r;
+  }();
+  return *ring;
+}
+
+/**
+ * @brief Writes a string as a JSON literal.
+ * @param os The output stream.
+ * @param s The string.
+ * @return Void.
+ */
+void write_json_string(std::ostream &os, const char *s) {
+  os << '"';
+  for (; *s; ++s) {
+    if (*s == '"' || *s == '\\') {
+      os << '\\' << *s;
+    } else if (static_cast<unsigned char>(*s) >= 0x20) {
+      os << *s;
+    }
+  }
+  os << '"';
+}
+
+} // namespace
+
+uint64_t now_ns() {
+  static const auto epoch = std::chrono::steady_clock::now();
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - epoch)
+          .count());
+}
+
+void record(const char *name, uint64_t begin_ns, uint64_t end_ns) {
+  Ring &ring = local_ring();
+  const uint64_t h = ring.head.load(std::memory_order_relaxed);
+  Slot &slot = ring.slots[h % ring_capacity];
+  slot.seq.store(2 * h + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.begin.store(begin_ns, std::memory_order_relaxed);
+  slot.dur.store(end_ns - begin_ns, std::memory_order_relaxed);
+  slot.seq.store(2 * h + 2, std::memory_order_release);
+  ring.head.store(h + 1, std::memory_order_release);
+}
+
+/**
+ * @details
+ * Timestamps are written in microseconds with nanosecond decimals, as the
+ * format expects, and every span is a complete (@c "ph":"X") event.
+ */
+size_t write_chrome_json(std::ostream &os) {
+  std::vector<Ring *> rings;
+  {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    rings = reg.rings;
+  }
+#ifndef _WIN32
+  const long pid = static_cast<long>(::getpid());
+#else
+  const long pid = 1;
+#endif
+
+  size_t written = 0;
+  os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  for (const Ring *ring : rings) {
+    const uint64_t head = ring->head.load(std::memory_order_acquire);
+    const uint64_t first = head > ring_capacity ? head - ring_capacity : 0;
+    for (uint64_t i = first; i < head; ++i) {
+      const Slot &slot = ring->slots[i % ring_capacity];
+      const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+      const char *name = slot.name.load(std::memory_order_relaxed);
+      const uint64_t begin = slot.begin.load(std::memory_order_relaxed);
+      const uint64_t dur = slot.dur.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq != 2 * i + 2 ||
+          slot.seq.load(std::memory_order_relaxed) != seq || !name) {
+        continue; // Rewritten since the head was read
+      }
+      os << (written ? ",\n" : "\n") << "{\"name\":";
+      write_json_string(os, name);
+      os << ",\"cat\":\"rgpot\",\"ph\":\"X\",\"ts\":" << begin / 1000 << '.'
+         << std::to_string(1000 + begin % 1000).substr(1)
+         << ",\"dur\":" << dur / 1000 << '.'
+         << std::to_string(1000 + dur % 1000).substr(1) << ",\"pid\":" << pid
+         << ",\"tid\":" << ring->tid << '}';
+      ++written;
+    }
+  }
+  os << "\n]}\n";
+  return written;
+}
+
+bool dump(const std::string &path) {
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+  write_chrome_json(out);
+  return static_cast<bool>(out);
+}
+
+void clear() {
+  Registry &reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  for (Ring *ring : reg.rings) {
+    for (Slot &slot : ring->slots) {
+      slot.seq.store(0, std::memory_order_relaxed);
+      slot.name.store(nullptr, std::memory_order_relaxed);
+    }
+    ring->head.store(0, std::memory_order_release);
+  }
+}
+
+bool dump_on_signal([[maybe_unused]] int signum,
+                    [[maybe_unused]] const std::string &path) {
+#ifndef _WIN32
+  sigset_t set;
+  sigemptyset(&set);
+  if (sigaddset(&set, signum) != 0 ||
+      pthread_sigmask(SIG_BLOCK, &set, nullptr) != 0) {
+    return false;
+  }
+  std::thread([set, path] {
+    for (;;) {
+      int sig = 0;
+      if (sigwait(&set, &sig) == 0) {
+        dump(path);
+      }
+    }
+  }).detach();
+  return true;
+#else
+  return false;
+#endif
+}
+
+} // namespace rgpot::trace
+
+extern "C" {
+
+int32_t pot_trace_dump(const char *path) {
+  if (!path) {
+    return 1;
+  }
+  return rgpot::trace::dump(path) ? 0 : 1;
+}
+
+void pot_trace_clear(void) { rgpot::trace::clear(); }
+
+} // extern "C"
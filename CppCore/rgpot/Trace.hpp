@@ -0,0 +1,141 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Scoped trace spans of the evaluation hot path.
+ *
+ * Defines @c rgpot::trace::Span and the @c RGPOT_TRACE_SCOPE macro placed
+ * around the stages of a request: message decoding, adapter copies, cache
+ * hashing and lookup, @c forceImpl and result encoding. Spans are kept in a
+ * lock-free ring buffer per thread and written out as Chrome trace JSON,
+ * which Perfetto and @c chrome://tracing open directly.
+ *
+ * The macro only expands to a span when @c RGPOT_HAS_TRACE is defined, so
+ * builds without tracing carry no cost; the recording and dump functions
+ * are always available.
+ */
+
+// clang-format off
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+// clang-format on
+
+namespace rgpot::trace {
+
+/**
+ * @brief Number of spans each thread keeps, older ones are overwritten.
+ */
+inline constexpr size_t ring_capacity = size_t{1} << 13;
+
+/**
+ * @brief Reads the trace clock.
+ * @return Nanoseconds since the first use of the trace clock.
+ */
+uint64_t now_ns();
+
+/**
+ * @brief Records a finished span on the calling thread.
+ * @param name Static string naming the stage, it is stored by pointer.
+ * @param begin_ns Start, from @c now_ns.
+ * @param end_ns End, from @c now_ns.
+ * @return Void.
+ */
+void record(const char *name, uint64_t begin_ns, uint64_t end_ns);
+
+/**
+ * @brief Writes every buffered span as Chrome trace JSON.
+ *
+ * Safe to call while other threads keep recording; spans overwritten
+ * during the dump are left out.
+ *
+ * @param os The output stream.
+ * @return Number of spans written.
+ */
+size_t write_chrome_json(std::ostream &os);
+
+/**
+ * @brief Writes every buffered span to a Chrome trace JSON file.
+ * @param path Destination file, replaced if it exists.
+ * @return Whether the file was written.
+ */
+bool dump(const std::string &path);
+
+/**
+ * @brief Drops every buffered span.
+ *
+ * Must not race with @c record on other threads.
+ *
+ * @return Void.
+ */
+void clear();
+
+/**
+ * @brief Dumps the spans to a file whenever a signal arrives.
+ *
+ * Blocks @a signum in the calling thread and starts a thread waiting for
+ * it, so the dump runs outside of signal context. Threads inherit the
+ * signal mask, hence this must be called before any other thread is
+ * started. Only available on POSIX systems.
+ *
+ * @param signum The signal, e.g. @c SIGUSR1.
+ * @param path Destination file, rewritten on every signal.
+ * @return Whether the handler was installed.
+ */
+bool dump_on_signal(int signum, const std::string &path);
+
+/**
+ * @class Span
+ * @brief Records the lifetime of a scope as a span.
+ * @ingroup rgpot
+ */
+class Span {
+public:
+  /**
+   * @brief Constructor for Span, starts the clock.
+   * @param name Static string naming the stage.
+   */
+  explicit Span(const char *name) : m_name(name), m_begin(now_ns()) {}
+
+  /**
+   * @brief Destructor, records the span.
+   */
+  ~Span() { record(m_name, m_begin, now_ns()); }
+
+  Span(const Span &) = delete;
+  Span &operator=(const Span &) = delete;
+
+private:
+  const char *m_name; //!< Stage name.
+  uint64_t m_begin;   //!< Start time.
+};
+
+} // namespace rgpot::trace
+
+#define RGPOT_TRACE_CONCAT_(a, b) a##b
+#define RGPOT_TRACE_CONCAT(a, b) RGPOT_TRACE_CONCAT_(a, b)
+
+#ifdef RGPOT_HAS_TRACE
+/**
+ * @brief Traces the enclosing scope under a static name.
+ */
+#define RGPOT_TRACE_SCOPE(name)                                                \
+  ::rgpot::trace::Span RGPOT_TRACE_CONCAT(rgpot_trace_span_, __LINE__) {      \
+    name                                                                       \
+  }
+/**
+ * @brief Reads the trace clock, for spans crossing scopes or threads.
+ */
+#define RGPOT_TRACE_NOW() ::rgpot::trace::now_ns()
+/**
+ * @brief Records a span from a @c RGPOT_TRACE_NOW reading until now.
+ */
+#define RGPOT_TRACE_SINCE(name, begin)                                         \
+  ::rgpot::trace::record(name, begin, ::rgpot::trace::now_ns())
+#else
+#define RGPOT_TRACE_SCOPE(name) static_cast<void>(0)
+#define RGPOT_TRACE_NOW() uint64_t{0}
+#define RGPOT_TRACE_SINCE(name, begin) static_cast<void>(begin)
+#endif // RGPOT_HAS_TRACE
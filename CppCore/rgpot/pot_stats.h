@@ -0,0 +1,58 @@
+#ifndef POT_STATS_H
+#define POT_STATS_H
+
+/**
+ * @brief C API for the per-potential evaluation statistics.
+ *
+ * This header exposes the counters collected by every potential of the
+ * library, keyed by the numeric value of @c rgpot::PotType, so that drivers
+ * in C, Fortran or Julia can monitor throughput without a profiler.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Number of buckets in the wall time histogram.
+ *
+ * Bucket @c b counts evaluations that took [2^b, 2^(b+1)) nanoseconds,
+ * bucket 0 also holds zero and the last bucket everything longer.
+ */
+#define POT_STATS_BUCKETS 40
+
+/**
+ * @brief Snapshot of the statistics of one potential type.
+ */
+typedef struct PotStats {
+  uint64_t force_calls;  /**< Evaluations that ran the force routine. */
+  uint64_t cache_hits;   /**< Evaluations answered by a cache. */
+  uint64_t cache_misses; /**< Cache lookups that fell through. */
+  uint64_t atoms;        /**< Atoms processed by the force routine. */
+  uint64_t wall_ns;      /**< Time spent in the force routine. */
+  uint64_t wall_histogram[POT_STATS_BUCKETS]; /**< Per-call wall times. */
+} PotStats;
+
+/**
+ * @brief Reads the statistics of a potential type.
+ * @param pot_type Numeric value of the @c rgpot::PotType.
+ * @param out Receives the snapshot.
+ * @return 0 on success, non-zero for an invalid type or @c NULL output.
+ */
+int32_t pot_stats_get(int32_t pot_type, PotStats *out);
+
+/**
+ * @brief Clears the statistics of a potential type.
+ * @param pot_type Numeric value of the @c rgpot::PotType.
+ * @return 0 on success, non-zero for an invalid type.
+ */
+int32_t pot_stats_reset(int32_t pot_type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // POT_STATS_H
@@ -0,0 +1,35 @@
+#ifndef POT_TRACE_H
+#define POT_TRACE_H
+
+/**
+ * @brief C API for the hot-path trace spans.
+ *
+ * Spans are only recorded by builds with @c RGPOT_HAS_TRACE; other builds
+ * write an empty trace. The output is Chrome trace JSON, readable by
+ * Perfetto.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Writes the buffered spans of every thread to a file.
+ * @param path Destination file, replaced if it exists.
+ * @return 0 on success, non-zero on a @c NULL path or write failure.
+ */
+int32_t pot_trace_dump(const char *path);
+
+/**
+ * @brief Drops the buffered spans, while no thread is recording.
+ * @return Void.
+ */
+void pot_trace_clear(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // POT_TRACE_H
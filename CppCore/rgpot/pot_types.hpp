@@ -26,7 +26,9 @@ namespace rgpot {
 enum class PotType {
   UNKNOWN = 0, //!<  The type is not defined or is invalid.
   CuH2,        //!<  Copper-Hydrogen EAM potential.
-  LJ           //!<  Standard 12-6 Lennard-Jones pairwise potential.
+  LJ,          //!<  Standard 12-6 Lennard-Jones pairwise potential.
+  Morse,       //!<  Morse pairwise potential.
+  Buckingham   //!<  Buckingham exponential-6 pairwise potential.
 };
 
 } // namespace rgpot
@@ -0,0 +1,582 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Implementation of the shared-memory transport.
+ *
+ * Every slot is laid out as its 256 byte control block, the box padded to
+ * 128 bytes, then the positions, forces and atomic numbers sized for
+ * @c max_atoms atoms. Requests are announced through the doorbell word of
+ * the header and answers through the answer word of the client's home
+ * slot; both are futex words, woken only when the other side has
+ * registered as waiting.
+ */
+
+// clang-format off
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+// clang-format on
+#include "rgpot/rpc/ShmChannel.hpp"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif // __linux__
+
+namespace rgpot::shm {
+
+namespace {
+
+constexpr uint64_t kBoxBytes = 128; //!< Box of 72 bytes, padded.
+constexpr unsigned kSpin = 4096;    //!< Polls before a futex wait.
+constexpr long kPollNs = 100'000'000; //!< Futex timeout between checks.
+
+/**
+ * @brief Lets a sibling hyperthread run during a spin.
+ * @return Void.
+ */
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+/**
+ * @brief Polls before a futex wait on this machine.
+ *
+ * Spinning only pays off when the other side runs on another core; on a
+ * single core it just delays the thread being waited for.
+ *
+ * @return @c kSpin, or zero on a single core.
+ */
+inline unsigned spin_limit() {
+  static const unsigned limit =
+      std::thread::hardware_concurrency() > 1 ? kSpin : 0;
+  return limit;
+}
+
+/**
+ * @brief Whether a slot state means the request has been answered.
+ * @param state A @c SlotState value.
+ * @return True for @c Done and @c Failed.
+ */
+inline bool answered(uint32_t state) {
+  return state == static_cast<uint32_t>(SlotState::Done) ||
+         state == static_cast<uint32_t>(SlotState::Failed);
+}
+
+/**
+ * @brief Whether a process exists.
+ * @param pid Process id.
+ * @return False only when the process is known to be gone.
+ */
+bool alive(uint32_t pid);
+
+/**
+ * @brief Sleeps while a futex word holds a value, or until the timeout.
+ * @param word The futex word, in shared memory.
+ * @param expected Value to sleep on.
+ * @return Void.
+ */
+void futex_wait(std::atomic<uint32_t> &word, uint32_t expected);
+
+/**
+ * @brief Wakes threads of any process sleeping on a futex word.
+ * @param word The futex word, in shared memory.
+ * @param count Number of threads to wake.
+ * @return Void.
+ */
+void futex_wake(std::atomic<uint32_t> &word, int count);
+
+#ifdef __linux__
+
+bool alive(uint32_t pid) {
+  return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+}
+
+void futex_wait(std::atomic<uint32_t> &word, uint32_t expected) {
+  const timespec timeout{0, kPollNs};
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT,
+            expected, &timeout, nullptr, 0);
+}
+
+void futex_wake(std::atomic<uint32_t> &word, int count) {
+  ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE,
+            count, nullptr, nullptr, 0);
+}
+
+/**
+ * @brief Checks a segment name and adds the leading slash.
+ * @param name Object name as given by the user.
+ * @return The name to pass to @c shm_open.
+ */
+std::string object_name(const std::string &name) {
+  if (name.empty() || name.size() > 200 ||
+      name.find('/') != std::string::npos) {
+    throw std::invalid_argument("Invalid shared memory name '" + name +
+                                "', expected 1-200 characters without '/'");
+  }
+  return "/" + name;
+}
+
+/**
+ * @brief Maps a shared memory object.
+ * @param fd Open descriptor of the object, closed here.
+ * @param bytes Length to map.
+ * @param what Context for the error message.
+ * @return The mapping.
+ */
+void *map_fd(int fd, size_t bytes, const std::string &what) {
+  void *base =
+      ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  const int err = errno;
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    throw std::runtime_error("mmap of " + what + ": " + std::strerror(err));
+  }
+  return base;
+}
+
+#else
+
+bool alive(uint32_t) { return true; }
+void futex_wait(std::atomic<uint32_t> &, uint32_t) {}
+void futex_wake(std::atomic<uint32_t> &, int) {}
+
+#endif // __linux__
+
+} // namespace
+
+std::optional<std::string> parse_address(const char *address) {
+  constexpr char scheme[] = "shm://";
+  if (!address || std::strncmp(address, scheme, sizeof(scheme) - 1) != 0) {
+    return std::nullopt;
+  }
+  return std::string(address + sizeof(scheme) - 1);
+}
+
+uint64_t Segment::slot_bytes(uint64_t max_atoms) {
+  const uint64_t bytes = sizeof(SlotHeader) + kBoxBytes +
+                         max_atoms * (6 * sizeof(double) + sizeof(int32_t));
+  return (bytes + 63) / 64 * 64;
+}
+
+double *Segment::box(uint32_t i) const {
+  return reinterpret_cast<double *>(slot_base(i) + sizeof(SlotHeader));
+}
+
+double *Segment::positions(uint32_t i) const {
+  return reinterpret_cast<double *>(slot_base(i) + sizeof(SlotHeader) +
+                                    kBoxBytes);
+}
+
+double *Segment::forces(uint32_t i) const {
+  return positions(i) + 3 * max_atoms();
+}
+
+int32_t *Segment::atmnrs(uint32_t i) const {
+  return reinterpret_cast<int32_t *>(forces(i) + 3 * max_atoms());
+}
+
+#ifdef __linux__
+
+/**
+ * @details
+ * A stale object of a server that did not exit cleanly is unlinked first,
+ * clients still mapping it notice that its server is gone. The header is
+ * completed before the magic is published, so @c open never sees a
+ * partial layout.
+ */
+Segment Segment::create(const std::string &name, uint32_t nslots,
+                        uint64_t max_atoms) {
+  const std::string object = object_name(name);
+  if (nslots == 0 || max_atoms == 0) {
+    throw std::invalid_argument("A shared memory segment needs slots");
+  }
+  const size_t bytes = sizeof(SegmentHeader) + nslots * slot_bytes(max_atoms);
+  ::shm_unlink(object.c_str());
+  const int fd =
+      ::shm_open(object.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (fd < 0) {
+    throw std::runtime_error("shm_open of " + object + ": " +
+                             std::strerror(errno));
+  }
+  if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+    const int err = errno;
+    ::close(fd);
+    ::shm_unlink(object.c_str());
+    throw std::runtime_error("ftruncate of " + object + ": " +
+                             std::strerror(err));
+  }
+  void *base = nullptr;
+  try {
+    base = map_fd(fd, bytes, object);
+  } catch (...) {
+    ::shm_unlink(object.c_str());
+    throw;
+  }
+
+  // The object is zero filled, which is a free idle slot
+  auto *hdr = new (base) SegmentHeader{};
+  hdr->version = kVersion;
+  hdr->nslots = nslots;
+  hdr->max_atoms = max_atoms;
+  hdr->slot_bytes = slot_bytes(max_atoms);
+  hdr->server_pid = static_cast<uint32_t>(::getpid());
+  Segment segment(object, base, bytes, true);
+  for (uint32_t i = 0; i < nslots; ++i) {
+    new (&segment.slot(i)) SlotHeader{};
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+  hdr->magic = kMagic;
+  return segment;
+}
+
+Segment Segment::open(const std::string &name) {
+  const std::string object = object_name(name);
+  const int fd = ::shm_open(object.c_str(), O_RDWR, 0);
+  if (fd < 0) {
+    throw std::runtime_error("No potserv serves shared memory " + object +
+                             ": " + std::strerror(errno));
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(SegmentHeader)) {
+    ::close(fd);
+    throw std::runtime_error("Shared memory " + object +
+                             " is not an rgpot segment");
+  }
+  const auto bytes = static_cast<size_t>(st.st_size);
+  Segment segment(object, map_fd(fd, bytes, object), bytes, false);
+  const SegmentHeader &hdr = segment.header();
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (hdr.magic != kMagic || hdr.version != kVersion ||
+      hdr.slot_bytes != slot_bytes(hdr.max_atoms) ||
+      bytes < sizeof(SegmentHeader) + hdr.nslots * hdr.slot_bytes) {
+    throw std::runtime_error("Shared memory " + object +
+                             " has an unknown layout");
+  }
+  return segment;
+}
+
+Segment::~Segment() {
+  if (!m_base) {
+    return;
+  }
+  ::munmap(m_base, m_bytes);
+  if (m_owner) {
+    ::shm_unlink(m_name.c_str());
+  }
+}
+
+#else
+
+Segment Segment::create(const std::string &, uint32_t, uint64_t) {
+  throw std::runtime_error("The shared memory transport requires Linux");
+}
+
+Segment Segment::open(const std::string &) {
+  throw std::runtime_error("The shared memory transport requires Linux");
+}
+
+Segment::~Segment() = default;
+
+#endif // __linux__
+
+Segment::Segment(Segment &&other) noexcept
+    : m_name(std::move(other.m_name)), m_base(other.m_base),
+      m_bytes(other.m_bytes), m_owner(other.m_owner) {
+  other.m_base = nullptr;
+  other.m_owner = false;
+}
+
+// ---------------------------------------------------------------------------
+// Server
+// ---------------------------------------------------------------------------
+
+Server::Server(const std::string &name, uint32_t nslots, uint64_t max_atoms)
+    : m_segment(Segment::create(name, nslots, max_atoms)) {}
+
+/**
+ * @details
+ * The doorbell is read before every scan: a request written after the
+ * scan changes it, so the futex wait returns at once instead of missing
+ * the request. The timeout only bounds how long @c stop takes.
+ */
+void Server::serve(const Handler &handler) {
+  SegmentHeader &hdr = m_segment.header();
+  unsigned idle = 0;
+  while (!m_stop.load(std::memory_order_acquire)) {
+    const uint32_t bell = hdr.doorbell.load(std::memory_order_seq_cst);
+    if (take(handler)) {
+      idle = 0;
+    } else if (idle < spin_limit()) {
+      ++idle;
+      cpu_relax();
+    } else {
+      hdr.sleepers.fetch_add(1, std::memory_order_seq_cst);
+      futex_wait(hdr.doorbell, bell);
+      hdr.sleepers.fetch_sub(1, std::memory_order_seq_cst);
+      idle = 0;
+    }
+  }
+}
+
+void Server::stop() {
+  m_stop.store(true, std::memory_order_release);
+  SegmentHeader &hdr = m_segment.header();
+  hdr.doorbell.fetch_add(1, std::memory_order_seq_cst);
+  futex_wake(hdr.doorbell, INT_MAX);
+}
+
+/**
+ * @details
+ * Scans start at a rotating slot so that no client is favored, and a
+ * request is taken by moving its slot from @c Request to @c Busy, which
+ * only one of the serving threads can do. The answer is announced on the
+ * home slot of the client, so that it wakes whichever of its slots it
+ * waits on.
+ */
+bool Server::take(const Handler &handler) {
+  const uint32_t n = m_segment.nslots();
+  const uint32_t start = m_next.fetch_add(1, std::memory_order_relaxed);
+  for (uint32_t k = 0; k < n; ++k) {
+    const uint32_t i = (start + k) % n;
+    SlotHeader &slot = m_segment.slot(i);
+    auto expected = static_cast<uint32_t>(SlotState::Request);
+    if (slot.state.load(std::memory_order_relaxed) != expected ||
+        !slot.state.compare_exchange_strong(
+            expected, static_cast<uint32_t>(SlotState::Busy),
+            std::memory_order_acquire)) {
+      continue;
+    }
+
+    auto outcome = SlotState::Done;
+    try {
+      if (slot.natoms > m_segment.max_atoms()) {
+        throw std::runtime_error("Request exceeds the slot capacity");
+      }
+      const Call call{slot.natoms,         m_segment.positions(i),
+                      m_segment.atmnrs(i), m_segment.box(i),
+                      m_segment.forces(i), &slot.energy};
+      handler(call);
+    } catch (const std::exception &e) {
+      std::strncpy(slot.error, e.what(), sizeof(slot.error) - 1);
+      slot.error[sizeof(slot.error) - 1] = '\0';
+      outcome = SlotState::Failed;
+    } catch (...) {
+      std::strncpy(slot.error, "Unknown exception in worker",
+                   sizeof(slot.error));
+      outcome = SlotState::Failed;
+    }
+    slot.state.store(static_cast<uint32_t>(outcome),
+                     std::memory_order_seq_cst);
+    SlotHeader &home = m_segment.slot(slot.home < n ? slot.home : i);
+    home.answers.fetch_add(1, std::memory_order_seq_cst);
+    if (home.waiting.load(std::memory_order_seq_cst) != 0) {
+      futex_wake(home.answers, INT_MAX);
+    }
+    return true;
+  }
+  return false;
+}
+
+// ---------------------------------------------------------------------------
+// Client
+// ---------------------------------------------------------------------------
+
+#ifdef __linux__
+Client::Client(const std::string &name)
+    : m_segment(Segment::open(name)),
+      m_pid(static_cast<uint32_t>(::getpid())) {
+  check_server();
+}
+#else
+Client::Client(const std::string &name)
+    : m_segment(Segment::open(name)), m_pid(0) {}
+#endif // __linux__
+
+/**
+ * @details
+ * A slot still in flight is waited for, since the server writes into it
+ * and the next owner would read that answer as its own.
+ */
+Client::~Client() {
+  for (uint32_t slot : m_held) {
+    const uint32_t state =
+        m_segment.slot(slot).state.load(std::memory_order_acquire);
+    if (state == static_cast<uint32_t>(SlotState::Request) ||
+        state == static_cast<uint32_t>(SlotState::Busy)) {
+      try {
+        wait(slot);
+      } catch (...) {
+        continue; // The server is gone, leave the slot claimed
+      }
+    }
+    m_segment.slot(slot).state.store(static_cast<uint32_t>(SlotState::Idle),
+                                     std::memory_order_relaxed);
+    m_segment.slot(slot).owner.store(0, std::memory_order_release);
+  }
+}
+
+/**
+ * @details
+ * Free slots are taken first. When none is left, slots of clients that
+ * exited without releasing them are taken over, unless a request of theirs
+ * is still being answered.
+ */
+std::optional<uint32_t> Client::acquire() {
+  if (!m_free.empty()) {
+    const uint32_t slot = m_free.back();
+    m_free.pop_back();
+    return slot;
+  }
+  const uint32_t n = m_segment.nslots();
+  for (int pass = 0; pass < 2; ++pass) {
+    for (uint32_t i = 0; i < n; ++i) {
+      SlotHeader &slot = m_segment.slot(i);
+      uint32_t owner = slot.owner.load(std::memory_order_relaxed);
+      const bool orphan = owner != 0 && owner != m_pid && !alive(owner);
+      if (pass == 0 ? owner != 0 : !orphan) {
+        continue;
+      }
+      if (orphan) {
+        const uint32_t state = slot.state.load(std::memory_order_acquire);
+        if (state == static_cast<uint32_t>(SlotState::Request) ||
+            state == static_cast<uint32_t>(SlotState::Busy)) {
+          continue;
+        }
+      }
+      if (slot.owner.compare_exchange_strong(owner, m_pid,
+                                             std::memory_order_acquire)) {
+        // Published to the server by the release of the first request
+        slot.home = m_held.empty() ? i : m_held.front();
+        slot.waiting.store(0, std::memory_order_relaxed);
+        slot.state.store(static_cast<uint32_t>(SlotState::Idle),
+                         std::memory_order_relaxed);
+        m_held.push_back(i);
+        return i;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+void Client::release(uint32_t slot) { m_free.push_back(slot); }
+
+/**
+ * @details
+ * The inputs are copied into the slot once; the server reads them and
+ * writes the forces there, so no further copy happens until @c collect.
+ * The doorbell is rung with a system call only when a server thread
+ * sleeps, which a spinning server never does.
+ */
+void Client::submit(uint32_t slot, size_t natoms, const double *pos,
+                    const int32_t *atmnrs, const double *box) {
+  if (natoms > m_segment.max_atoms()) {
+    throw std::runtime_error(
+        "System of " + std::to_string(natoms) +
+        " atoms exceeds the shared memory slot capacity of " +
+        std::to_string(m_segment.max_atoms()) +
+        "; start potserv with a larger --shm-atoms");
+  }
+  SlotHeader &hdr = m_segment.slot(slot);
+  hdr.natoms = natoms;
+  hdr.error[0] = '\0';
+  std::copy_n(box, 9, m_segment.box(slot));
+  std::copy_n(pos, natoms * 3, m_segment.positions(slot));
+  std::copy_n(atmnrs, natoms, m_segment.atmnrs(slot));
+  hdr.state.store(static_cast<uint32_t>(SlotState::Request),
+                  std::memory_order_release);
+
+  SegmentHeader &seg = m_segment.header();
+  seg.doorbell.fetch_add(1, std::memory_order_seq_cst);
+  if (seg.sleepers.load(std::memory_order_seq_cst) != 0) {
+    futex_wake(seg.doorbell, 1);
+  }
+}
+
+bool Client::ready(uint32_t slot) const {
+  return answered(
+      m_segment.slot(slot).state.load(std::memory_order_acquire));
+}
+
+void Client::wait(uint32_t slot) const { wait_any({slot}); }
+
+/**
+ * @details
+ * Spins over all listed slots first. Afterwards it sleeps on the answer
+ * word of the home slot, which every answer to this client changes, so
+ * any of the slots wakes it at once. The word is read before the slots
+ * are checked: an answer arriving in between changes it, and the futex
+ * wait returns immediately instead of missing that answer. A wait that
+ * times out checks that the server still runs.
+ */
+size_t Client::wait_any(const std::vector<uint32_t> &slots) const {
+  if (slots.empty()) {
+    throw std::invalid_argument("No slots to wait on");
+  }
+  auto first_answered = [&]() -> std::optional<size_t> {
+    for (size_t k = 0; k < slots.size(); ++k) {
+      if (ready(slots[k])) {
+        return k;
+      }
+    }
+    return std::nullopt;
+  };
+  for (unsigned spin = 0; spin < spin_limit(); ++spin) {
+    if (auto k = first_answered()) {
+      return *k;
+    }
+    cpu_relax();
+  }
+  SlotHeader &home = m_segment.slot(m_held.front());
+  for (;;) {
+    home.waiting.store(1, std::memory_order_seq_cst);
+    const uint32_t bell = home.answers.load(std::memory_order_seq_cst);
+    if (!first_answered()) {
+      futex_wait(home.answers, bell);
+    }
+    home.waiting.store(0, std::memory_order_relaxed);
+    if (auto k = first_answered()) {
+      return *k;
+    }
+    check_server();
+  }
+}
+
+double Client::collect(uint32_t slot, double *forces) {
+  SlotHeader &hdr = m_segment.slot(slot);
+  const uint32_t state = hdr.state.load(std::memory_order_acquire);
+  hdr.state.store(static_cast<uint32_t>(SlotState::Idle),
+                  std::memory_order_relaxed);
+  if (state == static_cast<uint32_t>(SlotState::Failed)) {
+    throw std::runtime_error(hdr.error);
+  }
+  if (state != static_cast<uint32_t>(SlotState::Done)) {
+    throw std::logic_error("Collecting an unanswered shared memory slot");
+  }
+  std::copy_n(m_segment.forces(slot), hdr.natoms * 3, forces);
+  return hdr.energy;
+}
+
+void Client::check_server() const {
+  if (!alive(m_segment.header().server_pid)) {
+    throw std::runtime_error("The potserv serving shared memory has exited");
+  }
+}
+
+} // namespace rgpot::shm
@@ -0,0 +1,385 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Shared-memory transport between potserv and clients on its host.
+ *
+ * A server started with @c --shm @c NAME creates the POSIX shared memory
+ * object @c /NAME, split into a header and a fixed number of slots. A
+ * client claims a slot, writes one configuration into it and rings the
+ * doorbell of the header; a server thread evaluates it in place, writing
+ * the forces into the slot, and flips the slot state. Waiting is a short
+ * spin followed by a futex wait, so the round trip of a small system costs
+ * a few microseconds instead of two loopback sends and the Cap'n Proto
+ * framing.
+ *
+ * The layout below is shared with the Rust client in
+ * @c rgpot-core/src/rpc/shm.rs and must change in both places together,
+ * bumping @c kVersion. Futex signaling makes the transport Linux-only;
+ * elsewhere opening a channel throws.
+ */
+
+// clang-format off
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+// clang-format on
+
+namespace rgpot::shm {
+
+/**
+ * @brief The bytes "RGPOTSHM" read as a little-endian integer.
+ */
+inline constexpr uint64_t kMagic = 0x4D4853544F504752ULL;
+
+/**
+ * @brief Version of the segment layout.
+ */
+inline constexpr uint32_t kVersion = 2;
+
+/**
+ * @brief Default number of slots of a server segment.
+ */
+inline constexpr uint32_t kDefaultSlots = 64;
+
+/**
+ * @brief Default number of atoms a slot holds.
+ */
+inline constexpr uint64_t kDefaultMaxAtoms = 4096;
+
+/**
+ * @brief Lifecycle of a slot, stored in @c SlotHeader::state.
+ */
+enum class SlotState : uint32_t {
+  Idle = 0,    //!< Claimed, no request written.
+  Request = 1, //!< Request written, waiting for a server thread.
+  Busy = 2,    //!< A server thread is evaluating the request.
+  Done = 3,    //!< Energy and forces are in the slot.
+  Failed = 4,  //!< The evaluation threw, the message is in the slot.
+};
+
+/**
+ * @brief Start of the segment, written by the server before clients open
+ * it.
+ */
+struct SegmentHeader {
+  uint64_t magic;       //!< @c kMagic.
+  uint32_t version;     //!< @c kVersion.
+  uint32_t nslots;      //!< Number of slots.
+  uint64_t max_atoms;   //!< Atoms one slot holds.
+  uint64_t slot_bytes;  //!< Distance between consecutive slots.
+  uint32_t server_pid;  //!< Process serving the segment.
+  uint32_t reserved[7]; //!< Keeps the signaling words on their own line.
+  std::atomic<uint32_t> doorbell; //!< Bumped by every request.
+  std::atomic<uint32_t> sleepers; //!< Server threads in a futex wait.
+  uint32_t padding[14];           //!< Fills the second cache line.
+};
+
+/**
+ * @brief Control block at the start of every slot, followed by the box,
+ * positions, forces and atomic numbers.
+ *
+ * A client sleeps on the @c answers word of its first slot, its home,
+ * which the server bumps after answering any slot of that client.
+ */
+struct SlotHeader {
+  std::atomic<uint32_t> owner;   //!< Process id of the client, 0 if free.
+  std::atomic<uint32_t> state;   //!< A @c SlotState.
+  std::atomic<uint32_t> waiting; //!< Whether the client sleeps on @c answers.
+  uint32_t home;                 //!< Slot whose @c answers the owner uses.
+  uint64_t natoms;               //!< Atoms of the request.
+  double energy;                 //!< Energy of the result.
+  std::atomic<uint32_t> answers; //!< Bumped by every answer to the owner.
+  uint32_t reserved;             //!< Alignment.
+  char error[216];               //!< Message of a failed evaluation.
+};
+
+static_assert(sizeof(SegmentHeader) == 128, "Header layout is shared");
+static_assert(sizeof(SlotHeader) == 256, "Slot layout is shared");
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "Futex words must be plain integers");
+
+/**
+ * @brief Extracts the segment name of a @c shm:// address.
+ * @param address A host string as given to the clients.
+ * @return The name after the scheme, or nothing for other addresses.
+ */
+std::optional<std::string> parse_address(const char *address);
+
+/**
+ * @class Segment
+ * @brief Mapping of a shared memory object with the slot layout.
+ *
+ * The creating side removes the object again when the mapping is
+ * destroyed; processes that still map it keep their view.
+ */
+class Segment {
+public:
+  /**
+   * @brief Creates and maps a fresh segment, replacing a stale one.
+   * @param name Object name without the leading slash.
+   * @param nslots Number of slots.
+   * @param max_atoms Atoms one slot holds.
+   * @return The mapping, owning the object.
+   * @throws std::runtime_error when the object cannot be created.
+   */
+  static Segment create(const std::string &name, uint32_t nslots,
+                        uint64_t max_atoms);
+
+  /**
+   * @brief Maps the segment of a running server.
+   * @param name Object name without the leading slash.
+   * @return The mapping.
+   * @throws std::runtime_error when the object is missing or has another
+   * layout.
+   */
+  static Segment open(const std::string &name);
+
+  ~Segment();
+  Segment(Segment &&other) noexcept;
+  Segment &operator=(Segment &&other) = delete;
+  Segment(const Segment &) = delete;
+  Segment &operator=(const Segment &) = delete;
+
+  /**
+   * @brief Fetches the header.
+   * @return The header in shared memory.
+   */
+  [[nodiscard]] SegmentHeader &header() const {
+    return *static_cast<SegmentHeader *>(m_base);
+  }
+
+  /**
+   * @brief Fetches the control block of a slot.
+   * @param i Slot index, below @c nslots().
+   * @return The control block in shared memory.
+   */
+  [[nodiscard]] SlotHeader &slot(uint32_t i) const {
+    return *reinterpret_cast<SlotHeader *>(slot_base(i));
+  }
+
+  [[nodiscard]] double *box(uint32_t i) const;       //!< Box of slot @a i.
+  [[nodiscard]] double *positions(uint32_t i) const; //!< Its positions.
+  [[nodiscard]] double *forces(uint32_t i) const;    //!< Its forces.
+  [[nodiscard]] int32_t *atmnrs(uint32_t i) const;   //!< Its numbers.
+
+  /**
+   * @brief Fetches the slot count.
+   * @return Number of slots.
+   */
+  [[nodiscard]] uint32_t nslots() const { return header().nslots; }
+
+  /**
+   * @brief Fetches the slot capacity.
+   * @return Atoms one slot holds.
+   */
+  [[nodiscard]] uint64_t max_atoms() const { return header().max_atoms; }
+
+  /**
+   * @brief Bytes one slot takes for a given capacity.
+   * @param max_atoms Atoms one slot holds.
+   * @return The slot stride, a multiple of 64.
+   */
+  static uint64_t slot_bytes(uint64_t max_atoms);
+
+private:
+  Segment(std::string name, void *base, size_t bytes, bool owner)
+      : m_name(std::move(name)), m_base(base), m_bytes(bytes),
+        m_owner(owner) {}
+
+  [[nodiscard]] char *slot_base(uint32_t i) const {
+    return static_cast<char *>(m_base) + sizeof(SegmentHeader) +
+           i * header().slot_bytes;
+  }
+
+  std::string m_name; //!< Object name with the leading slash.
+  void *m_base;       //!< Start of the mapping.
+  size_t m_bytes;     //!< Length of the mapping.
+  bool m_owner;       //!< Whether to remove the object on destruction.
+};
+
+/**
+ * @brief One request as seen by a server thread.
+ *
+ * All pointers alias the slot, so the handler reads the positions and
+ * writes the forces in shared memory.
+ */
+struct Call {
+  size_t nAtoms;         //!< Number of atoms.
+  const double *pos;     //!< Atomic coordinates.
+  const int32_t *atmnrs; //!< Atomic numbers.
+  const double *box;     //!< Simulation cell.
+  double *forces;        //!< Force output.
+  double *energy;        //!< Energy output.
+};
+
+/**
+ * @class Server
+ * @brief Server side of a segment, answered by any number of threads.
+ */
+class Server {
+public:
+  /**
+   * @brief Evaluates one request; exceptions fail it with their message.
+   */
+  using Handler = std::function<void(const Call &)>;
+
+  /**
+   * @brief Constructor for Server, creates the segment.
+   * @param name Object name without the leading slash.
+   * @param nslots Number of slots, i.e. of concurrent requests.
+   * @param max_atoms Atoms one slot holds.
+   */
+  Server(const std::string &name, uint32_t nslots, uint64_t max_atoms);
+
+  /**
+   * @brief Destructor, removes the segment.
+   * @pre Every thread has returned from @c serve.
+   */
+  ~Server() = default;
+
+  Server(const Server &) = delete;
+  Server &operator=(const Server &) = delete;
+
+  /**
+   * @brief Answers requests on the calling thread until @c stop.
+   *
+   * Several threads may serve one segment, each with its own handler.
+   *
+   * @param handler Evaluates the requests taken by this thread.
+   * @return Void.
+   */
+  void serve(const Handler &handler);
+
+  /**
+   * @brief Makes every @c serve call return after its current request.
+   * @return Void.
+   */
+  void stop();
+
+  /**
+   * @brief Fetches the mapping.
+   * @return The segment.
+   */
+  [[nodiscard]] const Segment &segment() const { return m_segment; }
+
+private:
+  /**
+   * @brief Runs one pending request, if any.
+   * @param handler The evaluating handler.
+   * @return Whether a request was found.
+   */
+  bool take(const Handler &handler);
+
+  Segment m_segment;                //!< The shared segment.
+  std::atomic<bool> m_stop{false};  //!< Set by @c stop.
+  std::atomic<uint32_t> m_next{0};  //!< First slot of the next scan.
+};
+
+/**
+ * @class Client
+ * @brief Client side of a segment.
+ *
+ * Slots are claimed on demand and reused; several calls may be in flight,
+ * one per slot. Not thread-safe, like the RPC clients.
+ */
+class Client {
+public:
+  /**
+   * @brief Constructor for Client, maps the segment of a server.
+   * @param name Object name without the leading slash.
+   * @throws std::runtime_error when no server serves @a name.
+   */
+  explicit Client(const std::string &name);
+
+  /**
+   * @brief Destructor, waits for calls in flight and frees the slots.
+   */
+  ~Client();
+
+  Client(const Client &) = delete;
+  Client &operator=(const Client &) = delete;
+
+  /**
+   * @brief Claims a slot for one call.
+   * @return The slot, or nothing when all are taken.
+   */
+  std::optional<uint32_t> acquire();
+
+  /**
+   * @brief Returns a finished or unused slot.
+   * @param slot A slot of @c acquire, not in flight.
+   * @return Void.
+   */
+  void release(uint32_t slot);
+
+  /**
+   * @brief Writes a request into a slot and signals the server.
+   * @param slot A claimed slot, not in flight.
+   * @param natoms Number of atoms.
+   * @param pos Flattened coordinates [natoms * 3].
+   * @param atmnrs Atomic numbers [natoms].
+   * @param box Simulation cell [9].
+   * @return Void.
+   * @throws std::runtime_error when the slot cannot hold @a natoms atoms.
+   */
+  void submit(uint32_t slot, size_t natoms, const double *pos,
+              const int32_t *atmnrs, const double *box);
+
+  /**
+   * @brief Checks whether the request of a slot has been answered.
+   * @param slot A slot in flight.
+   * @return Whether @c collect will not block.
+   */
+  [[nodiscard]] bool ready(uint32_t slot) const;
+
+  /**
+   * @brief Blocks until the request of a slot has been answered.
+   * @param slot A slot in flight.
+   * @return Void.
+   * @throws std::runtime_error when the server exits meanwhile.
+   */
+  void wait(uint32_t slot) const;
+
+  /**
+   * @brief Blocks until one of several requests has been answered.
+   * @param slots Slots in flight.
+   * @return Position in @a slots of an answered one, the first if several.
+   * @throws std::runtime_error when the server exits meanwhile.
+   */
+  size_t wait_any(const std::vector<uint32_t> &slots) const;
+
+  /**
+   * @brief Reads the result of an answered request.
+   * @param slot An answered slot, idle again afterwards.
+   * @param forces Receives the forces [natoms * 3].
+   * @return The energy.
+   * @throws std::runtime_error with the server's message for a failed call.
+   */
+  double collect(uint32_t slot, double *forces);
+
+  /**
+   * @brief Fetches the slot capacity.
+   * @return Atoms one request may hold.
+   */
+  [[nodiscard]] uint64_t max_atoms() const { return m_segment.max_atoms(); }
+
+private:
+  /**
+   * @brief Throws if the process serving the segment has exited.
+   * @return Void.
+   */
+  void check_server() const;
+
+  Segment m_segment;            //!< The shared segment.
+  uint32_t m_pid;               //!< Our process id, the slot owner tag.
+  std::vector<uint32_t> m_free; //!< Claimed slots not in use.
+  std::vector<uint32_t> m_held; //!< All claimed slots, the home first.
+};
+
+} // namespace rgpot::shm
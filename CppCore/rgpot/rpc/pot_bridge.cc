@@ -7,39 +7,676 @@
  * This file implements the C-compatible wrapper for the Cap'n Proto RPC client.
  * It manages the lifecycle of the EzRpcClient and handles error reporting
  * through a simple string-based interface.
+ *
+ * Hosts of the form @c shm://NAME select the shared-memory transport of
+ * @c ShmChannel.hpp instead, for servers on the same node; the same calls
+ * then go through slots of the segment, one per call in flight.
+ *
+ * A host may also list several endpoints, TCP or Unix domain sockets. Each
+ * call then goes to the endpoint with the fewest requests in flight, and
+ * calls whose endpoint has disconnected are resent to another one.
+ *
+ * Sessions stream the frames of one system to a @c Session capability,
+ * sending the atomic numbers and box once and per frame only the positions
+ * that changed.
+ *
+ * Servers queue the calls of every connection fairly against those of
+ * other clients. Calls a server refuses as overloaded are resent to
+ * another endpoint, and once none is left fail with @c POT_OVERLOADED.
  */
 
 #include "pot_bridge.h"
 #include "Potentials.capnp.h"
+#include "rgpot/rpc/ShmChannel.hpp"
+#include "rgpot/types/adapters/capnp/capnp_view.hpp"
 #include <algorithm>
 #include <capnp/ez-rpc.h>
 #include <capnp/message.h>
+#include <chrono>
+#include <deque>
+#include <kj/async.h>
 #include <kj/common.h>
+#include <kj/debug.h>
+#include <kj/vector.h>
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+//! Delay before a disconnected endpoint is probed again.
+constexpr std::chrono::milliseconds kRetryMin{250};
+//! Longest delay between probes of an endpoint that stays down.
+constexpr std::chrono::milliseconds kRetryMax{30000};
+
+//! Whether a failed call may be resent to another endpoint.
+bool endpoint_lost(const kj::Exception &e) {
+  return e.getType() == kj::Exception::Type::DISCONNECTED;
+}
+
+//! Whether a server refused a call because its queue was full.
+bool overloaded(const kj::Exception &e) {
+  return e.getType() == kj::Exception::Type::OVERLOADED;
+}
+
+//! Return code of a call that failed with @a e.
+int32_t failure_status(const kj::Exception &e) {
+  return overloaded(e) ? POT_OVERLOADED : -1;
+}
+
+} // namespace
+
+/**
+ * @class Endpoint
+ * @details
+ * One server of a client, with its connection and its load. An endpoint
+ * whose connection failed is down; after a delay that doubles with every
+ * failure it is reconnected and probed with a @c stats request, and comes
+ * back once the probe is answered.
+ */
+struct Endpoint {
+  std::string address;                     //!< @c HOST[:PORT] or @c unix:PATH.
+  uint32_t port = 0;                       //!< Port if @c address has none.
+  std::unique_ptr<capnp::EzRpcClient> rpc; //!< The current connection.
+  Potential::Client capability{nullptr};   //!< Capability of @c rpc.
+  size_t outstanding = 0;                  //!< Requests in flight.
+  uint32_t failures = 0;                   //!< Consecutive failures, 0 if up.
+  Clock::time_point retry_at;              //!< Next probe when down.
+  bool probing = false;                    //!< Whether @c probe is running.
+  std::optional<kj::Promise<void>> probe;  //!< The last health check.
+  uint64_t generation = 0;                 //!< Connections opened so far.
+
+  /**
+   * @brief Opens a fresh connection, replacing the current one.
+   * @return Void.
+   */
+  void connect() {
+    probe.reset();
+    auto fresh = std::make_unique<capnp::EzRpcClient>(address, port);
+    capability = fresh->getMain().castAs<Potential>();
+    rpc = std::move(fresh);
+    ++generation;
+  }
+};
+
+/**
+ * @class PendingCall
+ * @details
+ * State of one submitted @c calculate request. The continuation attached in
+ * @c pot_calculate_submit fills @c status and the caller's output buffers;
+ * @c done resolves once that has happened, successfully or not. Calls over
+ * shared memory instead hold a slot, read into the buffers on completion.
+ * With several endpoints the call keeps a copy of its inputs, so that it
+ * can be resent when its endpoint disconnects.
+ */
+struct PendingCall {
+  int32_t status = 1;    //!< 1 while in flight, then the call's return code.
+  std::string error;     //!< Error message for a failed call.
+  kj::Maybe<kj::ForkedPromise<void>> done; //!< Completion signal of RPC.
+  size_t attempts = 0;          //!< Endpoints the call was sent to.
+  std::vector<double> pos;      //!< Positions kept for failover.
+  std::vector<int32_t> atmnrs;  //!< Atomic numbers kept for failover.
+  std::vector<double> box;      //!< Box kept for failover.
+  uint32_t slot = 0;            //!< Shared memory slot of the call.
+  double *out_energy = nullptr; //!< Energy output of a shared memory call.
+  double *out_forces = nullptr; //!< Force output of a shared memory call.
+};
+
+/**
+ * @class BatchChunk
+ * @details
+ * The configurations @c [begin, begin + count) of a batch, sent to one
+ * endpoint as a single @c calculateBatch request.
+ */
+struct BatchChunk {
+  int32_t begin = 0;   //!< First configuration of the chunk.
+  int32_t count = 0;   //!< Configurations in the chunk.
+  int32_t status = 1;  //!< 1 while in flight, then the chunk's return code.
+  std::string error;   //!< Error message for a failed chunk.
+  size_t attempts = 0; //!< Endpoints the chunk was sent to.
+};
+
+/**
+ * @class BatchCall
+ * @details
+ * The caller's buffers of one @c pot_calculate_batch, valid while it runs.
+ */
+struct BatchCall {
+  int32_t natoms;        //!< Atoms per configuration.
+  const double *pos;     //!< Positions of all configurations.
+  const int32_t *atmnrs; //!< Atomic numbers shared by all configurations.
+  const double *boxes;   //!< Boxes of all configurations.
+  double *out_energies;  //!< Energies of all configurations.
+  double *out_forces;    //!< Forces of all configurations.
+};
 
 /**
  * @class PotClient
  * @details
  * Container for the C++ objects required to manage an RPC session. It is
  * exposed to C as an opaque pointer.  The use of @c std::unique_ptr ensures
- * that the RPC client is cleaned up correctly upon destruction.
+ * that the RPC clients are cleaned up correctly upon destruction. A client
+ * of a @c shm:// address holds a shared memory channel and no endpoints.
+ *
+ * All connections of the endpoints share the event loop of the thread, so
+ * the single wait scope drives calls to every server.
  */
 struct PotClient {
-  std::unique_ptr<capnp::EzRpcClient>
-      rpc_client;               //!< The Cap'n Proto RPC client.
-  Potential::Client capability; //!< The RPC capability for potential calls.
-  kj::WaitScope *wait_scope;    //!< Reference to the client wait scope.
-  std::string last_error;       //!< Buffer for the most recent error message.
+  std::vector<Endpoint> endpoints; //!< The servers of an RPC client.
+  kj::WaitScope *wait_scope;       //!< Reference to the client wait scope.
+  std::unique_ptr<rgpot::shm::Client> shm; //!< Shared memory channel.
+  size_t endpoint_limit = 0; //!< Requests per endpoint, 0 for no cap.
+  size_t next_endpoint = 0;  //!< Where the next endpoint scan starts.
+  std::string last_error;    //!< Buffer for the most recent error message.
+  std::map<int64_t, std::unique_ptr<PendingCall>>
+      pending;            //!< In-flight calls, declared last so they are
+                          //!< cancelled before the connection goes away.
+  int64_t next_ticket = 1; //!< Ticket handed to the next submitted call.
+
+  /**
+   * @brief Constructor for PotClient, connecting to every endpoint.
+   * @param addresses Endpoint addresses, at least one.
+   * @param port Port for addresses that name none.
+   */
+  PotClient(const std::vector<std::string> &addresses, uint32_t port)
+      : wait_scope(nullptr) {
+    endpoints.reserve(addresses.size());
+    for (const auto &address : addresses) {
+      Endpoint &ep = endpoints.emplace_back();
+      ep.address = address;
+      ep.port = port;
+      ep.connect();
+    }
+    wait_scope = &endpoints.front().rpc->getWaitScope();
+  }
+
+  /**
+   * @brief Constructor for a shared memory PotClient.
+   * @param channel The mapped segment of the server.
+   */
+  explicit PotClient(std::unique_ptr<rgpot::shm::Client> channel)
+      : wait_scope(nullptr), shm(std::move(channel)) {}
+
+  /**
+   * @brief Marks an endpoint down after a lost connection.
+   * @param e Index of the endpoint.
+   * @return Void.
+   */
+  void mark_down(size_t e) {
+    Endpoint &ep = endpoints[e];
+    const auto delay =
+        kRetryMin * (int64_t{1} << std::min<uint32_t>(ep.failures, 16));
+    ep.failures += 1;
+    ep.retry_at = Clock::now() + std::min<Clock::duration>(delay, kRetryMax);
+  }
+
+  /**
+   * @brief Starts health checks of the down endpoints that are due.
+   * @return Void.
+   */
+  void probe_due() {
+    const auto now = Clock::now();
+    for (size_t e = 0; e < endpoints.size(); ++e) {
+      Endpoint &ep = endpoints[e];
+      if (ep.failures == 0 || ep.probing || now < ep.retry_at) {
+        continue;
+      }
+      // Any answer, even an error, shows that the server is back
+      ep.connect();
+      ep.probing = true;
+      using StatsResponse = capnp::Response<Potential::StatsResults>;
+      auto req = ep.capability.statsRequest();
+      ep.probe = req.send()
+                     .then(
+                         [this, e](StatsResponse &&) {
+                           endpoints[e].failures = 0;
+                           endpoints[e].probing = false;
+                         },
+                         [this, e](kj::Exception &&ex) {
+                           if (endpoint_lost(ex)) {
+                             mark_down(e);
+                           } else {
+                             endpoints[e].failures = 0;
+                           }
+                           endpoints[e].probing = false;
+                         })
+                     .eagerlyEvaluate(nullptr);
+    }
+  }
+
+  /**
+   * @brief Finds the up endpoint with the fewest requests in flight.
+   * @param respect_limit Whether endpoints at @c endpoint_limit are skipped.
+   * @return Its index, or @c std::nullopt when none qualifies.
+   */
+  std::optional<size_t> least_loaded(bool respect_limit) const {
+    std::optional<size_t> best;
+    for (size_t k = 0; k < endpoints.size(); ++k) {
+      const size_t e = (next_endpoint + k) % endpoints.size();
+      const Endpoint &ep = endpoints[e];
+      if (ep.failures != 0 ||
+          (respect_limit && endpoint_limit != 0 &&
+           ep.outstanding >= endpoint_limit)) {
+        continue;
+      }
+      if (!best || ep.outstanding < endpoints[*best].outstanding) {
+        best = e;
+      }
+    }
+    return best;
+  }
+
+  /**
+   * @brief Picks the endpoint for a new request.
+   *
+   * Health checks that are due are started first. While every endpoint is
+   * at the limit, the event loop runs until a call of this client
+   * finishes. While every endpoint is down, the one due soonest is probed
+   * at once and the request shares the probe's connection, so that it
+   * fails with the real error instead of waiting out the delay.
+   *
+   * @return Index of the endpoint.
+   */
+  size_t acquire() {
+    for (;;) {
+      probe_due();
+      std::optional<size_t> e = least_loaded(true);
+      if (!e && !least_loaded(false)) {
+        auto soonest = std::min_element(
+            endpoints.begin(), endpoints.end(),
+            [](const Endpoint &a, const Endpoint &b) {
+              return a.retry_at < b.retry_at;
+            });
+        if (!soonest->probing) {
+          soonest->retry_at = Clock::time_point();
+          probe_due();
+        }
+        e = static_cast<size_t>(soonest - endpoints.begin());
+      }
+      if (!e) {
+        std::optional<kj::Promise<void>> any;
+        for (auto &entry : pending) {
+          PendingCall &call = *entry.second;
+          if (call.status != 1) {
+            continue;
+          }
+          auto branch = KJ_ASSERT_NONNULL(call.done).addBranch();
+          any = any ? any->exclusiveJoin(kj::mv(branch)) : kj::mv(branch);
+        }
+        if (any) {
+          any->wait(*wait_scope);
+          continue;
+        }
+        // Nothing of this client is in flight to wait for
+        e = least_loaded(false);
+      }
+      next_endpoint = (*e + 1) % endpoints.size();
+      return *e;
+    }
+  }
+
+  /**
+   * @brief Decides where a request goes after its endpoint failed.
+   *
+   * An overloaded endpoint stays up; the request moves on to the next one
+   * that is up, until every endpoint has been tried.
+   *
+   * @param e Index of the endpoint that failed.
+   * @param ex The failure.
+   * @param attempts Endpoints the request was sent to so far.
+   * @return The endpoint to resend to, or @c std::nullopt to give up.
+   */
+  std::optional<size_t> failover(size_t e, const kj::Exception &ex,
+                                 size_t attempts) {
+    if (overloaded(ex)) {
+      if (attempts >= endpoints.size()) {
+        return std::nullopt;
+      }
+      for (size_t k = 1; k < endpoints.size(); ++k) {
+        const size_t next = (e + k) % endpoints.size();
+        if (endpoints[next].failures == 0) {
+          return next;
+        }
+      }
+      return std::nullopt;
+    }
+    if (!endpoint_lost(ex)) {
+      return std::nullopt;
+    }
+    mark_down(e);
+    if (attempts >= endpoints.size()) {
+      return std::nullopt;
+    }
+    return least_loaded(false);
+  }
+
+  /**
+   * @brief Sends one calculation to an endpoint.
+   * @param call The pending call, which receives the result.
+   * @param e Index of the endpoint.
+   * @param pos Positions of the configuration.
+   * @param atmnrs Atomic numbers of the configuration.
+   * @param box Box of the configuration.
+   * @param nforces Number of force components expected.
+   * @param out_energy Where the energy is stored.
+   * @param out_forces Where the forces are stored.
+   * @return Promise resolved once @a call has finished.
+   */
+  kj::Promise<void> send_calculate(PendingCall *call, size_t e,
+                                   kj::ArrayPtr<const double> pos,
+                                   kj::ArrayPtr<const int32_t> atmnrs,
+                                   kj::ArrayPtr<const double> box,
+                                   size_t nforces, double *out_energy,
+                                   double *out_forces) {
+    Endpoint &ep = endpoints[e];
+    auto req = ep.capability.calculateRequest();
+    auto fip = req.initFip();
+
+    // Cap'n Proto sees these views and performs a bulk memcpy
+    // directly into the message builder's memory segment.
+    fip.setPos(pos);
+    fip.setAtmnrs(atmnrs);
+    fip.setBox(box);
+
+    ++ep.outstanding;
+    ++call->attempts;
+    return req.send().then(
+        [this, e, call, nforces, out_energy,
+         out_forces](capnp::Response<Potential::CalculateResults> &&response)
+            -> kj::Promise<void> {
+          --endpoints[e].outstanding;
+          endpoints[e].failures = 0;
+          auto result = response.getResult();
+
+          // -------------------------------------------------
+          // RETRIEVAL - Bulk Copy Back
+          // -------------------------------------------------
+
+          auto res_forces = result.getForces();
+
+          // Strict runtime check to ensure server didn't return
+          // garbage size
+          if (res_forces.size() != nforces) {
+            call->error = "Server returned force array of incorrect size";
+            call->status = -2;
+            return kj::READY_NOW;
+          }
+
+          *out_energy = result.getEnergy();
+          rgpot::types::adapt::capnp::copyFromCapnp(res_forces, out_forces,
+                                                    nforces);
+          call->status = 0;
+          return kj::READY_NOW;
+        },
+        [this, e, call, nforces, out_energy,
+         out_forces](kj::Exception &&ex) -> kj::Promise<void> {
+          --endpoints[e].outstanding;
+          if (auto next = failover(e, ex, call->attempts)) {
+            const PendingCall &saved = *call;
+            return send_calculate(
+                call, *next, kj::arrayPtr(saved.pos.data(), saved.pos.size()),
+                kj::arrayPtr(saved.atmnrs.data(), saved.atmnrs.size()),
+                kj::arrayPtr(saved.box.data(), saved.box.size()), nforces,
+                out_energy, out_forces);
+          }
+          call->error = ex.getDescription().cStr();
+          call->status = failure_status(ex);
+          return kj::READY_NOW;
+        });
+  }
+
+  /**
+   * @brief Sends one chunk of a batch to an endpoint.
+   * @param batch The caller's buffers.
+   * @param chunk The chunk, which receives the status.
+   * @param e Index of the endpoint.
+   * @return Promise resolved once @a chunk has finished.
+   */
+  kj::Promise<void> send_batch(const BatchCall *batch, BatchChunk *chunk,
+                               size_t e) {
+    Endpoint &ep = endpoints[e];
+    auto req = ep.capability.calculateBatchRequest();
+    auto fips = req.initFips(chunk->count);
+    const size_t stride = static_cast<size_t>(batch->natoms) * 3;
+    auto atm_view = kj::arrayPtr(batch->atmnrs, batch->natoms);
+
+    for (int32_t k = 0; k < chunk->count; ++k) {
+      const size_t c = static_cast<size_t>(chunk->begin + k);
+      auto fip = fips[k];
+      fip.setPos(kj::arrayPtr(batch->pos + c * stride, stride));
+      fip.setAtmnrs(atm_view);
+      fip.setBox(kj::arrayPtr(batch->boxes + c * 9, 9));
+    }
+
+    ++ep.outstanding;
+    ++chunk->attempts;
+    return req.send().then(
+        [this, e, batch, chunk,
+         stride](capnp::Response<Potential::CalculateBatchResults> &&response)
+            -> kj::Promise<void> {
+          --endpoints[e].outstanding;
+          endpoints[e].failures = 0;
+          auto results = response.getResults();
+          if (results.size() != static_cast<size_t>(chunk->count)) {
+            chunk->error = "Server returned an incorrect number of results";
+            chunk->status = -2;
+            return kj::READY_NOW;
+          }
+          for (int32_t k = 0; k < chunk->count; ++k) {
+            const size_t c = static_cast<size_t>(chunk->begin + k);
+            auto result = results[k];
+            auto res_forces = result.getForces();
+            if (res_forces.size() != stride) {
+              chunk->error = "Server returned force array of incorrect size";
+              chunk->status = -2;
+              return kj::READY_NOW;
+            }
+            batch->out_energies[c] = result.getEnergy();
+            rgpot::types::adapt::capnp::copyFromCapnp(
+                res_forces, batch->out_forces + c * stride, stride);
+          }
+          chunk->status = 0;
+          return kj::READY_NOW;
+        },
+        [this, e, batch, chunk](kj::Exception &&ex) -> kj::Promise<void> {
+          --endpoints[e].outstanding;
+          if (auto next = failover(e, ex, chunk->attempts)) {
+            return send_batch(batch, chunk, *next);
+          }
+          chunk->error = ex.getDescription().cStr();
+          chunk->status = failure_status(ex);
+          return kj::READY_NOW;
+        });
+  }
 
   /**
-   * @brief Constructor for PotClient.
-   * @param client Ownership of the initialized EzRpcClient.
-   * @param cap The capability client for the Potential interface.
+   * @brief Reads the answer of a finished shared memory call.
+   * @param call A call in flight whose slot is ready.
+   * @return Void.
    */
-  PotClient(std::unique_ptr<capnp::EzRpcClient> client, Potential::Client cap)
-      : rpc_client(std::move(client)), capability(std::move(cap)),
-        wait_scope(&rpc_client->getWaitScope()) {}
+  void finish_shm(PendingCall &call) {
+    try {
+      *call.out_energy = shm->collect(call.slot, call.out_forces);
+      call.status = 0;
+    } catch (const std::exception &e) {
+      call.error = e.what();
+      call.status = -1;
+    }
+    shm->release(call.slot);
+  }
+
+  /**
+   * @brief Removes a finished call and returns its status.
+   * @param it Iterator into @c pending for a call with @c status != 1.
+   * @return The call's status, with @c last_error set on failure.
+   */
+  int32_t
+  collect(std::map<int64_t, std::unique_ptr<PendingCall>>::iterator it) {
+    int32_t status = it->second->status;
+    if (status != 0) {
+      last_error = std::move(it->second->error);
+    }
+    pending.erase(it);
+    return status;
+  }
+};
+
+/**
+ * @class PotSession
+ * @details
+ * Client side of a @c Session capability, pinned to one endpoint. It keeps
+ * the positions the server holds, so that each step sends only what
+ * changed. After a failed step the next frame holds every position; when
+ * the endpoint was lost, the session is first opened again on another.
+ */
+struct PotSession {
+  PotClient *client = nullptr;               //!< The owning client.
+  std::optional<Session::Client> capability; //!< The open session.
+  size_t endpoint = 0;                       //!< Endpoint of @c capability.
+  uint64_t generation = 0;                   //!< Connection of @c capability.
+  std::vector<int32_t> atmnrs;               //!< Atomic numbers of the system.
+  std::vector<double> box;                   //!< Cell the server holds.
+  std::vector<double> sent;                  //!< Positions the server holds.
+  bool primed = false;                       //!< Whether @c sent is valid.
+  bool float_shifts = false;                 //!< Whether shifts may be sent.
+  std::vector<uint32_t> moved;               //!< Scratch list of moved atoms.
+
+  /**
+   * @brief Opens the session on an endpoint, without waiting.
+   * @param e Index of the endpoint.
+   * @return Void.
+   */
+  void open(size_t e) {
+    Endpoint &ep = client->endpoints[e];
+    auto req = ep.capability.openSessionRequest();
+    req.setAtmnrs(kj::arrayPtr(atmnrs.data(), atmnrs.size()));
+    req.setBox(kj::arrayPtr(box.data(), box.size()));
+    // Steps are pipelined onto the session before the reply arrives
+    capability.emplace(req.send().getSession());
+    endpoint = e;
+    generation = ep.generation;
+    primed = false;
+  }
+
+  /**
+   * @brief Fills the frame of the next step and records what was sent.
+   *
+   * Every position is sent for the first frame. Afterwards only the atoms
+   * that moved are sent while they are at most half of the system, and
+   * otherwise every position or, if enabled, the Float32 change of every
+   * coordinate, which the server adds to its copy exactly as done here.
+   *
+   * @param frame The frame builder of the request.
+   * @param pos The new positions.
+   * @param new_box The new simulation cell, or @c nullptr if unchanged.
+   * @return Void.
+   */
+  void fill(Frame::Builder frame, const double *pos, const double *new_box) {
+    const size_t n3 = sent.size();
+    const bool box_changed =
+        new_box && !std::equal(new_box, new_box + 9, box.begin());
+    if (new_box) {
+      std::copy_n(new_box, 9, box.begin());
+    }
+    if (!primed || box_changed) {
+      frame.setBox(kj::arrayPtr(box.data(), box.size()));
+    }
+    if (!primed) {
+      frame.setPos(kj::arrayPtr(pos, n3));
+      std::copy_n(pos, n3, sent.begin());
+      return;
+    }
+
+    moved.clear();
+    for (size_t i = 0; 3 * i < n3; ++i) {
+      if (!std::equal(pos + 3 * i, pos + 3 * i + 3, sent.begin() + 3 * i)) {
+        moved.push_back(static_cast<uint32_t>(i));
+      }
+    }
+    if (2 * moved.size() <= n3 / 3) {
+      auto group = frame.initMoved();
+      group.setIndices(kj::arrayPtr(moved.data(), moved.size()));
+      auto moved_pos = group.initPos(moved.size() * 3);
+      for (size_t k = 0; k < moved.size(); ++k) {
+        for (size_t d = 0; d < 3; ++d) {
+          const size_t c = 3 * size_t{moved[k]} + d;
+          moved_pos.set(3 * k + d, pos[c]);
+          sent[c] = pos[c];
+        }
+      }
+    } else if (float_shifts) {
+      auto shift = frame.initShift(n3);
+      for (size_t c = 0; c < n3; ++c) {
+        const float d = static_cast<float>(pos[c] - sent[c]);
+        shift.set(c, d);
+        sent[c] += static_cast<double>(d);
+      }
+    } else {
+      frame.setPos(kj::arrayPtr(pos, n3));
+      std::copy_n(pos, n3, sent.begin());
+    }
+  }
+
+  /**
+   * @brief Evaluates one frame, reopening the session on failover.
+   * @param pos The new positions.
+   * @param new_box The new simulation cell, or @c nullptr if unchanged.
+   * @param out_energy Where the energy is stored.
+   * @param out_forces Where the forces are stored.
+   * @return 0 on success, -1 on an RPC failure, -2 on a malformed reply,
+   * @c POT_OVERLOADED when the server refused the step.
+   */
+  int32_t step(const double *pos, const double *new_box, double *out_energy,
+               double *out_forces) {
+    const Endpoint &current = client->endpoints[endpoint];
+    if (!capability || current.failures != 0 ||
+        current.generation != generation) {
+      capability.reset();
+      open(client->acquire());
+    }
+    for (size_t attempts = 1;; ++attempts) {
+      auto req = capability->stepRequest();
+      fill(req.initFrame(), pos, new_box);
+      Endpoint &ep = client->endpoints[endpoint];
+      ++ep.outstanding;
+      try {
+        auto response = req.send().wait(*client->wait_scope);
+        --ep.outstanding;
+        ep.failures = 0;
+        auto result = response.getResult();
+        auto res_forces = result.getForces();
+        if (res_forces.size() != sent.size()) {
+          client->last_error = "Server returned force array of incorrect size";
+          return -2;
+        }
+        *out_energy = result.getEnergy();
+        rgpot::types::adapt::capnp::copyFromCapnp(res_forces, out_forces,
+                                                  sent.size());
+        primed = true;
+        return 0;
+      } catch (const kj::Exception &ex) {
+        --ep.outstanding;
+        // The server also drops its positions after a failed step
+        primed = false;
+        // A busy server keeps the session, it is not moved elsewhere
+        if (!endpoint_lost(ex)) {
+          client->last_error = ex.getDescription().cStr();
+          return failure_status(ex);
+        }
+        capability.reset();
+        auto next = client->failover(endpoint, ex, attempts);
+        if (!next) {
+          client->last_error = ex.getDescription().cStr();
+          return -1;
+        }
+        open(*next);
+      }
+    }
+  }
 };
 
 // Helper macros to enforce safety without clutter
@@ -59,23 +696,39 @@ extern "C" {
 
 /**
  * @details
- * Constructs a string-based address from the @a host and @a port,
- * then initializes a new @c capnp::EzRpcClient. The main capability
- * is cast to the @c Potential interface defined in the schema.
+ * Splits @a host at commas into endpoint addresses and initializes a
+ * @c capnp::EzRpcClient for each, with @a port as the default port. The
+ * main capabilities are cast to the @c Potential interface defined in the
+ * schema. Addresses are parsed by kj, which also accepts @c unix:PATH.
+ *
+ * For a @a host of the form @c shm://NAME the segment of a
+ * @c potserv @c --shm @c NAME is mapped instead and @a port is ignored.
  *
  * @note Returns @c nullptr if the connection cannot be established
- * or if the address is malformed.
+ * or if the address is malformed, including an empty endpoint.
  */
 PotClient *pot_client_init(const char *host, int32_t port) {
   // We cannot use the client struct for storage yet, so we use a temporary
   if (!host)
     return nullptr;
   try {
-    std::string address = std::string(host) + ":" + std::to_string(port);
-    auto rpc_client = std::make_unique<capnp::EzRpcClient>(address);
-    auto cap = rpc_client->getMain().castAs<Potential>();
+    if (auto name = rgpot::shm::parse_address(host)) {
+      return new PotClient(std::make_unique<rgpot::shm::Client>(*name));
+    }
+    std::vector<std::string> addresses;
+    const std::string list = host;
+    for (size_t begin = 0; begin <= list.size();) {
+      const size_t end = std::min(list.find(',', begin), list.size());
+      const size_t first = list.find_first_not_of(" \t", begin);
+      const size_t last = list.find_last_not_of(" \t", end - 1);
+      if (first >= end || last == std::string::npos || last < first) {
+        return nullptr;
+      }
+      addresses.push_back(list.substr(first, last - first + 1));
+      begin = end + 1;
+    }
 
-    return new PotClient(std::move(rpc_client), std::move(cap));
+    return new PotClient(addresses, static_cast<uint32_t>(port));
   } catch (...) {
     // In init, we return nullptr. The caller must assume initialization failed.
     // TODO(rg): Advanced logging could go to a thread-local static
@@ -83,6 +736,23 @@ PotClient *pot_client_init(const char *host, int32_t port) {
   }
 }
 
+/**
+ * @details
+ * Applies to requests submitted afterwards; those already in flight are
+ * not affected.
+ */
+int32_t pot_client_set_endpoint_limit(PotClient *client, int32_t limit) {
+  if (!client)
+    return -1;
+  client->last_error.clear();
+  if (limit < 0) {
+    client->last_error = "Negative endpoint limit";
+    return -1;
+  }
+  client->endpoint_limit = static_cast<size_t>(limit);
+  return 0;
+}
+
 /**
  * @details
  * Performs a standard @c delete on the client pointer. This triggers
@@ -97,14 +767,7 @@ void pot_client_free(PotClient *client) {
 
 /**
  * @details
- * This function performs the following steps:
- * 1. Resets the @c last_error buffer.
- * 2. Initializes a calculation request.
- * 3. Maps the input pointers to @c kj::arrayPtr views to avoid
- * unnecessary copying before serialization.
- * 4. Waits for the RPC promise to resolve.
- * 5. Validates the size of the returned force array.
- * 6. Copies the results into the provided output buffers.
+ * Implemented as @c pot_calculate_submit followed by @c pot_calculate_wait.
  *
  * @warning The server must return a force array matching @a natoms * 3.
  * If the sizes do not match, a non-zero error code is returned.
@@ -112,16 +775,76 @@ void pot_client_free(PotClient *client) {
 int32_t pot_calculate(PotClient *client, int32_t natoms, const double *pos,
                       const int32_t *atmnrs, const double *box,
                       double *out_energy, double *out_forces) {
+  int64_t ticket = pot_calculate_submit(client, natoms, pos, atmnrs, box,
+                                        out_energy, out_forces);
+  if (ticket < 0) {
+    return -1;
+  }
+  return pot_calculate_wait(client, ticket);
+}
+
+/**
+ * @details
+ * This function performs the following steps:
+ * 1. Resets the @c last_error buffer.
+ * 2. Initializes a calculation request.
+ * 3. Maps the input pointers to @c kj::arrayPtr views to avoid
+ * unnecessary copying before serialization.
+ * 4. Sends the request and attaches a continuation which validates the
+ * size of the returned force array and bulk copies the results into the
+ * provided output buffers.
+ * 5. Registers the continuation under a fresh ticket.
+ *
+ * Several requests may be in flight on one connection; Cap'n Proto
+ * pipelines them and the server answers each as soon as it is done. The
+ * continuations only run while the event loop is driven, i.e. inside
+ * @c pot_calculate_poll, @c pot_calculate_wait or @c pot_calculate_wait_any.
+ *
+ * With several endpoints the request goes to the one with the fewest
+ * requests in flight, blocking while all are at the limit set with
+ * @c pot_client_set_endpoint_limit. If that endpoint turns out to be
+ * disconnected, the continuation resends the request to the next one, until
+ * every endpoint has been tried.
+ *
+ * Over shared memory the inputs are written into a free slot of the
+ * segment instead, and the call fails when every slot is taken.
+ */
+int64_t pot_calculate_submit(PotClient *client, int32_t natoms,
+                             const double *pos, const int32_t *atmnrs,
+                             const double *box, double *out_energy,
+                             double *out_forces) {
 
   // Safety Checks
   if (!client)
     return -1;
   client->last_error.clear();
+  if (natoms < 0) {
+    client->last_error = "Negative atom count";
+    return -1;
+  }
 
   try {
-    auto &waitScope = *client->wait_scope;
-    auto req = client->capability.calculateRequest();
-    auto fip = req.initFip();
+    if (client->shm) {
+      auto slot = client->shm->acquire();
+      if (!slot) {
+        client->last_error = "All shared memory slots are in use";
+        return -1;
+      }
+      try {
+        client->shm->submit(*slot, static_cast<size_t>(natoms), pos, atmnrs,
+                            box);
+      } catch (...) {
+        client->shm->release(*slot);
+        throw;
+      }
+      auto call = std::make_unique<PendingCall>();
+      call->slot = *slot;
+      call->out_energy = out_energy;
+      call->out_forces = out_forces;
+      int64_t ticket = client->next_ticket++;
+      client->pending.emplace(ticket, std::move(call));
+      return ticket;
+    }
 
     // kj::arrayPtr creates a "view" (pointer + size) with NO copying.
     // It is essentially a span.
@@ -129,42 +852,318 @@ int32_t pot_calculate(PotClient *client, int32_t natoms, const double *pos,
     auto atm_view = kj::arrayPtr(atmnrs, natoms);
     auto box_view = kj::arrayPtr(box, 9);
 
-    // Cap'n Proto sees these views and performs a bulk memcpy
-    // directly into the message builder's memory segment.
-    fip.setPos(pos_view);
-    fip.setAtmnrs(atm_view);
-    fip.setBox(box_view);
-
-    // ---------------------------------------------------------
+    auto call = std::make_unique<PendingCall>();
+    PendingCall *state = call.get();
+    const size_t nforces = static_cast<size_t>(natoms) * 3;
+    if (client->endpoints.size() > 1) {
+      state->pos.assign(pos_view.begin(), pos_view.end());
+      state->atmnrs.assign(atm_view.begin(), atm_view.end());
+      state->box.assign(box_view.begin(), box_view.end());
+    }
 
     // Execute RPC
-    auto promise = req.send();
-    auto response = promise.wait(waitScope);
-    auto result = response.getResult();
+    const size_t endpoint = client->acquire();
+    auto promise =
+        client->send_calculate(state, endpoint, pos_view, atm_view, box_view,
+                               nforces, out_energy, out_forces);
+    state->done = promise.eagerlyEvaluate(nullptr).fork();
+
+    int64_t ticket = client->next_ticket++;
+    client->pending.emplace(ticket, std::move(call));
+    return ticket;
+  }
+  CATCH_AND_REPORT(client, -1)
+}
+
+/**
+ * @details
+ * Runs the event loop once without blocking, so that responses which have
+ * already arrived are processed, then reports the state of @a ticket.
+ */
+int32_t pot_calculate_poll(PotClient *client, int64_t ticket) {
+  if (!client)
+    return -1;
+  try {
+    auto it = client->pending.find(ticket);
+    if (it == client->pending.end()) {
+      client->last_error = "Unknown ticket";
+      return -1;
+    }
+    PendingCall &call = *it->second;
+    if (client->shm) {
+      if (call.status == 1 && client->shm->ready(call.slot)) {
+        client->finish_shm(call);
+      }
+    } else {
+      client->wait_scope->poll();
+    }
+    return call.status == 1 ? 1 : 0;
+  }
+  CATCH_AND_REPORT(client, -1)
+}
+
+/**
+ * @details
+ * Drives the event loop until the call behind @a ticket has finished, then
+ * removes it. Other in-flight calls whose responses arrive meanwhile are
+ * completed as well and keep their results until collected.
+ */
+int32_t pot_calculate_wait(PotClient *client, int64_t ticket) {
+  if (!client)
+    return -1;
+  try {
+    auto it = client->pending.find(ticket);
+    if (it == client->pending.end()) {
+      client->last_error = "Unknown ticket";
+      return -1;
+    }
+    if (it->second->status == 1 && client->shm) {
+      client->shm->wait(it->second->slot);
+      client->finish_shm(*it->second);
+    } else if (it->second->status == 1) {
+      KJ_ASSERT_NONNULL(it->second->done).addBranch().wait(*client->wait_scope);
+    }
+    return client->collect(it);
+  }
+  CATCH_AND_REPORT(client, -1)
+}
+
+/**
+ * @details
+ * Joins the completion signals of all listed in-flight calls with
+ * @c kj::Promise::exclusiveJoin and waits on the result. When several
+ * calls have finished, the one listed first is returned.
+ *
+ * @warning Every entry of @a tickets must refer to an uncollected call,
+ * otherwise -1 is returned without waiting.
+ */
+int32_t pot_calculate_wait_any(PotClient *client, const int64_t *tickets,
+                               int32_t nticket, int32_t *out_index) {
+  if (!client)
+    return -1;
+  client->last_error.clear();
+  if (!tickets || !out_index || nticket <= 0) {
+    client->last_error = "No tickets to wait on";
+    return -1;
+  }
 
-    *out_energy = result.getEnergy();
+  try {
+    auto first_done = [&]() -> int32_t {
+      for (int32_t k = 0; k < nticket; ++k) {
+        if (client->pending.at(tickets[k])->status != 1) {
+          return k;
+        }
+      }
+      return -1;
+    };
 
-    // ---------------------------------------------------------
-    // RETRIEVAL - Bulk Copy Back
-    // ---------------------------------------------------------
+    for (int32_t k = 0; k < nticket; ++k) {
+      if (client->pending.find(tickets[k]) == client->pending.end()) {
+        client->last_error = "Unknown ticket";
+        return -1;
+      }
+    }
+
+    int32_t idx = first_done();
+    if (idx < 0 && client->shm) {
+      std::vector<uint32_t> slots;
+      for (int32_t k = 0; k < nticket; ++k) {
+        slots.push_back(client->pending.at(tickets[k])->slot);
+      }
+      const size_t k = client->shm->wait_any(slots);
+      client->finish_shm(*client->pending.at(tickets[k]));
+      idx = first_done();
+    } else if (idx < 0) {
+      kj::Promise<void> any =
+          KJ_ASSERT_NONNULL(client->pending.at(tickets[0])->done).addBranch();
+      for (int32_t k = 1; k < nticket; ++k) {
+        any = any.exclusiveJoin(
+            KJ_ASSERT_NONNULL(client->pending.at(tickets[k])->done)
+                .addBranch());
+      }
+      any.wait(*client->wait_scope);
+      idx = first_done();
+    }
+
+    *out_index = idx;
+    return client->collect(client->pending.find(tickets[idx]));
+  }
+  CATCH_AND_REPORT(client, -1)
+}
+
+/**
+ * @details
+ * Builds one @c calculateBatch request holding @a nconf configurations,
+ * each with its own slice of @a pos and @a boxes and a copy of @a atmnrs,
+ * then copies the results back in input order.
+ *
+ * Over shared memory there is no batch message: the configurations are
+ * submitted one slot each, keeping a few in flight so that the server
+ * threads work on them concurrently.
+ *
+ * With several endpoints the batch is split into one contiguous chunk per
+ * endpoint that is up, each sent as its own @c calculateBatch request and
+ * resent elsewhere if its endpoint disconnects. The first failing chunk
+ * determines the result.
+ *
+ * @warning The server must return @a nconf results, each with a force
+ * array matching @a natoms * 3. Otherwise a non-zero error code is
+ * returned and the output buffers may be partially written.
+ */
+int32_t pot_calculate_batch(PotClient *client, int32_t nconf, int32_t natoms,
+                            const double *pos, const int32_t *atmnrs,
+                            const double *boxes, double *out_energies,
+                            double *out_forces) {
 
-    auto res_forces = result.getForces();
+  // Safety Checks
+  if (!client)
+    return -1;
+  client->last_error.clear();
+  if (nconf < 0 || natoms < 0) {
+    client->last_error = "Negative configuration or atom count";
+    return -1;
+  }
 
-    // Strict runtime check to ensure server didn't return garbage size
-    if (res_forces.size() != static_cast<size_t>(natoms * 3)) {
-      client->last_error = "Server returned force array of incorrect size";
-      return -2;
+  if (client->shm) {
+    constexpr size_t window = 8;
+    const size_t stride = static_cast<size_t>(natoms) * 3;
+    std::deque<int64_t> inflight;
+    int32_t status = 0;
+    for (int32_t c = 0; c < nconf && status == 0; ++c) {
+      if (inflight.size() == window) {
+        status = pot_calculate_wait(client, inflight.front());
+        inflight.pop_front();
+        if (status != 0) {
+          break;
+        }
+      }
+      const int64_t ticket = pot_calculate_submit(
+          client, natoms, pos + c * stride, atmnrs, boxes + c * 9,
+          out_energies + c, out_forces + c * stride);
+      if (ticket < 0) {
+        status = -1;
+        break;
+      }
+      inflight.push_back(ticket);
     }
+    // Every slot is collected, the first failure is reported
+    std::string error = client->last_error;
+    for (int64_t ticket : inflight) {
+      const int32_t rc = pot_calculate_wait(client, ticket);
+      if (rc != 0 && status == 0) {
+        status = rc;
+        error = client->last_error;
+      }
+    }
+    client->last_error = status == 0 ? std::string() : error;
+    return status;
+  }
 
-    for (size_t i = 0; i < res_forces.size(); ++i) {
-      out_forces[i] = res_forces[i];
+  try {
+    client->probe_due();
+    size_t up = 0;
+    for (const auto &ep : client->endpoints) {
+      up += ep.failures == 0 ? 1 : 0;
+    }
+    const int32_t nchunk = std::min<int32_t>(
+        nconf, static_cast<int32_t>(std::max<size_t>(1, up)));
+    const BatchCall batch{natoms, pos, atmnrs, boxes, out_energies,
+                          out_forces};
+    std::vector<BatchChunk> chunks(nchunk);
+    kj::Vector<kj::Promise<void>> promises;
+    for (int32_t k = 0; k < nchunk; ++k) {
+      chunks[k].begin = static_cast<int32_t>(int64_t{k} * nconf / nchunk);
+      chunks[k].count =
+          static_cast<int32_t>(int64_t{k + 1} * nconf / nchunk) -
+          chunks[k].begin;
+      promises.add(client->send_batch(&batch, &chunks[k], client->acquire())
+                       .eagerlyEvaluate(nullptr));
     }
 
+    // Execute RPC
+    kj::joinPromises(promises.releaseAsArray()).wait(*client->wait_scope);
+
+    for (const auto &chunk : chunks) {
+      if (chunk.status != 0) {
+        client->last_error = chunk.error;
+        return chunk.status;
+      }
+    }
     return 0;
   }
   CATCH_AND_REPORT(client, -1)
 }
 
+/**
+ * @details
+ * Sends @c openSession to the least loaded endpoint without waiting for
+ * the reply; a server unable to open the session fails the first step.
+ */
+PotSession *pot_session_open(PotClient *client, int32_t natoms,
+                             const int32_t *atmnrs, const double *box) {
+  if (!client)
+    return nullptr;
+  client->last_error.clear();
+  if (natoms < 0 || (natoms > 0 && !atmnrs) || !box) {
+    client->last_error = "Invalid session system";
+    return nullptr;
+  }
+  if (client->shm) {
+    client->last_error = "Sessions need an RPC connection";
+    return nullptr;
+  }
+  try {
+    auto session = std::make_unique<PotSession>();
+    session->client = client;
+    session->atmnrs.assign(atmnrs, atmnrs + natoms);
+    session->box.assign(box, box + 9);
+    session->sent.assign(static_cast<size_t>(natoms) * 3, 0.0);
+    session->open(client->acquire());
+    return session.release();
+  }
+  CATCH_AND_REPORT(client, nullptr)
+}
+
+/**
+ * @details
+ * Picks the smallest frame for the change since the previous step, see
+ * @c PotSession::fill. Errors are reported through the owning client.
+ */
+int32_t pot_session_step(PotSession *session, const double *pos,
+                         const double *box, double *out_energy,
+                         double *out_forces) {
+  if (!session)
+    return -1;
+  PotClient *client = session->client;
+  client->last_error.clear();
+  if ((!session->sent.empty() && (!pos || !out_forces)) || !out_energy) {
+    client->last_error = "Null session step buffer";
+    return -1;
+  }
+  try {
+    return session->step(pos, box, out_energy, out_forces);
+  }
+  CATCH_AND_REPORT(client, -1)
+}
+
+/**
+ * @details
+ * Takes effect from the next step.
+ */
+int32_t pot_session_set_float_shifts(PotSession *session, int32_t enable) {
+  if (!session)
+    return -1;
+  session->float_shifts = enable != 0;
+  return 0;
+}
+
+/**
+ * @details
+ * Dropping the capability ends the session on the server once its last
+ * step has finished.
+ */
+void pot_session_free(PotSession *session) { delete session; }
+
 /**
  * @details
  * Checks if a valid client handle is provided and if the @c last_error
@@ -21,15 +21,53 @@ extern "C" {
  */
 typedef struct PotClient PotClient;
 
+/**
+ * @brief Opaque handle to a session of a client.
+ */
+typedef struct PotSession PotSession;
+
+/**
+ * @brief Return code of calls refused because the servers were overloaded.
+ *
+ * Every endpoint tried had its queue full (see @c potserv @c --max-queue);
+ * the call was not evaluated and may be retried later.
+ */
+#define POT_OVERLOADED (-3)
+
 /**
  * @brief Initializes the RPC client connection.
- * @param host Target server hostname or IP address.
- * @param port Network port of the potential server.
+ *
+ * @a host may list several comma-separated endpoints, each @c HOST,
+ * @c HOST:PORT or @c unix:PATH (a @c potserv started with @c --unix
+ * @c PATH). Calls then go to the endpoint with the fewest requests in
+ * flight and are resent to another one when theirs has disconnected;
+ * endpoints that failed are skipped until a health check succeeds.
+ *
+ * A @a host of the form @c shm://NAME maps the shared memory segment of a
+ * @c potserv on the same node started with @c --shm @c NAME, bypassing the
+ * network; @a port is then ignored.
+ *
+ * @param host Target server hostname or IP address, an endpoint list or a
+ * @c shm:// address.
+ * @param port Network port of the potential server, for endpoints naming
+ * none.
  * @return Pointer to the client context or @c NULL on failure.
  * @see pot_get_last_error
  */
 PotClient *pot_client_init(const char *host, int32_t port);
 
+/**
+ * @brief Caps the requests kept in flight on each endpoint.
+ *
+ * @c pot_calculate_submit and @c pot_calculate_batch wait for a call of
+ * the client to finish while every endpoint is at the cap.
+ *
+ * @param client The opaque client handle.
+ * @param limit Requests per endpoint, 0 (the default) for no cap.
+ * @return 0 on success, non-zero on failure.
+ */
+int32_t pot_client_set_endpoint_limit(PotClient *client, int32_t limit);
+
 /**
  * @brief Frees all resources associated with the client.
  * @param client The opaque client handle to release.
@@ -47,12 +85,151 @@ void pot_client_free(PotClient *client);
  * @param box Simulation cell vectors in row-major order.
  * @param out_energy Pointer to store the calculated energy.
  * @param out_forces Buffer to store the calculated forces.
- * @return 0 on success, non-zero on failure.
+ * @return 0 on success, @c POT_OVERLOADED if the servers refused the call,
+ * other non-zero values on failure.
  */
 int32_t pot_calculate(PotClient *client, int32_t natoms, const double *pos,
                       const int32_t *atmnrs, const double *box,
                       double *out_energy, double *out_forces);
 
+/**
+ * @brief Executes several remote calculations in a single round trip.
+ * @pre The @a client must be successfully initialized.
+ * @param client The opaque client handle.
+ * @param nconf Number of configurations.
+ * @param natoms Number of atoms in every configuration.
+ * @param pos Array of flattened coordinates [nconf * natoms * 3].
+ * @param atmnrs Array of atomic numbers [natoms], shared by all
+ * configurations.
+ * @param boxes Simulation cells in row-major order [nconf * 9].
+ * @param out_energies Buffer to store the energies [nconf].
+ * @param out_forces Buffer to store the forces [nconf * natoms * 3].
+ * @return 0 on success, @c POT_OVERLOADED if the servers refused the
+ * batch, other non-zero values on failure.
+ */
+int32_t pot_calculate_batch(PotClient *client, int32_t nconf, int32_t natoms,
+                            const double *pos, const int32_t *atmnrs,
+                            const double *boxes, double *out_energies,
+                            double *out_forces);
+
+/**
+ * @brief Sends a remote calculation without waiting for the result.
+ *
+ * The inputs are copied into the request before this returns, so @a pos,
+ * @a atmnrs and @a box may be reused immediately. @a out_energy and
+ * @a out_forces are written when the result arrives and must stay valid
+ * until the ticket is collected with @c pot_calculate_wait or
+ * @c pot_calculate_wait_any.
+ *
+ * @pre The @a client must be successfully initialized.
+ * @param client The opaque client handle.
+ * @param natoms Total number of atoms in the system.
+ * @param pos Array of flattened atomic coordinates.
+ * @param atmnrs Array of atomic numbers.
+ * @param box Simulation cell vectors in row-major order.
+ * @param out_energy Pointer to store the calculated energy.
+ * @param out_forces Buffer to store the calculated forces.
+ * @return A positive ticket on success, negative on failure.
+ */
+int64_t pot_calculate_submit(PotClient *client, int32_t natoms,
+                             const double *pos, const int32_t *atmnrs,
+                             const double *box, double *out_energy,
+                             double *out_forces);
+
+/**
+ * @brief Checks whether a submitted calculation has finished.
+ *
+ * Processes pending network events without blocking.
+ *
+ * @param client The opaque client handle.
+ * @param ticket A ticket returned by @c pot_calculate_submit.
+ * @return 1 while in flight, 0 once finished, -1 for an unknown ticket.
+ */
+int32_t pot_calculate_poll(PotClient *client, int64_t ticket);
+
+/**
+ * @brief Blocks until a submitted calculation finishes and releases it.
+ * @param client The opaque client handle.
+ * @param ticket A ticket returned by @c pot_calculate_submit.
+ * @return The status @c pot_calculate would have returned for the call.
+ */
+int32_t pot_calculate_wait(PotClient *client, int64_t ticket);
+
+/**
+ * @brief Blocks until any of several calculations finishes and releases it.
+ *
+ * The remaining tickets stay in flight and may be waited on again.
+ *
+ * @param client The opaque client handle.
+ * @param tickets Array of tickets returned by @c pot_calculate_submit.
+ * @param nticket Number of entries in @a tickets.
+ * @param out_index Receives the position in @a tickets of the finished
+ * call.
+ * @return The status @c pot_calculate would have returned for that call.
+ */
+int32_t pot_calculate_wait_any(PotClient *client, const int64_t *tickets,
+                               int32_t nticket, int32_t *out_index);
+
+/**
+ * @brief Opens a session streaming the frames of one system.
+ *
+ * The atomic numbers and box are sent once; each step then sends only the
+ * positions, or just those of the atoms that moved, and the server keeps a
+ * potential instance for the session whose neighbor list follows the
+ * trajectory. Meant for MD, NEB and Monte Carlo drivers evaluating many
+ * frames of the same system. Not available over shared memory.
+ *
+ * @param client The opaque client handle, must outlive the session.
+ * @param natoms Number of atoms of the system.
+ * @param atmnrs Array of atomic numbers [natoms].
+ * @param box Initial simulation cell in row-major order.
+ * @return The session, or @c NULL with the error set on @a client.
+ */
+PotSession *pot_session_open(PotClient *client, int32_t natoms,
+                             const int32_t *atmnrs, const double *box);
+
+/**
+ * @brief Evaluates the next frame of a session.
+ *
+ * Frames where at most half of the atoms moved are sent as those atoms
+ * only and updated incrementally by potentials that support it. A session
+ * whose endpoint disconnects is reopened on another endpoint.
+ *
+ * @param session The session handle.
+ * @param pos Array of flattened atomic coordinates [natoms * 3].
+ * @param box New simulation cell, or @c NULL if unchanged.
+ * @param out_energy Pointer to store the calculated energy.
+ * @param out_forces Buffer to store the calculated forces.
+ * @return 0 on success, @c POT_OVERLOADED if the server refused the step,
+ * other non-zero values on failure, with the error set on the session's
+ * client.
+ */
+int32_t pot_session_step(PotSession *session, const double *pos,
+                         const double *box, double *out_energy,
+                         double *out_forces);
+
+/**
+ * @brief Allows frames sent as Float32 coordinate changes.
+ *
+ * Halves the traffic of frames where most atoms moved, such as MD steps.
+ * The server then evaluates positions that differ from the requested ones
+ * by the Float32 rounding of each step's displacement; errors do not
+ * accumulate, as the client tracks the positions the server holds.
+ *
+ * @param session The session handle.
+ * @param enable Non-zero to allow shifts, 0 (the default) for exact
+ * positions.
+ * @return 0 on success, non-zero on failure.
+ */
+int32_t pot_session_set_float_shifts(PotSession *session, int32_t enable);
+
+/**
+ * @brief Closes a session and frees its resources.
+ * @param session The session handle to release.
+ * @return Void.
+ */
+void pot_session_free(PotSession *session);
+
 /**
  * @brief Retrieves the most recent error message.
  * @param client The opaque client handle.
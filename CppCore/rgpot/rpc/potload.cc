@@ -0,0 +1,543 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Load generator and latency report for potential servers.
+ *
+ * Drives one or more @c potserv endpoints through the C client bridge and
+ * reports throughput together with the latency distribution. Each
+ * connection runs on its own thread with its own @c PotClient and keeps up
+ * to @c --inflight requests pipelined.
+ *
+ * In the default closed loop every connection sends a new request as soon
+ * as one completes. With @c --rate the loop is open: requests are scheduled
+ * at fixed intervals and latencies are measured from the time a request was
+ * due rather than the time it was sent, so a stalled server is charged for
+ * the requests it delayed instead of silently slowing the generator down
+ * (coordinated omission). Closed-loop runs can apply the equivalent
+ * correction with @c --expected-interval.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rgpot/LatencyHistogram.hpp"
+#include "rgpot/rpc/pot_bridge.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Address of one potential server.
+ */
+struct Endpoint {
+  std::string host; //!< Hostname or IP address.
+  int32_t port;     //!< Network port.
+};
+
+/**
+ * @brief One system size of the request mix.
+ */
+struct MixEntry {
+  int32_t natoms; //!< Number of atoms.
+  double weight;  //!< Relative frequency.
+};
+
+/**
+ * @brief Command line settings.
+ */
+struct Options {
+  std::vector<Endpoint> endpoints;    //!< Servers, used round robin.
+  size_t connections = 1;             //!< Client connections (threads).
+  size_t inflight = 1;                //!< Pipelined requests per connection.
+  double rate = 0.0;                  //!< Total requests/s, 0 = closed loop.
+  double duration = 10.0;             //!< Measured seconds.
+  double warmup = 1.0;                //!< Unrecorded seconds before.
+  uint64_t expected_interval_ns = 0;  //!< Closed-loop correction interval.
+  std::vector<MixEntry> mix{{64, 1}}; //!< System sizes and weights.
+  int32_t atomic_number = 1;          //!< Atomic number of every atom.
+  double spacing = 1.12;              //!< Lattice spacing.
+  double jitter = 0.01;               //!< Per-request displacement.
+  std::string json_path;              //!< JSON report, empty for none.
+};
+
+/**
+ * @brief Reference configuration of one mix entry.
+ */
+struct Frame {
+  int32_t natoms = 0;          //!< Number of atoms.
+  std::vector<double> pos;     //!< Lattice positions [natoms * 3].
+  std::vector<int32_t> atmnrs; //!< Atomic numbers [natoms].
+  std::vector<double> box;     //!< Cubic cell, row-major [9].
+};
+
+/**
+ * @brief Outcome of one connection.
+ */
+struct WorkerResult {
+  rgpot::LatencyHistogram latency; //!< Latencies of measured requests [ns].
+  uint64_t completed = 0;          //!< Measured successful requests.
+  uint64_t errors = 0;             //!< Measured failed requests.
+  uint64_t overloaded = 0;         //!< Failed ones refused as overloaded.
+  uint64_t atoms = 0;              //!< Atoms of the successful requests.
+  std::string error;               //!< First error message.
+};
+
+/**
+ * @brief A request slot, whose output buffers outlive the request.
+ */
+struct Slot {
+  int64_t ticket = -1;     //!< Bridge ticket while in flight.
+  Clock::time_point start; //!< Due time (open) or send time (closed).
+  size_t entry = 0;        //!< Index into the mix.
+  double energy = 0.0;     //!< Output energy.
+  std::vector<double> forces; //!< Output forces.
+};
+
+/**
+ * @brief Builds a cubic lattice for every mix entry.
+ * @param opts The settings.
+ * @return One reference frame per entry of @c opts.mix.
+ */
+std::vector<Frame> make_frames(const Options &opts) {
+  std::vector<Frame> frames;
+  for (const MixEntry &m : opts.mix) {
+    Frame f;
+    f.natoms = m.natoms;
+    const auto side = static_cast<int32_t>(
+        std::ceil(std::cbrt(static_cast<double>(m.natoms)) - 1e-9));
+    const double len = side * opts.spacing;
+    f.box = {len, 0.0, 0.0, 0.0, len, 0.0, 0.0, 0.0, len};
+    f.atmnrs.assign(m.natoms, opts.atomic_number);
+    f.pos.reserve(static_cast<size_t>(m.natoms) * 3);
+    for (int32_t i = 0; i < m.natoms; ++i) {
+      f.pos.push_back((i % side) * opts.spacing);
+      f.pos.push_back(((i / side) % side) * opts.spacing);
+      f.pos.push_back((i / (side * side)) * opts.spacing);
+    }
+    frames.push_back(std::move(f));
+  }
+  return frames;
+}
+
+/**
+ * @brief Runs one connection until its share of the test is done.
+ * @param opts The settings.
+ * @param frames Reference frames of the mix.
+ * @param index Index of the connection.
+ * @param t_begin Start of the warmup, shared by all connections.
+ * @param out Receives the outcome.
+ * @return Void.
+ */
+void run_connection(const Options &opts, const std::vector<Frame> &frames,
+                    size_t index, Clock::time_point t_begin,
+                    WorkerResult &out) {
+  const Endpoint &ep = opts.endpoints[index % opts.endpoints.size()];
+  PotClient *client = pot_client_init(ep.host.c_str(), ep.port);
+  if (!client) {
+    out.error = "Could not create a client for " + ep.host;
+    return;
+  }
+
+  const auto t_measure =
+      t_begin + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(opts.warmup));
+  const auto t_end =
+      t_measure + std::chrono::duration_cast<Clock::duration>(
+                      std::chrono::duration<double>(opts.duration));
+  const bool open_loop = opts.rate > 0.0;
+  const auto interval =
+      open_loop ? std::chrono::duration_cast<Clock::duration>(
+                      std::chrono::duration<double>(opts.connections /
+                                                    opts.rate))
+                : Clock::duration::zero();
+  // Connections are staggered so that the aggregate schedule is even
+  auto next_due = t_begin + interval * index / opts.connections;
+
+  std::mt19937_64 rng(0x5eed + index);
+  std::vector<double> weights;
+  int32_t max_atoms = 0;
+  for (const MixEntry &m : opts.mix) {
+    weights.push_back(m.weight);
+    max_atoms = std::max(max_atoms, m.natoms);
+  }
+  std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+  std::normal_distribution<double> noise(0.0,
+                                         opts.jitter > 0.0 ? opts.jitter : 1.0);
+  std::vector<double> pos(static_cast<size_t>(max_atoms) * 3);
+
+  std::vector<Slot> slots(std::max<size_t>(1, opts.inflight));
+  for (Slot &s : slots) {
+    s.forces.resize(static_cast<size_t>(max_atoms) * 3);
+  }
+  std::vector<size_t> idle(slots.size());
+  for (size_t k = 0; k < slots.size(); ++k) {
+    idle[k] = slots.size() - 1 - k;
+  }
+  std::vector<int64_t> tickets; // In-flight tickets, parallel to `busy`
+  std::vector<size_t> busy;
+  bool failed = false;
+
+  auto submit = [&](Clock::time_point start) {
+    const size_t k = idle.back();
+    Slot &s = slots[k];
+    s.entry = pick(rng);
+    const Frame &f = frames[s.entry];
+    const size_t n = f.pos.size();
+    for (size_t i = 0; i < n; ++i) {
+      pos[i] = opts.jitter > 0.0 ? f.pos[i] + noise(rng) : f.pos[i];
+    }
+    s.start = start;
+    s.ticket = pot_calculate_submit(client, f.natoms, pos.data(),
+                                    f.atmnrs.data(), f.box.data(), &s.energy,
+                                    s.forces.data());
+    if (s.ticket < 0) {
+      if (start >= t_measure) {
+        ++out.errors;
+      }
+      if (out.error.empty()) {
+        out.error = pot_get_last_error(client);
+      }
+      return;
+    }
+    idle.pop_back();
+    tickets.push_back(s.ticket);
+    busy.push_back(k);
+  };
+
+  auto complete = [&](size_t pos_in_busy, int32_t status) {
+    const auto now = Clock::now();
+    const size_t k = busy[pos_in_busy];
+    Slot &s = slots[k];
+    if (s.start >= t_measure) {
+      if (status == 0) {
+        const auto ns = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(now -
+                                                                 s.start)
+                .count());
+        out.latency.record_corrected(ns, opts.expected_interval_ns);
+        ++out.completed;
+        out.atoms += static_cast<uint64_t>(frames[s.entry].natoms);
+      } else {
+        ++out.errors;
+        out.overloaded += status == POT_OVERLOADED ? 1 : 0;
+      }
+    }
+    if (status != 0 && out.error.empty()) {
+      out.error = pot_get_last_error(client);
+    }
+    s.ticket = -1;
+    busy.erase(busy.begin() + static_cast<std::ptrdiff_t>(pos_in_busy));
+    tickets.erase(tickets.begin() + static_cast<std::ptrdiff_t>(pos_in_busy));
+    idle.push_back(k);
+  };
+
+  while (!failed) {
+    const auto now = Clock::now();
+    if (open_loop) {
+      while (!idle.empty() && next_due <= now && next_due < t_end) {
+        submit(next_due);
+        next_due += interval;
+      }
+    } else {
+      while (!idle.empty() && now < t_end) {
+        const size_t before = idle.size();
+        submit(Clock::now());
+        if (idle.size() == before) {
+          break; // Submission failed, back off until the next round
+        }
+      }
+    }
+
+    const bool more = open_loop ? next_due < t_end : now < t_end;
+    if (busy.empty()) {
+      if (!more) {
+        break;
+      }
+      if (open_loop) {
+        std::this_thread::sleep_until(next_due);
+      } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      continue;
+    }
+
+    if (open_loop && more && !idle.empty()) {
+      // A request falls due before any free slot is needed, poll only
+      bool any = false;
+      for (size_t b = 0; b < busy.size();) {
+        const int32_t state = pot_calculate_poll(client, tickets[b]);
+        if (state == 0) {
+          complete(b, pot_calculate_wait(client, tickets[b]));
+          any = true;
+        } else if (state < 0) {
+          failed = true;
+          break;
+        } else {
+          ++b;
+        }
+      }
+      if (!any && !failed) {
+        std::this_thread::sleep_for(std::min<Clock::duration>(
+            next_due - Clock::now(), std::chrono::microseconds(20)));
+      }
+      continue;
+    }
+
+    int32_t which = -1;
+    const int32_t status = pot_calculate_wait_any(
+        client, tickets.data(), static_cast<int32_t>(tickets.size()), &which);
+    if (which < 0 || static_cast<size_t>(which) >= busy.size()) {
+      failed = true;
+      break;
+    }
+    complete(static_cast<size_t>(which), status);
+  }
+
+  if (failed && out.error.empty()) {
+    out.error = pot_get_last_error(client);
+  }
+  pot_client_free(client);
+}
+
+/**
+ * @brief Reads the value of an option given as `--flag V` or `--flag=V`.
+ * @param flag The option, including the dashes.
+ * @param i Index of the current argument, advanced past a separate value.
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @param value Receives the value.
+ * @return Whether the current argument is @a flag.
+ */
+bool take_option(const std::string &flag, int &i, int argc, char *argv[],
+                 std::string &value) {
+  const std::string arg = argv[i];
+  if (arg == flag && i + 1 < argc) {
+    value = argv[++i];
+    return true;
+  }
+  if (arg.rfind(flag + "=", 0) == 0) {
+    value = arg.substr(flag.size() + 1);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Parses a request mix such as `64:3,512:1`.
+ * @param spec Comma separated entries of atoms with an optional weight.
+ * @return The entries.
+ * @throws std::invalid_argument For malformed entries.
+ */
+std::vector<MixEntry> parse_mix(const std::string &spec) {
+  std::vector<MixEntry> mix;
+  std::stringstream ss(spec);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    const auto colon = item.find(':');
+    MixEntry m{std::stoi(item.substr(0, colon)), 1.0};
+    if (colon != std::string::npos) {
+      m.weight = std::stod(item.substr(colon + 1));
+    }
+    if (m.natoms <= 0 || m.weight <= 0.0) {
+      throw std::invalid_argument("mix entry '" + item + "'");
+    }
+    mix.push_back(m);
+  }
+  if (mix.empty()) {
+    throw std::invalid_argument("empty mix");
+  }
+  return mix;
+}
+
+/**
+ * @brief Prints the command line help.
+ * @param prog Name of the executable.
+ * @return Void.
+ */
+void usage(const char *prog) {
+  std::cerr
+      << "Usage: " << prog << " [options] HOST:PORT [HOST:PORT ...]\n"
+      << "  --connections N        client connections, spread round robin\n"
+      << "                         over the endpoints (default 1)\n"
+      << "  --inflight K           pipelined requests per connection "
+         "(default 1)\n"
+      << "  --rate R               open loop at R requests/s in total; "
+         "closed\n"
+      << "                         loop when omitted\n"
+      << "  --duration S           measured seconds (default 10)\n"
+      << "  --warmup S             unrecorded seconds before (default 1)\n"
+      << "  --mix N[:W],...        system sizes in atoms and their weights\n"
+      << "                         (default 64)\n"
+      << "  --atomic-number Z      atomic number of every atom (default 1)\n"
+      << "  --spacing A            lattice spacing (default 1.12)\n"
+      << "  --jitter A             random displacement per request, 0 "
+         "repeats\n"
+      << "                         identical frames (default 0.01)\n"
+      << "  --expected-interval US closed loop: back-fill requests a stall\n"
+      << "                         held back, in microseconds\n"
+      << "  --json PATH            also write the report as JSON"
+      << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    std::string value;
+    try {
+      if (take_option("--connections", i, argc, argv, value)) {
+        opts.connections = std::max<size_t>(1, std::stoul(value));
+      } else if (take_option("--inflight", i, argc, argv, value)) {
+        opts.inflight = std::max<size_t>(1, std::stoul(value));
+      } else if (take_option("--rate", i, argc, argv, value)) {
+        opts.rate = std::stod(value);
+      } else if (take_option("--duration", i, argc, argv, value)) {
+        opts.duration = std::stod(value);
+      } else if (take_option("--warmup", i, argc, argv, value)) {
+        opts.warmup = std::max(0.0, std::stod(value));
+      } else if (take_option("--mix", i, argc, argv, value)) {
+        opts.mix = parse_mix(value);
+      } else if (take_option("--atomic-number", i, argc, argv, value)) {
+        opts.atomic_number = std::stoi(value);
+      } else if (take_option("--spacing", i, argc, argv, value)) {
+        opts.spacing = std::stod(value);
+      } else if (take_option("--jitter", i, argc, argv, value)) {
+        opts.jitter = std::max(0.0, std::stod(value));
+      } else if (take_option("--expected-interval", i, argc, argv, value)) {
+        opts.expected_interval_ns =
+            static_cast<uint64_t>(std::stod(value) * 1e3);
+      } else if (take_option("--json", i, argc, argv, value)) {
+        opts.json_path = value;
+      } else {
+        const std::string arg = argv[i];
+        const auto colon = arg.rfind(':');
+        if (arg.rfind("--", 0) == 0 || colon == std::string::npos) {
+          usage(argv[0]);
+          return 1;
+        }
+        opts.endpoints.push_back(
+            {arg.substr(0, colon), std::stoi(arg.substr(colon + 1))});
+      }
+    } catch (const std::exception &e) {
+      std::cerr << "Invalid argument '" << argv[i] << "': " << e.what()
+                << std::endl;
+      return 1;
+    }
+  }
+  if (opts.endpoints.empty() || opts.duration <= 0.0 || opts.rate < 0.0) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  const std::vector<Frame> frames = make_frames(opts);
+  std::vector<WorkerResult> results(opts.connections);
+  std::vector<std::thread> threads;
+  const auto t_begin = Clock::now();
+  for (size_t c = 0; c < opts.connections; ++c) {
+    threads.emplace_back(run_connection, std::cref(opts), std::cref(frames),
+                         c, t_begin, std::ref(results[c]));
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  rgpot::LatencyHistogram latency;
+  uint64_t completed = 0;
+  uint64_t errors = 0;
+  uint64_t overloaded = 0;
+  uint64_t atoms = 0;
+  std::vector<uint64_t> ep_completed(opts.endpoints.size(), 0);
+  std::vector<uint64_t> ep_errors(opts.endpoints.size(), 0);
+  for (size_t c = 0; c < results.size(); ++c) {
+    const WorkerResult &r = results[c];
+    latency.merge(r.latency);
+    completed += r.completed;
+    errors += r.errors;
+    overloaded += r.overloaded;
+    atoms += r.atoms;
+    ep_completed[c % opts.endpoints.size()] += r.completed;
+    ep_errors[c % opts.endpoints.size()] += r.errors;
+    if (!r.error.empty()) {
+      std::cerr << "connection " << c << ": " << r.error << std::endl;
+    }
+  }
+
+  const double throughput = completed / opts.duration;
+  const double atom_rate = atoms / opts.duration;
+  const std::vector<std::pair<const char *, double>> percentiles{
+      {"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p999", 99.9}};
+  auto us = [](double ns) { return ns / 1e3; };
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "potload: " << opts.endpoints.size() << " endpoint(s), "
+            << opts.connections << " connection(s) x " << opts.inflight
+            << " in flight, ";
+  if (opts.rate > 0.0) {
+    std::cout << "open loop at " << opts.rate << " req/s\n";
+  } else {
+    std::cout << "closed loop\n";
+  }
+  std::cout << "  requests    " << completed << " ok, " << errors
+            << " failed (" << overloaded << " overloaded) in "
+            << opts.duration << " s\n"
+            << "  throughput  " << throughput << " req/s, " << atom_rate
+            << " atoms/s\n"
+            << "  latency us  min " << us(latency.min()) << "  mean "
+            << us(latency.mean());
+  for (const auto &[name, p] : percentiles) {
+    std::cout << "  " << name << " " << us(latency.value_at_percentile(p));
+  }
+  std::cout << "  max " << us(latency.max()) << std::endl;
+  if (latency.count() != completed) {
+    std::cout << "  (" << latency.count() - completed
+              << " samples back-filled for coordinated omission)"
+              << std::endl;
+  }
+
+  if (!opts.json_path.empty()) {
+    std::ofstream js(opts.json_path);
+    js << std::setprecision(17);
+    js << "{\n  \"mode\": \"" << (opts.rate > 0.0 ? "open" : "closed")
+       << "\",\n  \"rate\": " << opts.rate
+       << ",\n  \"connections\": " << opts.connections
+       << ",\n  \"inflight\": " << opts.inflight
+       << ",\n  \"duration_s\": " << opts.duration
+       << ",\n  \"requests\": " << completed << ",\n  \"errors\": " << errors
+       << ",\n  \"overloaded\": " << overloaded
+       << ",\n  \"throughput_rps\": " << throughput
+       << ",\n  \"atoms_per_s\": " << atom_rate
+       << ",\n  \"latency_ns\": {\"samples\": " << latency.count()
+       << ", \"min\": " << latency.min() << ", \"mean\": " << latency.mean();
+    for (const auto &[name, p] : percentiles) {
+      js << ", \"" << name << "\": " << latency.value_at_percentile(p);
+    }
+    js << ", \"max\": " << latency.max() << "},\n  \"endpoints\": [";
+    for (size_t e = 0; e < opts.endpoints.size(); ++e) {
+      js << (e ? ", " : "") << "{\"address\": \"" << opts.endpoints[e].host
+         << ":" << opts.endpoints[e].port
+         << "\", \"requests\": " << ep_completed[e]
+         << ", \"errors\": " << ep_errors[e] << "}";
+    }
+    js << "]\n}\n";
+    if (!js) {
+      std::cerr << "Could not write " << opts.json_path << std::endl;
+      return 1;
+    }
+  }
+  return completed > 0 ? 0 : 1;
+}
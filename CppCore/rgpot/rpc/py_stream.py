@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+
+
+# /// script
+# requires-python = ">=3.12"
+# dependencies = [
+#   "pycapnp",
+#   "ase",
+# ]
+# ///
+
+# Usage (needs the environment setup):
+# 1. Start a server (e.g. in tmux)
+# ./bbdir/CppCore/rgpot/rpc/potserv 12345 LJ
+# 2. Run client
+# uv run CppCore/rgpot/rpc/py_stream.py localhost:12345 --count 5000
+
+import argparse
+import asyncio
+import time
+
+import capnp
+import numpy as np
+import Potentials_capnp
+from ase.build import bulk
+
+
+def parse_args():
+    """Parses command-line arguments."""
+    parser = argparse.ArgumentParser(
+        description="Streams a sweep of rattled structures through one server."
+    )
+    parser.add_argument("host", help="HOST:PORT")
+    parser.add_argument(
+        "--count", type=int, default=1000, help="Number of structures to evaluate."
+    )
+    parser.add_argument(
+        "--window",
+        type=int,
+        default=0,
+        help="Structures evaluated at once by the server, 0 for its default.",
+    )
+    return parser.parse_args()
+
+
+def atoms_to_force_input(atoms):
+    """Converts an ASE Atoms object to a Cap'n Proto ForceInput message."""
+    force_input = Potentials_capnp.ForceInput.new_message()
+    force_input.pos = [float(x) for x in atoms.get_positions().flatten()]
+    force_input.atmnrs = [int(z) for z in atoms.get_atomic_numbers()]
+    force_input.box = [float(x) for x in atoms.get_cell().flatten()]
+    return force_input
+
+
+class ResultCollector(Potentials_capnp.ResultSink.Server):
+    """Receives the results of the stream, in completion order."""
+
+    def __init__(self):
+        self.energies = {}
+        self.errors = {}
+
+    async def result(self, id, result, **kwargs):
+        self.energies[id] = result.energy
+
+    async def failed(self, id, error, **kwargs):
+        self.errors[id] = error
+
+    async def done(self, **kwargs):
+        pass
+
+
+async def run_sweep(host, port, structures, window):
+    """Pushes every structure into one stream and waits for all results."""
+    connection = await capnp.AsyncIoStream.create_connection(host=host, port=port)
+    client = capnp.TwoPartyClient(connection)
+    calculator = client.bootstrap().cast_as(Potentials_capnp.Potential)
+
+    collector = ResultCollector()
+    stream = await calculator.openStream(results=collector, window=window)
+    sink = stream.sink
+
+    # Flow control of the stream paces the pushes; awaiting each one only
+    # waits when the server has no room for more
+    for i, atoms in enumerate(structures):
+        await sink.push(id=i, fip=atoms_to_force_input(atoms))
+    await sink.done()
+    return collector
+
+
+def main():
+    """Builds the sweep, streams it and reports the throughput."""
+    args = parse_args()
+    host, port = args.host.split(":")
+
+    rng = np.random.default_rng(42)
+    base = bulk("Cu", "fcc", a=3.6).repeat((2, 2, 2))
+    structures = []
+    for _ in range(args.count):
+        atoms = base.copy()
+        atoms.rattle(stdev=0.05, seed=int(rng.integers(1 << 31)))
+        structures.append(atoms)
+    print(f"Generated {len(structures)} structures to calculate.")
+
+    start = time.monotonic()
+    collector = asyncio.run(
+        capnp.run(run_sweep(host, int(port), structures, args.window))
+    )
+    elapsed = time.monotonic() - start
+
+    print(f"Received {len(collector.energies)} results in {elapsed:.4f} s")
+    print(f"Throughput: {len(structures) / elapsed:.1f} structures/s")
+    for i, error in sorted(collector.errors.items()):
+        print(f"  Structure {i} failed: {error}")
+    if collector.energies:
+        energies = np.array([collector.energies[i] for i in sorted(collector.energies)])
+        print(f"Energy range: {energies.min():.4f} .. {energies.max():.4f}")
+
+
+if __name__ == "__main__":
+    main()
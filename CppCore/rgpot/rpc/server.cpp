@@ -5,135 +5,1965 @@
  * @brief Implementation of the standalone Cap'n Proto potential server.
  *
  * This file implements a basic RPC server which exposes toy potentials over a
- * network interface. It utilizes the @c EzRpcServer for handling requests.
+ * network interface. Every accepted connection is bootstrapped with a
+ * @c Potential capability of its own, whose calls share one lane of the
+ * fair queue. The event loop only decodes and encodes messages: every
+ * evaluation runs on a pool of worker threads, each holding its own
+ * potential instance, and completes its RPC through a cross-thread
+ * promise.
+ *
+ * With @c RGPOT_HAS_CACHE, a server can either own a RocksDB cache shared by
+ * its workers and export it as a @c CacheService capability, or consult the
+ * @c CacheService of another server, so that several servers share one
+ * cache.
+ *
+ * With @c --shm, clients on the same host may skip the network altogether
+ * and exchange configurations through a shared memory segment, answered by
+ * threads of their own next to the RPC workers.
+ *
+ * With @c --unix, the same capability is also served on a Unix domain
+ * socket, for clients on the host that should not go through TCP.
+ *
+ * Clients streaming a trajectory open a @c Session, which keeps the atomic
+ * numbers, box and last positions of their system, so that each step only
+ * sends the positions, or just those that changed.
+ *
+ * Throughput-bound clients open a stream instead: they push configurations
+ * into a @c ConfigSink as fast as flow control allows, and the server calls
+ * back the @c ResultSink they passed with every result as it completes.
+ *
+ * One server may host several potentials, named on the command line and
+ * looked up in the @c PotentialRegistry. The first one answers the
+ * bootstrap capability; the others are reached through @c potential and
+ * only get their workers when first asked for.
+ *
+ * Requests are queued per connection and served in turn, and identical
+ * configurations in flight at the same time are computed once, their
+ * result shared. With @c --max-queue the queue is bounded and calls that
+ * do not fit fail at once with an @c OVERLOADED exception.
  */
 
-#include <capnp/ez-rpc.h>
 #include <capnp/message.h>
+#include <capnp/rpc-twoparty.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <kj/async-io.h>
+#include <kj/async.h>
 #include <kj/debug.h>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
-#ifdef RGPOT_HAS_FORTRAN
-#include "rgpot/CuH2/CuH2Pot.hpp"
-#endif // RGPOT_HAS_FORTRAN
-
-#include "rgpot/LennardJones/LJPot.hpp"
 #include "rgpot/Potential.hpp"
-#include "rgpot/types/AtomMatrix.hpp"
-#include "rgpot/types/adapters/capnp/capnp_adapter.hpp"
+#include "rgpot/PotentialRegistry.hpp"
+#include "rgpot/PotentialStats.hpp"
+#ifdef RGPOT_HAS_CACHE
+#include "rgpot/PotentialCache.hpp"
+#endif // RGPOT_HAS_CACHE
+#include "rgpot/ThreadPool.hpp"
+#include "rgpot/Trace.hpp"
+#include "rgpot/rpc/Potentials.capnp.h"
+#include "rgpot/rpc/ShmChannel.hpp"
+#include "rgpot/types/adapters/capnp/capnp_view.hpp"
+
+/**
+ * @brief Callable creating a fresh potential instance.
+ */
+using PotentialFactory = std::function<std::unique_ptr<rgpot::PotentialBase>()>;
+
+/**
+ * @class WorkerPool
+ * @brief Worker threads that each own a potential instance.
+ *
+ * Jobs are queued by lane, one per connection, session or stream, and
+ * whichever worker is free takes the next job of the next lane in turn,
+ * so a client queueing many jobs does not hold back those of others.
+ * @c submit is called on the event loop thread and returns a promise that
+ * the worker fulfills cross-thread.
+ *
+ * With a capacity, jobs beyond it are refused with an @c OVERLOADED
+ * exception instead of waiting. A lane with nothing queued gets in as
+ * long as its jobs fit; a lane already waiting stops at an equal share of
+ * the capacity among the waiting lanes and one more, which keeps room for
+ * the next client while one floods the server.
+ *
+ * Owning an instance keeps per-call state apart between workers; it does
+ * not make a non-reentrant backend safe, which has to serialize itself,
+ * as @c CuH2Pot does around its Fortran code.
+ */
+class WorkerPool {
+public:
+  /**
+   * @brief Job signature, receives the potential of the running worker.
+   */
+  using Job = std::function<void(rgpot::PotentialBase &)>;
+
+  /**
+   * @brief Identifies the connection, session or stream a job is queued
+   * for.
+   */
+  using Lane = uint64_t;
+
+  /**
+   * @brief Constructor for WorkerPool.
+   * @param factory Creates one potential instance per worker thread.
+   * @param num_threads Number of worker threads, at least one.
+   * @param capacity Jobs waiting at most, 0 for no limit.
+   */
+  WorkerPool(const PotentialFactory &factory, size_t num_threads,
+             size_t capacity = 0)
+      : m_capacity(capacity) {
+    num_threads = std::max<size_t>(1, num_threads);
+    // Instances are created up front on this thread, so a failing factory
+    // aborts startup instead of killing a worker
+    std::vector<std::unique_ptr<rgpot::PotentialBase>> potentials;
+    for (size_t i = 0; i < num_threads; ++i) {
+      potentials.push_back(factory());
+    }
+    for (auto &pot : potentials) {
+      m_threads.emplace_back([this, p = std::move(pot)] { run(*p); });
+    }
+  }
+
+  /**
+   * @brief Destructor, finishes queued jobs and joins the workers.
+   */
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto &t : m_threads) {
+      t.join();
+    }
+  }
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  /**
+   * @brief Fetches the number of worker threads.
+   * @return The thread count.
+   */
+  [[nodiscard]] size_t size() const { return m_threads.size(); }
+
+  /**
+   * @brief Fetches the number of jobs that may wait.
+   * @return The capacity, 0 without a limit.
+   */
+  [[nodiscard]] size_t capacity() const { return m_capacity; }
+
+  /**
+   * @brief Checks whether a lane may queue more jobs now.
+   *
+   * Workers only ever shorten the queue, so jobs admitted here are also
+   * accepted by @c submit calls made right after on the same thread.
+   *
+   * @param lane The client's lane.
+   * @param count Number of jobs to queue.
+   * @return Whether they fit.
+   */
+  [[nodiscard]] bool admits(Lane lane, size_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return admitsLocked(lane, count);
+  }
+
+  /**
+   * @brief Queues a job and returns a promise for its completion.
+   *
+   * Exceptions thrown by @a job reject the promise. If the promise is
+   * dropped before the job has finished (e.g. the client went away), the
+   * job is skipped when not yet started, and otherwise left to finish on
+   * its worker while the event loop goes on. A job may thus outlive the
+   * call that queued it, and must only touch memory it shares ownership
+   * of, never the messages of the call.
+   *
+   * @param job The work to run on a worker thread.
+   * @param lane The client's lane.
+   * @return A promise fulfilled on the event loop once @a job is done, or
+   * rejected as @c OVERLOADED when the lane is not admitted.
+   */
+  kj::Promise<void> submit(Job job, Lane lane = 0) {
+    auto paf = kj::newPromiseAndCrossThreadFulfiller<void>();
+    auto state = std::make_shared<JobState>();
+    // std::function needs a copyable callable, kj::Own is move-only
+    auto fulfiller =
+        std::make_shared<kj::Own<kj::CrossThreadPromiseFulfiller<void>>>(
+            kj::mv(paf.fulfiller));
+    const uint64_t queued = RGPOT_TRACE_NOW();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!admitsLocked(lane, 1)) {
+        return KJ_EXCEPTION(OVERLOADED, "potserv queue is full",
+                            m_capacity);
+      }
+      std::deque<Job> &pending = m_lanes[lane];
+      if (pending.empty()) {
+        m_turns.push_back(lane);
+      }
+      ++m_queued;
+      pending.push_back([state, fulfiller, queued,
+                         job = std::move(job)](rgpot::PotentialBase &pot) {
+        RGPOT_TRACE_SINCE("rpc.queue", queued);
+        if (state->cancelled.load(std::memory_order_acquire)) {
+          return;
+        }
+        try {
+          RGPOT_TRACE_SCOPE("rpc.job");
+          job(pot);
+          (*fulfiller)->fulfill();
+        } catch (const std::exception &e) {
+          (*fulfiller)->reject(KJ_EXCEPTION(FAILED, e.what()));
+        } catch (...) {
+          (*fulfiller)->reject(
+              KJ_EXCEPTION(FAILED, "Unknown exception in worker"));
+        }
+      });
+    }
+    m_cv.notify_one();
+    return paf.promise.attach(kj::heap<CancelGuard>(state));
+  }
+
+private:
+  /**
+   * @brief Hand-off between a queued job and the promise waiting on it.
+   */
+  struct JobState {
+    std::atomic<bool> cancelled{false}; //!< The promise has been dropped.
+  };
+
+  /**
+   * @brief Attached to the returned promise, cancels the job on drop.
+   *
+   * Never waits: a job that already started runs to completion on its
+   * worker, which then moves on to the next one.
+   */
+  struct CancelGuard {
+    std::shared_ptr<JobState> state; //!< The guarded job.
+
+    explicit CancelGuard(std::shared_ptr<JobState> s) : state(std::move(s)) {}
+    ~CancelGuard() { state->cancelled.store(true, std::memory_order_release); }
+  };
+
+  /**
+   * @brief Applies the admission rules, with @c m_mutex held.
+   * @param lane The client's lane.
+   * @param count Number of jobs to queue.
+   * @return Whether they fit.
+   */
+  bool admitsLocked(Lane lane, size_t count) const {
+    if (m_capacity == 0) {
+      return true;
+    }
+    if (m_queued + count > m_capacity) {
+      return false;
+    }
+    const auto it = m_lanes.find(lane);
+    if (it == m_lanes.end()) {
+      return true;
+    }
+    return it->second.size() + count <= m_capacity / (m_lanes.size() + 1);
+  }
+
+  /**
+   * @brief Worker loop.
+   * @param pot The potential owned by this worker.
+   * @return Void.
+   */
+  void run(rgpot::PotentialBase &pot) {
+    for (;;) {
+      Job task;
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [this] { return m_stop || m_queued != 0; });
+        if (m_queued == 0) {
+          return;
+        }
+        const Lane lane = m_turns.front();
+        m_turns.pop_front();
+        auto it = m_lanes.find(lane);
+        task = std::move(it->second.front());
+        it->second.pop_front();
+        --m_queued;
+        if (it->second.empty()) {
+          m_lanes.erase(it);
+        } else {
+          m_turns.push_back(lane);
+        }
+      }
+      task(pot);
+    }
+  }
+
+  const size_t m_capacity;               //!< Jobs waiting at most, or 0.
+  std::mutex m_mutex;                    //!< Guards the queues.
+  std::condition_variable m_cv;          //!< Signals new jobs or shutdown.
+  std::unordered_map<Lane, std::deque<Job>> m_lanes; //!< Pending, by lane.
+  std::deque<Lane> m_turns; //!< Lanes with pending jobs, in serving order.
+  size_t m_queued = 0;      //!< Pending jobs of all lanes.
+  bool m_stop = false;                   //!< Set when shutting down.
+  std::vector<std::thread> m_threads;    //!< The workers.
+};
+
+#ifdef RGPOT_HAS_CACHE
+/**
+ * @brief Views a binary cache key as Cap'n Proto @c Data.
+ * @param key The key.
+ * @return A reader over the key bytes.
+ */
+inline capnp::Data::Reader keyData(const rgpot::cache::KeyHash &key) {
+  return {reinterpret_cast<const kj::byte *>(key.key.data()),
+          rgpot::cache::KeyHash::width};
+}
+
+/**
+ * @brief Checks and decodes a binary cache key.
+ * @param data The key bytes of a request.
+ * @return The key.
+ */
+inline rgpot::cache::KeyHash keyFromData(capnp::Data::Reader data) {
+  KJ_REQUIRE(data.size() == rgpot::cache::KeyHash::width,
+             "Cache keys hold 16 bytes");
+  return rgpot::cache::KeyHash::from_bytes(
+      reinterpret_cast<const char *>(data.begin()));
+}
+
+/**
+ * @class CacheServiceImpl
+ * @brief Exports a local @c PotentialCache as a @c CacheService.
+ *
+ * Requests are answered on the event loop thread. The cache is the one the
+ * local workers use, so results computed by any server sharing it are seen
+ * by all of them.
+ */
+class CacheServiceImpl final : public CacheService::Server {
+private:
+  rgpot::cache::PotentialCache &m_cache; //!< The shared cache.
+
+public:
+  /**
+   * @brief Constructor for CacheServiceImpl.
+   * @param cache The cache to export, must outlive the service.
+   */
+  explicit CacheServiceImpl(rgpot::cache::PotentialCache &cache)
+      : m_cache(cache) {}
+
+  kj::Promise<void> lookup(LookupContext context) override {
+    auto params = context.getParams();
+    auto key = keyFromData(params.getKey());
+    const size_t n = params.getNForces();
+    std::vector<double> forces(n);
+    double energy = 0.0;
+    const bool found = m_cache.lookup(key, energy, forces.data(), n);
+
+    auto results = context.getResults();
+    results.setFound(found);
+    if (found) {
+      auto res = results.initResult();
+      res.setEnergy(energy);
+      auto forcesList = res.initForces(n);
+      rgpot::types::adapt::capnp::copyToCapnp(forcesList, forces.data());
+    }
+    return kj::READY_NOW;
+  }
+
+  kj::Promise<void> store(StoreContext context) override {
+    auto params = context.getParams();
+    auto key = keyFromData(params.getKey());
+    auto res = params.getResult();
+    std::vector<double> storage;
+    const double *forces = rgpot::types::adapt::capnp::viewFromCapnp(
+        res.getForces(), storage);
+    m_cache.store(key, res.getEnergy(), forces, res.getForces().size());
+    return kj::READY_NOW;
+  }
+};
+#endif // RGPOT_HAS_CACHE
+
+/**
+ * @class SessionImpl
+ * @brief Server side of a @c Session, one system streamed frame by frame.
+ *
+ * The session owns a potential instance of its own, so its neighbor list
+ * follows one trajectory instead of the configurations of every client,
+ * and keeps the positions, forces and energy of the last frame. Frames
+ * listing the moved atoms go through @c PotentialBase::compute_moved.
+ * Steps are evaluated on the shared workers, one at a time and in the
+ * order they arrive; they bypass a remote cache. A non-reentrant backend
+ * still runs under its own process-wide lock, so sessions and workers
+ * evaluating it wait for each other.
+ */
+class SessionImpl final : public Session::Server {
+private:
+  //! Full evaluations are forced after this many incremental ones.
+  static constexpr size_t kRefreshEvery = 64;
+
+  /**
+   * @brief State shared with the jobs of the session.
+   */
+  struct State {
+    std::unique_ptr<rgpot::PotentialBase> pot; //!< The session's instance.
+    std::vector<int> atmnrs;    //!< Atomic numbers, fixed.
+    std::vector<double> box;    //!< Current simulation cell.
+    std::vector<double> pos;    //!< Positions of the frame being evaluated.
+    std::vector<double> prev;   //!< Positions of the last evaluated frame.
+    std::vector<double> forces; //!< Forces of the last evaluated frame.
+    double energy = 0.0;        //!< Energy of the last evaluated frame.
+    bool primed = false;        //!< Whether @c prev, @c forces are valid.
+    bool full = true;           //!< Whether the frame needs a full call.
+    size_t incremental = 0;     //!< Incremental calls since a full one.
+    std::vector<size_t> moved;  //!< Atoms moved by the frame.
+  };
+
+  WorkerPool &m_workers;          //!< Threads evaluating the steps.
+  WorkerPool::Lane m_lane;        //!< Queue of the session's steps.
+  std::shared_ptr<State> m_state; //!< The session state.
+  kj::ForkedPromise<void> m_tail; //!< Completion of the last step.
+
+  /**
+   * @brief Applies a frame to the positions of the session.
+   *
+   * The frame is validated before anything is changed.
+   *
+   * @param s The session state, no step of it running.
+   * @param frame The received frame.
+   * @return Void.
+   */
+  static void apply(State &s, Frame::Reader frame) {
+    RGPOT_TRACE_SCOPE("rpc.session.apply");
+    namespace adapt = rgpot::types::adapt::capnp;
+    const size_t n3 = s.pos.size();
+    auto box = frame.getBox();
+    KJ_REQUIRE(box.size() == 0 || box.size() == 9, "Box must hold 9 values");
+    KJ_REQUIRE(s.primed || frame.isPos(),
+               "The first frame of a session must hold every position");
+    s.full = !s.primed || box.size() != 0 ||
+             s.incremental >= kRefreshEvery;
+    s.moved.clear();
+    switch (frame.which()) {
+    case Frame::POS: {
+      auto pos = frame.getPos();
+      KJ_REQUIRE(pos.size() == n3, "Position list size mismatch");
+      adapt::copyFromCapnp(pos, s.pos.data(), n3);
+      s.full = true;
+      break;
+    }
+    case Frame::MOVED: {
+      auto indices = frame.getMoved().getIndices();
+      auto pos = frame.getMoved().getPos();
+      KJ_REQUIRE(pos.size() == indices.size() * 3,
+                 "Moved positions do not match the indices");
+      for (uint32_t i : indices) {
+        KJ_REQUIRE(i * size_t{3} < n3, "Moved atom index out of range", i);
+      }
+      for (uint32_t k = 0; k < indices.size(); ++k) {
+        const size_t i = indices[k];
+        for (size_t d = 0; d < 3; ++d) {
+          s.pos[3 * i + d] = pos[3 * k + d];
+        }
+        s.moved.push_back(i);
+      }
+      break;
+    }
+    case Frame::SHIFT: {
+      auto shift = frame.getShift();
+      KJ_REQUIRE(shift.size() == n3, "Shift list size mismatch");
+      for (size_t i = 0; i < n3; ++i) {
+        s.pos[i] += static_cast<double>(shift[i]);
+      }
+      s.full = true;
+      break;
+    }
+    default:
+      KJ_FAIL_REQUIRE("Unknown frame kind");
+    }
+    if (box.size() != 0) {
+      adapt::copyFromCapnp(box, s.box.data(), 9);
+    }
+  }
+
+  /**
+   * @brief Evaluates the applied frame with the session's potential.
+   * @param s The session state.
+   * @return Void.
+   */
+  static void evaluate(State &s) {
+    const size_t n = s.atmnrs.size();
+    rgpot::ForceInput next{.nAtoms = n,
+                           .pos = s.pos.data(),
+                           .atmnrs = s.atmnrs.data(),
+                           .box = s.box.data()};
+    rgpot::ForceOut fo{.F = s.forces.data(), .energy = s.energy,
+                       .variance = 0.0};
+    // Empty systems have no backing storage to point at
+    if (n == 0) {
+      fo.energy = 0.0;
+    } else if (s.full) {
+      s.pot->compute_into(next, fo);
+      s.prev = s.pos;
+      s.incremental = 0;
+    } else {
+      rgpot::ForceInput prev{.nAtoms = n,
+                             .pos = s.prev.data(),
+                             .atmnrs = s.atmnrs.data(),
+                             .box = s.box.data()};
+      s.pot->compute_moved(prev, next, s.moved.data(), s.moved.size(), fo);
+      for (size_t i : s.moved) {
+        std::copy_n(s.pos.begin() + 3 * i, 3, s.prev.begin() + 3 * i);
+      }
+      ++s.incremental;
+    }
+    s.energy = fo.energy;
+    s.primed = true;
+  }
+
+public:
+  /**
+   * @brief Constructor for SessionImpl.
+   * @param workers The threads evaluating the steps.
+   * @param lane The queue of the session's steps.
+   * @param pot The potential instance of the session.
+   * @param atmnrs The atomic numbers of the system.
+   * @param box The initial simulation cell, 9 values.
+   */
+  SessionImpl(WorkerPool &workers, WorkerPool::Lane lane,
+              std::unique_ptr<rgpot::PotentialBase> pot,
+              capnp::List<int32_t>::Reader atmnrs,
+              capnp::List<double>::Reader box)
+      : m_workers(workers), m_lane(lane), m_state(std::make_shared<State>()),
+        m_tail(kj::Promise<void>(kj::READY_NOW).fork()) {
+    State &s = *m_state;
+    s.pot = std::move(pot);
+    s.atmnrs.resize(atmnrs.size());
+    for (uint32_t i = 0; i < atmnrs.size(); ++i) {
+      s.atmnrs[i] = atmnrs[i];
+    }
+    s.box.resize(9);
+    rgpot::types::adapt::capnp::copyFromCapnp(box, s.box.data(), 9);
+    s.pos.assign(s.atmnrs.size() * 3, 0.0);
+    s.prev = s.pos;
+    s.forces = s.pos;
+  }
+
+  /**
+   * @details
+   * Waits for the previous step, applies the frame on the event loop
+   * thread and queues the evaluation on the workers. A failed step leaves
+   * the session unprimed, so the next frame has to hold every position.
+   *
+   * @param context The Cap'n Proto RPC call context.
+   * @return An asynchronous promise for completion.
+   */
+  kj::Promise<void> step(StepContext context) override {
+    auto state = m_state;
+    WorkerPool &workers = m_workers;
+    const WorkerPool::Lane lane = m_lane;
+    auto run =
+        m_tail.addBranch()
+            .then([state, &workers, lane, context]() mutable {
+              apply(*state, context.getParams().getFrame());
+              return workers.submit(
+                  [state](rgpot::PotentialBase &) { evaluate(*state); },
+                  lane);
+            })
+            .then(
+                [state, context]() mutable {
+                  RGPOT_TRACE_SCOPE("rpc.finish");
+                  auto pres = context.getResults().initResult();
+                  pres.setEnergy(state->energy);
+                  auto forcesList = pres.initForces(state->forces.size());
+                  rgpot::types::adapt::capnp::copyToCapnp(
+                      forcesList, state->forces.data());
+                },
+                [state](kj::Exception &&e) {
+                  state->primed = false;
+                  kj::throwFatalException(kj::mv(e));
+                })
+            .fork();
+    m_tail = run.addBranch().then([]() {}, [](kj::Exception &&) {}).fork();
+    return run.addBranch();
+  }
+};
 
 /**
  * @class GenericPotImpl
- * @brief Server implementation for the Potential RPC interface.
+ * @brief Evaluates the Potential RPC calls of every connection.
  *
- * This class wraps a polymorphic @c PotentialBase instance and dispatches
- * RPC calculate requests to the underlying physics engine.
+ * This class wraps polymorphic @c PotentialBase instances and dispatches
+ * RPC calculate requests to the underlying physics engine. Connections
+ * reach it through a @c PotentialFacade each, which tells it the lane to
+ * queue their calls on. Potentials keep per-call state (neighbor lists,
+ * scratch buffers), so every worker thread owns its own instance.
+ * Separate instances do not make non-reentrant code safe: potentials
+ * wrapping such code, like the Fortran EAM of @c CuH2Pot, serialize it
+ * themselves behind a process-wide lock, and their calls run one at a
+ * time whatever the number of workers.
  */
-class GenericPotImpl final : public Potential::Server {
+class GenericPotImpl final {
+public:
+  //! Contexts of the calls a @c PotentialFacade forwards.
+  using CalculateContext = Potential::Server::CalculateContext;
+  using CalculateBatchContext = Potential::Server::CalculateBatchContext;
+  using CacheContext = Potential::Server::CacheContext;
+  using StatsContext = Potential::Server::StatsContext;
+  using OpenSessionContext = Potential::Server::OpenSessionContext;
+  using OpenStreamContext = Potential::Server::OpenStreamContext;
+
 private:
-  std::unique_ptr<rgpot::PotentialBase>
-      m_potential; //!< The polymorphic potential engine.
+  //! Lanes from here on are handed to sessions and streams.
+  static constexpr WorkerPool::Lane kServerLanes = WorkerPool::Lane{1} << 63;
+
+  struct Flight;
+
+  PotentialFactory m_factory; //!< Creates the instances of sessions.
+  WorkerPool m_workers;       //!< Threads evaluating requests.
+  WorkerPool::Lane m_next_lane = kServerLanes; //!< For the next session.
+  //! Computations in flight, by a hash of their inputs.
+  std::unordered_multimap<uint64_t, std::shared_ptr<Flight>> m_flights;
+#ifdef RGPOT_HAS_CACHE
+  std::optional<CacheService::Client> m_local; //!< Cache of the workers.
+  std::optional<CacheService::Client> m_remote; //!< Cache of another server.
+  int m_pot_type = 0; //!< Potential type mixed into remote cache keys.
+#endif // RGPOT_HAS_CACHE
+
+  /**
+   * @brief In-message views of one configuration and its result slot.
+   *
+   * The pointers alias the request and response segments, falling back to
+   * the owned vectors only when a direct view is not possible. Before a
+   * configuration is queued on the workers, @c compute moves it into the
+   * owned vectors, since a dropped call releases its messages while its
+   * job may still be running.
+   */
+  struct CallView {
+    size_t nAtoms = 0;           //!< Number of atoms.
+    const double *pos = nullptr; //!< Atomic coordinates.
+    const int *atmnrs = nullptr; //!< Atomic numbers.
+    const double *box = nullptr; //!< Simulation cell.
+    double *forces = nullptr;    //!< Force output.
+    double energy = 0.0;         //!< Calculated energy.
+    std::vector<double> posStorage; //!< Copy of @c pos if needed.
+    std::vector<int> atmStorage;    //!< Copy of @c atmnrs if needed.
+    std::vector<double> boxStorage; //!< Copy of @c box if needed.
+    std::vector<double> forceStorage; //!< Force buffer if needed.
+  };
+
+  /**
+   * @brief One computation that identical calls wait on.
+   */
+  struct Flight {
+    std::shared_ptr<CallView> leader; //!< The computing call, while listed.
+    size_t followers = 0;             //!< Calls waiting on the result.
+    double energy = 0.0;              //!< Energy, copied for followers.
+    std::vector<double> forces;       //!< Forces, copied for followers.
+    //! Fulfilled with true once computed, false if the leader went away.
+    kj::Own<kj::PromiseFulfiller<bool>> settle;
+    kj::ForkedPromise<bool> done; //!< Resolved through @c settle.
+
+    /**
+     * @brief Constructor for Flight.
+     * @param view The computing call.
+     * @param paf The promise behind @c done and its fulfiller.
+     */
+    Flight(std::shared_ptr<CallView> view, kj::PromiseFulfillerPair<bool> paf)
+        : leader(std::move(view)), settle(kj::mv(paf.fulfiller)),
+          done(paf.promise.fork()) {}
+  };
+
+  /**
+   * @brief Maps a configuration and its result builder onto a view.
+   * @param fip The input configuration.
+   * @param pres The result to be filled, its forces are initialized here.
+   * @param view Receives the pointers.
+   * @return Void.
+   */
+  static void bindView(ForceInput::Reader fip,
+                       PotentialResult::Builder pres, CallView &view) {
+    RGPOT_TRACE_SCOPE("rpc.bind");
+    namespace adapt = rgpot::types::adapt::capnp;
+    auto capnpPos = fip.getPos();
+    view.nAtoms = capnpPos.size() / 3;
+    KJ_REQUIRE(capnpPos.size() == view.nAtoms * 3,
+               "Position list size is not a multiple of 3");
+    KJ_REQUIRE(fip.getAtmnrs().size() == view.nAtoms,
+               "AtomNumbers size mismatch");
+    KJ_REQUIRE(fip.getBox().size() == 9, "Box must hold 9 values");
+
+    view.pos = adapt::viewFromCapnp(capnpPos, view.posStorage);
+    view.atmnrs = adapt::viewFromCapnp(fip.getAtmnrs(), view.atmStorage);
+    view.box = adapt::viewFromCapnp(fip.getBox(), view.boxStorage);
+
+    auto forcesList = pres.initForces(view.nAtoms * 3);
+    view.forces = adapt::directView<double>(forcesList);
+    if (!view.forces) {
+      view.forceStorage.assign(view.nAtoms * 3, 0.0);
+      view.forces = view.forceStorage.data();
+    }
+  }
+
+  /**
+   * @brief Evaluates a bound configuration with one potential instance.
+   * @param pot The potential to use.
+   * @param view The configuration, its energy is written here.
+   * @return Void.
+   */
+  static void evaluate(rgpot::PotentialBase &pot, CallView &view) {
+    // Empty lists have no backing storage to point at
+    if (view.nAtoms == 0) {
+      return;
+    }
+    pot.calculate_batch(1, view.nAtoms, view.pos, view.atmnrs, view.box,
+                        &view.energy, view.forces);
+  }
+
+  /**
+   * @brief Stores the energy, and the forces if they were not in place.
+   * @param view The evaluated configuration.
+   * @param pres The result builder bound by @c bindView.
+   * @return Void.
+   */
+  static void finishView(const CallView &view, PotentialResult::Builder pres) {
+    RGPOT_TRACE_SCOPE("rpc.finish");
+    pres.setEnergy(view.energy);
+    if (!view.forceStorage.empty()) {
+      auto forcesList = pres.getForces();
+      rgpot::types::adapt::capnp::copyToCapnp(forcesList,
+                                              view.forceStorage.data());
+    }
+  }
+
+  /**
+   * @brief Hashes the inputs of a bound configuration.
+   * @param view The configuration.
+   * @return The hash, the cache key's when built with the cache.
+   */
+  static uint64_t flightKey(const CallView &view) {
+#ifdef RGPOT_HAS_CACHE
+    return rgpot::cache::make_key(rgpot::ForceInput{.nAtoms = view.nAtoms,
+                                                    .pos = view.pos,
+                                                    .atmnrs = view.atmnrs,
+                                                    .box = view.box},
+                                  0)
+        .hash;
+#else
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](const void *data, size_t bytes) {
+      const auto *p = static_cast<const unsigned char *>(data);
+      for (size_t i = 0; i < bytes; ++i) {
+        hash = (hash ^ p[i]) * 1099511628211ULL;
+      }
+    };
+    mix(view.pos, view.nAtoms * 3 * sizeof(double));
+    mix(view.atmnrs, view.nAtoms * sizeof(int));
+    mix(view.box, 9 * sizeof(double));
+    return hash;
+#endif // RGPOT_HAS_CACHE
+  }
+
+  /**
+   * @brief Compares the inputs of two bound configurations.
+   * @param a A configuration.
+   * @param b Another configuration.
+   * @return Whether they are identical byte for byte.
+   */
+  static bool sameInputs(const CallView &a, const CallView &b) {
+    return a.nAtoms == b.nAtoms &&
+           std::memcmp(a.pos, b.pos, a.nAtoms * 3 * sizeof(double)) == 0 &&
+           std::memcmp(a.atmnrs, b.atmnrs, a.nAtoms * sizeof(int)) == 0 &&
+           std::memcmp(a.box, b.box, 9 * sizeof(double)) == 0;
+  }
+
+  /**
+   * @brief Hands out a lane of its own to a session or stream.
+   * @return The lane.
+   */
+  WorkerPool::Lane newLane() { return m_next_lane++; }
+
+  /**
+   * @brief Runs a bound configuration, sharing identical ones in flight.
+   *
+   * A configuration matching one that is already being computed waits for
+   * that result instead of being queued again, and gets a copy of it. The
+   * computation leaves @c m_flights before its result is published, so no
+   * call joins too late to be served. Should the computing call go away
+   * first, the waiting ones are dispatched anew.
+   *
+   * @param view The configuration, kept alive until the promise resolves.
+   * @param lane The client's lane.
+   * @return A promise for the filled in @a view.
+   */
+  kj::Promise<void> dispatch(std::shared_ptr<CallView> view,
+                             WorkerPool::Lane lane) {
+    // Empty lists have no backing storage to compare
+    if (view->nAtoms == 0) {
+      return compute(view, lane);
+    }
+    const uint64_t key = flightKey(*view);
+    const auto range = m_flights.equal_range(key);
+    for (auto it = range.first; it != range.second; ++it) {
+      std::shared_ptr<Flight> flight = it->second;
+      if (!sameInputs(*flight->leader, *view)) {
+        continue;
+      }
+      ++flight->followers;
+      return flight->done.addBranch().then(
+          [this, flight, view, lane](bool computed) -> kj::Promise<void> {
+            if (!computed) {
+              return dispatch(view, lane);
+            }
+            view->energy = flight->energy;
+            std::copy(flight->forces.begin(), flight->forces.end(),
+                      view->forces);
+            return kj::READY_NOW;
+          });
+    }
+
+    auto flight =
+        std::make_shared<Flight>(view, kj::newPromiseAndFulfiller<bool>());
+    m_flights.emplace(key, flight);
+    // Iterators of the table do not survive a rehash, so look it up again
+    auto land = [this, key, flight]() {
+      if (!flight->leader) {
+        return;
+      }
+      const auto listed = m_flights.equal_range(key);
+      for (auto it = listed.first; it != listed.second; ++it) {
+        if (it->second == flight) {
+          m_flights.erase(it);
+          break;
+        }
+      }
+      flight->leader.reset();
+    };
+    return compute(view, lane)
+        .then(
+            [view, flight, land]() {
+              land();
+              if (flight->followers != 0) {
+                flight->energy = view->energy;
+                flight->forces.assign(view->forces,
+                                      view->forces + view->nAtoms * 3);
+              }
+              flight->settle->fulfill(true);
+            },
+            [flight, land](kj::Exception &&e) {
+              land();
+              flight->settle->reject(kj::cp(e));
+              kj::throwFatalException(kj::mv(e));
+            })
+        .attach(kj::defer([flight, land]() {
+          land();
+          if (flight->settle->isWaiting()) {
+            flight->settle->fulfill(false);
+          }
+        }));
+  }
+
+  /**
+   * @brief Runs a bound configuration on the workers.
+   *
+   * With a remote cache, the key is looked up there first and only misses
+   * reach the workers; their results are then published without waiting
+   * for the store to complete. A failing remote cache degrades to plain
+   * evaluation.
+   *
+   * @param view The configuration, kept alive until the promise resolves.
+   * @param lane The client's lane.
+   * @return A promise for the filled in @a view.
+   */
+  kj::Promise<void> compute(std::shared_ptr<CallView> view,
+                            WorkerPool::Lane lane) {
+    auto queue = [this, view, lane]() {
+      ownInputs(*view);
+      ownForces(*view);
+      return m_workers.submit(
+          [view](rgpot::PotentialBase &pot) { evaluate(pot, *view); }, lane);
+    };
+#ifdef RGPOT_HAS_CACHE
+    if (!m_remote || view->nAtoms == 0) {
+      return queue();
+    }
+    const size_t n = view->nAtoms * 3;
+    auto key = rgpot::cache::make_key(rgpot::ForceInput{.nAtoms = view->nAtoms,
+                                                        .pos = view->pos,
+                                                        .atmnrs = view->atmnrs,
+                                                        .box = view->box},
+                                      m_pot_type);
+    auto publish = [this, view, key, n]() {
+      auto req = m_remote->storeRequest();
+      req.setKey(keyData(key));
+      auto res = req.initResult();
+      res.setEnergy(view->energy);
+      auto forcesList = res.initForces(n);
+      rgpot::types::adapt::capnp::copyToCapnp(forcesList, view->forces);
+      req.send().detach([](kj::Exception &&e) {
+        KJ_LOG(WARNING, "Remote cache store failed", e);
+      });
+    };
+
+    auto &stats = rgpot::PotentialStats::for_type(
+        static_cast<rgpot::PotType>(m_pot_type));
+    auto req = m_remote->lookupRequest();
+    req.setKey(keyData(key));
+    req.setNForces(n);
+    return req.send().then(
+        [view, n, queue, publish, &stats](auto reply) -> kj::Promise<void> {
+          auto res = reply.getResult();
+          if (reply.getFound() && res.getForces().size() == n) {
+            rgpot::types::adapt::capnp::copyFromCapnp(res.getForces(),
+                                                      view->forces, n);
+            view->energy = res.getEnergy();
+            stats.record_cache_hit();
+            return kj::READY_NOW;
+          }
+          stats.record_cache_miss();
+          return queue().then(publish);
+        },
+        [queue](kj::Exception &&e) -> kj::Promise<void> {
+          KJ_LOG(WARNING, "Remote cache lookup failed", e);
+          return queue();
+        });
+#else
+    return queue();
+#endif // RGPOT_HAS_CACHE
+  }
+
+  /**
+   * @brief Copies the inputs of a view out of its request message.
+   * @param view A view bound by @c bindView, used past the request's life.
+   * @return Void.
+   */
+  static void ownInputs(CallView &view) {
+    const size_t n = view.nAtoms;
+    if (view.pos != view.posStorage.data()) {
+      view.posStorage.assign(view.pos, view.pos + n * 3);
+    }
+    if (view.atmnrs != view.atmStorage.data()) {
+      view.atmStorage.assign(view.atmnrs, view.atmnrs + n);
+    }
+    if (view.box != view.boxStorage.data()) {
+      view.boxStorage.assign(view.box, view.box + 9);
+    }
+    view.pos = view.posStorage.data();
+    view.atmnrs = view.atmStorage.data();
+    view.box = view.boxStorage.data();
+  }
+
+  /**
+   * @brief Moves the force output of a view out of its response message.
+   *
+   * @c finishView then copies the forces into the message.
+   *
+   * @param view A view bound by @c bindView.
+   * @return Void.
+   */
+  static void ownForces(CallView &view) {
+    if (view.forceStorage.empty() || view.forces != view.forceStorage.data()) {
+      view.forceStorage.assign(view.nAtoms * 3, 0.0);
+      view.forces = view.forceStorage.data();
+    }
+  }
+
+  /**
+   * @class StreamImpl
+   * @brief One evaluation stream opened by @c openStream.
+   *
+   * Every push is evaluated like a @c calculate call, its forces copied
+   * into the @c ResultSink.result request that carries them back. At most
+   * @c m_window configurations are in flight, counted until their result
+   * is acknowledged; once the window is full, @c push resolves only when
+   * a slot frees, which is what holds the client back through the flow
+   * control of the @c stream method.
+   */
+  class StreamImpl final : public ConfigSink::Server,
+                           private kj::TaskSet::ErrorHandler {
+  private:
+    GenericPotImpl &m_pot;        //!< Evaluates the configurations.
+    WorkerPool::Lane m_lane;      //!< Queue of the pushes.
+    ResultSink::Client m_results; //!< Receives the results.
+    size_t m_window;              //!< Configurations in flight at most.
+    size_t m_inflight = 0;        //!< Pushed but not yet acknowledged.
+    std::optional<kj::Exception> m_failure; //!< Why results were lost.
+    //! Fulfilled when the window has room for the waiting push; calls on a
+    //! capability are held back while one of its stream calls runs, so
+    //! there is never more than one.
+    std::optional<kj::Own<kj::PromiseFulfiller<void>>> m_room;
+    //! Fulfilled when nothing is in flight anymore.
+    std::optional<kj::Own<kj::PromiseFulfiller<void>>> m_drained;
+    kj::TaskSet m_tasks; //!< Deliveries of results, destroyed first.
+
+    void taskFailed(kj::Exception &&e) override {
+      KJ_LOG(ERROR, "Stream task failed", e);
+    }
+
+    /**
+     * @brief Releases the slot of a delivered result.
+     * @return Void.
+     */
+    void release() {
+      --m_inflight;
+      if (m_room && m_inflight < m_window) {
+        (*m_room)->fulfill();
+        m_room.reset();
+      }
+      if (m_drained && m_inflight == 0) {
+        (*m_drained)->fulfill();
+        m_drained.reset();
+      }
+    }
+
+  public:
+    /**
+     * @brief Constructor for StreamImpl.
+     * @param pot The server evaluating the pushes.
+     * @param results The sink of the client.
+     * @param window Configurations in flight at most, at least one.
+     */
+    StreamImpl(GenericPotImpl &pot, ResultSink::Client results,
+               size_t window)
+        : m_pot(pot), m_lane(pot.newLane()), m_results(kj::mv(results)),
+          m_window(std::max<size_t>(window, 1)), m_tasks(*this) {}
+
+    /**
+     * @details
+     * The inputs are copied out of the push, whose message is released as
+     * soon as this returns. A malformed or failing configuration is
+     * reported through @c ResultSink.failed rather than breaking the
+     * stream; only a sink that no longer accepts results does, failing
+     * every later push.
+     *
+     * @param context The Cap'n Proto RPC call context.
+     * @return A promise resolved once the window has room again.
+     */
+    kj::Promise<void> push(PushContext context) override {
+      if (m_failure) {
+        kj::throwFatalException(kj::cp(*m_failure));
+      }
+      auto params = context.getParams();
+      const uint64_t id = params.getId();
+      auto req = m_results.resultRequest();
+      req.setId(id);
+
+      auto view = std::make_shared<CallView>();
+      std::optional<kj::Promise<void>> evaluated;
+      try {
+        bindView(params.getFip(), req.initResult(), *view);
+        ownInputs(*view);
+        evaluated.emplace(m_pot.dispatch(view, m_lane));
+      } catch (const kj::Exception &e) {
+        evaluated.emplace(kj::cp(e));
+      }
+
+      ++m_inflight;
+      auto delivered = kj::mv(*evaluated).then(
+          [view, req = kj::mv(req)]() mutable {
+            finishView(*view, req.getResult());
+            return req.send();
+          },
+          [this, id](kj::Exception &&e) {
+            auto failed = m_results.failedRequest();
+            failed.setId(id);
+            failed.setError(e.getDescription());
+            return failed.send();
+          });
+      m_tasks.add(delivered.then([this]() { release(); },
+                                 [this](kj::Exception &&e) {
+                                   if (!m_failure) {
+                                     m_failure = kj::mv(e);
+                                   }
+                                   release();
+                                 }));
+
+      if (m_inflight < m_window) {
+        return kj::READY_NOW;
+      }
+      auto paf = kj::newPromiseAndFulfiller<void>();
+      m_room = kj::mv(paf.fulfiller);
+      return kj::mv(paf.promise);
+    }
+
+    /**
+     * @details
+     * Waits for every result in flight, then calls @c ResultSink.done,
+     * which as a regular call returns only after the client has handled
+     * all results streamed before it.
+     *
+     * @param context The Cap'n Proto RPC call context.
+     * @return A promise resolved once the client has all results.
+     */
+    kj::Promise<void> done(DoneContext context) override {
+      kj::Promise<void> drained = kj::READY_NOW;
+      if (m_inflight != 0) {
+        auto paf = kj::newPromiseAndFulfiller<void>();
+        m_drained = kj::mv(paf.fulfiller);
+        drained = kj::mv(paf.promise);
+      }
+      return drained.then([this]() -> kj::Promise<void> {
+        if (m_failure) {
+          return kj::Promise<void>(kj::cp(*m_failure));
+        }
+        return m_results.doneRequest().send().ignoreResult();
+      });
+    }
+  };
 
 public:
   /**
    * @brief Constructor for GenericPotImpl.
-   * @param pot Ownership of a PotentialBase derived object.
+   * @param factory Creates one potential instance per worker thread.
+   * @param num_threads Number of worker threads.
+   * @param max_queue Requests waiting at most, 0 for no limit.
    */
-  GenericPotImpl(std::unique_ptr<rgpot::PotentialBase> pot)
-      : m_potential(std::move(pot)) {}
+  GenericPotImpl(const PotentialFactory &factory, size_t num_threads,
+                 size_t max_queue = 0)
+      : m_factory(factory), m_workers(factory, num_threads, max_queue) {}
+
+#ifdef RGPOT_HAS_CACHE
+  /**
+   * @brief Exports the cache the workers were created with.
+   * @param cache The shared cache, must outlive the server.
+   * @return Void.
+   */
+  void export_cache(rgpot::cache::PotentialCache &cache) {
+    m_local.emplace(kj::heap<CacheServiceImpl>(cache));
+  }
+
+  /**
+   * @brief Consults the cache of another server before computing.
+   * @param remote The @c CacheService of that server.
+   * @param pot_type Numeric potential type of the workers.
+   * @return Void.
+   */
+  void use_remote_cache(CacheService::Client remote, int pot_type) {
+    m_remote.emplace(kj::mv(remote));
+    m_pot_type = pot_type;
+  }
 
   /**
    * @details
-   * This method performs the following translation steps:
+   * Returns the exported local cache, or the remote cache this server
+   * consults, so that servers can be chained onto one cache owner.
+   *
+   * @param context The Cap'n Proto RPC call context.
+   * @return An immediately resolved promise.
+   */
+  kj::Promise<void> cache(CacheContext context) {
+    if (m_local) {
+      context.getResults().setService(*m_local);
+    } else if (m_remote) {
+      context.getResults().setService(*m_remote);
+    } else {
+      KJ_FAIL_REQUIRE("potserv runs without a cache");
+    }
+    return kj::READY_NOW;
+  }
+#endif // RGPOT_HAS_CACHE
+
+  /**
+   * @details
+   * Reports the process-wide @c PotentialStats of the requested type,
+   * which cover every worker of this server.
+   *
+   * @param context The Cap'n Proto RPC call context.
+   * @return An immediately resolved promise.
+   */
+  kj::Promise<void> stats(StatsContext context) {
+    const int32_t pot_type = context.getParams().getPotType();
+    PotStats snap{};
+    KJ_REQUIRE(pot_stats_get(pot_type, &snap) == 0, "Unknown potential type",
+               pot_type);
+    auto out = context.getResults().initStats();
+    out.setPotType(pot_type);
+    out.setForceCalls(snap.force_calls);
+    out.setCacheHits(snap.cache_hits);
+    out.setCacheMisses(snap.cache_misses);
+    out.setAtoms(snap.atoms);
+    out.setWallNanos(snap.wall_ns);
+    auto histogram = out.initHistogram(POT_STATS_BUCKETS);
+    for (unsigned b = 0; b < POT_STATS_BUCKETS; ++b) {
+      histogram.set(b, snap.wall_histogram[b]);
+    }
+    return kj::READY_NOW;
+  }
+
+  /**
+   * @details
+   * Creates a potential instance for the session on the event loop thread;
+   * the session's steps run on the shared workers.
+   *
+   * @param context The Cap'n Proto RPC call context.
+   * @return An immediately resolved promise.
+   */
+  kj::Promise<void> openSession(OpenSessionContext context) {
+    auto params = context.getParams();
+    KJ_REQUIRE(params.getBox().size() == 9, "Box must hold 9 values");
+    context.getResults().setSession(
+        kj::heap<SessionImpl>(m_workers, newLane(), m_factory(),
+                              params.getAtmnrs(), params.getBox()));
+    return kj::READY_NOW;
+  }
+
+  /**
+   * @details
+   * Without an explicit window, a stream keeps two configurations per
+   * worker in flight, enough to keep every worker busy while results
+   * travel back.
+   *
+   * @param context The Cap'n Proto RPC call context.
+   * @return An immediately resolved promise.
+   */
+  kj::Promise<void> openStream(OpenStreamContext context) {
+    auto params = context.getParams();
+    size_t window = params.getWindow();
+    if (window == 0) {
+      window = 2 * m_workers.size();
+    }
+    context.getResults().setSink(
+        kj::heap<StreamImpl>(*this, params.getResults(), window));
+    return kj::READY_NOW;
+  }
+
+  /**
+   * @details
+   * This method performs the following steps:
    * 1. Extracts the @c ForceInput (fip) from the RPC context.
-   * 2. Validates the size of the atomic number list.
-   * 3. Converts Cap'n Proto lists into native @c AtomMatrix and @c std::vector
-   * types.
-   * 4. Executes the calculation via the @c PotentialBase virtual operator.
-   * 5. Populates the @c PotentialResult with energy and force data.
+   * 2. Validates the sizes of the position, atomic number and box lists.
+   * 3. Views the input lists in place inside the request message and
+   * initializes the force list of the response.
+   * 4. Queues the evaluation on the worker pool, unless a remote cache or
+   * an identical call in flight provides the result. The worker reads and
+   * writes copies owned by the call view; a dropped call frees its
+   * messages without waiting for the worker.
+   * 5. Sets the energy of the @c PotentialResult and copies the forces in
+   * once the worker is done.
+   *
+   * Steps 1-3 and 5 run on the event loop thread, which keeps serving other
+   * clients while the worker computes.
+   *
+   * @param context The Cap'n Proto RPC call context.
+   * @param lane The lane of the calling connection.
+   * @return An asynchronous promise for completion.
+   */
+  kj::Promise<void> calculate(CalculateContext context,
+                              WorkerPool::Lane lane) {
+    auto params = context.getParams();
+    auto pres = context.getResults().initResult();
+
+    auto view = std::make_shared<CallView>();
+    bindView(params.getFip(), pres, *view);
+    return dispatch(view, lane).then([view, pres]() {
+      finishView(*view, pres);
+    });
+  }
+
+  /**
+   * @details
+   * All configurations are bound to their response slots on the event loop
+   * thread first, so malformed input is rejected before any work starts.
+   * Every item is then queued separately, so the workers spread a batch
+   * between them and interleave it with other clients' requests, and its
+   * forces are copied into its slot of the response once all are done.
    *
    * @param context The Cap'n Proto RPC call context.
+   * @param lane The lane of the calling connection.
    * @return An asynchronous promise for completion.
    */
+  kj::Promise<void> calculateBatch(CalculateBatchContext context,
+                                   WorkerPool::Lane lane) {
+    auto params = context.getParams();
+    auto fips = params.getFips();
+    const size_t nconf = fips.size();
+    const size_t capacity = m_workers.capacity();
+    KJ_REQUIRE(capacity == 0 || nconf <= capacity,
+               "Batch exceeds the queue capacity of potserv", nconf,
+               capacity);
+    if (!m_workers.admits(lane, nconf)) {
+      return KJ_EXCEPTION(OVERLOADED, "potserv queue is full", capacity);
+    }
+    auto results = context.getResults().initResults(nconf);
+
+    auto views = std::make_shared<std::vector<CallView>>(nconf);
+    for (size_t i = 0; i < nconf; ++i) {
+      bindView(fips[i], results[i], (*views)[i]);
+    }
+
+    auto jobs = kj::heapArrayBuilder<kj::Promise<void>>(nconf);
+    for (size_t i = 0; i < nconf; ++i) {
+      // Aliases the item while sharing ownership of the whole vector
+      jobs.add(
+          dispatch(std::shared_ptr<CallView>(views, &(*views)[i]), lane));
+    }
+
+    return kj::joinPromises(jobs.finish())
+        .then([views, results]() mutable {
+          for (size_t i = 0; i < views->size(); ++i) {
+            finishView((*views)[i], results[i]);
+          }
+        });
+  }
+};
+
+/**
+ * @class PotentialHost
+ * @brief The potentials served by one process, each created on first use.
+ *
+ * Every potential gets its own @c GenericPotImpl and worker threads, so
+ * the ones no client asks for cost neither threads nor memory. Only used
+ * on the event loop thread.
+ */
+class PotentialHost {
+public:
+  /**
+   * @brief Creates the server of one registered potential.
+   */
+  using Loader = std::function<kj::Own<GenericPotImpl>(
+      const rgpot::PotentialRegistry::Entry &)>;
+
+  /**
+   * @brief Constructor for PotentialHost.
+   * @param entries The hosted potentials, the bootstrap one first.
+   * @param loader Creates the server of a potential.
+   */
+  PotentialHost(const std::vector<const rgpot::PotentialRegistry::Entry *>
+                    &entries,
+                Loader loader)
+      : m_loader(std::move(loader)) {
+    for (const auto *entry : entries) {
+      m_slots.push_back({entry, nullptr});
+    }
+  }
+
+  /**
+   * @brief Fetches a hosted potential, creating its server if needed.
+   * @param name Registered name of the potential.
+   * @return Its server, owned by the host.
+   */
+  GenericPotImpl &get(std::string_view name) {
+    auto slot = std::find_if(m_slots.begin(), m_slots.end(),
+                             [name](const Slot &s) {
+                               return s.entry->name == name;
+                             });
+    KJ_REQUIRE(slot != m_slots.end(), "Potential not hosted by this server",
+               kj::heapString(name.data(), name.size()));
+    if (slot->impl == nullptr) {
+      std::cout << "Loading " << slot->entry->name << " potential..."
+                << std::endl;
+      slot->impl = m_loader(*slot->entry);
+    }
+    return *slot->impl;
+  }
+
+  /**
+   * @brief Fetches the potential answering the bootstrap capability.
+   * @return Its server, owned by the host.
+   */
+  GenericPotImpl &bootstrap() { return get(m_slots.front().entry->name); }
+
+  /**
+   * @brief Lists the hosted potentials.
+   * @param builder Receives the names and whether each is loaded.
+   * @return Void.
+   */
+  void list(Potential::PotentialsResults::Builder builder) const {
+    auto names = builder.initNames(m_slots.size());
+    auto loaded = builder.initLoaded(m_slots.size());
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+      names.set(i, m_slots[i].entry->name.c_str());
+      loaded.set(i, m_slots[i].impl != nullptr);
+    }
+  }
+
+  /**
+   * @brief Hands out a lane of its own to a new connection.
+   *
+   * Connection lanes count up from 0, clear of those the potentials give
+   * their sessions and streams.
+   *
+   * @return The lane.
+   */
+  WorkerPool::Lane newLane() { return m_next_lane++; }
+
+private:
+  /**
+   * @brief One hosted potential.
+   */
+  struct Slot {
+    const rgpot::PotentialRegistry::Entry *entry; //!< Its registration.
+    kj::Own<GenericPotImpl> impl; //!< Its server, once loaded.
+  };
+
+  std::vector<Slot> m_slots;        //!< In command line order.
+  Loader m_loader;                  //!< Creates the servers.
+  WorkerPool::Lane m_next_lane = 0; //!< For the next connection.
+};
+
+/**
+ * @class PotentialFacade
+ * @brief The @c Potential capability of one connection.
+ *
+ * Cap'n Proto does not tell a server which connection a call arrived on,
+ * so every connection is bootstrapped with a facade of its own, which
+ * queues its calls on the connection's lane. Potentials fetched through
+ * @c potential come with the same lane.
+ */
+class PotentialFacade final : public Potential::Server {
+public:
+  /**
+   * @brief Constructor for PotentialFacade.
+   * @param host The potentials of the server, must outlive the facade.
+   * @param pot The potential answering the calls.
+   * @param lane The lane of the connection.
+   */
+  PotentialFacade(PotentialHost &host, GenericPotImpl &pot,
+                  WorkerPool::Lane lane)
+      : m_host(host), m_pot(pot), m_lane(lane) {}
+
   kj::Promise<void> calculate(CalculateContext context) override {
-    auto fip = context.getParams().getFip();
-    const size_t numAtoms = fip.getPos().size() / 3;
+    return m_pot.calculate(context, m_lane);
+  }
 
-    KJ_REQUIRE(fip.getAtmnrs().size() == numAtoms, "AtomNumbers size mismatch");
+  kj::Promise<void> calculateBatch(CalculateBatchContext context) override {
+    return m_pot.calculateBatch(context, m_lane);
+  }
 
-    rgpot::types::AtomMatrix nativePositions =
-        rgpot::types::adapt::capnp::convertPositionsFromCapnp(fip.getPos(),
-                                                              numAtoms);
-    std::vector<int> nativeAtomTypes =
-        rgpot::types::adapt::capnp::convertAtomNumbersFromCapnp(
-            fip.getAtmnrs());
-    std::array<std::array<double, 3>, 3> nativeBoxMatrix =
-        rgpot::types::adapt::capnp::convertBoxMatrixFromCapnp(fip.getBox());
+#ifdef RGPOT_HAS_CACHE
+  kj::Promise<void> cache(CacheContext context) override {
+    return m_pot.cache(context);
+  }
+#endif // RGPOT_HAS_CACHE
 
-    // Call via the virtual operator() on PotentialBase
-    auto [energy, forces] =
-        (*m_potential)(nativePositions, nativeAtomTypes, nativeBoxMatrix);
+  kj::Promise<void> stats(StatsContext context) override {
+    return m_pot.stats(context);
+  }
 
-    auto result = context.getResults();
-    auto pres = result.initResult();
-    pres.setEnergy(energy);
+  kj::Promise<void> openSession(OpenSessionContext context) override {
+    return m_pot.openSession(context);
+  }
 
-    auto forcesList = pres.initForces(numAtoms * 3);
-    rgpot::types::adapt::capnp::populateForcesToCapnp(forcesList, forces);
+  kj::Promise<void> openStream(OpenStreamContext context) override {
+    return m_pot.openStream(context);
+  }
 
+  /**
+   * @details
+   * Loads the potential on first use, and hands out a facade over it on
+   * the lane of this connection.
+   *
+   * @param context The Cap'n Proto RPC call context.
+   * @return An immediately resolved promise.
+   */
+  kj::Promise<void> potential(PotentialContext context) override {
+    const capnp::Text::Reader name = context.getParams().getName();
+    context.getResults().setPotential(kj::heap<PotentialFacade>(
+        m_host, m_host.get(std::string_view(name.cStr(), name.size())),
+        m_lane));
     return kj::READY_NOW;
   }
+
+  /**
+   * @param context The Cap'n Proto RPC call context.
+   * @return An immediately resolved promise.
+   */
+  kj::Promise<void> potentials(PotentialsContext context) override {
+    m_host.list(context.getResults());
+    return kj::READY_NOW;
+  }
+
+private:
+  PotentialHost &m_host;   //!< Other potentials of the server.
+  GenericPotImpl &m_pot;   //!< Evaluates the calls.
+  WorkerPool::Lane m_lane; //!< Queue of the connection's calls.
+};
+
+/**
+ * @class Listener
+ * @brief Accepts the connections of one address.
+ *
+ * Works like @c capnp::TwoPartyServer, except that every connection is
+ * bootstrapped with a new @c PotentialFacade, on a lane of its own, where
+ * the former hands all of them the same capability.
+ */
+class Listener final : private kj::TaskSet::ErrorHandler {
+public:
+  /**
+   * @brief Constructor for Listener.
+   * @param host The potentials of the server, must outlive the listener.
+   */
+  explicit Listener(PotentialHost &host) : m_host(host), m_tasks(*this) {}
+
+  /**
+   * @brief Accepts connections until the listener is destroyed.
+   * @param receiver The bound address.
+   * @return Void.
+   */
+  void listen(kj::Own<kj::ConnectionReceiver> receiver) {
+    m_tasks.add(accept(kj::mv(receiver)));
+  }
+
+private:
+  /**
+   * @brief The RPC system of one accepted connection.
+   */
+  struct Connection {
+    Connection(kj::Own<kj::AsyncIoStream> &&s,
+               capnp::Capability::Client bootstrap)
+        : stream(kj::mv(s)),
+          network(*stream, capnp::rpc::twoparty::Side::SERVER),
+          rpc(capnp::makeRpcServer(network, kj::mv(bootstrap))) {}
+
+    kj::Own<kj::AsyncIoStream> stream; //!< The socket.
+    capnp::TwoPartyVatNetwork network; //!< Framing over the socket.
+    capnp::RpcSystem<capnp::rpc::twoparty::VatId> rpc; //!< Its calls.
+  };
+
+  kj::Promise<void> accept(kj::Own<kj::ConnectionReceiver> &&receiver) {
+    auto &ref = *receiver;
+    return ref.accept().then(
+        [this, receiver = kj::mv(receiver)](
+            kj::Own<kj::AsyncIoStream> &&stream) mutable {
+          auto conn = kj::heap<Connection>(
+              kj::mv(stream),
+              kj::heap<PotentialFacade>(m_host, m_host.bootstrap(),
+                                        m_host.newLane()));
+          // The connection lives until the client hangs up
+          auto &network = conn->network;
+          m_tasks.add(network.onDisconnect().attach(kj::mv(conn)));
+          return accept(kj::mv(receiver));
+        });
+  }
+
+  void taskFailed(kj::Exception &&exception) override {
+    KJ_LOG(ERROR, "Connection failed", exception);
+  }
+
+  PotentialHost &m_host; //!< Served to every connection.
+  kj::TaskSet m_tasks;   //!< Accept loop and open connections.
+};
+
+/**
+ * @class ShmService
+ * @brief Serves a shared memory segment next to the RPC interface.
+ *
+ * Each thread owns a potential instance, as the RPC workers do, and
+ * evaluates the slots in place: positions are read from and forces written
+ * to the shared pages. The threads share the cache and the statistics of
+ * the process with the RPC workers, and non-reentrant backends stay
+ * serialized by their own process-wide lock, shared with the RPC workers
+ * and sessions.
+ */
+class ShmService {
+public:
+  /**
+   * @brief Constructor for ShmService, creates the segment.
+   * @param name Shared memory object name.
+   * @param max_atoms Atoms one slot holds.
+   * @param factory Creates one potential instance per thread.
+   * @param num_threads Number of serving threads, at least one.
+   */
+  ShmService(const std::string &name, uint64_t max_atoms,
+             const PotentialFactory &factory, size_t num_threads)
+      : m_server(name, rgpot::shm::kDefaultSlots, max_atoms) {
+    num_threads = std::max<size_t>(1, num_threads);
+    std::vector<std::unique_ptr<rgpot::PotentialBase>> potentials;
+    for (size_t i = 0; i < num_threads; ++i) {
+      potentials.push_back(factory());
+    }
+    for (auto &pot : potentials) {
+      m_threads.emplace_back([this, p = std::move(pot)] {
+        m_server.serve(
+            [&pot = *p](const rgpot::shm::Call &call) { evaluate(pot, call); });
+      });
+    }
+  }
+
+  /**
+   * @brief Destructor, stops the threads and removes the segment.
+   */
+  ~ShmService() {
+    m_server.stop();
+    for (auto &t : m_threads) {
+      t.join();
+    }
+  }
+
+  ShmService(const ShmService &) = delete;
+  ShmService &operator=(const ShmService &) = delete;
+
+private:
+  /**
+   * @brief Evaluates one slot.
+   * @param pot The potential of the serving thread.
+   * @param call The request, aliasing the slot.
+   * @return Void.
+   */
+  static void evaluate(rgpot::PotentialBase &pot,
+                       const rgpot::shm::Call &call) {
+    RGPOT_TRACE_SCOPE("shm.job");
+    *call.energy = 0.0;
+    if (call.nAtoms == 0) {
+      return;
+    }
+    pot.calculate_batch(1, call.nAtoms, call.pos, call.atmnrs, call.box,
+                        call.energy, call.forces);
+  }
+
+  rgpot::shm::Server m_server;        //!< The shared segment.
+  std::vector<std::thread> m_threads; //!< The serving threads.
 };
 
 /**
  * @details
  * The main entry point handles command-line arguments to specify the
  * network port and the potential type. It instantiates the requested
- * physics engine and blocks until the server is terminated.
+ * physics engine once per worker thread and blocks until the server is
+ * terminated.
+ *
+ * The potential type may be a comma-separated list of names from the
+ * @c PotentialRegistry. The first is created at startup and served as the
+ * bootstrap capability, the others are loaded when a client first asks
+ * for them with @c potential. @c --list prints the registered names.
+ *
+ * The worker count is set with @c --threads (or the legacy third
+ * positional argument) and defaults to @c RGPOT_NUM_THREADS (one when
+ * unset).
+ *
+ * With @c RGPOT_HAS_CACHE, @c --cache opens a RocksDB cache at the given
+ * path, shared by all workers and exported to other servers, while
+ * @c --cache-server consults the cache of the server at @c host:port. A
+ * RocksDB directory can only be opened by one process, so servers sharing a
+ * cache point @c --cache-server at the one owning it.
+ *
+ * @c --trace writes the buffered trace spans of all threads to the given
+ * path as Chrome trace JSON each time the server receives @c SIGUSR1.
+ *
+ * @c --shm serves the shared memory segment @c /NAME as well, which
+ * clients reach with the address @c shm://NAME, using as many threads as
+ * the RPC workers. Its slots hold up to @c --shm-atoms atoms (4096 by
+ * default). A segment left behind by a killed server is replaced on the
+ * next start.
+ *
+ * @c --unix additionally listens on a Unix domain socket at the given
+ * path, which clients reach with the address @c unix:PATH. A socket left
+ * behind by a killed server is removed first; any other file at the path
+ * is an error.
+ *
+ * @c --max-queue caps the requests waiting for a worker of each potential
+ * (unbounded by default). A client whose requests would exceed it, or
+ * its share of it while others wait, gets an @c OVERLOADED error; the
+ * C bridge reports that as its own return code.
  *
  * # Usage
- * @c ./potserv <port> <PotentialType>
+ * @c ./potserv [--threads N] [--cache PATH | --cache-server HOST:PORT]
+ * [--trace PATH] [--shm NAME [--shm-atoms N]] [--unix PATH]
+ * [--max-queue N] <port> <PotentialType>[,<PotentialType>...]
  *
  * @param argc Argument count.
  * @param argv Argument vector.
  * @return 0 on success, 1 on initialization failure.
  */
 int main(int argc, char *argv[]) {
-  if (argc < 3) {
-    std::cerr << "Usage: " << argv[0] << " <port> <PotentialType>" << std::endl;
-    std::cerr << "  Available PotentialTypes: CuH2, LJ" << std::endl;
-    return 1;
+  size_t num_threads = rgpot::ThreadPool::default_num_threads();
+  std::string cache_path;
+  std::string cache_server;
+  std::string trace_path;
+  std::string shm_name;
+  std::string unix_path;
+  uint64_t shm_atoms = rgpot::shm::kDefaultMaxAtoms;
+  size_t max_queue = 0;
+  bool list_only = false;
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    std::string value;
+    if (arg == "--list") {
+      list_only = true;
+      continue;
+    } else if (arg == "--cache" && i + 1 < argc) {
+      cache_path = argv[++i];
+      continue;
+    } else if (arg.rfind("--cache=", 0) == 0) {
+      cache_path = arg.substr(std::strlen("--cache="));
+      continue;
+    } else if (arg == "--cache-server" && i + 1 < argc) {
+      cache_server = argv[++i];
+      continue;
+    } else if (arg.rfind("--cache-server=", 0) == 0) {
+      cache_server = arg.substr(std::strlen("--cache-server="));
+      continue;
+    } else if (arg == "--trace" && i + 1 < argc) {
+      trace_path = argv[++i];
+      continue;
+    } else if (arg.rfind("--trace=", 0) == 0) {
+      trace_path = arg.substr(std::strlen("--trace="));
+      continue;
+    } else if (arg == "--shm" && i + 1 < argc) {
+      shm_name = argv[++i];
+      continue;
+    } else if (arg.rfind("--shm=", 0) == 0) {
+      shm_name = arg.substr(std::strlen("--shm="));
+      continue;
+    } else if (arg == "--unix" && i + 1 < argc) {
+      unix_path = argv[++i];
+      continue;
+    } else if (arg.rfind("--unix=", 0) == 0) {
+      unix_path = arg.substr(std::strlen("--unix="));
+      continue;
+    } else if ((arg == "--shm-atoms" && i + 1 < argc) ||
+               arg.rfind("--shm-atoms=", 0) == 0) {
+      const std::string count = arg == "--shm-atoms"
+                                    ? std::string(argv[++i])
+                                    : arg.substr(std::strlen("--shm-atoms="));
+      try {
+        shm_atoms = std::max<uint64_t>(1, std::stoull(count));
+      } catch (const std::exception &e) {
+        std::cerr << "Invalid slot capacity '" << count << "'. Using "
+                  << shm_atoms << "." << std::endl;
+      }
+      continue;
+    } else if ((arg == "--max-queue" && i + 1 < argc) ||
+               arg.rfind("--max-queue=", 0) == 0) {
+      const std::string count = arg == "--max-queue"
+                                    ? std::string(argv[++i])
+                                    : arg.substr(std::strlen("--max-queue="));
+      try {
+        max_queue = std::stoul(count);
+      } catch (const std::exception &e) {
+        std::cerr << "Invalid queue capacity '" << count
+                  << "'. Leaving the queue unbounded." << std::endl;
+      }
+      continue;
+    } else if (arg == "--threads" && i + 1 < argc) {
+      value = argv[++i];
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      value = arg.substr(std::strlen("--threads="));
+    } else {
+      positional.push_back(arg);
+      continue;
+    }
+    try {
+      num_threads = std::max<size_t>(1, std::stoul(value));
+    } catch (const std::exception &e) {
+      std::cerr << "Invalid thread count '" << value << "'. Using "
+                << num_threads << "." << std::endl;
+    }
   }
 
+  const rgpot::PotentialRegistry &registry =
+      rgpot::PotentialRegistry::global();
+  if (list_only) {
+    for (const std::string &name : registry.names()) {
+      std::cout << name << std::endl;
+    }
+    return 0;
+  }
+  if (positional.size() < 2) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--list] [--threads N]"
+                 " [--cache PATH | --cache-server HOST:PORT]"
+                 " [--trace PATH] [--shm NAME [--shm-atoms N]]"
+                 " [--unix PATH] [--max-queue N]"
+                 " <port> <PotentialType>[,<PotentialType>...]"
+              << std::endl;
+    std::cerr << "  Available PotentialTypes: " << registry.describe()
+              << std::endl;
+    return 1;
+  }
+  if (!cache_path.empty() && !cache_server.empty()) {
+    std::cerr << "Error: --cache and --cache-server are mutually exclusive"
+              << std::endl;
+    return 1;
+  }
+#ifndef RGPOT_HAS_CACHE
+  if (!cache_path.empty() || !cache_server.empty()) {
+    std::cerr << "Error: potserv was built without cache support"
+              << std::endl;
+    return 1;
+  }
+#endif // RGPOT_HAS_CACHE
   int port = 12345;
   try {
-    port = std::stoi(argv[1]);
+    port = std::stoi(positional[0]);
   } catch (const std::exception &e) {
-    std::cerr << "Invalid port argument '" << argv[1]
+    std::cerr << "Invalid port argument '" << positional[0]
               << "'. Using default 12345." << std::endl;
   }
 
-  std::string pot_type = argv[2];
-  std::unique_ptr<rgpot::PotentialBase> potential_to_use;
+  if (positional.size() > 2) {
+    try {
+      num_threads = std::max<size_t>(1, std::stoul(positional[2]));
+    } catch (const std::exception &e) {
+      std::cerr << "Invalid thread count '" << positional[2] << "'. Using "
+                << num_threads << "." << std::endl;
+    }
+  }
 
-  if (pot_type == "CuH2") {
-    std::cout << "Loading CuH2 potential..." << std::endl;
-    potential_to_use = std::make_unique<rgpot::CuH2Pot>();
-  } else if (pot_type == "LJ") {
-    std::cout << "Loading LJ potential..." << std::endl;
-    potential_to_use = std::make_unique<rgpot::LJPot>();
-  } else {
-    std::cerr << "Error: Unknown potential type '" << pot_type << "'"
+  if (!trace_path.empty()) {
+    // Before any worker starts, so that they inherit the blocked signal
+    if (!rgpot::trace::dump_on_signal(SIGUSR1, trace_path)) {
+      std::cerr << "Error: trace dumps on signal are not supported here"
+                << std::endl;
+      return 1;
+    }
+#ifndef RGPOT_HAS_TRACE
+    std::cerr << "Warning: potserv was built without tracing, dumps will be "
+                 "empty"
               << std::endl;
-    return 1;
+#endif // RGPOT_HAS_TRACE
+    std::cout << "Send SIGUSR1 to write a trace to " << trace_path
+              << std::endl;
+  }
+
+  const std::string pot_type = positional[1];
+  std::vector<const rgpot::PotentialRegistry::Entry *> entries;
+  for (size_t start = 0; start <= pot_type.size();) {
+    size_t end = pot_type.find(',', start);
+    if (end == std::string::npos) {
+      end = pot_type.size();
+    }
+    const std::string name = pot_type.substr(start, end - start);
+    start = end + 1;
+    const rgpot::PotentialRegistry::Entry *entry = registry.find(name);
+    if (entry == nullptr) {
+      std::cerr << "Error: Unknown potential type '" << name
+                << "', available: " << registry.describe() << std::endl;
+      return 1;
+    }
+    if (std::find(entries.begin(), entries.end(), entry) == entries.end()) {
+      entries.push_back(entry);
+    }
+  }
+
+  // One event loop serves every connection and the remote cache
+  auto io = kj::setupAsyncIo();
+
+#ifdef RGPOT_HAS_CACHE
+  // Keys include the potential type, so every hosted potential shares it
+  std::unique_ptr<rgpot::cache::PotentialCache> cache;
+  if (!cache_path.empty()) {
+    cache = std::make_unique<rgpot::cache::PotentialCache>(cache_path);
+    if (!cache->is_open()) {
+      return 1;
+    }
+    std::cout << "Caching results in " << cache_path << std::endl;
+  }
+
+  // Runs on the event loop of the listeners created below
+  kj::Own<kj::AsyncIoStream> cache_stream;
+  std::unique_ptr<capnp::TwoPartyClient> cache_client;
+  std::optional<CacheService::Client> remote_cache;
+  if (!cache_server.empty()) {
+    // Fails early when the other server is unreachable or has no cache
+    try {
+      cache_stream = io.provider->getNetwork()
+                         .parseAddress(cache_server)
+                         .wait(io.waitScope)
+                         ->connect()
+                         .wait(io.waitScope);
+      cache_client = std::make_unique<capnp::TwoPartyClient>(*cache_stream);
+      remote_cache.emplace(cache_client->bootstrap()
+                               .castAs<Potential>()
+                               .cacheRequest()
+                               .send()
+                               .wait(io.waitScope)
+                               .getService());
+    } catch (const kj::Exception &e) {
+      std::cerr << "Unable to use the cache of " << cache_server << ": "
+                << e.getDescription().cStr() << std::endl;
+      return 1;
+    }
+    std::cout << "Using the cache of " << cache_server << std::endl;
   }
+#endif // RGPOT_HAS_CACHE
 
-  capnp::EzRpcServer server(
-      kj::heap<GenericPotImpl>(std::move(potential_to_use)), "localhost", port);
+  auto make_factory =
+      [&](const rgpot::PotentialRegistry::Entry &entry) -> PotentialFactory {
+#ifdef RGPOT_HAS_CACHE
+    if (cache) {
+      return [inner = entry.create, shared = cache.get()] {
+        auto pot = inner();
+        pot->set_cache(shared);
+        return pot;
+      };
+    }
+#endif // RGPOT_HAS_CACHE
+    return entry.create;
+  };
+  PotentialHost host(
+      entries, [&](const rgpot::PotentialRegistry::Entry &entry) {
+        auto impl = kj::heap<GenericPotImpl>(make_factory(entry), num_threads,
+                                             max_queue);
+#ifdef RGPOT_HAS_CACHE
+        if (cache) {
+          impl->export_cache(*cache);
+        }
+        if (remote_cache) {
+          impl->use_remote_cache(*remote_cache,
+                                 static_cast<int>(entry.type));
+        }
+#endif // RGPOT_HAS_CACHE
+        return impl;
+      });
+  const PotentialFactory factory = make_factory(*entries.front());
 
-  auto &waitScope = server.getWaitScope();
+  std::unique_ptr<ShmService> shm;
+  if (!shm_name.empty()) {
+    try {
+      shm = std::make_unique<ShmService>(shm_name, shm_atoms, factory,
+                                         num_threads);
+    } catch (const std::exception &e) {
+      std::cerr << "Unable to serve shared memory: " << e.what()
+                << std::endl;
+      return 1;
+    }
+    std::cout << "Serving shm://" << shm_name << " with slots of "
+              << shm_atoms << " atoms" << std::endl;
+  }
+  if (!unix_path.empty()) {
+    std::error_code ec;
+    if (std::filesystem::is_socket(unix_path, ec)) {
+      std::filesystem::remove(unix_path, ec);
+    } else if (std::filesystem::exists(unix_path, ec)) {
+      std::cerr << "Error: " << unix_path << " exists and is not a socket"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  // Both listeners share the workers, each connection on its own lane
+  host.bootstrap();
+  Listener listener(host);
+  listener.listen(io.provider->getNetwork()
+                      .parseAddress("localhost", port)
+                      .wait(io.waitScope)
+                      ->listen());
+  if (!unix_path.empty()) {
+    listener.listen(io.provider->getNetwork()
+                        .parseAddress("unix:" + unix_path)
+                        .wait(io.waitScope)
+                        ->listen());
+    std::cout << "Serving unix:" << unix_path << std::endl;
+  }
+
+  if (max_queue != 0) {
+    std::cout << "Queueing at most " << max_queue << " request(s) per "
+              << "potential" << std::endl;
+  }
   std::cout << "Server running on port " << port << " with " << pot_type
-            << " potential." << std::endl;
-  kj::NEVER_DONE.wait(waitScope);
+            << " potential(s) and " << num_threads << " worker thread(s)."
+            << std::endl;
+  kj::NEVER_DONE.wait(io.waitScope);
 
   return 0;
 }
@@ -6,7 +6,14 @@
  * @brief Definition of the native AtomMatrix class.
  *
  * This file defines a lightweight, row-major matrix class designed for storing
- * atomic coordinates and forces.
+ * atomic coordinates and forces. Storage comes from @c BufferPool, so the
+ * matrices created for every call of a potential recycle the buffers of
+ * previous calls of the same size, and is always aligned to
+ * @c BufferPool::alignment bytes. Matrices may carry zeroed padding rows past
+ * the last atom, and expose strided per-column views for kernels that work
+ * on coordinates one axis at a time. A @c MatrixView is a separate,
+ * non-owning view over external row-major memory, which lets array
+ * libraries pass their own buffers to a potential without copying.
  */
 
 // clang-format off
@@ -16,8 +23,11 @@
 #include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <type_traits>
 #include <vector>
 
+#include "rgpot/types/BufferPool.hpp"
+
 namespace rgpot {
 namespace types {
 
@@ -27,16 +37,161 @@ namespace types {
  */
 using AtomVector = std::vector<double>;
 
+/**
+ * @class ColumnView
+ * @brief Non-owning strided view over one column of a row-major matrix.
+ * @tparam T Element type, @c const qualified for read-only views.
+ */
+template <typename T> class ColumnView {
+public:
+  /**
+   * @brief Constructor for ColumnView.
+   * @param data First element of the column.
+   * @param size Number of elements.
+   * @param stride Distance between consecutive elements, in elements.
+   */
+  ColumnView(T *data, size_t size, size_t stride)
+      : m_data(data), m_size(size), m_stride(stride) {}
+
+  /**
+   * @brief Access an element.
+   * @param i Row index.
+   * @return Reference to the element.
+   */
+  T &operator[](size_t i) const { return m_data[i * m_stride]; }
+
+  /**
+   * @brief Fetches the number of elements.
+   * @return Element count.
+   */
+  size_t size() const { return m_size; }
+
+  /**
+   * @brief Fetches the distance between consecutive elements.
+   * @return Stride in elements.
+   */
+  size_t stride() const { return m_stride; }
+
+  /**
+   * @brief Fetches a pointer to the first element.
+   * @return Raw pointer to memory.
+   */
+  T *data() const { return m_data; }
+
+private:
+  T *m_data;       //!< First element of the column.
+  size_t m_size;   //!< Number of elements.
+  size_t m_stride; //!< Distance between consecutive elements.
+};
+
+/**
+ * @class MatrixView
+ * @brief Non-owning view over external row-major memory.
+ *
+ * A view has reference semantics, like @c std::span: copies alias the same
+ * memory, which must outlive all of them. Constructing an @c AtomMatrix
+ * from a view makes an owning copy.
+ *
+ * @tparam T Element type, @c const qualified for read-only views.
+ */
+template <typename T> class MatrixView {
+public:
+  /**
+   * @brief Constructor for MatrixView.
+   * @param data First element, @a rows * @a cols contiguous elements.
+   * @param rows Number of rows.
+   * @param cols Number of columns.
+   */
+  MatrixView(T *data, size_t rows, size_t cols)
+      : m_data(data), m_rows(rows), m_cols(cols) {}
+
+  /**
+   * @brief Converts a writable view to a read-only one.
+   * @tparam U Element type of @a other, @a T without @c const.
+   * @param other The writable view.
+   */
+  template <typename U,
+            typename = std::enable_if_t<std::is_same_v<const U, T> &&
+                                        !std::is_same_v<U, T>>>
+  MatrixView(const MatrixView<U> &other)
+      : MatrixView(other.data(), other.rows(), other.cols()) {}
+
+  /**
+   * @brief Access an element.
+   * @param row  Row index.
+   * @param col  Column index.
+   * @return Reference to the element.
+   */
+  T &operator()(size_t row, size_t col) const {
+    return m_data[row * m_cols + col];
+  }
+
+  /**
+   * @brief Fetches the number of rows.
+   * @return Row count.
+   */
+  size_t rows() const { return m_rows; }
+
+  /**
+   * @brief Fetches the number of columns.
+   * @return Column count.
+   */
+  size_t cols() const { return m_cols; }
+
+  /**
+   * @brief Fetches the total number of elements.
+   * @return Element count.
+   */
+  size_t size() const { return m_rows * m_cols; }
+
+  /**
+   * @brief Fetches a strided view of one column.
+   * @param col  Column index.
+   * @return View over the rows of the column.
+   */
+  ColumnView<T> col(size_t col) const {
+    return {m_data + col, m_rows, m_cols};
+  }
+
+  /**
+   * @brief Fetches a pointer to the viewed memory.
+   * @return Raw pointer to the first element.
+   */
+  T *data() const { return m_data; }
+
+private:
+  T *m_data;     //!< First element of the viewed memory.
+  size_t m_rows; //!< Number of rows.
+  size_t m_cols; //!< Number of columns.
+};
+
+/**
+ * @typedef AtomMatrixView
+ * @brief Writable view over external coordinates or forces.
+ */
+using AtomMatrixView = MatrixView<double>;
+
+/**
+ * @typedef ConstAtomMatrixView
+ * @brief Read-only view over external coordinates.
+ */
+using ConstAtomMatrixView = MatrixView<const double>;
+
 /**
  * @class AtomMatrix
  * @brief A lightweight row-major matrix class for atomic data.
  */
 class AtomMatrix {
 public:
+  /**
+   * @brief Rows of doubles filling one aligned block, the default padding.
+   */
+  static constexpr size_t simd_width = BufferPool::alignment / sizeof(double);
+
   /**
    * @brief Default constructor.
    */
-  AtomMatrix() : m_rows(0), m_cols(0) {}
+  AtomMatrix() : m_rows(0), m_cols(0), m_padded_rows(0) {}
 
   /**
    * @brief Constructor for list initialization.
@@ -44,7 +199,7 @@ public:
    */
   AtomMatrix(std::initializer_list<std::initializer_list<double>> list)
       : m_rows(list.size()), m_cols((list.begin())->size()),
-        m_data(m_rows * m_cols) {
+        m_padded_rows(m_rows), m_data(m_rows * m_cols) {
     size_t rowIdx = 0;
     for (const auto &rowList : list) {
       std::copy(rowList.begin(), rowList.end(),
@@ -59,7 +214,15 @@ public:
    * @param cols  Number of columns.
    */
   AtomMatrix(size_t rows, size_t cols)
-      : m_rows(rows), m_cols(cols), m_data(rows * cols) {}
+      : m_rows(rows), m_cols(cols), m_padded_rows(rows), m_data(rows * cols) {}
+
+  /**
+   * @brief Constructor copying the memory of a view.
+   * @param view  The viewed memory, copied into pooled storage.
+   */
+  explicit AtomMatrix(ConstAtomMatrixView view)
+      : m_rows(view.rows()), m_cols(view.cols()), m_padded_rows(m_rows),
+        m_data(view.data(), view.data() + view.size()) {}
 
   /**
    * @brief Creates a matrix initialized with zeroes.
@@ -73,6 +236,29 @@ public:
     return matrix;
   }
 
+  /**
+   * @brief Creates a zeroed matrix whose storage is padded with extra rows.
+   *
+   * The row count is rounded up to a multiple of @a multiple, so vector
+   * loops can run over whole blocks without a remainder. The padding rows
+   * follow the @a rows logical rows and stay zero unless written through
+   * @c data(); @c rows() and @c size() report the logical shape only.
+   *
+   * @param rows  Number of logical rows.
+   * @param cols  Number of columns.
+   * @param multiple  Row multiple to pad to, zero or one for none.
+   * @return A zero-initialized, padded @c AtomMatrix.
+   */
+  static AtomMatrix Padded(size_t rows, size_t cols,
+                           size_t multiple = simd_width) {
+    const size_t padded =
+        multiple > 1 ? (rows + multiple - 1) / multiple * multiple : rows;
+    AtomMatrix matrix(padded, cols);
+    std::fill(matrix.m_data.begin(), matrix.m_data.end(), 0.0);
+    matrix.m_rows = rows;
+    return matrix;
+  }
+
   /**
    * @brief Access element for mutation.
    * @param row  Row index.
@@ -111,9 +297,58 @@ public:
    */
   size_t size() const { return m_rows * m_cols; }
 
+  /**
+   * @brief Fetches the number of rows backed by storage.
+   * @return Row count including padding, at least @c rows().
+   */
+  size_t padded_rows() const { return m_padded_rows; }
+
+  /**
+   * @brief Fetches a strided view of one column for mutation.
+   * @param col  Column index.
+   * @return View over the logical rows of the column.
+   */
+  ColumnView<double> col(size_t col) {
+    return {m_data.data() + col, m_rows, m_cols};
+  }
+
+  /**
+   * @brief Fetches a strided view of one column for reading.
+   * @param col  Column index.
+   * @return View over the logical rows of the column.
+   */
+  ColumnView<const double> col(size_t col) const {
+    return {m_data.data() + col, m_rows, m_cols};
+  }
+
+  /**
+   * @brief Fetches the X coordinates of an N x 3 matrix.
+   * @return Strided view of the first column.
+   */
+  ColumnView<double> x() { return col(0); }
+  ColumnView<const double> x() const { return col(0); } //!< @copydoc x()
+
+  /**
+   * @brief Fetches the Y coordinates of an N x 3 matrix.
+   * @return Strided view of the second column.
+   */
+  ColumnView<double> y() { return col(1); }
+  ColumnView<const double> y() const { return col(1); } //!< @copydoc y()
+
+  /**
+   * @brief Fetches the Z coordinates of an N x 3 matrix.
+   * @return Strided view of the third column.
+   */
+  ColumnView<double> z() { return col(2); }
+  ColumnView<const double> z() const { return col(2); } //!< @copydoc z()
+
   /**
    * @brief Fetches a pointer to the raw data for mutation.
-   * @return Raw pointer to memory.
+   *
+   * The first @c size() elements hold the logical rows in row-major order,
+   * followed by any padding rows.
+   *
+   * @return Raw pointer to memory, aligned to @c BufferPool::alignment.
    */
   double *data() { return m_data.data(); }
 
@@ -152,7 +387,8 @@ public:
 private:
   size_t m_rows; //!< The number of rows in the matrix.
   size_t m_cols; //!< The number of columns in the matrix.
-  std::vector<double>
+  size_t m_padded_rows; //!< Rows backed by storage, including padding.
+  std::vector<double, PoolAllocator<double>>
       m_data; //!< The underlying flat container for row-major data.
 };
 
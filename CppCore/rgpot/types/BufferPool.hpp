@@ -0,0 +1,238 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Size-class pool recycling numeric buffers.
+ *
+ * Defines @c BufferPool, which keeps released buffers in power-of-two size
+ * classes so that the matrices of recurring system sizes reuse memory
+ * instead of going through the general purpose allocator on every call,
+ * and @c PoolAllocator, a standard allocator drawing from it.
+ */
+
+// clang-format off
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+// clang-format on
+
+namespace rgpot {
+namespace types {
+
+/**
+ * @class BufferPool
+ * @brief Thread-safe cache of freed buffers, grouped by size class.
+ *
+ * Requests are rounded up to the next power of two between @c min_bytes
+ * and @c max_bytes, and blocks are aligned to @c alignment bytes. Larger
+ * requests bypass the pool. Each class retains a bounded number of free
+ * blocks, so the pool only grows to the working set of distinct sizes.
+ */
+class BufferPool {
+public:
+  static constexpr size_t alignment = 64;           //!< Block alignment.
+  static constexpr size_t min_bytes = 64;           //!< Smallest class.
+  static constexpr size_t max_bytes = size_t{1} << 24; //!< Largest class.
+
+  /**
+   * @brief Constructor for BufferPool.
+   * @param max_cached Free blocks retained per size class.
+   */
+  explicit BufferPool(size_t max_cached = 64) : m_max_cached(max_cached) {}
+
+  /**
+   * @brief Destructor, releases every cached block.
+   */
+  ~BufferPool() { trim(); }
+
+  BufferPool(const BufferPool &) = delete;
+  BufferPool &operator=(const BufferPool &) = delete;
+
+  /**
+   * @brief Fetches the process-wide pool used by @c PoolAllocator.
+   *
+   * Never destroyed, so buffers owned by static objects can still be
+   * released during shutdown.
+   *
+   * @return The pool.
+   */
+  static BufferPool &global() {
+    static BufferPool *pool = new BufferPool();
+    return *pool;
+  }
+
+  /**
+   * @brief Allocates a block of at least @a bytes.
+   * @param bytes Requested size.
+   * @return The block, aligned to @c alignment.
+   * @throws std::bad_alloc When the allocation fails.
+   */
+  void *allocate(size_t bytes) {
+    const size_t cls = class_of(bytes);
+    if (cls < num_classes) {
+      SizeClass &sc = m_classes[cls];
+      std::lock_guard<std::mutex> lock(sc.mutex);
+      if (!sc.free.empty()) {
+        void *block = sc.free.back();
+        sc.free.pop_back();
+        m_cached_bytes.fetch_sub(class_bytes(cls), std::memory_order_relaxed);
+        return block;
+      }
+    }
+    return ::operator new(block_bytes(bytes), std::align_val_t{alignment});
+  }
+
+  /**
+   * @brief Returns a block obtained from @c allocate.
+   * @param block The block, may be @c nullptr.
+   * @param bytes The size passed to @c allocate.
+   * @return Void.
+   */
+  void deallocate(void *block, size_t bytes) noexcept {
+    if (!block) {
+      return;
+    }
+    const size_t cls = class_of(bytes);
+    if (cls < num_classes) {
+      SizeClass &sc = m_classes[cls];
+      std::lock_guard<std::mutex> lock(sc.mutex);
+      if (sc.free.size() < m_max_cached) {
+        try {
+          sc.free.push_back(block);
+          m_cached_bytes.fetch_add(class_bytes(cls),
+                                   std::memory_order_relaxed);
+          return;
+        } catch (...) {
+          // Fall through and release the block
+        }
+      }
+    }
+    ::operator delete(block, std::align_val_t{alignment});
+  }
+
+  /**
+   * @brief Releases every cached block to the system.
+   * @return Void.
+   */
+  void trim() noexcept {
+    for (size_t cls = 0; cls < num_classes; ++cls) {
+      SizeClass &sc = m_classes[cls];
+      std::lock_guard<std::mutex> lock(sc.mutex);
+      for (void *block : sc.free) {
+        ::operator delete(block, std::align_val_t{alignment});
+      }
+      m_cached_bytes.fetch_sub(sc.free.size() * class_bytes(cls),
+                               std::memory_order_relaxed);
+      sc.free.clear();
+    }
+  }
+
+  /**
+   * @brief Fetches the memory held by cached blocks.
+   * @return Bytes in free lists.
+   */
+  [[nodiscard]] size_t cached_bytes() const {
+    return m_cached_bytes.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr size_t num_classes = 19; //!< 64 B up to 16 MiB.
+
+  /**
+   * @brief Maps a request to its size class.
+   * @param bytes Requested size.
+   * @return The class index, @c num_classes when the pool is bypassed.
+   */
+  static size_t class_of(size_t bytes) {
+    if (bytes > max_bytes) {
+      return num_classes;
+    }
+    size_t cls = 0;
+    while (class_bytes(cls) < bytes) {
+      ++cls;
+    }
+    return cls;
+  }
+
+  /**
+   * @brief Block size of a class.
+   * @param cls The class index.
+   * @return Size in bytes.
+   */
+  static constexpr size_t class_bytes(size_t cls) { return min_bytes << cls; }
+
+  /**
+   * @brief Size actually allocated for a request.
+   * @param bytes Requested size.
+   * @return The class size, or @a bytes when the pool is bypassed.
+   */
+  static size_t block_bytes(size_t bytes) {
+    const size_t cls = class_of(bytes);
+    return cls < num_classes ? class_bytes(cls) : bytes;
+  }
+
+  /**
+   * @brief Free blocks of one size.
+   */
+  struct SizeClass {
+    std::mutex mutex;         //!< Guards @c free.
+    std::vector<void *> free; //!< Blocks ready for reuse.
+  };
+
+  size_t m_max_cached;                            //!< Per-class bound.
+  std::array<SizeClass, num_classes> m_classes;   //!< The size classes.
+  std::atomic<size_t> m_cached_bytes{0};          //!< Memory in free lists.
+};
+
+/**
+ * @class PoolAllocator
+ * @brief Standard allocator backed by @c BufferPool::global().
+ *
+ * Stateless, so containers using it can exchange storage freely.
+ */
+template <typename T> class PoolAllocator {
+public:
+  using value_type = T; //!< Allocated element type.
+
+  PoolAllocator() noexcept = default;
+
+  /**
+   * @brief Converting constructor required by the allocator requirements.
+   */
+  template <typename U> PoolAllocator(const PoolAllocator<U> &) noexcept {}
+
+  /**
+   * @brief Allocates storage for @a n elements.
+   * @param n Number of elements.
+   * @return Pointer to uninitialized storage.
+   */
+  T *allocate(size_t n) {
+    return static_cast<T *>(BufferPool::global().allocate(n * sizeof(T)));
+  }
+
+  /**
+   * @brief Returns storage obtained from @c allocate.
+   * @param p The storage.
+   * @param n Number of elements passed to @c allocate.
+   * @return Void.
+   */
+  void deallocate(T *p, size_t n) noexcept {
+    BufferPool::global().deallocate(p, n * sizeof(T));
+  }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U> &) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const PoolAllocator<U> &) const noexcept {
+    return false;
+  }
+};
+
+} // namespace types
+} // namespace rgpot
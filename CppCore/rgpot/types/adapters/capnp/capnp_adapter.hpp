@@ -7,13 +7,16 @@
  *
  * This file contains inline adapter functions designed to facilitate the
  * seamless transfer of data between the Cap'n Proto RPC layer and the internal
- * @c Eigen based @c AtomMatrix and other STL types.
+ * @c Eigen based @c AtomMatrix and other STL types. List payloads are moved
+ * with a single @c memcpy where the wire layout allows it, see
+ * @c capnp_view.hpp for the in-place views used by the server.
  */
 
 #include <vector>
 
 #include "rgpot/rpc/Potentials.capnp.h"
 #include "rgpot/types/AtomMatrix.hpp"
+#include "rgpot/types/adapters/capnp/capnp_view.hpp"
 #include <capnp/list.h>
 #include <capnp/message.h>
 
@@ -34,9 +37,7 @@ inline AtomMatrix
 convertPositionsFromCapnp(const ::capnp::List<double>::Reader &capnpPos,
                           size_t numAtoms) {
   AtomMatrix nativePositions(numAtoms, 3);
-  for (size_t i = 0; i < numAtoms * 3; ++i) {
-    nativePositions.data()[i] = capnpPos[i];
-  }
+  copyFromCapnp(capnpPos, nativePositions.data(), numAtoms * 3);
   return nativePositions;
 }
 
@@ -47,11 +48,9 @@ convertPositionsFromCapnp(const ::capnp::List<double>::Reader &capnpPos,
  */
 inline std::vector<int>
 convertAtomNumbersFromCapnp(const ::capnp::List<int>::Reader &capnpAtmnrs) {
-  std::vector<int> nativeAtomTypes(capnpAtmnrs.size());
-  for (size_t i = 0; i < capnpAtmnrs.size(); ++i) {
-    nativeAtomTypes[i] = capnpAtmnrs[i];
-  }
-  return nativeAtomTypes;
+  std::vector<int> storage;
+  const int *data = viewFromCapnp(capnpAtmnrs, storage);
+  return std::vector<int>(data, data + capnpAtmnrs.size());
 }
 
 /**
@@ -79,9 +78,7 @@ convertBoxMatrixFromCapnp(const ::capnp::List<double>::Reader &capnpBox) {
  */
 inline void populatePositionsToCapnp(::capnp::List<double>::Builder &capnpPos,
                                      const AtomMatrix &positions) {
-  for (size_t i = 0; i < positions.rows() * positions.cols(); ++i) {
-    capnpPos.set(i, positions.data()[i]);
-  }
+  copyToCapnp(capnpPos, positions.data());
 }
 
 /**
@@ -92,9 +89,7 @@ inline void populatePositionsToCapnp(::capnp::List<double>::Builder &capnpPos,
  */
 inline void populateForcesToCapnp(::capnp::List<double>::Builder &capnpForces,
                                   const AtomMatrix &forces) {
-  for (size_t i = 0; i < forces.rows() * forces.cols(); ++i) {
-    capnpForces.set(i, forces.data()[i]);
-  }
+  copyToCapnp(capnpForces, forces.data());
 }
 
 /**
@@ -0,0 +1,154 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Zero-copy access to primitive Cap'n Proto lists.
+ *
+ * Cap'n Proto stores @c List(Float64) and @c List(Int32) as flat,
+ * word-aligned, little-endian arrays inside the message segments. On a
+ * little-endian host these arrays can be used in place, which avoids the
+ * per-element accessors of @c List<T>::Reader and @c List<T>::Builder.
+ * Every helper falls back to an element-wise copy when the host byte order
+ * or the list encoding does not allow a direct view.
+ *
+ * Only depends on Cap'n Proto, so it can be used by the C bridge as well.
+ */
+
+// clang-format off
+#include <cstdint>
+#include <cstring>
+#include <vector>
+// clang-format on
+
+#include <capnp/any.h>
+#include <capnp/list.h>
+
+namespace rgpot {
+namespace types {
+namespace adapt {
+namespace capnp {
+
+/**
+ * @brief Checks whether the host stores integers in little-endian order.
+ * @return @c true on little-endian hosts, the Cap'n Proto wire order.
+ */
+inline bool hostIsLittleEndian() {
+  const uint16_t probe = 1;
+  unsigned char first = 0;
+  std::memcpy(&first, &probe, 1);
+  return first == 1;
+}
+
+/**
+ * @brief Returns a pointer to the in-message elements of a primitive list.
+ *
+ * @c nullptr is returned when the elements cannot be used directly, either
+ * because the host is big-endian or because the list was not encoded as a
+ * flat array of @c T (e.g. a struct list sent by a newer schema).
+ *
+ * @param list The reader for the list.
+ * @return Pointer to @c list.size() elements, or @c nullptr.
+ */
+template <typename T>
+inline const T *directView(const typename ::capnp::List<T>::Reader &list) {
+  if (!hostIsLittleEndian()) {
+    return nullptr;
+  }
+  auto bytes = ::capnp::AnyList::Reader(list).getRawBytes();
+  if (bytes.size() != list.size() * sizeof(T)) {
+    return nullptr;
+  }
+  return reinterpret_cast<const T *>(bytes.begin());
+}
+
+/**
+ * @brief Returns a writable pointer to the in-message elements of a list.
+ *
+ * Lists created with @c initXxx(n) are always flat, so this is only
+ * @c nullptr on big-endian hosts.
+ *
+ * @param list The builder for the list.
+ * @return Pointer to @c list.size() elements, or @c nullptr.
+ */
+template <typename T>
+inline T *directView(typename ::capnp::List<T>::Builder &list) {
+  // The reader aliases the builder's segment, which is writable
+  return const_cast<T *>(directView<T>(list.asReader()));
+}
+
+/**
+ * @brief Views a @c List(Float64), copying only when needed.
+ * @param list The reader for the list.
+ * @param storage Receives a copy when no direct view is possible.
+ * @return Pointer to @c list.size() doubles.
+ */
+inline const double *viewFromCapnp(const ::capnp::List<double>::Reader &list,
+                                   std::vector<double> &storage) {
+  if (const double *direct = directView<double>(list)) {
+    return direct;
+  }
+  storage.resize(list.size());
+  for (size_t i = 0; i < list.size(); ++i) {
+    storage[i] = list[i];
+  }
+  return storage.data();
+}
+
+/**
+ * @brief Views a @c List(Int32), copying only when needed.
+ * @param list The reader for the list.
+ * @param storage Receives a copy when no direct view is possible.
+ * @return Pointer to @c list.size() integers.
+ */
+inline const int *viewFromCapnp(const ::capnp::List<int>::Reader &list,
+                                std::vector<int> &storage) {
+  if (const int *direct = directView<int>(list)) {
+    return direct;
+  }
+  storage.resize(list.size());
+  for (size_t i = 0; i < list.size(); ++i) {
+    storage[i] = list[i];
+  }
+  return storage.data();
+}
+
+/**
+ * @brief Bulk copies the leading elements of a @c List(Float64).
+ * @param list The reader for the list.
+ * @param dst Destination holding at least @a count doubles.
+ * @param count Number of elements to copy, at most @c list.size().
+ * @return Void.
+ */
+inline void copyFromCapnp(const ::capnp::List<double>::Reader &list,
+                          double *dst, size_t count) {
+  if (const double *direct = directView<double>(list)) {
+    std::memcpy(dst, direct, count * sizeof(double));
+    return;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    dst[i] = list[i];
+  }
+}
+
+/**
+ * @brief Bulk copies a native buffer into a @c List(Float64) builder.
+ * @param list The builder for the list.
+ * @param src Source holding at least @c list.size() doubles.
+ * @return Void.
+ */
+inline void copyToCapnp(::capnp::List<double>::Builder &list,
+                        const double *src) {
+  if (double *direct = directView<double>(list)) {
+    std::memcpy(direct, src, list.size() * sizeof(double));
+    return;
+  }
+  for (size_t i = 0; i < list.size(); ++i) {
+    list.set(i, src[i]);
+  }
+}
+
+} // namespace capnp
+} // namespace adapt
+} // namespace types
+} // namespace rgpot
@@ -7,7 +7,9 @@
  *
  * This file contains inline adapter functions for integrating the Eigen
  * linear algebra library with the native @c AtomMatrix and @c std::vector
- * types used in the rgpot library.
+ * types used in the rgpot library. The @c view* functions alias memory in
+ * either direction through @c Eigen::Map and @c MatrixView, the
+ * @c convert* functions copy.
  */
 
 // clang-format off
@@ -19,37 +21,103 @@
 #include "rgpot/types/AtomMatrix.hpp"
 
 using rgpot::types::AtomMatrix;
+using rgpot::types::AtomMatrixView;
+using rgpot::types::ConstAtomMatrixView;
 
 namespace rgpot {
 namespace types {
 namespace adapt {
 namespace eigen {
 
+/**
+ * @typedef RowMajorMatrix
+ * @brief Dynamic Eigen matrix with the memory layout of @c AtomMatrix.
+ */
+using RowMajorMatrix =
+    Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+/**
+ * @typedef ColumnMap
+ * @brief Eigen vector mapped over a strided @c AtomMatrix column.
+ */
+using ColumnMap =
+    Eigen::Map<Eigen::VectorXd, Eigen::Unaligned, Eigen::InnerStride<>>;
+
+/**
+ * @brief Maps a native AtomMatrix as an Eigen matrix without copying.
+ * @param atomMatrix  The native matrix, must outlive the map.
+ * @return A writable @c Eigen::Map over the matrix data.
+ */
+inline Eigen::Map<RowMajorMatrix> viewAsEigen(AtomMatrix &atomMatrix) {
+  return {atomMatrix.data(), static_cast<Eigen::Index>(atomMatrix.rows()),
+          static_cast<Eigen::Index>(atomMatrix.cols())};
+}
+
+/**
+ * @brief Maps a native AtomMatrix as a read-only Eigen matrix.
+ * @param atomMatrix  The native matrix, must outlive the map.
+ * @return A read-only @c Eigen::Map over the matrix data.
+ */
+inline Eigen::Map<const RowMajorMatrix>
+viewAsEigen(const AtomMatrix &atomMatrix) {
+  return {atomMatrix.data(), static_cast<Eigen::Index>(atomMatrix.rows()),
+          static_cast<Eigen::Index>(atomMatrix.cols())};
+}
+
+/**
+ * @brief Maps one strided AtomMatrix column as an Eigen vector.
+ * @param column  A view such as @c AtomMatrix::x().
+ * @return A writable @c Eigen::Map with the column stride.
+ */
+inline ColumnMap viewAsEigen(ColumnView<double> column) {
+  return {column.data(), static_cast<Eigen::Index>(column.size()),
+          Eigen::InnerStride<>(static_cast<Eigen::Index>(column.stride()))};
+}
+
+/**
+ * @brief Views a row-major Eigen matrix without copying.
+ * @param matrix  The Eigen matrix, must outlive the view.
+ * @return A writable @c AtomMatrixView of the matrix data.
+ */
+inline AtomMatrixView viewAsAtomMatrix(RowMajorMatrix &matrix) {
+  return {matrix.data(), static_cast<size_t>(matrix.rows()),
+          static_cast<size_t>(matrix.cols())};
+}
+
+/**
+ * @brief Views a read-only row-major Eigen matrix without copying.
+ * @param matrix  The Eigen matrix, must outlive the view.
+ * @return A @c ConstAtomMatrixView of the matrix data.
+ */
+inline ConstAtomMatrixView viewAsAtomMatrix(const RowMajorMatrix &matrix) {
+  return {matrix.data(), static_cast<size_t>(matrix.rows()),
+          static_cast<size_t>(matrix.cols())};
+}
+
 /**
  * @brief Converts an Eigen matrix to a native AtomMatrix.
+ *
+ * Any storage order is accepted; the copy is a single mapped assignment.
+ * Row-major matrices can use @c viewAsAtomMatrix instead.
+ *
  * @param matrix  The source Eigen matrix.
  * @return An @c AtomMatrix instance with copied data.
  */
-inline AtomMatrix convertToAtomMatrix(const Eigen::MatrixXd &matrix) {
+template <typename Derived>
+AtomMatrix convertToAtomMatrix(const Eigen::MatrixBase<Derived> &matrix) {
   AtomMatrix result(matrix.rows(), matrix.cols());
-  for (int i = 0; i < matrix.rows(); ++i) {
-    for (int j = 0; j < matrix.cols(); ++j) {
-      result(i, j) = matrix(i, j);
-    }
-  }
+  viewAsEigen(result) = matrix;
   return result;
 }
 
 /**
  * @brief Converts a native AtomMatrix to an Eigen matrix.
  * @param atomMatrix  The source native matrix.
- * @return An @c Eigen::MatrixXd mapped to the original data.
- * @note This uses @c Eigen::Map for zero-copy access where possible.
+ * @return An @c Eigen::MatrixXd with copied data.
+ * @note Use @c viewAsEigen to access the data without copying.
  */
 inline Eigen::MatrixXd convertToEigen(const AtomMatrix &atomMatrix) {
-  return Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic,
-                                        Eigen::RowMajor>>(
-      atomMatrix.data(), atomMatrix.rows(), atomMatrix.cols());
+  return viewAsEigen(atomMatrix);
 }
 
 /**
@@ -7,33 +7,77 @@
  *
  * This file provides adapters for the @c xtensor library, enabling
  * interoperability between multidimensional arrays and rgpot data structures.
+ * The @c view* functions alias memory in either direction through
+ * @c xt::adapt and @c MatrixView, the @c convert* functions copy.
  */
 
+#include <algorithm>
 #include <array>
 #include <vector>
+#include <xtensor/xadapt.hpp>
 #include <xtensor/xtensor.hpp>
 
 #include "rgpot/types/AtomMatrix.hpp"
 
 using rgpot::types::AtomMatrix;
+using rgpot::types::AtomMatrixView;
+using rgpot::types::ConstAtomMatrixView;
 
 namespace rgpot {
 namespace types {
 namespace adapt {
 namespace xtensor {
 
+/**
+ * @brief Adapts a native AtomMatrix as an xtensor expression without copying.
+ * @param atomMatrix  The native matrix, must outlive the adaptor.
+ * @return A writable, non-owning row-major adaptor over the matrix data.
+ */
+inline auto viewAsXtensor(AtomMatrix &atomMatrix) {
+  const std::array<size_t, 2> shape{atomMatrix.rows(), atomMatrix.cols()};
+  return xt::adapt(atomMatrix.data(), atomMatrix.size(), xt::no_ownership(),
+                   shape);
+}
+
+/**
+ * @brief Adapts a native AtomMatrix as a read-only xtensor expression.
+ * @param atomMatrix  The native matrix, must outlive the adaptor.
+ * @return A read-only, non-owning row-major adaptor over the matrix data.
+ */
+inline auto viewAsXtensor(const AtomMatrix &atomMatrix) {
+  const std::array<size_t, 2> shape{atomMatrix.rows(), atomMatrix.cols()};
+  return xt::adapt(atomMatrix.data(), atomMatrix.size(), xt::no_ownership(),
+                   shape);
+}
+
+/**
+ * @brief Views a row-major xtensor array without copying.
+ * @param matrix  The 2D array, must outlive the view.
+ * @return A writable @c AtomMatrixView of the array data.
+ */
+inline AtomMatrixView viewAsAtomMatrix(xt::xtensor<double, 2> &matrix) {
+  return {matrix.data(), matrix.shape(0), matrix.shape(1)};
+}
+
+/**
+ * @brief Views a read-only row-major xtensor array without copying.
+ * @param matrix  The 2D array, must outlive the view.
+ * @return A @c ConstAtomMatrixView of the array data.
+ */
+inline ConstAtomMatrixView
+viewAsAtomMatrix(const xt::xtensor<double, 2> &matrix) {
+  return {matrix.data(), matrix.shape(0), matrix.shape(1)};
+}
+
 /**
  * @brief Converts an xtensor array to a native AtomMatrix.
  * @param matrix  The source 2D xtensor array.
  * @return An @c AtomMatrix containing the copied data.
+ * @note Use @c viewAsAtomMatrix to pass the array without copying.
  */
 inline AtomMatrix convertToAtomMatrix(const xt::xtensor<double, 2> &matrix) {
   AtomMatrix result(matrix.shape(0), matrix.shape(1));
-  for (size_t i = 0; i < matrix.shape(0); ++i) {
-    for (size_t j = 0; j < matrix.shape(1); ++j) {
-      result(i, j) = matrix(i, j);
-    }
-  }
+  std::copy(matrix.begin(), matrix.end(), result.data());
   return result;
 }
 
@@ -41,16 +85,10 @@ inline AtomMatrix convertToAtomMatrix(const xt::xtensor<double, 2> &matrix) {
  * @brief Converts a native AtomMatrix to an xtensor array.
  * @param atomMatrix  The source native matrix.
  * @return A 2D @c xt::xtensor containing the data.
+ * @note Use @c viewAsXtensor to access the data without copying.
  */
 inline xt::xtensor<double, 2> convertToXtensor(const AtomMatrix &atomMatrix) {
-  xt::xtensor<double, 2> result =
-      xt::zeros<double>({atomMatrix.rows(), atomMatrix.cols()});
-  for (size_t i = 0; i < atomMatrix.rows(); ++i) {
-    for (size_t j = 0; j < atomMatrix.cols(); ++j) {
-      result(i, j) = atomMatrix(i, j);
-    }
-  }
-  return result;
+  return viewAsXtensor(atomMatrix);
 }
 
 /**
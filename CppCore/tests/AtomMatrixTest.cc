@@ -0,0 +1,91 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "rgpot/types/AtomMatrix.hpp"
+
+using rgpot::types::AtomMatrix;
+
+TEST_CASE("AtomMatrix storage is aligned", "[AtomMatrix]") {
+  for (size_t n : {1, 3, 7, 64, 1000}) {
+    AtomMatrix m(n, 3);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(m.data()) %
+                rgpot::types::BufferPool::alignment ==
+            0);
+    REQUIRE(m.padded_rows() == n);
+  }
+}
+
+TEST_CASE("Padded matrices keep the row-major contract", "[AtomMatrix]") {
+  auto m = AtomMatrix::Padded(5, 3);
+  REQUIRE(m.rows() == 5);
+  REQUIRE(m.size() == 15);
+  REQUIRE(m.padded_rows() == AtomMatrix::simd_width);
+  for (size_t i = 0; i < m.padded_rows() * m.cols(); ++i) {
+    REQUIRE(m.data()[i] == 0.0);
+  }
+
+  m(4, 2) = 1.5;
+  REQUIRE(m.data()[4 * 3 + 2] == 1.5);
+  REQUIRE(AtomMatrix::Padded(16, 3).padded_rows() == 16);
+  REQUIRE(AtomMatrix::Padded(5, 3, 4).padded_rows() == 8);
+  REQUIRE(AtomMatrix::Padded(5, 3, 0).padded_rows() == 5);
+
+  // Copies carry the padding along
+  AtomMatrix copy = m;
+  REQUIRE(copy.padded_rows() == m.padded_rows());
+  REQUIRE(copy(4, 2) == 1.5);
+}
+
+TEST_CASE("Column views alias the row-major storage", "[AtomMatrix]") {
+  AtomMatrix m{{1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}};
+  auto x = m.x();
+  REQUIRE(x.size() == 2);
+  REQUIRE(x.stride() == 3);
+  REQUIRE(x[1] == 4.0);
+  REQUIRE(m.y()[0] == 2.0);
+
+  m.z()[1] = -6.0;
+  REQUIRE(m(1, 2) == -6.0);
+
+  const AtomMatrix &cm = m;
+  REQUIRE(cm.z().data() == m.data() + 2);
+  REQUIRE(cm.col(1)[1] == 5.0);
+}
+
+TEST_CASE("Views alias external memory", "[AtomMatrix]") {
+  using rgpot::types::AtomMatrixView;
+  using rgpot::types::ConstAtomMatrixView;
+  std::vector<double> buffer{1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+  AtomMatrixView view(buffer.data(), 2, 3);
+  REQUIRE(view.data() == buffer.data());
+  REQUIRE(view(1, 0) == 4.0);
+  REQUIRE(view.col(2)[1] == 6.0);
+
+  view(0, 1) = -2.0;
+  REQUIRE(buffer[1] == -2.0);
+
+  // Copies of a view alias the same memory, owning matrices do not
+  AtomMatrixView alias = view;
+  REQUIRE(alias.data() == buffer.data());
+  AtomMatrix copy(view);
+  REQUIRE(copy.data() != buffer.data());
+  REQUIRE(copy(0, 1) == -2.0);
+  copy(0, 1) = 7.0;
+  REQUIRE(buffer[1] == -2.0);
+  AtomMatrix copy2 = copy;
+  REQUIRE(copy2.data() != copy.data());
+
+  const std::vector<double> &cbuffer = buffer;
+  ConstAtomMatrixView cview(cbuffer.data(), 3, 2);
+  REQUIRE(cview.rows() == 3);
+  REQUIRE(cview(2, 1) == 6.0);
+  ConstAtomMatrixView from_mutable = view;
+  REQUIRE(from_mutable.data() == buffer.data());
+  STATIC_REQUIRE_FALSE(std::is_assignable_v<decltype(cview(0, 0)), double>);
+  STATIC_REQUIRE_FALSE(
+      std::is_convertible_v<ConstAtomMatrixView, AtomMatrixView>);
+}
@@ -0,0 +1,85 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <random>
+#include <vector>
+
+#include "rgpot/LennardJones/LJPot.hpp"
+
+using namespace Catch::Matchers;
+
+TEST_CASE("calculate_batch matches per-configuration calls", "[Potential]") {
+  const size_t n_atoms = 64;
+  const size_t nconf = 5;
+  const size_t stride = n_atoms * 3;
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<> dis(0.0, 20.0);
+
+  std::vector<double> positions(nconf * stride);
+  for (auto &p : positions) {
+    p = dis(gen);
+  }
+  std::vector<double> boxes(nconf * 9, 0.0);
+  for (size_t c = 0; c < nconf; ++c) {
+    const double len = 40.0 + static_cast<double>(c);
+    boxes[c * 9] = boxes[c * 9 + 4] = boxes[c * 9 + 8] = len;
+  }
+  std::vector<int> types(n_atoms, 1);
+
+  rgpot::LJPot single;
+  std::vector<double> expected_energy;
+  std::vector<std::vector<double>> expected;
+  for (size_t c = 0; c < nconf; ++c) {
+    rgpot::types::AtomMatrix pos(n_atoms, 3);
+    std::copy_n(positions.data() + c * stride, stride, pos.data());
+    std::array<std::array<double, 3>, 3> box{};
+    for (size_t d = 0; d < 3; ++d) {
+      box[d][d] = boxes[c * 9 + 4 * d];
+    }
+    auto [e, f] = single(pos, types, box);
+    expected_energy.push_back(e);
+    expected.emplace_back(f.data(), f.data() + stride);
+  }
+
+  rgpot::LJPot batch;
+  rgpot::PotentialBase &base = batch;
+  const size_t calls_before = rgpot::registry<rgpot::LJPot>::forceCalls;
+  std::vector<double> energies(nconf);
+  std::vector<double> forces(nconf * stride, -1.0);
+  base.calculate_batch(nconf, n_atoms, positions.data(), types.data(),
+                       boxes.data(), energies.data(), forces.data());
+  REQUIRE(rgpot::registry<rgpot::LJPot>::forceCalls == calls_before + nconf);
+
+  for (size_t c = 0; c < nconf; ++c) {
+    REQUIRE_THAT(energies[c], WithinRel(expected_energy[c], 1e-12));
+    for (size_t k = 0; k < stride; ++k) {
+      REQUIRE_THAT(forces[c * stride + k], WithinAbs(expected[c][k], 1e-12));
+    }
+  }
+
+  SECTION("Empty and invalid batches") {
+    base.calculate_batch(0, n_atoms, nullptr, nullptr, nullptr, nullptr,
+                         nullptr);
+    REQUIRE_THROWS_AS(base.calculate_batch(1, n_atoms, nullptr, types.data(),
+                                           boxes.data(), energies.data(),
+                                           forces.data()),
+                      std::runtime_error);
+  }
+
+  SECTION("compute_into reuses a caller-owned buffer") {
+    std::vector<double> out(stride, -1.0);
+    for (size_t c = 0; c < nconf; ++c) {
+      rgpot::ForceInput fi{.nAtoms = n_atoms,
+                           .pos = positions.data() + c * stride,
+                           .atmnrs = types.data(),
+                           .box = boxes.data() + c * 9};
+      rgpot::ForceOut fo{.F = out.data(), .energy = -1.0, .variance = -1.0};
+      base.compute_into(fi, fo);
+      REQUIRE(fo.variance == 0.0);
+      REQUIRE_THAT(fo.energy, WithinRel(expected_energy[c], 1e-12));
+      for (size_t k = 0; k < stride; ++k) {
+        REQUIRE_THAT(out[k], WithinAbs(expected[c][k], 1e-12));
+      }
+    }
+  }
+}
@@ -39,6 +39,22 @@ TEST_CASE("Bridge Lifecycle and Robustness", "[bridge][core]") {
     double pos[3] = {0, 0, 0};
     double box[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
     CHECK(pot_calculate(nullptr, 1, pos, atmnrs, box, &eng, f) != 0);
+    CHECK(pot_calculate_batch(nullptr, 1, 1, pos, atmnrs, box, &eng, f) != 0);
+    CHECK(pot_calculate_submit(nullptr, 1, pos, atmnrs, box, &eng, f) < 0);
+    CHECK(pot_calculate_poll(nullptr, 1) < 0);
+    CHECK(pot_calculate_wait(nullptr, 1) < 0);
+  }
+
+  SECTION("Unknown tickets are rejected") {
+    PotClient *client = pot_client_init("invalid_host_xyz", 9999);
+    REQUIRE(client != nullptr);
+    int64_t tickets[1] = {42};
+    int32_t idx = -1;
+    CHECK(pot_calculate_poll(client, 42) == -1);
+    CHECK(pot_calculate_wait(client, 42) == -1);
+    CHECK(pot_calculate_wait_any(client, tickets, 1, &idx) == -1);
+    CHECK(pot_get_last_error(client)[0] != '\0');
+    pot_client_free(client);
   }
 
   SECTION("Lazy Connection Failure") {
@@ -102,6 +118,82 @@ TEST_CASE("Bridge Calculation Stress", "[bridge][perf]") {
     }
   }
 
+  SECTION("Batch matches single calls") {
+    const int32_t nconf = 8;
+    std::vector<double> batch_pos;
+    std::vector<double> batch_box;
+    for (int32_t c = 0; c < nconf; ++c) {
+      for (size_t k = 0; k < pos.size(); ++k) {
+        batch_pos.push_back(pos[k] + (k == 3 ? 0.05 * c : 0.0));
+      }
+      batch_box.insert(batch_box.end(), box.begin(), box.end());
+    }
+    std::vector<double> energies(nconf);
+    std::vector<double> batch_forces(nconf * natoms * 3);
+
+    int res = pot_calculate_batch(client, nconf, natoms, batch_pos.data(),
+                                  atmnrs.data(), batch_box.data(),
+                                  energies.data(), batch_forces.data());
+    if (res != 0) {
+      FAIL("Batch RPC Failed: " << pot_get_last_error(client));
+    }
+
+    for (int32_t c = 0; c < nconf; ++c) {
+      REQUIRE(pot_calculate(client, natoms, batch_pos.data() + c * natoms * 3,
+                            atmnrs.data(), box.data(), &energy,
+                            forces.data()) == 0);
+      CHECK(energies[c] == energy);
+      for (int32_t k = 0; k < natoms * 3; ++k) {
+        CHECK(batch_forces[c * natoms * 3 + k] == forces[k]);
+      }
+    }
+  }
+
+  SECTION("Pipelined submissions match blocking calls") {
+    const int32_t ncalls = 16;
+    std::vector<double> energies(ncalls);
+    std::vector<double> pipelined(ncalls * natoms * 3);
+    std::vector<int64_t> tickets;
+    for (int32_t c = 0; c < ncalls; ++c) {
+      std::vector<double> shifted = pos;
+      shifted[3] += 0.02 * c;
+      // Inputs are copied on submit, so the buffer may go away right after
+      int64_t ticket = pot_calculate_submit(client, natoms, shifted.data(),
+                                            atmnrs.data(), box.data(),
+                                            &energies[c],
+                                            pipelined.data() + c * natoms * 3);
+      REQUIRE(ticket > 0);
+      tickets.push_back(ticket);
+    }
+    CHECK(pot_calculate_poll(client, tickets.back()) >= 0);
+
+    // Collect half in completion order, the rest by ticket
+    std::vector<int64_t> remaining(tickets.begin(), tickets.begin() + 8);
+    while (!remaining.empty()) {
+      int32_t idx = -1;
+      REQUIRE(pot_calculate_wait_any(client, remaining.data(),
+                                     static_cast<int32_t>(remaining.size()),
+                                     &idx) == 0);
+      REQUIRE(idx >= 0);
+      remaining.erase(remaining.begin() + idx);
+    }
+    for (int32_t c = 8; c < ncalls; ++c) {
+      REQUIRE(pot_calculate_wait(client, tickets[c]) == 0);
+    }
+    CHECK(pot_calculate_wait(client, tickets[0]) == -1);
+
+    for (int32_t c = 0; c < ncalls; ++c) {
+      std::vector<double> shifted = pos;
+      shifted[3] += 0.02 * c;
+      REQUIRE(pot_calculate(client, natoms, shifted.data(), atmnrs.data(),
+                            box.data(), &energy, forces.data()) == 0);
+      CHECK(energies[c] == energy);
+      for (int32_t k = 0; k < natoms * 3; ++k) {
+        CHECK(pipelined[c * natoms * 3 + k] == forces[k]);
+      }
+    }
+  }
+
   SECTION("Payload Size Stress (10k atoms)") {
     int32_t big_N = 10000;
     std::vector<int32_t> big_atmnrs(big_N, 1);
@@ -120,6 +212,227 @@ TEST_CASE("Bridge Calculation Stress", "[bridge][perf]") {
   pot_client_free(client);
 }
 
+TEST_CASE("Bridge Endpoint Lists", "[bridge][core]") {
+  int32_t natoms = 2;
+  std::vector<int32_t> atmnrs = {1, 1};
+  std::vector<double> pos = {0.0, 0.0, 0.0, 0.74, 0.0, 0.0};
+  std::vector<double> box = {10, 0, 0, 0, 10, 0, 0, 0, 10};
+  std::vector<double> forces(natoms * 3);
+  double energy = 0;
+
+  SECTION("Malformed lists and limits are rejected") {
+    CHECK(pot_client_init("127.0.0.1,,127.0.0.2", PORT) == nullptr);
+    CHECK(pot_client_init("127.0.0.1, ", PORT) == nullptr);
+    CHECK(pot_client_set_endpoint_limit(nullptr, 1) != 0);
+
+    PotClient *client = pot_client_init("127.0.0.1, 127.0.0.2:1", PORT);
+    REQUIRE(client != nullptr);
+    CHECK(pot_client_set_endpoint_limit(client, -1) != 0);
+    CHECK(pot_client_set_endpoint_limit(client, 2) == 0);
+    pot_client_free(client);
+  }
+
+  SECTION("Lists of dead endpoints fail cleanly") {
+    // Port 1 is not served, nor is the socket path
+    PotClient *client =
+        pot_client_init("127.0.0.1:1,unix:/nonexistent/rgpot.sock", PORT);
+    REQUIRE(client != nullptr);
+    for (int i = 0; i < 3; ++i) {
+      CHECK(pot_calculate(client, natoms, pos.data(), atmnrs.data(),
+                          box.data(), &energy, forces.data()) != 0);
+      CHECK(pot_get_last_error(client)[0] != '\0');
+    }
+    std::vector<double> energies(2);
+    std::vector<double> batch_pos(2 * pos.size());
+    std::vector<double> batch_box(2 * box.size());
+    std::vector<double> batch_forces(2 * forces.size());
+    CHECK(pot_calculate_batch(client, 2, natoms, batch_pos.data(),
+                              atmnrs.data(), batch_box.data(),
+                              energies.data(), batch_forces.data()) != 0);
+    pot_client_free(client);
+  }
+
+  SECTION("Calls fail over from dead endpoints") {
+    PotClient *single = pot_client_init(HOST.c_str(), PORT);
+    REQUIRE(single != nullptr);
+    const bool up = pot_calculate(single, natoms, pos.data(), atmnrs.data(),
+                                  box.data(), &energy, forces.data()) == 0;
+    const double expected = energy;
+    pot_client_free(single);
+    if (!up) {
+      SKIP("Server not available at " << HOST << ":" << PORT);
+    }
+
+    const std::string list = "127.0.0.1:1," + HOST;
+    PotClient *client = pot_client_init(list.c_str(), PORT);
+    REQUIRE(client != nullptr);
+    REQUIRE(pot_client_set_endpoint_limit(client, 2) == 0);
+
+    // Calls sent to the dead endpoint are resent to the live one
+    const int32_t ncalls = 16;
+    std::vector<double> energies(ncalls, 0.0);
+    std::vector<double> all_forces(ncalls * natoms * 3);
+    std::vector<int64_t> tickets;
+    for (int32_t c = 0; c < ncalls; ++c) {
+      const int64_t ticket = pot_calculate_submit(
+          client, natoms, pos.data(), atmnrs.data(), box.data(), &energies[c],
+          all_forces.data() + c * natoms * 3);
+      REQUIRE(ticket > 0);
+      tickets.push_back(ticket);
+    }
+    for (int32_t c = 0; c < ncalls; ++c) {
+      INFO(pot_get_last_error(client));
+      REQUIRE(pot_calculate_wait(client, tickets[c]) == 0);
+      CHECK(energies[c] == expected);
+    }
+
+    const int32_t nconf = 4;
+    std::vector<double> batch_pos;
+    std::vector<double> batch_box;
+    for (int32_t c = 0; c < nconf; ++c) {
+      batch_pos.insert(batch_pos.end(), pos.begin(), pos.end());
+      batch_box.insert(batch_box.end(), box.begin(), box.end());
+    }
+    std::vector<double> batch_energies(nconf);
+    std::vector<double> batch_forces(nconf * natoms * 3);
+    REQUIRE(pot_calculate_batch(client, nconf, natoms, batch_pos.data(),
+                                atmnrs.data(), batch_box.data(),
+                                batch_energies.data(),
+                                batch_forces.data()) == 0);
+    for (double e : batch_energies) {
+      CHECK(e == expected);
+    }
+    pot_client_free(client);
+  }
+}
+
+TEST_CASE("Bridge Sessions", "[bridge][core]") {
+  PotClient *client = pot_client_init(HOST.c_str(), PORT);
+  REQUIRE(client != nullptr);
+
+  // A small periodic cluster on a cubic lattice
+  const int32_t natoms = 8;
+  std::vector<int32_t> atmnrs(natoms, 1);
+  std::vector<double> pos;
+  for (int32_t i = 0; i < natoms; ++i) {
+    pos.push_back(1.1 * (i % 2));
+    pos.push_back(1.1 * ((i / 2) % 2));
+    pos.push_back(1.1 * (i / 4));
+  }
+  std::vector<double> box = {10, 0, 0, 0, 10, 0, 0, 0, 10};
+  std::vector<double> forces(natoms * 3);
+  std::vector<double> expected_forces(natoms * 3);
+  double energy = 0;
+  double expected = 0;
+  if (pot_calculate(client, natoms, pos.data(), atmnrs.data(), box.data(),
+                    &expected, expected_forces.data()) != 0) {
+    pot_client_free(client);
+    SKIP("Server not available at " << HOST << ":" << PORT);
+  }
+
+  PotSession *session =
+      pot_session_open(client, natoms, atmnrs.data(), box.data());
+  REQUIRE(session != nullptr);
+
+  // Compares a step of the session with a plain calculation; the sums may
+  // run in another order, and shifts move atoms by their Float32 rounding
+  auto check_step = [&](const double *step_box, double tolerance) {
+    const double *cell = step_box ? step_box : box.data();
+    INFO(pot_get_last_error(client));
+    REQUIRE(pot_session_step(session, pos.data(), step_box, &energy,
+                             forces.data()) == 0);
+    REQUIRE(pot_calculate(client, natoms, pos.data(), atmnrs.data(), cell,
+                          &expected, expected_forces.data()) == 0);
+    CHECK(energy == Catch::Approx(expected).epsilon(1e-9).margin(tolerance));
+    for (size_t k = 0; k < forces.size(); ++k) {
+      CHECK(forces[k] ==
+            Catch::Approx(expected_forces[k]).epsilon(1e-9).margin(tolerance));
+    }
+  };
+
+  SECTION("Full, moved and shifted frames match plain calculations") {
+    check_step(nullptr, 1e-9);
+    // One atom moves, sent as a sparse frame
+    pos[0] += 0.05;
+    check_step(nullptr, 1e-9);
+    // Nothing moves
+    check_step(nullptr, 1e-9);
+    // Every atom moves, sent in full
+    for (double &x : pos) {
+      x += 0.01;
+    }
+    check_step(nullptr, 1e-9);
+    // Every atom moves, sent as Float32 shifts
+    REQUIRE(pot_session_set_float_shifts(session, 1) == 0);
+    for (size_t k = 0; k < pos.size(); ++k) {
+      pos[k] += 0.003 * static_cast<double>(k % 5);
+    }
+    check_step(nullptr, 1e-5);
+    // The cell changes
+    std::vector<double> bigger = {11, 0, 0, 0, 11, 0, 0, 0, 11};
+    check_step(bigger.data(), 1e-5);
+  }
+
+  SECTION("Invalid arguments are rejected") {
+    CHECK(pot_session_open(nullptr, natoms, atmnrs.data(), box.data()) ==
+          nullptr);
+    CHECK(pot_session_open(client, -1, atmnrs.data(), box.data()) == nullptr);
+    CHECK(pot_session_step(nullptr, pos.data(), nullptr, &energy,
+                           forces.data()) != 0);
+    CHECK(pot_session_step(session, nullptr, nullptr, &energy,
+                           forces.data()) != 0);
+    CHECK(pot_session_set_float_shifts(nullptr, 1) != 0);
+  }
+
+  pot_session_free(session);
+  pot_client_free(client);
+}
+
+TEST_CASE("Bridge Identical Calls", "[bridge][core]") {
+  PotClient *client = pot_client_init(HOST.c_str(), PORT);
+  REQUIRE(client != nullptr);
+
+  // Two configurations, each sent several times while the others run
+  const int32_t natoms = 2;
+  std::vector<int32_t> atmnrs = {1, 1};
+  const std::vector<std::vector<double>> configs = {
+      {0.0, 0.0, 0.0, 0.74, 0.0, 0.0}, {0.0, 0.0, 0.0, 1.2, 0.0, 0.0}};
+  std::vector<double> box = {10, 0, 0, 0, 10, 0, 0, 0, 10};
+  std::vector<double> expected(configs.size());
+  std::vector<std::vector<double>> expected_forces(
+      configs.size(), std::vector<double>(natoms * 3));
+  for (size_t k = 0; k < configs.size(); ++k) {
+    if (pot_calculate(client, natoms, configs[k].data(), atmnrs.data(),
+                      box.data(), &expected[k],
+                      expected_forces[k].data()) != 0) {
+      pot_client_free(client);
+      SKIP("Server not available at " << HOST << ":" << PORT);
+    }
+  }
+
+  // Whether or not the server shares the work, every call gets its result
+  const int32_t ncalls = 12;
+  std::vector<double> energies(ncalls, 0.0);
+  std::vector<double> all_forces(ncalls * natoms * 3, 0.0);
+  std::vector<int64_t> tickets;
+  for (int32_t c = 0; c < ncalls; ++c) {
+    const int64_t ticket = pot_calculate_submit(
+        client, natoms, configs[c % 2].data(), atmnrs.data(), box.data(),
+        &energies[c], all_forces.data() + c * natoms * 3);
+    REQUIRE(ticket > 0);
+    tickets.push_back(ticket);
+  }
+  for (int32_t c = 0; c < ncalls; ++c) {
+    INFO(pot_get_last_error(client));
+    REQUIRE(pot_calculate_wait(client, tickets[c]) == 0);
+    CHECK(energies[c] == expected[c % 2]);
+    for (int32_t i = 0; i < natoms * 3; ++i) {
+      CHECK(all_forces[c * natoms * 3 + i] == expected_forces[c % 2][i]);
+    }
+  }
+  pot_client_free(client);
+}
+
 TEST_CASE("Bridge Concurrency", "[bridge][threaded]") {
   // Spin up 4 threads, each with its OWN client (recommended usage)
   // Sharing one client across threads requires locking inside the bridge
@@ -0,0 +1,85 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "rgpot/types/AtomMatrix.hpp"
+#include "rgpot/types/BufferPool.hpp"
+
+using rgpot::types::BufferPool;
+
+TEST_CASE("BufferPool recycles blocks by size class", "[BufferPool]") {
+  BufferPool pool(2);
+  void *a = pool.allocate(100);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(a) % BufferPool::alignment == 0);
+  pool.deallocate(a, 100);
+  REQUIRE(pool.cached_bytes() == 128);
+
+  // Any request of the same class reuses the block
+  void *b = pool.allocate(120);
+  REQUIRE(b == a);
+  REQUIRE(pool.cached_bytes() == 0);
+
+  // Only two free blocks per class are kept
+  void *c = pool.allocate(120);
+  void *d = pool.allocate(120);
+  pool.deallocate(b, 120);
+  pool.deallocate(c, 120);
+  pool.deallocate(d, 120);
+  REQUIRE(pool.cached_bytes() == 2 * 128);
+
+  // Oversized requests bypass the pool
+  void *big = pool.allocate(BufferPool::max_bytes + 1);
+  pool.deallocate(big, BufferPool::max_bytes + 1);
+  REQUIRE(pool.cached_bytes() == 2 * 128);
+
+  pool.trim();
+  REQUIRE(pool.cached_bytes() == 0);
+}
+
+TEST_CASE("AtomMatrix reuses pooled storage", "[BufferPool]") {
+  const double *first = nullptr;
+  {
+    auto m = rgpot::types::AtomMatrix::Zero(37, 3);
+    first = m.data();
+  }
+  auto again = rgpot::types::AtomMatrix::Zero(37, 3);
+  REQUIRE(again.data() == first);
+  for (size_t i = 0; i < again.size(); ++i) {
+    REQUIRE(again.data()[i] == 0.0);
+  }
+
+  rgpot::types::AtomMatrix copy = again;
+  REQUIRE(copy.data() != again.data());
+  REQUIRE(copy.rows() == 37);
+}
+
+TEST_CASE("BufferPool is safe under concurrent use", "[BufferPool]") {
+  BufferPool pool(8);
+  std::atomic<bool> consistent{true};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&pool, &consistent, t] {
+      for (size_t i = 0; i < 2000; ++i) {
+        const size_t n = 8 * (1 + (i + t) % 5);
+        auto *p = static_cast<double *>(pool.allocate(n * sizeof(double)));
+        for (size_t k = 0; k < n; ++k) {
+          p[k] = static_cast<double>(t);
+        }
+        for (size_t k = 0; k < n; ++k) {
+          if (p[k] != static_cast<double>(t)) {
+            consistent = false;
+          }
+        }
+        pool.deallocate(p, n * sizeof(double));
+      }
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  REQUIRE(consistent);
+}
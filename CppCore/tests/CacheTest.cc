@@ -1,9 +1,12 @@
 // MIT License
 // Copyright 2023--present rgpot developers
+#include <algorithm>
 #include <catch2/catch_all.hpp>
 #include <chrono>
+#include <cmath>
 #include <filesystem>
 #include <random>
+#include <stdexcept>
 
 #include "rgpot/LennardJones/LJPot.hpp"
 #include "rgpot/PotentialCache.hpp"
@@ -126,6 +129,38 @@ TEST_CASE("Potential caching with rgpot", "[Potential]") {
     }
   }
 
+  SECTION("Batched calls consult the cache per configuration") {
+    std::string db_path = "/tmp/rgpot_test_rocksdb_batch";
+    rocksdb::Options opts;
+    rocksdb::DestroyDB(db_path, opts);
+    auto pcache = rgpot::cache::PotentialCache(db_path);
+    pot->set_cache(&pcache);
+
+    // Two copies of the same configuration
+    const size_t stride = n_atoms * 3;
+    std::vector<double> pos(2 * stride);
+    std::copy_n(positions.data(), stride, pos.data());
+    std::copy_n(positions.data(), stride, pos.data() + stride);
+    std::vector<double> boxes{10, 0, 0, 0, 10, 0, 0, 0, 10,
+                              10, 0, 0, 0, 10, 0, 0, 0, 10};
+    std::vector<double> energies(2);
+    std::vector<double> forces(2 * stride);
+
+    const size_t calls_before = rgpot::registry<rgpot::LJPot>::forceCalls;
+    auto &stats = rgpot::PotentialStats::for_type(rgpot::PotType::LJ);
+    const PotStats stats_before = stats.snapshot();
+    pot->calculate_batch(2, n_atoms, pos.data(), types.data(), boxes.data(),
+                         energies.data(), forces.data());
+    REQUIRE(rgpot::registry<rgpot::LJPot>::forceCalls == calls_before + 1);
+    REQUIRE(stats.snapshot().cache_misses == stats_before.cache_misses + 1);
+    REQUIRE(stats.snapshot().cache_hits == stats_before.cache_hits + 1);
+    REQUIRE_THAT(energies[0], WithinAbs(e_base, 1e-12));
+    REQUIRE_THAT(energies[1], WithinAbs(e_base, 1e-12));
+    for (size_t k = 0; k < stride; ++k) {
+      REQUIRE(forces[k] == forces[stride + k]);
+    }
+  }
+
   SECTION("Uninitialized Cache (Graceful Degradation)") {
     // Cache object created but no DB set
     auto pcache_empty = rgpot::cache::PotentialCache();
@@ -141,3 +176,202 @@ TEST_CASE("Potential caching with rgpot", "[Potential]") {
     // We just check it didn't throw exceptions
   }
 }
+
+TEST_CASE("Binary cache keys and payload checksums", "[Potential]") {
+  const size_t n_atoms = 2;
+  std::vector<double> pos{0, 0, 0, 1, 1, 1};
+  std::vector<int> types{1, 2};
+  std::vector<double> box{5, 0, 0, 0, 5, 0, 0, 0, 5};
+  rgpot::ForceInput fi{.nAtoms = n_atoms,
+                       .pos = pos.data(),
+                       .atmnrs = types.data(),
+                       .box = box.data()};
+
+  auto key = rgpot::cache::make_key(fi, 1);
+  REQUIRE(key.view().size() == rgpot::cache::KeyHash::width);
+  REQUIRE(rgpot::cache::make_key(fi, 1).view() == key.view());
+  REQUIRE(rgpot::cache::make_key(fi, 2).view() != key.view());
+
+  // With XOR-combined field digests, positions equal to the box cancel out
+  // and all such three-atom systems would share one key
+  std::vector<int> three{1, 1, 1};
+  std::vector<double> cell_a{4, 0, 0, 0, 4, 0, 0, 0, 4};
+  std::vector<double> cell_b{6, 0, 0, 0, 6, 0, 0, 0, 6};
+  rgpot::ForceInput fi_a{.nAtoms = 3,
+                         .pos = cell_a.data(),
+                         .atmnrs = three.data(),
+                         .box = cell_a.data()};
+  rgpot::ForceInput fi_b{.nAtoms = 3,
+                         .pos = cell_b.data(),
+                         .atmnrs = three.data(),
+                         .box = cell_b.data()};
+  REQUIRE(rgpot::cache::make_key(fi_a, 1).view() !=
+          rgpot::cache::make_key(fi_b, 1).view());
+
+  SECTION("Corrupted values are misses") {
+    std::string db_path = "/tmp/rgpot_test_rocksdb_checksum";
+    rocksdb::Options opts;
+    opts.create_if_missing = true;
+    rocksdb::DestroyDB(db_path, opts);
+    rocksdb::DB *db_ptr = nullptr;
+    REQUIRE(rocksdb::DB::Open(opts, db_path, &db_ptr).ok());
+    auto db = std::unique_ptr<rocksdb::DB>(db_ptr);
+
+    rgpot::cache::PotentialCache cache;
+    cache.set_db(db.get());
+    cache.set_checksum(true);
+
+    const double forces[6] = {1, 2, 3, 4, 5, 6};
+    cache.store(key, -1.5, forces, 6);
+    double energy = 0.0;
+    double out[6] = {0};
+    REQUIRE(cache.lookup(key, energy, out, 6));
+    REQUIRE(energy == -1.5);
+    REQUIRE(out[5] == 6.0);
+
+    auto raw = cache.find(key);
+    REQUIRE(raw);
+    REQUIRE(raw->size() == 7 * sizeof(double) + sizeof(uint64_t));
+    (*raw)[sizeof(double) + 3] ^= 0x10;
+    db->Put(rocksdb::WriteOptions(), key.slice(), *raw);
+    REQUIRE_FALSE(cache.lookup(key, energy, out, 6));
+
+    // Values written without a checksum are still accepted
+    cache.set_checksum(false);
+    cache.store(key, -1.5, forces, 6);
+    REQUIRE(cache.find(key)->size() == 7 * sizeof(double));
+    REQUIRE(cache.lookup(key, energy, out, 6));
+  }
+}
+
+TEST_CASE("Quantized lookup of near-duplicate geometries", "[Potential]") {
+  const size_t n_atoms = 16;
+  rgpot::types::AtomMatrix positions(n_atoms, 3);
+  std::mt19937 gen(77);
+  std::uniform_real_distribution<> dis(0.0, 8.0);
+  for (size_t i = 0; i < n_atoms * 3; ++i) {
+    // Away from the cell boundaries of a 1e-6 grid
+    positions.data()[i] = std::round(dis(gen) * 1e6) * 1e-6;
+  }
+  std::vector<int> types(n_atoms, 1);
+  std::array<std::array<double, 3>, 3> box = {
+      {{8, 0, 0}, {0, 8, 0}, {0, 0, 8}}};
+  auto pot = rgpot::LJPot();
+
+  auto check = [&](rgpot::cache::PotentialCache &cache) {
+    cache.set_quantization(1e-6, 1e-9);
+    pot.set_cache(&cache);
+    auto [e1, f1] = pot(positions, types, box);
+
+    rgpot::types::AtomMatrix nudged = positions;
+    for (size_t i = 0; i < n_atoms * 3; ++i) {
+      nudged.data()[i] += (i % 2 ? 1e-14 : -1e-14);
+    }
+    const size_t before = rgpot::registry<rgpot::LJPot>::forceCalls;
+    auto [e2, f2] = pot(nudged, types, box);
+    REQUIRE(rgpot::registry<rgpot::LJPot>::forceCalls == before);
+    for (size_t k = 0; k < n_atoms * 3; ++k) {
+      REQUIRE(f2.data()[k] == f1.data()[k]);
+    }
+
+    // Same cell, but outside the tolerance
+    nudged.data()[4] += 1e-7;
+    pot(nudged, types, box);
+    REQUIRE(rgpot::registry<rgpot::LJPot>::forceCalls == before + 1);
+    pot.set_cache(nullptr);
+  };
+
+  REQUIRE_THROWS_AS(rgpot::cache::PotentialCache().set_quantization(-1, 0),
+                    std::invalid_argument);
+  REQUIRE_THROWS_AS(rgpot::cache::PotentialCache().set_quantization(1, 2),
+                    std::invalid_argument);
+
+  SECTION("Memory tier") {
+    rgpot::cache::PotentialCache cache;
+    cache.set_memory_tier({.mode = rgpot::cache::TierMode::MemoryOnly});
+    check(cache);
+  }
+
+  SECTION("RocksDB") {
+    const std::string db_path = "/tmp/rgpot_test_rocksdb_quantized";
+    rocksdb::Options opts;
+    rocksdb::DestroyDB(db_path, opts);
+    rgpot::cache::PotentialCache cache(db_path);
+    check(cache);
+  }
+}
+
+TEST_CASE("Tuned databases, batched writes and SST round trips",
+          "[Potential]") {
+  const size_t count = 64;
+  const size_t n = 6;
+  std::vector<rgpot::cache::KeyHash> keys;
+  std::vector<double> energies(count);
+  std::vector<double> forces(count * n);
+  for (size_t i = 0; i < count; ++i) {
+    keys.emplace_back(rgpot::cache::KeyHash(i * 7919 + 1, i));
+    energies[i] = -0.25 * static_cast<double>(i);
+    for (size_t k = 0; k < n; ++k) {
+      forces[i * n + k] = static_cast<double>(i) + 0.1 * static_cast<double>(k);
+    }
+  }
+  auto expect_all = [&](rgpot::cache::PotentialCache &cache) {
+    double energy = 0.0;
+    std::vector<double> out(n);
+    for (size_t i = 0; i < count; ++i) {
+      REQUIRE(cache.lookup(keys[i], energy, out.data(), n));
+      REQUIRE(energy == energies[i]);
+      REQUIRE(out[n - 1] == forces[i * n + n - 1]);
+    }
+  };
+
+  const std::string src_path = "/tmp/rgpot_test_rocksdb_bulk_src";
+  const std::string dst_path = "/tmp/rgpot_test_rocksdb_bulk_dst";
+  const std::string sst_path = "/tmp/rgpot_test_bulk.sst";
+  rocksdb::Options opts;
+  rocksdb::DestroyDB(src_path, opts);
+  rocksdb::DestroyDB(dst_path, opts);
+
+  rgpot::cache::PotentialCache src(src_path,
+                                   rgpot::cache::DbOptions::point_lookup(
+                                       size_t{8} << 20,
+                                       rgpot::cache::Compression::None));
+  REQUIRE(src.is_open());
+
+  SECTION("add_many with and without the write-ahead log") {
+    src.add_many(count / 2, keys.data(), energies.data(), forces.data(), n);
+    src.add_many(count / 2, keys.data() + count / 2,
+                 energies.data() + count / 2, forces.data() + count / 2 * n, n,
+                 true);
+    expect_all(src);
+
+    REQUIRE(src.export_sst(sst_path) == count);
+    rgpot::cache::PotentialCache dst(dst_path);
+    dst.ingest_sst({sst_path});
+    expect_all(dst);
+  }
+
+  SECTION("Offline SST files, unsorted and with duplicates") {
+    std::vector<rgpot::cache::KeyHash> rev(keys.rbegin(), keys.rend());
+    std::vector<double> rev_e(energies.rbegin(), energies.rend());
+    std::vector<double> rev_f(count * n);
+    for (size_t i = 0; i < count; ++i) {
+      std::copy_n(forces.begin() + (count - 1 - i) * n, n,
+                  rev_f.begin() + i * n);
+    }
+    rev.push_back(rev.front());
+    rev_e.push_back(rev_e.front());
+    rev_f.insert(rev_f.end(), rev_f.begin(), rev_f.begin() + n);
+
+    rgpot::cache::PotentialCache offline;
+    offline.write_sst(sst_path, rev.size(), rev.data(), rev_e.data(),
+                      rev_f.data(), n);
+    REQUIRE_THROWS_AS(offline.write_sst(sst_path, 0, rev.data(), rev_e.data(),
+                                        rev_f.data(), n),
+                      std::invalid_argument);
+    REQUIRE_THROWS_AS(offline.export_sst(sst_path), std::runtime_error);
+
+    src.ingest_sst({sst_path});
+    expect_all(src);
+  }
+}
@@ -0,0 +1,218 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <atomic>
+#include <catch2/catch_all.hpp>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rgpot/CacheTier.hpp"
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/PotentialCache.hpp"
+
+#include <rocksdb/db.h>
+#include <rocksdb/options.h>
+
+using rgpot::cache::ShardedLRU;
+using rgpot::cache::TierMode;
+using rgpot::cache::TierOptions;
+
+TEST_CASE("ShardedLRU stores and evicts by byte budget", "[CacheTier]") {
+  std::vector<double> forces(30);
+  for (size_t i = 0; i < forces.size(); ++i) {
+    forces[i] = 0.5 * static_cast<double>(i);
+  }
+  // One shard holding a handful of these entries
+  ShardedLRU lru(4 * (31 * sizeof(double) + 160), 1);
+
+  for (size_t k = 0; k < 8; ++k) {
+    lru.put(k, std::to_string(k), static_cast<double>(k), forces.data(),
+            forces.size(), false, {});
+  }
+  REQUIRE(lru.size() < 8);
+  REQUIRE(lru.size_bytes() <= 4 * (31 * sizeof(double) + 160));
+
+  double energy = 0.0;
+  std::vector<double> out(30, -1.0);
+  REQUIRE(lru.get(7, "7", energy, out.data(), out.size()));
+  REQUIRE(energy == 7.0);
+  REQUIRE(out == forces);
+  REQUIRE_FALSE(lru.get(0, "0", energy, out.data(), out.size()));
+  // A size mismatch is a miss, not a partial copy
+  REQUIRE_FALSE(lru.get(7, "7", energy, out.data(), 3));
+
+  SECTION("Recently read entries survive eviction") {
+    const size_t before = lru.size();
+    REQUIRE(lru.get(7 - before + 1, std::to_string(7 - before + 1), energy,
+                    out.data(), out.size()));
+    lru.put(100, "100", 1.0, forces.data(), forces.size(), false, {});
+    REQUIRE(lru.get(7 - before + 1, std::to_string(7 - before + 1), energy,
+                    out.data(), out.size()));
+  }
+
+  SECTION("Dirty entries are spilled on eviction and drain") {
+    ShardedLRU wb(2 * (31 * sizeof(double) + 160), 1);
+    std::map<std::string, size_t> spilled;
+    auto spill = [&](std::string_view key, std::string_view value) {
+      spilled[std::string(key)] = value.size();
+    };
+    wb.put(1, "a", 1.0, forces.data(), forces.size(), true, spill);
+    wb.put(2, "b", 2.0, forces.data(), forces.size(), true, spill);
+    wb.put(3, "c", 3.0, forces.data(), forces.size(), true, spill);
+    REQUIRE(spilled.count("a") == 1);
+    REQUIRE(spilled["a"] == 31 * sizeof(double));
+
+    wb.drain_dirty(spill);
+    REQUIRE(spilled.size() == 3);
+    spilled.clear();
+    wb.drain_dirty(spill);
+    REQUIRE(spilled.empty());
+  }
+}
+
+TEST_CASE("ShardedLRU is safe under concurrent use", "[CacheTier]") {
+  ShardedLRU lru(size_t{1} << 20, 8);
+  std::atomic<bool> consistent{true};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&lru, &consistent, t] {
+      double f[3] = {1.0, 2.0, 3.0};
+      double out[3];
+      double energy = 0.0;
+      for (size_t i = 0; i < 2000; ++i) {
+        const size_t k = (i * 7 + t) % 300;
+        if (!lru.get(k, std::to_string(k), energy, out, 3)) {
+          lru.put(k, std::to_string(k), static_cast<double>(k), f, 3, false,
+                  {});
+        } else if (energy != static_cast<double>(k)) {
+          consistent = false;
+        }
+      }
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  REQUIRE(consistent);
+  REQUIRE(lru.size() <= 300);
+}
+
+TEST_CASE("PotentialCache tier modes", "[CacheTier][Potential]") {
+  const size_t n_atoms = 32;
+  rgpot::types::AtomMatrix positions(n_atoms, 3);
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<> dis(0.0, 12.0);
+  for (size_t i = 0; i < n_atoms * 3; ++i) {
+    positions.data()[i] = dis(gen);
+  }
+  std::vector<int> types(n_atoms, 1);
+  std::array<std::array<double, 3>, 3> box = {
+      {{12, 0, 0}, {0, 12, 0}, {0, 0, 12}}};
+  auto pot = rgpot::LJPot();
+
+  auto run = [&](rgpot::cache::PotentialCache &cache) {
+    pot.set_cache(&cache);
+    const size_t before = rgpot::registry<rgpot::LJPot>::forceCalls;
+    auto [e1, f1] = pot(positions, types, box);
+    auto [e2, f2] = pot(positions, types, box);
+    pot.set_cache(nullptr);
+    REQUIRE(rgpot::registry<rgpot::LJPot>::forceCalls == before + 1);
+    for (size_t k = 0; k < n_atoms * 3; ++k) {
+      REQUIRE(f2.data()[k] == f1.data()[k]);
+    }
+  };
+
+  SECTION("Memory only needs no database") {
+    rgpot::cache::PotentialCache cache;
+    cache.set_memory_tier({.mode = TierMode::MemoryOnly});
+    run(cache);
+    REQUIRE(cache.memory_tier()->size() == 1);
+  }
+
+  SECTION("Write-back persists on destruction") {
+    const std::string db_path = "/tmp/rgpot_test_rocksdb_writeback";
+    rocksdb::Options opts;
+    rocksdb::DestroyDB(db_path, opts);
+    {
+      rgpot::cache::PotentialCache cache(db_path,
+                                         {.mode = TierMode::WriteBack});
+      run(cache);
+    }
+    // A fresh cache without a memory tier hits in RocksDB
+    rgpot::cache::PotentialCache reopened(db_path);
+    pot.set_cache(&reopened);
+    const size_t before = rgpot::registry<rgpot::LJPot>::forceCalls;
+    pot(positions, types, box);
+    pot.set_cache(nullptr);
+    REQUIRE(rgpot::registry<rgpot::LJPot>::forceCalls == before);
+  }
+
+  SECTION("Write-through promotes database hits") {
+    const std::string db_path = "/tmp/rgpot_test_rocksdb_writethrough";
+    rocksdb::Options opts;
+    rocksdb::DestroyDB(db_path, opts);
+    {
+      rgpot::cache::PotentialCache cache(db_path,
+                                         {.mode = TierMode::WriteThrough});
+      run(cache);
+    }
+    rgpot::cache::PotentialCache cache(db_path,
+                                       {.mode = TierMode::WriteThrough});
+    REQUIRE(cache.memory_tier()->size() == 0);
+    pot.set_cache(&cache);
+    pot(positions, types, box);
+    pot.set_cache(nullptr);
+    REQUIRE(cache.memory_tier()->size() == 1);
+  }
+}
+
+TEST_CASE("Write-back entries survive evictions by database hits",
+          "[CacheTier][Potential]") {
+  const std::string db_path = "/tmp/rgpot_test_rocksdb_writeback_evict";
+  rocksdb::Options opts;
+  rocksdb::DestroyDB(db_path, opts);
+  std::vector<double> pos(30);
+  std::vector<int> types(10, 1);
+  const double box[9] = {10, 0, 0, 0, 10, 0, 0, 0, 10};
+  std::vector<double> forces(30, 0.25);
+  auto key = [&](size_t k) {
+    pos[0] = static_cast<double>(k);
+    return rgpot::cache::make_key({.nAtoms = 10,
+                                   .pos = pos.data(),
+                                   .atmnrs = types.data(),
+                                   .box = box},
+                                  0);
+  };
+
+  // Results only RocksDB holds
+  {
+    rgpot::cache::PotentialCache cache(db_path);
+    for (size_t k = 100; k < 108; ++k) {
+      cache.store(key(k), static_cast<double>(k), forces.data(), 30);
+    }
+  }
+
+  // A single shard holding a handful of entries, all dirty
+  rgpot::cache::PotentialCache cache(
+      db_path, {.mode = TierMode::WriteBack,
+                .capacity_bytes = 4 * (31 * sizeof(double) + 160),
+                .num_shards = 1});
+  for (size_t k = 0; k < 4; ++k) {
+    cache.store(key(k), static_cast<double>(k), forces.data(), 30);
+  }
+  double energy = 0.0;
+  std::vector<double> out(30);
+  for (size_t k = 100; k < 108; ++k) {
+    REQUIRE(cache.lookup(key(k), energy, out.data(), 30));
+    REQUIRE(energy == static_cast<double>(k));
+  }
+
+  cache.flush();
+  for (size_t k = 0; k < 4; ++k) {
+    REQUIRE(cache.lookup(key(k), energy, out.data(), 30));
+    REQUIRE(energy == static_cast<double>(k));
+    REQUIRE(out == forces);
+  }
+}
@@ -68,3 +68,33 @@ TEST_CASE("CapnpAdapter: Atom Types Conversion", "[rpc][adapter]") {
   REQUIRE(converted[0] == 29);
   REQUIRE(converted[1] == 1);
 }
+
+TEST_CASE("CapnpAdapter: In-place list views", "[rpc][adapter]") {
+  namespace adapt = rgpot::types::adapt::capnp;
+  const double values[6] = {1.0, -2.0, 3.5, 4.0, 5.25, -6.0};
+
+  ::capnp::MallocMessageBuilder message;
+  auto builder = message.initRoot<::capnp::List<double>>(6);
+  adapt::copyToCapnp(builder, values);
+
+  auto reader = builder.asReader();
+  std::vector<double> storage;
+  const double *view = adapt::viewFromCapnp(reader, storage);
+  for (size_t i = 0; i < 6; ++i) {
+    REQUIRE(view[i] == values[i]);
+  }
+
+  if (adapt::hostIsLittleEndian()) {
+    // The view aliases the message, so writes through the builder view land
+    // in the message itself
+    REQUIRE(storage.empty());
+    double *out = adapt::directView<double>(builder);
+    REQUIRE(out == view);
+    out[2] = 42.0;
+    REQUIRE(reader[2] == Catch::Approx(42.0));
+  }
+
+  double copied[6] = {0};
+  adapt::copyFromCapnp(reader, copied, 6);
+  REQUIRE(copied[5] == Catch::Approx(-6.0));
+}
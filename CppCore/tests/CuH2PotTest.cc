@@ -40,3 +40,86 @@ TEST_CASE("CuH2Pot Energy and Forces", "[CuH2Pot]") {
     }
   }
 }
+
+TEST_CASE("CuH2Pot revalidates changed species", "[CuH2Pot]") {
+  using rgpot::types::AtomMatrix;
+  rgpot::CuH2Pot cuh2pot;
+  AtomMatrix positions{{0.63940268750835, 0.90484742551374, 6.97516498544584},
+                       {3.19652040936288, 0.90417430354811, 6.97547796369474},
+                       {8.98363230369760, 9.94703496017833, 7.83556854923689},
+                       {7.64080177576300, 9.94703114803832, 7.83556986121272}};
+  std::array<std::array<double, 3>, 3> box{
+      {{15.3456, 0, 0}, {0, 21.702, 0}, {0, 0, 100.0}}};
+  std::vector<int> atmtypes{29, 29, 1, 1};
+  auto [energy, forces] = cuh2pot(positions, atmtypes, box);
+
+  // Same atom count, other species
+  std::vector<int> with_oxygen{29, 29, 1, 8};
+  REQUIRE_THROWS_AS(cuh2pot(positions, with_oxygen, box), std::runtime_error);
+  std::vector<int> no_hydrogen{29, 29, 29, 29};
+  REQUIRE_THROWS_AS(cuh2pot(positions, no_hydrogen, box), std::runtime_error);
+
+  // Same atom count, other counts: a fresh instance must agree
+  std::vector<int> more_copper{29, 29, 29, 1};
+  auto [e_cached, f_cached] = cuh2pot(positions, more_copper, box);
+  auto [e_fresh, f_fresh] = rgpot::CuH2Pot()(positions, more_copper, box);
+  REQUIRE_THAT(e_cached, Catch::Matchers::WithinAbs(e_fresh, 1e-12));
+
+  auto [e_again, f_again] = cuh2pot(positions, atmtypes, box);
+  REQUIRE_THAT(e_again, Catch::Matchers::WithinAbs(energy, 1e-12));
+}
+
+TEST_CASE("CuH2Pot evaluates replicas in one call", "[CuH2Pot]") {
+  using rgpot::types::AtomMatrix;
+  const size_t n_atoms = 4;
+  const size_t nconf = 3;
+  const size_t stride = n_atoms * 3;
+  AtomMatrix base{{0.63940268750835, 0.90484742551374, 6.97516498544584},
+                  {3.19652040936288, 0.90417430354811, 6.97547796369474},
+                  {8.98363230369760, 9.94703496017833, 7.83556854923689},
+                  {7.64080177576300, 9.94703114803832, 7.83556986121272}};
+  std::vector<int> atmtypes{29, 29, 1, 1};
+  std::array<std::array<double, 3>, 3> box{
+      {{15.3456, 0, 0}, {0, 21.702, 0}, {0, 0, 100.0}}};
+
+  std::vector<double> positions(nconf * stride);
+  std::vector<double> boxes(nconf * 9, 0.0);
+  std::vector<double> expected_energy;
+  std::vector<std::vector<double>> expected_forces;
+  rgpot::CuH2Pot single;
+  for (size_t c = 0; c < nconf; ++c) {
+    AtomMatrix pos = base;
+    pos(2, 0) += 0.1 * static_cast<double>(c); // Move one H along the path
+    std::copy_n(pos.data(), stride, positions.data() + c * stride);
+    for (size_t d = 0; d < 3; ++d) {
+      boxes[c * 9 + 4 * d] = box[d][d];
+    }
+    auto [e, f] = single(pos, atmtypes, box);
+    expected_energy.push_back(e);
+    expected_forces.emplace_back(f.data(), f.data() + stride);
+  }
+
+  rgpot::CuH2Pot replicas;
+  rgpot::PotentialBase &pot = replicas;
+  std::vector<double> energies(nconf);
+  std::vector<double> forces(nconf * stride, -1.0);
+  pot.calculate_batch(nconf, n_atoms, positions.data(), atmtypes.data(),
+                      boxes.data(), energies.data(), forces.data());
+  for (size_t c = 0; c < nconf; ++c) {
+    REQUIRE_THAT(energies[c],
+                 Catch::Matchers::WithinAbs(expected_energy[c], 1e-12));
+    for (size_t k = 0; k < stride; ++k) {
+      REQUIRE_THAT(forces[c * stride + k],
+                   Catch::Matchers::WithinAbs(expected_forces[c][k], 1e-12));
+    }
+  }
+
+  // A bad composition is rejected before any replica is evaluated
+  std::vector<int> bad{29, 29, 1, 8};
+  const size_t calls = rgpot::registry<rgpot::CuH2Pot>::forceCalls;
+  REQUIRE_THROWS_AS(pot.calculate_batch(nconf, n_atoms, positions.data(),
+                                        bad.data(), boxes.data(),
+                                        energies.data(), forces.data()),
+                    std::runtime_error);
+  REQUIRE(rgpot::registry<rgpot::CuH2Pot>::forceCalls == calls);
+}
@@ -0,0 +1,50 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/types/adapters/eigen.hpp"
+
+using namespace rgpot::types::adapt::eigen;
+
+TEST_CASE("Eigen views alias AtomMatrix storage", "[Eigen]") {
+  AtomMatrix m{{1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}};
+  auto map = viewAsEigen(m);
+  REQUIRE(map.data() == m.data());
+  REQUIRE(map(1, 2) == 6.0);
+  map(0, 0) = -1.0;
+  REQUIRE(m(0, 0) == -1.0);
+
+  const AtomMatrix &cm = m;
+  REQUIRE(viewAsEigen(cm).sum() == 19.0);
+
+  auto y = viewAsEigen(m.y());
+  REQUIRE(y.size() == 2);
+  REQUIRE(y(1) == 5.0);
+  y *= 2.0;
+  REQUIRE(m(1, 1) == 10.0);
+}
+
+TEST_CASE("Row-major Eigen matrices pass to potentials in place", "[Eigen]") {
+  RowMajorMatrix positions(3, 3);
+  positions << 1, 2, 3, 1.5, 2.5, 3.5, 4, 5, 6;
+  std::vector<int> types(3, 0);
+  std::array<std::array<double, 3>, 3> box{
+      {{15.0, 0.0, 0.0}, {0.0, 20.0, 0.0}, {0.0, 0.0, 30.0}}};
+
+  auto view = viewAsAtomMatrix(positions);
+  REQUIRE(view.data() == positions.data());
+
+  rgpot::LJPot pot;
+  auto [e_view, f_view] = pot(view, types, box);
+
+  // The copying path must agree with the view
+  Eigen::MatrixXd colmajor = positions;
+  auto copy = convertToAtomMatrix(colmajor);
+  REQUIRE(copy.data() != positions.data());
+  REQUIRE(copy(1, 2) == 3.5);
+  auto [e_copy, f_copy] = pot(copy, types, box);
+  REQUIRE(e_view == e_copy);
+  REQUIRE(viewAsEigen(f_view) == viewAsEigen(f_copy));
+  REQUIRE(convertToEigen(f_view) == viewAsEigen(f_copy));
+}
@@ -0,0 +1,100 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "rgpot/FrameFile.hpp"
+
+using rgpot::frames::FrameFile;
+namespace frames = rgpot::frames;
+
+namespace {
+
+std::string temp_path(const char *tag) {
+  return "/tmp/rgpot-frames-" + std::string(tag) + "-" +
+         std::to_string(::getpid());
+}
+
+const std::vector<int32_t> kAtmnrs{29, 1, 1};
+const double kBox[9] = {5, 0, 0, 0, 6, 0, 0, 0, 7};
+
+} // namespace
+
+TEST_CASE("FrameFile round trips frames through the mapping",
+          "[FrameFile]") {
+  const std::string path = temp_path("roundtrip");
+  const uint32_t fields = frames::Positions | frames::Energies;
+  {
+    FrameFile out =
+        FrameFile::create(path, fields, 3, 5, kAtmnrs.data(), kBox);
+    REQUIRE(out.forces(0) == nullptr);
+    for (uint64_t f = 0; f < 5; ++f) {
+      for (size_t k = 0; k < 9; ++k) {
+        out.positions(f)[k] = 10.0 * f + k;
+      }
+      *out.energies(f) = -1.0 * f;
+    }
+    out.flush(0, 5, true);
+  }
+
+  const FrameFile in = FrameFile::open(path);
+  REQUIRE(in.natoms() == 3);
+  REQUIRE(in.nframes() == 5);
+  REQUIRE(in.has(frames::Positions));
+  REQUIRE(in.has(frames::Energies));
+  REQUIRE_FALSE(in.has(frames::Forces));
+  REQUIRE(std::vector<int32_t>(in.atmnrs(), in.atmnrs() + 3) == kAtmnrs);
+  REQUIRE(in.box()[4] == 6.0);
+
+  // Frames of a field are contiguous, one batch is a single pointer
+  REQUIRE(in.positions(3) == in.positions(0) + 27);
+  REQUIRE(reinterpret_cast<uintptr_t>(in.positions(0)) % 64 == 0);
+  REQUIRE(reinterpret_cast<uintptr_t>(in.energies(0)) % 64 == 0);
+  for (uint64_t f = 0; f < 5; ++f) {
+    REQUIRE(in.positions(f)[8] == 10.0 * f + 8);
+    REQUIRE(*in.energies(f) == -1.0 * f);
+  }
+
+  // Hints over any range, including past the end, leave the data intact
+  in.prefetch(0, 100);
+  in.evict(1, 3);
+  in.evict(7, 1);
+  REQUIRE(in.positions(2)[0] == 20.0);
+  std::remove(path.c_str());
+}
+
+TEST_CASE("FrameFile sizes its blocks", "[FrameFile]") {
+  // Header and numbers, then 2 frames of positions and energies
+  REQUIRE(FrameFile::file_bytes(frames::Positions, 3, 2) == 192 + 192);
+  REQUIRE(FrameFile::file_bytes(frames::Positions | frames::Energies, 3,
+                                2) == 192 + 192 + 64);
+  REQUIRE(FrameFile::file_bytes(0, 3, 2) == 192);
+  REQUIRE_THROWS_AS(FrameFile::file_bytes(frames::Forces, 1ULL << 62, 8),
+                    std::overflow_error);
+}
+
+TEST_CASE("FrameFile rejects foreign and truncated files", "[FrameFile]") {
+  const std::string path = temp_path("bad");
+  REQUIRE_THROWS_AS(FrameFile::open(path), std::runtime_error);
+
+  {
+    std::ofstream junk(path, std::ios::binary);
+    junk << std::string(256, 'x');
+  }
+  REQUIRE_THROWS_AS(FrameFile::open(path), std::runtime_error);
+
+  {
+    FrameFile out = FrameFile::create(path, frames::Positions, 3, 4,
+                                      kAtmnrs.data(), kBox);
+  }
+  REQUIRE(::truncate(path.c_str(), 300) == 0);
+  REQUIRE_THROWS_WITH(FrameFile::open(path),
+                      Catch::Matchers::ContainsSubstring("truncated"));
+  std::remove(path.c_str());
+}
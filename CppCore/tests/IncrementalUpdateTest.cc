@@ -0,0 +1,193 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/PairFunctionals.hpp"
+
+using namespace Catch::Matchers;
+
+namespace {
+
+std::vector<double> lattice_positions(size_t per_side, double spacing,
+                                      double jitter, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> dis(-jitter, jitter);
+  std::vector<double> pos;
+  for (size_t a = 0; a < per_side; ++a) {
+    for (size_t b = 0; b < per_side; ++b) {
+      for (size_t c = 0; c < per_side; ++c) {
+        pos.push_back(spacing * (a + 0.5) + dis(gen));
+        pos.push_back(spacing * (b + 0.5) + dis(gen));
+        pos.push_back(spacing * (c + 0.5) + dis(gen));
+      }
+    }
+  }
+  return pos;
+}
+
+struct State {
+  std::vector<double> pos;
+  std::vector<double> forces;
+  double energy = 0;
+};
+
+rgpot::ForceInput input_of(const std::vector<double> &pos,
+                           const std::vector<int> &types, const double *box) {
+  return {.nAtoms = types.size(),
+          .pos = pos.data(),
+          .atmnrs = types.data(),
+          .box = box};
+}
+
+// Full evaluation of a configuration into a state
+template <typename Pot>
+State evaluate(Pot &pot, const std::vector<double> &pos,
+               const std::vector<int> &types, const double *box) {
+  State s{pos, std::vector<double>(pos.size()), 0.0};
+  rgpot::ForceOut fo{.F = s.forces.data(), .energy = 0.0, .variance = 0.0};
+  pot.compute_into(input_of(s.pos, types, box), fo);
+  s.energy = fo.energy;
+  return s;
+}
+
+// Moves a few atoms of a state and updates it incrementally
+template <typename Pot>
+State move(Pot &pot, const State &prev, const std::vector<size_t> &moved,
+           std::mt19937 &gen, double step, const std::vector<int> &types,
+           const double *box) {
+  std::uniform_real_distribution<> dis(-step, step);
+  State next = prev;
+  for (size_t i : moved) {
+    for (size_t d = 0; d < 3; ++d) {
+      next.pos[3 * i + d] += dis(gen);
+    }
+  }
+  rgpot::ForceOut fo{
+      .F = next.forces.data(), .energy = prev.energy, .variance = 0.0};
+  pot.compute_moved(input_of(prev.pos, types, box),
+                    input_of(next.pos, types, box), moved.data(),
+                    moved.size(), fo);
+  next.energy = fo.energy;
+  return next;
+}
+
+void require_same(const State &a, const State &b, double tol) {
+  REQUIRE_THAT(a.energy, WithinAbs(b.energy, tol * (1.0 + std::abs(b.energy))));
+  for (size_t k = 0; k < a.forces.size(); ++k) {
+    REQUIRE_THAT(a.forces[k],
+                 WithinAbs(b.forces[k], tol * (1.0 + std::abs(b.forces[k]))));
+  }
+}
+
+} // namespace
+
+TEST_CASE("LJPot updates single-atom moves incrementally",
+          "[Incremental][LJPot]") {
+  const size_t per_side = 8;
+  const double spacing = 1.2;
+  const double len = per_side * spacing;
+  const double box[9] = {len, 0, 0, 0, len, 0, 0, 0, len};
+  const auto pos = lattice_positions(per_side, spacing, 0.1, 3);
+  std::vector<int> types(pos.size() / 3, 1);
+
+  rgpot::LJPot pot;
+  pot.set_num_threads(1);
+  rgpot::LJPot reference;
+  reference.set_num_threads(1);
+  State state = evaluate(pot, pos, types, box);
+
+  rgpot::registry<rgpot::LJPot>::forceCalls = 0;
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<size_t> pick(0, types.size() - 1);
+  for (size_t step = 0; step < 40; ++step) {
+    std::vector<size_t> moved{pick(gen)};
+    if (step % 4 == 3) {
+      // Pairs of two moved atoms, and a repeated index
+      moved.push_back(pick(gen));
+      moved.push_back(moved.front());
+    }
+    state = move(pot, state, moved, gen, 0.03, types, box);
+  }
+  // Every move stayed within half the skin of the last build
+  REQUIRE(rgpot::registry<rgpot::LJPot>::forceCalls == 0);
+  require_same(state, evaluate(reference, state.pos, types, box), 1e-10);
+
+  SECTION("Energy-only updates leave the forces alone") {
+    std::vector<size_t> moved{5};
+    State next = state;
+    next.pos[15] += 0.02;
+    rgpot::ForceOut fo{
+        .F = next.forces.data(), .energy = state.energy, .variance = 0.0};
+    pot.compute_moved(input_of(state.pos, types, box),
+                      input_of(next.pos, types, box), moved.data(), 1, fo,
+                      false);
+    REQUIRE(next.forces == state.forces);
+    REQUIRE_THAT(fo.energy,
+                 WithinRel(evaluate(reference, next.pos, types, box).energy,
+                           1e-10));
+  }
+
+  SECTION("Rejected moves beyond the skin fall back to a full evaluation") {
+    // The trial rebuilds the list, the next move starts from the old state
+    const size_t calls = rgpot::registry<rgpot::LJPot>::forceCalls;
+    const State trial = move(pot, state, {10}, gen, 1.0, types, box);
+    REQUIRE(rgpot::registry<rgpot::LJPot>::forceCalls == calls + 1);
+    require_same(trial, evaluate(reference, trial.pos, types, box), 1e-10);
+    const State other = move(pot, state, {11}, gen, 0.03, types, box);
+    require_same(other, evaluate(reference, other.pos, types, box), 1e-10);
+  }
+
+  SECTION("Invalid indices are rejected") {
+    std::vector<size_t> moved{types.size()};
+    rgpot::ForceOut fo{
+        .F = state.forces.data(), .energy = state.energy, .variance = 0.0};
+    REQUIRE_THROWS_AS(pot.compute_moved(input_of(state.pos, types, box),
+                                        input_of(state.pos, types, box),
+                                        moved.data(), 1, fo),
+                      std::out_of_range);
+  }
+}
+
+TEST_CASE("PairPotential updates moves incrementally",
+          "[Incremental][PairPotential]") {
+  const size_t per_side = 7;
+  const double spacing = 1.1;
+  const double len = per_side * spacing;
+  const double box[9] = {len, 0, 0, 0, len, 0, 0, 0, len};
+  const auto pos = lattice_positions(per_side, spacing, 0.08, 5);
+  std::vector<int> types(pos.size() / 3, 1);
+  std::mt19937 gen(11);
+  std::uniform_int_distribution<size_t> pick(0, types.size() - 1);
+
+  // Switched Morse exercises a truncation touching both energy and force
+  using SwitchedMorse =
+      rgpot::PairPotential<rgpot::pair::Morse, rgpot::truncation::Switched,
+                           rgpot::periodicity::Triclinic>;
+  SwitchedMorse pot(rgpot::pair::Morse{}, 3.0);
+  pot.set_thread_pool(nullptr);
+  SwitchedMorse reference(rgpot::pair::Morse{}, 3.0);
+  State state = evaluate(pot, pos, types, box);
+  using Registry = rgpot::registry<SwitchedMorse>;
+  const size_t calls = Registry::forceCalls;
+  for (size_t step = 0; step < 30; ++step) {
+    state = move(pot, state, {pick(gen), pick(gen)}, gen, 0.03, types, box);
+  }
+  REQUIRE(Registry::forceCalls == calls);
+  require_same(state, evaluate(reference, state.pos, types, box), 1e-10);
+
+  // Isolated clusters visit every atom, no neighbor list involved
+  rgpot::PairPotential<rgpot::pair::LennardJones,
+                       rgpot::truncation::ShiftedEnergy,
+                       rgpot::periodicity::None>
+      cluster(rgpot::pair::LennardJones{}, 2.5);
+  state = evaluate(cluster, pos, types, box);
+  for (size_t step = 0; step < 30; ++step) {
+    state = move(cluster, state, {pick(gen)}, gen, 0.2, types, box);
+  }
+  require_same(state, evaluate(cluster, state.pos, types, box), 1e-10);
+}
@@ -0,0 +1,101 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "rgpot/LennardJones/LJDevice.hpp"
+#include "rgpot/LennardJones/LJPot.hpp"
+
+using namespace Catch::Matchers;
+
+namespace {
+
+// Jittered simple cubic lattice filling a cube of side per_side * spacing
+std::vector<double> lattice_positions(size_t per_side, double spacing,
+                                      double jitter, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> dis(-jitter, jitter);
+  std::vector<double> pos;
+  for (size_t a = 0; a < per_side; ++a) {
+    for (size_t b = 0; b < per_side; ++b) {
+      for (size_t c = 0; c < per_side; ++c) {
+        pos.push_back(spacing * (a + 0.5) + dis(gen));
+        pos.push_back(spacing * (b + 0.5) + dis(gen));
+        pos.push_back(spacing * (c + 0.5) + dis(gen));
+      }
+    }
+  }
+  return pos;
+}
+
+// The work of every GPU thread, run on the host
+double all_pairs(const std::vector<double> &pos, const double *box,
+                 std::vector<double> &forces) {
+  const size_t n = pos.size() / 3;
+  const auto cell = rgpot::make_device_cell(box);
+  const auto params = rgpot::shifted_lj_params(1.0, 1.0, 15.0);
+  forces.assign(pos.size(), 0.0);
+  double energy = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    energy += rgpot::lj_atom_all_pairs(i, n, pos.data(), params, cell,
+                                       forces.data() + 3 * i);
+  }
+  return 0.5 * energy;
+}
+
+void require_matches_ljpot(const std::vector<double> &pos, const double *box) {
+  std::vector<int> types(pos.size() / 3, 1);
+  std::vector<double> f_ref(pos.size());
+  rgpot::LJPot reference;
+  rgpot::ForceOut fo{.F = f_ref.data(), .energy = 0.0, .variance = 0.0};
+  reference.compute_into(
+      {.nAtoms = types.size(), .pos = pos.data(), .atmnrs = types.data(),
+       .box = box},
+      fo);
+
+  std::vector<double> forces;
+  const double energy = all_pairs(pos, box, forces);
+  REQUIRE_THAT(energy, WithinRel(fo.energy, 1e-10));
+  for (size_t k = 0; k < forces.size(); ++k) {
+    REQUIRE_THAT(forces[k], WithinAbs(f_ref[k], 1e-9));
+  }
+}
+
+} // namespace
+
+TEST_CASE("Device cell agrees with PeriodicCell", "[LJDevice]") {
+  const double cube[9] = {31, 0, 0, 0, 32, 0, 0, 0, 33};
+  const double skewed[9] = {31, 0, 0, 6, 32, 0, -4, 5, 33};
+  for (const double *box : {cube, skewed}) {
+    const rgpot::PeriodicCell cell(box);
+    const auto device = rgpot::make_device_cell(box);
+    REQUIRE(device.orthogonal == cell.orthogonal());
+    for (size_t k = 0; k < 9; ++k) {
+      REQUIRE_THAT(device.inv[k], WithinAbs(cell.inverse()[k], 1e-15));
+    }
+  }
+}
+
+TEST_CASE("Device pair terms match LJPot", "[LJDevice][LJPot]") {
+  const size_t per_side = 6;
+  const double spacing = 5.5;
+  const double len = per_side * spacing;
+  const auto pos = lattice_positions(per_side, spacing, 1.5, 13);
+
+  SECTION("Orthogonal cell") {
+    const double box[9] = {len, 0, 0, 0, len, 0, 0, 0, len};
+    require_matches_ljpot(pos, box);
+  }
+
+  SECTION("Skewed cell") {
+    // Widths stay above twice the cutoff
+    const double box[9] = {len, 0, 0, 2.0, len, 0, 0, 1.5, len};
+    const rgpot::PeriodicCell cell(box);
+    for (size_t d = 0; d < 3; ++d) {
+      REQUIRE(cell.perpendicular_width(d) > 30.0);
+    }
+    require_matches_ljpot(pos, box);
+  }
+}
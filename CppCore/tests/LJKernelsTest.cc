@@ -0,0 +1,111 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "rgpot/LennardJones/LJKernels.hpp"
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/NeighborList.hpp"
+
+using namespace Catch::Matchers;
+
+namespace {
+
+std::vector<double> random_positions(size_t n_atoms, double len,
+                                     unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> dis(0.0, len);
+  std::vector<double> pos(3 * n_atoms);
+  for (auto &p : pos) {
+    p = dis(gen);
+  }
+  return pos;
+}
+
+std::vector<rgpot::SimdLevel> supported_levels() {
+  std::vector<rgpot::SimdLevel> levels;
+  for (auto level : {rgpot::SimdLevel::AVX2, rgpot::SimdLevel::AVX512}) {
+    if (rgpot::simd_level_supported(level)) {
+      levels.push_back(level);
+    }
+  }
+  return levels;
+}
+
+} // namespace
+
+TEST_CASE("Vectorized LJ kernels match the scalar kernel", "[LJKernels]") {
+  const size_t n_atoms = 240;
+  double box[9] = {30, 0, 0, 0, 32, 0, 0, 0, 34};
+  auto pos = random_positions(n_atoms, 30.0, 31337);
+  rgpot::ForceInput fi{
+      .nAtoms = n_atoms, .pos = pos.data(), .atmnrs = nullptr, .box = box};
+  rgpot::NeighborList nlist(9.0, 0.5);
+  nlist.update(fi);
+
+  std::vector<double> soa(3 * n_atoms);
+  for (size_t i = 0; i < n_atoms; ++i) {
+    for (size_t d = 0; d < 3; ++d) {
+      soa[d * n_atoms + i] = pos[3 * i + d];
+    }
+  }
+  const rgpot::PeriodicCell cell(box);
+  const rgpot::LJPairData data{soa.data(),
+                               soa.data() + n_atoms,
+                               soa.data() + 2 * n_atoms,
+                               nlist.offsets().data(),
+                               nlist.neighbors().data(),
+                               &cell};
+  const rgpot::LJParams params{0.8, 1.3, 9.0, 1e-4};
+
+  std::vector<double> f_ref(3 * n_atoms, 0.0);
+  const double e_ref = rgpot::lj_pair_range(rgpot::SimdLevel::Scalar, data,
+                                            params, 0, n_atoms, f_ref.data());
+  REQUIRE(std::isfinite(e_ref));
+
+  for (auto level : supported_levels()) {
+    std::vector<double> forces(3 * n_atoms, 0.0);
+    const double energy =
+        rgpot::lj_pair_range(level, data, params, 0, n_atoms, forces.data());
+    REQUIRE_THAT(energy, WithinRel(e_ref, 1e-12));
+    for (size_t i = 0; i < 3 * n_atoms; ++i) {
+      REQUIRE_THAT(forces[i],
+                   WithinAbs(f_ref[i], 1e-10 * (1.0 + std::abs(f_ref[i]))));
+    }
+  }
+}
+
+TEST_CASE("LJPot SIMD levels match the eOn loop", "[LJKernels][LJPot]") {
+  const size_t n_atoms = 300;
+  std::array<std::array<double, 3>, 3> box = {
+      {{50, 0, 0}, {0, 50, 0}, {0, 0, 50}}};
+  auto pos = random_positions(n_atoms, 50.0, 8);
+  rgpot::types::AtomMatrix positions(n_atoms, 3);
+  std::copy(pos.begin(), pos.end(), positions.data());
+  std::vector<int> types(n_atoms, 1);
+
+  auto scalar = rgpot::LJPot();
+  scalar.set_simd_level(rgpot::SimdLevel::Scalar);
+  auto [e_ref, f_ref] = scalar(positions, types, box);
+
+  for (auto level : supported_levels()) {
+    auto pot = rgpot::LJPot();
+    pot.set_simd_level(level);
+    REQUIRE(pot.simd_level() == level);
+    auto [energy, forces] = pot(positions, types, box);
+    REQUIRE_THAT(energy, WithinRel(e_ref, 1e-10));
+    for (size_t i = 0; i < n_atoms * 3; ++i) {
+      REQUIRE_THAT(forces.data()[i], WithinAbs(f_ref.data()[i], 1e-9));
+    }
+
+    // Vectorized ranges also compose with the threaded reduction
+    pot.set_num_threads(3, true);
+    auto [energy_mt, forces_mt] = pot(positions, types, box);
+    REQUIRE_THAT(energy_mt, WithinRel(e_ref, 1e-10));
+    for (size_t i = 0; i < n_atoms * 3; ++i) {
+      REQUIRE_THAT(forces_mt.data()[i], WithinAbs(f_ref.data()[i], 1e-9));
+    }
+  }
+}
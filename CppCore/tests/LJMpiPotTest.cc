@@ -0,0 +1,159 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <algorithm>
+#include <array>
+#include <catch2/catch_all.hpp>
+#include <mpi.h>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "rgpot/LennardJones/LJMpiPot.hpp"
+#include "rgpot/LennardJones/LJPot.hpp"
+
+using namespace Catch::Matchers;
+
+namespace {
+
+// Brackets the whole run, Catch2WithMain provides main
+class MpiSession : public Catch::EventListenerBase {
+public:
+  using Catch::EventListenerBase::EventListenerBase;
+  void testRunStarting(const Catch::TestRunInfo &) override {
+    MPI_Init(nullptr, nullptr);
+  }
+  void testRunEnded(const Catch::TestRunStats &) override { MPI_Finalize(); }
+};
+
+// Jittered simple cubic lattice filling a cube of side per_side * spacing
+std::vector<double> lattice_positions(size_t per_side, double spacing,
+                                      double jitter, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> dis(-jitter, jitter);
+  std::vector<double> pos;
+  for (size_t a = 0; a < per_side; ++a) {
+    for (size_t b = 0; b < per_side; ++b) {
+      for (size_t c = 0; c < per_side; ++c) {
+        pos.push_back(spacing * (a + 0.5) + dis(gen));
+        pos.push_back(spacing * (b + 0.5) + dis(gen));
+        pos.push_back(spacing * (c + 0.5) + dis(gen));
+      }
+    }
+  }
+  return pos;
+}
+
+void require_matches_ljpot(const std::vector<double> &pos, const double *box) {
+  const size_t n = pos.size() / 3;
+  std::vector<int> types(n, 1);
+  const rgpot::ForceInput fi{.nAtoms = n,
+                             .pos = pos.data(),
+                             .atmnrs = types.data(),
+                             .box = box};
+
+  std::vector<double> f_ref(pos.size());
+  rgpot::LJPot reference;
+  rgpot::ForceOut ref{.F = f_ref.data(), .energy = 0.0, .variance = 0.0};
+  reference.compute_into(fi, ref);
+
+  // Only rank 0 holds the configuration, the others pass garbage
+  std::vector<double> mine = pos;
+  rgpot::LJMpiPot pot;
+  if (pot.rank() != 0) {
+    std::fill(mine.begin(), mine.end(), -1.0);
+  }
+  std::vector<double> forces(pos.size());
+  rgpot::ForceOut fo{.F = forces.data(), .energy = 0.0, .variance = 0.0};
+  pot.compute_into({.nAtoms = n,
+                    .pos = mine.data(),
+                    .atmnrs = types.data(),
+                    .box = box},
+                   fo);
+
+  const auto grid = pot.grid();
+  REQUIRE(grid[0] * grid[1] * grid[2] <= pot.size());
+  if (pot.size() > 1) {
+    REQUIRE(grid[0] * grid[1] * grid[2] > 1);
+  }
+  REQUIRE_THAT(fo.energy, WithinRel(ref.energy, 1e-10));
+  for (size_t k = 0; k < forces.size(); ++k) {
+    REQUIRE_THAT(forces[k], WithinAbs(f_ref[k], 1e-9));
+  }
+}
+
+} // namespace
+
+CATCH_REGISTER_LISTENER(MpiSession)
+
+TEST_CASE("LJMpiPot picks grids of domains one cutoff wide", "[LJMpiPot]") {
+  const double cube[9] = {64, 0, 0, 0, 64, 0, 0, 0, 64};
+  const rgpot::PeriodicCell cell(cube);
+  const auto four = rgpot::LJMpiPot::process_grid(4, cell, 15.0);
+  REQUIRE(four[0] * four[1] * four[2] == 4);
+  REQUIRE(four[0] <= 2);
+
+  // Seven ranks do not split a cube, one of them stays idle
+  const auto seven = rgpot::LJMpiPot::process_grid(7, cell, 15.0);
+  REQUIRE(seven[0] * seven[1] * seven[2] == 6);
+
+  // Two domains of 20 along each vector at most
+  const double small[9] = {40, 0, 0, 0, 40, 0, 0, 0, 40};
+  const auto capped =
+      rgpot::LJMpiPot::process_grid(64, rgpot::PeriodicCell(small), 15.0);
+  REQUIRE(capped == std::array<int, 3>{2, 2, 2});
+
+  // The long vector of a slab takes the domains
+  const double slab[9] = {200, 0, 0, 0, 31, 0, 0, 0, 31};
+  const auto slabbed =
+      rgpot::LJMpiPot::process_grid(8, rgpot::PeriodicCell(slab), 15.0);
+  REQUIRE(slabbed == std::array<int, 3>{8, 1, 1});
+}
+
+TEST_CASE("LJMpiPot matches LJPot across the ranks",
+          "[LJMpiPot][LJPot]") {
+  const size_t per_side = 12;
+  const double spacing = 5.5;
+  const double len = per_side * spacing;
+  const auto pos = lattice_positions(per_side, spacing, 1.5, 29);
+
+  SECTION("Orthogonal cell") {
+    const double box[9] = {len, 0, 0, 0, len, 0, 0, 0, len};
+    require_matches_ljpot(pos, box);
+  }
+
+  SECTION("Skewed cell") {
+    const double box[9] = {len, 0, 0, 6.0, len, 0, -4.0, 5.0, len};
+    require_matches_ljpot(pos, box);
+  }
+
+  SECTION("Atoms outside the cell") {
+    std::vector<double> shifted = pos;
+    for (size_t k = 0; k < shifted.size(); k += 7) {
+      shifted[k] += (k % 2 ? 3.0 : -2.0) * len;
+    }
+    const double box[9] = {len, 0, 0, 0, len, 0, 0, 0, len};
+    require_matches_ljpot(shifted, box);
+  }
+}
+
+TEST_CASE("LJMpiPot rejects ranks disagreeing on the atom count",
+          "[LJMpiPot]") {
+  rgpot::LJMpiPot pot;
+  const double box[9] = {40, 0, 0, 0, 40, 0, 0, 0, 40};
+  const size_t n = pot.rank() == 0 || pot.size() == 1 ? 2 : 3;
+  std::vector<double> pos(3 * n, 0.0);
+  pos[3] = 2.0;
+  std::vector<int> types(n, 1);
+  std::vector<double> forces(3 * n);
+  rgpot::ForceOut fo{.F = forces.data(), .energy = 0.0, .variance = 0.0};
+  const rgpot::ForceInput fi{.nAtoms = n,
+                             .pos = pos.data(),
+                             .atmnrs = types.data(),
+                             .box = box};
+  if (pot.size() == 1) {
+    pot.compute_into(fi, fo);
+    REQUIRE(forces[0] == -forces[3]);
+  } else {
+    REQUIRE_THROWS_AS(pot.compute_into(fi, fo), std::invalid_argument);
+  }
+}
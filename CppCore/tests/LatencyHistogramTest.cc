@@ -0,0 +1,86 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <cstdint>
+#include <limits>
+
+#include "rgpot/LatencyHistogram.hpp"
+
+using Catch::Matchers::WithinRel;
+using rgpot::LatencyHistogram;
+
+TEST_CASE("Buckets cover the full range", "[LatencyHistogram]") {
+  REQUIRE(LatencyHistogram::index_of(0) == 0);
+  REQUIRE(LatencyHistogram::index_of(255) == 255);
+  REQUIRE(LatencyHistogram::index_of(256) == 256);
+  REQUIRE(LatencyHistogram::index_of(std::numeric_limits<uint64_t>::max()) ==
+          LatencyHistogram::num_counts - 1);
+  REQUIRE(LatencyHistogram::highest_equivalent(LatencyHistogram::num_counts -
+                                               1) ==
+          std::numeric_limits<uint64_t>::max());
+
+  // Every value lies inside its bucket, within the documented error
+  for (uint64_t v : {1ull, 300ull, 4095ull, 123456789ull, 1ull << 40}) {
+    const auto hi =
+        LatencyHistogram::highest_equivalent(LatencyHistogram::index_of(v));
+    REQUIRE(hi >= v);
+    REQUIRE(static_cast<double>(hi - v) <= v / 128.0);
+  }
+}
+
+TEST_CASE("Percentiles of a uniform distribution", "[LatencyHistogram]") {
+  LatencyHistogram h;
+  for (uint64_t v = 1; v <= 10000; ++v) {
+    h.record(v * 1000);
+  }
+  REQUIRE(h.count() == 10000);
+  REQUIRE(h.min() == 1000);
+  REQUIRE(h.max() == 10000000);
+  REQUIRE_THAT(h.mean(), WithinRel(5000500.0, 1e-12));
+  REQUIRE_THAT(static_cast<double>(h.value_at_percentile(50.0)),
+               WithinRel(5000000.0, 0.01));
+  REQUIRE_THAT(static_cast<double>(h.value_at_percentile(99.0)),
+               WithinRel(9900000.0, 0.01));
+  REQUIRE_THAT(static_cast<double>(h.value_at_percentile(99.9)),
+               WithinRel(9990000.0, 0.01));
+  REQUIRE(h.value_at_percentile(100.0) == h.max());
+  REQUIRE(h.value_at_percentile(0.0) == h.min());
+
+  h.reset();
+  REQUIRE(h.count() == 0);
+  REQUIRE(h.value_at_percentile(50.0) == 0);
+}
+
+TEST_CASE("Merging adds counts", "[LatencyHistogram]") {
+  LatencyHistogram a;
+  LatencyHistogram b;
+  a.record(10, 3);
+  b.record(1000000);
+  a.merge(b);
+  REQUIRE(a.count() == 4);
+  REQUIRE(a.min() == 10);
+  REQUIRE(a.max() == 1000000);
+  REQUIRE(a.value_at_percentile(75.0) == 10);
+  REQUIRE(a.value_at_percentile(100.0) == 1000000);
+}
+
+TEST_CASE("Coordinated omission is corrected", "[LatencyHistogram]") {
+  // A closed loop sampling every 1 ms that stalls for 100 ms once
+  LatencyHistogram raw;
+  LatencyHistogram corrected;
+  const uint64_t interval = 1000000;
+  for (int i = 0; i < 99; ++i) {
+    raw.record(interval);
+    corrected.record_corrected(interval, interval);
+  }
+  raw.record(100 * interval);
+  corrected.record_corrected(100 * interval, interval);
+
+  REQUIRE(raw.count() == 100);
+  REQUIRE_THAT(static_cast<double>(raw.value_at_percentile(90.0)),
+               WithinRel(static_cast<double>(interval), 0.01));
+  // The stall hides 99 requests that would have waited 99 ms down to 1 ms
+  REQUIRE(corrected.count() == 199);
+  REQUIRE(corrected.value_at_percentile(90.0) >= 79 * interval);
+  REQUIRE(corrected.max() == 100 * interval);
+}
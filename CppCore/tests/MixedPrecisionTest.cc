@@ -0,0 +1,250 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "rgpot/LennardJones/LJPot.hpp"
+
+using namespace Catch::Matchers;
+
+namespace {
+
+using Box = std::array<std::array<double, 3>, 3>;
+
+// Relative error factor documented for lj_pair_range_mixed
+double mixed_bound(double len, double r_min) {
+  return (70.0 * len / r_min + 10.0) * std::ldexp(1.0, -24);
+}
+
+// Sums of the absolute pair energies and per-atom force magnitudes, which
+// scale the documented error bound
+struct AbsPairSums {
+  double energy = 0;
+  std::vector<double> force;
+};
+
+AbsPairSums abs_pair_sums(const rgpot::types::AtomMatrix &pos, double len,
+                          double rc) {
+  AbsPairSums sums;
+  sums.force.assign(pos.rows(), 0.0);
+  for (size_t i = 0; i < pos.rows(); ++i) {
+    for (size_t j = i + 1; j < pos.rows(); ++j) {
+      double r2 = 0;
+      for (size_t d = 0; d < 3; ++d) {
+        double dd = pos(i, d) - pos(j, d);
+        dd -= len * std::floor(dd / len + 0.5);
+        r2 += dd * dd;
+      }
+      if (r2 >= rc * rc) {
+        continue;
+      }
+      const double s6 = 1.0 / (r2 * r2 * r2);
+      sums.energy += std::abs(4.0 * s6 * (s6 - 1.0));
+      const double f = std::abs(24.0 * s6 * (2.0 * s6 - 1.0)) / std::sqrt(r2);
+      sums.force[i] += f;
+      sums.force[j] += f;
+    }
+  }
+  return sums;
+}
+
+rgpot::types::AtomMatrix random_cluster(size_t n_atoms, const double *center,
+                                        double radius, double min_dist,
+                                        unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> dis(-radius, radius);
+  rgpot::types::AtomMatrix pos(n_atoms, 3);
+  size_t placed = 0;
+  while (placed < n_atoms) {
+    double p[3]{dis(gen), dis(gen), dis(gen)};
+    if (p[0] * p[0] + p[1] * p[1] + p[2] * p[2] > radius * radius) {
+      continue;
+    }
+    bool ok = true;
+    for (size_t j = 0; j < placed && ok; ++j) {
+      double r2 = 0;
+      for (size_t d = 0; d < 3; ++d) {
+        const double dd = center[d] + p[d] - pos(j, d);
+        r2 += dd * dd;
+      }
+      ok = r2 > min_dist * min_dist;
+    }
+    if (ok) {
+      for (size_t d = 0; d < 3; ++d) {
+        pos(placed, d) = center[d] + p[d];
+      }
+      ++placed;
+    }
+  }
+  return pos;
+}
+
+// Rotation about the z axis through a point
+void rotate_z(rgpot::types::AtomMatrix &pos, const double *origin,
+              double angle_rad) {
+  const double c = std::cos(angle_rad);
+  const double s = std::sin(angle_rad);
+  for (size_t i = 0; i < pos.rows(); ++i) {
+    const double x = pos(i, 0) - origin[0];
+    const double y = pos(i, 1) - origin[1];
+    pos(i, 0) = origin[0] + x * c - y * s;
+    pos(i, 1) = origin[1] + x * s + y * c;
+  }
+}
+
+std::vector<rgpot::SimdLevel> supported_levels() {
+  std::vector<rgpot::SimdLevel> levels;
+  for (auto level : {rgpot::SimdLevel::Scalar, rgpot::SimdLevel::AVX2,
+                     rgpot::SimdLevel::AVX512}) {
+    if (rgpot::simd_level_supported(level)) {
+      levels.push_back(level);
+    }
+  }
+  return levels;
+}
+
+} // namespace
+
+TEST_CASE("Mixed precision stays within its error bound",
+          "[MixedPrecision][LJPot]") {
+  const double len = 30.0;
+  const double r_min = 0.9;
+  const Box box{{{len, 0, 0}, {0, len, 0}, {0, 0, len}}};
+  const double center[3]{len / 2, len / 2, len / 2};
+  // A sample filling most of the cell, shifted so some atoms sit outside the
+  // cell and have to be wrapped
+  auto positions = random_cluster(250, center, 14.9, r_min, 4);
+  for (size_t i = 0; i < positions.rows(); ++i) {
+    positions(i, 0) += 0.4 * len;
+  }
+  std::vector<int> types(positions.rows(), 1);
+  const auto sums = abs_pair_sums(positions, len, 15.0);
+  const double eps = mixed_bound(len, r_min);
+
+  rgpot::LJPot reference;
+  reference.set_simd_level(rgpot::SimdLevel::Scalar);
+  auto [e_ref, f_ref] = reference(positions, types, box);
+
+  for (auto level : supported_levels()) {
+    rgpot::LJPot pot;
+    pot.set_num_threads(1);
+    pot.set_simd_level(level);
+    pot.set_precision(rgpot::Precision::Mixed);
+    REQUIRE(pot.precision() == rgpot::Precision::Mixed);
+    auto [energy, forces] = pot(positions, types, box);
+    REQUIRE(energy != e_ref); // Actually ran in single precision
+    REQUIRE_THAT(energy, WithinAbs(e_ref, eps * sums.energy));
+    for (size_t i = 0; i < forces.rows(); ++i) {
+      for (size_t d = 0; d < 3; ++d) {
+        REQUIRE_THAT(forces(i, d), WithinAbs(f_ref(i, d), eps * sums.force[i]));
+      }
+    }
+
+    // Sums stay in double, so the threaded reduction agrees to round-off
+    pot.set_num_threads(3, true);
+    auto [energy_mt, forces_mt] = pot(positions, types, box);
+    REQUIRE_THAT(energy_mt, WithinRel(energy, 1e-12));
+    for (size_t i = 0; i < forces.rows(); ++i) {
+      for (size_t d = 0; d < 3; ++d) {
+        REQUIRE_THAT(forces_mt(i, d), WithinAbs(forces(i, d), 1e-10));
+      }
+    }
+  }
+}
+
+TEST_CASE("Mixed precision on a skewed cell", "[MixedPrecision][LJPot]") {
+  // Same lattice as the cube, see PeriodicCellTest
+  const double len = 60.0;
+  const Box cube{{{len, 0, 0}, {0, len, 0}, {0, 0, len}}};
+  const Box skewed{{{len, 0, 0}, {len, len, 0}, {0, -len, len}}};
+  const double center[3]{len / 2, len / 2, len / 2};
+  auto positions = random_cluster(120, center, 29.0, 1.0, 9);
+  std::vector<int> types(positions.rows(), 1);
+  const auto sums = abs_pair_sums(positions, len, 15.0);
+  // Wrapped skewed positions reach the far corner of the cell
+  const double eps = mixed_bound(3.0 * len, 1.0);
+
+  rgpot::LJPot reference;
+  auto [e_ref, f_ref] = reference(positions, types, cube);
+  rgpot::LJPot pot;
+  pot.set_precision(rgpot::Precision::Mixed);
+  auto [energy, forces] = pot(positions, types, skewed);
+  REQUIRE_THAT(energy, WithinAbs(e_ref, eps * sums.energy));
+  for (size_t i = 0; i < forces.rows(); ++i) {
+    for (size_t d = 0; d < 3; ++d) {
+      REQUIRE_THAT(forces(i, d), WithinAbs(f_ref(i, d), eps * sums.force[i]));
+    }
+  }
+}
+
+TEST_CASE("Mixed precision keeps translation and rotation invariance",
+          "[MixedPrecision][Invariance]") {
+  // A cluster far from its periodic images, so rotations are symmetries
+  const double len = 40.0;
+  const double r_min = 0.95;
+  const Box box{{{len, 0, 0}, {0, len, 0}, {0, 0, len}}};
+  const double center[3]{len / 2, len / 2, len / 2};
+  auto pos = random_cluster(80, center, 5.0, r_min, 17);
+  std::vector<int> types(pos.rows(), 1);
+  const auto sums = abs_pair_sums(pos, len, 15.0);
+  // Both sides of each comparison carry the single precision error
+  const double eps = 2.0 * mixed_bound(len, r_min);
+
+  auto pot = rgpot::LJPot();
+  pot.set_precision(rgpot::Precision::Mixed);
+
+  // --- Baseline ---
+  auto [e_base, f_base] = pot(pos, types, box);
+
+  SECTION("Global Translation") {
+    for (size_t i = 0; i < pos.rows(); ++i) {
+      pos(i, 0) += 5.0;
+      pos(i, 1) += 5.0;
+      pos(i, 2) += 5.0;
+    }
+    auto [e_trans, f_trans] = pot(pos, types, box);
+    REQUIRE_THAT(e_trans, WithinAbs(e_base, eps * sums.energy));
+    for (size_t i = 0; i < pos.rows(); ++i) {
+      for (size_t d = 0; d < 3; ++d) {
+        REQUIRE_THAT(f_trans(i, d),
+                     WithinAbs(f_base(i, d), eps * sums.force[i]));
+      }
+    }
+  }
+
+  SECTION("Translation Across The Cell Boundary") {
+    // Part of the cluster leaves the cell and is wrapped back in
+    for (size_t i = 0; i < pos.rows(); ++i) {
+      pos(i, 0) += 0.5 * len;
+      pos(i, 1) -= 1.5 * len;
+    }
+    auto [e_trans, f_trans] = pot(pos, types, box);
+    REQUIRE_THAT(e_trans, WithinAbs(e_base, eps * sums.energy));
+    for (size_t i = 0; i < pos.rows(); ++i) {
+      for (size_t d = 0; d < 3; ++d) {
+        REQUIRE_THAT(f_trans(i, d),
+                     WithinAbs(f_base(i, d), eps * sums.force[i]));
+      }
+    }
+  }
+
+  SECTION("Global Rotation") {
+    const double angle = 0.7;
+    rotate_z(pos, center, angle);
+    auto [e_rot, f_rot] = pot(pos, types, box);
+    REQUIRE_THAT(e_rot, WithinAbs(e_base, eps * sums.energy));
+
+    // Forces rotate with the configuration
+    const double c = std::cos(angle);
+    const double s = std::sin(angle);
+    for (size_t i = 0; i < pos.rows(); ++i) {
+      const double fx = f_base(i, 0) * c - f_base(i, 1) * s;
+      const double fy = f_base(i, 0) * s + f_base(i, 1) * c;
+      REQUIRE_THAT(f_rot(i, 0), WithinAbs(fx, eps * sums.force[i]));
+      REQUIRE_THAT(f_rot(i, 1), WithinAbs(fy, eps * sums.force[i]));
+      REQUIRE_THAT(f_rot(i, 2), WithinAbs(f_base(i, 2), eps * sums.force[i]));
+    }
+  }
+}
@@ -0,0 +1,220 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/NeighborList.hpp"
+
+using namespace Catch::Matchers;
+
+namespace {
+
+std::vector<double> random_positions(size_t n_atoms, double len,
+                                     unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> dis(0.0, len);
+  std::vector<double> pos(3 * n_atoms);
+  for (auto &p : pos) {
+    p = dis(gen);
+  }
+  return pos;
+}
+
+double min_image(double d, double len) {
+  return d - len * std::floor(d / len + 0.5);
+}
+
+// Every i < j pair within rcut under the minimum image convention
+std::set<std::pair<size_t, size_t>>
+brute_force_pairs(const std::vector<double> &pos, const double *box,
+                  double rcut) {
+  std::set<std::pair<size_t, size_t>> pairs;
+  const size_t n = pos.size() / 3;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = i + 1; j < n; ++j) {
+      double r2 = 0;
+      for (size_t d = 0; d < 3; ++d) {
+        double dd = min_image(pos[3 * i + d] - pos[3 * j + d], box[4 * d]);
+        r2 += dd * dd;
+      }
+      if (r2 < rcut * rcut) {
+        pairs.insert({i, j});
+      }
+    }
+  }
+  return pairs;
+}
+
+// Every i < j pair within rcut, searching the neighboring lattice images
+std::set<std::pair<size_t, size_t>>
+brute_force_pairs_skewed(const std::vector<double> &pos, const double *box,
+                         double rcut) {
+  std::set<std::pair<size_t, size_t>> pairs;
+  const size_t n = pos.size() / 3;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = i + 1; j < n; ++j) {
+      double best = std::numeric_limits<double>::max();
+      for (int n0 = -2; n0 <= 2; ++n0) {
+        for (int n1 = -2; n1 <= 2; ++n1) {
+          for (int n2 = -2; n2 <= 2; ++n2) {
+            double r2 = 0;
+            for (size_t k = 0; k < 3; ++k) {
+              const double v = pos[3 * i + k] - pos[3 * j + k] +
+                               n0 * box[k] + n1 * box[3 + k] +
+                               n2 * box[6 + k];
+              r2 += v * v;
+            }
+            best = std::min(best, r2);
+          }
+        }
+      }
+      if (best < rcut * rcut) {
+        pairs.insert({i, j});
+      }
+    }
+  }
+  return pairs;
+}
+
+std::set<std::pair<size_t, size_t>>
+list_pairs(const rgpot::NeighborList &nlist) {
+  std::set<std::pair<size_t, size_t>> pairs;
+  for (size_t i = 0; i < nlist.num_atoms(); ++i) {
+    for (size_t k = nlist.offsets()[i]; k < nlist.offsets()[i + 1]; ++k) {
+      pairs.insert({i, nlist.neighbors()[k]});
+    }
+  }
+  return pairs;
+}
+
+// Forces from the original O(N^2) Lennard-Jones double loop
+std::vector<double> reference_lj_forces(const std::vector<double> &pos,
+                                        const double *box) {
+  const double u0 = 1.0, psi = 1.0, rcut = 15.0;
+  const size_t n = pos.size() / 3;
+  std::vector<double> F(3 * n, 0.0);
+  for (size_t i = 0; i + 1 < n; ++i) {
+    for (size_t j = i + 1; j < n; ++j) {
+      double d[3];
+      for (size_t k = 0; k < 3; ++k) {
+        d[k] = min_image(pos[3 * i + k] - pos[3 * j + k], box[4 * k]);
+      }
+      double r = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+      if (r < rcut) {
+        double a = std::pow(psi / r, 6);
+        double b = 4 * u0 * a;
+        double dU = -6 * b / r * (2 * a - 1);
+        for (size_t k = 0; k < 3; ++k) {
+          F[3 * i + k] -= dU * d[k] / r;
+          F[3 * j + k] += dU * d[k] / r;
+        }
+      }
+    }
+  }
+  return F;
+}
+
+} // namespace
+
+TEST_CASE("NeighborList matches a brute force pair search", "[NeighborList]") {
+  const size_t n_atoms = 400;
+
+  SECTION("Linked cells in a large box") {
+    double box[9] = {20, 0, 0, 0, 22, 0, 0, 0, 24};
+    auto pos = random_positions(n_atoms, 20.0, 1234);
+    // Push some atoms outside the primary cell
+    pos[0] -= 20.0;
+    pos[4] += 44.0;
+    rgpot::ForceInput fi{
+        .nAtoms = n_atoms, .pos = pos.data(), .atmnrs = nullptr, .box = box};
+    rgpot::NeighborList nlist(3.0, 0.5);
+    REQUIRE(nlist.update(fi));
+    REQUIRE(list_pairs(nlist) == brute_force_pairs(pos, box, 3.5));
+  }
+
+  SECTION("All-pairs fallback in a small box") {
+    double box[9] = {8, 0, 0, 0, 8, 0, 0, 0, 8};
+    auto pos = random_positions(n_atoms, 8.0, 4321);
+    rgpot::ForceInput fi{
+        .nAtoms = n_atoms, .pos = pos.data(), .atmnrs = nullptr, .box = box};
+    rgpot::NeighborList nlist(3.0, 0.0);
+    REQUIRE(nlist.update(fi));
+    REQUIRE(list_pairs(nlist) == brute_force_pairs(pos, box, 3.0));
+  }
+
+  SECTION("Linked cells in a skewed box") {
+    double box[9] = {20, 0, 0, 4, 20, 0, -3, 5, 20};
+    auto pos = random_positions(n_atoms, 20.0, 5678);
+    rgpot::ForceInput fi{
+        .nAtoms = n_atoms, .pos = pos.data(), .atmnrs = nullptr, .box = box};
+    rgpot::NeighborList nlist(3.0, 0.5);
+    REQUIRE(nlist.update(fi));
+    REQUIRE(list_pairs(nlist) == brute_force_pairs_skewed(pos, box, 3.5));
+  }
+}
+
+TEST_CASE("NeighborList Verlet skin reuse", "[NeighborList]") {
+  const size_t n_atoms = 200;
+  double box[9] = {20, 0, 0, 0, 20, 0, 0, 0, 20};
+  auto pos = random_positions(n_atoms, 20.0, 99);
+  rgpot::ForceInput fi{
+      .nAtoms = n_atoms, .pos = pos.data(), .atmnrs = nullptr, .box = box};
+  rgpot::NeighborList nlist(3.0, 1.0);
+
+  REQUIRE(nlist.update(fi));
+  REQUIRE_FALSE(nlist.update(fi));
+
+  // Below half the skin: reuse
+  pos[0] += 0.4;
+  REQUIRE_FALSE(nlist.update(fi));
+  REQUIRE(nlist.rebuilds() == 1);
+
+  // Beyond half the skin: rebuild
+  pos[3] += 0.6;
+  REQUIRE(nlist.update(fi));
+  REQUIRE(nlist.rebuilds() == 2);
+
+  // Box changes always rebuild
+  box[0] = 21.0;
+  REQUIRE(nlist.update(fi));
+
+  REQUIRE_THROWS_AS(nlist.set_skin(-1.0), std::invalid_argument);
+}
+
+TEST_CASE("LJPot with neighbor lists matches the full pair loop", "[LJPot]") {
+  const size_t n_atoms = 300;
+  // 50 / (15 + skin) keeps three cells per direction
+  std::array<std::array<double, 3>, 3> box = {
+      {{50, 0, 0}, {0, 50, 0}, {0, 0, 50}}};
+  double flat_box[9] = {50, 0, 0, 0, 50, 0, 0, 0, 50};
+  auto pos = random_positions(n_atoms, 50.0, 2024);
+
+  rgpot::types::AtomMatrix positions(n_atoms, 3);
+  std::copy(pos.begin(), pos.end(), positions.data());
+  std::vector<int> types(n_atoms, 1);
+
+  auto pot = rgpot::LJPot();
+  auto [energy, forces] = pot(positions, types, box);
+  auto expected = reference_lj_forces(pos, flat_box);
+  REQUIRE(std::isfinite(energy));
+  for (size_t i = 0; i < n_atoms * 3; ++i) {
+    REQUIRE_THAT(forces.data()[i], WithinAbs(expected[i], 1e-9));
+  }
+
+  // A small move reuses the list and still matches the reference
+  positions(0, 0) += 0.05;
+  pos[0] += 0.05;
+  auto [energy2, forces2] = pot(positions, types, box);
+  REQUIRE(pot.neighbor_list().rebuilds() == 1);
+  expected = reference_lj_forces(pos, flat_box);
+  for (size_t i = 0; i < n_atoms * 3; ++i) {
+    REQUIRE_THAT(forces2.data()[i], WithinAbs(expected[i], 1e-9));
+  }
+}
@@ -0,0 +1,237 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/PairFunctionals.hpp"
+#include "rgpot/ThreadPool.hpp"
+
+using namespace Catch::Matchers;
+
+namespace {
+
+using Box = std::array<std::array<double, 3>, 3>;
+
+rgpot::types::AtomMatrix random_positions(size_t n_atoms, double len,
+                                          double min_dist, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> dis(0.0, len);
+  rgpot::types::AtomMatrix pos(n_atoms, 3);
+  size_t placed = 0;
+  while (placed < n_atoms) {
+    double p[3]{dis(gen), dis(gen), dis(gen)};
+    bool ok = true;
+    for (size_t j = 0; j < placed && ok; ++j) {
+      double r2 = 0;
+      for (size_t d = 0; d < 3; ++d) {
+        double dd = p[d] - pos(j, d);
+        dd -= len * std::floor(dd / len + 0.5);
+        r2 += dd * dd;
+      }
+      ok = r2 > min_dist * min_dist;
+    }
+    if (ok) {
+      for (size_t d = 0; d < 3; ++d) {
+        pos(placed, d) = p[d];
+      }
+      ++placed;
+    }
+  }
+  return pos;
+}
+
+// Central differences of the energy against the returned forces
+template <typename Pot>
+void check_forces(Pot &pot, const rgpot::types::AtomMatrix &positions,
+                  const Box &box, double tol) {
+  std::vector<int> types(positions.rows(), 1);
+  auto [energy, forces] = pot(positions, types, box);
+  REQUIRE(std::isfinite(energy));
+  const double h = 1e-6;
+  for (int i = 0; i < 4; ++i) {
+    for (int d = 0; d < 3; ++d) {
+      auto plus = positions;
+      auto minus = positions;
+      plus(i, d) += h;
+      minus(i, d) -= h;
+      const double fd = -(pot(plus, types, box).first -
+                          pot(minus, types, box).first) /
+                        (2 * h);
+      REQUIRE_THAT(forces(i, d), WithinAbs(fd, tol * (1.0 + std::abs(fd))));
+    }
+  }
+}
+
+} // namespace
+
+TEST_CASE("LJPairPot reproduces LJPot", "[PairPotential]") {
+  const double len = 40.0;
+  auto positions = random_positions(120, len, 0.9, 11);
+  std::vector<int> types(positions.rows(), 1);
+  const Box box{{{len, 0, 0}, {0, len, 0}, {0, 0, len}}};
+
+  rgpot::LJPot lj;
+  lj.set_simd_level(rgpot::SimdLevel::Scalar);
+  lj.set_num_threads(1);
+  rgpot::LJPairPot pair;
+  pair.set_thread_pool(nullptr);
+  auto [e_ref, f_ref] = lj(positions, types, box);
+  auto [energy, forces] = pair(positions, types, box);
+  REQUIRE(pair.get_type() == rgpot::PotType::LJ);
+  REQUIRE_THAT(energy, WithinRel(e_ref, 1e-11));
+  for (size_t i = 0; i < forces.rows(); ++i) {
+    for (int d = 0; d < 3; ++d) {
+      const double ref = f_ref(i, d);
+      REQUIRE_THAT(forces(i, d), WithinAbs(ref, 1e-9 * (1.0 + std::abs(ref))));
+    }
+  }
+}
+
+TEST_CASE("LJPot shifts the energy at the cutoff", "[PairPotential][LJPot]") {
+  // Two atoms just inside the cutoff carry almost no energy, while the
+  // unshifted pair energy there is about -3.5e-7
+  rgpot::types::AtomMatrix positions{{0, 0, 0}, {14.999, 0, 0}};
+  std::vector<int> types{1, 1};
+  const Box box{{{100, 0, 0}, {0, 100, 0}, {0, 0, 100}}};
+  rgpot::LJPot lj;
+  auto [energy, forces] = lj(positions, types, box);
+  REQUIRE_THAT(energy, WithinAbs(0.0, 1e-9));
+}
+
+TEST_CASE("Truncations are continuous and consistent", "[PairPotential]") {
+  const double rc = 3.0;
+  const rgpot::pair::LennardJones lj{};
+  rgpot::PairPotential<rgpot::pair::LennardJones,
+                       rgpot::truncation::ShiftedEnergy>
+      shifted(lj, rc);
+  rgpot::PairPotential<rgpot::pair::LennardJones,
+                       rgpot::truncation::ShiftedForce>
+      shifted_force(lj, rc);
+  rgpot::PairPotential<rgpot::pair::LennardJones, rgpot::truncation::Switched>
+      switched(lj, rc, 2.5);
+
+  const double below = rc * rc * (1.0 - 1e-9);
+  double u = 0, fs = 0;
+  shifted.pair_terms(below, u, fs);
+  REQUIRE_THAT(u, WithinAbs(0.0, 1e-9));
+  REQUIRE(std::abs(fs) > 1e-3);
+  shifted_force.pair_terms(below, u, fs);
+  REQUIRE_THAT(u, WithinAbs(0.0, 1e-9));
+  REQUIRE_THAT(fs, WithinAbs(0.0, 1e-9));
+  switched.pair_terms(below, u, fs);
+  REQUIRE_THAT(u, WithinAbs(0.0, 1e-9));
+  REQUIRE_THAT(fs, WithinAbs(0.0, 1e-9));
+  shifted.pair_terms(rc * rc * 1.01, u, fs);
+  REQUIRE(u == 0.0);
+  REQUIRE(fs == 0.0);
+
+  // Below the switching region the raw functional is untouched
+  double u_raw = 0, fs_raw = 0;
+  lj(1.2 * 1.2, u_raw, fs_raw);
+  switched.pair_terms(1.2 * 1.2, u, fs);
+  REQUIRE(u == u_raw);
+  REQUIRE(fs == fs_raw);
+
+  REQUIRE_THROWS_AS(
+      (rgpot::PairPotential<rgpot::pair::LennardJones,
+                            rgpot::truncation::Switched>(lj, rc, rc)),
+      std::invalid_argument);
+
+  const double len = 12.0;
+  auto positions = random_positions(40, len, 0.95, 3);
+  const Box box{{{len, 0, 0}, {0, len, 0}, {0, 0, len}}};
+  check_forces(shifted, positions, box, 1e-5);
+  check_forces(shifted_force, positions, box, 1e-5);
+  check_forces(switched, positions, box, 1e-5);
+}
+
+TEST_CASE("Morse and Buckingham forces match their energies",
+          "[PairPotential]") {
+  const double len = 14.0;
+  const Box box{{{len, 0, 0}, {0, len, 0}, {0, 0, len}}};
+
+  rgpot::MorsePot morse;
+  REQUIRE(morse.get_type() == rgpot::PotType::Morse);
+  check_forces(morse, random_positions(50, len, 0.8, 5), box, 1e-5);
+
+  // Stay well on the repulsive side of the Buckingham barrier
+  rgpot::BuckinghamPot buck(rgpot::pair::Buckingham{}, 6.0);
+  REQUIRE(buck.get_type() == rgpot::PotType::Buckingham);
+  check_forces(buck, random_positions(50, len, 1.2, 6), box, 1e-5);
+
+  // Morse minimum sits at re with depth D
+  double u = 0, fs = 0;
+  rgpot::pair::Morse{2.0, 1.5, 1.1}(1.1 * 1.1, u, fs);
+  REQUIRE_THAT(u, WithinAbs(-2.0, 1e-12));
+  REQUIRE_THAT(fs, WithinAbs(0.0, 1e-12));
+}
+
+TEST_CASE("Periodicity and precision policies", "[PairPotential]") {
+  const double len = 12.0;
+  auto positions = random_positions(40, len, 0.95, 8);
+  std::vector<int> types(positions.rows(), 1);
+  const rgpot::pair::LennardJones lj{};
+  const Box cube{{{len, 0, 0}, {0, len, 0}, {0, 0, len}}};
+  const Box skewed{{{len, 0, 0}, {len, len, 0}, {0, 0, len}}};
+
+  rgpot::PairPotential<rgpot::pair::LennardJones> ortho(lj, 2.5);
+  rgpot::PairPotential<rgpot::pair::LennardJones,
+                       rgpot::truncation::ShiftedEnergy,
+                       rgpot::periodicity::Triclinic>
+      tric(lj, 2.5);
+  auto [e_ortho, f_ortho] = ortho(positions, types, cube);
+  auto [e_tric, f_tric] = tric(positions, types, skewed);
+  REQUIRE_THAT(e_tric, WithinRel(e_ortho, 1e-10));
+  REQUIRE_THROWS_AS(ortho(positions, types, skewed), std::runtime_error);
+
+  // A cluster far from its images sees no periodic partners
+  rgpot::PairPotential<rgpot::pair::LennardJones,
+                       rgpot::truncation::ShiftedEnergy,
+                       rgpot::periodicity::None>
+      cluster(lj, 2.5);
+  const Box huge{{{1000, 0, 0}, {0, 1000, 0}, {0, 0, 1000}}};
+  rgpot::PairPotential<rgpot::pair::LennardJones> far(lj, 2.5);
+  auto [e_cluster, f_cluster] = cluster(positions, types, cube);
+  auto [e_far, f_far] = far(positions, types, huge);
+  REQUIRE_THAT(e_cluster, WithinRel(e_far, 1e-10));
+
+  rgpot::PairPotential<rgpot::pair::LennardJones,
+                       rgpot::truncation::ShiftedEnergy,
+                       rgpot::periodicity::Orthogonal, float>
+      single(lj, 2.5);
+  auto [e_single, f_single] = single(positions, types, cube);
+  REQUIRE_THAT(e_single, WithinRel(e_ortho, 1e-4));
+  for (size_t i = 0; i < f_single.rows(); ++i) {
+    for (int d = 0; d < 3; ++d) {
+      const double ref = f_ortho(i, d);
+      REQUIRE_THAT(f_single(i, d),
+                   WithinAbs(ref, 1e-3 * (1.0 + std::abs(ref))));
+    }
+  }
+}
+
+TEST_CASE("PairPotential thread pool matches the serial loop",
+          "[PairPotential][ThreadPool]") {
+  const double len = 20.0;
+  auto positions = random_positions(300, len, 0.9, 21);
+  std::vector<int> types(positions.rows(), 1);
+  const Box box{{{len, 0, 0}, {0, len, 0}, {0, 0, len}}};
+
+  rgpot::MorsePot serial;
+  serial.set_thread_pool(nullptr);
+  rgpot::MorsePot threaded;
+  threaded.set_thread_pool(std::make_shared<rgpot::ThreadPool>(4), true);
+  auto [e_ref, f_ref] = serial(positions, types, box);
+  auto [energy, forces] = threaded(positions, types, box);
+  REQUIRE_THAT(energy, WithinRel(e_ref, 1e-12));
+  for (size_t i = 0; i < forces.rows(); ++i) {
+    for (int d = 0; d < 3; ++d) {
+      REQUIRE_THAT(forces(i, d), WithinAbs(f_ref(i, d), 1e-10));
+    }
+  }
+}
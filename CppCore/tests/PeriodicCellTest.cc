@@ -0,0 +1,138 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/PeriodicCell.hpp"
+
+using namespace Catch::Matchers;
+
+namespace {
+
+// Shortest image of d found by trying the neighboring lattice translations
+double brute_force_image_r2(const double *d, const double *box) {
+  double best = std::numeric_limits<double>::max();
+  for (int n0 = -2; n0 <= 2; ++n0) {
+    for (int n1 = -2; n1 <= 2; ++n1) {
+      for (int n2 = -2; n2 <= 2; ++n2) {
+        double r2 = 0;
+        for (size_t k = 0; k < 3; ++k) {
+          const double v =
+              d[k] + n0 * box[k] + n1 * box[3 + k] + n2 * box[6 + k];
+          r2 += v * v;
+        }
+        best = std::min(best, r2);
+      }
+    }
+  }
+  return best;
+}
+
+} // namespace
+
+TEST_CASE("PeriodicCell inverts the cell matrix", "[PeriodicCell]") {
+  const double box[9] = {10, 0, 0, 2, 9, 0, -1, 1.5, 8};
+  const rgpot::PeriodicCell cell(box);
+  REQUIRE_FALSE(cell.orthogonal());
+  const auto &inv = cell.inverse();
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 3; ++j) {
+      double v = 0;
+      for (size_t k = 0; k < 3; ++k) {
+        v += box[3 * i + k] * inv[3 * k + j];
+      }
+      REQUIRE_THAT(v, WithinAbs(i == j ? 1.0 : 0.0, 1e-14));
+    }
+  }
+  // Lower triangular cell, the c vector crosses the xy faces at z = 8
+  REQUIRE_THAT(cell.perpendicular_width(2), WithinRel(8.0, 1e-14));
+
+  const double ortho[9] = {10, 0, 0, 0, 12, 1e-15, 0, 0, 14};
+  const rgpot::PeriodicCell ocell(ortho);
+  REQUIRE(ocell.orthogonal());
+  REQUIRE(ocell.inverse_lengths()[1] == 1.0 / 12.0);
+  REQUIRE_THAT(ocell.perpendicular_width(0), WithinRel(10.0, 1e-14));
+
+  const double flat[9] = {10, 0, 0, 5, 0, 0, 0, 0, 14};
+  REQUIRE_THROWS_AS(rgpot::PeriodicCell(flat), std::invalid_argument);
+}
+
+TEST_CASE("PeriodicCell finds the minimum image", "[PeriodicCell]") {
+  const double box[9] = {10, 0, 0, 2, 9, 0, -1, 1.5, 8};
+  const rgpot::PeriodicCell cell(box);
+  double min_width = cell.perpendicular_width(0);
+  for (size_t d = 1; d < 3; ++d) {
+    min_width = std::min(min_width, cell.perpendicular_width(d));
+  }
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<> dis(-25.0, 25.0);
+  size_t checked = 0;
+  for (size_t trial = 0; trial < 2000; ++trial) {
+    double d[3]{dis(gen), dis(gen), dis(gen)};
+    const double expected = brute_force_image_r2(d, box);
+    if (expected >= 0.25 * min_width * min_width) {
+      continue; // Beyond the range where the fractional image is exact
+    }
+    cell.minimum_image<false>(d[0], d[1], d[2]);
+    REQUIRE_THAT(d[0] * d[0] + d[1] * d[1] + d[2] * d[2],
+                 WithinRel(expected, 1e-12));
+    ++checked;
+  }
+  REQUIRE(checked > 100);
+
+  const double obox[9] = {10, 0, 0, 0, 12, 0, 0, 0, 14};
+  const rgpot::PeriodicCell ocell(obox);
+  for (size_t trial = 0; trial < 200; ++trial) {
+    double a[3]{dis(gen), dis(gen), dis(gen)};
+    double b[3]{a[0], a[1], a[2]};
+    ocell.minimum_image<true>(a[0], a[1], a[2]);
+    ocell.minimum_image<false>(b[0], b[1], b[2]);
+    for (size_t k = 0; k < 3; ++k) {
+      REQUIRE_THAT(a[k], WithinAbs(b[k], 1e-12));
+    }
+  }
+}
+
+TEST_CASE("LJPot agrees on equivalent skewed and orthogonal cells",
+          "[PeriodicCell][LJPot]") {
+  // b' = b + a and c' = c - b describe the same lattice as the cube
+  const double len = 60.0;
+  const std::array<std::array<double, 3>, 3> cube{
+      {{len, 0, 0}, {0, len, 0}, {0, 0, len}}};
+  const std::array<std::array<double, 3>, 3> skewed{
+      {{len, 0, 0}, {len, len, 0}, {0, -len, len}}};
+
+  const size_t n_atoms = 96;
+  std::mt19937 gen(2024);
+  std::uniform_real_distribution<> dis(0.0, len);
+  rgpot::types::AtomMatrix positions(n_atoms, 3);
+  for (size_t i = 0; i < n_atoms; ++i) {
+    for (size_t d = 0; d < 3; ++d) {
+      positions(i, d) = dis(gen);
+    }
+  }
+  std::vector<int> types(n_atoms, 1);
+
+  for (auto level : {rgpot::SimdLevel::Scalar, rgpot::detect_simd_level()}) {
+    rgpot::LJPot ortho_pot;
+    rgpot::LJPot skewed_pot;
+    ortho_pot.set_simd_level(level);
+    skewed_pot.set_simd_level(level);
+    auto [e_ortho, f_ortho] = ortho_pot(positions, types, cube);
+    auto [e_skewed, f_skewed] = skewed_pot(positions, types, skewed);
+    REQUIRE_THAT(e_skewed, WithinRel(e_ortho, 1e-10));
+    for (size_t i = 0; i < n_atoms; ++i) {
+      for (size_t d = 0; d < 3; ++d) {
+        REQUIRE_THAT(f_skewed(i, d),
+                     WithinAbs(f_ortho(i, d),
+                               1e-9 * (1.0 + std::abs(f_ortho(i, d)))));
+      }
+    }
+  }
+}
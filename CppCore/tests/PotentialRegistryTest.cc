@@ -0,0 +1,65 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <algorithm>
+#include <catch2/catch_all.hpp>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/PairFunctionals.hpp"
+#include "rgpot/PotentialRegistry.hpp"
+
+using rgpot::PotentialRegistry;
+using rgpot::PotType;
+
+RGPOT_REGISTER_POTENTIAL(rgpot::MorsePot, "TestMorse", PotType::Morse);
+
+TEST_CASE("PotentialRegistry lists the built-in potentials",
+          "[PotentialRegistry]") {
+  const PotentialRegistry &registry = PotentialRegistry::global();
+  const std::vector<std::string> names = registry.names();
+  for (const char *name : {"LJ", "Morse", "Buckingham"}) {
+    REQUIRE(std::find(names.begin(), names.end(), name) != names.end());
+  }
+  REQUIRE(std::is_sorted(names.begin(), names.end()));
+
+  const PotentialRegistry::Entry *lj = registry.find("LJ");
+  REQUIRE(lj != nullptr);
+  REQUIRE(lj->type == PotType::LJ);
+  REQUIRE(registry.find("Unknown") == nullptr);
+}
+
+TEST_CASE("PotentialRegistry creates instances on demand",
+          "[PotentialRegistry]") {
+  const PotentialRegistry &registry = PotentialRegistry::global();
+  const PotentialRegistry::Entry *lj = registry.find("LJ");
+  const size_t before = lj->instances();
+  {
+    std::unique_ptr<rgpot::PotentialBase> pot = registry.create("LJ");
+    REQUIRE(dynamic_cast<rgpot::LJPot *>(pot.get()) != nullptr);
+    REQUIRE(lj->instances() == before + 1);
+  }
+  REQUIRE(lj->instances() == before);
+
+  REQUIRE_THROWS_AS(registry.create("Unknown"), std::invalid_argument);
+  REQUIRE_THROWS_WITH(registry.create("Unknown"),
+                      Catch::Matchers::ContainsSubstring("Buckingham"));
+}
+
+TEST_CASE("PotentialRegistry takes registrations of programs",
+          "[PotentialRegistry]") {
+  PotentialRegistry &registry = PotentialRegistry::global();
+  const PotentialRegistry::Entry *entry = registry.find("TestMorse");
+  REQUIRE(entry != nullptr);
+  REQUIRE(entry->type == PotType::Morse);
+  REQUIRE(dynamic_cast<rgpot::MorsePot *>(
+              registry.create("TestMorse").get()) != nullptr);
+
+  // Names are taken once, the first registration is kept
+  REQUIRE_FALSE(registry.add<rgpot::LJPot>("TestMorse", PotType::LJ));
+  REQUIRE(registry.find("TestMorse")->type == PotType::Morse);
+  REQUIRE(registry.add<rgpot::LJPot>("TestLJ", PotType::LJ));
+  REQUIRE(registry.describe().find("TestLJ") != std::string::npos);
+}
@@ -0,0 +1,67 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <thread>
+#include <vector>
+
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/pot_stats.h"
+
+using rgpot::PotentialStats;
+
+TEST_CASE("Histogram buckets are powers of two", "[PotentialStats]") {
+  REQUIRE(PotentialStats::bucket_of(0) == 0);
+  REQUIRE(PotentialStats::bucket_of(1) == 0);
+  REQUIRE(PotentialStats::bucket_of(2) == 1);
+  REQUIRE(PotentialStats::bucket_of(1023) == 9);
+  REQUIRE(PotentialStats::bucket_of(1024) == 10);
+  REQUIRE(PotentialStats::bucket_of(~uint64_t{0}) ==
+          PotentialStats::num_buckets - 1);
+}
+
+TEST_CASE("Force calls are counted across threads", "[PotentialStats]") {
+  const auto lj = static_cast<int32_t>(rgpot::PotType::LJ);
+  REQUIRE(pot_stats_reset(lj) == 0);
+
+  const size_t n_threads = 4;
+  const size_t n_calls = 50;
+  const size_t n_atoms = 3;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < n_threads; ++t) {
+    threads.emplace_back([=] {
+      rgpot::LJPot pot;
+      rgpot::types::AtomMatrix pos{
+          {0.0, 0.0, 0.0}, {1.1, 0.0, 0.0}, {0.0, 1.2 + 0.01 * t, 0.0}};
+      std::vector<int> types(n_atoms, 0);
+      std::array<std::array<double, 3>, 3> box{
+          {{20.0, 0.0, 0.0}, {0.0, 20.0, 0.0}, {0.0, 0.0, 20.0}}};
+      for (size_t i = 0; i < n_calls; ++i) {
+        pot(pos, types, box);
+      }
+    });
+  }
+  for (auto &th : threads) {
+    th.join();
+  }
+  REQUIRE(rgpot::registry<rgpot::LJPot>::count == 0);
+
+  PotStats stats{};
+  REQUIRE(pot_stats_get(lj, &stats) == 0);
+  REQUIRE(stats.force_calls == n_threads * n_calls);
+  REQUIRE(stats.atoms == n_threads * n_calls * n_atoms);
+  REQUIRE(stats.cache_hits == 0);
+  uint64_t binned = 0;
+  for (uint64_t h : stats.wall_histogram) {
+    binned += h;
+  }
+  REQUIRE(binned == stats.force_calls);
+  REQUIRE(stats.wall_ns > 0);
+
+  REQUIRE(pot_stats_reset(lj) == 0);
+  REQUIRE(pot_stats_get(lj, &stats) == 0);
+  REQUIRE(stats.force_calls == 0);
+
+  REQUIRE(pot_stats_get(-1, &stats) != 0);
+  REQUIRE(pot_stats_get(lj, nullptr) != 0);
+  REQUIRE(pot_stats_reset(1000) != 0);
+}
@@ -0,0 +1,205 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "rgpot/rpc/ShmChannel.hpp"
+
+using namespace Catch::Matchers;
+
+namespace {
+
+std::string unique_name(const char *tag) {
+  return std::string("rgpot-test-") + tag + "-" + std::to_string(::getpid());
+}
+
+// Forces are twice the positions, the energy sums the atomic numbers
+void toy_handler(const rgpot::shm::Call &call) {
+  for (size_t k = 0; k < 3 * call.nAtoms; ++k) {
+    call.forces[k] = 2.0 * call.pos[k] + call.box[0];
+  }
+  *call.energy =
+      std::accumulate(call.atmnrs, call.atmnrs + call.nAtoms, 0.0);
+  if (call.nAtoms == 3) {
+    throw std::runtime_error("three atoms are not allowed");
+  }
+}
+
+// Server threads running for the lifetime of a test case
+struct ServerThreads {
+  rgpot::shm::Server server;
+  std::vector<std::thread> threads;
+
+  ServerThreads(const std::string &name, uint32_t nslots, size_t nthreads,
+                rgpot::shm::Server::Handler handler = toy_handler)
+      : server(name, nslots, 16) {
+    for (size_t t = 0; t < nthreads; ++t) {
+      threads.emplace_back([this, handler] { server.serve(handler); });
+    }
+  }
+  ~ServerThreads() {
+    server.stop();
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+};
+
+} // namespace
+
+TEST_CASE("Shared memory addresses", "[Shm]") {
+  REQUIRE(rgpot::shm::parse_address("shm://potserv") == "potserv");
+  REQUIRE_FALSE(rgpot::shm::parse_address("localhost").has_value());
+  REQUIRE_FALSE(rgpot::shm::parse_address(nullptr).has_value());
+  REQUIRE_THROWS(rgpot::shm::Client("rgpot-test-nobody-serves-this"));
+  REQUIRE_THROWS(rgpot::shm::Client("not/a/name"));
+}
+
+TEST_CASE("Shared memory round trip", "[Shm]") {
+  const auto name = unique_name("roundtrip");
+  ServerThreads srv(name, 4, 1);
+  rgpot::shm::Client client(name);
+  REQUIRE(client.max_atoms() == 16);
+
+  const std::vector<double> pos{0.5, 1.0, 1.5, 2.0, 2.5, 3.0};
+  const std::vector<int32_t> atm{1, 29};
+  const double box[9] = {10, 0, 0, 0, 10, 0, 0, 0, 10};
+  std::vector<double> forces(6, 0.0);
+
+  // The second pass reuses the slot released by the first
+  for (int pass = 0; pass < 2; ++pass) {
+    auto slot = client.acquire();
+    REQUIRE(slot.has_value());
+    client.submit(*slot, 2, pos.data(), atm.data(), box);
+    client.wait(*slot);
+    REQUIRE(client.ready(*slot));
+    const double energy = client.collect(*slot, forces.data());
+    client.release(*slot);
+    REQUIRE(energy == 30.0);
+    for (size_t k = 0; k < 6; ++k) {
+      REQUIRE(forces[k] == 2.0 * pos[k] + 10.0);
+    }
+  }
+}
+
+TEST_CASE("Shared memory errors", "[Shm]") {
+  const auto name = unique_name("errors");
+  ServerThreads srv(name, 2, 1);
+  rgpot::shm::Client client(name);
+  const std::vector<double> pos(3 * 17, 1.0);
+  const std::vector<int32_t> atm(17, 1);
+  const double box[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  std::vector<double> forces(3 * 17);
+
+  auto slot = client.acquire();
+  REQUIRE(slot.has_value());
+
+  SECTION("Handler exceptions fail the call with their message") {
+    client.submit(*slot, 3, pos.data(), atm.data(), box);
+    client.wait(*slot);
+    REQUIRE_THROWS_WITH(client.collect(*slot, forces.data()),
+                        ContainsSubstring("three atoms"));
+    // The slot is usable again
+    client.submit(*slot, 1, pos.data(), atm.data(), box);
+    client.wait(*slot);
+    REQUIRE(client.collect(*slot, forces.data()) == 1.0);
+  }
+
+  SECTION("Systems above the slot capacity are rejected") {
+    REQUIRE_THROWS_WITH(client.submit(*slot, 17, pos.data(), atm.data(), box),
+                        ContainsSubstring("--shm-atoms"));
+  }
+
+  SECTION("Slots run out and are shared between clients") {
+    rgpot::shm::Client other(name);
+    REQUIRE(other.acquire().has_value());
+    REQUIRE_FALSE(client.acquire().has_value());
+    REQUIRE_FALSE(other.acquire().has_value());
+  }
+}
+
+TEST_CASE("Shared memory calls in flight", "[Shm]") {
+  const auto name = unique_name("inflight");
+  ServerThreads srv(name, 8, 3);
+  const double box[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  // Several clients, each with several calls in flight
+  std::vector<std::thread> drivers;
+  std::vector<int> failures(4, 0);
+  for (int d = 0; d < 4; ++d) {
+    drivers.emplace_back([&, d] {
+      rgpot::shm::Client client(name);
+      std::vector<uint32_t> slots;
+      std::vector<std::vector<double>> pos;
+      for (int c = 0; c < 2; ++c) {
+        auto slot = client.acquire();
+        if (!slot) {
+          ++failures[d];
+          return;
+        }
+        slots.push_back(*slot);
+        pos.emplace_back(6, 10.0 * d + c);
+      }
+      const std::vector<int32_t> atm{d, d};
+      for (int round = 0; round < 200; ++round) {
+        for (size_t c = 0; c < slots.size(); ++c) {
+          client.submit(slots[c], 2, pos[c].data(), atm.data(), box);
+        }
+        std::vector<uint32_t> pending = slots;
+        std::vector<size_t> owner{0, 1};
+        std::vector<double> forces(6);
+        while (!pending.empty()) {
+          const size_t k = client.wait_any(pending);
+          const double energy = client.collect(pending[k], forces.data());
+          if (energy != 2.0 * d || forces[0] != 2.0 * pos[owner[k]][0]) {
+            ++failures[d];
+          }
+          pending.erase(pending.begin() + k);
+          owner.erase(owner.begin() + k);
+        }
+      }
+    });
+  }
+  for (auto &t : drivers) {
+    t.join();
+  }
+  for (int f : failures) {
+    REQUIRE(f == 0);
+  }
+}
+
+TEST_CASE("Shared memory waits wake on any slot", "[Shm]") {
+  const auto name = unique_name("wakeany");
+  // The first atomic number is a delay in milliseconds
+  ServerThreads srv(name, 4, 2, [](const rgpot::shm::Call &call) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(call.atmnrs[0]));
+    *call.energy = call.atmnrs[0];
+  });
+  rgpot::shm::Client client(name);
+  auto slow = client.acquire();
+  auto fast = client.acquire();
+  REQUIRE((slow && fast));
+  const double pos[3] = {0, 0, 0};
+  const double box[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+  const int32_t slow_ms = 1000;
+  const int32_t fast_ms = 10;
+  double force[3];
+
+  // The answer to the second slot must not wait for the first one
+  const auto start = std::chrono::steady_clock::now();
+  client.submit(*slow, 1, pos, &slow_ms, box);
+  client.submit(*fast, 1, pos, &fast_ms, box);
+  const size_t k = client.wait_any({*slow, *fast});
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  REQUIRE(k == 1);
+  REQUIRE(elapsed < std::chrono::milliseconds(80));
+  REQUIRE(client.collect(*fast, force) == fast_ms);
+  client.wait(*slow);
+  REQUIRE(client.collect(*slow, force) == slow_ms);
+}
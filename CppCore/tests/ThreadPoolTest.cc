@@ -0,0 +1,106 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/ThreadPool.hpp"
+
+using namespace Catch::Matchers;
+
+namespace {
+
+rgpot::types::AtomMatrix random_positions(size_t n_atoms, double len,
+                                          unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<> dis(0.0, len);
+  rgpot::types::AtomMatrix pos(n_atoms, 3);
+  for (size_t i = 0; i < n_atoms * 3; ++i) {
+    pos.data()[i] = dis(gen);
+  }
+  return pos;
+}
+
+} // namespace
+
+TEST_CASE("ThreadPool runs every task exactly once", "[ThreadPool]") {
+  rgpot::ThreadPool pool(4);
+  REQUIRE(pool.size() == 4);
+
+  std::vector<std::atomic<int>> hits(1000);
+  std::atomic<bool> slot_ok{true};
+  pool.parallel_for(hits.size(), [&](size_t task, size_t slot) {
+    hits[task].fetch_add(1);
+    if (slot >= pool.size()) {
+      slot_ok = false;
+    }
+  });
+  for (const auto &h : hits) {
+    REQUIRE(h.load() == 1);
+  }
+  REQUIRE(slot_ok.load());
+
+  SECTION("Nested calls complete") {
+    std::atomic<size_t> count{0};
+    pool.parallel_for(8, [&](size_t, size_t) {
+      pool.parallel_for(8, [&](size_t, size_t) { count.fetch_add(1); });
+    });
+    REQUIRE(count.load() == 64);
+  }
+
+  SECTION("Exceptions propagate to the caller") {
+    REQUIRE_THROWS_AS(pool.parallel_for(16,
+                                        [](size_t task, size_t) {
+                                          if (task == 7) {
+                                            throw std::runtime_error("boom");
+                                          }
+                                        }),
+                      std::runtime_error);
+  }
+}
+
+TEST_CASE("Parallel LJPot matches the serial loop", "[ThreadPool][LJPot]") {
+  const size_t n_atoms = 400;
+  std::array<std::array<double, 3>, 3> box = {
+      {{50, 0, 0}, {0, 50, 0}, {0, 0, 50}}};
+  auto positions = random_positions(n_atoms, 50.0, 77);
+  std::vector<int> types(n_atoms, 1);
+
+  auto serial = rgpot::LJPot();
+  serial.set_num_threads(1);
+  auto [e_ref, f_ref] = serial(positions, types, box);
+
+  SECTION("Dynamic scheduling") {
+    auto parallel = rgpot::LJPot();
+    parallel.set_num_threads(4);
+    REQUIRE(parallel.num_threads() == 4);
+    auto [energy, forces] = parallel(positions, types, box);
+    REQUIRE_THAT(energy, WithinRel(e_ref, 1e-10));
+    for (size_t i = 0; i < n_atoms * 3; ++i) {
+      REQUIRE_THAT(forces.data()[i], WithinAbs(f_ref.data()[i], 1e-9));
+    }
+  }
+
+  SECTION("Deterministic reduction is bit-stable") {
+    auto pool = std::make_shared<rgpot::ThreadPool>(3);
+    auto first = rgpot::LJPot();
+    auto second = rgpot::LJPot();
+    first.set_thread_pool(pool, true);
+    second.set_thread_pool(pool, true);
+    auto [e1, f1] = first(positions, types, box);
+    for (int rep = 0; rep < 3; ++rep) {
+      auto [e2, f2] = second(positions, types, box);
+      REQUIRE(e1 == e2);
+      for (size_t i = 0; i < n_atoms * 3; ++i) {
+        REQUIRE(f1.data()[i] == f2.data()[i]);
+      }
+    }
+    REQUIRE_THAT(e1, WithinRel(e_ref, 1e-10));
+    for (size_t i = 0; i < n_atoms * 3; ++i) {
+      REQUIRE_THAT(f1.data()[i], WithinAbs(f_ref.data()[i], 1e-9));
+    }
+  }
+}
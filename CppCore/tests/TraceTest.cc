@@ -0,0 +1,98 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+#include <catch2/catch_all.hpp>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rgpot/LennardJones/LJPot.hpp"
+#include "rgpot/Trace.hpp"
+#include "rgpot/pot_trace.h"
+
+namespace trace = rgpot::trace;
+
+/**
+ * @brief Counts the occurrences of a substring.
+ */
+static size_t count_of(const std::string &text, const std::string &needle) {
+  size_t n = 0;
+  for (auto pos = text.find(needle); pos != std::string::npos;
+       pos = text.find(needle, pos + needle.size())) {
+    ++n;
+  }
+  return n;
+}
+
+TEST_CASE("Spans are written as Chrome trace events", "[Trace]") {
+  trace::clear();
+  {
+    trace::Span outer("test.outer");
+    trace::Span inner("test.\"inner\"");
+  }
+  std::ostringstream os;
+  REQUIRE(trace::write_chrome_json(os) == 2);
+  const std::string json = os.str();
+  REQUIRE(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0) == 0);
+  REQUIRE(count_of(json, "\"ph\":\"X\"") == 2);
+  REQUIRE(count_of(json, "\"name\":\"test.outer\"") == 1);
+  REQUIRE(count_of(json, "\"name\":\"test.\\\"inner\\\"\"") == 1);
+
+  trace::clear();
+  std::ostringstream empty;
+  REQUIRE(trace::write_chrome_json(empty) == 0);
+}
+
+TEST_CASE("Rings keep the latest spans of every thread", "[Trace]") {
+  trace::clear();
+  const size_t n_threads = 3;
+  const size_t n_spans = trace::ring_capacity + 100;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < n_threads; ++t) {
+    threads.emplace_back([] {
+      for (size_t i = 0; i < n_spans; ++i) {
+        const uint64_t now = trace::now_ns();
+        trace::record("test.loop", now, now + 1);
+      }
+    });
+  }
+  // Dumps may run concurrently with writers
+  std::ostringstream during;
+  trace::write_chrome_json(during);
+  for (auto &th : threads) {
+    th.join();
+  }
+  std::ostringstream os;
+  REQUIRE(trace::write_chrome_json(os) == n_threads * trace::ring_capacity);
+  trace::clear();
+}
+
+TEST_CASE("Evaluations emit force spans when tracing", "[Trace]") {
+  trace::clear();
+  rgpot::LJPot pot;
+  rgpot::types::AtomMatrix pos{{0.0, 0.0, 0.0}, {1.1, 0.0, 0.0}};
+  std::vector<int> types(2, 0);
+  std::array<std::array<double, 3>, 3> box{
+      {{20.0, 0.0, 0.0}, {0.0, 20.0, 0.0}, {0.0, 0.0, 20.0}}};
+  pot(pos, types, box);
+
+  std::ostringstream os;
+  trace::write_chrome_json(os);
+#ifdef RGPOT_HAS_TRACE
+  REQUIRE(count_of(os.str(), "\"name\":\"pot.force\"") == 1);
+#else
+  REQUIRE(count_of(os.str(), "\"name\":\"pot.force\"") == 0);
+#endif
+
+  const std::string path = "rgpot_trace_test.json";
+  REQUIRE(pot_trace_dump(path.c_str()) == 0);
+  std::ifstream in(path);
+  std::stringstream body;
+  body << in.rdbuf();
+  REQUIRE(body.str() == os.str());
+  std::remove(path.c_str());
+  REQUIRE(pot_trace_dump(nullptr) != 0);
+  pot_trace_clear();
+}
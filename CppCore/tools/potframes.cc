@@ -0,0 +1,590 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @brief Batch driver evaluating frame files.
+ *
+ * Streams the frames of a @c FrameFile through a potential and writes the
+ * energies and forces, with the positions unless @c --no-positions, into a
+ * new frame file. Both files are memory mapped and the potential writes
+ * its results straight into the output mapping, so no frame is parsed or
+ * copied on the way.
+ *
+ * The frames are processed in chunks by a three stage pipeline:
+ *
+ * 1. a prefetch thread asks the kernel to read the next chunks ahead of
+ *    the compute threads, at most @c --ahead chunks beyond those written;
+ * 2. compute threads, each with its own potential instance (or, with
+ *    @c --remote, its own connection to @c potserv), evaluate one chunk at
+ *    a time through @c calculate_batch;
+ * 3. the main thread writes completed chunks back in order, starting the
+ *    write of the output and dropping the input pages it no longer needs.
+ *
+ * @c --convert turns an eOn @c .con trajectory into a frame file once, so
+ * that later runs skip the text parsing.
+ */
+
+// clang-format off
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rgpot/FrameFile.hpp"
+#include "rgpot/Potential.hpp"
+#include "rgpot/PotentialRegistry.hpp"
+
+#ifdef RGPOT_HAS_RPC
+#include "rgpot/rpc/pot_bridge.h"
+#endif // RGPOT_HAS_RPC
+// clang-format on
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using rgpot::frames::FrameFile;
+
+/**
+ * @brief Command line settings.
+ */
+struct Options {
+  std::string input;          //!< Input frame file.
+  std::string output;         //!< Output frame file.
+  std::string pot = "LJ";     //!< Local potential type.
+  std::string remote;         //!< potserv address, empty to run locally.
+  int32_t port = 12345;       //!< Port of entries of @c remote without one.
+  size_t threads = 0;         //!< Compute threads, 0 for every core.
+  size_t chunk = 64;          //!< Frames per chunk.
+  size_t ahead = 4;           //!< Chunks prefetched past those written.
+  bool keep_positions = true; //!< Copy the positions to the output.
+  bool convert = false;       //!< Convert a .con file instead.
+};
+
+/**
+ * @brief Evaluates a run of frames into the output mapping.
+ *
+ * Arguments: frame count, atom count, positions, atomic numbers, boxes,
+ * energies and forces, laid out as for @c calculate_batch.
+ */
+using ChunkFn =
+    std::function<void(size_t, size_t, const double *, const int *,
+                       const double *, double *, double *)>;
+
+/**
+ * @brief Creates the evaluator of one compute thread.
+ */
+using EvaluatorFactory = std::function<ChunkFn()>;
+
+/**
+ * @brief Chemical symbols up to radon, indexed by atomic number - 1.
+ */
+constexpr const char *kSymbols[] = {
+    "H",  "He", "Li", "Be", "B",  "C",  "N",  "O",  "F",  "Ne", "Na", "Mg",
+    "Al", "Si", "P",  "S",  "Cl", "Ar", "K",  "Ca", "Sc", "Ti", "V",  "Cr",
+    "Mn", "Fe", "Co", "Ni", "Cu", "Zn", "Ga", "Ge", "As", "Se", "Br", "Kr",
+    "Rb", "Sr", "Y",  "Zr", "Nb", "Mo", "Tc", "Ru", "Rh", "Pd", "Ag", "Cd",
+    "In", "Sn", "Sb", "Te", "I",  "Xe", "Cs", "Ba", "La", "Ce", "Pr", "Nd",
+    "Pm", "Sm", "Eu", "Gd", "Tb", "Dy", "Ho", "Er", "Tm", "Yb", "Lu", "Hf",
+    "Ta", "W",  "Re", "Os", "Ir", "Pt", "Au", "Hg", "Tl", "Pb", "Bi", "Po",
+    "At", "Rn"};
+
+/**
+ * @brief Looks up the atomic number of a chemical symbol.
+ * @param symbol The symbol, or the number itself.
+ * @return The atomic number.
+ */
+int32_t atomic_number(const std::string &symbol) {
+  for (size_t z = 0; z < std::size(kSymbols); ++z) {
+    if (symbol == kSymbols[z]) {
+      return static_cast<int32_t>(z + 1);
+    }
+  }
+  try {
+    return std::stoi(symbol);
+  } catch (const std::exception &) {
+    throw std::runtime_error("Unknown element '" + symbol + "'");
+  }
+}
+
+/**
+ * @brief Frames read from a text trajectory.
+ */
+struct Trajectory {
+  std::vector<int32_t> atmnrs; //!< Atomic numbers [natoms].
+  double box[9] = {};          //!< Cell of the first frame, row-major.
+  std::vector<double> pos;     //!< Positions of all frames.
+  size_t nframes = 0;          //!< Number of frames.
+};
+
+/**
+ * @brief Reads the next non-empty line.
+ * @param in The stream.
+ * @param line Receives the line.
+ * @return False at the end of the stream.
+ */
+bool next_line(std::istream &in, std::string &line) {
+  while (std::getline(in, line)) {
+    if (line.find_first_not_of(" \t\r") != std::string::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Reads an eOn @c .con file of one or more frames.
+ *
+ * A frame file holds one cell, so every frame must have the lengths and
+ * angles of the first one, and the same atoms in the same order.
+ *
+ * @param path Path of the file.
+ * @return The frames.
+ */
+Trajectory read_con(const std::string &path) {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error("Cannot read " + path);
+  }
+  Trajectory traj;
+  std::vector<double> cell;
+  std::string line;
+  auto fail = [&](const std::string &what) {
+    return std::runtime_error(path + ", frame " +
+                              std::to_string(traj.nframes + 1) + ": " + what);
+  };
+  auto numbers = [&](size_t count) {
+    if (!next_line(in, line)) {
+      throw fail("unexpected end of file");
+    }
+    std::istringstream fields(line);
+    std::vector<double> out(count);
+    for (double &v : out) {
+      if (!(fields >> v)) {
+        throw fail("malformed line '" + line + "'");
+      }
+    }
+    return out;
+  };
+
+  while (next_line(in, line)) {
+    // Seed and time lines, the first of which was just read
+    next_line(in, line);
+    const std::vector<double> lengths = numbers(3);
+    const std::vector<double> angles = numbers(3);
+    next_line(in, line);
+    next_line(in, line);
+    const auto ntypes = static_cast<size_t>(numbers(1)[0]);
+    const std::vector<double> counts = numbers(ntypes);
+    numbers(ntypes); // Masses
+
+    std::vector<int32_t> atmnrs;
+    std::vector<double> pos;
+    for (size_t t = 0; t < ntypes; ++t) {
+      if (!next_line(in, line)) {
+        throw fail("unexpected end of file");
+      }
+      std::istringstream symbol(line);
+      std::string name;
+      symbol >> name;
+      const int32_t z = atomic_number(name);
+      next_line(in, line); // "Components of Type N"
+      for (size_t a = 0; a < static_cast<size_t>(counts[t]); ++a) {
+        const std::vector<double> xyz = numbers(3);
+        pos.insert(pos.end(), xyz.begin(), xyz.end());
+        atmnrs.push_back(z);
+      }
+    }
+
+    std::vector<double> frame_cell = lengths;
+    frame_cell.insert(frame_cell.end(), angles.begin(), angles.end());
+    if (traj.nframes == 0) {
+      traj.atmnrs = atmnrs;
+      cell = frame_cell;
+      constexpr double deg = 3.14159265358979323846 / 180.0;
+      const double ca = std::cos(angles[0] * deg);
+      const double cb = std::cos(angles[1] * deg);
+      const double cg = std::cos(angles[2] * deg);
+      const double sg = std::sin(angles[2] * deg);
+      const double cx = cb;
+      const double cy = (ca - cb * cg) / sg;
+      const double cz = std::sqrt(std::max(0.0, 1.0 - cx * cx - cy * cy));
+      // Rows are the cell vectors, a along x and b in the xy plane
+      const double box[9] = {lengths[0],      0.0,             0.0,
+                             lengths[1] * cg, lengths[1] * sg, 0.0,
+                             lengths[2] * cx, lengths[2] * cy, lengths[2] * cz};
+      std::copy(std::begin(box), std::end(box), traj.box);
+    } else if (atmnrs != traj.atmnrs) {
+      throw fail("atoms differ from the first frame");
+    } else {
+      // Allow for rounding where the cell was written out
+      for (size_t k = 0; k < cell.size(); ++k) {
+        if (std::abs(frame_cell[k] - cell[k]) >
+            1e-9 * std::max(1.0, std::abs(cell[k]))) {
+          throw fail("cell differs from the first frame");
+        }
+      }
+    }
+    traj.pos.insert(traj.pos.end(), pos.begin(), pos.end());
+    ++traj.nframes;
+  }
+  if (traj.nframes == 0) {
+    throw std::runtime_error(path + " holds no frames");
+  }
+  return traj;
+}
+
+/**
+ * @brief Converts a @c .con trajectory into a frame file of positions.
+ * @param opts The settings, naming both files.
+ * @return Void.
+ */
+void convert(const Options &opts) {
+  const Trajectory traj = read_con(opts.input);
+  FrameFile out = FrameFile::create(
+      opts.output, rgpot::frames::Positions, traj.atmnrs.size(),
+      traj.nframes, traj.atmnrs.data(), traj.box);
+  std::copy(traj.pos.begin(), traj.pos.end(), out.positions(0));
+  out.flush(0, traj.nframes, true);
+  std::cout << "potframes: wrote " << traj.nframes << " frame(s) of "
+            << traj.atmnrs.size() << " atoms to " << opts.output << std::endl;
+}
+
+/**
+ * @brief Creates evaluators of a local potential.
+ * @param type Potential type name.
+ * @return The factory, one instance per compute thread.
+ */
+EvaluatorFactory local_evaluators(const std::string &type) {
+  const rgpot::PotentialRegistry &registry =
+      rgpot::PotentialRegistry::global();
+  // Rejects unknown names before any thread starts
+  if (registry.find(type) == nullptr) {
+    throw std::runtime_error("Unknown potential type '" + type +
+                             "', available: " + registry.describe());
+  }
+  return [&registry, type] {
+    std::shared_ptr<rgpot::PotentialBase> pot = registry.create(type);
+    return [pot](size_t nconf, size_t natoms, const double *pos,
+                 const int *atmnrs, const double *boxes, double *energies,
+                 double *forces) {
+      pot->calculate_batch(nconf, natoms, pos, atmnrs, boxes, energies,
+                           forces);
+    };
+  };
+}
+
+#ifdef RGPOT_HAS_RPC
+
+/**
+ * @brief Creates evaluators sending chunks to potential servers.
+ * @param address Address as accepted by @c pot_client_init.
+ * @param port Port of entries without one.
+ * @return The factory, one connection per compute thread.
+ */
+EvaluatorFactory remote_evaluators(const std::string &address, int32_t port) {
+  return [address, port] {
+    std::shared_ptr<PotClient> client(
+        pot_client_init(address.c_str(), port), pot_client_free);
+    if (!client) {
+      throw std::runtime_error("Could not connect to " + address);
+    }
+    return [client](size_t nconf, size_t natoms, const double *pos,
+                    const int *atmnrs, const double *boxes, double *energies,
+                    double *forces) {
+      if (pot_calculate_batch(client.get(), static_cast<int32_t>(nconf),
+                              static_cast<int32_t>(natoms), pos, atmnrs,
+                              boxes, energies, forces) != 0) {
+        throw std::runtime_error(pot_get_last_error(client.get()));
+      }
+    };
+  };
+}
+
+#endif // RGPOT_HAS_RPC
+
+/**
+ * @brief Shared state of the pipeline stages.
+ */
+struct Pipeline {
+  std::mutex mutex;           //!< Guards the members below.
+  std::condition_variable cv; //!< Signals every change.
+  std::deque<uint64_t> ready; //!< Prefetched chunks awaiting compute.
+  std::vector<char> done;     //!< Computed chunks.
+  uint64_t written = 0;       //!< Chunks written back, in order.
+  bool stop = false;          //!< Set on the first error.
+  std::string error;          //!< The first error message.
+
+  /**
+   * @brief Records an error and stops every stage.
+   * @param what The message.
+   * @return Void.
+   */
+  void fail(const std::string &what) {
+    std::lock_guard lock(mutex);
+    if (!stop) {
+      stop = true;
+      error = what;
+    }
+    cv.notify_all();
+  }
+};
+
+/**
+ * @brief Evaluates every frame of the input into the output.
+ * @param opts The settings.
+ * @param evaluators Creates the evaluator of each compute thread.
+ * @return Zero on success.
+ */
+int run(const Options &opts, const EvaluatorFactory &evaluators) {
+  const FrameFile in = FrameFile::open(opts.input);
+  if (!in.has(rgpot::frames::Positions)) {
+    throw std::runtime_error(opts.input + " holds no positions");
+  }
+  const size_t natoms = in.natoms();
+  const uint64_t nframes = in.nframes();
+  uint32_t fields = rgpot::frames::Energies | rgpot::frames::Forces;
+  if (opts.keep_positions) {
+    fields |= rgpot::frames::Positions;
+  }
+  const FrameFile out = FrameFile::create(opts.output, fields, natoms,
+                                          nframes, in.atmnrs(), in.box());
+
+  const size_t chunk = std::max<size_t>(1, opts.chunk);
+  const uint64_t nchunks = (nframes + chunk - 1) / chunk;
+  const size_t nthreads =
+      opts.threads != 0
+          ? opts.threads
+          : std::max<size_t>(1, std::thread::hardware_concurrency());
+  const uint64_t window = std::max<size_t>(1, opts.ahead) + nthreads;
+  auto count_of = [&](uint64_t c) {
+    return std::min<uint64_t>(chunk, nframes - c * chunk);
+  };
+
+  Pipeline pipe;
+  pipe.done.assign(nchunks, 0);
+  const auto t_begin = Clock::now();
+
+  std::thread prefetcher([&] {
+    for (uint64_t c = 0; c < nchunks; ++c) {
+      {
+        std::unique_lock lock(pipe.mutex);
+        pipe.cv.wait(lock,
+                     [&] { return pipe.stop || c < pipe.written + window; });
+        if (pipe.stop) {
+          return;
+        }
+      }
+      in.prefetch(c * chunk, count_of(c));
+      std::lock_guard lock(pipe.mutex);
+      pipe.ready.push_back(c);
+      pipe.cv.notify_all();
+    }
+  });
+
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < nthreads; ++t) {
+    workers.emplace_back([&] {
+      try {
+        const ChunkFn evaluate = evaluators();
+        const std::vector<double> box(in.box(), in.box() + 9);
+        std::vector<double> boxes;
+        while (true) {
+          uint64_t c = 0;
+          {
+            std::unique_lock lock(pipe.mutex);
+            pipe.cv.wait(lock, [&] {
+              return pipe.stop || !pipe.ready.empty() ||
+                     pipe.written == nchunks;
+            });
+            if (pipe.stop || pipe.ready.empty()) {
+              return;
+            }
+            c = pipe.ready.front();
+            pipe.ready.pop_front();
+          }
+          const uint64_t first = c * chunk;
+          const size_t count = count_of(c);
+          while (boxes.size() < count * 9) {
+            boxes.insert(boxes.end(), box.begin(), box.end());
+          }
+          evaluate(count, natoms, in.positions(first), in.atmnrs(),
+                   boxes.data(), out.energies(first), out.forces(first));
+          if (opts.keep_positions) {
+            std::memcpy(out.positions(first), in.positions(first),
+                        count * natoms * 3 * sizeof(double));
+          }
+          std::lock_guard lock(pipe.mutex);
+          pipe.done[c] = 1;
+          pipe.cv.notify_all();
+        }
+      } catch (const std::exception &e) {
+        pipe.fail(e.what());
+      }
+    });
+  }
+
+  try {
+    // Write back the completed prefix of chunks as it grows
+    std::unique_lock lock(pipe.mutex);
+    while (pipe.written < nchunks) {
+      pipe.cv.wait(lock,
+                   [&] { return pipe.stop || pipe.done[pipe.written]; });
+      if (pipe.stop) {
+        break;
+      }
+      const uint64_t c = pipe.written;
+      lock.unlock();
+      out.flush(c * chunk, count_of(c), false);
+      in.evict(c * chunk, count_of(c));
+      lock.lock();
+      ++pipe.written;
+      pipe.cv.notify_all();
+    }
+  } catch (const std::exception &e) {
+    pipe.fail(e.what());
+  }
+  prefetcher.join();
+  for (auto &w : workers) {
+    w.join();
+  }
+  if (pipe.stop) {
+    std::cerr << "potframes: " << pipe.error << std::endl;
+    return 1;
+  }
+  out.flush(0, nframes, true);
+
+  const double seconds =
+      std::chrono::duration<double>(Clock::now() - t_begin).count();
+  std::cout << std::fixed << std::setprecision(3) << "potframes: "
+            << nframes << " frame(s) of " << natoms << " atoms in "
+            << seconds << " s, " << std::setprecision(1)
+            << (seconds > 0.0 ? nframes / seconds : 0.0) << " frames/s on "
+            << nthreads << " thread(s)" << std::endl;
+  return 0;
+}
+
+/**
+ * @brief Prints the command line help.
+ * @param argv0 Name of the executable.
+ * @return Void.
+ */
+void usage(const char *argv0) {
+  std::cerr
+      << "Usage: " << argv0 << " [options] INPUT OUTPUT\n"
+      << "       " << argv0 << " --convert IN.con OUTPUT\n"
+      << "Evaluates every frame of the frame file INPUT into OUTPUT.\n"
+      << "  --pot TYPE        potential, LJ by default, one of\n"
+      << "                    "
+      << rgpot::PotentialRegistry::global().describe() << "\n"
+#ifdef RGPOT_HAS_RPC
+      << "  --remote ADDRESS  evaluate on potserv endpoints instead\n"
+      << "  --port N          port of endpoints without one (12345)\n"
+#endif // RGPOT_HAS_RPC
+      << "  --threads N       compute threads, 0 for every core (0)\n"
+      << "  --chunk N         frames per chunk (64)\n"
+      << "  --ahead N         chunks read ahead (4)\n"
+      << "  --no-positions    leave the positions out of OUTPUT\n";
+}
+
+/**
+ * @brief Consumes the value of an option.
+ * @param name The option.
+ * @param i Index of the current argument, advanced past the value.
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @param value Receives the value.
+ * @return True if argument @a i is @a name.
+ */
+bool take_option(const char *name, int &i, int argc, char *argv[],
+                 std::string &value) {
+  if (std::strcmp(argv[i], name) != 0) {
+    return false;
+  }
+  if (i + 1 >= argc) {
+    throw std::invalid_argument("missing value");
+  }
+  value = argv[++i];
+  return true;
+}
+
+} // namespace
+
+/**
+ * @brief Entry point of the batch driver.
+ * @param argc Argument count.
+ * @param argv Argument vector.
+ * @return Exit status.
+ */
+int main(int argc, char *argv[]) {
+  Options opts;
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; ++i) {
+    std::string value;
+    try {
+      if (take_option("--pot", i, argc, argv, value)) {
+        opts.pot = value;
+#ifdef RGPOT_HAS_RPC
+      } else if (take_option("--remote", i, argc, argv, value)) {
+        opts.remote = value;
+      } else if (take_option("--port", i, argc, argv, value)) {
+        opts.port = std::stoi(value);
+#endif // RGPOT_HAS_RPC
+      } else if (take_option("--threads", i, argc, argv, value)) {
+        opts.threads = std::stoul(value);
+      } else if (take_option("--chunk", i, argc, argv, value)) {
+        opts.chunk = std::stoul(value);
+      } else if (take_option("--ahead", i, argc, argv, value)) {
+        opts.ahead = std::stoul(value);
+      } else if (std::strcmp(argv[i], "--no-positions") == 0) {
+        opts.keep_positions = false;
+      } else if (std::strcmp(argv[i], "--convert") == 0) {
+        opts.convert = true;
+      } else if (argv[i][0] == '-') {
+        usage(argv[0]);
+        return 1;
+      } else {
+        positional.emplace_back(argv[i]);
+      }
+    } catch (const std::exception &e) {
+      std::cerr << "Invalid argument '" << argv[i] << "': " << e.what()
+                << std::endl;
+      return 1;
+    }
+  }
+  if (positional.size() != 2) {
+    usage(argv[0]);
+    return 1;
+  }
+  opts.input = positional[0];
+  opts.output = positional[1];
+
+  try {
+    if (opts.convert) {
+      convert(opts);
+      return 0;
+    }
+#ifdef RGPOT_HAS_RPC
+    if (!opts.remote.empty()) {
+      return run(opts, remote_evaluators(opts.remote, opts.port));
+    }
+#endif // RGPOT_HAS_RPC
+    return run(opts, local_evaluators(opts.pot));
+  } catch (const std::exception &e) {
+    std::cerr << "potframes: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,72 @@
+#pragma once
+// MIT License
+// Copyright 2023--present rgpot developers
+
+/**
+ * @file device.hpp
+ * @author rgpot Developers
+ * @date 2026-10-14
+ * @brief Registers the device-to-host copy used by the RPC layer.
+ *
+ * Local calculations never copy device tensors.  The RPC client has to
+ * serialize its inputs, so it stages tensors that live on a GPU through a
+ * copy function registered once per process with @c set_device_copy().
+ *
+ * # Example
+ * @code
+ * rgpot::set_device_copy<&rgpot::gpu_copy_to_host>();
+ * @endcode
+ *
+ * @ingroup rgpot_cpp
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rgpot.h"
+
+namespace rgpot {
+
+namespace details {
+
+/**
+ * @brief C callback forwarding a device copy to a C++ function.
+ * @tparam Copy Function @c (dst, src, bytes, device_id) throwing on
+ *         failure.
+ * @param dst Host destination.
+ * @param src Device source.
+ * @param bytes Number of bytes.
+ * @param device Device of @a src.
+ * @return @c RGPOT_SUCCESS or @c RGPOT_INTERNAL_ERROR.
+ */
+template <auto Copy>
+rgpot_status_t device_copy_trampoline(void *dst, const void *src,
+                                      uintptr_t bytes,
+                                      DLDevice device) noexcept {
+  try {
+    Copy(dst, src, static_cast<size_t>(bytes), device.device_id);
+    return RGPOT_SUCCESS;
+  } catch (...) {
+    return RGPOT_INTERNAL_ERROR;
+  }
+}
+
+} // namespace details
+
+/**
+ * @brief Registers the device-to-host copy of the RPC layer.
+ * @tparam Copy Function @c (dst, src, bytes, device_id) throwing on
+ *         failure, such as @c rgpot::gpu_copy_to_host.
+ * @return Void.
+ */
+template <auto Copy> void set_device_copy() {
+  rgpot_device_copy_set(&details::device_copy_trampoline<Copy>);
+}
+
+/**
+ * @brief Removes the registered device-to-host copy.
+ * @return Void.
+ */
+inline void clear_device_copy() { rgpot_device_copy_set(nullptr); }
+
+} // namespace rgpot
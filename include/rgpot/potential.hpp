@@ -18,8 +18,11 @@
  * - @c from_impl<Impl>() — wraps an existing C++ potential whose
  *   @c forceImpl() uses the legacy @c ForceInput / @c ForceOut structs
  *   (defined in @c ForceStructs.hpp).  A template trampoline extracts
- *   raw CPU pointers from the DLPack tensors and creates an owning DLPack
- *   forces tensor from the legacy output.
+ *   raw CPU pointers from the DLPack tensors and writes the forces into a
+ *   preset forces tensor, or creates an owning one from the legacy output.
+ * - @c from_device_impl<Impl>() — wraps a potential computing on a GPU,
+ *   such as @c LJGpuPot, handing it the device pointers of the input
+ *   tensors and returning device-resident forces without host copies.
  * - @c from_callback() — registers a bare C function pointer directly.
  *
  * # Example
@@ -34,13 +37,21 @@
  *
  * auto result = pot.calculate(input);
  * double energy = result.energy();
+ *
+ * // MD loops: update pos in place and reuse the input and the result
+ * double forces[6];
+ * rgpot::CalcResult step(forces, 2);
+ * pot.calculate_into(input, step);
  * @endcode
  *
  * @ingroup rgpot_cpp
  */
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <stdexcept>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -126,13 +137,39 @@ public:
     return result;
   }
 
+  /**
+   * @brief Perform a calculation into an existing result.
+   *
+   * The forces tensor already held by @a result is passed to the callback,
+   * which may fill it in place; the trampoline of @c from_impl() does so
+   * whenever the tensor is a writable @c [n_atoms, 3] f64 CPU tensor.  A
+   * callback that sets a new tensor instead replaces, and frees, the old
+   * one.  Reusing one @c InputSpec and one @c CalcResult thus keeps a
+   * calculation loop free of heap allocations after the first step.
+   *
+   * @param input The atomic configuration to evaluate.
+   * @param result Receives energy, variance, and forces.
+   * @return Void.
+   * @throws rgpot::Error when the underlying callback reports failure.
+   */
+  void calculate_into(const InputSpec &input, CalcResult &result) {
+    auto &output = result.c_struct();
+    DLManagedTensorVersioned *previous = output.forces;
+    auto status =
+        rgpot_potential_calculate(handle_, &input.c_struct(), &output);
+    if (previous && output.forces != previous) {
+      rgpot_tensor_free(previous);
+    }
+    details::check_status(status);
+  }
+
   /**
    * @brief Create a handle from a legacy C++ potential implementation.
    *
    * Registers a template trampoline that extracts raw CPU pointers from
    * the DLPack tensors in @c rgpot_force_input_t, constructs legacy
    * @c ForceInput / @c ForceOut types for @a Impl::forceImpl(), and
-   * wraps the resulting forces in an owning DLPack tensor.
+   * writes the forces into a preset tensor or an owning DLPack tensor.
    *
    * The caller retains ownership of @a impl and @b must keep it alive
    * for the lifetime of the returned handle.
@@ -150,6 +187,37 @@ public:
     return PotentialHandle(handle);
   }
 
+  /**
+   * @brief Create a handle from a potential computing on device memory.
+   *
+   * Registers a trampoline that passes the data pointers of the DLPack
+   * tensors straight to @a Impl::deviceForceImpl(), so positions and
+   * forces never leave the device.  Positions and box must live on the
+   * device of @a impl, otherwise the calculation fails with
+   * @c RGPOT_INVALID_PARAMETER.  Forces are written into a preset forces
+   * tensor on that device, or into a buffer of @a Impl::device_alloc()
+   * handed to the caller as an owning tensor.  Only RPC calls, which
+   * serialize the data, copy it to the host.
+   *
+   * The caller retains ownership of @a impl and @b must keep it alive
+   * for the lifetime of the returned handle.
+   *
+   * @tparam Impl A type with
+   *         @c void @c deviceForceImpl(const @c ForceInput&, @c ForceOut*),
+   *         @c device_id(), @c dlpack_device_type(),
+   *         @c device_alloc(size_t) and a static @c device_free(void*).
+   * @param impl Reference to the device potential.
+   * @return A new @c PotentialHandle wrapping @a impl.
+   */
+  template <typename Impl>
+  static PotentialHandle from_device_impl(Impl &impl) {
+    auto *handle = rgpot_potential_new(&device_trampoline_callback<Impl>,
+                                       static_cast<void *>(&impl),
+                                       nullptr // caller owns impl
+    );
+    return PotentialHandle(handle);
+  }
+
   /**
    * @brief Create a handle from an explicit C callback and user data.
    *
@@ -182,14 +250,44 @@ private:
   rgpot_potential_t *handle_; //!< Owned opaque handle (may be @c nullptr
                               //!< after move).
 
+  /**
+   * @brief Returns the data of a forces tensor that can be written in place.
+   * @param tensor The preset forces tensor, may be @c nullptr.
+   * @param n_atoms Number of atoms of the configuration.
+   * @param device Device the forces are computed on.
+   * @return Pointer to @a n_atoms * 3 contiguous doubles, or @c nullptr
+   *         unless @a tensor is a writable, row-major @c [n_atoms, 3] f64
+   *         tensor on @a device.
+   */
+  static double *writable_forces(DLManagedTensorVersioned *tensor,
+                                 size_t n_atoms, DLDevice device) {
+    if (!tensor || (tensor->flags & DLPACK_FLAG_BITMASK_READ_ONLY)) {
+      return nullptr;
+    }
+    const DLTensor &t = tensor->dl_tensor;
+    if (t.device.device_type != device.device_type ||
+        t.device.device_id != device.device_id || t.dtype.code != kDLFloat ||
+        t.dtype.bits != 64 || t.dtype.lanes != 1 || t.ndim != 2 ||
+        t.shape[0] != static_cast<int64_t>(n_atoms) || t.shape[1] != 3) {
+      return nullptr;
+    }
+    if (t.strides && (t.strides[0] != 3 || t.strides[1] != 1)) {
+      return nullptr;
+    }
+    return reinterpret_cast<double *>(static_cast<char *>(t.data) +
+                                      t.byte_offset);
+  }
+
   /**
    * @brief Template trampoline bridging DLPack-based C ABI types to legacy
    *        C++ types.
    *
-   * 1. Extracts raw CPU pointers from DLPack tensors in the input.
+   * 1. Extracts raw CPU pointers from DLPack tensors in the input, which
+   *    have to be readable from the host.
    * 2. Constructs legacy @c ForceInput and @c ForceOut.
-   * 3. Calls @c Impl::forceImpl().
-   * 4. Wraps the output forces in an owning DLPack tensor via
+   * 3. Calls @c Impl::forceImpl(), directly on the data of a preset
+   *    forces tensor when @c writable_forces() accepts it.
+   * 4. Otherwise wraps the output forces in an owning DLPack tensor via
    *    @c rgpot_tensor_owned_cpu_f64_2d() (since the local
    *    @c std::vector goes out of scope).
    *
@@ -197,7 +295,8 @@ private:
    * @param user_data Pointer to the @a Impl instance (cast from @c void*).
    * @param input     Pointer to the C input struct (DLPack tensors).
    * @param output    Pointer to the C output struct.
-   * @return @c RGPOT_SUCCESS or @c RGPOT_INTERNAL_ERROR.
+   * @return @c RGPOT_SUCCESS, @c RGPOT_INVALID_PARAMETER or
+   *         @c RGPOT_INTERNAL_ERROR.
    */
   template <typename Impl>
   static rgpot_status_t trampoline_callback(void *user_data,
@@ -211,6 +310,9 @@ private:
         return RGPOT_INVALID_PARAMETER;
       }
       auto *pos_tensor = &input->positions->dl_tensor;
+      if (!details::host_accessible(pos_tensor->device)) {
+        return RGPOT_INVALID_PARAMETER; // Use from_device_impl instead
+      }
       size_t n_atoms = static_cast<size_t>(pos_tensor->shape[0]);
 
       // Extract raw CPU pointers from DLPack tensors
@@ -228,9 +330,18 @@ private:
       ::rgpot::ForceInput fi{
           .nAtoms = n_atoms, .pos = pos, .atmnrs = atmnrs, .box = box};
 
-      // Temporary buffer for forces
-      std::vector<double> forces(n_atoms * 3, 0.0);
-      ::rgpot::ForceOut fo{.F = forces.data(), .energy = 0.0, .variance = 0.0};
+      // Write in place when the caller preset a usable forces tensor
+      double *in_place =
+          writable_forces(output->forces, n_atoms, DLDevice{kDLCPU, 0});
+      std::vector<double> forces;
+      if (in_place) {
+        std::fill(in_place, in_place + n_atoms * 3, 0.0);
+      } else {
+        forces.assign(n_atoms * 3, 0.0);
+      }
+      ::rgpot::ForceOut fo{.F = in_place ? in_place : forces.data(),
+                           .energy = 0.0,
+                           .variance = 0.0};
 
       self->forceImpl(fi, &fo);
 
@@ -239,15 +350,190 @@ private:
 
       // Create an owning DLPack tensor that copies the forces data.
       // This is necessary because `forces` is a local vector that goes
-      // out of scope when this function returns.
-      output->forces = rgpot_tensor_owned_cpu_f64_2d(
-          forces.data(), static_cast<int64_t>(n_atoms), 3);
+      // out of scope when this function returns.  A preset tensor that was
+      // not usable stays owned by the caller.
+      if (!in_place) {
+        output->forces = rgpot_tensor_owned_cpu_f64_2d(
+            forces.data(), static_cast<int64_t>(n_atoms), 3);
+      }
 
       return RGPOT_SUCCESS;
     } catch (...) {
       return RGPOT_INTERNAL_ERROR;
     }
   }
+
+  /**
+   * @brief Returns the data of an input tensor on a given device.
+   *
+   * The device kernels index the data as a packed array of @a T, so the
+   * tensor must hold single-lane f64 (@c double) or i32 (@c int) elements
+   * and, when it carries strides, be contiguous in row-major order.
+   *
+   * @tparam T Element type of the tensor, @c double or @c int.
+   * @param tensor The input tensor, may be @c nullptr.
+   * @param device Device the data has to live on.
+   * @param n_elements Number of elements the tensor must hold.
+   * @return Pointer to the first element, or @c nullptr if @a tensor is
+   *         missing, on another device, of another dtype or size, or not
+   *         contiguous.
+   */
+  template <typename T>
+  static const T *device_data(const DLManagedTensorVersioned *tensor,
+                              DLDevice device, size_t n_elements) {
+    static_assert(std::is_same_v<T, double> ||
+                      (std::is_same_v<T, int> && sizeof(int) == 4),
+                  "Device tensors hold f64 or i32 elements");
+    constexpr uint8_t code = std::is_same_v<T, double> ? kDLFloat : kDLInt;
+    if (!tensor) {
+      return nullptr;
+    }
+    const DLTensor &t = tensor->dl_tensor;
+    if (t.device.device_type != device.device_type ||
+        t.device.device_id != device.device_id || t.dtype.code != code ||
+        t.dtype.bits != 8 * sizeof(T) || t.dtype.lanes != 1 || t.ndim < 1) {
+      return nullptr;
+    }
+    int64_t packed = 1;
+    for (int d = t.ndim - 1; d >= 0; --d) {
+      // Strides of extent-one dimensions are never used to step
+      if (t.strides && t.shape[d] != 1 && t.strides[d] != packed) {
+        return nullptr;
+      }
+      packed *= t.shape[d];
+    }
+    if (packed != static_cast<int64_t>(n_elements)) {
+      return nullptr;
+    }
+    return reinterpret_cast<const T *>(static_cast<const char *>(t.data) +
+                                       t.byte_offset);
+  }
+
+  /**
+   * @brief Owning DLPack tensor around a device force buffer.
+   *
+   * The tensor points to its own shape and strides, and its deleter
+   * releases the buffer with @c Impl::device_free().
+   */
+  struct DeviceForces {
+    DLManagedTensorVersioned managed; //!< The exported tensor.
+    int64_t shape[2];                 //!< @c [n_atoms, 3].
+    int64_t strides[2];               //!< Row-major strides.
+  };
+
+  /**
+   * @brief Deleter of @c DeviceForces tensors.
+   * @tparam Impl The device potential that allocated the buffer.
+   * @param self The tensor to release.
+   * @return Void.
+   */
+  template <typename Impl>
+  static void device_forces_deleter(DLManagedTensorVersioned *self) {
+    Impl::device_free(self->dl_tensor.data);
+    delete static_cast<DeviceForces *>(self->manager_ctx);
+  }
+
+  /**
+   * @brief Wraps a device force buffer in an owning DLPack tensor.
+   * @tparam Impl The device potential that allocated @a data.
+   * @param data Buffer of @a n_atoms * 3 doubles, owned by the result.
+   * @param n_atoms Number of atoms.
+   * @param device Device holding @a data.
+   * @return The tensor, released with @c rgpot_tensor_free().
+   */
+  template <typename Impl>
+  static DLManagedTensorVersioned *
+  owned_device_forces(double *data, size_t n_atoms, DLDevice device) {
+    auto *owner = new DeviceForces{};
+    owner->shape[0] = static_cast<int64_t>(n_atoms);
+    owner->shape[1] = 3;
+    owner->strides[0] = 3;
+    owner->strides[1] = 1;
+    DLManagedTensorVersioned &m = owner->managed;
+    m.version = {1, 0};
+    m.manager_ctx = owner;
+    m.deleter = &device_forces_deleter<Impl>;
+    m.flags = 0;
+    m.dl_tensor = DLTensor{.data = data,
+                           .device = device,
+                           .ndim = 2,
+                           .dtype = {kDLFloat, 64, 1},
+                           .shape = owner->shape,
+                           .strides = owner->strides,
+                           .byte_offset = 0};
+    return &m;
+  }
+
+  /**
+   * @brief Template trampoline handing device tensors to a device
+   *        potential.
+   *
+   * 1. Checks with @c device_data() that positions, box and, when given,
+   *    atomic numbers are packed tensors of the expected dtype and size on
+   *    the device of the @a Impl instance, and passes their data pointers
+   *    on as a legacy @c ForceInput. Anything else is rejected with
+   *    @c RGPOT_INVALID_PARAMETER.
+   * 2. Calls @c Impl::deviceForceImpl() on the data of a preset forces
+   *    tensor when @c writable_forces() accepts it for that device.
+   * 3. Otherwise computes into a buffer of @c Impl::device_alloc() and
+   *    returns it as an owning tensor on the device.
+   *
+   * @tparam Impl The concrete device potential type.
+   * @param user_data Pointer to the @a Impl instance (cast from @c void*).
+   * @param input     Pointer to the C input struct (DLPack tensors).
+   * @param output    Pointer to the C output struct.
+   * @return @c RGPOT_SUCCESS, @c RGPOT_INVALID_PARAMETER or
+   *         @c RGPOT_INTERNAL_ERROR.
+   */
+  template <typename Impl>
+  static rgpot_status_t
+  device_trampoline_callback(void *user_data, const rgpot_force_input_t *input,
+                             rgpot_force_out_t *output) {
+    try {
+      auto *self = static_cast<Impl *>(user_data);
+      const DLDevice device{
+          static_cast<DLDeviceType>(self->dlpack_device_type()),
+          self->device_id()};
+      if (!input->positions || input->positions->dl_tensor.ndim != 2 ||
+          input->positions->dl_tensor.shape[1] != 3) {
+        return RGPOT_INVALID_PARAMETER;
+      }
+      size_t n_atoms =
+          static_cast<size_t>(input->positions->dl_tensor.shape[0]);
+      const double *pos =
+          device_data<double>(input->positions, device, n_atoms * 3);
+      const double *box = device_data<double>(input->box_matrix, device, 9);
+      const int *atmnrs =
+          device_data<int>(input->atomic_numbers, device, n_atoms);
+      if (!pos || !box || (input->atomic_numbers && !atmnrs)) {
+        return RGPOT_INVALID_PARAMETER;
+      }
+
+      ::rgpot::ForceInput fi{
+          .nAtoms = n_atoms, .pos = pos, .atmnrs = atmnrs, .box = box};
+
+      double *in_place = writable_forces(output->forces, n_atoms, device);
+      double *forces = in_place ? in_place : self->device_alloc(n_atoms * 3);
+      ::rgpot::ForceOut fo{.F = forces, .energy = 0.0, .variance = 0.0};
+      try {
+        self->deviceForceImpl(fi, &fo);
+        if (!in_place) {
+          output->forces = owned_device_forces<Impl>(forces, n_atoms, device);
+        }
+      } catch (...) {
+        if (!in_place) {
+          Impl::device_free(forces);
+        }
+        throw;
+      }
+
+      output->energy = fo.energy;
+      output->variance = fo.variance;
+      return RGPOT_SUCCESS;
+    } catch (...) {
+      return RGPOT_INTERNAL_ERROR;
+    }
+  }
 };
 
 } // namespace rgpot
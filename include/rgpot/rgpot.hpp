@@ -24,6 +24,7 @@
  * whenever the underlying C API returns a non-success status code.
  */
 
+#include "rgpot/device.hpp"
 #include "rgpot/errors.hpp"
 #include "rgpot/potential.hpp"
 #include "rgpot/types.hpp"
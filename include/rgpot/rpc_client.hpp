@@ -10,9 +10,10 @@
  *
  * Provides @c rgpot::RpcClient, a thin C++ handle that connects to a
  * remote rgpot server and proxies @c calculate() calls over Cap'n Proto
- * RPC.  The class is only available when the Rust core is compiled with
- * the @c rpc feature (the @c RGPOT_HAS_RPC preprocessor macro is defined
- * in the auto-generated @c rgpot.h header).
+ * RPC, and @c rgpot::RpcClientPool, which shares several such connections
+ * between threads.  The classes are only available when the Rust core is
+ * compiled with the @c rpc feature (the @c RGPOT_HAS_RPC preprocessor
+ * macro is defined in the auto-generated @c rgpot.h header).
  *
  * # Example
  * @code
@@ -33,6 +34,7 @@
  */
 
 #include <string>
+#include <vector>
 
 #include "rgpot.h"
 #include "rgpot/errors.hpp"
@@ -48,18 +50,23 @@ namespace rgpot {
  * @ingroup rgpot_cpp
  *
  * Owns an opaque RPC client handle allocated by the Rust core.  The
- * connection is established during construction and torn down on
+ * connection is opened on the first call, reused for every later call
+ * (reconnecting once if the server dropped it), and torn down on
  * destruction via @c rgpot_rpc_client_free().  The class is non-copyable;
- * move semantics transfer ownership of the connection.
+ * move semantics transfer ownership of the connection.  A single client
+ * must not be used from several threads at once; see @c RpcClientPool.
  */
 class RpcClient final {
 public:
   /**
    * @brief Connect to a remote rgpot server.
    *
-   * Calls @c rgpot_rpc_client_new() and throws on failure.
+   * Calls @c rgpot_rpc_client_new() and throws on failure.  @a host may
+   * list several comma-separated endpoints (@c HOST, @c HOST:PORT or
+   * @c unix:PATH); each call then goes to the least loaded one and fails
+   * over to the others when it is unreachable.
    *
-   * @param host Hostname or IP address of the server.
+   * @param host Hostname or IP address of the server, or an endpoint list.
    * @param port TCP port the server listens on.
    * @throws rgpot::Error if the connection cannot be established.
    */
@@ -128,10 +135,137 @@ public:
     return result;
   }
 
+  /**
+   * @brief Perform several remote calculations in one round trip.
+   *
+   * Sends all configurations in a single @c calculateBatch request, which
+   * the server may evaluate concurrently.
+   *
+   * @param inputs The atomic configurations to evaluate.
+   * @return One @c CalcResult per input, in input order.
+   * @throws rgpot::Error on RPC transport or server-side failure.
+   */
+  std::vector<CalcResult>
+  calculate_batch(const std::vector<InputSpec> &inputs) {
+    std::vector<rgpot_force_input_t> c_inputs;
+    c_inputs.reserve(inputs.size());
+    for (const auto &input : inputs) {
+      c_inputs.push_back(input.c_struct());
+    }
+    std::vector<rgpot_force_out_t> c_outputs(inputs.size(),
+                                             rgpot_force_out_create());
+    auto status = rgpot_rpc_calculate_batch(handle_, c_inputs.size(),
+                                            c_inputs.data(), c_outputs.data());
+
+    // Take ownership of the returned tensors (all NULL on failure)
+    std::vector<CalcResult> results(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      results[i].c_struct() = c_outputs[i];
+    }
+    details::check_status(status);
+    return results;
+  }
+
 private:
   rgpot_rpc_client_t *handle_ = nullptr; //!< Owned opaque RPC client handle.
 };
 
+/**
+ * @class RpcClientPool
+ * @brief Move-only RAII wrapper around @c rgpot_rpc_pool_t.
+ * @ingroup rgpot_cpp
+ *
+ * Owns a fixed number of persistent connections to one server, or to
+ * each server of an endpoint list.  Unlike @c RpcClient, @c calculate()
+ * may be called from several threads at once; each call is served by the
+ * next free connection, on the endpoint with the fewest requests in
+ * flight.
+ */
+class RpcClientPool final {
+public:
+  /**
+   * @brief Create a pool of connections to a remote rgpot server.
+   * @param host Hostname or IP address of the server, or an endpoint list.
+   * @param port TCP port the server listens on.
+   * @param size Number of connections, at least one.
+   * @throws rgpot::Error if the pool cannot be created.
+   */
+  RpcClientPool(const std::string &host, uint16_t port, size_t size) {
+    handle_ = rgpot_rpc_pool_new(host.c_str(), port, size);
+    if (!handle_) {
+      const char *msg = rgpot_last_error();
+      throw Error(msg ? msg : "failed to create RPC connection pool");
+    }
+  }
+
+  /**
+   * @brief Destructor — closes every connection in the pool.
+   *
+   * Safe to call on a moved-from handle (internal pointer is @c nullptr).
+   */
+  ~RpcClientPool() {
+    if (handle_) {
+      rgpot_rpc_pool_free(handle_);
+    }
+  }
+
+  /**
+   * @brief Move constructor — transfers pool ownership.
+   * @param other Pool to move from; left in a null state.
+   */
+  RpcClientPool(RpcClientPool &&other) noexcept : handle_(other.handle_) {
+    other.handle_ = nullptr;
+  }
+
+  /**
+   * @brief Move assignment — releases the current pool, transfers ownership.
+   * @param other Pool to move from; left in a null state.
+   * @return Reference to @c *this.
+   */
+  RpcClientPool &operator=(RpcClientPool &&other) noexcept {
+    if (this != &other) {
+      if (handle_) {
+        rgpot_rpc_pool_free(handle_);
+      }
+      handle_ = other.handle_;
+      other.handle_ = nullptr;
+    }
+    return *this;
+  }
+
+  RpcClientPool(const RpcClientPool &) = delete;
+  RpcClientPool &operator=(const RpcClientPool &) = delete;
+
+  /**
+   * @brief Perform a remote force/energy calculation on a free connection.
+   * @param input The atomic configuration to evaluate.
+   * @return A @c CalcResult containing energy, variance, and forces.
+   * @throws rgpot::Error on RPC transport or server-side failure.
+   */
+  CalcResult calculate(const InputSpec &input) const {
+    CalcResult result;
+    auto status = rgpot_rpc_pool_calculate(handle_, &input.c_struct(),
+                                           &result.c_struct());
+    details::check_status(status);
+    return result;
+  }
+
+  /**
+   * @brief Cap the requests kept in flight on each endpoint.
+   *
+   * Calls wait for a free endpoint once all are at the cap.
+   *
+   * @param limit Requests per endpoint, 0 (the default) for no cap.
+   * @throws rgpot::Error on a moved-from pool.
+   */
+  void set_endpoint_limit(size_t limit) const {
+    details::check_status(rgpot_rpc_pool_set_endpoint_limit(handle_, limit));
+  }
+
+private:
+  rgpot_rpc_pool_t *handle_ = nullptr; //!< Owned opaque pool handle.
+};
+
 } // namespace rgpot
 
 #endif // RGPOT_HAS_RPC
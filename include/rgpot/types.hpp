@@ -10,11 +10,13 @@
  *
  * Provides two thin wrappers for the C structs generated by cbindgen:
  *
- * - @c InputSpec : manages DLPack tensor creation from raw CPU arrays.
- *   Move-only; frees the non-owning tensor metadata on destruction.
+ * - @c InputSpec : manages DLPack tensor creation from raw host or device
+ *   arrays.  Move-only; frees the non-owning tensor metadata on
+ *   destruction.
  * - @c CalcResult : receives the force tensor (DLPack) set by the callback
- *   and provides accessors for energy, variance, and CPU force data.
- *   Move-only; frees the owning forces tensor on destruction.
+ *   and provides accessors for energy, variance, and host force data.
+ *   Move-only; frees the forces tensor on destruction.  A result can be
+ *   reused, or wrap a caller buffer, to keep the same tensor across calls.
  *
  * These names are deliberately different from the legacy @c rgpot::ForceInput
  * and @c rgpot::ForceOut defined in @c ForceStructs.hpp to avoid name
@@ -29,13 +31,29 @@
 #include <vector>
 
 #include "rgpot.h"
+#include "rgpot/errors.hpp"
 
 namespace rgpot {
 
+namespace details {
+
+/**
+ * @brief Checks whether the host can read memory of a device.
+ * @param device The DLPack device.
+ * @return True for host, pinned and managed memory.
+ */
+inline bool host_accessible(DLDevice device) {
+  return device.device_type == kDLCPU || device.device_type == kDLCUDAHost ||
+         device.device_type == kDLCUDAManaged ||
+         device.device_type == kDLROCMHost;
+}
+
+} // namespace details
+
 /**
  * @class InputSpec
  * @brief Move-only wrapper that creates non-owning DLPack tensors from raw
- *        CPU arrays.
+ *        host or device arrays.
  * @ingroup rgpot_cpp
  *
  * Wraps @c rgpot_force_input_t.  The constructor calls
@@ -80,6 +98,28 @@ public:
         input_(rgpot_force_input_create(positions.size() / 3, positions.data(),
                                         atmnrs.data(), box)) {}
 
+  /**
+   * @brief Construct from buffers in device memory (borrowed, not copied).
+   *
+   * No data is read here, so the buffers may live on a GPU; a potential
+   * created with @c PotentialHandle::from_device_impl() reads them in
+   * place.
+   *
+   * @param n_atoms Number of atoms in the configuration.
+   * @param pos     Device array @c [n_atoms*3], row-major xyz.
+   * @param atmnrs  Device array @c [n_atoms] of atomic numbers.
+   * @param box     Device 3x3 cell matrix @c [9], row-major.
+   * @param device  Device holding all three buffers, e.g. @c {kDLCUDA, 0}.
+   */
+  InputSpec(size_t n_atoms, double *pos, int *atmnrs, double *box,
+            DLDevice device)
+      : n_atoms_(n_atoms),
+        input_{rgpot_tensor_device_f64_2d(pos, static_cast<int64_t>(n_atoms),
+                                          3, device),
+               rgpot_tensor_device_i32_1d(
+                   atmnrs, static_cast<int64_t>(n_atoms), device),
+               rgpot_tensor_device_f64_2d(box, 3, 3, device)} {}
+
   ~InputSpec() { rgpot_force_input_free(&input_); }
 
   // Move-only
@@ -130,8 +170,9 @@ private:
  * set by the potential callback to an owning DLPack tensor.  The destructor
  * calls @c rgpot_tensor_free() to release the forces tensor.
  *
- * For CPU tensors, use @c forces_data() to access the raw pointer or
- * @c forces_vec() to copy forces into a @c std::vector<double>.
+ * For host tensors, use @c forces_data() to access the raw pointer or
+ * @c forces_vec() to copy forces into a @c std::vector<double>.  Forces
+ * computed on a GPU stay there; @c forces_device() tells them apart.
  */
 class CalcResult {
 public:
@@ -140,6 +181,31 @@ public:
    */
   CalcResult() : output_(rgpot_force_out_create()) {}
 
+  /**
+   * @brief Create a result whose forces are written into a caller buffer.
+   *
+   * Presets a borrowing forces tensor, which @c
+   * PotentialHandle::calculate_into() lets callbacks fill in place.  The
+   * buffer must outlive the result.
+   *
+   * @param forces Buffer of @a n_atoms * 3 doubles.
+   * @param n_atoms Number of atoms.
+   */
+  CalcResult(double *forces, size_t n_atoms)
+      : CalcResult(forces, n_atoms, DLDevice{kDLCPU, 0}) {}
+
+  /**
+   * @brief Create a result whose forces are written into a device buffer.
+   * @param forces Buffer of @a n_atoms * 3 doubles in memory of @a device.
+   * @param n_atoms Number of atoms.
+   * @param device Device holding @a forces, e.g. @c {kDLCUDA, 0}.
+   */
+  CalcResult(double *forces, size_t n_atoms, DLDevice device)
+      : output_(rgpot_force_out_create()) {
+    output_.forces = rgpot_tensor_device_f64_2d(
+        forces, static_cast<int64_t>(n_atoms), 3, device);
+  }
+
   ~CalcResult() {
     if (output_.forces) {
       rgpot_tensor_free(output_.forces);
@@ -183,9 +249,19 @@ public:
   double variance() const { return output_.variance; }
 
   /**
-   * @brief Returns a raw pointer to the forces data (CPU only).
+   * @brief Returns the device holding the forces.
+   * @return Device of the forces tensor, the host when there is none.
+   */
+  DLDevice forces_device() const {
+    return output_.forces ? output_.forces->dl_tensor.device
+                          : DLDevice{kDLCPU, 0};
+  }
+
+  /**
+   * @brief Returns a raw pointer to the forces data.
    *
-   * The returned pointer is valid for the lifetime of this CalcResult.
+   * The returned pointer is valid for the lifetime of this CalcResult.  It
+   * points to device memory when @c forces_device() is a GPU.
    *
    * @param n_elements Output: number of doubles in the forces array.
    * @return Raw pointer to the force data, or @c nullptr if no forces tensor.
@@ -206,8 +282,12 @@ public:
   /**
    * @brief Copy forces into a std::vector<double>.
    * @return Vector of forces [n_atoms * 3].
+   * @throws rgpot::Error when the forces are not readable from the host.
    */
   std::vector<double> forces_vec() const {
+    if (!details::host_accessible(forces_device())) {
+      throw Error("forces_vec: forces are in device memory");
+    }
     size_t n = 0;
     const double *data = forces_data(n);
     if (!data || n == 0) {
@@ -60,6 +60,13 @@ typedef struct PotentialImpl PotentialImpl;
 typedef struct RpcClient RpcClient;
 #endif
 
+#if defined(RGPOT_HAS_RPC)
+/**
+ * Fixed-size pool of RPC connections to one server.
+ */
+typedef struct RpcClientPool RpcClientPool;
+#endif
+
 /**
  * Input configuration for a potential energy evaluation.
  *
@@ -100,6 +107,12 @@ typedef struct rgpot_force_input_t {
  * a callee-allocated DLPack tensor.  After the call, the caller owns the
  * tensor and must free it via `rgpot_tensor_free`.
  *
+ * A caller may instead preset `forces` to a writable `[n_atoms, 3]` f64
+ * tensor, on the host or on the device the callback computes on, to reuse it
+ * across calls.  A callback may fill such a tensor in
+ * place and leave the pointer unchanged, or replace it like a `NULL` one, in
+ * which case the caller still owns and frees the preset tensor.
+ *
  * # Fields
  *
  * - `forces`: output force tensor, same shape/dtype as `positions`.
@@ -121,6 +134,16 @@ typedef struct rgpot_force_out_t {
   double variance;
 } rgpot_force_out_t;
 
+/**
+ * Function copying `bytes` bytes from memory of `device` to host memory.
+ *
+ * Returns `RGPOT_SUCCESS` once the data can be read at `dst`.
+ */
+typedef enum rgpot_status_t (*rgpot_device_copy_fn)(void *dst,
+                                                    const void *src,
+                                                    uintptr_t bytes,
+                                                    DLDevice device);
+
 /**
  * Opaque handle exposed to C as `rgpot_potential_t`.
  *
@@ -149,6 +172,13 @@ typedef enum rgpot_status_t (*PotentialCallback)(void *user_data,
 typedef struct RpcClient rgpot_rpc_client_t;
 #endif
 
+#if (defined(RGPOT_HAS_RPC) && defined(RGPOT_HAS_RPC))
+/**
+ * Opaque RPC connection pool handle.
+ */
+typedef struct RpcClientPool rgpot_rpc_pool_t;
+#endif
+
 /**
  * Create a non-owning 2-D f64 tensor on CPU wrapping an existing buffer.
  *
@@ -178,6 +208,30 @@ DLManagedTensorVersioned *rgpot_tensor_cpu_i32_1d(int *data, int64_t len);
  */
 DLManagedTensorVersioned *rgpot_tensor_cpu_f64_matrix3(double *data);
 
+/**
+ * Create a non-owning 2-D f64 tensor wrapping a buffer on `device`.
+ *
+ * Same as `rgpot_tensor_cpu_f64_2d` for memory that may live on a GPU,
+ * e.g. `{kDLCUDA, 0}`.  The data is never read by this call.
+ *
+ * # Safety
+ * `data` must point to at least `rows * cols` contiguous `f64` values in
+ * memory of `device`.
+ */
+DLManagedTensorVersioned *rgpot_tensor_device_f64_2d(double *data,
+                                                     int64_t rows,
+                                                     int64_t cols,
+                                                     DLDevice device);
+
+/**
+ * Create a non-owning 1-D i32 tensor wrapping a buffer on `device`.
+ *
+ * # Safety
+ * `data` must point to at least `len` contiguous `c_int` values in memory
+ * of `device`.
+ */
+DLManagedTensorVersioned *rgpot_tensor_device_i32_1d(int *data, int64_t len, DLDevice device);
+
 /**
  * Create an **owning** 2-D f64 tensor on CPU by copying data.
  *
@@ -229,6 +283,15 @@ const void *rgpot_tensor_data(const DLManagedTensorVersioned *tensor);
  */
 const int64_t *rgpot_tensor_shape(const DLManagedTensorVersioned *tensor, int32_t *ndim_out);
 
+/**
+ * Register the function that copies device tensors to the host.
+ *
+ * It is called only where host data is unavoidable, such as encoding an
+ * RPC request from GPU-resident positions.  Passing `NULL` removes it.
+ * The function may be called from any thread.
+ */
+void rgpot_device_copy_set(rgpot_device_copy_fn copy);
+
 /**
  * Retrieve a pointer to the last error message for the current thread.
  *
@@ -328,6 +391,12 @@ void rgpot_potential_free(rgpot_potential_t *pot);
 /**
  * Create a new RPC client connected to `host:port`.
  *
+ * `host` may also list several comma-separated endpoints, each
+ * `HOST`, `HOST:PORT` or `unix:PATH`; calls then go to the one with the
+ * fewest requests in flight and fail over when one is unreachable.  A
+ * host of `shm://NAME` uses the shared memory segment of a local
+ * `potserv --shm NAME` instead, and `port` is ignored.
+ *
  * Returns a heap-allocated handle, or `NULL` on failure.
  * The caller must eventually call `rgpot_rpc_client_free`.
  */
@@ -345,6 +414,21 @@ enum rgpot_status_t rgpot_rpc_calculate(rgpot_rpc_client_t *client,
                                         struct rgpot_force_out_t *output);
 #endif
 
+#if (defined(RGPOT_HAS_RPC) && defined(RGPOT_HAS_RPC))
+/**
+ * Perform several remote calculations in one round trip.
+ *
+ * `inputs` and `outputs` point to arrays of `n` elements; `outputs[i]`
+ * receives the result for `inputs[i]` and owns its force tensor afterwards.
+ *
+ * Returns `RGPOT_SUCCESS` on success, or an error status code.
+ */
+enum rgpot_status_t rgpot_rpc_calculate_batch(rgpot_rpc_client_t *client,
+                                              uintptr_t n,
+                                              const struct rgpot_force_input_t *inputs,
+                                              struct rgpot_force_out_t *outputs);
+#endif
+
 #if (defined(RGPOT_HAS_RPC) && defined(RGPOT_HAS_RPC))
 /**
  * Free an RPC client handle.
@@ -354,6 +438,70 @@ enum rgpot_status_t rgpot_rpc_calculate(rgpot_rpc_client_t *client,
 void rgpot_rpc_client_free(rgpot_rpc_client_t *client);
 #endif
 
+#if (defined(RGPOT_HAS_RPC) && defined(RGPOT_HAS_RPC))
+/**
+ * Create a pool of `size` RPC connections to `host:port`.
+ *
+ * Unlike a client handle, a pool may be shared between threads: each
+ * `rgpot_rpc_pool_calculate` call is served by the next free connection.
+ * `host` accepts the endpoint lists of `rgpot_rpc_client_new`, balanced
+ * over the whole pool.
+ * Returns a heap-allocated handle, or `NULL` on failure.
+ * The caller must eventually call `rgpot_rpc_pool_free`.
+ */
+rgpot_rpc_pool_t *rgpot_rpc_pool_new(const char *host, uint16_t port, uintptr_t size);
+#endif
+
+#if (defined(RGPOT_HAS_RPC) && defined(RGPOT_HAS_RPC))
+/**
+ * Perform a remote force/energy calculation on a pooled connection.
+ *
+ * Safe to call from several threads with the same `pool`; blocks until
+ * the result has been written to `output`.
+ *
+ * Returns `RGPOT_SUCCESS` on success, or an error status code.
+ */
+enum rgpot_status_t rgpot_rpc_pool_calculate(const rgpot_rpc_pool_t *pool,
+                                             const struct rgpot_force_input_t *input,
+                                             struct rgpot_force_out_t *output);
+#endif
+
+#if (defined(RGPOT_HAS_RPC) && defined(RGPOT_HAS_RPC))
+/**
+ * Cap the requests `pool` keeps in flight on each of its endpoints.
+ *
+ * Calls wait for a free endpoint once all are at the cap; 0, the default,
+ * removes it.
+ *
+ * Returns `RGPOT_SUCCESS`, or `RGPOT_INVALID_PARAMETER` for a `NULL` pool.
+ */
+enum rgpot_status_t rgpot_rpc_pool_set_endpoint_limit(const rgpot_rpc_pool_t *pool,
+                                                      uintptr_t limit);
+#endif
+
+#if (defined(RGPOT_HAS_RPC) && defined(RGPOT_HAS_RPC))
+/**
+ * Free an RPC connection pool, closing all of its connections.
+ *
+ * Must not be called while other threads are still using `pool`.
+ * If `pool` is `NULL`, this is a no-op.
+ */
+void rgpot_rpc_pool_free(rgpot_rpc_pool_t *pool);
+#endif
+
+/**
+ * Write the buffered trace spans of every thread to `path` as Chrome
+ * trace JSON, replacing the file if it exists.
+ *
+ * Safe to call while other threads keep recording.
+ *
+ * Returns `RGPOT_SUCCESS` on success, or an error status code.
+ *
+ * # Safety
+ * `path` must be a valid NUL-terminated string.
+ */
+enum rgpot_status_t rgpot_trace_dump(const char *path);
+
 #if defined(RGPOT_HAS_RPC)
 /**
  * Start an RPC server listening on `host:port`, dispatching to `pot`.
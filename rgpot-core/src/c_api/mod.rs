@@ -25,9 +25,13 @@
 //!   calculate, free.
 //! - [`rpc`] — RPC client functions (feature-gated on `rpc`): connect,
 //!   calculate, disconnect.
+//! - [`trace`] — Dump of the trace spans (recorded with the `trace`
+//!   feature).
 
 pub mod types;
 pub mod potential;
 
 #[cfg(feature = "rpc")]
 pub mod rpc;
+
+pub mod trace;
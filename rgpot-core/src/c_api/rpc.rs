@@ -4,8 +4,9 @@
 //! C API for the RPC client.
 //!
 //! Provides `rgpot_rpc_client_t` — an opaque handle wrapping the async
-//! Cap'n Proto RPC client — and functions to connect, calculate, and
-//! disconnect.
+//! Cap'n Proto RPC client — and functions to connect, calculate (one
+//! configuration or a batch), and disconnect.  `rgpot_rpc_pool_t` wraps a
+//! pool of such connections that several threads may call concurrently.
 
 #[cfg(feature = "rpc")]
 use std::os::raw::c_char;
@@ -13,6 +14,8 @@ use std::os::raw::c_char;
 #[cfg(feature = "rpc")]
 use crate::rpc::client::RpcClient;
 #[cfg(feature = "rpc")]
+use crate::rpc::pool::RpcClientPool;
+#[cfg(feature = "rpc")]
 use crate::status::{catch_unwind, rgpot_status_t, set_last_error};
 #[cfg(feature = "rpc")]
 use crate::types::{rgpot_force_input_t, rgpot_force_out_t};
@@ -21,8 +24,18 @@ use crate::types::{rgpot_force_input_t, rgpot_force_out_t};
 #[cfg(feature = "rpc")]
 pub type rgpot_rpc_client_t = RpcClient;
 
+/// Opaque RPC connection pool handle.
+#[cfg(feature = "rpc")]
+pub type rgpot_rpc_pool_t = RpcClientPool;
+
 /// Create a new RPC client connected to `host:port`.
 ///
+/// `host` may also list several comma-separated endpoints, each
+/// `HOST`, `HOST:PORT` or `unix:PATH`; calls then go to the one with the
+/// fewest requests in flight and fail over when one is unreachable.  A
+/// host of `shm://NAME` uses the shared memory segment of a local
+/// `potserv --shm NAME` instead, and `port` is ignored.
+///
 /// Returns a heap-allocated handle, or `NULL` on failure.
 /// The caller must eventually call `rgpot_rpc_client_free`.
 #[cfg(feature = "rpc")]
@@ -91,6 +104,51 @@ pub unsafe extern "C" fn rgpot_rpc_calculate(
     }))
 }
 
+/// Perform several remote calculations in one round trip.
+///
+/// `inputs` and `outputs` point to arrays of `n` elements; `outputs[i]`
+/// receives the result for `inputs[i]` and owns its force tensor afterwards.
+///
+/// Returns `RGPOT_SUCCESS` on success, or an error status code.
+#[cfg(feature = "rpc")]
+#[no_mangle]
+pub unsafe extern "C" fn rgpot_rpc_calculate_batch(
+    client: *mut rgpot_rpc_client_t,
+    n: usize,
+    inputs: *const rgpot_force_input_t,
+    outputs: *mut rgpot_force_out_t,
+) -> rgpot_status_t {
+    catch_unwind(std::panic::AssertUnwindSafe(|| {
+        if client.is_null() {
+            set_last_error("rgpot_rpc_calculate_batch: client is NULL");
+            return rgpot_status_t::RGPOT_INVALID_PARAMETER;
+        }
+        if n == 0 {
+            return rgpot_status_t::RGPOT_SUCCESS;
+        }
+        if inputs.is_null() {
+            set_last_error("rgpot_rpc_calculate_batch: inputs is NULL");
+            return rgpot_status_t::RGPOT_INVALID_PARAMETER;
+        }
+        if outputs.is_null() {
+            set_last_error("rgpot_rpc_calculate_batch: outputs is NULL");
+            return rgpot_status_t::RGPOT_INVALID_PARAMETER;
+        }
+
+        let client_ref = unsafe { &mut *client };
+        let inp = unsafe { std::slice::from_raw_parts(inputs, n) };
+        let out = unsafe { std::slice::from_raw_parts_mut(outputs, n) };
+
+        match client_ref.calculate_batch(inp, out) {
+            Ok(()) => rgpot_status_t::RGPOT_SUCCESS,
+            Err(e) => {
+                set_last_error(&format!("rgpot_rpc_calculate_batch: {e}"));
+                rgpot_status_t::RGPOT_RPC_ERROR
+            }
+        }
+    }))
+}
+
 /// Free an RPC client handle.
 ///
 /// If `client` is `NULL`, this is a no-op.
@@ -101,3 +159,113 @@ pub unsafe extern "C" fn rgpot_rpc_client_free(client: *mut rgpot_rpc_client_t)
         drop(unsafe { Box::from_raw(client) });
     }
 }
+
+/// Create a pool of `size` RPC connections to `host:port`.
+///
+/// Unlike a client handle, a pool may be shared between threads: each
+/// `rgpot_rpc_pool_calculate` call is served by the next free connection.
+/// `host` accepts the endpoint lists of `rgpot_rpc_client_new`, balanced
+/// over the whole pool.
+/// Returns a heap-allocated handle, or `NULL` on failure.
+/// The caller must eventually call `rgpot_rpc_pool_free`.
+#[cfg(feature = "rpc")]
+#[no_mangle]
+pub unsafe extern "C" fn rgpot_rpc_pool_new(
+    host: *const c_char,
+    port: u16,
+    size: usize,
+) -> *mut rgpot_rpc_pool_t {
+    if host.is_null() {
+        set_last_error("rgpot_rpc_pool_new: host is NULL");
+        return std::ptr::null_mut();
+    }
+
+    let host_str = match unsafe { std::ffi::CStr::from_ptr(host) }.to_str() {
+        Ok(s) => s.to_owned(),
+        Err(e) => {
+            set_last_error(&format!("rgpot_rpc_pool_new: invalid host string: {e}"));
+            return std::ptr::null_mut();
+        }
+    };
+
+    match RpcClientPool::new(&host_str, port, size) {
+        Ok(pool) => Box::into_raw(Box::new(pool)),
+        Err(e) => {
+            set_last_error(&format!("rgpot_rpc_pool_new: {e}"));
+            std::ptr::null_mut()
+        }
+    }
+}
+
+/// Perform a remote force/energy calculation on a pooled connection.
+///
+/// Safe to call from several threads with the same `pool`; blocks until
+/// the result has been written to `output`.
+///
+/// Returns `RGPOT_SUCCESS` on success, or an error status code.
+#[cfg(feature = "rpc")]
+#[no_mangle]
+pub unsafe extern "C" fn rgpot_rpc_pool_calculate(
+    pool: *const rgpot_rpc_pool_t,
+    input: *const rgpot_force_input_t,
+    output: *mut rgpot_force_out_t,
+) -> rgpot_status_t {
+    catch_unwind(std::panic::AssertUnwindSafe(|| {
+        if pool.is_null() {
+            set_last_error("rgpot_rpc_pool_calculate: pool is NULL");
+            return rgpot_status_t::RGPOT_INVALID_PARAMETER;
+        }
+        if input.is_null() {
+            set_last_error("rgpot_rpc_pool_calculate: input is NULL");
+            return rgpot_status_t::RGPOT_INVALID_PARAMETER;
+        }
+        if output.is_null() {
+            set_last_error("rgpot_rpc_pool_calculate: output is NULL");
+            return rgpot_status_t::RGPOT_INVALID_PARAMETER;
+        }
+
+        let pool_ref = unsafe { &*pool };
+        let inp = unsafe { &*input };
+        let out = unsafe { &mut *output };
+
+        match pool_ref.calculate(inp, out) {
+            Ok(()) => rgpot_status_t::RGPOT_SUCCESS,
+            Err(e) => {
+                set_last_error(&format!("rgpot_rpc_pool_calculate: {e}"));
+                rgpot_status_t::RGPOT_RPC_ERROR
+            }
+        }
+    }))
+}
+
+/// Cap the requests `pool` keeps in flight on each of its endpoints.
+///
+/// Calls wait for a free endpoint once all are at the cap; 0, the default,
+/// removes it.
+///
+/// Returns `RGPOT_SUCCESS`, or `RGPOT_INVALID_PARAMETER` for a `NULL` pool.
+#[cfg(feature = "rpc")]
+#[no_mangle]
+pub unsafe extern "C" fn rgpot_rpc_pool_set_endpoint_limit(
+    pool: *const rgpot_rpc_pool_t,
+    limit: usize,
+) -> rgpot_status_t {
+    if pool.is_null() {
+        set_last_error("rgpot_rpc_pool_set_endpoint_limit: pool is NULL");
+        return rgpot_status_t::RGPOT_INVALID_PARAMETER;
+    }
+    unsafe { &*pool }.set_endpoint_limit(limit);
+    rgpot_status_t::RGPOT_SUCCESS
+}
+
+/// Free an RPC connection pool, closing all of its connections.
+///
+/// Must not be called while other threads are still using `pool`.
+/// If `pool` is `NULL`, this is a no-op.
+#[cfg(feature = "rpc")]
+#[no_mangle]
+pub unsafe extern "C" fn rgpot_rpc_pool_free(pool: *mut rgpot_rpc_pool_t) {
+    if !pool.is_null() {
+        drop(unsafe { Box::from_raw(pool) });
+    }
+}
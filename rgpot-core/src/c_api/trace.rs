@@ -0,0 +1,49 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+//! C API for the trace spans of the Rust core.
+//!
+//! Spans are only recorded when the crate is built with the `trace`
+//! feature; otherwise the dump is an empty, valid trace.
+
+use std::os::raw::c_char;
+
+use crate::status::{catch_unwind, rgpot_status_t, set_last_error};
+
+/// Write the buffered trace spans of every thread to `path` as Chrome
+/// trace JSON, replacing the file if it exists.
+///
+/// Safe to call while other threads keep recording.
+///
+/// Returns `RGPOT_SUCCESS` on success, or an error status code.
+///
+/// # Safety
+/// `path` must be a valid NUL-terminated string.
+#[no_mangle]
+pub unsafe extern "C" fn rgpot_trace_dump(path: *const c_char) -> rgpot_status_t {
+    catch_unwind(std::panic::AssertUnwindSafe(|| {
+        if path.is_null() {
+            set_last_error("rgpot_trace_dump: path is NULL");
+            return rgpot_status_t::RGPOT_INVALID_PARAMETER;
+        }
+        let path_str = match unsafe { std::ffi::CStr::from_ptr(path) }.to_str() {
+            Ok(s) => s,
+            Err(e) => {
+                set_last_error(&format!("rgpot_trace_dump: invalid path string: {e}"));
+                return rgpot_status_t::RGPOT_INVALID_PARAMETER;
+            }
+        };
+        let written = std::fs::File::create(path_str).and_then(|file| {
+            let mut out = std::io::BufWriter::new(file);
+            crate::trace::write_chrome_json(&mut out)?;
+            std::io::Write::flush(&mut out)
+        });
+        match written {
+            Ok(()) => rgpot_status_t::RGPOT_SUCCESS,
+            Err(e) => {
+                set_last_error(&format!("rgpot_trace_dump: {path_str}: {e}"));
+                rgpot_status_t::RGPOT_INTERNAL_ERROR
+            }
+        }
+    }))
+}
@@ -0,0 +1,188 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+//! Device-to-host staging of DLPack tensors.
+//!
+//! The core never links a GPU runtime.  Local calculations hand device
+//! tensors to the potential callback untouched, so a GPU potential reads
+//! and writes device memory without any host round trip.  Only paths that
+//! need host data, currently the RPC client encoding its request, stage
+//! tensors through [`stage_to_host`]:
+//!
+//! - Host-accessible tensors (CPU, pinned and managed memory) are borrowed.
+//! - Other device tensors are copied into a host buffer by the function
+//!   registered with [`rgpot_device_copy_set`], typically wrapping
+//!   `cudaMemcpy` or `hipMemcpy`.
+//!
+//! Without a registered function such tensors are rejected with an error
+//! naming the device.
+
+use std::borrow::Cow;
+use std::os::raw::c_void;
+use std::sync::RwLock;
+
+use dlpk::sys::{DLDevice, DLDeviceType, DLManagedTensorVersioned};
+
+use crate::status::rgpot_status_t;
+
+/// Function copying `bytes` bytes from memory of `device` to host memory.
+///
+/// Returns `RGPOT_SUCCESS` once the data can be read at `dst`.
+pub type rgpot_device_copy_fn = unsafe extern "C" fn(
+    dst: *mut c_void,
+    src: *const c_void,
+    bytes: usize,
+    device: DLDevice,
+) -> rgpot_status_t;
+
+static DEVICE_COPY: RwLock<Option<rgpot_device_copy_fn>> = RwLock::new(None);
+
+/// Whether the host can read memory of `device` directly.
+pub(crate) fn host_accessible(device: DLDevice) -> bool {
+    matches!(
+        device.device_type,
+        DLDeviceType::kDLCPU
+            | DLDeviceType::kDLCUDAHost
+            | DLDeviceType::kDLCUDAManaged
+            | DLDeviceType::kDLROCMHost
+    )
+}
+
+/// Read the first `len` elements of a tensor on the host.
+///
+/// Host-accessible data is borrowed, anything else is copied into a new
+/// buffer through the registered copy function.  `name` labels the tensor
+/// in error messages.
+///
+/// # Safety
+/// `tensor` must be a valid, contiguous DLPack tensor holding at least
+/// `len` elements of `T`, and must outlive the returned slice.
+pub(crate) unsafe fn stage_to_host<'a, T: Copy + Default>(
+    tensor: *const DLManagedTensorVersioned,
+    len: usize,
+    name: &str,
+) -> Result<Cow<'a, [T]>, String> {
+    let t = unsafe { &(*tensor).dl_tensor };
+    let data = unsafe { t.data.cast::<u8>().add(t.byte_offset as usize) }.cast::<T>();
+    if host_accessible(t.device) {
+        return Ok(Cow::Borrowed(unsafe {
+            std::slice::from_raw_parts(data, len)
+        }));
+    }
+    let copy = DEVICE_COPY
+        .read()
+        .unwrap_or_else(|e| e.into_inner())
+        .ok_or_else(|| {
+            format!(
+                "{name} is on device {:?}; register a device copy with \
+                 rgpot_device_copy_set to stage it",
+                t.device.device_type
+            )
+        })?;
+    let mut host = vec![T::default(); len];
+    let status = unsafe {
+        copy(
+            host.as_mut_ptr().cast(),
+            data.cast(),
+            len * std::mem::size_of::<T>(),
+            t.device,
+        )
+    };
+    if status != rgpot_status_t::RGPOT_SUCCESS {
+        return Err(format!("device-to-host copy of {name} failed: {status:?}"));
+    }
+    Ok(Cow::Owned(host))
+}
+
+/// Register the function that copies device tensors to the host.
+///
+/// It is called only where host data is unavoidable, such as encoding an
+/// RPC request from GPU-resident positions.  Passing `NULL` removes it.
+/// The function may be called from any thread.
+#[no_mangle]
+pub extern "C" fn rgpot_device_copy_set(copy: Option<rgpot_device_copy_fn>) {
+    *DEVICE_COPY.write().unwrap_or_else(|e| e.into_inner()) = copy;
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::tensor::{rgpot_tensor_device_f64_2d, rgpot_tensor_free};
+    use std::sync::atomic::{AtomicUsize, Ordering};
+    use std::sync::Mutex;
+
+    /// The copy function is global; tests registering one run one at a time.
+    static SERIAL: Mutex<()> = Mutex::new(());
+    static COPIED: AtomicUsize = AtomicUsize::new(0);
+
+    /// Stand-in for `cudaMemcpy`: the "device" memory is host memory.
+    unsafe extern "C" fn host_memcpy(
+        dst: *mut c_void,
+        src: *const c_void,
+        bytes: usize,
+        _device: DLDevice,
+    ) -> rgpot_status_t {
+        unsafe { std::ptr::copy_nonoverlapping(src.cast::<u8>(), dst.cast(), bytes) };
+        COPIED.fetch_add(bytes, Ordering::SeqCst);
+        rgpot_status_t::RGPOT_SUCCESS
+    }
+
+    unsafe extern "C" fn failing_copy(
+        _dst: *mut c_void,
+        _src: *const c_void,
+        _bytes: usize,
+        _device: DLDevice,
+    ) -> rgpot_status_t {
+        rgpot_status_t::RGPOT_INTERNAL_ERROR
+    }
+
+    fn device(device_type: DLDeviceType) -> DLDevice {
+        DLDevice {
+            device_type,
+            device_id: 0,
+        }
+    }
+
+    #[test]
+    fn host_tensors_are_borrowed() {
+        let mut data = [1.0_f64, 2.0, 3.0];
+        for kind in [DLDeviceType::kDLCPU, DLDeviceType::kDLCUDAHost] {
+            let tensor =
+                unsafe { rgpot_tensor_device_f64_2d(data.as_mut_ptr(), 1, 3, device(kind)) };
+            let staged = unsafe { stage_to_host::<f64>(tensor, 3, "positions") }.unwrap();
+            assert!(matches!(staged, Cow::Borrowed(_)));
+            assert_eq!(staged.as_ptr(), data.as_ptr());
+            unsafe { rgpot_tensor_free(tensor) };
+        }
+    }
+
+    #[test]
+    fn device_tensors_are_copied_by_the_registered_function() {
+        let _serial = SERIAL.lock().unwrap_or_else(|e| e.into_inner());
+        let mut data = [1.0_f64, 2.0, 3.0, 4.0, 5.0, 6.0];
+        let tensor = unsafe {
+            rgpot_tensor_device_f64_2d(data.as_mut_ptr(), 2, 3, device(DLDeviceType::kDLCUDA))
+        };
+
+        rgpot_device_copy_set(None);
+        let err = unsafe { stage_to_host::<f64>(tensor, 6, "positions") }.unwrap_err();
+        assert!(err.contains("positions"), "{err}");
+
+        rgpot_device_copy_set(Some(host_memcpy));
+        let before = COPIED.load(Ordering::SeqCst);
+        let staged = unsafe { stage_to_host::<f64>(tensor, 6, "positions") }.unwrap();
+        assert!(matches!(staged, Cow::Owned(_)));
+        assert_eq!(&*staged, &data);
+        assert_eq!(COPIED.load(Ordering::SeqCst) - before, 48);
+
+        rgpot_device_copy_set(Some(failing_copy));
+        assert!(unsafe { stage_to_host::<f64>(tensor, 6, "positions") }.is_err());
+
+        rgpot_device_copy_set(None);
+        unsafe { rgpot_tensor_free(tensor) };
+    }
+}
@@ -19,8 +19,11 @@
 //! |--------|---------|
 //! | [`types`] | `#[repr(C)]` data structures for force/energy I/O |
 //! | [`tensor`] | DLPack tensor helpers: create, free, validate |
+//! | [`device`] | Device-to-host staging through a registered copy function |
+//! | `pool` | Size-class recycling of tensor buffers (crate-internal) |
 //! | [`status`] | Status codes, thread-local error message, panic safety |
 //! | [`potential`] | Callback-based potential dispatch (opaque handle) |
+//! | [`trace`] | Hot-path trace spans, Chrome trace output (`trace` feature) |
 //! | [`c_api`] | `extern "C"` entry points collected by cbindgen |
 //! | [`rpc`] | Cap'n Proto RPC client and server (feature-gated) |
 //!
@@ -49,8 +52,11 @@
 
 pub mod types;
 pub mod tensor;
+pub mod device;
+mod pool;
 pub mod status;
 pub mod potential;
+pub mod trace;
 pub mod c_api;
 
 #[cfg(feature = "rpc")]
@@ -0,0 +1,156 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+//! Size-class pool recycling the numeric buffers behind DLPack tensors.
+//!
+//! Owned tensors and the RPC server draw their `Vec`s from here and hand
+//! them back when they are released.  Capacities are rounded up to a power
+//! of two, so the buffers of recurring system sizes are reused instead of
+//! going through the allocator on every evaluation.  Each class keeps a
+//! bounded number of free buffers; anything beyond that is dropped.
+
+use std::sync::Mutex;
+
+/// Smallest pooled capacity, in elements.
+const MIN_ELEMENTS: usize = 8;
+/// Largest pooled capacity, in elements; larger buffers bypass the pool.
+const MAX_ELEMENTS: usize = 1 << 21;
+/// Free buffers retained per size class.
+const MAX_CACHED: usize = 32;
+/// Number of size classes between `MIN_ELEMENTS` and `MAX_ELEMENTS`.
+const NUM_CLASSES: usize = (MAX_ELEMENTS / MIN_ELEMENTS).trailing_zeros() as usize + 1;
+
+/// Thread-safe cache of empty `Vec<T>` buffers, grouped by capacity.
+pub(crate) struct BufferPool<T> {
+    classes: Mutex<Vec<Vec<Vec<T>>>>,
+}
+
+impl<T: Copy + Default> BufferPool<T> {
+    /// Create an empty pool.
+    pub(crate) const fn new() -> Self {
+        Self {
+            classes: Mutex::new(Vec::new()),
+        }
+    }
+
+    /// Size class serving `len` elements, `None` when the pool is bypassed.
+    fn class_of(len: usize) -> Option<usize> {
+        if len > MAX_ELEMENTS {
+            return None;
+        }
+        let cap = len.max(MIN_ELEMENTS).next_power_of_two();
+        Some((cap / MIN_ELEMENTS).trailing_zeros() as usize)
+    }
+
+    /// Take an empty buffer with room for at least `len` elements.
+    pub(crate) fn take(&self, len: usize) -> Vec<T> {
+        let Some(class) = Self::class_of(len) else {
+            return Vec::with_capacity(len);
+        };
+        if let Ok(mut classes) = self.classes.lock() {
+            if let Some(buf) = classes.get_mut(class).and_then(Vec::pop) {
+                return buf;
+            }
+        }
+        Vec::with_capacity(MIN_ELEMENTS << class)
+    }
+
+    /// Take a buffer of `len` default-initialized elements.
+    pub(crate) fn take_zeroed(&self, len: usize) -> Vec<T> {
+        let mut buf = self.take(len);
+        buf.resize(len, T::default());
+        buf
+    }
+
+    /// Take a buffer holding a copy of `data`.
+    pub(crate) fn take_copy(&self, data: &[T]) -> Vec<T> {
+        let mut buf = self.take(data.len());
+        buf.extend_from_slice(data);
+        buf
+    }
+
+    /// Return a buffer for reuse.
+    ///
+    /// Buffers whose capacity is not one of the class sizes, such as those
+    /// built outside the pool, are simply dropped.
+    pub(crate) fn give(&self, mut buf: Vec<T>) {
+        let cap = buf.capacity();
+        if !(MIN_ELEMENTS..=MAX_ELEMENTS).contains(&cap) || !cap.is_power_of_two() {
+            return;
+        }
+        let class = (cap / MIN_ELEMENTS).trailing_zeros() as usize;
+        buf.clear();
+        if let Ok(mut classes) = self.classes.lock() {
+            if classes.len() < NUM_CLASSES {
+                classes.resize_with(NUM_CLASSES, Vec::new);
+            }
+            if classes[class].len() < MAX_CACHED {
+                classes[class].push(buf);
+            }
+        }
+    }
+
+    /// Number of free buffers currently held.
+    #[cfg(test)]
+    fn cached(&self) -> usize {
+        self.classes
+            .lock()
+            .map(|classes| classes.iter().map(Vec::len).sum())
+            .unwrap_or(0)
+    }
+}
+
+/// Pool behind owned `f64` tensors and RPC coordinate buffers.
+pub(crate) static F64_POOL: BufferPool<f64> = BufferPool::new();
+/// Pool behind owned `i32` tensors and RPC atomic number buffers.
+pub(crate) static I32_POOL: BufferPool<i32> = BufferPool::new();
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn buffers_are_reused_within_a_class() {
+        let pool = BufferPool::<f64>::new();
+        let buf = pool.take_zeroed(100);
+        assert_eq!(buf.len(), 100);
+        assert_eq!(buf.capacity(), 128);
+        let ptr = buf.as_ptr();
+        pool.give(buf);
+        assert_eq!(pool.cached(), 1);
+
+        // Any length in the same class gets the same storage back, empty
+        let again = pool.take(120);
+        assert!(again.is_empty());
+        assert_eq!(again.as_ptr(), ptr);
+        assert_eq!(pool.cached(), 0);
+    }
+
+    #[test]
+    fn foreign_and_oversized_buffers_are_dropped() {
+        let pool = BufferPool::<i32>::new();
+        pool.give(vec![1, 2, 3]);
+        pool.give(Vec::with_capacity(MAX_ELEMENTS * 2));
+        assert_eq!(pool.cached(), 0);
+
+        let big = pool.take(MAX_ELEMENTS + 1);
+        assert!(big.capacity() > MAX_ELEMENTS);
+    }
+
+    #[test]
+    fn retention_is_bounded_per_class() {
+        let pool = BufferPool::<f64>::new();
+        let bufs: Vec<_> = (0..MAX_CACHED + 4).map(|_| pool.take(64)).collect();
+        for buf in bufs {
+            pool.give(buf);
+        }
+        assert_eq!(pool.cached(), MAX_CACHED);
+    }
+
+    #[test]
+    fn copies_preserve_data() {
+        let pool = BufferPool::<f64>::new();
+        let buf = pool.take_copy(&[1.0, 2.0, 3.0]);
+        assert_eq!(buf, vec![1.0, 2.0, 3.0]);
+    }
+}
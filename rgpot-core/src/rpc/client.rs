@@ -6,183 +6,481 @@
 //! The client owns a tokio runtime so that the C API can call it
 //! synchronously.
 //!
+//! ## Connection Reuse
+//!
+//! The connection and the bootstrapped `Potential` capability are kept for
+//! the lifetime of the client.  The `RpcSystem` driving them is spawned on
+//! a `LocalSet` owned by the client, so it keeps running across calls.
+//! If a call fails because the connection dropped, the client reconnects
+//! once and retries that call; any other failure is reported as is.
+//!
+//! ## Several Endpoints
+//!
+//! The address may list several servers, including Unix domain sockets
+//! (see [`crate::rpc::endpoints`]).  The client then holds one connection
+//! per endpoint and sends each call to the endpoint with the fewest
+//! requests in flight.  A call whose endpoint cannot be reached is sent to
+//! the next one, until every endpoint has been tried.
+//!
+//! ## Shared Memory
+//!
+//! A host of the form `shm://NAME` selects [`ShmClient`] instead; the port
+//! is then ignored and calls go through the segment of a local
+//! `potserv --shm NAME`.
+//!
 //! ## DLPack Integration
 //!
-//! Input tensors are read from `DLManagedTensorVersioned` pointers (CPU only
-//! for RPC — GPU tensors would need a device-to-host copy first).  The
-//! response forces are wrapped in an **owning** DLPack tensor so the caller
-//! can free them via `rgpot_tensor_free`.
+//! Input tensors are read from `DLManagedTensorVersioned` pointers.  Host
+//! tensors are copied into the request lists in one block each; tensors on
+//! a GPU are staged to the host first through
+//! [`crate::device::stage_to_host`], the only place where a device-to-host
+//! copy happens.  The response forces are copied out of the message once,
+//! into a pooled buffer wrapped in an **owning** host DLPack tensor so the
+//! caller can free them via `rgpot_tensor_free`; the message itself cannot
+//! back that tensor, as it belongs to the connection's event loop.
+
+use std::borrow::Cow;
+
+use std::sync::Arc;
 
 use capnp::Error as CapnpError;
 use capnp_rpc::{rpc_twoparty_capnp, twoparty, RpcSystem};
-use dlpk::sys::DLDeviceType;
 use futures::AsyncReadExt;
 use tokio::runtime::Runtime;
+use tokio::task::LocalSet;
 
-use crate::rpc::schema::potential;
+use crate::device::stage_to_host;
+use crate::pool::F64_POOL;
+use crate::rpc::endpoints::{Endpoint, EndpointSet, CONNECT_TIMEOUT};
+use crate::rpc::lists;
+use crate::rpc::schema::{force_input, potential, potential_result};
+use crate::rpc::shm::{self, ShmClient};
 use crate::tensor::create_owned_f64_tensor;
+use crate::trace;
 use crate::types::{rgpot_force_input_t, rgpot_force_out_t};
 
-/// RPC client that connects to a remote rgpot server.
+/// Failure of one RPC attempt.
+enum CallError {
+    /// The connection was lost; the call may be retried on a new one.
+    Disconnected(String),
+    /// Any other failure; retrying would not help.
+    Other(String),
+}
+
+impl From<String> for CallError {
+    fn from(msg: String) -> Self {
+        CallError::Other(msg)
+    }
+}
+
+impl From<CallError> for String {
+    fn from(err: CallError) -> Self {
+        match err {
+            CallError::Disconnected(msg) | CallError::Other(msg) => msg,
+        }
+    }
+}
+
+/// Classify a capnp error from a sent request.
+fn rpc_error(e: CapnpError) -> CallError {
+    let msg = format!("RPC call failed: {e}");
+    if e.kind == capnp::ErrorKind::Disconnected {
+        CallError::Disconnected(msg)
+    } else {
+        CallError::Other(msg)
+    }
+}
+
+/// RPC client that connects to one or several remote rgpot servers.
 pub struct RpcClient {
     runtime: Runtime,
-    addr: String,
+    local: LocalSet,
+    endpoints: Arc<EndpointSet>,
+    connections: Vec<Option<potential::Client>>,
+    shm: Option<ShmClient>,
 }
 
 impl RpcClient {
     /// Create a new RPC client targeting `host:port`.
     ///
-    /// The connection is established lazily on the first `calculate` call.
+    /// `host` may also be a comma-separated list of endpoints, see
+    /// [`crate::rpc::endpoints`].  Connections are established lazily on
+    /// the first call that needs them and reused afterwards.  A
+    /// `shm://NAME` host maps the server's shared memory segment right
+    /// away instead.
     pub fn new(host: &str, port: u16) -> Result<Self, String> {
+        if let Some(name) = shm::parse_address(host) {
+            let mut client = Self::with_endpoints(Arc::default())?;
+            client.shm = Some(ShmClient::connect(name)?);
+            return Ok(client);
+        }
+        Self::with_endpoints(Arc::new(EndpointSet::new(host, port)?))
+    }
+
+    /// Create a client balancing over `endpoints`, which other clients
+    /// may share so that their requests count towards the same load.
+    pub fn with_endpoints(endpoints: Arc<EndpointSet>) -> Result<Self, String> {
         let runtime =
             Runtime::new().map_err(|e| format!("failed to create tokio runtime: {e}"))?;
         Ok(Self {
             runtime,
-            addr: format!("{host}:{port}"),
+            local: LocalSet::new(),
+            connections: vec![None; endpoints.len()],
+            endpoints,
+            shm: None,
         })
     }
 
+    /// Whether a bootstrapped connection or shared memory segment is
+    /// currently held.
+    pub fn is_connected(&self) -> bool {
+        self.connections.iter().any(Option::is_some) || self.shm.is_some()
+    }
+
     /// Perform a synchronous RPC calculation.
     ///
-    /// Internally this blocks on the tokio runtime with a `LocalSet`
-    /// (required because `capnp_rpc::RpcSystem` is `!Send`).
+    /// Internally this blocks on the tokio runtime with the client's
+    /// `LocalSet` (required because `capnp_rpc::RpcSystem` is `!Send`).
     pub fn calculate(
         &mut self,
         input: &rgpot_force_input_t,
         output: &mut rgpot_force_out_t,
     ) -> Result<(), String> {
-        let local = tokio::task::LocalSet::new();
-        local.block_on(&self.runtime, self.calculate_async(input, output))
-    }
-
-    async fn calculate_async(
-        &self,
-        input: &rgpot_force_input_t,
-        output: &mut rgpot_force_out_t,
-    ) -> Result<(), String> {
-        // --- Extract data from DLPack tensors (CPU only) ---
+        // --- Extract data from DLPack tensors (staged if on a device) ---
         let n = unsafe { input.n_atoms() }
             .ok_or_else(|| "cannot determine n_atoms from input tensors".to_string())?;
+        let (positions, atmnrs, box_data) = unsafe { extract_input(input, n)? };
 
-        let (positions, atmnrs, box_data) = unsafe { extract_cpu_input(input, n)? };
-
-        // --- Connect ---
-        let stream = tokio::net::TcpStream::connect(&self.addr)
-            .await
-            .map_err(|e| format!("connection failed: {e}"))?;
-        stream
-            .set_nodelay(true)
-            .map_err(|e| format!("set_nodelay failed: {e}"))?;
+        let _call = trace::span("rust.client.calculate");
+        if let Some(shm) = &mut self.shm {
+            let (energy, forces) = shm.calculate(&positions, &atmnrs, &box_data)?;
+            store_result(output, energy, forces, n);
+            return Ok(());
+        }
+        let (energy, forces) = self.with_retry(|client| {
+            let mut request = client.calculate_request();
+            {
+                let _span = trace::span("rust.client.encode");
+                fill_force_input(request.get().init_fip(), &positions, &atmnrs, &box_data);
+            }
+            async move {
+                let response = {
+                    let _span = trace::span("rust.client.wait");
+                    request.send().promise.await.map_err(rpc_error)?
+                };
+                let _span = trace::span("rust.client.decode");
+                let result = response
+                    .get()
+                    .map_err(|e| format!("failed to read response: {e}"))?
+                    .get_result()
+                    .map_err(|e| format!("failed to get result: {e}"))?;
+                Ok(read_result(result, n)?)
+            }
+        })?;
+        store_result(output, energy, forces, n);
+        Ok(())
+    }
 
-        let (reader, writer) =
-            tokio_util::compat::TokioAsyncReadCompatExt::compat(stream).split();
+    /// Perform several RPC calculations in a single `calculateBatch` round
+    /// trip.
+    ///
+    /// `outputs[i]` receives the result for `inputs[i]`; both slices must
+    /// have the same length.  Outputs are only written once the whole batch
+    /// succeeded.
+    pub fn calculate_batch(
+        &mut self,
+        inputs: &[rgpot_force_input_t],
+        outputs: &mut [rgpot_force_out_t],
+    ) -> Result<(), String> {
+        if inputs.len() != outputs.len() {
+            return Err(format!(
+                "batch size mismatch: {} inputs, {} outputs",
+                inputs.len(),
+                outputs.len()
+            ));
+        }
 
-        let network = twoparty::VatNetwork::new(
-            futures::io::BufReader::new(reader),
-            futures::io::BufWriter::new(writer),
-            rpc_twoparty_capnp::Side::Client,
-            Default::default(),
-        );
+        // --- Extract data from DLPack tensors (staged if on a device) ---
+        let mut sizes = Vec::with_capacity(inputs.len());
+        let mut slices = Vec::with_capacity(inputs.len());
+        for (i, input) in inputs.iter().enumerate() {
+            let n = unsafe { input.n_atoms() }.ok_or_else(|| {
+                format!("cannot determine n_atoms from input tensors of item {i}")
+            })?;
+            slices.push(unsafe { extract_input(input, n)? });
+            sizes.push(n);
+        }
 
-        let mut rpc_system = RpcSystem::new(Box::new(network), None);
-        let potential_client: potential::Client =
-            rpc_system.bootstrap(rpc_twoparty_capnp::Side::Server);
+        let _call = trace::span("rust.client.calculate_batch");
+        if let Some(shm) = &mut self.shm {
+            let items: Vec<_> = slices
+                .iter()
+                .map(|(p, a, b)| (&p[..], &a[..], &b[..]))
+                .collect();
+            let results = shm.calculate_batch(&items)?;
+            for ((output, (energy, forces)), &n) in outputs.iter_mut().zip(results).zip(&sizes) {
+                store_result(output, energy, forces, n);
+            }
+            return Ok(());
+        }
+        let expected = sizes.len();
+        let sizes_ref = &sizes;
+        let results = self.with_retry(move |client| {
+            let mut request = client.calculate_batch_request();
+            {
+                let _span = trace::span("rust.client.encode");
+                let mut fips = request.get().init_fips(slices.len() as u32);
+                for (i, (positions, atmnrs, box_data)) in slices.iter().enumerate() {
+                    fill_force_input(fips.reborrow().get(i as u32), positions, atmnrs, box_data);
+                }
+            }
+            async move {
+                let response = {
+                    let _span = trace::span("rust.client.wait");
+                    request.send().promise.await.map_err(rpc_error)?
+                };
+                let _span = trace::span("rust.client.decode");
+                let results = response
+                    .get()
+                    .map_err(|e| format!("failed to read response: {e}"))?
+                    .get_results()
+                    .map_err(|e| format!("failed to get results: {e}"))?;
 
-        tokio::task::spawn_local(rpc_system);
+                if results.len() as usize != expected {
+                    return Err(CallError::Other(format!(
+                        "batch result count mismatch: expected {expected}, got {}",
+                        results.len()
+                    )));
+                }
+                let mut out = Vec::with_capacity(expected);
+                for (i, &n) in sizes_ref.iter().enumerate() {
+                    out.push(read_result(results.get(i as u32), n)?);
+                }
+                Ok(out)
+            }
+        })?;
 
-        // --- Build capnp request ---
-        let mut request = potential_client.calculate_request();
-        {
-            let mut fip = request.get().init_fip();
+        for ((output, (energy, forces)), &n) in outputs.iter_mut().zip(results).zip(&sizes) {
+            store_result(output, energy, forces, n);
+        }
+        Ok(())
+    }
 
-            let mut pos_builder = fip.reborrow().init_pos(positions.len() as u32);
-            for (i, &val) in positions.iter().enumerate() {
-                pos_builder.set(i as u32, val);
+    /// Run one call on the least loaded endpoint, failing over to the
+    /// others while the connection turns out to be gone.
+    ///
+    /// Every endpoint is tried once, a single endpoint twice, so that a
+    /// dropped connection is re-established.  `call` builds the request
+    /// from the capability and returns the future awaiting it; it is
+    /// invoked again for every retry.
+    fn with_retry<T, F, Fut>(&mut self, mut call: F) -> Result<T, String>
+    where
+        F: FnMut(&potential::Client) -> Fut,
+        Fut: std::future::Future<Output = Result<T, CallError>>,
+    {
+        let endpoints = Arc::clone(&self.endpoints);
+        let mut tried = Vec::new();
+        let mut retried = false;
+        let mut last_error = String::new();
+        while let Some(lease) = endpoints.acquire(&tried) {
+            let index = lease.index();
+            let outcome = match self.connection(index) {
+                Ok(client) => self.local.block_on(&self.runtime, call(&client)),
+                Err(err) => Err(err),
+            };
+            match outcome {
+                Ok(value) => {
+                    endpoints.mark_up(index);
+                    return Ok(value);
+                }
+                Err(CallError::Disconnected(msg)) => {
+                    self.connections[index] = None;
+                    endpoints.mark_down(index);
+                    last_error = msg;
+                    if endpoints.len() > 1 || retried {
+                        tried.push(index);
+                    }
+                    retried = true;
+                }
+                Err(err) => return Err(err.into()),
             }
+        }
+        Err(last_error)
+    }
 
-            let mut atm_builder = fip.reborrow().init_atmnrs(atmnrs.len() as u32);
-            for (i, &val) in atmnrs.iter().enumerate() {
-                atm_builder.set(i as u32, val);
-            }
+    /// Return the capability of endpoint `index`, connecting first if
+    /// needed.
+    fn connection(&mut self, index: usize) -> Result<potential::Client, CallError> {
+        if let Some(client) = &self.connections[index] {
+            return Ok(client.clone());
+        }
+        let endpoint = self.endpoints.endpoint(index);
+        let client = self
+            .local
+            .block_on(&self.runtime, connect(endpoint))
+            .map_err(|e| CallError::Disconnected(format!("{endpoint}: {e}")))?;
+        self.connections[index] = Some(client.clone());
+        Ok(client)
+    }
+}
 
-            let mut box_builder = fip.init_box(9);
-            for (i, &val) in box_data.iter().enumerate() {
-                box_builder.set(i as u32, val);
+/// Open a connection and bootstrap the `Potential` capability.
+///
+/// Must run inside a `LocalSet`; the `RpcSystem` is spawned onto it and
+/// lives as long as that set keeps being driven.
+async fn connect(endpoint: &Endpoint) -> Result<potential::Client, String> {
+    let opened = tokio::time::timeout(CONNECT_TIMEOUT, async {
+        match endpoint {
+            Endpoint::Tcp(addr) => {
+                let stream = tokio::net::TcpStream::connect(addr).await?;
+                stream.set_nodelay(true)?;
+                Ok::<_, std::io::Error>(bootstrap(stream))
             }
+            #[cfg(unix)]
+            Endpoint::Unix(path) => Ok(bootstrap(tokio::net::UnixStream::connect(path).await?)),
+            #[cfg(not(unix))]
+            Endpoint::Unix(_) => Err(std::io::Error::new(
+                std::io::ErrorKind::Unsupported,
+                "Unix domain sockets are not supported here",
+            )),
         }
+    })
+    .await;
+    match opened {
+        Ok(Ok(client)) => Ok(client),
+        Ok(Err(e)) => Err(format!("connection failed: {e}")),
+        Err(_) => Err(format!("connection timed out after {CONNECT_TIMEOUT:?}")),
+    }
+}
 
-        // --- Send and receive ---
-        let response = request
-            .send()
-            .promise
-            .await
-            .map_err(|e: CapnpError| format!("RPC call failed: {e}"))?;
+/// Bootstrap the `Potential` capability over an open stream.
+fn bootstrap<S>(stream: S) -> potential::Client
+where
+    S: tokio::io::AsyncRead + tokio::io::AsyncWrite + Unpin + 'static,
+{
+    let (reader, writer) = tokio_util::compat::TokioAsyncReadCompatExt::compat(stream).split();
 
-        let result = response
-            .get()
-            .map_err(|e| format!("failed to read response: {e}"))?
-            .get_result()
-            .map_err(|e| format!("failed to get result: {e}"))?;
+    let network = twoparty::VatNetwork::new(
+        futures::io::BufReader::new(reader),
+        futures::io::BufWriter::new(writer),
+        rpc_twoparty_capnp::Side::Client,
+        Default::default(),
+    );
 
-        output.energy = result.get_energy();
+    let mut rpc_system = RpcSystem::new(Box::new(network), None);
+    let potential_client: potential::Client =
+        rpc_system.bootstrap(rpc_twoparty_capnp::Side::Server);
 
-        let forces = result
-            .get_forces()
-            .map_err(|e| format!("failed to read forces: {e}"))?;
+    tokio::task::spawn_local(rpc_system);
+    potential_client
+}
 
-        if forces.len() as usize != n * 3 {
-            return Err(format!(
-                "force array size mismatch: expected {}, got {}",
-                n * 3,
-                forces.len()
-            ));
-        }
+/// Copy one configuration into a capnp `ForceInput` builder, one block
+/// copy per list.
+fn fill_force_input(
+    mut fip: force_input::Builder<'_>,
+    positions: &[f64],
+    atmnrs: &[i32],
+    box_data: &[f64],
+) {
+    lists::fill(
+        &mut fip.reborrow().init_pos(positions.len() as u32),
+        positions,
+    );
+    lists::fill(&mut fip.reborrow().init_atmnrs(atmnrs.len() as u32), atmnrs);
+    lists::fill(&mut fip.init_box(9), box_data);
+}
 
-        // Create an owning DLPack tensor for the forces
-        let forces_vec: Vec<f64> = (0..forces.len()).map(|i| forces.get(i)).collect();
-        output.forces = create_owned_f64_tensor(forces_vec, vec![n as i64, 3]);
+/// Read the energy and forces out of a capnp `PotentialResult`, checking
+/// the force count against `n` atoms.
+fn read_result(result: potential_result::Reader<'_>, n: usize) -> Result<(f64, Vec<f64>), String> {
+    let forces = result
+        .get_forces()
+        .map_err(|e| format!("failed to read forces: {e}"))?;
 
-        Ok(())
+    if forces.len() as usize != n * 3 {
+        return Err(format!(
+            "force array size mismatch: expected {}, got {}",
+            n * 3,
+            forces.len()
+        ));
     }
+
+    Ok((result.get_energy(), lists::copy_to_pool(&forces, &F64_POOL)))
 }
 
-/// Extract CPU data slices from DLPack input tensors.
+/// Store a result in `output`, wrapping the forces in an owning DLPack
+/// tensor.
+fn store_result(output: &mut rgpot_force_out_t, energy: f64, forces: Vec<f64>, n: usize) {
+    output.energy = energy;
+    output.forces = create_owned_f64_tensor(forces, vec![n as i64, 3]);
+}
+
+/// Host copies of the positions, atomic numbers and box of one input.
+type HostInput<'a> = (Cow<'a, [f64]>, Cow<'a, [i32]>, Cow<'a, [f64]>);
+
+/// Extract host data from DLPack input tensors.
+///
+/// Host tensors are borrowed; device tensors are copied through the
+/// function registered with `rgpot_device_copy_set`.
 ///
 /// # Safety
-/// All tensor pointers in `input` must be valid DLPack tensors on kDLCPU.
-unsafe fn extract_cpu_input(
-    input: &rgpot_force_input_t,
-    n: usize,
-) -> Result<(&[f64], &[i32], &[f64]), String> {
-    // Positions
+/// All tensor pointers in `input` must be valid, contiguous DLPack tensors.
+unsafe fn extract_input(input: &rgpot_force_input_t, n: usize) -> Result<HostInput<'_>, String> {
     if input.positions.is_null() {
         return Err("positions tensor is NULL".into());
     }
-    let pos_t = unsafe { &(*input.positions).dl_tensor };
-    if pos_t.device.device_type != DLDeviceType::kDLCPU {
-        return Err("RPC requires CPU tensors; positions is not on CPU".into());
-    }
-    let positions = unsafe { std::slice::from_raw_parts(pos_t.data as *const f64, n * 3) };
-
-    // Atomic numbers
     if input.atomic_numbers.is_null() {
         return Err("atomic_numbers tensor is NULL".into());
     }
-    let atm_t = unsafe { &(*input.atomic_numbers).dl_tensor };
-    if atm_t.device.device_type != DLDeviceType::kDLCPU {
-        return Err("RPC requires CPU tensors; atomic_numbers is not on CPU".into());
-    }
-    let atmnrs = unsafe { std::slice::from_raw_parts(atm_t.data as *const i32, n) };
-
-    // Box matrix
     if input.box_matrix.is_null() {
         return Err("box_matrix tensor is NULL".into());
     }
-    let box_t = unsafe { &(*input.box_matrix).dl_tensor };
-    if box_t.device.device_type != DLDeviceType::kDLCPU {
-        return Err("RPC requires CPU tensors; box_matrix is not on CPU".into());
+    unsafe {
+        Ok((
+            stage_to_host(input.positions, n * 3, "positions")?,
+            stage_to_host(input.atomic_numbers, n, "atomic_numbers")?,
+            stage_to_host(input.box_matrix, 9, "box_matrix")?,
+        ))
+    }
+}
+
+// Unverified: these tests need `cargo test --features rpc`, which could not
+// be built where they were written, so they have never been run.
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::rpc::server::testing::{Case, Stats, TestServer};
+    use std::sync::atomic::Ordering;
+
+    #[test]
+    fn calls_reuse_one_connection() {
+        let stats = Arc::new(Stats::default());
+        let server = TestServer::start(0, &stats);
+        let mut client = RpcClient::new("127.0.0.1", server.port()).unwrap();
+        assert!(!client.is_connected());
+        for seed in 0..5 {
+            Case::new(seed).check(|input, output| client.calculate(input, output));
+        }
+        assert!(client.is_connected());
+        assert_eq!(stats.calls.load(Ordering::SeqCst), 5);
+        assert_eq!(stats.accepted.load(Ordering::SeqCst), 1);
     }
-    let box_data = unsafe { std::slice::from_raw_parts(box_t.data as *const f64, 9) };
 
-    Ok((positions, atmnrs, box_data))
+    #[test]
+    fn reconnects_to_a_restarted_server() {
+        let stats = Arc::new(Stats::default());
+        let server = TestServer::start(0, &stats);
+        let port = server.port();
+        let mut client = RpcClient::new("127.0.0.1", port).unwrap();
+        Case::new(1).check(|input, output| client.calculate(input, output));
+
+        // The held connection dies with the server, the next call redials
+        drop(server);
+        let _server = TestServer::start(port, &stats);
+        Case::new(2).check(|input, output| client.calculate(input, output));
+        Case::new(3).check(|input, output| client.calculate(input, output));
+        assert_eq!(stats.accepted.load(Ordering::SeqCst), 2);
+        assert_eq!(stats.calls.load(Ordering::SeqCst), 3);
+    }
 }
@@ -0,0 +1,321 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+//! Endpoint lists and least-outstanding-requests balancing.
+//!
+//! A client address is a comma-separated list of endpoints, each one of
+//!
+//! - `HOST`, using the port passed alongside the address;
+//! - `HOST:PORT`;
+//! - `unix:PATH`, a Unix domain socket of a `potserv --unix PATH`.
+//!
+//! [`EndpointSet`] tracks the requests in flight on every endpoint and
+//! which endpoints are down.  It is shared by all clients of a
+//! [`crate::rpc::pool::RpcClientPool`], so the balancing covers every
+//! worker thread.
+//!
+//! ## Health
+//!
+//! An endpoint whose connection fails is marked down and skipped for a
+//! delay that doubles with every consecutive failure, from
+//! [`RETRY_MIN`] up to [`RETRY_MAX`].  Once the delay has passed the next
+//! call may pick it again; opening the connection, bounded by
+//! [`CONNECT_TIMEOUT`], serves as the health check, and the call fails over
+//! to another endpoint when it does not succeed.  While every endpoint is
+//! down, calls go to the one due soonest rather than failing outright.
+
+use std::sync::{Condvar, Mutex, MutexGuard};
+use std::time::{Duration, Instant};
+
+/// Delay before a failed endpoint is tried again.
+pub const RETRY_MIN: Duration = Duration::from_millis(250);
+
+/// Longest delay between attempts on an endpoint that keeps failing.
+pub const RETRY_MAX: Duration = Duration::from_secs(30);
+
+/// Time allowed for opening a connection.
+pub const CONNECT_TIMEOUT: Duration = Duration::from_secs(5);
+
+/// Where one server listens.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub enum Endpoint {
+    /// A TCP `host:port` address.
+    Tcp(String),
+    /// The path of a Unix domain socket.
+    Unix(String),
+}
+
+impl std::fmt::Display for Endpoint {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            Endpoint::Tcp(addr) => f.write_str(addr),
+            Endpoint::Unix(path) => write!(f, "unix:{path}"),
+        }
+    }
+}
+
+/// Split a client address into its endpoints.
+///
+/// Entries without a port use `port`; an address with an empty entry is
+/// rejected.
+pub fn parse_endpoints(host: &str, port: u16) -> Result<Vec<Endpoint>, String> {
+    host.split(',')
+        .map(str::trim)
+        .map(|entry| {
+            if entry.is_empty() {
+                Err(format!("empty endpoint in address '{host}'"))
+            } else if let Some(path) = entry.strip_prefix("unix:") {
+                if path.is_empty() {
+                    return Err(format!("empty socket path in address '{host}'"));
+                }
+                Ok(Endpoint::Unix(path.to_owned()))
+            } else if has_port(entry) {
+                Ok(Endpoint::Tcp(entry.to_owned()))
+            } else {
+                Ok(Endpoint::Tcp(format!("{entry}:{port}")))
+            }
+        })
+        .collect()
+}
+
+/// Whether a TCP entry names its port, also for bracketed IPv6 hosts.
+fn has_port(entry: &str) -> bool {
+    match entry.rsplit_once(':') {
+        Some((host, port)) => {
+            !port.is_empty()
+                && port.bytes().all(|b| b.is_ascii_digit())
+                && (!host.contains(':') || host.ends_with(']'))
+        }
+        None => false,
+    }
+}
+
+/// Health and load of one endpoint.
+#[derive(Debug, Default)]
+struct Slot {
+    outstanding: usize,
+    failures: u32,
+    retry_at: Option<Instant>,
+}
+
+impl Slot {
+    fn is_up(&self, now: Instant) -> bool {
+        self.retry_at.is_none_or(|at| at <= now)
+    }
+}
+
+#[derive(Debug, Default)]
+struct State {
+    slots: Vec<Slot>,
+    limit: usize,
+    next: usize,
+}
+
+/// Shared bookkeeping of the endpoints of one address.
+///
+/// The default set is empty, for clients that reach their server another
+/// way; [`EndpointSet::acquire`] then never returns an endpoint.
+#[derive(Debug, Default)]
+pub struct EndpointSet {
+    endpoints: Vec<Endpoint>,
+    state: Mutex<State>,
+    freed: Condvar,
+}
+
+/// A request in flight on one endpoint, counted until dropped.
+#[derive(Debug)]
+pub struct Lease<'a> {
+    set: &'a EndpointSet,
+    index: usize,
+}
+
+impl Lease<'_> {
+    /// Position of the endpoint in the set.
+    pub fn index(&self) -> usize {
+        self.index
+    }
+}
+
+impl Drop for Lease<'_> {
+    fn drop(&mut self) {
+        let mut state = self.set.lock();
+        state.slots[self.index].outstanding -= 1;
+        drop(state);
+        self.set.freed.notify_one();
+    }
+}
+
+impl EndpointSet {
+    /// Track the endpoints of `host`, see [`parse_endpoints`].
+    pub fn new(host: &str, port: u16) -> Result<Self, String> {
+        let endpoints = parse_endpoints(host, port)?;
+        let slots = endpoints.iter().map(|_| Slot::default()).collect();
+        Ok(Self {
+            endpoints,
+            state: Mutex::new(State {
+                slots,
+                limit: 0,
+                next: 0,
+            }),
+            freed: Condvar::new(),
+        })
+    }
+
+    /// Number of endpoints.
+    pub fn len(&self) -> usize {
+        self.endpoints.len()
+    }
+
+    /// Whether the set has no endpoints.
+    pub fn is_empty(&self) -> bool {
+        self.endpoints.is_empty()
+    }
+
+    /// The endpoint at `index`.
+    pub fn endpoint(&self, index: usize) -> &Endpoint {
+        &self.endpoints[index]
+    }
+
+    /// Cap the requests in flight on each endpoint; 0 removes the cap.
+    pub fn set_limit(&self, limit: usize) {
+        self.lock().limit = limit;
+        self.freed.notify_all();
+    }
+
+    /// Claim the up endpoint with the fewest requests in flight, skipping
+    /// those in `exclude`.
+    ///
+    /// Blocks while every candidate is at the limit.  Returns `None` only
+    /// when every endpoint is excluded.
+    pub fn acquire(&self, exclude: &[usize]) -> Option<Lease<'_>> {
+        let mut state = self.lock();
+        loop {
+            let now = Instant::now();
+            let n = state.slots.len();
+            let candidates = || {
+                (0..n)
+                    .map(|k| (state.next + k) % n)
+                    .filter(|i| !exclude.contains(i))
+            };
+            if candidates().next().is_none() {
+                return None;
+            }
+            let below_limit =
+                |i: &usize| state.limit == 0 || state.slots[*i].outstanding < state.limit;
+            let up = candidates()
+                .filter(|&i| state.slots[i].is_up(now))
+                .filter(below_limit)
+                .min_by_key(|&i| state.slots[i].outstanding);
+            let any_up = candidates().any(|i| state.slots[i].is_up(now));
+            // With every candidate down, try the one due soonest
+            let chosen = if any_up {
+                up
+            } else {
+                candidates()
+                    .filter(below_limit)
+                    .min_by_key(|&i| state.slots[i].retry_at)
+            };
+            if let Some(index) = chosen {
+                state.slots[index].outstanding += 1;
+                state.next = (index + 1) % n;
+                return Some(Lease { set: self, index });
+            }
+            state = self
+                .freed
+                .wait(state)
+                .unwrap_or_else(|poisoned| poisoned.into_inner());
+        }
+    }
+
+    /// Record a failed connection to `index`, which is skipped until its
+    /// retry delay has passed.
+    pub fn mark_down(&self, index: usize) {
+        let mut state = self.lock();
+        let slot = &mut state.slots[index];
+        let delay = RETRY_MIN.saturating_mul(1 << slot.failures.min(16));
+        slot.failures = slot.failures.saturating_add(1);
+        slot.retry_at = Some(Instant::now() + delay.min(RETRY_MAX));
+    }
+
+    /// Record a working connection to `index`.
+    pub fn mark_up(&self, index: usize) {
+        let mut state = self.lock();
+        let slot = &mut state.slots[index];
+        slot.failures = 0;
+        slot.retry_at = None;
+    }
+
+    fn lock(&self) -> MutexGuard<'_, State> {
+        self.state
+            .lock()
+            .unwrap_or_else(|poisoned| poisoned.into_inner())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn parses_endpoint_lists() {
+        let eps = parse_endpoints("a, b:7, unix:/tmp/p.sock,[::1]:9,[::1]", 5).unwrap();
+        assert_eq!(
+            eps,
+            vec![
+                Endpoint::Tcp("a:5".into()),
+                Endpoint::Tcp("b:7".into()),
+                Endpoint::Unix("/tmp/p.sock".into()),
+                Endpoint::Tcp("[::1]:9".into()),
+                Endpoint::Tcp("[::1]:5".into()),
+            ]
+        );
+        assert!(parse_endpoints("a,,b", 5).is_err());
+        assert!(parse_endpoints("unix:", 5).is_err());
+    }
+
+    #[test]
+    fn balances_by_outstanding_requests() {
+        let set = EndpointSet::new("a,b,c", 1).unwrap();
+        let first = set.acquire(&[]).unwrap();
+        let second = set.acquire(&[]).unwrap();
+        let third = set.acquire(&[]).unwrap();
+        let mut used = vec![first.index(), second.index(), third.index()];
+        used.sort();
+        assert_eq!(used, vec![0, 1, 2]);
+
+        // The endpoint freed first is the least loaded one
+        let freed = second.index();
+        drop(second);
+        assert_eq!(set.acquire(&[]).unwrap().index(), freed);
+        assert!(set.acquire(&[0, 1, 2]).is_none());
+    }
+
+    #[test]
+    fn skips_endpoints_that_are_down() {
+        let set = EndpointSet::new("a,b", 1).unwrap();
+        set.mark_down(0);
+        for _ in 0..4 {
+            assert_eq!(set.acquire(&[]).unwrap().index(), 1);
+        }
+        // With both down the one due soonest is still tried
+        set.mark_down(1);
+        set.mark_down(1);
+        assert_eq!(set.acquire(&[]).unwrap().index(), 0);
+        set.mark_up(1);
+        assert_eq!(set.acquire(&[]).unwrap().index(), 1);
+    }
+
+    #[test]
+    fn limit_blocks_until_a_request_finishes() {
+        let set = EndpointSet::new("a", 1).unwrap();
+        set.set_limit(1);
+        let held = set.acquire(&[]).unwrap();
+        std::thread::scope(|s| {
+            let waiter = s.spawn(|| set.acquire(&[]).map(|l| l.index()));
+            std::thread::sleep(Duration::from_millis(50));
+            assert!(!waiter.is_finished());
+            drop(held);
+            assert_eq!(waiter.join().unwrap(), Some(0));
+        });
+    }
+}
@@ -0,0 +1,96 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+//! In-place access to Cap'n Proto primitive lists.
+//!
+//! On little-endian targets the `Float64` and `Int32` lists of a message
+//! are laid out in its 8-byte aligned segments exactly like Rust slices, so
+//! the RPC layer reads and writes them through slice views instead of one
+//! `get` / `set` per element.  Lists that cannot be viewed that way, on
+//! big-endian targets or when a schema change widened the element size,
+//! fall back to element-wise access.
+
+use std::borrow::Cow;
+
+use capnp::primitive_list;
+use capnp::private::layout::PrimitiveElement;
+
+use crate::pool::BufferPool;
+
+/// View `list` as a slice, when its layout allows it.
+#[cfg(target_endian = "little")]
+pub(crate) fn as_slice<'a, T: PrimitiveElement>(
+    list: &'a primitive_list::Reader<'_, T>,
+) -> Option<&'a [T]> {
+    list.as_slice()
+}
+
+/// View `list` as a slice, when its layout allows it.
+#[cfg(not(target_endian = "little"))]
+pub(crate) fn as_slice<'a, T: PrimitiveElement>(
+    _list: &'a primitive_list::Reader<'_, T>,
+) -> Option<&'a [T]> {
+    None
+}
+
+/// View `list` as a mutable slice, when its layout allows it.
+#[cfg(target_endian = "little")]
+pub(crate) fn as_mut_slice<'a, T: PrimitiveElement>(
+    list: &'a mut primitive_list::Builder<'_, T>,
+) -> Option<&'a mut [T]> {
+    list.as_slice()
+}
+
+/// View `list` as a mutable slice, when its layout allows it.
+#[cfg(not(target_endian = "little"))]
+pub(crate) fn as_mut_slice<'a, T: PrimitiveElement>(
+    _list: &'a mut primitive_list::Builder<'_, T>,
+) -> Option<&'a mut [T]> {
+    None
+}
+
+/// Borrow `list` in place, or copy it into a buffer taken from `pool` when
+/// it cannot be viewed as a slice.
+pub(crate) fn borrow_or_copy<'a, T>(
+    list: &'a primitive_list::Reader<'_, T>,
+    pool: &BufferPool<T>,
+) -> Cow<'a, [T]>
+where
+    T: PrimitiveElement + Copy + Default,
+{
+    match as_slice(list) {
+        Some(data) => Cow::Borrowed(data),
+        None => Cow::Owned(copy_to_pool(list, pool)),
+    }
+}
+
+/// Copy `list` into a buffer taken from `pool`.
+pub(crate) fn copy_to_pool<T>(list: &primitive_list::Reader<'_, T>, pool: &BufferPool<T>) -> Vec<T>
+where
+    T: PrimitiveElement + Copy + Default,
+{
+    match as_slice(list) {
+        Some(data) => pool.take_copy(data),
+        None => {
+            let mut buf = pool.take(list.len() as usize);
+            buf.extend((0..list.len()).map(|i| list.get(i)));
+            buf
+        }
+    }
+}
+
+/// Copy `data` into `list`, which must have the same length.
+pub(crate) fn fill<T>(list: &mut primitive_list::Builder<'_, T>, data: &[T])
+where
+    T: PrimitiveElement + Copy,
+{
+    debug_assert_eq!(list.len() as usize, data.len());
+    match as_mut_slice(list) {
+        Some(dst) => dst.copy_from_slice(data),
+        None => {
+            for (i, &val) in data.iter().enumerate() {
+                list.set(i as u32, val);
+            }
+        }
+    }
+}
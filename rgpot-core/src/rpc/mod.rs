@@ -15,14 +15,48 @@
 //!
 //! - `ForceInput` — positions, atomic numbers, simulation cell.
 //! - `PotentialResult` — energy and forces.
-//! - `Potential` interface — a single `calculate` RPC method.
+//! - `Potential` interface — `calculate` for one configuration and
+//!   `calculateBatch` for a list of configurations.
 //!
 //! ## Client
 //!
 //! [`client::RpcClient`] connects to a remote rgpot server and provides a
-//! synchronous `calculate()` method. Internally it owns a tokio runtime so
-//! that the blocking C API can drive async I/O. Exposed to C via
-//! `rgpot_rpc_client_new` / `rgpot_rpc_calculate` / `rgpot_rpc_client_free`.
+//! synchronous `calculate()` method, plus `calculate_batch()` for several
+//! configurations per round trip. Internally it owns a tokio runtime so
+//! that the blocking C API can drive async I/O. The connection is opened on
+//! first use, kept for the lifetime of the client, and re-established once
+//! if the server drops it; with several endpoints, calls fail over to the
+//! others. Exposed to C via
+//! `rgpot_rpc_client_new` / `rgpot_rpc_calculate` /
+//! `rgpot_rpc_calculate_batch` / `rgpot_rpc_client_free`.
+//!
+//! ## Endpoints
+//!
+//! [`endpoints::EndpointSet`] parses addresses listing several servers,
+//! over TCP or Unix domain sockets, and balances calls between them by
+//! least outstanding requests, with failover and an optional
+//! per-endpoint concurrency limit.
+//!
+//! ## Lists
+//!
+//! Both sides access the `Float64` / `Int32` lists of a message through
+//! slice views (the private `lists` module): the server lays its DLPack
+//! tensors directly over the request and response, and the client copies
+//! each array in and out in one block.
+//!
+//! ## Shared memory
+//!
+//! [`shm::ShmClient`] is used instead of TCP when the host is given as
+//! `shm://NAME`, reaching a `potserv --shm NAME` on the same machine
+//! through a mapped segment.  It is Linux-only and shares the slot layout
+//! of `CppCore/rgpot/rpc/ShmChannel.hpp`.
+//!
+//! ## Connection pool
+//!
+//! [`pool::RpcClientPool`] runs `N` clients on their own threads behind a
+//! shared queue, so concurrent callers can keep up to `N` requests in
+//! flight. Exposed to C via `rgpot_rpc_pool_new` /
+//! `rgpot_rpc_pool_calculate` / `rgpot_rpc_pool_free`.
 //!
 //! ## Server
 //!
@@ -39,4 +73,8 @@
 pub use crate::Potentials_capnp as schema;
 
 pub mod client;
+pub mod endpoints;
+mod lists;
+pub mod pool;
 pub mod server;
+pub mod shm;
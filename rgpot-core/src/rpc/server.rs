@@ -1,25 +1,33 @@
 // MIT License
 // Copyright 2023--present rgpot developers
 
-//! Cap'n Proto RPC server that dispatches incoming `calculate` calls
-//! to a `rgpot_potential_t` callback.
+//! Cap'n Proto RPC server that dispatches incoming `calculate` and
+//! `calculateBatch` calls to a `rgpot_potential_t` callback.
 //!
 //! ## DLPack Integration
 //!
-//! Incoming data is deserialized from Cap'n Proto into owned `Vec` values, then
-//! wrapped in non-owning DLPack tensors for the callback.  The callback's
-//! output forces (an owning DLPack tensor) are read back and serialized
-//! into the Cap'n Proto response.
+//! The callback sees non-owning DLPack tensors laid directly over the
+//! `Float64` / `Int32` lists of the request message (see
+//! [`crate::rpc::lists`]); nothing is decoded.  The output forces are
+//! preset to a tensor over the `forces` list of the response, so a callback
+//! filling them in place writes the reply without any copy.  Only forces a
+//! callback returns in its own tensor, staged to the host first when on a
+//! GPU, are copied into the response.
 
 use capnp::Error as CapnpError;
 use capnp_rpc::{pry, rpc_twoparty_capnp, twoparty, RpcSystem};
 use futures::AsyncReadExt;
+use std::borrow::Cow;
 use std::os::raw::c_void;
 use tokio::runtime::Runtime;
 
+use crate::device::stage_to_host;
+use crate::pool::{F64_POOL, I32_POOL};
 use crate::potential::{PotentialCallback, rgpot_potential_t};
-use crate::rpc::schema::potential;
+use crate::rpc::lists;
+use crate::rpc::schema::{force_input, potential, potential_result};
 use crate::status::rgpot_status_t;
+use crate::trace;
 use crate::tensor::{
     rgpot_tensor_cpu_f64_2d, rgpot_tensor_cpu_f64_matrix3, rgpot_tensor_cpu_i32_1d,
     rgpot_tensor_free,
@@ -37,77 +45,147 @@ struct PotentialServer {
 unsafe impl Send for PotentialServer {}
 unsafe impl Sync for PotentialServer {}
 
-impl potential::Server for PotentialServer {
-    fn calculate(
-        &mut self,
-        params: potential::CalculateParams,
-        mut results: potential::CalculateResults,
-    ) -> capnp::capability::Promise<(), CapnpError> {
-        let fip = pry!(pry!(params.get()).get_fip());
-
-        let positions = pry!(fip.get_pos());
-        let atmnrs = pry!(fip.get_atmnrs());
-        let box_data = pry!(fip.get_box());
+impl PotentialServer {
+    /// Run the callback on one `ForceInput` and serialize the result.
+    fn evaluate(
+        &self,
+        fip: force_input::Reader<'_>,
+        mut result_builder: potential_result::Builder<'_>,
+    ) -> Result<(), CapnpError> {
+        let positions = fip.get_pos()?;
+        let atmnrs = fip.get_atmnrs()?;
+        let box_list = fip.get_box()?;
 
         let n_atoms = atmnrs.len() as usize;
 
-        // Copy capnp data into owned buffers
-        let mut pos_vec: Vec<f64> = (0..positions.len()).map(|i| positions.get(i)).collect();
-        let mut atm_vec: Vec<i32> = (0..atmnrs.len()).map(|i| atmnrs.get(i)).collect();
-        let mut box_vec: Vec<f64> = (0..box_data.len()).map(|i| box_data.get(i)).collect();
+        // View the request lists in place; only those that cannot be viewed
+        // as slices are copied into pooled buffers
+        let (pos_data, atm_data, box_data) = {
+            let _span = trace::span("rust.rpc.decode");
+            (
+                lists::borrow_or_copy(&positions, &F64_POOL),
+                lists::borrow_or_copy(&atmnrs, &I32_POOL),
+                lists::borrow_or_copy(&box_list, &F64_POOL),
+            )
+        };
+
+        // The forces are computed straight into the response list
+        let mut forces_builder = result_builder.reborrow().init_forces((n_atoms * 3) as u32);
+        let mut forces_scratch = None;
+        let forces_ptr = match lists::as_mut_slice(&mut forces_builder) {
+            Some(forces) => forces.as_mut_ptr(),
+            None => forces_scratch
+                .insert(F64_POOL.take_zeroed(n_atoms * 3))
+                .as_mut_ptr(),
+        };
 
-        // Create non-owning DLPack tensors wrapping the owned buffers
+        // Non-owning DLPack tensors over the message; the inputs are only
+        // read by callbacks, so casting away const is sound
         let pos_tensor =
-            unsafe { rgpot_tensor_cpu_f64_2d(pos_vec.as_mut_ptr(), n_atoms as i64, 3) };
+            unsafe { rgpot_tensor_cpu_f64_2d(pos_data.as_ptr().cast_mut(), n_atoms as i64, 3) };
         let atm_tensor =
-            unsafe { rgpot_tensor_cpu_i32_1d(atm_vec.as_mut_ptr(), n_atoms as i64) };
-        let box_tensor = unsafe { rgpot_tensor_cpu_f64_matrix3(box_vec.as_mut_ptr()) };
+            unsafe { rgpot_tensor_cpu_i32_1d(atm_data.as_ptr().cast_mut(), n_atoms as i64) };
+        let box_tensor = unsafe { rgpot_tensor_cpu_f64_matrix3(box_data.as_ptr().cast_mut()) };
+        let forces_tensor = unsafe { rgpot_tensor_cpu_f64_2d(forces_ptr, n_atoms as i64, 3) };
 
         let input = rgpot_force_input_t {
             positions: pos_tensor,
             atomic_numbers: atm_tensor,
             box_matrix: box_tensor,
         };
+        // Preset forces let callbacks write in place; one that replaces the
+        // tensor instead hands back its own, copied and freed below
         let mut output = rgpot_force_out_t {
-            forces: std::ptr::null_mut(),
+            forces: forces_tensor,
             energy: 0.0,
             variance: 0.0,
         };
 
-        let status = unsafe { (self.callback)(self.user_data, &input, &mut output) };
-
-        // Read forces from the output DLPack tensor before freeing
-        let forces_data = if !output.forces.is_null() {
-            let ft = unsafe { &(*output.forces).dl_tensor };
-            let len = n_atoms * 3;
-            unsafe { std::slice::from_raw_parts(ft.data as *const f64, len) }
-        } else {
-            &[] as &[f64]
+        let status = {
+            let _span = trace::span("rust.rpc.callback");
+            unsafe { (self.callback)(self.user_data, &input, &mut output) }
         };
 
-        // Free all tensors
-        let forces_copy: Vec<f64> = forces_data.to_vec();
+        let mut stage_error = None;
+        if status == rgpot_status_t::RGPOT_SUCCESS {
+            let _span = trace::span("rust.rpc.encode");
+            if output.forces == forces_tensor {
+                if let Some(forces) = &forces_scratch {
+                    lists::fill(&mut forces_builder, forces);
+                }
+            } else if !output.forces.is_null() {
+                match unsafe { stage_to_host::<f64>(output.forces, n_atoms * 3, "forces") } {
+                    Ok(forces) => lists::fill(&mut forces_builder, &forces),
+                    Err(msg) => stage_error = Some(msg),
+                }
+            } else {
+                result_builder.reborrow().init_forces(0);
+            }
+            result_builder.set_energy(output.energy);
+        }
+
+        // Free all tensors, then recycle the buffers they borrowed
         unsafe {
-            rgpot_tensor_free(output.forces);
+            if output.forces != forces_tensor {
+                rgpot_tensor_free(output.forces);
+            }
+            rgpot_tensor_free(forces_tensor);
             rgpot_tensor_free(input.positions);
             rgpot_tensor_free(input.atomic_numbers);
             rgpot_tensor_free(input.box_matrix);
         }
+        if let Cow::Owned(buf) = pos_data {
+            F64_POOL.give(buf);
+        }
+        if let Cow::Owned(buf) = atm_data {
+            I32_POOL.give(buf);
+        }
+        if let Cow::Owned(buf) = box_data {
+            F64_POOL.give(buf);
+        }
+        if let Some(buf) = forces_scratch {
+            F64_POOL.give(buf);
+        }
 
+        if let Some(msg) = stage_error {
+            return Err(CapnpError::failed(msg));
+        }
         if status != rgpot_status_t::RGPOT_SUCCESS {
-            return capnp::capability::Promise::err(CapnpError::failed(
+            return Err(CapnpError::failed(
                 "potential callback returned an error".to_string(),
             ));
         }
 
-        let mut result_builder = results.get().init_result();
-        result_builder.set_energy(output.energy);
+        Ok(())
+    }
+}
 
-        let mut forces_builder = result_builder.init_forces(forces_copy.len() as u32);
-        for (i, &f) in forces_copy.iter().enumerate() {
-            forces_builder.set(i as u32, f);
-        }
+impl potential::Server for PotentialServer {
+    fn calculate(
+        &mut self,
+        params: potential::CalculateParams,
+        mut results: potential::CalculateResults,
+    ) -> capnp::capability::Promise<(), CapnpError> {
+        let fip = pry!(pry!(params.get()).get_fip());
+        pry!(self.evaluate(fip, results.get().init_result()));
+        capnp::capability::Promise::ok(())
+    }
 
+    /// Evaluates the items one after another in input order.
+    ///
+    /// The callback contract does not promise reentrancy, so unlike the
+    /// C++ `potserv` the items are not spread over threads here; the batch
+    /// still saves one round trip per item.
+    fn calculate_batch(
+        &mut self,
+        params: potential::CalculateBatchParams,
+        mut results: potential::CalculateBatchResults,
+    ) -> capnp::capability::Promise<(), CapnpError> {
+        let fips = pry!(pry!(params.get()).get_fips());
+        let mut builder = results.get().init_results(fips.len());
+        for i in 0..fips.len() {
+            pry!(self.evaluate(fips.get(i), builder.reborrow().get(i)));
+        }
         capnp::capability::Promise::ok(())
     }
 }
@@ -176,31 +254,234 @@ pub unsafe extern "C" fn rgpot_rpc_server_start(
                     }
                 };
 
-                let _ = stream.set_nodelay(true);
+                serve_stream(stream, pot_ref);
+            }
+        })
+    }))
+}
 
-                let server_impl = PotentialServer {
-                    callback: pot_ref.callback,
-                    user_data: pot_ref.user_data,
-                };
+/// Serve the `Potential` capability of `pot` over one accepted stream.
+///
+/// Must run inside a `LocalSet`; the `RpcSystem` is spawned onto it and
+/// answers until the peer disconnects or the set is dropped.
+fn serve_stream(stream: tokio::net::TcpStream, pot: &rgpot_potential_t) {
+    let _ = stream.set_nodelay(true);
+
+    let server_impl = PotentialServer {
+        callback: pot.callback,
+        user_data: pot.user_data,
+    };
+
+    let potential_client = capnp_rpc::new_client::<potential::Client, _>(server_impl);
 
-                let potential_client =
-                    capnp_rpc::new_client::<potential::Client, _>(server_impl);
+    let (reader, writer) = tokio_util::compat::TokioAsyncReadCompatExt::compat(stream).split();
 
-                let (reader, writer) =
-                    tokio_util::compat::TokioAsyncReadCompatExt::compat(stream).split();
+    let network = twoparty::VatNetwork::new(
+        futures::io::BufReader::new(reader),
+        futures::io::BufWriter::new(writer),
+        rpc_twoparty_capnp::Side::Server,
+        Default::default(),
+    );
 
-                let network = twoparty::VatNetwork::new(
-                    futures::io::BufReader::new(reader),
-                    futures::io::BufWriter::new(writer),
-                    rpc_twoparty_capnp::Side::Server,
-                    Default::default(),
-                );
+    let rpc_system = RpcSystem::new(Box::new(network), Some(potential_client.client));
 
-                let rpc_system =
-                    RpcSystem::new(Box::new(network), Some(potential_client.client));
+    tokio::task::spawn_local(rpc_system);
+}
 
-                tokio::task::spawn_local(rpc_system);
+/// A server on its own thread for the client tests, answering with a mock
+/// potential and restartable on the same port.
+///
+/// Unverified: like the client tests, it needs the `rpc` feature and has
+/// never been built or run.
+#[cfg(test)]
+pub(crate) mod testing {
+    use std::os::raw::c_void;
+    use std::sync::atomic::{AtomicUsize, Ordering};
+    use std::sync::Arc;
+    use std::thread::JoinHandle;
+    use std::time::Duration;
+
+    use futures::channel::oneshot;
+    use tokio::runtime::Runtime;
+    use tokio::task::LocalSet;
+
+    use super::serve_stream;
+    use crate::potential::PotentialImpl;
+    use crate::status::rgpot_status_t;
+    use crate::tensor::{
+        rgpot_tensor_cpu_f64_2d, rgpot_tensor_cpu_f64_matrix3, rgpot_tensor_cpu_i32_1d,
+        rgpot_tensor_data, rgpot_tensor_free,
+    };
+    use crate::types::{rgpot_force_input_t, rgpot_force_out_t};
+
+    /// Counters shared by the tests and the mock potential of their servers.
+    #[derive(Default)]
+    pub(crate) struct Stats {
+        /// Time each evaluation takes.
+        pub(crate) delay: Duration,
+        /// Connections accepted.
+        pub(crate) accepted: AtomicUsize,
+        /// Evaluations finished.
+        pub(crate) calls: AtomicUsize,
+        /// Evaluations running right now, over all servers.
+        pub(crate) running: AtomicUsize,
+        /// Most evaluations seen running at once.
+        pub(crate) max_running: AtomicUsize,
+    }
+
+    /// Mock potential: the forces are twice the positions and the energy
+    /// sums the atomic numbers.
+    unsafe extern "C" fn mock_callback(
+        user_data: *mut c_void,
+        input: *const rgpot_force_input_t,
+        output: *mut rgpot_force_out_t,
+    ) -> rgpot_status_t {
+        let stats = unsafe { &*user_data.cast::<Stats>() };
+        let running = stats.running.fetch_add(1, Ordering::SeqCst) + 1;
+        stats.max_running.fetch_max(running, Ordering::SeqCst);
+        std::thread::sleep(stats.delay);
+
+        let (input, output) = unsafe { (&*input, &mut *output) };
+        let n = unsafe { input.n_atoms() }.unwrap_or(0);
+        // The server presets the forces to a tensor over its response
+        unsafe {
+            let pos =
+                std::slice::from_raw_parts(rgpot_tensor_data(input.positions).cast::<f64>(), n * 3);
+            let atmnrs = std::slice::from_raw_parts(
+                rgpot_tensor_data(input.atomic_numbers).cast::<i32>(),
+                n,
+            );
+            let forces = std::slice::from_raw_parts_mut(
+                rgpot_tensor_data(output.forces).cast::<f64>().cast_mut(),
+                n * 3,
+            );
+            for (f, p) in forces.iter_mut().zip(pos) {
+                *f = 2.0 * p;
             }
-        })
-    }))
+            output.energy = atmnrs.iter().sum::<i32>() as f64;
+        }
+
+        stats.calls.fetch_add(1, Ordering::SeqCst);
+        stats.running.fetch_sub(1, Ordering::SeqCst);
+        rgpot_status_t::RGPOT_SUCCESS
+    }
+
+    /// A server thread on the loopback interface, stopped on drop together
+    /// with all its connections.
+    pub(crate) struct TestServer {
+        port: u16,
+        stop: Option<oneshot::Sender<()>>,
+        thread: Option<JoinHandle<()>>,
+    }
+
+    impl TestServer {
+        /// Serve the mock potential on `port`, or on a free port for 0.
+        pub(crate) fn start(port: u16, stats: &Arc<Stats>) -> Self {
+            let (stop, mut stopped) = oneshot::channel::<()>();
+            let (bound_tx, bound_rx) = std::sync::mpsc::channel();
+            let stats = Arc::clone(stats);
+            let thread = std::thread::spawn(move || {
+                let runtime = Runtime::new().expect("test server runtime");
+                let local = LocalSet::new();
+                let user_data = Arc::as_ptr(&stats).cast_mut().cast::<c_void>();
+                let pot = PotentialImpl::new(mock_callback, user_data, None);
+                local.block_on(&runtime, async {
+                    let listener = tokio::net::TcpListener::bind(("127.0.0.1", port))
+                        .await
+                        .expect("test server bind");
+                    let _ = bound_tx.send(listener.local_addr().expect("bound address").port());
+                    loop {
+                        tokio::select! {
+                            _ = &mut stopped => break,
+                            accepted = listener.accept() => {
+                                let (stream, _) = accepted.expect("test server accept");
+                                stats.accepted.fetch_add(1, Ordering::SeqCst);
+                                serve_stream(stream, &pot);
+                            }
+                        }
+                    }
+                });
+                // Dropping the set closes every connection
+                drop(local);
+            });
+            let port = bound_rx.recv().expect("test server failed to start");
+            Self {
+                port,
+                stop: Some(stop),
+                thread: Some(thread),
+            }
+        }
+
+        /// Port the server listens on.
+        pub(crate) fn port(&self) -> u16 {
+            self.port
+        }
+    }
+
+    impl Drop for TestServer {
+        fn drop(&mut self) {
+            if let Some(stop) = self.stop.take() {
+                let _ = stop.send(());
+            }
+            if let Some(thread) = self.thread.take() {
+                let _ = thread.join();
+            }
+        }
+    }
+
+    /// A configuration of two atoms, told apart by `seed`.
+    pub(crate) struct Case {
+        pos: Vec<f64>,
+        atmnrs: Vec<i32>,
+        cell: [f64; 9],
+    }
+
+    impl Case {
+        pub(crate) fn new(seed: usize) -> Self {
+            let s = seed as f64;
+            Self {
+                pos: vec![s, 0.5, 1.0, 1.5, s, 2.0],
+                atmnrs: vec![seed as i32, 1],
+                cell: [10.0, 0.0, 0.0, 0.0, 10.0, 0.0, 0.0, 0.0, 10.0],
+            }
+        }
+
+        /// Evaluate this configuration with `calculate` and check the
+        /// answer of the mock potential.
+        pub(crate) fn check<F>(mut self, calculate: F)
+        where
+            F: FnOnce(&rgpot_force_input_t, &mut rgpot_force_out_t) -> Result<(), String>,
+        {
+            let input = unsafe {
+                rgpot_force_input_t {
+                    positions: rgpot_tensor_cpu_f64_2d(self.pos.as_mut_ptr(), 2, 3),
+                    atomic_numbers: rgpot_tensor_cpu_i32_1d(self.atmnrs.as_mut_ptr(), 2),
+                    box_matrix: rgpot_tensor_cpu_f64_matrix3(self.cell.as_mut_ptr()),
+                }
+            };
+            let mut output = rgpot_force_out_t {
+                forces: std::ptr::null_mut(),
+                energy: 0.0,
+                variance: 0.0,
+            };
+            let result = calculate(&input, &mut output);
+            unsafe {
+                rgpot_tensor_free(input.positions);
+                rgpot_tensor_free(input.atomic_numbers);
+                rgpot_tensor_free(input.box_matrix);
+            }
+            if let Err(e) = result {
+                panic!("calculation failed: {e}");
+            }
+
+            assert_eq!(output.energy, self.atmnrs.iter().sum::<i32>() as f64);
+            let forces = unsafe {
+                std::slice::from_raw_parts(rgpot_tensor_data(output.forces).cast::<f64>(), 6)
+            };
+            for (f, p) in forces.iter().zip(&self.pos) {
+                assert_eq!(*f, 2.0 * p);
+            }
+            unsafe { rgpot_tensor_free(output.forces) };
+        }
+    }
 }
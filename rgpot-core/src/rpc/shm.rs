@@ -0,0 +1,526 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+//! Shared-memory transport to a `potserv --shm NAME` on the same host.
+//!
+//! Selected by giving [`crate::rpc::client::RpcClient`] a host of the form
+//! `shm://NAME`.  The server's POSIX shared memory object `/NAME` is mapped
+//! once; every call claims a slot of it, writes the configuration there and
+//! rings the doorbell, and the server writes energy and forces back into
+//! the same slot.  Waiting spins briefly and then sleeps on a futex, so a
+//! round trip avoids the loopback socket and the Cap'n Proto framing.
+//!
+//! ## Layout
+//!
+//! Mirrors `CppCore/rgpot/rpc/ShmChannel.hpp`, which is authoritative:
+//!
+//! - A 128 byte header: magic and version, slot count, atoms per slot,
+//!   slot stride, server pid, then the `doorbell` and `sleepers` futex
+//!   words on the second cache line.
+//! - Slots of `slot_bytes`: a 256 byte control block (`owner`, `state`,
+//!   `waiting`, `home`, `natoms`, `energy`, `answers`, error message), the
+//!   box padded to 128 bytes, then positions, forces and atomic numbers for
+//!   `max_atoms`.
+//!
+//! Every slot names the `home` slot of its owner, the first one the client
+//! claimed; the server bumps the `answers` word of that home after each
+//! answer, so one futex wait covers all slots of a client.
+//!
+//! Futex signaling makes the transport Linux-only; elsewhere connecting
+//! fails.
+
+use std::sync::atomic::{AtomicU32, Ordering};
+use std::sync::OnceLock;
+
+const MAGIC: u64 = 0x4D48_5354_4F50_4752; // "RGPOTSHM"
+const VERSION: u32 = 2;
+
+const HEADER_BYTES: usize = 128;
+const H_MAGIC: usize = 0;
+const H_VERSION: usize = 8;
+const H_NSLOTS: usize = 12;
+const H_MAX_ATOMS: usize = 16;
+const H_SLOT_BYTES: usize = 24;
+const H_SERVER_PID: usize = 32;
+const H_DOORBELL: usize = 64;
+const H_SLEEPERS: usize = 68;
+
+const SLOT_HEADER_BYTES: usize = 256;
+const BOX_BYTES: usize = 128;
+const S_OWNER: usize = 0;
+const S_STATE: usize = 4;
+const S_WAITING: usize = 8;
+const S_HOME: usize = 12;
+const S_NATOMS: usize = 16;
+const S_ENERGY: usize = 24;
+const S_ANSWERS: usize = 32;
+const S_ERROR: usize = 40;
+const ERROR_BYTES: usize = 216;
+
+const IDLE: u32 = 0;
+const REQUEST: u32 = 1;
+const BUSY: u32 = 2;
+const DONE: u32 = 3;
+const FAILED: u32 = 4;
+
+/// Polls before a futex wait.
+const SPIN: u32 = 4096;
+
+/// Configurations of a batch kept in flight at once.
+const BATCH_WINDOW: usize = 8;
+
+/// Extract the segment name of a `shm://` address.
+pub(crate) fn parse_address(host: &str) -> Option<&str> {
+    host.strip_prefix("shm://")
+}
+
+/// Bytes one slot takes for `max_atoms` atoms, as in `Segment::slot_bytes`.
+fn slot_bytes(max_atoms: u64) -> u64 {
+    let bytes = (SLOT_HEADER_BYTES + BOX_BYTES) as u64 + max_atoms * (6 * 8 + 4);
+    bytes.div_ceil(64) * 64
+}
+
+/// Polls before a futex wait; spinning on a single core only delays the
+/// server.
+fn spin_limit() -> u32 {
+    static LIMIT: OnceLock<u32> = OnceLock::new();
+    *LIMIT.get_or_init(|| match std::thread::available_parallelism() {
+        Ok(n) if n.get() > 1 => SPIN,
+        _ => 0,
+    })
+}
+
+/// Client side of a shared memory segment.
+///
+/// Slots are claimed on demand and reused; like the TCP client it is
+/// driven by one thread at a time.
+pub struct ShmClient {
+    base: *mut u8,
+    bytes: usize,
+    nslots: u32,
+    max_atoms: usize,
+    slot_bytes: usize,
+    server_pid: u32,
+    pid: u32,
+    free: Vec<u32>,
+    held: Vec<u32>,
+}
+
+impl ShmClient {
+    /// Map the segment of the server serving `name`.
+    pub fn connect(name: &str) -> Result<Self, String> {
+        if name.is_empty() || name.len() > 200 || name.contains('/') {
+            return Err(format!(
+                "invalid shared memory name '{name}', expected 1-200 characters without '/'"
+            ));
+        }
+        let (base, bytes) = sys::map(&format!("/{name}"))?;
+        let mut client = Self {
+            base,
+            bytes,
+            nslots: 0,
+            max_atoms: 0,
+            slot_bytes: 0,
+            server_pid: 0,
+            pid: sys::getpid(),
+            free: Vec::new(),
+            held: Vec::new(),
+        };
+        // Dropping `client` unmaps on every error below
+        let (magic, version) =
+            unsafe { (client.read::<u64>(H_MAGIC), client.read::<u32>(H_VERSION)) };
+        let nslots = unsafe { client.read::<u32>(H_NSLOTS) };
+        let max_atoms = unsafe { client.read::<u64>(H_MAX_ATOMS) };
+        let stride = unsafe { client.read::<u64>(H_SLOT_BYTES) };
+        if magic != MAGIC
+            || version != VERSION
+            || stride != slot_bytes(max_atoms)
+            || (bytes as u64) < HEADER_BYTES as u64 + nslots as u64 * stride
+        {
+            return Err(format!("shared memory /{name} has an unknown layout"));
+        }
+        client.nslots = nslots;
+        client.max_atoms = max_atoms as usize;
+        client.slot_bytes = stride as usize;
+        client.server_pid = unsafe { client.read::<u32>(H_SERVER_PID) };
+        client.check_server()?;
+        Ok(client)
+    }
+
+    /// Atoms one request may hold.
+    pub fn max_atoms(&self) -> usize {
+        self.max_atoms
+    }
+
+    /// Evaluate one configuration.
+    pub fn calculate(
+        &mut self,
+        positions: &[f64],
+        atmnrs: &[i32],
+        box_data: &[f64],
+    ) -> Result<(f64, Vec<f64>), String> {
+        let slot = self
+            .acquire()
+            .ok_or_else(|| "all shared memory slots are in use".to_string())?;
+        let result = self
+            .submit(slot, positions, atmnrs, box_data)
+            .and_then(|()| self.wait(slot))
+            .and_then(|()| self.collect(slot));
+        self.release(slot);
+        result
+    }
+
+    /// Evaluate several configurations, keeping a few in flight so the
+    /// server threads share them.  Results are in input order.
+    pub fn calculate_batch(
+        &mut self,
+        items: &[(&[f64], &[i32], &[f64])],
+    ) -> Result<Vec<(f64, Vec<f64>)>, String> {
+        let mut results = Vec::with_capacity(items.len());
+        let mut inflight = std::collections::VecDeque::new();
+        let mut outcome = Ok(());
+        for &(positions, atmnrs, box_data) in items {
+            if inflight.len() == BATCH_WINDOW {
+                let slot = inflight.pop_front().unwrap();
+                outcome = self.finish(slot, &mut results);
+                if outcome.is_err() {
+                    break;
+                }
+            }
+            let Some(slot) = self.acquire() else {
+                outcome = Err("all shared memory slots are in use".to_string());
+                break;
+            };
+            if let Err(e) = self.submit(slot, positions, atmnrs, box_data) {
+                self.release(slot);
+                outcome = Err(e);
+                break;
+            }
+            inflight.push_back(slot);
+        }
+        // Every slot is collected, the first failure is reported
+        for slot in inflight {
+            let rc = self.finish(slot, &mut results);
+            if outcome.is_ok() {
+                outcome = rc;
+            }
+        }
+        outcome.map(|()| results)
+    }
+
+    /// Wait for, collect and release one slot of a batch.
+    fn finish(&mut self, slot: u32, results: &mut Vec<(f64, Vec<f64>)>) -> Result<(), String> {
+        let result = self.wait(slot).and_then(|()| self.collect(slot));
+        self.release(slot);
+        results.push(result?);
+        Ok(())
+    }
+
+    /// Claim a free slot, or one left behind by a client that exited.
+    fn acquire(&mut self) -> Option<u32> {
+        if let Some(slot) = self.free.pop() {
+            return Some(slot);
+        }
+        for pass in 0..2 {
+            for i in 0..self.nslots {
+                let owner_word = self.slot_word(i, S_OWNER);
+                let owner = owner_word.load(Ordering::Relaxed);
+                // The first pass takes free slots, the second reclaims
+                // idle ones of dead owners
+                let claimable = if pass == 0 {
+                    owner == 0
+                } else {
+                    let state = self.slot_word(i, S_STATE).load(Ordering::Acquire);
+                    owner != 0
+                        && owner != self.pid
+                        && state != REQUEST
+                        && state != BUSY
+                        && !sys::alive(owner)
+                };
+                if !claimable {
+                    continue;
+                }
+                if owner_word
+                    .compare_exchange(owner, self.pid, Ordering::Acquire, Ordering::Relaxed)
+                    .is_ok()
+                {
+                    // Published to the server by the release of the first request
+                    let home = self.held.first().copied().unwrap_or(i);
+                    self.slot_word(i, S_HOME).store(home, Ordering::Relaxed);
+                    self.slot_word(i, S_WAITING).store(0, Ordering::Relaxed);
+                    self.slot_word(i, S_STATE).store(IDLE, Ordering::Relaxed);
+                    self.held.push(i);
+                    return Some(i);
+                }
+            }
+        }
+        None
+    }
+
+    fn release(&mut self, slot: u32) {
+        self.free.push(slot);
+    }
+
+    /// Write a request into `slot` and signal the server.
+    fn submit(
+        &mut self,
+        slot: u32,
+        positions: &[f64],
+        atmnrs: &[i32],
+        box_data: &[f64],
+    ) -> Result<(), String> {
+        let n = atmnrs.len();
+        if n > self.max_atoms {
+            return Err(format!(
+                "system of {n} atoms exceeds the shared memory slot capacity of {}; \
+                 start potserv with a larger --shm-atoms",
+                self.max_atoms
+            ));
+        }
+        if positions.len() != n * 3 || box_data.len() != 9 {
+            return Err("inconsistent input sizes".into());
+        }
+        let base = self.slot_base(slot);
+        unsafe {
+            base.add(S_NATOMS).cast::<u64>().write(n as u64);
+            *base.add(S_ERROR) = 0;
+            let boxp = base.add(SLOT_HEADER_BYTES).cast::<f64>();
+            std::ptr::copy_nonoverlapping(box_data.as_ptr(), boxp, 9);
+            std::ptr::copy_nonoverlapping(positions.as_ptr(), self.positions(slot), n * 3);
+            std::ptr::copy_nonoverlapping(atmnrs.as_ptr(), self.atmnrs(slot), n);
+        }
+        self.slot_word(slot, S_STATE)
+            .store(REQUEST, Ordering::Release);
+
+        let doorbell = self.header_word(H_DOORBELL);
+        doorbell.fetch_add(1, Ordering::SeqCst);
+        if self.header_word(H_SLEEPERS).load(Ordering::SeqCst) != 0 {
+            sys::futex_wake(doorbell, 1);
+        }
+        Ok(())
+    }
+
+    fn ready(&self, slot: u32) -> bool {
+        matches!(
+            self.slot_word(slot, S_STATE).load(Ordering::Acquire),
+            DONE | FAILED
+        )
+    }
+
+    /// Block until `slot` is answered, checking that the server still runs.
+    ///
+    /// Sleeps on the `answers` word of the home slot, read before the state
+    /// so that an answer arriving in between ends the futex wait at once.
+    fn wait(&self, slot: u32) -> Result<(), String> {
+        for _ in 0..spin_limit() {
+            if self.ready(slot) {
+                return Ok(());
+            }
+            std::hint::spin_loop();
+        }
+        let home = self.held[0];
+        let answers = self.slot_word(home, S_ANSWERS);
+        let waiting = self.slot_word(home, S_WAITING);
+        loop {
+            waiting.store(1, Ordering::SeqCst);
+            let bell = answers.load(Ordering::SeqCst);
+            if !self.ready(slot) {
+                sys::futex_wait(answers, bell);
+            }
+            waiting.store(0, Ordering::Relaxed);
+            if self.ready(slot) {
+                return Ok(());
+            }
+            self.check_server()?;
+        }
+    }
+
+    /// Read the answer of `slot`, which becomes idle again.
+    fn collect(&mut self, slot: u32) -> Result<(f64, Vec<f64>), String> {
+        let state = self.slot_word(slot, S_STATE).load(Ordering::Acquire);
+        self.slot_word(slot, S_STATE).store(IDLE, Ordering::Relaxed);
+        let base = self.slot_base(slot);
+        if state == FAILED {
+            let msg = unsafe { std::slice::from_raw_parts(base.add(S_ERROR), ERROR_BYTES) };
+            let len = msg.iter().position(|&b| b == 0).unwrap_or(ERROR_BYTES);
+            return Err(format!(
+                "server error: {}",
+                String::from_utf8_lossy(&msg[..len])
+            ));
+        }
+        if state != DONE {
+            return Err("collecting an unanswered shared memory slot".into());
+        }
+        unsafe {
+            let n = base.add(S_NATOMS).cast::<u64>().read() as usize;
+            let energy = base.add(S_ENERGY).cast::<f64>().read();
+            let forces = std::slice::from_raw_parts(self.forces(slot), n * 3).to_vec();
+            Ok((energy, forces))
+        }
+    }
+
+    fn check_server(&self) -> Result<(), String> {
+        if sys::alive(self.server_pid) {
+            Ok(())
+        } else {
+            Err("the potserv serving shared memory has exited".into())
+        }
+    }
+
+    unsafe fn read<T: Copy>(&self, offset: usize) -> T {
+        unsafe { self.base.add(offset).cast::<T>().read() }
+    }
+
+    fn header_word(&self, offset: usize) -> &AtomicU32 {
+        unsafe { &*self.base.add(offset).cast::<AtomicU32>() }
+    }
+
+    fn slot_base(&self, slot: u32) -> *mut u8 {
+        unsafe {
+            self.base
+                .add(HEADER_BYTES + slot as usize * self.slot_bytes)
+        }
+    }
+
+    fn slot_word(&self, slot: u32, offset: usize) -> &AtomicU32 {
+        unsafe { &*self.slot_base(slot).add(offset).cast::<AtomicU32>() }
+    }
+
+    fn positions(&self, slot: u32) -> *mut f64 {
+        unsafe {
+            self.slot_base(slot)
+                .add(SLOT_HEADER_BYTES + BOX_BYTES)
+                .cast()
+        }
+    }
+
+    fn forces(&self, slot: u32) -> *mut f64 {
+        unsafe { self.positions(slot).add(3 * self.max_atoms) }
+    }
+
+    fn atmnrs(&self, slot: u32) -> *mut i32 {
+        unsafe { self.forces(slot).add(3 * self.max_atoms).cast() }
+    }
+}
+
+impl Drop for ShmClient {
+    /// Waits for slots still in flight, since the next owner would read
+    /// their answers as its own, then frees all claimed slots.
+    fn drop(&mut self) {
+        for &slot in &self.held {
+            let state = self.slot_word(slot, S_STATE).load(Ordering::Acquire);
+            if (state == REQUEST || state == BUSY) && self.wait(slot).is_err() {
+                continue; // The server is gone, leave the slot claimed
+            }
+            self.slot_word(slot, S_STATE).store(IDLE, Ordering::Relaxed);
+            self.slot_word(slot, S_OWNER).store(0, Ordering::Release);
+        }
+        unsafe { sys::unmap(self.base, self.bytes) };
+    }
+}
+
+#[cfg(target_os = "linux")]
+mod sys {
+    use std::ffi::CString;
+    use std::sync::atomic::AtomicU32;
+
+    /// Futex timeout between server liveness checks.
+    const POLL_NS: libc::c_long = 100_000_000;
+
+    pub(super) fn map(object: &str) -> Result<(*mut u8, usize), String> {
+        let cname = CString::new(object).map_err(|e| format!("invalid name: {e}"))?;
+        let fd = unsafe { libc::shm_open(cname.as_ptr(), libc::O_RDWR, 0) };
+        if fd < 0 {
+            return Err(format!(
+                "no potserv serves shared memory {object}: {}",
+                std::io::Error::last_os_error()
+            ));
+        }
+        let mut st: libc::stat = unsafe { std::mem::zeroed() };
+        if unsafe { libc::fstat(fd, &mut st) } != 0 || (st.st_size as usize) < super::HEADER_BYTES {
+            unsafe { libc::close(fd) };
+            return Err(format!("shared memory {object} is not an rgpot segment"));
+        }
+        let bytes = st.st_size as usize;
+        let base = unsafe {
+            libc::mmap(
+                std::ptr::null_mut(),
+                bytes,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_SHARED,
+                fd,
+                0,
+            )
+        };
+        let err = std::io::Error::last_os_error();
+        unsafe { libc::close(fd) };
+        if base == libc::MAP_FAILED {
+            return Err(format!("mmap of {object}: {err}"));
+        }
+        Ok((base.cast(), bytes))
+    }
+
+    pub(super) unsafe fn unmap(base: *mut u8, bytes: usize) {
+        unsafe { libc::munmap(base.cast(), bytes) };
+    }
+
+    pub(super) fn getpid() -> u32 {
+        std::process::id()
+    }
+
+    /// False only when the process is known to be gone.
+    pub(super) fn alive(pid: u32) -> bool {
+        let rc = unsafe { libc::kill(pid as libc::pid_t, 0) };
+        rc == 0 || std::io::Error::last_os_error().raw_os_error() != Some(libc::ESRCH)
+    }
+
+    pub(super) fn futex_wait(word: &AtomicU32, expected: u32) {
+        let timeout = libc::timespec {
+            tv_sec: 0,
+            tv_nsec: POLL_NS,
+        };
+        unsafe {
+            libc::syscall(
+                libc::SYS_futex,
+                word.as_ptr(),
+                libc::FUTEX_WAIT,
+                expected,
+                &timeout as *const libc::timespec,
+                std::ptr::null::<u32>(),
+                0,
+            )
+        };
+    }
+
+    pub(super) fn futex_wake(word: &AtomicU32, count: i32) {
+        unsafe {
+            libc::syscall(
+                libc::SYS_futex,
+                word.as_ptr(),
+                libc::FUTEX_WAKE,
+                count,
+                std::ptr::null::<libc::timespec>(),
+                std::ptr::null::<u32>(),
+                0,
+            )
+        };
+    }
+}
+
+#[cfg(not(target_os = "linux"))]
+mod sys {
+    use std::sync::atomic::AtomicU32;
+
+    pub(super) fn map(_object: &str) -> Result<(*mut u8, usize), String> {
+        Err("the shared memory transport requires Linux".into())
+    }
+    pub(super) unsafe fn unmap(_base: *mut u8, _bytes: usize) {}
+    pub(super) fn getpid() -> u32 {
+        std::process::id()
+    }
+    pub(super) fn alive(_pid: u32) -> bool {
+        true
+    }
+    pub(super) fn futex_wait(_word: &AtomicU32, _expected: u32) {}
+    pub(super) fn futex_wake(_word: &AtomicU32, _count: i32) {}
+}
@@ -10,6 +10,10 @@
 //!   frees only the `DLManagedTensorVersioned` metadata, not the data.
 //! - **Owned**: wraps a `Vec<T>`. The deleter frees both metadata and data.
 //!
+//! Borrowed tensors may describe memory on any device; `rgpot_tensor_cpu_*`
+//! are shorthands for the `rgpot_tensor_device_*` constructors on the host.
+//! Owned tensors always hold host memory.
+//!
 //! All exported `extern "C"` functions are collected by cbindgen into `rgpot.h`.
 
 use std::os::raw::{c_int, c_void};
@@ -19,6 +23,8 @@ use dlpk::sys::{
     DLTensor, DLPACK_FLAG_BITMASK_IS_COPIED,
 };
 
+use crate::pool::{F64_POOL, I32_POOL};
+
 // ---------------------------------------------------------------------------
 // Internal: row-major stride computation
 // ---------------------------------------------------------------------------
@@ -88,7 +94,8 @@ unsafe extern "C" fn borrowed_deleter(ptr: *mut DLManagedTensorVersioned) {
     drop(unsafe { Box::from_raw(ptr) });
 }
 
-/// Create a non-owning `DLManagedTensorVersioned` that borrows `data`.
+/// Create a non-owning `DLManagedTensorVersioned` that borrows `data` on
+/// `device`.
 ///
 /// # Safety
 /// `data` must remain valid for the lifetime of the returned tensor.
@@ -96,6 +103,7 @@ unsafe fn create_borrowed_tensor(
     data: *mut c_void,
     dtype: DLDataType,
     shape_vec: Vec<i64>,
+    device: DLDevice,
 ) -> *mut DLManagedTensorVersioned {
     let ndim = shape_vec.len() as i32;
     let strides_vec = compute_row_major_strides(&shape_vec);
@@ -107,7 +115,7 @@ unsafe fn create_borrowed_tensor(
 
     let dl_tensor = DLTensor {
         data,
-        device: cpu_device(),
+        device,
         ndim,
         dtype,
         shape: ctx.shape.as_mut_ptr(),
@@ -131,7 +139,7 @@ unsafe fn create_borrowed_tensor(
 // ---------------------------------------------------------------------------
 
 struct OwnedF64TensorContext {
-    _data: Vec<f64>,
+    data: Vec<f64>,
     shape: Vec<i64>,
     strides: Vec<i64>,
 }
@@ -142,14 +150,15 @@ unsafe extern "C" fn owned_f64_deleter(ptr: *mut DLManagedTensorVersioned) {
     }
     let ctx = unsafe { (*ptr).manager_ctx.cast::<OwnedF64TensorContext>() };
     if !ctx.is_null() {
-        drop(unsafe { Box::from_raw(ctx) });
+        let ctx = unsafe { Box::from_raw(ctx) };
+        F64_POOL.give(ctx.data);
     }
     drop(unsafe { Box::from_raw(ptr) });
 }
 
 #[allow(dead_code)]
 struct OwnedI32TensorContext {
-    _data: Vec<i32>,
+    data: Vec<i32>,
     shape: Vec<i64>,
     strides: Vec<i64>,
 }
@@ -161,13 +170,14 @@ unsafe extern "C" fn owned_i32_deleter(ptr: *mut DLManagedTensorVersioned) {
     }
     let ctx = unsafe { (*ptr).manager_ctx.cast::<OwnedI32TensorContext>() };
     if !ctx.is_null() {
-        drop(unsafe { Box::from_raw(ctx) });
+        let ctx = unsafe { Box::from_raw(ctx) };
+        I32_POOL.give(ctx.data);
     }
     drop(unsafe { Box::from_raw(ptr) });
 }
 
 /// Create an owning f64 DLPack tensor.  The `Vec<f64>` is kept alive inside
-/// the manager context and freed when the deleter runs.
+/// the manager context and handed back to [`F64_POOL`] when the deleter runs.
 pub(crate) fn create_owned_f64_tensor(
     mut data: Vec<f64>,
     shape_vec: Vec<i64>,
@@ -177,7 +187,7 @@ pub(crate) fn create_owned_f64_tensor(
     let data_ptr = data.as_mut_ptr();
 
     let mut ctx = Box::new(OwnedF64TensorContext {
-        _data: data,
+        data,
         shape: shape_vec,
         strides: strides_vec,
     });
@@ -214,7 +224,7 @@ pub(crate) fn create_owned_i32_tensor(
     let data_ptr = data.as_mut_ptr();
 
     let mut ctx = Box::new(OwnedI32TensorContext {
-        _data: data,
+        data,
         shape: shape_vec,
         strides: strides_vec,
     });
@@ -337,7 +347,7 @@ pub unsafe extern "C" fn rgpot_tensor_cpu_f64_2d(
     rows: i64,
     cols: i64,
 ) -> *mut DLManagedTensorVersioned {
-    create_borrowed_tensor(data.cast(), dtype_f64(), vec![rows, cols])
+    create_borrowed_tensor(data.cast(), dtype_f64(), vec![rows, cols], cpu_device())
 }
 
 /// Create a non-owning 1-D i32 tensor on CPU wrapping an existing buffer.
@@ -349,7 +359,7 @@ pub unsafe extern "C" fn rgpot_tensor_cpu_i32_1d(
     data: *mut c_int,
     len: i64,
 ) -> *mut DLManagedTensorVersioned {
-    create_borrowed_tensor(data.cast(), dtype_i32(), vec![len])
+    create_borrowed_tensor(data.cast(), dtype_i32(), vec![len], cpu_device())
 }
 
 /// Create a non-owning 2-D f64 tensor on CPU for a 3x3 matrix.
@@ -362,7 +372,39 @@ pub unsafe extern "C" fn rgpot_tensor_cpu_i32_1d(
 pub unsafe extern "C" fn rgpot_tensor_cpu_f64_matrix3(
     data: *mut f64,
 ) -> *mut DLManagedTensorVersioned {
-    create_borrowed_tensor(data.cast(), dtype_f64(), vec![3, 3])
+    create_borrowed_tensor(data.cast(), dtype_f64(), vec![3, 3], cpu_device())
+}
+
+/// Create a non-owning 2-D f64 tensor wrapping a buffer on `device`.
+///
+/// Same as `rgpot_tensor_cpu_f64_2d` for memory that may live on a GPU,
+/// e.g. `{kDLCUDA, 0}`.  The data is never read by this call.
+///
+/// # Safety
+/// `data` must point to at least `rows * cols` contiguous `f64` values in
+/// memory of `device`.
+#[no_mangle]
+pub unsafe extern "C" fn rgpot_tensor_device_f64_2d(
+    data: *mut f64,
+    rows: i64,
+    cols: i64,
+    device: DLDevice,
+) -> *mut DLManagedTensorVersioned {
+    create_borrowed_tensor(data.cast(), dtype_f64(), vec![rows, cols], device)
+}
+
+/// Create a non-owning 1-D i32 tensor wrapping a buffer on `device`.
+///
+/// # Safety
+/// `data` must point to at least `len` contiguous `c_int` values in memory
+/// of `device`.
+#[no_mangle]
+pub unsafe extern "C" fn rgpot_tensor_device_i32_1d(
+    data: *mut c_int,
+    len: i64,
+    device: DLDevice,
+) -> *mut DLManagedTensorVersioned {
+    create_borrowed_tensor(data.cast(), dtype_i32(), vec![len], device)
 }
 
 /// Create an **owning** 2-D f64 tensor on CPU by copying data.
@@ -379,7 +421,7 @@ pub unsafe extern "C" fn rgpot_tensor_owned_cpu_f64_2d(
     cols: i64,
 ) -> *mut DLManagedTensorVersioned {
     let len = (rows * cols) as usize;
-    let vec = unsafe { std::slice::from_raw_parts(data, len) }.to_vec();
+    let vec = F64_POOL.take_copy(unsafe { std::slice::from_raw_parts(data, len) });
     create_owned_f64_tensor(vec, vec![rows, cols])
 }
 
@@ -555,6 +597,28 @@ mod tests {
         unsafe { rgpot_tensor_free(tensor) };
     }
 
+    #[test]
+    fn device_tensor_keeps_device_and_metadata() {
+        // The data is never dereferenced, a host buffer stands in for GPU
+        // memory
+        let mut data = [0.0_f64; 6];
+        let device = DLDevice {
+            device_type: DLDeviceType::kDLCUDA,
+            device_id: 1,
+        };
+        let tensor =
+            unsafe { rgpot_tensor_device_f64_2d(data.as_mut_ptr(), 2, 3, device) };
+        assert_eq!(unsafe { rgpot_tensor_device(tensor) }, device);
+        assert_eq!(validate_positions(tensor), Ok(2));
+        unsafe { rgpot_tensor_free(tensor) };
+
+        let mut types = [1_i32; 2];
+        let tensor = unsafe { rgpot_tensor_device_i32_1d(types.as_mut_ptr(), 2, device) };
+        assert_eq!(unsafe { rgpot_tensor_device(tensor) }, device);
+        assert!(validate_atomic_numbers(tensor, 2).is_ok());
+        unsafe { rgpot_tensor_free(tensor) };
+    }
+
     #[test]
     fn data_accessor_returns_correct_pointer() {
         let mut data = [42.0_f64; 3];
@@ -0,0 +1,230 @@
+// MIT License
+// Copyright 2023--present rgpot developers
+
+//! Hot-path trace spans with Chrome trace output.
+//!
+//! [`span`] returns a guard that records the lifetime of its scope into a
+//! ring buffer owned by the calling thread.  With the `trace` feature
+//! disabled the guard is zero-sized and every call compiles away.
+//!
+//! Dumps read the rings of all threads without locking them: each slot
+//! carries a sequence number, and slots rewritten while being copied are
+//! skipped.  The output is the same Chrome trace JSON as the C++ core's
+//! `pot_trace_dump`, so both can be opened side by side in Perfetto.
+
+use std::io::{self, Write};
+
+/// Spans each thread keeps; older ones are overwritten.
+pub const RING_CAPACITY: usize = 1 << 13;
+
+#[cfg(feature = "trace")]
+mod imp {
+    use super::RING_CAPACITY;
+    use std::io::{self, Write};
+    use std::sync::atomic::{fence, AtomicPtr, AtomicU64, AtomicUsize, Ordering};
+    use std::sync::{Arc, Mutex, OnceLock};
+    use std::time::Instant;
+
+    /// One recorded span, read concurrently by dumps.
+    #[derive(Default)]
+    struct Slot {
+        /// Odd while written, `2 * (index + 1)` once complete.
+        seq: AtomicU64,
+        name_ptr: AtomicPtr<u8>,
+        name_len: AtomicUsize,
+        begin: AtomicU64,
+        dur: AtomicU64,
+    }
+
+    /// Spans of one thread, written only by that thread.
+    struct Ring {
+        tid: u32,
+        head: AtomicU64,
+        slots: Box<[Slot]>,
+    }
+
+    static RINGS: Mutex<Vec<Arc<Ring>>> = Mutex::new(Vec::new());
+    static EPOCH: OnceLock<Instant> = OnceLock::new();
+
+    thread_local! {
+        static LOCAL: Arc<Ring> = {
+            let mut rings = RINGS.lock().unwrap_or_else(|e| e.into_inner());
+            let ring = Arc::new(Ring {
+                tid: rings.len() as u32 + 1,
+                head: AtomicU64::new(0),
+                slots: (0..RING_CAPACITY).map(|_| Slot::default()).collect(),
+            });
+            rings.push(Arc::clone(&ring));
+            ring
+        };
+    }
+
+    /// Nanoseconds since the first use of the trace clock.
+    pub(super) fn now_ns() -> u64 {
+        EPOCH.get_or_init(Instant::now).elapsed().as_nanos() as u64
+    }
+
+    /// Record a finished span on the calling thread.
+    pub(super) fn record(name: &'static str, begin: u64, end: u64) {
+        // Threads being torn down have no ring left; their spans are lost
+        let _ = LOCAL.try_with(|ring| {
+            let h = ring.head.load(Ordering::Relaxed);
+            let slot = &ring.slots[(h as usize) % RING_CAPACITY];
+            slot.seq.store(2 * h + 1, Ordering::Relaxed);
+            fence(Ordering::Release);
+            slot.name_ptr.store(name.as_ptr() as *mut u8, Ordering::Relaxed);
+            slot.name_len.store(name.len(), Ordering::Relaxed);
+            slot.begin.store(begin, Ordering::Relaxed);
+            slot.dur.store(end.saturating_sub(begin), Ordering::Relaxed);
+            slot.seq.store(2 * h + 2, Ordering::Release);
+            ring.head.store(h + 1, Ordering::Release);
+        });
+    }
+
+    /// Write the complete events of every ring, returning their count.
+    pub(super) fn write_events(out: &mut dyn Write) -> io::Result<usize> {
+        let rings: Vec<Arc<Ring>> = RINGS.lock().unwrap_or_else(|e| e.into_inner()).clone();
+        let pid = std::process::id();
+        let mut written = 0;
+        for ring in &rings {
+            let head = ring.head.load(Ordering::Acquire);
+            let first = head.saturating_sub(RING_CAPACITY as u64);
+            for i in first..head {
+                let slot = &ring.slots[(i as usize) % RING_CAPACITY];
+                let seq = slot.seq.load(Ordering::Acquire);
+                let ptr = slot.name_ptr.load(Ordering::Relaxed);
+                let len = slot.name_len.load(Ordering::Relaxed);
+                let begin = slot.begin.load(Ordering::Relaxed);
+                let dur = slot.dur.load(Ordering::Relaxed);
+                fence(Ordering::Acquire);
+                if seq != 2 * i + 2 || slot.seq.load(Ordering::Relaxed) != seq || ptr.is_null() {
+                    continue; // Rewritten since the head was read
+                }
+                // Safety: a matching sequence number means ptr and len were
+                // stored together from one `&'static str`
+                let name = unsafe {
+                    std::str::from_utf8_unchecked(std::slice::from_raw_parts(ptr, len))
+                };
+                write!(
+                    out,
+                    "{}\n{{\"name\":\"{}\",\"cat\":\"rgpot-core\",\"ph\":\"X\",\
+                     \"ts\":{}.{:03},\"dur\":{}.{:03},\"pid\":{},\"tid\":{}}}",
+                    if written > 0 { "," } else { "" },
+                    name.escape_default(),
+                    begin / 1000,
+                    begin % 1000,
+                    dur / 1000,
+                    dur % 1000,
+                    pid,
+                    ring.tid
+                )?;
+                written += 1;
+            }
+        }
+        Ok(written)
+    }
+
+    /// Drop every buffered span.
+    pub(super) fn clear() {
+        let rings = RINGS.lock().unwrap_or_else(|e| e.into_inner());
+        for ring in rings.iter() {
+            for slot in ring.slots.iter() {
+                slot.seq.store(0, Ordering::Relaxed);
+                slot.name_ptr.store(std::ptr::null_mut(), Ordering::Relaxed);
+            }
+            ring.head.store(0, Ordering::Release);
+        }
+    }
+}
+
+/// Guard recording a span when dropped.
+#[must_use = "a span ends when the guard is dropped"]
+#[cfg_attr(not(feature = "rpc"), allow(dead_code))]
+pub(crate) struct Span {
+    #[cfg(feature = "trace")]
+    name: &'static str,
+    #[cfg(feature = "trace")]
+    begin: u64,
+}
+
+/// Start a span named `name`, ending when the returned guard is dropped.
+#[inline(always)]
+#[cfg_attr(not(feature = "trace"), allow(unused_variables))]
+#[cfg_attr(not(feature = "rpc"), allow(dead_code))]
+pub(crate) fn span(name: &'static str) -> Span {
+    Span {
+        #[cfg(feature = "trace")]
+        name,
+        #[cfg(feature = "trace")]
+        begin: imp::now_ns(),
+    }
+}
+
+#[cfg(feature = "trace")]
+impl Drop for Span {
+    fn drop(&mut self) {
+        imp::record(self.name, self.begin, imp::now_ns());
+    }
+}
+
+/// Write every buffered span as Chrome trace JSON, returning their count.
+///
+/// Safe while other threads keep recording.  Without the `trace` feature
+/// the trace is empty.
+pub fn write_chrome_json(out: &mut dyn Write) -> io::Result<usize> {
+    out.write_all(b"{\"displayTimeUnit\":\"ns\",\"traceEvents\":[")?;
+    #[cfg(feature = "trace")]
+    let written = imp::write_events(out)?;
+    #[cfg(not(feature = "trace"))]
+    let written = 0;
+    out.write_all(b"\n]}\n")?;
+    Ok(written)
+}
+
+/// Drop every buffered span; must not race with recording threads.
+pub fn clear() {
+    #[cfg(feature = "trace")]
+    imp::clear();
+}
+
+#[cfg(all(test, feature = "trace"))]
+mod tests {
+    use super::*;
+    use std::sync::Mutex;
+
+    /// Serializes the tests, which share the global rings.
+    static SERIAL: Mutex<()> = Mutex::new(());
+
+    #[test]
+    fn spans_are_dumped() {
+        let _lock = SERIAL.lock().unwrap_or_else(|e| e.into_inner());
+        clear();
+        {
+            let _outer = span("test.outer");
+            let _inner = span("test.inner");
+        }
+        let mut buf = Vec::new();
+        let n = write_chrome_json(&mut buf).unwrap();
+        let json = String::from_utf8(buf).unwrap();
+        assert!(n >= 2);
+        assert!(json.contains("\"name\":\"test.outer\""));
+        assert!(json.contains("\"name\":\"test.inner\""));
+        assert!(json.ends_with("\n]}\n"));
+    }
+
+    #[test]
+    fn rings_wrap() {
+        let _lock = SERIAL.lock().unwrap_or_else(|e| e.into_inner());
+        clear();
+        let handle = std::thread::spawn(|| {
+            for _ in 0..RING_CAPACITY + 10 {
+                let _s = span("test.wrap");
+            }
+        });
+        handle.join().unwrap();
+        let mut buf = Vec::new();
+        write_chrome_json(&mut buf).unwrap();
+        let json = String::from_utf8(buf).unwrap();
+        assert_eq!(json.matches("\"name\":\"test.wrap\"").count(), RING_CAPACITY);
+    }
+}
@@ -14,7 +14,11 @@
 //! - **Output forces** are *callee-allocated* — the callback sets
 //!   `output.forces` to a DLPack tensor it creates.  After the call, the
 //!   caller takes ownership and must free it via `rgpot_tensor_free`.
+//!   Callbacks may instead fill a tensor preset by the caller in place.
 //! - **Energy and variance** are plain `f64` scalars, always on the host.
+//! - **Devices**: tensors may live on any DLPack device.  A callback
+//!   computing on a GPU reads device positions and returns device forces;
+//!   host copies are made only by the RPC layer (see [`crate::device`]).
 //!
 //! ## DLPack Tensor Shapes
 //!
@@ -59,6 +63,12 @@ pub struct rgpot_force_input_t {
 /// a callee-allocated DLPack tensor.  After the call, the caller owns the
 /// tensor and must free it via `rgpot_tensor_free`.
 ///
+/// A caller may instead preset `forces` to a writable `[n_atoms, 3]` f64
+/// tensor, on the host or on the device the callback computes on, to reuse it
+/// across calls.  A callback may fill such a tensor in
+/// place and leave the pointer unchanged, or replace it like a `NULL` one, in
+/// which case the caller still owns and frees the preset tensor.
+///
 /// # Fields
 ///
 /// - `forces`: output force tensor, same shape/dtype as `positions`.
@@ -13,7 +13,7 @@ SCHEMA_PATH = os.path.join(SCRIPT_DIR, "../CppCore/rgpot/rpc/Potentials.capnp")
 pot_capnp = capnp.load(SCHEMA_PATH)
 
 
-async def run_client(port):
+async def run_client(port, cached=False):
     # Retry connection a few times to allow server startup
     for _ in range(10):
         try:
@@ -68,6 +68,33 @@ async def run_client(port):
         print("Error: Energy is zero or NaN")
         return False
 
+    # Batched requests evaluate every item and keep the input order
+    print("Sending batch request...")
+    req = pot.calculateBatch_request()
+    fips = req.init("fips", 3)
+    for item in fips:
+        item.pos = pos_data
+        item.atmnrs = [29, 1]
+        item.box = box_data
+    batch = await req.send()
+    assert len(batch.results) == 3
+    for res in batch.results:
+        assert res.energy == result.result.energy
+        assert list(res.forces) == list(result.result.forces)
+
+    # Concurrent calls are served by the worker pool and must all agree
+    print("Sending concurrent requests...")
+    replies = await asyncio.gather(*[pot.calculate(fip) for _ in range(8)])
+    for reply in replies:
+        assert reply.result.energy == result.result.energy
+
+    # The exported cache answers unknown keys with a miss
+    if cached:
+        print("Querying the shared cache...")
+        service = (await pot.cache()).service
+        miss = await service.lookup(key=bytes(16), nForces=6)
+        assert not miss.found
+
     return True
 
 
@@ -77,19 +104,26 @@ def main():
         "--server-bin", required=True, help="Path to potserv executable"
     )
     parser.add_argument("--port", type=int, default=12345)
+    parser.add_argument(
+        "--cache-dir", help="RocksDB directory, needs a cache-enabled potserv"
+    )
     args = parser.parse_args()
 
     # 1. Start Server
-    print(f"Starting server: {args.server_bin} {args.port} CuH2")
+    cmd = [args.server_bin, "--threads", "2"]
+    if args.cache_dir:
+        cmd += ["--cache", args.cache_dir]
+    cmd += [str(args.port), "CuH2"]
+    print(f"Starting server: {' '.join(cmd)}")
     server_proc = subprocess.Popen(
-        [args.server_bin, str(args.port), "CuH2"],
+        cmd,
         stdout=subprocess.PIPE,
         stderr=subprocess.PIPE,
     )
 
     try:
         #  Run Client
-        success = asyncio.run(capnp.run(run_client(args.port)))
+        success = asyncio.run(capnp.run(run_client(args.port, bool(args.cache_dir))))
     except Exception as e:
         print(f"Exception during test: {e}")
         # Print server stderr to help debug